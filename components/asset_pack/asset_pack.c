@@ -0,0 +1,191 @@
+/**
+ * @file asset_pack.c
+ * @brief 资源包的映射和查找
+ */
+
+#include "asset_pack.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+
+static const char *TAG = "asset_pack";
+
+static const uint8_t *s_base = NULL; // 映射后的资源包开头
+static const asset_pack_entry_t *s_index = NULL;
+static uint32_t s_count = 0;
+static esp_partition_mmap_handle_t s_mmap_handle;
+
+/**
+ * @brief 检查索引项是否落在资源包内
+ */
+static bool entry_valid(const asset_pack_entry_t *e, uint32_t total_size)
+{
+    return e->name[ASSET_PACK_NAME_MAX - 1] == '\0' &&
+           (e->offset % ASSET_PACK_ALIGN) == 0 &&
+           e->offset <= total_size && e->size <= total_size - e->offset;
+}
+
+esp_err_t asset_pack_init(const char *partition_label)
+{
+    if (s_base != NULL)
+    {
+        return ESP_OK;
+    }
+
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, partition_label);
+    if (part == NULL)
+    {
+        ESP_LOGE(TAG, "分区不存在: %s", partition_label);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // 先只读文件头, 确认是资源包后再按实际长度映射
+    asset_pack_header_t hdr;
+    esp_err_t ret = esp_partition_read(part, 0, &hdr, sizeof(hdr));
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    if (hdr.magic != ASSET_PACK_MAGIC || hdr.version != ASSET_PACK_VERSION || hdr.entry_size != sizeof(asset_pack_entry_t))
+    {
+        ESP_LOGI(TAG, "分区 %s 中没有资源包", partition_label);
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (hdr.total_size > part->size || hdr.index_offset > hdr.total_size ||
+        hdr.count > (hdr.total_size - hdr.index_offset) / sizeof(asset_pack_entry_t))
+    {
+        ESP_LOGE(TAG, "资源包文件头无效 (总长 %lu, 分区 %lu)", (unsigned long)hdr.total_size, (unsigned long)part->size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const void *ptr = NULL;
+    ret = esp_partition_mmap(part, 0, hdr.total_size, ESP_PARTITION_MMAP_DATA, &ptr, &s_mmap_handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "映射资源包失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    const uint8_t *base = ptr;
+    const asset_pack_entry_t *index = (const asset_pack_entry_t *)(base + hdr.index_offset);
+    size_t index_bytes = (size_t)hdr.count * sizeof(asset_pack_entry_t);
+    if (esp_rom_crc32_le(0, (const uint8_t *)index, index_bytes) != hdr.index_crc)
+    {
+        ESP_LOGE(TAG, "资源包索引CRC错误");
+        esp_partition_munmap(s_mmap_handle);
+        return ESP_ERR_INVALID_CRC;
+    }
+    for (uint32_t i = 0; i < hdr.count; i++)
+    {
+        if (!entry_valid(&index[i], hdr.total_size))
+        {
+            ESP_LOGE(TAG, "资源包索引项 %lu 无效", (unsigned long)i);
+            esp_partition_munmap(s_mmap_handle);
+            return ESP_ERR_INVALID_SIZE;
+        }
+    }
+
+    s_base = base;
+    s_index = index;
+    s_count = hdr.count;
+    ESP_LOGI(TAG, "已映射资源包 %s: %lu 个资源, %lu 字节 @ %p",
+             partition_label, (unsigned long)s_count, (unsigned long)hdr.total_size, s_base);
+    return ESP_OK;
+}
+
+void asset_pack_deinit(void)
+{
+    if (s_base == NULL)
+    {
+        return;
+    }
+    esp_partition_munmap(s_mmap_handle);
+    s_base = NULL;
+    s_index = NULL;
+    s_count = 0;
+}
+
+bool asset_pack_is_mounted(void)
+{
+    return s_base != NULL;
+}
+
+static void fill_asset(const asset_pack_entry_t *e, asset_pack_asset_t *out)
+{
+    out->entry = e;
+    out->data = s_base + e->offset;
+    out->size = e->size;
+}
+
+esp_err_t asset_pack_find(const char *name, asset_pack_asset_t *out)
+{
+    if (name == NULL || out == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_base == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // 打包工具按strcmp(字节序)排序
+    uint32_t lo = 0, hi = s_count;
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int c = strncmp(name, s_index[mid].name, ASSET_PACK_NAME_MAX);
+        if (c == 0)
+        {
+            fill_asset(&s_index[mid], out);
+            return ESP_OK;
+        }
+        if (c < 0)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid + 1;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+uint32_t asset_pack_count(void)
+{
+    return s_count;
+}
+
+esp_err_t asset_pack_get(uint32_t index, asset_pack_asset_t *out)
+{
+    if (out == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (index >= s_count)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    fill_asset(&s_index[index], out);
+    return ESP_OK;
+}
+
+esp_err_t asset_pack_verify(void)
+{
+    if (s_base == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    int bad = 0;
+    for (uint32_t i = 0; i < s_count; i++)
+    {
+        const asset_pack_entry_t *e = &s_index[i];
+        if (esp_rom_crc32_le(0, s_base + e->offset, e->size) != e->crc)
+        {
+            ESP_LOGE(TAG, "资源CRC错误: %s", e->name);
+            bad++;
+        }
+    }
+    return bad == 0 ? ESP_OK : ESP_ERR_INVALID_CRC;
+}
@@ -0,0 +1,134 @@
+/**
+ * @file asset_pack.h
+ * @brief audio分区上的只读资源包 (内存映射, 零拷贝)
+ * @details 资源包由主机上的 tools/asset_pack.py 生成, 直接写入audio分区, 布局:
+ *          文件头 | 索引(按名称排序) | 数据块 ...  全部小端, 数据块按ASSET_PACK_ALIGN对齐。
+ *          初始化时用esp_partition_mmap把整个资源包映射到数据地址空间,
+ *          之后查找只在索引上二分, 返回的指针直接指向flash, 交给LVGL和混音器使用, 不经过文件系统和拷贝。
+ *
+ *          音效在打包时已转换为48kHz/16位立体声并补齐到混音块的整数倍, 可以直接注册到混音器;
+ *          图片保存LVGL的图片头字段和像素数据, 可以直接填入lv_image_dsc_t。
+ */
+
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define ASSET_PACK_MAGIC (0x4B415041u) // "APAK"
+#define ASSET_PACK_VERSION (1)
+#define ASSET_PACK_ALIGN (64)          // 数据块对齐 (cache行, 同时满足SIMD的16字节要求)
+#define ASSET_PACK_NAME_MAX (36)       // 名称长度上限, 含结尾的'\0'
+
+    /**
+     * @brief 资源类型
+     */
+    typedef enum
+    {
+        ASSET_PACK_TYPE_RAW = 0,   // 原样保存的文件
+        ASSET_PACK_TYPE_PCM = 1,   // 音效: 48kHz/16位立体声PCM, 帧数是混音块的整数倍
+        ASSET_PACK_TYPE_IMAGE = 2, // LVGL图片: 像素数据, 图片头字段见meta
+        ASSET_PACK_TYPE_FONT = 3,  // 字体文件 (TTF/OTF或LVGL二进制字体), 原样保存
+    } asset_pack_type_t;
+
+    /**
+     * @brief 文件头 (位于分区开头, 64字节)
+     */
+    typedef struct
+    {
+        uint32_t magic;        // ASSET_PACK_MAGIC
+        uint16_t version;      // ASSET_PACK_VERSION
+        uint16_t entry_size;   // sizeof(asset_pack_entry_t)
+        uint32_t count;        // 资源数量
+        uint32_t index_offset; // 索引相对资源包开头的偏移
+        uint32_t data_offset;  // 第一个数据块的偏移
+        uint32_t total_size;   // 资源包总长度 (映射长度)
+        uint32_t index_crc;    // 索引的CRC32
+        uint32_t reserved[9];
+    } asset_pack_header_t;
+
+    /**
+     * @brief 索引项 (64字节)
+     * @details meta的含义随类型变化:
+     *          PCM:   meta[0]帧数, meta[1]采样率, meta[2]声道数
+     *          IMAGE: meta[0]宽 | 高<<16, meta[1]颜色格式 | 行字节数<<16, meta[2]LVGL图片头标志
+     */
+    typedef struct
+    {
+        char name[ASSET_PACK_NAME_MAX]; // 相对路径去掉扩展名, 例如 "click"、"icons/wifi"
+        uint16_t type;                  // asset_pack_type_t
+        uint16_t flags;
+        uint32_t offset; // 数据相对资源包开头的偏移, ASSET_PACK_ALIGN对齐
+        uint32_t size;   // 数据字节数
+        uint32_t meta[3];
+        uint32_t crc;    // 数据的CRC32
+    } asset_pack_entry_t;
+
+    /**
+     * @brief 找到的资源
+     */
+    typedef struct
+    {
+        const asset_pack_entry_t *entry; // 指向映射中的索引项
+        const void *data;                // 指向映射中的数据, 资源包卸载前一直有效
+        size_t size;
+    } asset_pack_asset_t;
+
+    /**
+     * @brief 映射分区上的资源包
+     * @details 先读出文件头检查magic和索引CRC, 只映射total_size长度, 不占用整个分区的MMU页
+     * @param partition_label 分区名, 例如 "audio"
+     * @return esp_err_t ESP_OK成功, ESP_ERR_NOT_FOUND分区不存在,
+     *         ESP_ERR_INVALID_VERSION分区中不是资源包(例如仍是SPIFFS), ESP_ERR_INVALID_CRC索引损坏
+     */
+    esp_err_t asset_pack_init(const char *partition_label);
+
+    /**
+     * @brief 解除映射
+     * @note 之后不能再使用任何从资源包得到的指针 (注册到混音器的音效、LVGL图片等)
+     */
+    void asset_pack_deinit(void);
+
+    /**
+     * @brief 资源包是否已映射
+     */
+    bool asset_pack_is_mounted(void);
+
+    /**
+     * @brief 按名称查找资源 (在索引上二分, 不区分类型)
+     * @param name 资源名称
+     * @param out 输出资源
+     * @return esp_err_t ESP_OK成功, ESP_ERR_NOT_FOUND不存在, ESP_ERR_INVALID_STATE未初始化
+     */
+    esp_err_t asset_pack_find(const char *name, asset_pack_asset_t *out);
+
+    /**
+     * @brief 资源数量
+     */
+    uint32_t asset_pack_count(void);
+
+    /**
+     * @brief 按索引顺序(名称排序)取第index个资源, 用于遍历
+     * @return esp_err_t ESP_OK成功, ESP_ERR_NOT_FOUND越界
+     */
+    esp_err_t asset_pack_get(uint32_t index, asset_pack_asset_t *out);
+
+    /**
+     * @brief 逐个校验数据块的CRC (读一遍整个资源包, 只在烧录后或诊断时调用)
+     * @return esp_err_t ESP_OK全部正确, ESP_ERR_INVALID_CRC有损坏的资源
+     */
+    esp_err_t asset_pack_verify(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ASSET_PACK_H
@@ -1,5 +1,6 @@
 // 标准库头文件
 #include <string.h> // 字符串操作函数
+#include <math.h>   // 音量dB换算
 
 // 自定义头文件
 #include "audio_codec.h" // 音频编解码器接口定义
@@ -12,6 +13,11 @@
 #include "esp_codec_dev_defaults.h" // 编解码设备默认配置
 #include "es8311_codec.h"           // ES8311编解码器驱动
 #include "es7210_adc.h"             // ES7210 ADC驱动
+#include "esp_timer.h"              // 音量提交定时器
+#include "esp_attr.h"               // DMA中断回调放在IRAM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"         // 读写与档位切换互斥
 
 static const char *TAG = "audio_codec"; // 日志标签
 
@@ -23,7 +29,7 @@ static i2s_chan_handle_t s_i2s_rx_handle = NULL; // RX:录音通道
 static const audio_codec_if_t *s_playback_codec_if = NULL; // 播放接口(ES8311)
 static const audio_codec_if_t *s_record_codec_if = NULL;   // 录音接口(ES7210)
 
-// 数据传输接口句柄(I2S)
+// 数据传输接口(I2S), 见s_codec_data_if
 static const audio_codec_data_if_t *s_data_if = NULL;
 
 // Codec 设备句柄(高层封装,提供统一API)
@@ -33,6 +39,84 @@ static esp_codec_dev_handle_t s_record_dev = NULL;   // 录音设备
 // 当前音量值(0-100)
 static int s_current_volume = 60;
 
+// 音量分两级: 粗调的模拟音量写入ES8311, 剩余部分由混音器以软件增益实现
+static int s_analog_volume = -1;                            // 已写入codec的模拟音量, -1表示未写入
+static volatile int16_t s_soft_gain_q15 = AUDIO_CODEC_SOFT_GAIN_UNITY; // 软件增益(Q15)
+static esp_timer_handle_t s_volume_timer = NULL;            // 模拟音量延迟提交定时器
+static int64_t s_last_commit_us = 0;                        // 上次写入codec的时间
+static portMUX_TYPE s_volume_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// 模拟音量跨档与软件增益同步切换:
+// 混音器从写入流的s_switch_at字节(DMA缓冲区边界)起按新档位的软件增益输出,
+// 这个缓冲区开始播放时(上一个缓冲区的发送完成中断)通知s_volume_task写入寄存器
+typedef enum
+{
+    VOL_SWITCH_IDLE = 0, // 没有待切换的档位
+    VOL_SWITCH_PENDING,  // 定时器已决定跨档, 等混音器在块边界取走
+    VOL_SWITCH_ARMED,    // 混音器已按新档位写入, 等该块开始播放
+    VOL_SWITCH_WRITING,  // 已通知s_volume_task写入寄存器
+} volume_switch_state_t;
+
+static volatile volume_switch_state_t s_switch_state = VOL_SWITCH_IDLE;
+static int s_switch_target = -1;          // 新的模拟音量档位 (写入寄存器的值)
+static uint64_t s_switch_at = 0;          // 新档位第一个字节在写入流中的位置, s_latency_lock保护
+static bool s_switch_synced = false;      // 混音器调用过audio_codec_playback_volume_switch, 否则直接写寄存器
+static TaskHandle_t s_volume_task = NULL; // 写入寄存器的任务
+
+// 延迟档位: DMA缓冲区帧数都是AUDIO_CODEC_DMA_FRAMES的整数倍
+typedef struct
+{
+    const char *name;
+    uint32_t dma_frames;
+    uint32_t dma_desc_num;
+} latency_profile_cfg_t;
+
+static const latency_profile_cfg_t s_profile_cfgs[AUDIO_CODEC_LATENCY_MAX] = {
+    [AUDIO_CODEC_LATENCY_INTERACTIVE] = {"interactive", AUDIO_CODEC_INTERACTIVE_DMA_FRAMES, AUDIO_CODEC_INTERACTIVE_DMA_DESC},
+    [AUDIO_CODEC_LATENCY_BALANCED] = {"balanced", AUDIO_CODEC_BALANCED_DMA_FRAMES, AUDIO_CODEC_BALANCED_DMA_DESC},
+    [AUDIO_CODEC_LATENCY_MUSIC] = {"music", AUDIO_CODEC_MUSIC_DMA_FRAMES, AUDIO_CODEC_MUSIC_DMA_DESC},
+};
+
+_Static_assert(AUDIO_CODEC_INTERACTIVE_DMA_FRAMES % AUDIO_CODEC_DMA_FRAMES == 0 &&
+                   AUDIO_CODEC_BALANCED_DMA_FRAMES % AUDIO_CODEC_DMA_FRAMES == 0 &&
+                   AUDIO_CODEC_MUSIC_DMA_FRAMES % AUDIO_CODEC_DMA_FRAMES == 0,
+               "DMA缓冲区帧数必须是AUDIO_CODEC_DMA_FRAMES的整数倍");
+
+#define CODEC_BYTES_PER_FRAME (AUDIO_DEFAULT_CHANNELS * AUDIO_DEFAULT_BITS_PER_SAMPLE / 8)
+#define CODEC_LATENCY_AVG_SHIFT (4) // 平均延迟的指数平滑系数 1/16
+
+static audio_codec_latency_profile_t s_profile = AUDIO_CODEC_DEFAULT_LATENCY_PROFILE;
+static SemaphoreHandle_t s_tx_lock = NULL; // 播放写入与档位切换互斥
+static SemaphoreHandle_t s_rx_lock = NULL; // 录音读取与档位切换互斥
+static bool s_muted = false;               // 反初始化后重新初始化时恢复
+static float s_record_gain_db = 36.0f;     // 同上, 默认36dB
+static volatile bool s_mixer_active = false; // 混音器正在输出, 见audio_codec_playback_set_active
+
+// 延迟测量: DMA中断里累计已发送的字节, 写入后用"已写入-已发送"估算排队深度
+static portMUX_TYPE s_latency_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint64_t s_tx_written_bytes = 0;
+static uint64_t s_tx_sent_bytes = 0;
+static bool s_tx_next_silent = true; // 正在播放的DMA缓冲区是欠载时自动清零的静音, 发送完成时不计入
+static uint32_t s_tx_isr_count = 0;
+static uint32_t s_rx_isr_count = 0;
+static uint32_t s_latency_avg_us = 0;
+static uint32_t s_latency_max_us = 0;
+static int64_t s_profile_start_us = 0;
+
+// 各档位分别累计的统计: 上面是当前档位的计数, 切换档位时存入旧档位、取出新档位, 不清零
+typedef struct
+{
+    uint32_t tx_isr_count;
+    uint32_t rx_isr_count;
+    uint32_t latency_avg_us;
+    uint32_t latency_max_us;
+    int64_t active_us; // 该档位之前累计使用的时长
+} latency_profile_stats_t;
+
+static latency_profile_stats_t s_profile_stats[AUDIO_CODEC_LATENCY_MAX];
+
+#define CODEC_DATA_IF_TIMEOUT_MS (1000) // 经esp_codec_dev读写时的等待时间
+
 // I2C 设备地址定义(8位格式,包含读写位)
 #define ES8311_CODEC_ADDR 0x30 // ES8311编解码器地址(7位0x18左移1位)
 #define ES7210_ADC_ADDR 0x80   // ES7210 ADC地址(7位0x40左移1位)
@@ -47,15 +131,65 @@ static esp_err_t audio_i2c_init(void)
 }
 
 /**
- * @brief 初始化 I2S 接口（Duplex 模式，同时支持播放和录音）
+ * @brief TX DMA缓冲区发送完成中断: 统计中断次数和已播出的字节, 到达跨档位置时通知写入模拟音量
+ * @details 欠载时DMA播放自动清零的缓冲区, 之后写入的数据进入它后面的缓冲区; 这个静音缓冲区的
+ *          发送完成不计入已播出字节, 否则已播出字节会比实际超前一个缓冲区
+ */
+static IRAM_ATTR bool audio_i2s_tx_sent_cb(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    BaseType_t woken = pdFALSE;
+    bool notify = false;
+    portENTER_CRITICAL_ISR(&s_latency_lock);
+    s_tx_isr_count++;
+    if (!s_tx_next_silent)
+    {
+        s_tx_sent_bytes += event->size;
+        if (s_tx_sent_bytes > s_tx_written_bytes)
+        {
+            s_tx_sent_bytes = s_tx_written_bytes; // 缓冲区只写入了一部分
+        }
+    }
+    // 没有排队的数据: 现在开始播放的缓冲区是静音
+    s_tx_next_silent = (s_tx_sent_bytes == s_tx_written_bytes);
+    if (s_switch_state == VOL_SWITCH_ARMED && s_tx_sent_bytes >= s_switch_at)
+    {
+        // 按新档位输出的第一个缓冲区现在开始播放
+        s_switch_state = VOL_SWITCH_WRITING;
+        notify = true;
+    }
+    portEXIT_CRITICAL_ISR(&s_latency_lock);
+    if (notify)
+    {
+        vTaskNotifyGiveFromISR(s_volume_task, &woken);
+    }
+    return woken == pdTRUE;
+}
+
+/**
+ * @brief RX DMA缓冲区接收完成中断: 只统计中断次数
+ */
+static IRAM_ATTR bool audio_i2s_rx_recv_cb(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    portENTER_CRITICAL_ISR(&s_latency_lock);
+    s_rx_isr_count++;
+    portEXIT_CRITICAL_ISR(&s_latency_lock);
+    return false;
+}
+
+/**
+ * @brief 创建并启用 I2S 接口（Duplex 模式，同时支持播放和录音）
+ * @note DMA缓冲区的帧数和个数由当前延迟档位决定, 只能在创建通道时设置
  */
 static esp_err_t audio_i2s_init(void)
 {
     esp_err_t ret; // 错误码变量
+    const latency_profile_cfg_t *profile = &s_profile_cfgs[s_profile];
 
     // 配置 I2S 双工模式(同时TX和RX,使用I2S_NUM_0作为主机)
     i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
     chan_cfg.auto_clear = true; // 启用自动清空缓冲区
+    chan_cfg.dma_frame_num = profile->dma_frames; // 混音块的整数倍, 混音器写入不会跨缓冲区拼接
+    chan_cfg.dma_desc_num = profile->dma_desc_num;
 
     // 创建双工I2S通道(TX用于播放,RX用于录音)
     ret = i2s_new_channel(&chan_cfg, &s_i2s_tx_handle, &s_i2s_rx_handle);
@@ -108,10 +242,52 @@ static esp_err_t audio_i2s_init(void)
         return ret; // 失败则返回错误码
     }
 
+    // 注册DMA中断回调, 用于测量输出延迟和中断频率
+    i2s_channel_register_event_callback(s_i2s_tx_handle, &(i2s_event_callbacks_t){.on_sent = audio_i2s_tx_sent_cb}, NULL);
+    i2s_channel_register_event_callback(s_i2s_rx_handle, &(i2s_event_callbacks_t){.on_recv = audio_i2s_rx_recv_cb}, NULL);
+
+    // 启用 I2S TX通道(codec设备打开前MCLK必须已经输出)
+    ret = i2s_channel_enable(s_i2s_tx_handle);
+    if (ret != ESP_OK)
+    { // 检查是否成功
+        ESP_LOGE(TAG, "Failed to enable I2S TX channel: %s", esp_err_to_name(ret));
+        return ret; // 失败则返回错误码
+    }
+
+    // 启用 I2S RX通道(双工模式需要同时启用TX和RX)
+    ret = i2s_channel_enable(s_i2s_rx_handle);
+    if (ret != ESP_OK)
+    { // 检查是否成功
+        ESP_LOGE(TAG, "Failed to enable I2S RX channel: %s", esp_err_to_name(ret));
+        return ret; // 失败则返回错误码
+    }
+
     ESP_LOGI(TAG, "I2S duplex interface initialized"); // 记录初始化成功日志
     return ESP_OK;                                     // 成功返回
 }
 
+/**
+ * @brief 禁用并删除I2S通道 (反初始化和切换延迟档位共用)
+ */
+static void audio_i2s_deinit(void)
+{
+    // 禁用并删除I2S TX通道(如果已初始化)
+    if (s_i2s_tx_handle)
+    {
+        i2s_channel_disable(s_i2s_tx_handle); // 禁用通道
+        i2s_del_channel(s_i2s_tx_handle);     // 删除通道
+        s_i2s_tx_handle = NULL;               // 清空句柄
+    }
+
+    // 禁用并删除I2S RX通道(如果已初始化)
+    if (s_i2s_rx_handle)
+    {
+        i2s_channel_disable(s_i2s_rx_handle); // 禁用通道
+        i2s_del_channel(s_i2s_rx_handle);     // 删除通道
+        s_i2s_rx_handle = NULL;               // 清空句柄
+    }
+}
+
 /**
  * @brief 初始化功放控制引脚
  */
@@ -140,6 +316,238 @@ static esp_err_t audio_pa_init(void)
     return ESP_OK;                               // 成功返回
 }
 
+/**
+ * @brief 音量值换算成dB (与esp_codec_dev默认音量曲线一致: 0→最小dB, 100→0dB, 线性)
+ */
+static float volume_to_db(int volume)
+{
+    return AUDIO_CODEC_VOL_MIN_DB * (100 - volume) / 100.0f;
+}
+
+/**
+ * @brief 取不低于目标音量的最近一档模拟音量
+ */
+static int volume_to_analog(int volume)
+{
+    int analog = (volume + AUDIO_CODEC_ANALOG_VOL_STEP - 1) / AUDIO_CODEC_ANALOG_VOL_STEP * AUDIO_CODEC_ANALOG_VOL_STEP;
+    if (analog < AUDIO_CODEC_ANALOG_VOL_STEP)
+    {
+        analog = AUDIO_CODEC_ANALOG_VOL_STEP; // 音量0时保持最低档, 由软件增益静音
+    }
+    return analog > 100 ? 100 : analog;
+}
+
+/**
+ * @brief 计算在指定模拟音量下达到目标音量所需的软件增益
+ * @note 模拟音量总是不低于目标音量, 增益不超过单位增益. 调高到更高一档时, 跨档之前暂时限制在
+ *       单位增益; 跨档时软件增益与模拟音量在同一个DMA缓冲区边界切换, 不需要超过单位增益的补偿
+ */
+static int16_t volume_to_soft_gain(int volume, int analog)
+{
+    if (volume <= 0)
+    {
+        return 0;
+    }
+    float db = volume_to_db(volume) - volume_to_db(analog);
+    if (db >= 0.0f)
+    {
+        return AUDIO_CODEC_SOFT_GAIN_UNITY;
+    }
+    return (int16_t)(powf(10.0f, db / 20.0f) * AUDIO_CODEC_SOFT_GAIN_UNITY);
+}
+
+/**
+ * @brief 把最新的模拟音量写入codec (合并期间的所有调节, 只写最后一次)
+ * @details 混音器运行时不在这里写: 只标记待切换, 由混音器在块边界按新档位换算软件增益
+ *          (audio_codec_playback_volume_switch), 该块开始播放时再写入寄存器, 两者在同一位置生效
+ */
+static void volume_commit(void)
+{
+    int volume, analog;
+    bool synced;
+    portENTER_CRITICAL(&s_volume_lock);
+    volume = s_current_volume;
+    analog = s_analog_volume;
+    synced = s_switch_synced;
+    if (synced && s_switch_state == VOL_SWITCH_IDLE && volume_to_analog(volume) != analog)
+    {
+        s_switch_state = VOL_SWITCH_PENDING;
+    }
+    portEXIT_CRITICAL(&s_volume_lock);
+
+    int target = volume_to_analog(volume);
+    if (synced || target == analog || s_playback_dev == NULL)
+    {
+        return; // 跨档进行中时由volume_switch_task完成后重新检查
+    }
+
+    if (esp_codec_dev_set_out_vol(s_playback_dev, target) != ESP_CODEC_DEV_OK)
+    {
+        ESP_LOGW(TAG, "写入模拟音量失败: %d", target);
+        return;
+    }
+
+    portENTER_CRITICAL(&s_volume_lock);
+    s_analog_volume = target;
+    s_last_commit_us = esp_timer_get_time();
+    // 期间音量可能又变了, 以最新值重新计算软件增益
+    s_soft_gain_q15 = volume_to_soft_gain(s_current_volume, target);
+    portEXIT_CRITICAL(&s_volume_lock);
+    ESP_LOGD(TAG, "模拟音量提交: %d", target);
+}
+
+static void volume_timer_cb(void *arg)
+{
+    volume_commit();
+}
+
+/**
+ * @brief 跨档任务: 按新档位输出的第一个DMA缓冲区开始播放时写入模拟音量
+ * @details 由发送完成中断唤醒, 高优先级, 从唤醒到I2C写入完成约几百微秒
+ */
+static void volume_switch_task(void *arg)
+{
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        esp_codec_dev_handle_t dev = s_playback_dev;
+        if (dev != NULL && esp_codec_dev_set_out_vol(dev, s_switch_target) != ESP_CODEC_DEV_OK)
+        {
+            ESP_LOGW(TAG, "写入模拟音量失败: %d", s_switch_target);
+        }
+
+        portENTER_CRITICAL(&s_volume_lock);
+        s_switch_state = VOL_SWITCH_IDLE;
+        s_last_commit_us = esp_timer_get_time();
+        bool again = volume_to_analog(s_current_volume) != s_analog_volume;
+        portEXIT_CRITICAL(&s_volume_lock);
+        ESP_LOGD(TAG, "模拟音量提交: %d", s_switch_target);
+
+        // 期间音量又跨了档, 按提交间隔再切换一次
+        if (again && s_volume_timer != NULL && !esp_timer_is_active(s_volume_timer))
+        {
+            esp_timer_start_once(s_volume_timer, AUDIO_CODEC_VOL_COMMIT_MS * 1000);
+        }
+    }
+}
+
+bool audio_codec_playback_volume_switch(int16_t gain_q15, int16_t *new_gain_q15)
+{
+    if (new_gain_q15 == NULL)
+    {
+        return false;
+    }
+    *new_gain_q15 = gain_q15;
+    s_switch_synced = true;
+    if (s_switch_state != VOL_SWITCH_PENDING)
+    {
+        return false;
+    }
+
+    portENTER_CRITICAL(&s_volume_lock);
+    int from = s_analog_volume;
+    int to = volume_to_analog(s_current_volume);
+    portEXIT_CRITICAL(&s_volume_lock);
+    if (to == from)
+    {
+        s_switch_state = VOL_SWITCH_IDLE; // 期间音量又回到了原来的档位
+        return false;
+    }
+
+    // 换算后电平不变: gain x 旧档位 = new_gain x 新档位. 调低一档时要等软件增益先降到新档位以内
+    float gain = gain_q15 * powf(10.0f, (volume_to_db(from) - volume_to_db(to)) / 20.0f);
+    if (gain > AUDIO_CODEC_SOFT_GAIN_UNITY)
+    {
+        return false;
+    }
+
+    // 新档位从写入流的DMA缓冲区边界开始, 发送完成中断才能对齐; 队列已空(正在播放静音)时立即切换
+    const uint64_t buf_bytes = (uint64_t)s_profile_cfgs[s_profile].dma_frames * CODEC_BYTES_PER_FRAME;
+    bool switched = false;
+    bool now = false;
+    portENTER_CRITICAL(&s_latency_lock);
+    bool empty = (s_tx_sent_bytes == s_tx_written_bytes);
+    if (empty || s_tx_written_bytes % buf_bytes == 0)
+    {
+        s_switch_at = s_tx_written_bytes;
+        s_switch_target = to;
+        s_switch_state = empty ? VOL_SWITCH_WRITING : VOL_SWITCH_ARMED;
+        switched = true;
+        now = empty;
+    }
+    portEXIT_CRITICAL(&s_latency_lock);
+    if (!switched)
+    {
+        return false; // 等下一个对齐的块
+    }
+
+    portENTER_CRITICAL(&s_volume_lock);
+    s_analog_volume = to; // 之后的软件增益按新档位计算
+    s_soft_gain_q15 = volume_to_soft_gain(s_current_volume, to);
+    portEXIT_CRITICAL(&s_volume_lock);
+    if (now)
+    {
+        xTaskNotifyGive(s_volume_task);
+    }
+    *new_gain_q15 = (int16_t)(gain + 0.5f);
+    return true;
+}
+
+/*
+ * codec设备的数据接口. esp_codec_dev自带的I2S数据接口创建时记住通道句柄, 切换延迟档位重建通道后
+ * 就会失效; 这里每次读写时才经audio_codec_playback_write/record_read取当前通道, ES8311/ES7210设备
+ * 和功放在切换时保持不变. 通道由本文件创建和启用, 设备打开关闭时的enable/set_fmt只检查格式
+ */
+static int codec_data_open(const audio_codec_data_if_t *h, void *data_cfg, int cfg_size)
+{
+    return ESP_CODEC_DEV_OK;
+}
+
+static bool codec_data_is_open(const audio_codec_data_if_t *h)
+{
+    return true;
+}
+
+static int codec_data_enable(const audio_codec_data_if_t *h, esp_codec_dev_type_t dev_type, bool enable)
+{
+    return ESP_CODEC_DEV_OK;
+}
+
+static int codec_data_set_fmt(const audio_codec_data_if_t *h, esp_codec_dev_type_t dev_type, esp_codec_dev_sample_info_t *fs)
+{
+    // 通道固定为48kHz/16位/立体声
+    bool match = fs->sample_rate == AUDIO_DEFAULT_SAMPLE_RATE && fs->channel == AUDIO_DEFAULT_CHANNELS &&
+                 fs->bits_per_sample == AUDIO_DEFAULT_BITS_PER_SAMPLE;
+    return match ? ESP_CODEC_DEV_OK : ESP_CODEC_DEV_NOT_SUPPORT;
+}
+
+static int codec_data_read(const audio_codec_data_if_t *h, uint8_t *data, int size)
+{
+    esp_err_t ret = audio_codec_record_read(data, size, CODEC_DATA_IF_TIMEOUT_MS);
+    return ret == ESP_OK ? ESP_CODEC_DEV_OK : ESP_CODEC_DEV_DRV_ERR;
+}
+
+static int codec_data_write(const audio_codec_data_if_t *h, uint8_t *data, int size)
+{
+    esp_err_t ret = audio_codec_playback_write((const int16_t *)data, size / CODEC_BYTES_PER_FRAME, CODEC_DATA_IF_TIMEOUT_MS);
+    return ret == ESP_OK ? ESP_CODEC_DEV_OK : ESP_CODEC_DEV_DRV_ERR;
+}
+
+static int codec_data_close(const audio_codec_data_if_t *h)
+{
+    return ESP_CODEC_DEV_OK;
+}
+
+static const audio_codec_data_if_t s_codec_data_if = {
+    .open = codec_data_open,
+    .is_open = codec_data_is_open,
+    .enable = codec_data_enable,
+    .set_fmt = codec_data_set_fmt,
+    .read = codec_data_read,
+    .write = codec_data_write,
+    .close = codec_data_close,
+};
+
 /**
  * @brief 初始化 ES8311 编解码器
  */
@@ -190,7 +598,10 @@ static esp_err_t audio_es8311_init(void)
                                                                  .bits_per_sample = AUDIO_DEFAULT_BITS_PER_SAMPLE, // 采样位宽(16位)
                                                              }) == ESP_CODEC_DEV_OK)
     {                                                                // 检查打开是否成功
-        esp_codec_dev_set_out_vol(s_playback_dev, s_current_volume); // 设置默认音量
+        s_analog_volume = volume_to_analog(s_current_volume);
+        esp_codec_dev_set_out_vol(s_playback_dev, s_analog_volume); // 设置默认音量(粗调部分)
+        esp_codec_dev_set_out_mute(s_playback_dev, s_muted);        // 恢复静音状态(重新初始化时)
+        s_soft_gain_q15 = volume_to_soft_gain(s_current_volume, s_analog_volume);
         ESP_LOGI(TAG, "ES8311 initialized");                         // 记录初始化成功日志
         return ESP_OK;                                               // 成功返回
     }
@@ -235,7 +646,7 @@ static esp_err_t audio_es7210_init(void)
                                                              .bits_per_sample = AUDIO_DEFAULT_BITS_PER_SAMPLE, // 采样位宽(16位)
                                                          }) == ESP_CODEC_DEV_OK)
     {                                                  // 检查打开是否成功
-        esp_codec_dev_set_in_gain(s_record_dev, 36.0); // 设置默认增益(36dB)
+        esp_codec_dev_set_in_gain(s_record_dev, s_record_gain_db); // 设置增益(默认36dB)
         ESP_LOGI(TAG, "ES7210 initialized");           // 记录初始化成功日志
         return ESP_OK;                                 // 成功返回
     }
@@ -244,53 +655,35 @@ static esp_err_t audio_es7210_init(void)
     return ESP_FAIL;                        // 失败返回
 }
 
-esp_err_t audio_codec_init(void)
+/**
+ * @brief 创建I2S通道和codec设备
+ */
+static esp_err_t audio_codec_start_io(void)
 {
     esp_err_t ret; // 错误码变量
 
-    ESP_LOGI(TAG, "Initializing audio codec..."); // 记录初始化开始日志
-
-    // 步骤1: 初始化 I2C 总线
-    ret = audio_i2c_init();
-    if (ret != ESP_OK)
-    {               // 检查是否成功
-        return ret; // 失败则返回错误码
-    }
+    // 重新开始延迟统计(各档位都清零)
+    portENTER_CRITICAL(&s_latency_lock);
+    s_tx_written_bytes = 0;
+    s_tx_sent_bytes = 0;
+    s_tx_next_silent = true;
+    s_tx_isr_count = 0;
+    s_rx_isr_count = 0;
+    s_latency_avg_us = 0;
+    s_latency_max_us = 0;
+    memset(s_profile_stats, 0, sizeof(s_profile_stats));
+    portEXIT_CRITICAL(&s_latency_lock);
+    s_profile_start_us = esp_timer_get_time();
 
-    // 步骤2: 初始化 I2S 接口(配置双工模式:TX播放+RX录音)
+    // 步骤2-3: 创建并启用 I2S 接口(配置双工模式:TX播放+RX录音)
     ret = audio_i2s_init();
     if (ret != ESP_OK)
     {               // 检查是否成功
         return ret; // 失败则返回错误码
     }
 
-    // 步骤3: 启用 I2S TX通道(必须在创建数据接口前启用)
-    ret = i2s_channel_enable(s_i2s_tx_handle);
-    if (ret != ESP_OK)
-    { // 检查是否成功
-        ESP_LOGE(TAG, "Failed to enable I2S TX channel: %s", esp_err_to_name(ret));
-        return ret; // 失败则返回错误码
-    }
-
-    // 步骤3.5: 启用 I2S RX通道(双工模式需要同时启用TX和RX)
-    ret = i2s_channel_enable(s_i2s_rx_handle);
-    if (ret != ESP_OK)
-    { // 检查是否成功
-        ESP_LOGE(TAG, "Failed to enable I2S RX channel: %s", esp_err_to_name(ret));
-        return ret; // 失败则返回错误码
-    }
-
-    // 步骤4: 创建数据接口(将I2S通道绑定到codec设备)
-    audio_codec_i2s_cfg_t i2s_cfg = {
-        .rx_handle = s_i2s_rx_handle, // 绑定RX通道
-        .tx_handle = s_i2s_tx_handle, // 绑定TX通道
-    };
-    s_data_if = audio_codec_new_i2s_data(&i2s_cfg); // 创建I2S数据接口
-    if (s_data_if == NULL)
-    { // 检查创建是否成功
-        ESP_LOGE(TAG, "Failed to create I2S data interface");
-        return ESP_FAIL; // 失败则返回错误
-    }
+    // 步骤4: 数据接口(codec设备经它读写当前的I2S通道)
+    s_data_if = &s_codec_data_if;
 
     // 步骤5: 初始化功放控制引脚(GPIO46)
     ret = audio_pa_init();
@@ -313,18 +706,21 @@ esp_err_t audio_codec_init(void)
         return ret; // 失败则返回错误码
     }
 
-    ESP_LOGI(TAG, "Audio codec initialization complete"); // 记录初始化完成日志
-    return ESP_OK;                                        // 所有步骤成功,返回OK
+    return ESP_OK; // 所有步骤成功,返回OK
 }
 
-esp_err_t audio_codec_deinit(void)
+/**
+ * @brief 删除codec设备和I2S通道
+ */
+static void audio_codec_stop_io(void)
 {
     // 关闭并删除播放设备(如果已初始化)
     if (s_playback_dev)
     {
-        esp_codec_dev_close(s_playback_dev);  // 关闭设备
-        esp_codec_dev_delete(s_playback_dev); // 删除设备对象
-        s_playback_dev = NULL;                // 清空句柄
+        esp_codec_dev_handle_t dev = s_playback_dev;
+        s_playback_dev = NULL;      // 先清空句柄, 音量提交定时器不再访问
+        esp_codec_dev_close(dev);   // 关闭设备
+        esp_codec_dev_delete(dev);  // 删除设备对象
     }
 
     // 关闭并删除录音设备(如果已初始化)
@@ -349,29 +745,290 @@ esp_err_t audio_codec_deinit(void)
         s_record_codec_if = NULL;                       // 清空句柄
     }
 
-    // 删除数据接口(如果已初始化)
-    if (s_data_if)
+    // 数据接口是静态对象, 不需要删除
+    s_data_if = NULL;
+
+    // 禁用并删除I2S通道
+    audio_i2s_deinit();
+}
+
+/**
+ * @brief 切换档位时交换当前统计: 当前计数存入旧档位, 取出新档位之前累计的计数
+ * @note 调用时I2S通道已删除, 没有中断在更新计数
+ */
+static void latency_stats_switch(audio_codec_latency_profile_t from, audio_codec_latency_profile_t to)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_latency_lock);
+    latency_profile_stats_t *old = &s_profile_stats[from];
+    old->tx_isr_count = s_tx_isr_count;
+    old->rx_isr_count = s_rx_isr_count;
+    old->latency_avg_us = s_latency_avg_us;
+    old->latency_max_us = s_latency_max_us;
+    old->active_us += now - s_profile_start_us;
+
+    const latency_profile_stats_t *cur = &s_profile_stats[to];
+    s_tx_isr_count = cur->tx_isr_count;
+    s_rx_isr_count = cur->rx_isr_count;
+    s_latency_avg_us = cur->latency_avg_us;
+    s_latency_max_us = cur->latency_max_us;
+    s_profile_start_us = now;
+
+    // 新通道的DMA队列是空的
+    s_tx_written_bytes = 0;
+    s_tx_sent_bytes = 0;
+    s_tx_next_silent = true;
+    portEXIT_CRITICAL(&s_latency_lock);
+}
+
+esp_err_t audio_codec_init(void)
+{
+    esp_err_t ret; // 错误码变量
+
+    ESP_LOGI(TAG, "Initializing audio codec..."); // 记录初始化开始日志
+
+    // 步骤1: 初始化 I2C 总线
+    ret = audio_i2c_init();
+    if (ret != ESP_OK)
+    {               // 检查是否成功
+        return ret; // 失败则返回错误码
+    }
+
+    if (s_tx_lock == NULL)
+    {
+        s_tx_lock = xSemaphoreCreateMutex();
+        s_rx_lock = xSemaphoreCreateMutex();
+        if (s_tx_lock == NULL || s_rx_lock == NULL)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (s_volume_task == NULL &&
+        xTaskCreate(volume_switch_task, "codec_vol", 3072, NULL, AUDIO_CODEC_VOL_TASK_PRIORITY, &s_volume_task) != pdPASS)
     {
-        audio_codec_delete_data_if(s_data_if); // 删除数据接口对象
-        s_data_if = NULL;                      // 清空句柄
+        return ESP_ERR_NO_MEM;
     }
 
-    // 禁用并删除I2S TX通道(如果已初始化)
-    if (s_i2s_tx_handle)
+    // 步骤2-7: I2S通道、功放引脚和codec设备
+    ret = audio_codec_start_io();
+    if (ret != ESP_OK)
     {
-        i2s_channel_disable(s_i2s_tx_handle); // 禁用通道
-        i2s_del_channel(s_i2s_tx_handle);     // 删除通道
-        s_i2s_tx_handle = NULL;               // 清空句柄
+        return ret;
     }
 
-    // 禁用并删除I2S RX通道(如果已初始化)
-    if (s_i2s_rx_handle)
+    ESP_LOGI(TAG, "Audio codec initialization complete, latency profile: %s", s_profile_cfgs[s_profile].name); // 记录初始化完成日志
+    return ESP_OK;                                                                                            // 所有步骤成功,返回OK
+}
+
+esp_err_t audio_codec_set_latency_profile(audio_codec_latency_profile_t profile)
+{
+    if ((unsigned)profile >= AUDIO_CODEC_LATENCY_MAX)
     {
-        i2s_channel_disable(s_i2s_rx_handle); // 禁用通道
-        i2s_del_channel(s_i2s_rx_handle);     // 删除通道
-        s_i2s_rx_handle = NULL;               // 清空句柄
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_tx_lock == NULL || s_i2s_tx_handle == NULL)
+    {
+        s_profile = profile; // 未初始化时只记录, audio_codec_init()按此档位创建通道
+        return ESP_OK;
+    }
+    if (profile == s_profile)
+    {
+        return ESP_OK;
+    }
+
+    // 等正在进行的读写结束, 切换期间新的读写阻塞(超时则返回失败)
+    xSemaphoreTake(s_tx_lock, portMAX_DELAY);
+    xSemaphoreTake(s_rx_lock, portMAX_DELAY);
+
+    // 混音器还有流在输出, 或DMA队列里还有没播完的数据: 删除通道会截断声音
+    portENTER_CRITICAL(&s_latency_lock);
+    bool playing = s_mixer_active || s_tx_sent_bytes != s_tx_written_bytes;
+    portEXIT_CRITICAL(&s_latency_lock);
+    if (playing)
+    {
+        xSemaphoreGive(s_rx_lock);
+        xSemaphoreGive(s_tx_lock);
+        ESP_LOGW(TAG, "正在播放, 不能切换延迟档位");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // 只重建I2S通道; codec设备经s_codec_data_if访问通道, 功放和寄存器设置保持不变
+    audio_codec_latency_profile_t old = s_profile;
+    int64_t start_us = esp_timer_get_time();
+    audio_i2s_deinit();
+    latency_stats_switch(old, profile);
+    s_profile = profile;
+    esp_err_t ret = audio_i2s_init();
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "切换到延迟档位%s失败, 恢复%s", s_profile_cfgs[profile].name, s_profile_cfgs[old].name);
+        audio_i2s_deinit();
+        latency_stats_switch(profile, old);
+        s_profile = old;
+        if (audio_i2s_init() != ESP_OK)
+        {
+            audio_i2s_deinit();
+            ESP_LOGE(TAG, "恢复延迟档位失败, 音频不可用");
+        }
+    }
+    else
+    {
+        const latency_profile_cfg_t *cfg = &s_profile_cfgs[profile];
+        ESP_LOGI(TAG, "延迟档位: %s, DMA %lu帧 x %lu, 切换耗时 %lld us", cfg->name, (unsigned long)cfg->dma_frames,
+                 (unsigned long)cfg->dma_desc_num, esp_timer_get_time() - start_us);
+    }
+
+    xSemaphoreGive(s_rx_lock);
+    xSemaphoreGive(s_tx_lock);
+    return ret;
+}
+
+audio_codec_latency_profile_t audio_codec_get_latency_profile(void)
+{
+    return s_profile;
+}
+
+esp_err_t audio_codec_get_profile_latency_stats(audio_codec_latency_profile_t profile, audio_codec_latency_stats_t *stats)
+{
+    if (stats == NULL || (unsigned)profile >= AUDIO_CODEC_LATENCY_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const latency_profile_cfg_t *cfg = &s_profile_cfgs[profile];
+    memset(stats, 0, sizeof(*stats));
+    stats->profile = profile;
+    stats->dma_frames = cfg->dma_frames;
+    stats->dma_desc_num = cfg->dma_desc_num;
+    stats->buffer_us = (uint32_t)((uint64_t)cfg->dma_frames * cfg->dma_desc_num * 1000000ULL / AUDIO_DEFAULT_SAMPLE_RATE);
+
+    int64_t now = esp_timer_get_time();
+    latency_profile_stats_t st;
+    portENTER_CRITICAL(&s_latency_lock);
+    st = s_profile_stats[profile];
+    if (profile == s_profile)
+    {
+        // 当前档位: 加上这一段的计数
+        st.tx_isr_count = s_tx_isr_count;
+        st.rx_isr_count = s_rx_isr_count;
+        st.latency_avg_us = s_latency_avg_us;
+        st.latency_max_us = s_latency_max_us;
+        st.active_us += now - s_profile_start_us;
+    }
+    portEXIT_CRITICAL(&s_latency_lock);
+
+    stats->latency_avg_us = st.latency_avg_us;
+    stats->latency_max_us = st.latency_max_us;
+    if (st.active_us > 0)
+    {
+        stats->tx_isr_per_sec = (uint32_t)((uint64_t)st.tx_isr_count * 1000000ULL / (uint64_t)st.active_us);
+        stats->rx_isr_per_sec = (uint32_t)((uint64_t)st.rx_isr_count * 1000000ULL / (uint64_t)st.active_us);
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_codec_get_latency_stats(audio_codec_latency_stats_t *stats)
+{
+    return audio_codec_get_profile_latency_stats(s_profile, stats);
+}
+
+void audio_codec_playback_set_active(bool active)
+{
+    s_mixer_active = active;
+}
+
+esp_err_t audio_codec_playback_write(const int16_t *pcm, size_t frames, uint32_t timeout_ms)
+{
+    if (pcm == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_tx_lock == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xSemaphoreTake(s_tx_lock, pdMS_TO_TICKS(timeout_ms)) != pdTRUE)
+    {
+        return ESP_ERR_TIMEOUT; // 正在切换延迟档位
+    }
+    if (s_i2s_tx_handle == NULL)
+    {
+        xSemaphoreGive(s_tx_lock);
+        return ESP_ERR_INVALID_STATE;
     }
 
+    size_t len = frames * CODEC_BYTES_PER_FRAME;
+    size_t written = 0;
+    esp_err_t ret = i2s_channel_write(s_i2s_tx_handle, pcm, len, &written, timeout_ms);
+    if (ret == ESP_OK && written != len)
+    {
+        ret = ESP_ERR_TIMEOUT;
+    }
+
+    // 刚写入的数据要等DMA中排在前面的数据播完, 排队深度就是它的输出延迟
+    portENTER_CRITICAL(&s_latency_lock);
+    s_tx_written_bytes += written;
+    uint32_t latency_us = (uint32_t)((s_tx_written_bytes - s_tx_sent_bytes) * 1000000ULL /
+                                     (AUDIO_DEFAULT_SAMPLE_RATE * CODEC_BYTES_PER_FRAME));
+    s_latency_avg_us += ((int32_t)latency_us - (int32_t)s_latency_avg_us) >> CODEC_LATENCY_AVG_SHIFT;
+    s_latency_max_us = latency_us > s_latency_max_us ? latency_us : s_latency_max_us;
+    portEXIT_CRITICAL(&s_latency_lock);
+
+    xSemaphoreGive(s_tx_lock);
+    return ret;
+}
+
+esp_err_t audio_codec_record_read(void *data, size_t len, uint32_t timeout_ms)
+{
+    if (data == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_rx_lock == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xSemaphoreTake(s_rx_lock, pdMS_TO_TICKS(timeout_ms)) != pdTRUE)
+    {
+        return ESP_ERR_TIMEOUT; // 正在切换延迟档位
+    }
+    if (s_i2s_rx_handle == NULL)
+    {
+        xSemaphoreGive(s_rx_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    size_t got = 0;
+    esp_err_t ret = i2s_channel_read(s_i2s_rx_handle, data, len, &got, timeout_ms);
+    if (ret == ESP_OK && got != len)
+    {
+        ret = ESP_ERR_TIMEOUT;
+    }
+    xSemaphoreGive(s_rx_lock);
+    return ret;
+}
+
+esp_err_t audio_codec_deinit(void)
+{
+    // 停止模拟音量提交定时器
+    if (s_volume_timer)
+    {
+        esp_timer_stop(s_volume_timer);
+        esp_timer_delete(s_volume_timer);
+        s_volume_timer = NULL;
+    }
+    if (s_volume_task)
+    {
+        vTaskDelete(s_volume_task);
+        s_volume_task = NULL;
+    }
+    s_switch_state = VOL_SWITCH_IDLE;
+    s_switch_synced = false;
+    s_analog_volume = -1;
+
+    // 删除codec设备和I2S通道
+    audio_codec_stop_io();
+
     // I2C总线由 i2c_manager 统一管理,不在此处删除
 
     ESP_LOGI(TAG, "Audio codec deinitialized"); // 记录反初始化完成日志
@@ -398,6 +1055,9 @@ esp_codec_dev_handle_t audio_codec_get_record_dev(void)
 
 /**
  * @brief 设置播放音量
+ * @details 不直接写codec: 立即更新软件增益(混音器逐帧平滑过渡), 模拟音量只在跨档时
+ *          由定时器延迟提交, 两次提交间隔不小于AUDIO_CODEC_VOL_COMMIT_MS, 期间的调节合并为最后一次;
+ *          提交时软件增益和模拟音量在同一个DMA缓冲区边界切换 (见audio_codec_playback_volume_switch)
  * @param volume 音量值(0-100)
  * @return ESP_OK:成功, ESP_ERR_INVALID_ARG:参数无效, ESP_FAIL:设置失败
  */
@@ -409,13 +1069,32 @@ esp_err_t audio_codec_set_volume(int volume)
         return ESP_ERR_INVALID_ARG; // 参数无效
     }
 
-    // 调用底层API设置音量
-    if (esp_codec_dev_set_out_vol(s_playback_dev, volume) == ESP_CODEC_DEV_OK)
+    if (s_volume_timer == NULL)
     {
-        s_current_volume = volume; // 更新当前音量值
-        return ESP_OK;             // 设置成功
+        const esp_timer_create_args_t timer_args = {
+            .callback = volume_timer_cb,
+            .name = "codec_vol",
+        };
+        if (esp_timer_create(&timer_args, &s_volume_timer) != ESP_OK)
+        {
+            return ESP_FAIL; // 设置失败
+        }
     }
-    return ESP_FAIL; // 设置失败
+
+    int64_t delay_us;
+    portENTER_CRITICAL(&s_volume_lock);
+    s_current_volume = volume; // 更新当前音量值
+    s_soft_gain_q15 = volume_to_soft_gain(volume, s_analog_volume);
+    bool need_commit = volume_to_analog(volume) != s_analog_volume;
+    delay_us = s_last_commit_us + AUDIO_CODEC_VOL_COMMIT_MS * 1000LL - esp_timer_get_time();
+    portEXIT_CRITICAL(&s_volume_lock);
+
+    // 已有待提交的写入时直接返回, 定时器到期后读取最新音量
+    if (need_commit && !esp_timer_is_active(s_volume_timer))
+    {
+        esp_timer_start_once(s_volume_timer, delay_us > 0 ? (uint64_t)delay_us : 0);
+    }
+    return ESP_OK; // 设置成功
 }
 
 /**
@@ -434,6 +1113,15 @@ esp_err_t audio_codec_get_volume(int *volume)
     return ESP_OK;              // 获取成功
 }
 
+/**
+ * @brief 获取软件增益(音量中未由codec模拟音量实现的部分)
+ * @return Q15增益, 由混音器作为主音量逐帧平滑应用
+ */
+int16_t audio_codec_get_soft_gain_q15(void)
+{
+    return s_soft_gain_q15;
+}
+
 /**
  * @brief 设置静音状态
  * @param enable true:静音, false:取消静音
@@ -447,6 +1135,7 @@ esp_err_t audio_codec_set_mute(bool enable)
         return ESP_ERR_INVALID_STATE; // 设备未初始化
     }
     // 调用底层API设置静音状态并返回结果
+    s_muted = enable;
     return (esp_codec_dev_set_out_mute(s_playback_dev, enable) == ESP_CODEC_DEV_OK) ? ESP_OK : ESP_FAIL;
 }
 
@@ -467,6 +1156,7 @@ esp_err_t audio_codec_set_record_gain(float db)
     {
         return ESP_ERR_INVALID_STATE;
     }
+    s_record_gain_db = db;
     return (esp_codec_dev_set_in_gain(s_record_dev, db) == ESP_CODEC_DEV_OK) ? ESP_OK : ESP_FAIL;
 }
 
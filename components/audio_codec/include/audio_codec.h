@@ -1,6 +1,9 @@
 #ifndef AUDIO_CODEC_H
 #define AUDIO_CODEC_H
 
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
 #include "esp_err.h"
 #include "esp_codec_dev.h"
 
@@ -24,6 +27,49 @@ extern "C"
 #define AUDIO_DEFAULT_BITS_PER_SAMPLE (16)
 #define AUDIO_DEFAULT_CHANNELS (2)
 
+// I2S DMA配置: 各延迟档位的DMA缓冲区帧数都是AUDIO_CODEC_DMA_FRAMES(混音块)的整数倍
+#define AUDIO_CODEC_DMA_FRAMES (240)              // DMA缓冲区帧数的基本单位 (5ms)
+#define AUDIO_CODEC_INTERACTIVE_DMA_FRAMES (240)  // 交互档: 5ms x 2, 缓冲10ms, 每通道200次中断/秒
+#define AUDIO_CODEC_INTERACTIVE_DMA_DESC (2)
+#define AUDIO_CODEC_BALANCED_DMA_FRAMES (240)     // 均衡档(默认): 5ms x 6, 缓冲30ms
+#define AUDIO_CODEC_BALANCED_DMA_DESC (6)
+#define AUDIO_CODEC_MUSIC_DMA_FRAMES (960)        // 音乐档: 20ms x 4, 缓冲80ms, 每通道50次中断/秒
+#define AUDIO_CODEC_MUSIC_DMA_DESC (4)
+#define AUDIO_CODEC_DEFAULT_LATENCY_PROFILE AUDIO_CODEC_LATENCY_BALANCED
+
+    /**
+     * @brief 输出延迟档位
+     */
+    typedef enum
+    {
+        AUDIO_CODEC_LATENCY_INTERACTIVE = 0, // 低延迟: UI音效、监听
+        AUDIO_CODEC_LATENCY_BALANCED,        // 默认
+        AUDIO_CODEC_LATENCY_MUSIC,           // 高吞吐: 中断少, CPU占用低
+        AUDIO_CODEC_LATENCY_MAX,
+    } audio_codec_latency_profile_t;
+
+    /**
+     * @brief 一个档位的配置和实测数据 (各档位分别累计, 切换档位不清零)
+     */
+    typedef struct
+    {
+        audio_codec_latency_profile_t profile;
+        uint32_t dma_frames;     // 每个DMA缓冲区的帧数
+        uint32_t dma_desc_num;   // DMA缓冲区个数
+        uint32_t buffer_us;      // DMA总缓冲时长 (延迟上限)
+        uint32_t latency_avg_us; // 实测输出延迟(写入到播出)的平滑平均值
+        uint32_t latency_max_us; // 实测输出延迟的最大值
+        uint32_t tx_isr_per_sec; // TX DMA中断频率
+        uint32_t rx_isr_per_sec; // RX DMA中断频率
+    } audio_codec_latency_stats_t;
+
+// 音量配置: 模拟音量按档写入codec, 档内的差值由软件增益补足
+#define AUDIO_CODEC_ANALOG_VOL_STEP (25)      // 模拟音量档位间隔(0-100刻度)
+#define AUDIO_CODEC_VOL_COMMIT_MS (150)       // 两次写入codec音量寄存器的最小间隔
+#define AUDIO_CODEC_VOL_MIN_DB (-50.0f)       // 音量0对应的dB (与esp_codec_dev默认曲线一致)
+#define AUDIO_CODEC_SOFT_GAIN_UNITY (32767)   // 软件增益的单位值(Q15)
+#define AUDIO_CODEC_VOL_TASK_PRIORITY (20)    // 跨档时写入模拟音量的任务, 要在DMA缓冲区开始播放后尽快写入
+
     /**
      * @brief 初始化音频编解码器
      *
@@ -52,8 +98,73 @@ extern "C"
      */
     esp_codec_dev_handle_t audio_codec_get_record_dev(void);
 
+    /**
+     * @brief 写入播放数据 (直接写入I2S TX通道, 不经过esp_codec_dev)
+     * @note 帧数为AUDIO_CODEC_DMA_FRAMES的整数倍时每次正好填满DMA缓冲区, 驱动内部不需要拼接
+     *
+     * @param pcm 16位立体声交织PCM
+     * @param frames 帧数
+     * @param timeout_ms DMA没有空间时的最长等待时间
+     * @return esp_err_t ESP_OK 全部写入, ESP_ERR_TIMEOUT 超时, ESP_ERR_INVALID_STATE 未初始化
+     */
+    esp_err_t audio_codec_playback_write(const int16_t *pcm, size_t frames, uint32_t timeout_ms);
+
+    /**
+     * @brief 读取录音数据 (直接从I2S RX通道读取, 不经过esp_codec_dev)
+     *
+     * @param data 输出缓冲区, 16位立体声交织PCM
+     * @param len 字节数
+     * @param timeout_ms 最长等待时间
+     * @return esp_err_t ESP_OK 读满len字节, ESP_ERR_TIMEOUT 超时, ESP_ERR_INVALID_STATE 未初始化
+     */
+    esp_err_t audio_codec_record_read(void *data, size_t len, uint32_t timeout_ms);
+
+    /**
+     * @brief 切换输出延迟档位
+     * @details DMA缓冲区大小只能在创建通道时设置, 切换时只删除并重建I2S通道(几毫秒), ES8311/ES7210设备、
+     *          功放和音量/静音/录音增益保持不变, 期间的录音读取阻塞等待。混音器有流在输出时拒绝切换,
+     *          应在两段播放之间调用。初始化之前调用只记录档位, audio_codec_init()按该档位创建通道。
+     *
+     * @param profile 目标档位
+     * @return esp_err_t ESP_OK 成功, ESP_ERR_INVALID_ARG 档位无效, ESP_ERR_INVALID_STATE 正在播放,
+     *         其他为重建通道失败(已尝试恢复原档位)
+     */
+    esp_err_t audio_codec_set_latency_profile(audio_codec_latency_profile_t profile);
+
+    /**
+     * @brief 获取当前输出延迟档位
+     */
+    audio_codec_latency_profile_t audio_codec_get_latency_profile(void);
+
+    /**
+     * @brief 获取当前档位的配置和实测延迟、中断频率
+     *
+     * @param stats 输出
+     * @return esp_err_t ESP_OK 成功
+     */
+    esp_err_t audio_codec_get_latency_stats(audio_codec_latency_stats_t *stats);
+
+    /**
+     * @brief 获取指定档位的配置和实测统计
+     * @note 每个档位的统计在使用该档位期间分别累计, 切换档位不清零; 中断频率按该档位的累计使用时长计算
+     *
+     * @param profile 档位
+     * @param stats 输出
+     * @return esp_err_t ESP_OK 成功, ESP_ERR_INVALID_ARG 参数无效
+     */
+    esp_err_t audio_codec_get_profile_latency_stats(audio_codec_latency_profile_t profile, audio_codec_latency_stats_t *stats);
+
+    /**
+     * @brief 混音器每个块报告是否有流在输出 (由audio_mixer调用)
+     * @note 为true时audio_codec_set_latency_profile()返回ESP_ERR_INVALID_STATE
+     *
+     * @param active 本块是否有流或音效输出
+     */
+    void audio_codec_playback_set_active(bool active);
+
     /**
      * @brief 设置播放音量
+     * @note 不产生I2C传输: 立即改变软件增益, 模拟音量跨档时延迟合并写入codec
      *
      * @param volume 音量值 (0-100)
      * @return esp_err_t ESP_OK 成功，其他失败
@@ -68,6 +179,27 @@ extern "C"
      */
     esp_err_t audio_codec_get_volume(int *volume);
 
+    /**
+     * @brief 获取当前软件增益
+     *
+     * @return int16_t Q15增益 (AUDIO_CODEC_SOFT_GAIN_UNITY为不衰减)
+     */
+    int16_t audio_codec_get_soft_gain_q15(void);
+
+    /**
+     * @brief 写入下一块之前调用(混音器): 模拟音量需要跨档时, 在这一块的开头切换
+     * @details 调用者从这一块起按new_gain_q15输出, 这一块开始播放时(DMA缓冲区边界)codec写入新的模拟音量,
+     *          软件增益和模拟音量在同一位置生效, 输出电平连续. new_gain_q15 = gain_q15 x 旧档位/新档位,
+     *          之后audio_codec_get_soft_gain_q15按新档位返回目标. 调用过一次后, 跨档只经由这个函数进行。
+     *          以下情况本块不切换, 返回false, 下一块再试:
+     *          - 调低一档时换算后的增益会超过单位增益 (调用者的增益还在向目标渐变)
+     *          - 写入位置不在DMA缓冲区边界, 且DMA队列中还有数据
+     * @param gain_q15 调用者当前的软件增益 (上一块结束时)
+     * @param new_gain_q15 输出: 这一块起使用的增益, 不切换时等于gain_q15
+     * @return bool true: 本块切换
+     */
+    bool audio_codec_playback_volume_switch(int16_t gain_q15, int16_t *new_gain_q15);
+
     /**
      * @brief 静音控制
      *
@@ -0,0 +1,160 @@
+/**
+ * @file audio_dsp_adpcm.c
+ * @brief IMA-ADPCM编解码实现
+ * @details 使用标准的IMA步长表和索引调整表, 纯整数运算, 每个采样约十几条指令
+ */
+
+#include "audio_dsp_adpcm.h"
+#include "audio_dsp.h"
+
+static const int16_t s_step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+static const int8_t s_index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8};
+
+/**
+ * @brief 编码一个采样, 同时按解码器的方式更新预测值, 保证编解码两端一致
+ */
+static uint8_t encode_sample(audio_dsp_adpcm_state_t *st, int32_t sample)
+{
+    int32_t step = s_step_table[st->step_index];
+    int32_t diff = sample - st->predictor;
+    uint8_t code = 0;
+
+    if (diff < 0)
+    {
+        code = 8;
+        diff = -diff;
+    }
+
+    // 逐位逼近, 重建差值与解码器完全相同
+    int32_t delta = step >> 3;
+    if (diff >= step)
+    {
+        code |= 4;
+        diff -= step;
+        delta += step;
+    }
+    step >>= 1;
+    if (diff >= step)
+    {
+        code |= 2;
+        diff -= step;
+        delta += step;
+    }
+    step >>= 1;
+    if (diff >= step)
+    {
+        code |= 1;
+        delta += step;
+    }
+
+    st->predictor = audio_dsp_sat16((code & 8) ? st->predictor - delta : st->predictor + delta);
+    st->step_index += s_index_table[code];
+    st->step_index = st->step_index < 0 ? 0 : (st->step_index > 88 ? 88 : st->step_index);
+    return code;
+}
+
+void audio_dsp_adpcm_encode_block(audio_dsp_adpcm_state_t *state, const int16_t *pcm,
+                                  uint8_t *out, size_t block_bytes)
+{
+    // 块头: 首个采样原样保存, 作为本块的初始预测值
+    state->predictor = pcm[0];
+    out[0] = (uint8_t)(pcm[0] & 0xff);
+    out[1] = (uint8_t)((pcm[0] >> 8) & 0xff);
+    out[2] = (uint8_t)state->step_index;
+    out[3] = 0;
+
+    const int16_t *p = pcm + 1;
+    for (size_t i = 4; i < block_bytes; i++)
+    {
+        uint8_t lo = encode_sample(state, *p++);
+        uint8_t hi = encode_sample(state, *p++);
+        out[i] = (uint8_t)(lo | (hi << 4));
+    }
+}
+
+/**
+ * @brief 解码一个采样
+ */
+static int16_t decode_sample(audio_dsp_adpcm_state_t *st, uint8_t code)
+{
+    int32_t step = s_step_table[st->step_index];
+    int32_t delta = step >> 3;
+    if (code & 4)
+    {
+        delta += step;
+    }
+    if (code & 2)
+    {
+        delta += step >> 1;
+    }
+    if (code & 1)
+    {
+        delta += step >> 2;
+    }
+
+    st->predictor = audio_dsp_sat16((code & 8) ? st->predictor - delta : st->predictor + delta);
+    st->step_index += s_index_table[code];
+    st->step_index = st->step_index < 0 ? 0 : (st->step_index > 88 ? 88 : st->step_index);
+    return (int16_t)st->predictor;
+}
+
+size_t audio_dsp_adpcm_decode_block(const uint8_t *in, size_t block_bytes, int channels, int16_t *pcm)
+{
+    audio_dsp_adpcm_state_t st[2];
+    size_t header = 4 * (size_t)channels;
+    if (channels < 1 || channels > 2 || block_bytes < header)
+    {
+        return 0;
+    }
+
+    for (int ch = 0; ch < channels; ch++)
+    {
+        const uint8_t *h = in + 4 * ch;
+        st[ch].predictor = (int16_t)(h[0] | (h[1] << 8));
+        st[ch].step_index = h[2] > 88 ? 88 : h[2];
+        pcm[ch] = (int16_t)st[ch].predictor;
+    }
+
+    const uint8_t *p = in + header;
+    size_t frames;
+    if (channels == 1)
+    {
+        frames = (block_bytes - header) * 2;
+        for (size_t i = 0; i < frames; i += 2)
+        {
+            pcm[1 + i] = decode_sample(&st[0], *p & 0x0f);
+            pcm[2 + i] = decode_sample(&st[0], *p >> 4);
+            p++;
+        }
+    }
+    else
+    {
+        // 每组8字节: 左声道8个采样, 右声道8个采样
+        size_t groups = (block_bytes - header) / 8;
+        frames = groups * 8;
+        int16_t *out = pcm + 2;
+        for (size_t g = 0; g < groups; g++)
+        {
+            for (int ch = 0; ch < 2; ch++)
+            {
+                for (int i = 0; i < 4; i++)
+                {
+                    out[(2 * i) * 2 + ch] = decode_sample(&st[ch], p[i] & 0x0f);
+                    out[(2 * i + 1) * 2 + ch] = decode_sample(&st[ch], p[i] >> 4);
+                }
+                p += 4;
+            }
+            out += 16;
+        }
+    }
+    return frames + 1;
+}
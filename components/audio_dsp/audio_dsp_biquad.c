@@ -0,0 +1,235 @@
+/**
+ * @file audio_dsp_biquad.c
+ * @brief 定点二阶IIR级联滤波器实现
+ * @details IIR的每个输出依赖上一个输出, 无法像混音那样按8路SIMD展开;
+ *          内层循环为32x32→64位乘累加, 在ESP32-S3上编译为mull/mulsh指令对。
+ *          48kHz立体声一个240帧的块, 每级约需 480 * 5 次乘累加。
+ */
+
+#include "audio_dsp_biquad.h"
+#include "audio_dsp.h"
+#include <math.h>
+#include <string.h>
+
+#define COEF_ONE ((double)(1 << AUDIO_DSP_BIQUAD_COEF_SHIFT))
+#define COEF_MAX (7.99)    // Q28可表示的最大系数
+#define FRAC_MASK (((int64_t)1 << AUDIO_DSP_BIQUAD_COEF_SHIFT) - 1)
+
+static bool coef_to_fixed(double v, int32_t *out)
+{
+    if (v > COEF_MAX || v < -COEF_MAX)
+    {
+        return false;
+    }
+    *out = (int32_t)lrint(v * COEF_ONE);
+    return true;
+}
+
+bool audio_dsp_biquad_design(const audio_dsp_biquad_param_t *param, uint32_t sample_rate,
+                             audio_dsp_biquad_coef_t *coef)
+{
+    if (param == NULL || coef == NULL || sample_rate == 0 ||
+        param->freq_hz <= 0.0f || param->freq_hz >= sample_rate / 2.0f || param->q <= 0.0f)
+    {
+        return false;
+    }
+
+    const double w0 = 2.0 * M_PI * param->freq_hz / sample_rate;
+    const double cs = cos(w0);
+    const double alpha = sin(w0) / (2.0 * param->q);
+    const double A = pow(10.0, param->gain_db / 40.0);
+    const double sqA2a = 2.0 * sqrt(A) * alpha;
+    double b0, b1, b2, a0, a1, a2;
+
+    switch (param->type)
+    {
+    case AUDIO_DSP_BIQUAD_PEAK:
+        b0 = 1.0 + alpha * A;
+        b1 = -2.0 * cs;
+        b2 = 1.0 - alpha * A;
+        a0 = 1.0 + alpha / A;
+        a1 = -2.0 * cs;
+        a2 = 1.0 - alpha / A;
+        break;
+    case AUDIO_DSP_BIQUAD_LOW_SHELF:
+        b0 = A * ((A + 1.0) - (A - 1.0) * cs + sqA2a);
+        b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cs);
+        b2 = A * ((A + 1.0) - (A - 1.0) * cs - sqA2a);
+        a0 = (A + 1.0) + (A - 1.0) * cs + sqA2a;
+        a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cs);
+        a2 = (A + 1.0) + (A - 1.0) * cs - sqA2a;
+        break;
+    case AUDIO_DSP_BIQUAD_HIGH_SHELF:
+        b0 = A * ((A + 1.0) + (A - 1.0) * cs + sqA2a);
+        b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cs);
+        b2 = A * ((A + 1.0) + (A - 1.0) * cs - sqA2a);
+        a0 = (A + 1.0) - (A - 1.0) * cs + sqA2a;
+        a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cs);
+        a2 = (A + 1.0) - (A - 1.0) * cs - sqA2a;
+        break;
+    case AUDIO_DSP_BIQUAD_HIGHPASS:
+        b0 = (1.0 + cs) / 2.0;
+        b1 = -(1.0 + cs);
+        b2 = (1.0 + cs) / 2.0;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cs;
+        a2 = 1.0 - alpha;
+        break;
+    case AUDIO_DSP_BIQUAD_LOWPASS:
+        b0 = (1.0 - cs) / 2.0;
+        b1 = 1.0 - cs;
+        b2 = (1.0 - cs) / 2.0;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cs;
+        a2 = 1.0 - alpha;
+        break;
+    default:
+        return false;
+    }
+
+    audio_dsp_biquad_coef_t c;
+    if (!coef_to_fixed(b0 / a0, &c.b0) || !coef_to_fixed(b1 / a0, &c.b1) || !coef_to_fixed(b2 / a0, &c.b2) ||
+        !coef_to_fixed(a1 / a0, &c.a1) || !coef_to_fixed(a2 / a0, &c.a2))
+    {
+        return false;
+    }
+    *coef = c;
+    return true;
+}
+
+void audio_dsp_biquad_chain_init(audio_dsp_biquad_chain_t *chain, const audio_dsp_biquad_coef_t *coef, int stages)
+{
+    if (stages < 0)
+    {
+        stages = 0;
+    }
+    if (stages > AUDIO_DSP_BIQUAD_MAX_STAGES)
+    {
+        stages = AUDIO_DSP_BIQUAD_MAX_STAGES;
+    }
+
+    memset(chain, 0, sizeof(*chain));
+    chain->stages = stages;
+    if (stages > 0)
+    {
+        memcpy(chain->coef, coef, stages * sizeof(audio_dsp_biquad_coef_t));
+    }
+}
+
+/**
+ * @brief 一级滤波器处理一段Q8数据 (原地)
+ */
+static void biquad_run(const audio_dsp_biquad_coef_t *k, audio_dsp_biquad_state_t *state, int32_t *v, size_t n)
+{
+    // 系数和状态放在局部变量中, 循环内只访问v
+    const int32_t b0 = k->b0, b1 = k->b1, b2 = k->b2, a1 = k->a1, a2 = k->a2;
+    int32_t x1 = state->x1, x2 = state->x2, y1 = state->y1, y2 = state->y2;
+    int64_t err = state->err;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        int32_t x0 = v[i];
+        // 误差反馈: 上一次截断丢掉的小数加回累加器, 低频极点(接近z=1)时量化噪声不会被放大
+        int64_t acc = err;
+        acc += (int64_t)b0 * x0;
+        acc += (int64_t)b1 * x1;
+        acc += (int64_t)b2 * x2;
+        acc -= (int64_t)a1 * y1;
+        acc -= (int64_t)a2 * y2;
+        int32_t y0 = (int32_t)(acc >> AUDIO_DSP_BIQUAD_COEF_SHIFT);
+        err = acc & FRAC_MASK;
+
+        x2 = x1;
+        x1 = x0;
+        y2 = y1;
+        y1 = y0;
+        v[i] = y0;
+    }
+
+    state->x1 = x1;
+    state->x2 = x2;
+    state->y1 = y1;
+    state->y2 = y2;
+    state->err = (int32_t)err;
+}
+
+void audio_dsp_biquad_chain_process(audio_dsp_biquad_chain_t *chain, int16_t *buf, size_t frames, int channels)
+{
+    const int stages = chain->stages;
+    if (stages == 0 || channels <= 0 || channels > AUDIO_DSP_BIQUAD_MAX_CHANNELS)
+    {
+        return;
+    }
+
+    // 按声道、按级处理: 一级处理完一整段再进入下一级, 级间的Q8中间值保存在栈上的小缓冲区
+    int32_t work[AUDIO_DSP_BIQUAD_CHUNK_FRAMES];
+    const int round = 1 << (AUDIO_DSP_BIQUAD_STATE_SHIFT - 1);
+
+    for (size_t done = 0; done < frames; done += AUDIO_DSP_BIQUAD_CHUNK_FRAMES)
+    {
+        size_t n = frames - done;
+        if (n > AUDIO_DSP_BIQUAD_CHUNK_FRAMES)
+        {
+            n = AUDIO_DSP_BIQUAD_CHUNK_FRAMES;
+        }
+
+        for (int c = 0; c < channels; c++)
+        {
+            int16_t *p = buf + done * channels + c;
+            for (size_t i = 0; i < n; i++)
+            {
+                work[i] = (int32_t)p[i * channels] << AUDIO_DSP_BIQUAD_STATE_SHIFT;
+            }
+            for (int s = 0; s < stages; s++)
+            {
+                biquad_run(&chain->coef[s], &chain->state[s][c], work, n);
+            }
+            for (size_t i = 0; i < n; i++)
+            {
+                p[i * channels] = audio_dsp_sat16((work[i] + round) >> AUDIO_DSP_BIQUAD_STATE_SHIFT);
+            }
+        }
+    }
+}
+
+void audio_dsp_biquad_chain_swap(audio_dsp_biquad_chain_t *chain, const audio_dsp_biquad_coef_t *coef, int stages,
+                                 int16_t *buf, int16_t *scratch, size_t frames, int channels)
+{
+    if (stages > AUDIO_DSP_BIQUAD_MAX_STAGES)
+    {
+        stages = AUDIO_DSP_BIQUAD_MAX_STAGES;
+    }
+
+    // 1. 旧系数处理输入副本 (临时拷贝, 旧状态随后丢弃)
+    audio_dsp_biquad_chain_t old = *chain;
+    memcpy(scratch, buf, frames * channels * sizeof(int16_t));
+    audio_dsp_biquad_chain_process(&old, scratch, frames, channels);
+
+    // 2. 新系数从旧状态接续处理原缓冲区; 新增的级从零状态开始
+    chain->stages = stages > 0 ? stages : 0;
+    if (chain->stages > 0)
+    {
+        memcpy(chain->coef, coef, chain->stages * sizeof(audio_dsp_biquad_coef_t));
+    }
+    for (int s = old.stages; s < chain->stages; s++)
+    {
+        memset(chain->state[s], 0, sizeof(chain->state[s]));
+    }
+    audio_dsp_biquad_chain_process(chain, buf, frames, channels);
+
+    // 3. 块内从旧输出线性过渡到新输出: buf = scratch * (1 - t) + buf * t
+    if (frames == 0)
+    {
+        return;
+    }
+    for (size_t f = 0; f < frames; f++)
+    {
+        int32_t t = (int32_t)(((int64_t)f << 15) / frames);
+        for (int c = 0; c < channels; c++)
+        {
+            size_t i = f * channels + c;
+            int32_t mixed = ((int32_t)scratch[i] * (32768 - t) + (int32_t)buf[i] * t) >> 15;
+            buf[i] = audio_dsp_sat16(mixed);
+        }
+    }
+}
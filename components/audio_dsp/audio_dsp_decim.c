@@ -0,0 +1,63 @@
+/**
+ * @file audio_dsp_decim.c
+ * @brief 整数倍抽取实现
+ * @details 只在需要输出的位置计算FIR, 48kHz->16kHz时每个输出48次乘累加
+ */
+
+#include "audio_dsp_decim.h"
+#include "audio_dsp.h"
+#include <math.h>
+#include <string.h>
+
+void audio_dsp_decim_init(audio_dsp_decim_t *d, int factor)
+{
+    memset(d, 0, sizeof(*d));
+    d->factor = factor < 2 ? 2 : factor;
+    d->phase = d->factor;
+
+    // Hamming窗sinc低通, 截止频率 0.8 * (fs / 2 / factor)
+    const double fc = 0.8 * 0.5 / d->factor;
+    const int n = AUDIO_DSP_DECIM_TAPS;
+    double h[AUDIO_DSP_DECIM_TAPS];
+    double sum = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        double m = i - (n - 1) / 2.0;
+        double sinc = (m == 0.0) ? 2.0 * fc : sin(2.0 * M_PI * fc * m) / (M_PI * m);
+        h[i] = sinc * (0.54 - 0.46 * cos(2.0 * M_PI * i / (n - 1)));
+        sum += h[i];
+    }
+    // 归一化为单位直流增益
+    for (int i = 0; i < n; i++)
+    {
+        d->taps[i] = (int16_t)lrint(h[i] / sum * 32767.0);
+    }
+}
+
+size_t audio_dsp_decim_process(audio_dsp_decim_t *d, const int16_t *in, size_t samples, int16_t *out)
+{
+    size_t produced = 0;
+
+    for (size_t i = 0; i < samples; i++)
+    {
+        d->hist[d->pos] = in[i];
+        d->hist[d->pos + AUDIO_DSP_DECIM_TAPS] = in[i];
+        d->pos = (d->pos + 1) % AUDIO_DSP_DECIM_TAPS;
+
+        if (--d->phase > 0)
+        {
+            continue;
+        }
+        d->phase = d->factor;
+
+        // hist[pos .. pos+TAPS-1] 为从旧到新的连续窗口, 系数对称无需翻转
+        const int16_t *x = &d->hist[d->pos];
+        int32_t acc = 1 << 14;
+        for (int k = 0; k < AUDIO_DSP_DECIM_TAPS; k++)
+        {
+            acc += (int32_t)x[k] * d->taps[k];
+        }
+        out[produced++] = audio_dsp_sat16(acc >> 15);
+    }
+    return produced;
+}
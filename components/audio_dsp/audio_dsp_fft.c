@@ -0,0 +1,146 @@
+/**
+ * @file audio_dsp_fft.c
+ * @brief 定点基4 FFT实现 (按时间抽取)
+ * @details 先对输入做基4数字倒序, 然后log4(N)级蝶形运算。
+ *          256点只需4级, 比基2少一半的级数和复数乘法。
+ */
+
+#include "audio_dsp_fft.h"
+#include <stddef.h>
+#include <math.h>
+
+static int fft_log4(int n)
+{
+    int stages = 0;
+    while (n > 1)
+    {
+        if (n & 3)
+        {
+            return -1;
+        }
+        n >>= 2;
+        stages++;
+    }
+    return stages;
+}
+
+bool audio_dsp_fft_r4_twiddle(int16_t *twiddle, int n)
+{
+    if (twiddle == NULL || n < 4 || n > AUDIO_DSP_FFT_MAX_POINTS || fft_log4(n) < 0)
+    {
+        return false;
+    }
+
+    for (int k = 0; k < n; k++)
+    {
+        double phase = 2.0 * M_PI * k / n;
+        twiddle[2 * k] = (int16_t)lrint(cos(phase) * 32767.0);
+        twiddle[2 * k + 1] = (int16_t)lrint(-sin(phase) * 32767.0);
+    }
+    return true;
+}
+
+void audio_dsp_window_hann_q15(int16_t *window, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        window[i] = (int16_t)lrint(0.5 * (1.0 - cos(2.0 * M_PI * i / (n - 1))) * 32767.0);
+    }
+}
+
+/**
+ * @brief 基4数字倒序重排
+ */
+static void digit_reverse(int16_t *data, int n, int stages)
+{
+    for (int i = 0; i < n; i++)
+    {
+        int j = 0;
+        int v = i;
+        for (int s = 0; s < stages; s++)
+        {
+            j = (j << 2) | (v & 3);
+            v >>= 2;
+        }
+        if (j > i)
+        {
+            int16_t re = data[2 * i];
+            int16_t im = data[2 * i + 1];
+            data[2 * i] = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j] = re;
+            data[2 * j + 1] = im;
+        }
+    }
+}
+
+/**
+ * @brief Q15复数乘法 x * w
+ */
+static inline void cmul_q15(int32_t xr, int32_t xi, const int16_t *w, int32_t *out_r, int32_t *out_i)
+{
+    *out_r = (xr * w[0] - xi * w[1]) >> 15;
+    *out_i = (xr * w[1] + xi * w[0]) >> 15;
+}
+
+void audio_dsp_fft_r4_s16(int16_t *data, int n, const int16_t *twiddle)
+{
+    int stages = fft_log4(n);
+    if (data == NULL || twiddle == NULL || stages <= 0)
+    {
+        return;
+    }
+
+    digit_reverse(data, n, stages);
+
+    for (int m = 4; m <= n; m <<= 2)
+    {
+        const int q = m >> 2;        // 每组蝶形的跨度
+        const int tw_step = n / m;   // 本级旋转因子的步长
+
+        for (int k = 0; k < n; k += m)
+        {
+            for (int j = 0; j < q; j++)
+            {
+                int16_t *p0 = &data[2 * (k + j)];
+                int16_t *p1 = p0 + 2 * q;
+                int16_t *p2 = p1 + 2 * q;
+                int16_t *p3 = p2 + 2 * q;
+
+                int32_t ar = p0[0], ai = p0[1];
+                int32_t br, bi, cr, ci, dr, di;
+                if (j == 0)
+                {
+                    // 第一个蝶形的旋转因子都是1
+                    br = p1[0];
+                    bi = p1[1];
+                    cr = p2[0];
+                    ci = p2[1];
+                    dr = p3[0];
+                    di = p3[1];
+                }
+                else
+                {
+                    cmul_q15(p1[0], p1[1], &twiddle[2 * (j * tw_step)], &br, &bi);
+                    cmul_q15(p2[0], p2[1], &twiddle[2 * (2 * j * tw_step)], &cr, &ci);
+                    cmul_q15(p3[0], p3[1], &twiddle[2 * (3 * j * tw_step)], &dr, &di);
+                }
+
+                int32_t t0r = ar + cr, t0i = ai + ci;
+                int32_t t1r = ar - cr, t1i = ai - ci;
+                int32_t t2r = br + dr, t2i = bi + di;
+                int32_t t3r = br - dr, t3i = bi - di;
+
+                // X0 = t0 + t2, X1 = t1 - j·t3, X2 = t0 - t2, X3 = t1 + j·t3, 每级整体缩小4倍
+                p0[0] = (int16_t)((t0r + t2r) >> 2);
+                p0[1] = (int16_t)((t0i + t2i) >> 2);
+                p1[0] = (int16_t)((t1r + t3i) >> 2);
+                p1[1] = (int16_t)((t1i - t3r) >> 2);
+                p2[0] = (int16_t)((t0r - t2r) >> 2);
+                p2[1] = (int16_t)((t0i - t2i) >> 2);
+                p3[0] = (int16_t)((t1r - t3i) >> 2);
+                p3[1] = (int16_t)((t1i + t3r) >> 2);
+            }
+        }
+    }
+}
@@ -0,0 +1,223 @@
+/**
+ * @file audio_dsp_simd.c
+ * @brief 定点音频DSP基础运算实现
+ * @details ESP32-S3 PIE指令说明:
+ *          - ee.vld.128.ip / ee.vst.128.ip: 128位对齐加载/存储, 地址自增
+ *          - ee.vldbc.16: 加载一个int16并广播到8个通道
+ *          - ee.vmul.s16: 8路int16相乘, 结果右移SAR位后饱和
+ *          - ee.vadds.s16: 8路int16饱和加法
+ */
+
+#include "audio_dsp.h"
+#include <string.h>
+#include "sdkconfig.h"
+
+#if CONFIG_IDF_TARGET_ESP32S3
+#define AUDIO_DSP_USE_PIE 1
+#else
+#define AUDIO_DSP_USE_PIE 0
+#endif
+
+/**
+ * @brief 判断是否满足SIMD路径的对齐和长度要求
+ */
+static inline int simd_ok(const void *a, const void *b, size_t samples)
+{
+    return AUDIO_DSP_USE_PIE &&
+           (((uintptr_t)a | (uintptr_t)b) & (AUDIO_DSP_ALIGN - 1)) == 0 &&
+           (samples % AUDIO_DSP_SIMD_SAMPLES) == 0 && samples > 0;
+}
+
+#if AUDIO_DSP_USE_PIE
+
+// 写SAR(移位量寄存器)的内联汇编要声明破坏SAR: clang把SAR当作普通寄存器分配, 可能在其中保存移位量;
+// GCC的xtensa后端没有这个寄存器名(每条移位指令模式都先写SAR, 不跨指令使用), 声明会编译失败
+#if defined(__clang__)
+#define AUDIO_DSP_SAR_CLOBBER , "sar"
+#else
+#define AUDIO_DSP_SAR_CLOBBER
+#endif
+
+static void mix_add_pie(int16_t *dst, const int16_t *src, size_t samples)
+{
+    uint32_t loops = samples / AUDIO_DSP_SIMD_SAMPLES;
+    int16_t *out = dst;
+    __asm__ volatile(
+        "1:\n"
+        "ee.vld.128.ip q0, %[src], 16\n"
+        "ee.vld.128.ip q1, %[dst], 16\n"
+        "ee.vadds.s16 q1, q1, q0\n"
+        "ee.vst.128.ip q1, %[out], 16\n"
+        "addi %[n], %[n], -1\n"
+        "bnez %[n], 1b\n"
+        : [src] "+r"(src), [dst] "+r"(dst), [out] "+r"(out), [n] "+r"(loops)
+        :
+        : "memory");
+}
+
+static void mix_gain_pie(int16_t *dst, const int16_t *src, size_t samples, int16_t gain_q15)
+{
+    uint32_t loops = samples / AUDIO_DSP_SIMD_SAMPLES;
+    int16_t *out = dst;
+    const int16_t gain = gain_q15;
+    const int16_t *gain_ptr = &gain;
+    __asm__ volatile(
+        "movi a8, 15\n"
+        "wsr.sar a8\n"
+        "ee.vldbc.16 q2, %[g]\n"
+        "1:\n"
+        "ee.vld.128.ip q0, %[src], 16\n"
+        "ee.vld.128.ip q1, %[dst], 16\n"
+        "ee.vmul.s16 q0, q0, q2\n"
+        "ee.vadds.s16 q1, q1, q0\n"
+        "ee.vst.128.ip q1, %[out], 16\n"
+        "addi %[n], %[n], -1\n"
+        "bnez %[n], 1b\n"
+        : [src] "+r"(src), [dst] "+r"(dst), [out] "+r"(out), [n] "+r"(loops)
+        : [g] "r"(gain_ptr)
+        : "a8", "memory" AUDIO_DSP_SAR_CLOBBER);
+}
+
+static void scale_pie(int16_t *buf, size_t samples, int16_t gain_q15)
+{
+    uint32_t loops = samples / AUDIO_DSP_SIMD_SAMPLES;
+    int16_t *out = buf;
+    const int16_t gain = gain_q15;
+    const int16_t *gain_ptr = &gain;
+    __asm__ volatile(
+        "movi a8, 15\n"
+        "wsr.sar a8\n"
+        "ee.vldbc.16 q2, %[g]\n"
+        "1:\n"
+        "ee.vld.128.ip q0, %[in], 16\n"
+        "ee.vmul.s16 q0, q0, q2\n"
+        "ee.vst.128.ip q0, %[out], 16\n"
+        "addi %[n], %[n], -1\n"
+        "bnez %[n], 1b\n"
+        : [in] "+r"(buf), [out] "+r"(out), [n] "+r"(loops)
+        : [g] "r"(gain_ptr)
+        : "a8", "memory" AUDIO_DSP_SAR_CLOBBER);
+}
+
+#endif // AUDIO_DSP_USE_PIE
+
+void audio_dsp_mix_s16(int16_t *dst, const int16_t *src, size_t samples, int16_t gain_q15)
+{
+    if (gain_q15 <= 0)
+    {
+        return;
+    }
+
+#if AUDIO_DSP_USE_PIE
+    if (simd_ok(dst, src, samples))
+    {
+        if (gain_q15 >= AUDIO_DSP_GAIN_UNITY)
+        {
+            mix_add_pie(dst, src, samples);
+        }
+        else
+        {
+            mix_gain_pie(dst, src, samples, gain_q15);
+        }
+        return;
+    }
+#endif
+
+    if (gain_q15 >= AUDIO_DSP_GAIN_UNITY)
+    {
+        for (size_t i = 0; i < samples; i++)
+        {
+            dst[i] = audio_dsp_sat16((int32_t)dst[i] + src[i]);
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < samples; i++)
+        {
+            dst[i] = audio_dsp_sat16((int32_t)dst[i] + (((int32_t)src[i] * gain_q15) >> 15));
+        }
+    }
+}
+
+void audio_dsp_mix_ramp_s16(int16_t *dst, const int16_t *src, size_t frames, int channels,
+                            int16_t gain_start_q15, int16_t gain_end_q15)
+{
+    if (frames == 0)
+    {
+        return;
+    }
+
+    // 增益用Q16小数累加, 每帧步进一次, 同一帧的各声道使用相同增益
+    int32_t gain = (int32_t)gain_start_q15 * 65536;
+    // 负数左移是未定义行为, 用乘法; 差值乘65536可能超出int32, 按64位计算
+    int32_t step = (int32_t)(((int64_t)gain_end_q15 - gain_start_q15) * 65536 / (int64_t)frames);
+
+    for (size_t f = 0; f < frames; f++)
+    {
+        int32_t g = gain >> 16;
+        for (int c = 0; c < channels; c++)
+        {
+            size_t i = f * channels + c;
+            dst[i] = audio_dsp_sat16((int32_t)dst[i] + (((int32_t)src[i] * g) >> 15));
+        }
+        gain += step;
+    }
+}
+
+void audio_dsp_scale_s16(int16_t *buf, size_t samples, int16_t gain_q15)
+{
+    if (gain_q15 >= AUDIO_DSP_GAIN_UNITY)
+    {
+        return;
+    }
+    if (gain_q15 <= 0)
+    {
+        memset(buf, 0, samples * sizeof(int16_t));
+        return;
+    }
+
+#if AUDIO_DSP_USE_PIE
+    if (simd_ok(buf, buf, samples))
+    {
+        scale_pie(buf, samples, gain_q15);
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < samples; i++)
+    {
+        buf[i] = (int16_t)(((int32_t)buf[i] * gain_q15) >> 15);
+    }
+}
+
+void audio_dsp_scale_ramp_s16(int16_t *buf, size_t frames, int channels,
+                              int16_t gain_start_q15, int16_t gain_end_q15)
+{
+    if (frames == 0)
+    {
+        return;
+    }
+
+    int32_t gain = (int32_t)gain_start_q15 * 65536;
+    int32_t step = (int32_t)(((int64_t)gain_end_q15 - gain_start_q15) * 65536 / (int64_t)frames);
+
+    for (size_t f = 0; f < frames; f++)
+    {
+        int32_t g = gain >> 16;
+        for (int c = 0; c < channels; c++)
+        {
+            size_t i = f * channels + c;
+            buf[i] = (int16_t)(((int32_t)buf[i] * g) >> 15);
+        }
+        gain += step;
+    }
+}
+
+void audio_dsp_downmix_s16(int16_t *dst, const int16_t *src, size_t frames)
+{
+    // 按帧顺序处理, dst与src相同时写入位置总不超过读取位置
+    for (size_t i = 0; i < frames; i++)
+    {
+        dst[i] = (int16_t)(((int32_t)src[2 * i] + src[2 * i + 1]) >> 1);
+    }
+}
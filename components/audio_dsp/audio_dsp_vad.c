@@ -0,0 +1,90 @@
+/**
+ * @file audio_dsp_vad.c
+ * @brief 语音活动检测实现
+ * @details 16kHz单声道每块约340个采样, 每个采样一次乘累加和一次符号比较,
+ *          在240MHz下每块只需几微秒。
+ */
+
+#include "audio_dsp_vad.h"
+#include <string.h>
+
+void audio_dsp_vad_init(audio_dsp_vad_t *vad, uint32_t sample_rate, uint32_t hangover_ms)
+{
+    memset(vad, 0, sizeof(*vad));
+    vad->sample_rate = sample_rate;
+    vad->hangover_samples = sample_rate / 1000 * hangover_ms;
+    vad->noise_floor = AUDIO_DSP_VAD_MIN_NOISE;
+}
+
+/**
+ * @brief 更新噪声底: 下降快(跟随安静环境), 上升慢(不被语音抬高)
+ */
+static void vad_update_noise(audio_dsp_vad_t *vad, bool speech)
+{
+    uint32_t e = vad->energy;
+    uint32_t n = vad->noise_floor;
+
+    if (e < n)
+    {
+        n -= (n - e) >> 2;
+    }
+    else
+    {
+        // 语音期间几乎不上升(约40秒时间常数), 新出现的稳定噪声仍会在几秒后被吸收
+        n += (e - n) >> (speech ? 11 : 5);
+    }
+    vad->noise_floor = n < AUDIO_DSP_VAD_MIN_NOISE ? AUDIO_DSP_VAD_MIN_NOISE : n;
+}
+
+bool audio_dsp_vad_process(audio_dsp_vad_t *vad, const int16_t *pcm, size_t frames, int channels)
+{
+    if (frames == 0)
+    {
+        return vad->active;
+    }
+
+    // 1. 均方能量和过零次数
+    uint64_t sum = 0;
+    uint32_t crossings = 0;
+    int32_t prev = 0;
+    for (size_t i = 0; i < frames; i++)
+    {
+        int32_t s = pcm[i * channels];
+        if (channels == 2)
+        {
+            s = (s + pcm[i * 2 + 1]) >> 1;
+        }
+        sum += (uint64_t)(s * s);
+        crossings += (uint32_t)((s ^ prev) < 0);
+        prev = s;
+    }
+    vad->energy = (uint32_t)(sum / frames);
+    vad->zc_hz = (uint32_t)((uint64_t)crossings * vad->sample_rate / (2 * frames));
+
+    // 2. 原始判决
+    uint64_t noise = vad->noise_floor;
+    bool speech = false;
+    if (vad->energy >= AUDIO_DSP_VAD_MIN_ENERGY)
+    {
+        speech = vad->energy > noise * AUDIO_DSP_VAD_VOICED_RATIO ||
+                 (vad->energy > noise * AUDIO_DSP_VAD_UNVOICED_RATIO && vad->zc_hz >= AUDIO_DSP_VAD_UNVOICED_ZC_HZ);
+    }
+    vad_update_noise(vad, speech);
+
+    // 3. 拖尾
+    if (speech)
+    {
+        vad->hangover_left = vad->hangover_samples;
+        vad->active = true;
+    }
+    else if (vad->hangover_left > frames)
+    {
+        vad->hangover_left -= frames;
+    }
+    else
+    {
+        vad->hangover_left = 0;
+        vad->active = false;
+    }
+    return vad->active;
+}
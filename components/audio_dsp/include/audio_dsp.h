@@ -0,0 +1,75 @@
+/**
+ * @file audio_dsp.h
+ * @brief 定点音频DSP基础运算
+ * @details ESP32-S3上使用PIE 128位SIMD指令(一次处理8个int16), 其他平台使用等价的C实现
+ */
+
+#ifndef AUDIO_DSP_H
+#define AUDIO_DSP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define AUDIO_DSP_ALIGN (16)           // SIMD缓冲区对齐要求(字节)
+#define AUDIO_DSP_GAIN_UNITY (32767)   // Q15格式的单位增益
+#define AUDIO_DSP_SIMD_SAMPLES (8)     // 一条SIMD指令处理的int16数量
+
+    /**
+     * @brief 饱和限幅到int16
+     */
+    static inline int16_t audio_dsp_sat16(int32_t v)
+    {
+        return (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+    }
+
+    /**
+     * @brief 固定增益混音: dst = sat(dst + src * gain)
+     * @note dst/src按AUDIO_DSP_ALIGN对齐且samples为8的倍数时走SIMD路径
+     * @param dst 累加目标
+     * @param src 输入
+     * @param samples int16采样数(立体声为帧数*2)
+     * @param gain_q15 Q15增益, AUDIO_DSP_GAIN_UNITY时只做饱和相加
+     */
+    void audio_dsp_mix_s16(int16_t *dst, const int16_t *src, size_t samples, int16_t gain_q15);
+
+    /**
+     * @brief 增益线性渐变混音, 逐帧平滑, 用于避免增益跳变产生的"拉链"噪声
+     * @param dst 累加目标
+     * @param src 输入 (交织格式)
+     * @param frames 帧数
+     * @param channels 声道数
+     * @param gain_start_q15 第一帧的增益
+     * @param gain_end_q15 最后一帧之后的增益
+     */
+    void audio_dsp_mix_ramp_s16(int16_t *dst, const int16_t *src, size_t frames, int channels,
+                                int16_t gain_start_q15, int16_t gain_end_q15);
+
+    /**
+     * @brief 原地固定增益: buf = sat(buf * gain)
+     */
+    void audio_dsp_scale_s16(int16_t *buf, size_t samples, int16_t gain_q15);
+
+    /**
+     * @brief 原地增益线性渐变
+     */
+    void audio_dsp_scale_ramp_s16(int16_t *buf, size_t frames, int channels,
+                                  int16_t gain_start_q15, int16_t gain_end_q15);
+
+    /**
+     * @brief 立体声下混为单声道: dst[i] = (L + R) / 2
+     * @param dst 输出, 可与src相同
+     * @param src 交织立体声输入
+     * @param frames 帧数
+     */
+    void audio_dsp_downmix_s16(int16_t *dst, const int16_t *src, size_t frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_DSP_H
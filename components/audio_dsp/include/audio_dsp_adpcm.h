@@ -0,0 +1,58 @@
+/**
+ * @file audio_dsp_adpcm.h
+ * @brief IMA-ADPCM编解码 (WAV格式0x11)
+ * @details 每块以每声道4字节的块头开始(首个采样int16 + 步长索引 + 保留字节), 其后每个采样4位,
+ *          低半字节在前。块头中的首个采样不参与编码, 单声道块大小为block_bytes时每块采样数为
+ *          (block_bytes - 4) * 2 + 1。立体声块在块头之后按4字节(每声道8个采样)交替存放两个声道。
+ */
+
+#ifndef AUDIO_DSP_ADPCM_H
+#define AUDIO_DSP_ADPCM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define AUDIO_DSP_ADPCM_BLOCK_BYTES (512) // 默认块大小 (单声道)
+#define AUDIO_DSP_ADPCM_SAMPLES_PER_BLOCK(block_bytes) (((block_bytes) - 4) * 2 + 1)
+#define AUDIO_DSP_ADPCM_FRAMES_PER_BLOCK(block_bytes, channels) \
+    (((block_bytes) - 4 * (channels)) * 2 / (channels) + 1) // 多声道块的每声道采样数
+
+    /**
+     * @brief 编码器状态 (跨块保持, 使相邻块的步长连续)
+     */
+    typedef struct
+    {
+        int32_t predictor;  // 上一个重建采样
+        int32_t step_index; // 步长表索引 0-88
+    } audio_dsp_adpcm_state_t;
+
+    /**
+     * @brief 编码一个单声道块
+     * @param state 编码器状态, 首次使用前清零
+     * @param pcm 输入采样, 数量为AUDIO_DSP_ADPCM_SAMPLES_PER_BLOCK(block_bytes)
+     * @param out 输出块
+     * @param block_bytes 块大小 (4 + 偶数个采样的字节数)
+     */
+    void audio_dsp_adpcm_encode_block(audio_dsp_adpcm_state_t *state, const int16_t *pcm,
+                                      uint8_t *out, size_t block_bytes);
+
+    /**
+     * @brief 解码一个块 (可以是文件末尾不完整的块)
+     * @param in 输入块
+     * @param block_bytes 块大小
+     * @param channels 声道数 (1或2)
+     * @param pcm 输出交织采样, 容量AUDIO_DSP_ADPCM_FRAMES_PER_BLOCK(block_bytes, channels)帧
+     * @return 输出帧数, 块头不完整时为0
+     */
+    size_t audio_dsp_adpcm_decode_block(const uint8_t *in, size_t block_bytes, int channels, int16_t *pcm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_DSP_ADPCM_H
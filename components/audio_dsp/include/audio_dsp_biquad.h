@@ -0,0 +1,125 @@
+/**
+ * @file audio_dsp_biquad.h
+ * @brief 定点二阶IIR(biquad)级联滤波器
+ * @details 系数按RBJ Audio EQ Cookbook设计(浮点, 仅在配置时计算), 运行时为Q28系数、
+ *          带8位小数的32位中间值和64位累加的直接I型结构(带一阶误差反馈), 级间不限幅, 输出时饱和到int16。
+ *          更换系数时对新旧两组滤波器的输出在一个块内交叉淡化, 避免切换瞬间的爆音。
+ */
+
+#ifndef AUDIO_DSP_BIQUAD_H
+#define AUDIO_DSP_BIQUAD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define AUDIO_DSP_BIQUAD_MAX_STAGES (10) // 级联的最大滤波器数量
+#define AUDIO_DSP_BIQUAD_MAX_CHANNELS (2)
+#define AUDIO_DSP_BIQUAD_COEF_SHIFT (28) // 系数定点格式Q28, 可表示±8
+#define AUDIO_DSP_BIQUAD_STATE_SHIFT (8) // 中间值比int16多出的小数位
+#define AUDIO_DSP_BIQUAD_CHUNK_FRAMES (64) // 级间中间值缓冲区的帧数(栈上256字节)
+
+    /**
+     * @brief 滤波器类型
+     */
+    typedef enum
+    {
+        AUDIO_DSP_BIQUAD_PEAK = 0,   // 峰值/陷波 (参数EQ频段)
+        AUDIO_DSP_BIQUAD_LOW_SHELF,  // 低架
+        AUDIO_DSP_BIQUAD_HIGH_SHELF, // 高架
+        AUDIO_DSP_BIQUAD_HIGHPASS,   // 二阶高通
+        AUDIO_DSP_BIQUAD_LOWPASS,    // 二阶低通
+    } audio_dsp_biquad_type_t;
+
+    /**
+     * @brief 滤波器设计参数
+     */
+    typedef struct
+    {
+        audio_dsp_biquad_type_t type;
+        float freq_hz; // 中心/转折频率
+        float gain_db; // 增益(峰值和架式滤波器有效)
+        float q;       // 品质因数, 架式滤波器0.707为最陡且无过冲
+    } audio_dsp_biquad_param_t;
+
+    /**
+     * @brief Q28系数 (已除以a0, a1/a2按差分方程中的减号取原值)
+     */
+    typedef struct
+    {
+        int32_t b0, b1, b2;
+        int32_t a1, a2;
+    } audio_dsp_biquad_coef_t;
+
+    /**
+     * @brief 单级单声道的历史状态 (Q8)
+     */
+    typedef struct
+    {
+        int32_t x1, x2;
+        int32_t y1, y2;
+        int32_t err; // 上一次输出截断的余数 (误差反馈)
+    } audio_dsp_biquad_state_t;
+
+    /**
+     * @brief 级联滤波器
+     */
+    typedef struct
+    {
+        int stages;
+        audio_dsp_biquad_coef_t coef[AUDIO_DSP_BIQUAD_MAX_STAGES];
+        audio_dsp_biquad_state_t state[AUDIO_DSP_BIQUAD_MAX_STAGES][AUDIO_DSP_BIQUAD_MAX_CHANNELS];
+    } audio_dsp_biquad_chain_t;
+
+    /**
+     * @brief 按RBJ公式设计一级滤波器
+     * @param param 设计参数
+     * @param sample_rate 采样率
+     * @param coef 输出Q28系数
+     * @return true 成功, false 参数超出范围(频率不在(0, fs/2)内或系数溢出)
+     */
+    bool audio_dsp_biquad_design(const audio_dsp_biquad_param_t *param, uint32_t sample_rate,
+                                 audio_dsp_biquad_coef_t *coef);
+
+    /**
+     * @brief 初始化级联滤波器并清空状态
+     * @param chain 滤波器
+     * @param coef 各级系数, stages为0时可为NULL (直通)
+     * @param stages 级数
+     */
+    void audio_dsp_biquad_chain_init(audio_dsp_biquad_chain_t *chain, const audio_dsp_biquad_coef_t *coef, int stages);
+
+    /**
+     * @brief 原地处理交织的int16块
+     * @param chain 滤波器
+     * @param buf 输入输出
+     * @param frames 帧数
+     * @param channels 声道数 (不超过AUDIO_DSP_BIQUAD_MAX_CHANNELS)
+     */
+    void audio_dsp_biquad_chain_process(audio_dsp_biquad_chain_t *chain, int16_t *buf, size_t frames, int channels);
+
+    /**
+     * @brief 处理一个块的同时切换到新系数
+     * @details 旧系数处理输入的副本, 新系数从旧状态接续处理原缓冲区, 然后逐帧从旧输出
+     *          线性过渡到新输出。结束后chain使用新系数, 状态与新系数连续。
+     * @param chain 滤波器
+     * @param coef 新系数
+     * @param stages 新级数
+     * @param buf 输入输出
+     * @param scratch 与buf等长的临时缓冲区
+     * @param frames 帧数
+     * @param channels 声道数
+     */
+    void audio_dsp_biquad_chain_swap(audio_dsp_biquad_chain_t *chain, const audio_dsp_biquad_coef_t *coef, int stages,
+                                     int16_t *buf, int16_t *scratch, size_t frames, int channels);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_DSP_BIQUAD_H
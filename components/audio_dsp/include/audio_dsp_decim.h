@@ -0,0 +1,52 @@
+/**
+ * @file audio_dsp_decim.h
+ * @brief 整数倍抽取 (抗混叠FIR + 降采样), 单声道流式处理
+ */
+
+#ifndef AUDIO_DSP_DECIM_H
+#define AUDIO_DSP_DECIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define AUDIO_DSP_DECIM_TAPS (48) // FIR阶数 (Hamming窗sinc)
+
+    /**
+     * @brief 抽取器状态
+     */
+    typedef struct
+    {
+        int factor;                             // 抽取倍数
+        int phase;                              // 距离下一个输出还需的输入数
+        int pos;                                // 延迟线写入位置
+        int16_t taps[AUDIO_DSP_DECIM_TAPS];     // Q15系数
+        int16_t hist[2 * AUDIO_DSP_DECIM_TAPS]; // 双倍长度延迟线, 任意位置开始都是连续窗口
+    } audio_dsp_decim_t;
+
+    /**
+     * @brief 初始化抽取器, 截止频率取输出奈奎斯特频率的80%
+     * @param d 抽取器
+     * @param factor 抽取倍数 (>=2)
+     */
+    void audio_dsp_decim_init(audio_dsp_decim_t *d, int factor);
+
+    /**
+     * @brief 处理一段输入, 跨调用保持状态
+     * @param d 抽取器
+     * @param in 输入
+     * @param samples 输入采样数
+     * @param out 输出, 容量至少 samples / factor + 1
+     * @return 输出采样数
+     */
+    size_t audio_dsp_decim_process(audio_dsp_decim_t *d, const int16_t *in, size_t samples, int16_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_DSP_DECIM_H
@@ -0,0 +1,48 @@
+/**
+ * @file audio_dsp_fft.h
+ * @brief 定点基4 FFT
+ * @details 复数以交织的int16(实部, 虚部)存放, 旋转因子为Q15。
+ *          每一级蝶形运算后右移2位防止溢出, 输出等于真实DFT结果除以N。
+ */
+
+#ifndef AUDIO_DSP_FFT_H
+#define AUDIO_DSP_FFT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define AUDIO_DSP_FFT_MAX_POINTS (1024) // 支持的最大点数 (4的幂)
+
+    /**
+     * @brief 生成旋转因子表 W^k = cos(2πk/N) - j·sin(2πk/N), k = 0..N-1
+     * @param twiddle 输出, 长度2*N个int16 (交织的cos, -sin)
+     * @param n 点数
+     * @return true 成功, false n不是4的幂或超出范围
+     */
+    bool audio_dsp_fft_r4_twiddle(int16_t *twiddle, int n);
+
+    /**
+     * @brief 生成Q15汉宁窗
+     * @param window 输出, 长度n
+     * @param n 点数
+     */
+    void audio_dsp_window_hann_q15(int16_t *window, int n);
+
+    /**
+     * @brief 原地基4 FFT (输入自然顺序, 输出自然顺序)
+     * @param data 交织复数, 长度2*n个int16
+     * @param n 点数 (4的幂)
+     * @param twiddle audio_dsp_fft_r4_twiddle生成的表
+     */
+    void audio_dsp_fft_r4_s16(int16_t *data, int n, const int16_t *twiddle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_DSP_FFT_H
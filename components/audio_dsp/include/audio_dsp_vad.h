@@ -0,0 +1,63 @@
+/**
+ * @file audio_dsp_vad.h
+ * @brief 轻量语音活动检测 (短时能量 + 过零率, 带拖尾)
+ * @details 每次处理一块(10-30ms)采样, 只用整数累加:
+ *          能量明显高于自适应噪声底 -> 浊音; 能量略高且过零频率落在摩擦音范围 -> 清音;
+ *          判为语音后保持hangover时长, 避免切掉词尾和句间短停顿。
+ */
+
+#ifndef AUDIO_DSP_VAD_H
+#define AUDIO_DSP_VAD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define AUDIO_DSP_VAD_VOICED_RATIO (8)       // 浊音: 能量高于噪声底8倍 (+9dB)
+#define AUDIO_DSP_VAD_UNVOICED_RATIO (3)     // 清音: 能量高于噪声底3倍 (+5dB) 且过零频率够高
+#define AUDIO_DSP_VAD_UNVOICED_ZC_HZ (2000)  // 清音的最低过零频率
+#define AUDIO_DSP_VAD_MIN_ENERGY (64 * 64)   // 绝对能量下限 (约-54dBFS), 低于此一律为静音
+#define AUDIO_DSP_VAD_MIN_NOISE (16)         // 噪声底下限, 防止数字静音后阈值过低
+
+    /**
+     * @brief VAD状态
+     */
+    typedef struct
+    {
+        uint32_t sample_rate;
+        uint32_t hangover_samples; // 语音结束后保持的采样数
+        uint32_t hangover_left;
+        uint32_t noise_floor;      // 自适应噪声底 (均方能量), 从下限开始向上适应, 开头宁可多录
+        uint32_t energy;           // 最近一块的均方能量
+        uint32_t zc_hz;            // 最近一块的过零频率
+        bool active;               // 当前判决 (含拖尾)
+    } audio_dsp_vad_t;
+
+    /**
+     * @brief 初始化VAD
+     * @param vad 状态
+     * @param sample_rate 采样率
+     * @param hangover_ms 拖尾时长
+     */
+    void audio_dsp_vad_init(audio_dsp_vad_t *vad, uint32_t sample_rate, uint32_t hangover_ms);
+
+    /**
+     * @brief 处理一块采样并给出判决
+     * @param vad 状态
+     * @param pcm 交织采样, 多声道时取平均
+     * @param frames 帧数
+     * @param channels 声道数
+     * @return true 语音 (含拖尾), false 静音
+     */
+    bool audio_dsp_vad_process(audio_dsp_vad_t *vad, const int16_t *pcm, size_t frames, int channels);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_DSP_VAD_H
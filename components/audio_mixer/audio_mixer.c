@@ -0,0 +1,1003 @@
+/**
+ * @file audio_mixer.c
+ * @brief 多路音频混音器实现
+ * @details 混音任务每次处理AUDIO_MIXER_BLOCK_FRAMES帧:
+ *          1. 从音乐/语音环形缓冲区取一个块, 按流增益(可渐变)累加到输出块
+ *          2. 累加所有正在播放的音效
+ *          3. 输出EQ (biquad级联), 配置变化时在一个块内交叉淡化到新系数
+ *          4. 调用输出监听回调(频谱分析等), 然后按主音量(audio_codec的软件增益)缩放, 增益变化时逐帧平滑
+ *          5. 直接写入I2S (DMA缓冲区是混音块的整数倍, 写入不跨缓冲区拼接), 阻塞等待DMA空间, 由此按实时速度运行
+ *          环形缓冲区按AUDIO_DSP_ALIGN对齐, 连续的整块直接从环形缓冲区内存混音, 不拷贝到临时缓冲区。
+ *          所有流都没有数据时任务休眠, 由写入/触发音效唤醒
+ */
+
+#include "audio_mixer.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <math.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/ringbuf.h"
+#include "audio_codec.h"
+#include "audio_dsp.h"
+
+static const char *TAG = "audio_mixer";
+
+#define MIXER_CHANNELS (AUDIO_DEFAULT_CHANNELS)
+#define MIXER_FRAME_BYTES (MIXER_CHANNELS * sizeof(int16_t))
+#define MIXER_BLOCK_SAMPLES (AUDIO_MIXER_BLOCK_FRAMES * MIXER_CHANNELS)
+#define MIXER_BLOCK_BYTES (AUDIO_MIXER_BLOCK_FRAMES * MIXER_FRAME_BYTES)
+#define MIXER_IDLE_WAIT_MS (20) // 无数据时的休眠时间
+#define MIXER_WRITE_TIMEOUT_MS (100)
+
+#if AUDIO_MIXER_BLOCK_FRAMES != AUDIO_CODEC_DMA_FRAMES
+#error "混音块大小必须等于I2S DMA缓冲区帧数的基本单位"
+#endif
+// 主音量每块允许的最大变化量: 满刻度变化在AUDIO_MIXER_MASTER_RAMP_MS内完成
+#define MIXER_MASTER_MAX_STEP (AUDIO_DSP_GAIN_UNITY * AUDIO_MIXER_BLOCK_FRAMES / (AUDIO_MIXER_MASTER_RAMP_MS * AUDIO_DEFAULT_SAMPLE_RATE / 1000))
+
+// 单路流状态
+typedef struct
+{
+    RingbufHandle_t ring;  // 音乐/语音的数据缓冲区, 音效流为NULL
+    StaticRingbuffer_t *ring_struct;
+    uint8_t *ring_storage; // 环形缓冲区存储 (AUDIO_DSP_ALIGN对齐)
+    volatile bool held;    // 混音任务正持有环形缓冲区中的一块 (零拷贝混音)
+    int16_t gain_cur;      // 当前增益(Q15)
+    int16_t gain_target;   // 目标增益(Q15)
+    uint32_t ramp_frames;  // 剩余渐变帧数
+} mixer_stream_t;
+
+// 预加载的音效
+typedef struct
+{
+    char name[AUDIO_MIXER_EFFECT_NAME_MAX];
+    const int16_t *pcm; // 48kHz立体声PCM (PSRAM或映射的flash, 16字节对齐, 长度补齐到整块)
+    uint32_t frames; // 帧数 (AUDIO_MIXER_BLOCK_FRAMES的整数倍)
+} mixer_effect_t;
+
+// 正在播放的音效
+typedef struct
+{
+    const int16_t *pos;   // 下一块的起始位置
+    uint32_t frames_left; // 剩余帧数, 0表示空闲
+    int16_t gain;         // Q15
+} mixer_voice_t;
+
+static mixer_stream_t s_streams[AUDIO_MIXER_STREAM_MAX];
+static mixer_effect_t s_effects[AUDIO_MIXER_MAX_EFFECTS];
+static int s_effect_count = 0;
+static mixer_voice_t s_voices[AUDIO_MIXER_MAX_EFFECT_VOICES];
+static uint32_t s_next_voice = 0;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskHandle_t s_task_handle = NULL;
+static volatile bool s_running = false;
+static int16_t *s_out_buf = NULL;     // 输出块 (内部RAM, 16字节对齐)
+static int16_t *s_scratch_buf = NULL; // 从环形缓冲区取出的输入块
+static audio_mixer_stats_t s_stats;
+static int16_t s_master_gain = AUDIO_DSP_GAIN_UNITY; // 当前主音量(Q15), 仅混音任务访问
+
+// 输出EQ: s_eq_chain仅混音任务访问, 新系数经s_eq_pending交给混音任务
+static audio_dsp_biquad_chain_t s_eq_chain;
+static audio_dsp_biquad_coef_t s_eq_pending[AUDIO_DSP_BIQUAD_MAX_STAGES];
+static int s_eq_pending_stages = 0;
+static bool s_eq_pending_valid = false;
+static audio_mixer_tap_cb_t s_tap_cb = NULL;
+static void *s_tap_ctx = NULL;
+static audio_mixer_eq_t s_eq_config = {
+    .speaker_hpf_hz = AUDIO_MIXER_SPEAKER_HPF_HZ,
+};
+
+static int16_t gain_to_q15(float gain)
+{
+    if (gain <= 0.0f)
+    {
+        return 0;
+    }
+    if (gain >= 1.0f)
+    {
+        return AUDIO_DSP_GAIN_UNITY;
+    }
+    return (int16_t)(gain * AUDIO_DSP_GAIN_UNITY);
+}
+
+/**
+ * @brief 从环形缓冲区读取最多len字节 (不等待)
+ * @return 实际读取的字节数
+ */
+static size_t stream_read(RingbufHandle_t ring, uint8_t *dst, size_t len)
+{
+    size_t total = 0;
+    while (total < len)
+    {
+        size_t item_size = 0;
+        void *item = xRingbufferReceiveUpTo(ring, &item_size, 0, len - total);
+        if (item == NULL)
+        {
+            break;
+        }
+        memcpy(dst + total, item, item_size);
+        vRingbufferReturnItem(ring, item);
+        total += item_size;
+    }
+    return total;
+}
+
+/**
+ * @brief 取一个块的输入
+ * @details 环形缓冲区中连续的整块直接返回其地址(混音后用vRingbufferReturnItem归还),
+ *          跨越缓冲区末尾或不足一块时拷贝到s_scratch_buf, 不足部分补静音
+ * @param st 流
+ * @param item 输出需要归还的项, 拷贝时为NULL
+ * @param got 输出实际读到的字节数, 0表示没有数据
+ * @return 输入块
+ */
+static const int16_t *stream_acquire(mixer_stream_t *st, void **item, size_t *got)
+{
+    size_t item_size = 0;
+    st->held = true;
+    uint8_t *first = xRingbufferReceiveUpTo(st->ring, &item_size, 0, MIXER_BLOCK_BYTES);
+    *item = NULL;
+    *got = 0;
+    if (first == NULL)
+    {
+        st->held = false;
+        return NULL;
+    }
+    if (item_size == MIXER_BLOCK_BYTES)
+    {
+        *item = first;
+        *got = item_size;
+        s_stats.zero_copy_blocks++;
+        return (const int16_t *)first;
+    }
+
+    memcpy(s_scratch_buf, first, item_size);
+    vRingbufferReturnItem(st->ring, first);
+    *got = item_size + stream_read(st->ring, (uint8_t *)s_scratch_buf + item_size, MIXER_BLOCK_BYTES - item_size);
+    st->held = false;
+    if (*got < MIXER_BLOCK_BYTES)
+    {
+        memset((uint8_t *)s_scratch_buf + *got, 0, MIXER_BLOCK_BYTES - *got);
+    }
+    return s_scratch_buf;
+}
+
+/**
+ * @brief 创建环形缓冲区, 存储按AUDIO_DSP_ALIGN对齐, 使整块输入可以直接走SIMD路径
+ */
+static esp_err_t stream_create_ring(mixer_stream_t *st, uint32_t caps)
+{
+    st->ring_struct = heap_caps_calloc(1, sizeof(StaticRingbuffer_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    st->ring_storage = heap_caps_aligned_alloc(AUDIO_DSP_ALIGN, AUDIO_MIXER_STREAM_BUF_SIZE, caps);
+    if (st->ring_struct == NULL || st->ring_storage == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    st->ring = xRingbufferCreateStatic(AUDIO_MIXER_STREAM_BUF_SIZE, RINGBUF_TYPE_BYTEBUF, st->ring_storage, st->ring_struct);
+    return st->ring != NULL ? ESP_OK : ESP_FAIL;
+}
+
+/**
+ * @brief 计算本块的起止增益并推进渐变
+ */
+static void stream_step_gain(mixer_stream_t *st, int16_t *gain_start, int16_t *gain_end)
+{
+    portENTER_CRITICAL(&s_lock);
+    *gain_start = st->gain_cur;
+    if (st->ramp_frames > AUDIO_MIXER_BLOCK_FRAMES)
+    {
+        int32_t delta = (int32_t)(st->gain_target - st->gain_cur) * AUDIO_MIXER_BLOCK_FRAMES / (int32_t)st->ramp_frames;
+        st->gain_cur += delta;
+        st->ramp_frames -= AUDIO_MIXER_BLOCK_FRAMES;
+    }
+    else
+    {
+        st->gain_cur = st->gain_target;
+        st->ramp_frames = 0;
+    }
+    *gain_end = st->gain_cur;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+/**
+ * @brief 把输入块按增益累加到输出块
+ */
+static void mix_block(const int16_t *src, int16_t gain_start, int16_t gain_end)
+{
+    if (gain_start == gain_end)
+    {
+        audio_dsp_mix_s16(s_out_buf, src, MIXER_BLOCK_SAMPLES, gain_end);
+    }
+    else
+    {
+        audio_dsp_mix_ramp_s16(s_out_buf, src, AUDIO_MIXER_BLOCK_FRAMES, MIXER_CHANNELS, gain_start, gain_end);
+    }
+}
+
+/**
+ * @brief 累加所有正在播放的音效
+ * @return true 至少有一个音效在播放
+ */
+static bool mix_effects(void)
+{
+    int16_t gain_start, gain_end;
+    stream_step_gain(&s_streams[AUDIO_MIXER_STREAM_EFFECT], &gain_start, &gain_end);
+
+    bool active = false;
+    for (int i = 0; i < AUDIO_MIXER_MAX_EFFECT_VOICES; i++)
+    {
+        mixer_voice_t voice;
+        portENTER_CRITICAL(&s_lock);
+        voice = s_voices[i];
+        if (voice.frames_left > 0)
+        {
+            // 音效长度已补齐到整块, 每次正好推进一块
+            s_voices[i].pos += MIXER_BLOCK_SAMPLES;
+            s_voices[i].frames_left -= AUDIO_MIXER_BLOCK_FRAMES;
+        }
+        portEXIT_CRITICAL(&s_lock);
+
+        if (voice.frames_left == 0)
+        {
+            continue;
+        }
+
+        active = true;
+        int16_t g0 = (int16_t)(((int32_t)voice.gain * gain_start) >> 15);
+        int16_t g1 = (int16_t)(((int32_t)voice.gain * gain_end) >> 15);
+        mix_block(voice.pos, g0, g1);
+    }
+    return active;
+}
+
+/**
+ * @brief 对输出块做EQ, 有新系数时交叉淡化切换
+ */
+static void apply_eq(void)
+{
+    static audio_dsp_biquad_coef_t coef[AUDIO_DSP_BIQUAD_MAX_STAGES];
+    int stages = 0;
+    bool swap = false;
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_eq_pending_valid)
+    {
+        stages = s_eq_pending_stages;
+        memcpy(coef, s_eq_pending, sizeof(coef));
+        s_eq_pending_valid = false;
+        swap = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!swap && s_eq_chain.stages == 0)
+    {
+        return;
+    }
+
+    int64_t t0 = esp_timer_get_time();
+    if (swap)
+    {
+        // 混音已完成, s_scratch_buf可作为旧系数输出的临时缓冲区
+        audio_dsp_biquad_chain_swap(&s_eq_chain, coef, stages, s_out_buf, s_scratch_buf,
+                                    AUDIO_MIXER_BLOCK_FRAMES, MIXER_CHANNELS);
+        s_stats.eq_swaps++;
+    }
+    else
+    {
+        audio_dsp_biquad_chain_process(&s_eq_chain, s_out_buf, AUDIO_MIXER_BLOCK_FRAMES, MIXER_CHANNELS);
+    }
+
+    uint32_t eq_us = (uint32_t)(esp_timer_get_time() - t0);
+    if (eq_us > s_stats.max_eq_us)
+    {
+        s_stats.max_eq_us = eq_us;
+    }
+}
+
+/**
+ * @brief 应用主音量: 向目标增益限速逼近, 块内逐帧线性过渡
+ */
+static void apply_master_gain(void)
+{
+    // 模拟音量在这一块的开头跨档时, 当前增益按档位差换算, 与codec寄存器在同一采样生效
+    int16_t start = s_master_gain;
+    audio_codec_playback_volume_switch(start, &start);
+    int16_t target = audio_codec_get_soft_gain_q15();
+    int32_t delta = (int32_t)target - start;
+
+    if (delta > MIXER_MASTER_MAX_STEP)
+    {
+        delta = MIXER_MASTER_MAX_STEP;
+    }
+    else if (delta < -MIXER_MASTER_MAX_STEP)
+    {
+        delta = -MIXER_MASTER_MAX_STEP;
+    }
+    s_master_gain = (int16_t)(start + delta);
+
+    if (start == s_master_gain)
+    {
+        audio_dsp_scale_s16(s_out_buf, MIXER_BLOCK_SAMPLES, s_master_gain);
+    }
+    else
+    {
+        audio_dsp_scale_ramp_s16(s_out_buf, AUDIO_MIXER_BLOCK_FRAMES, MIXER_CHANNELS, start, s_master_gain);
+    }
+}
+
+static void mixer_task(void *arg)
+{
+    ESP_LOGI(TAG, "混音任务启动: 块大小 %d 帧", AUDIO_MIXER_BLOCK_FRAMES);
+
+    while (s_running)
+    {
+        bool active = false;
+        int64_t t0 = esp_timer_get_time();
+
+        memset(s_out_buf, 0, MIXER_BLOCK_BYTES);
+
+        // 1. 音乐/语音流
+        for (int s = 0; s < AUDIO_MIXER_STREAM_MAX; s++)
+        {
+            mixer_stream_t *st = &s_streams[s];
+            if (st->ring == NULL)
+            {
+                continue;
+            }
+
+            void *item;
+            size_t got;
+            const int16_t *src = stream_acquire(st, &item, &got);
+            if (got == 0)
+            {
+                continue;
+            }
+            if (got < MIXER_BLOCK_BYTES)
+            {
+                // 生产者跟不上, 已用静音补齐
+                s_stats.underruns[s]++;
+            }
+
+            int16_t gain_start, gain_end;
+            stream_step_gain(st, &gain_start, &gain_end);
+            mix_block(src, gain_start, gain_end);
+            if (item != NULL)
+            {
+                vRingbufferReturnItem(st->ring, item);
+                st->held = false;
+            }
+            active = true;
+        }
+
+        // 2. 音效
+        if (mix_effects())
+        {
+            active = true;
+        }
+
+        audio_codec_playback_set_active(active); // 有流在输出时不允许切换延迟档位
+        if (!active)
+        {
+            // 没有输出时无需渐变, 主音量直接跟随目标; DMA队列播空后待跨档的模拟音量在这里立即写入
+            audio_codec_playback_volume_switch(s_master_gain, &s_master_gain);
+            s_master_gain = audio_codec_get_soft_gain_q15();
+            // 没有任何数据, 等待写入或音效触发
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MIXER_IDLE_WAIT_MS));
+            continue;
+        }
+
+        // 3. 输出EQ
+        apply_eq();
+
+        // 4. 输出监听 (不受音量影响), 然后应用主音量
+        audio_mixer_tap_cb_t tap_cb;
+        void *tap_ctx;
+        portENTER_CRITICAL(&s_lock);
+        tap_cb = s_tap_cb;
+        tap_ctx = s_tap_ctx;
+        portEXIT_CRITICAL(&s_lock);
+        if (tap_cb != NULL)
+        {
+            tap_cb(s_out_buf, AUDIO_MIXER_BLOCK_FRAMES, tap_ctx);
+        }
+        apply_master_gain();
+
+        uint32_t mix_us = (uint32_t)(esp_timer_get_time() - t0);
+        if (mix_us > s_stats.max_mix_us)
+        {
+            s_stats.max_mix_us = mix_us;
+        }
+        s_stats.blocks_mixed++;
+
+        // 5. 写入一个DMA缓冲区 (阻塞直到DMA有空间)
+        if (audio_codec_playback_write(s_out_buf, AUDIO_MIXER_BLOCK_FRAMES, MIXER_WRITE_TIMEOUT_MS) != ESP_OK)
+        {
+            s_stats.write_errors++;
+        }
+    }
+
+    audio_codec_playback_set_active(false);
+    ESP_LOGI(TAG, "混音任务退出");
+    s_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t audio_mixer_init(void)
+{
+    if (s_running)
+    {
+        return ESP_OK;
+    }
+
+    if (audio_codec_get_playback_dev() == NULL)
+    {
+        ESP_LOGE(TAG, "播放设备未初始化, 请先调用audio_codec_init()");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_out_buf = heap_caps_aligned_alloc(AUDIO_DSP_ALIGN, MIXER_BLOCK_BYTES, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    s_scratch_buf = heap_caps_aligned_alloc(AUDIO_DSP_ALIGN, MIXER_BLOCK_BYTES, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    // 音乐缓冲放在内部RAM, 避免和LVGL争用PSRAM带宽; 语音提示使用较少, 放在PSRAM
+    esp_err_t music_ret = stream_create_ring(&s_streams[AUDIO_MIXER_STREAM_MUSIC], MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    esp_err_t voice_ret = stream_create_ring(&s_streams[AUDIO_MIXER_STREAM_VOICE], MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    s_streams[AUDIO_MIXER_STREAM_EFFECT].ring = NULL;
+
+    if (s_out_buf == NULL || s_scratch_buf == NULL || music_ret != ESP_OK || voice_ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "混音缓冲区分配失败");
+        audio_mixer_deinit();
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (int s = 0; s < AUDIO_MIXER_STREAM_MAX; s++)
+    {
+        s_streams[s].gain_cur = AUDIO_DSP_GAIN_UNITY;
+        s_streams[s].gain_target = AUDIO_DSP_GAIN_UNITY;
+        s_streams[s].ramp_frames = 0;
+    }
+    memset(s_voices, 0, sizeof(s_voices));
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_master_gain = audio_codec_get_soft_gain_q15();
+    audio_dsp_biquad_chain_init(&s_eq_chain, NULL, 0);
+    audio_mixer_set_eq(&s_eq_config);
+
+    s_running = true;
+    BaseType_t ret = xTaskCreatePinnedToCore(mixer_task, "audio_mixer", 4096, NULL,
+                                             AUDIO_MIXER_TASK_PRIORITY, &s_task_handle, AUDIO_MIXER_TASK_CORE);
+    if (ret != pdPASS)
+    {
+        ESP_LOGE(TAG, "创建混音任务失败");
+        s_running = false;
+        audio_mixer_deinit();
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "混音器初始化成功");
+    return ESP_OK;
+}
+
+esp_err_t audio_mixer_deinit(void)
+{
+    if (s_task_handle != NULL)
+    {
+        s_running = false;
+        xTaskNotifyGive(s_task_handle);
+        // 等待混音任务完成当前块后退出
+        for (int i = 0; i < 50 && s_task_handle != NULL; i++)
+        {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+    }
+
+    for (int s = 0; s < AUDIO_MIXER_STREAM_MAX; s++)
+    {
+        if (s_streams[s].ring != NULL)
+        {
+            vRingbufferDelete(s_streams[s].ring);
+            s_streams[s].ring = NULL;
+        }
+        heap_caps_free(s_streams[s].ring_struct);
+        heap_caps_free(s_streams[s].ring_storage);
+        s_streams[s].ring_struct = NULL;
+        s_streams[s].ring_storage = NULL;
+    }
+
+    heap_caps_free(s_out_buf);
+    heap_caps_free(s_scratch_buf);
+    s_out_buf = NULL;
+    s_scratch_buf = NULL;
+    return ESP_OK;
+}
+
+esp_err_t audio_mixer_write(audio_mixer_stream_t stream, const void *data, size_t len, uint32_t timeout_ms)
+{
+    if (stream >= AUDIO_MIXER_STREAM_MAX || data == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    RingbufHandle_t ring = s_streams[stream].ring;
+    if (ring == NULL || !s_running)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // 分段写入, 每段不超过缓冲区一半, 保证混音任务取走一部分后就能继续写
+    const uint8_t *p = data;
+    const size_t max_chunk = AUDIO_MIXER_STREAM_BUF_SIZE / 2;
+    while (len > 0)
+    {
+        size_t chunk = len > max_chunk ? max_chunk : len;
+        if (xRingbufferSend(ring, p, chunk, pdMS_TO_TICKS(timeout_ms)) != pdTRUE)
+        {
+            return ESP_ERR_TIMEOUT;
+        }
+        xTaskNotifyGive(s_task_handle);
+
+        uint32_t used = AUDIO_MIXER_STREAM_BUF_SIZE - xRingbufferGetCurFreeSize(ring);
+        if (used > s_stats.peak_fill[stream])
+        {
+            s_stats.peak_fill[stream] = used;
+        }
+        p += chunk;
+        len -= chunk;
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_mixer_flush(audio_mixer_stream_t stream)
+{
+    if (stream >= AUDIO_MIXER_STREAM_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (stream == AUDIO_MIXER_STREAM_EFFECT)
+    {
+        portENTER_CRITICAL(&s_lock);
+        memset(s_voices, 0, sizeof(s_voices));
+        portEXIT_CRITICAL(&s_lock);
+        return ESP_OK;
+    }
+
+    RingbufHandle_t ring = s_streams[stream].ring;
+    if (ring == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // 混音任务持有一块时字节缓冲区不允许再次读取, 等它归还后继续清空
+    size_t item_size;
+    void *item;
+    while (true)
+    {
+        while ((item = xRingbufferReceiveUpTo(ring, &item_size, 0, AUDIO_MIXER_STREAM_BUF_SIZE)) != NULL)
+        {
+            vRingbufferReturnItem(ring, item);
+        }
+        if (!s_streams[stream].held)
+        {
+            break;
+        }
+        vTaskDelay(1);
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_mixer_set_gain(audio_mixer_stream_t stream, float gain, uint32_t ramp_ms)
+{
+    if (stream >= AUDIO_MIXER_STREAM_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t ramp_frames = ramp_ms * (AUDIO_DEFAULT_SAMPLE_RATE / 1000);
+    if (ramp_frames < AUDIO_MIXER_BLOCK_FRAMES)
+    {
+        ramp_frames = AUDIO_MIXER_BLOCK_FRAMES;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_streams[stream].gain_target = gain_to_q15(gain);
+    s_streams[stream].ramp_frames = ramp_frames;
+    portEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
+
+/**
+ * @brief 把EQ配置展开为biquad系数
+ * @return 级数, 参数无效返回-1
+ */
+static int eq_design(const audio_mixer_eq_t *eq, audio_dsp_biquad_coef_t *coef)
+{
+    audio_dsp_biquad_param_t params[AUDIO_DSP_BIQUAD_MAX_STAGES];
+    int n = 0;
+    float max_boost_db = 0.0f;
+
+    if (eq->speaker_hpf_hz > 0.0f)
+    {
+        params[n++] = (audio_dsp_biquad_param_t){AUDIO_DSP_BIQUAD_HIGHPASS, eq->speaker_hpf_hz, 0.0f, 0.707f};
+    }
+    if (eq->bass_boost_db != 0.0f)
+    {
+        params[n++] = (audio_dsp_biquad_param_t){AUDIO_DSP_BIQUAD_LOW_SHELF, AUDIO_MIXER_BASS_BOOST_HZ, eq->bass_boost_db, 0.707f};
+    }
+    if (eq->loudness)
+    {
+        params[n++] = (audio_dsp_biquad_param_t){AUDIO_DSP_BIQUAD_LOW_SHELF, 80.0f, AUDIO_MIXER_LOUDNESS_LOW_DB, 0.707f};
+        params[n++] = (audio_dsp_biquad_param_t){AUDIO_DSP_BIQUAD_HIGH_SHELF, 10000.0f, AUDIO_MIXER_LOUDNESS_HIGH_DB, 0.707f};
+    }
+    for (int i = 0; i < eq->band_count; i++)
+    {
+        params[n++] = eq->bands[i];
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        if (!audio_dsp_biquad_design(&params[i], AUDIO_DEFAULT_SAMPLE_RATE, &coef[i]))
+        {
+            ESP_LOGE(TAG, "EQ第%d级参数无效: %.0fHz %.1fdB Q%.2f", i, params[i].freq_hz, params[i].gain_db, params[i].q);
+            return -1;
+        }
+        if (params[i].type != AUDIO_DSP_BIQUAD_HIGHPASS && params[i].type != AUDIO_DSP_BIQUAD_LOWPASS)
+        {
+            // 级联后最坏情况的提升按各级提升之和估计
+            max_boost_db += params[i].gain_db > 0.0f ? params[i].gain_db : 0.0f;
+        }
+    }
+
+    // 前级衰减并入第一级的b系数, 避免额外的一次遍历
+    if (n > 0 && max_boost_db > 0.0f)
+    {
+        float preamp = powf(10.0f, -max_boost_db / 20.0f);
+        coef[0].b0 = (int32_t)(coef[0].b0 * preamp);
+        coef[0].b1 = (int32_t)(coef[0].b1 * preamp);
+        coef[0].b2 = (int32_t)(coef[0].b2 * preamp);
+    }
+    return n;
+}
+
+esp_err_t audio_mixer_set_eq(const audio_mixer_eq_t *eq)
+{
+    if (eq == NULL || eq->band_count < 0 || eq->band_count > AUDIO_MIXER_EQ_MAX_BANDS)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_dsp_biquad_coef_t coef[AUDIO_DSP_BIQUAD_MAX_STAGES];
+    int stages = eq_design(eq, coef);
+    if (stages < 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    memcpy(s_eq_pending, coef, stages * sizeof(audio_dsp_biquad_coef_t));
+    s_eq_pending_stages = stages;
+    s_eq_pending_valid = true;
+    s_eq_config = *eq;
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "EQ更新: %d级", stages);
+    return ESP_OK;
+}
+
+void audio_mixer_get_eq(audio_mixer_eq_t *eq)
+{
+    if (eq == NULL)
+    {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    *eq = s_eq_config;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+/**
+ * @brief 读取WAV文件的fmt和data块
+ * @return esp_err_t ESP_OK成功, data_offset/data_size为PCM数据位置
+ */
+static esp_err_t wav_read_header(FILE *f, uint16_t *channels, uint32_t *sample_rate,
+                                 uint32_t *data_offset, uint32_t *data_size)
+{
+    uint8_t riff[12];
+    if (fread(riff, 1, sizeof(riff), f) != sizeof(riff) ||
+        memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    bool have_fmt = false;
+    uint8_t chunk[8];
+    while (fread(chunk, 1, sizeof(chunk), f) == sizeof(chunk))
+    {
+        uint32_t size = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | ((uint32_t)chunk[7] << 24);
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16)
+        {
+            uint8_t fmt[16];
+            if (fread(fmt, 1, sizeof(fmt), f) != sizeof(fmt))
+            {
+                return ESP_ERR_INVALID_SIZE;
+            }
+            uint16_t audio_fmt = fmt[0] | (fmt[1] << 8);
+            uint16_t bits = fmt[14] | (fmt[15] << 8);
+            *channels = fmt[2] | (fmt[3] << 8);
+            *sample_rate = fmt[4] | (fmt[5] << 8) | (fmt[6] << 16) | ((uint32_t)fmt[7] << 24);
+            if (audio_fmt != 1 || bits != 16 || *channels == 0 || *channels > 2 || *sample_rate == 0)
+            {
+                ESP_LOGE(TAG, "只支持16位PCM单/双声道WAV (格式%u, %u位, %u声道)", audio_fmt, bits, *channels);
+                return ESP_ERR_NOT_SUPPORTED;
+            }
+            have_fmt = true;
+            fseek(f, (size - 16) + (size & 1), SEEK_CUR);
+        }
+        else if (memcmp(chunk, "data", 4) == 0)
+        {
+            if (!have_fmt)
+            {
+                return ESP_ERR_NOT_SUPPORTED;
+            }
+            *data_offset = (uint32_t)ftell(f);
+            *data_size = size;
+            return ESP_OK;
+        }
+        else
+        {
+            fseek(f, size + (size & 1), SEEK_CUR);
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+/**
+ * @brief 把音效加入表中 (s_lock保护, 可以与播放、查找和其他加载并发)
+ * @details 表项写好后才增加计数, 读者只访问计数以内的表项, 已加入的表项不再修改
+ * @return 音效ID, 表已满时返回-1
+ */
+static int effect_publish(const char *name, const int16_t *pcm, uint32_t frames)
+{
+    int id = -1;
+    portENTER_CRITICAL(&s_lock);
+    if (s_effect_count < AUDIO_MIXER_MAX_EFFECTS)
+    {
+        id = s_effect_count;
+        mixer_effect_t *fx = &s_effects[id];
+        strcpy(fx->name, name);
+        fx->pcm = pcm;
+        fx->frames = frames;
+        s_effect_count++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return id;
+}
+
+/**
+ * @brief 已加入表中的音效数
+ */
+static int effect_count(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    int count = s_effect_count;
+    portEXIT_CRITICAL(&s_lock);
+    return count;
+}
+
+esp_err_t audio_mixer_effect_load(const char *path, const char *name, int *out_id)
+{
+    if (path == NULL || name == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // 截断后audio_mixer_effect_find按原名找不到, 直接拒绝
+    if (strlen(name) >= AUDIO_MIXER_EFFECT_NAME_MAX)
+    {
+        ESP_LOGE(TAG, "音效名称过长: %s", name);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (effect_count() >= AUDIO_MIXER_MAX_EFFECTS)
+    {
+        ESP_LOGE(TAG, "音效数量已达上限 %d", AUDIO_MIXER_MAX_EFFECTS);
+        return ESP_ERR_NO_MEM;
+    }
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        ESP_LOGE(TAG, "无法打开音效文件: %s", path);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint16_t channels = 0;
+    uint32_t sample_rate = 0, data_offset = 0, data_size = 0;
+    esp_err_t ret = wav_read_header(f, &channels, &sample_rate, &data_offset, &data_size);
+    if (ret != ESP_OK)
+    {
+        fclose(f);
+        return ret;
+    }
+
+    uint32_t in_frames = data_size / (channels * sizeof(int16_t));
+    uint32_t out_frames = (uint32_t)((uint64_t)in_frames * AUDIO_DEFAULT_SAMPLE_RATE / sample_rate);
+    // 补齐到整块, 混音时每块直接从PSRAM累加, 不需要处理尾部
+    uint32_t padded_frames = (out_frames + AUDIO_MIXER_BLOCK_FRAMES - 1) / AUDIO_MIXER_BLOCK_FRAMES * AUDIO_MIXER_BLOCK_FRAMES;
+    size_t pcm_bytes = padded_frames * MIXER_FRAME_BYTES;
+
+    if (in_frames == 0 || pcm_bytes > AUDIO_MIXER_MAX_EFFECT_BYTES)
+    {
+        ESP_LOGE(TAG, "音效长度无效或过大: %s (%u 字节)", path, (unsigned)pcm_bytes);
+        fclose(f);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    int16_t *raw = heap_caps_malloc(data_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    int16_t *pcm = heap_caps_aligned_calloc(AUDIO_DSP_ALIGN, 1, pcm_bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (raw == NULL || pcm == NULL)
+    {
+        heap_caps_free(raw);
+        heap_caps_free(pcm);
+        fclose(f);
+        return ESP_ERR_NO_MEM;
+    }
+
+    fseek(f, data_offset, SEEK_SET);
+    size_t got = fread(raw, 1, data_size, f);
+    fclose(f);
+    in_frames = got / (channels * sizeof(int16_t));
+    if (out_frames > (uint32_t)((uint64_t)in_frames * AUDIO_DEFAULT_SAMPLE_RATE / sample_rate))
+    {
+        out_frames = (uint32_t)((uint64_t)in_frames * AUDIO_DEFAULT_SAMPLE_RATE / sample_rate);
+    }
+
+    // 转换为48kHz立体声: 单声道复制到两个声道, 采样率不同时线性插值 (Q16步进)
+    uint32_t step = (uint32_t)(((uint64_t)sample_rate << 16) / AUDIO_DEFAULT_SAMPLE_RATE);
+    uint64_t phase = 0;
+    for (uint32_t i = 0; i < out_frames; i++, phase += step)
+    {
+        uint32_t idx = (uint32_t)(phase >> 16);
+        int32_t frac = (int32_t)(phase & 0xFFFF);
+        uint32_t next = (idx + 1 < in_frames) ? idx + 1 : idx;
+        for (int c = 0; c < MIXER_CHANNELS; c++)
+        {
+            int src_c = (channels == 1) ? 0 : c;
+            int32_t a = raw[idx * channels + src_c];
+            int32_t b = raw[next * channels + src_c];
+            pcm[i * MIXER_CHANNELS + c] = (int16_t)(a + (((b - a) * frac) >> 16));
+        }
+    }
+    heap_caps_free(raw);
+
+    // 解码期间其他任务可能已加满
+    int id = effect_publish(name, pcm, padded_frames);
+    if (id < 0)
+    {
+        ESP_LOGE(TAG, "音效数量已达上限 %d", AUDIO_MIXER_MAX_EFFECTS);
+        heap_caps_free(pcm);
+        return ESP_ERR_NO_MEM;
+    }
+    if (out_id != NULL)
+    {
+        *out_id = id;
+    }
+
+    ESP_LOGI(TAG, "已加载音效 '%s': %s, %lu Hz %u声道 -> %u 帧 (%u 字节 PSRAM)",
+             name, path, (unsigned long)sample_rate, channels, (unsigned)out_frames, (unsigned)pcm_bytes);
+    return ESP_OK;
+}
+
+esp_err_t audio_mixer_effect_register(const char *name, const int16_t *pcm, uint32_t frames, int *out_id)
+{
+    if (name == NULL || pcm == NULL || frames == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // 混音时按块直接从pcm累加, 对齐和长度必须满足SIMD路径和整块推进的要求
+    if (((uintptr_t)pcm % AUDIO_DSP_ALIGN) != 0 || (frames % AUDIO_MIXER_BLOCK_FRAMES) != 0)
+    {
+        ESP_LOGE(TAG, "音效数据未对齐或长度不是整块: %s", name);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (strlen(name) >= AUDIO_MIXER_EFFECT_NAME_MAX)
+    {
+        ESP_LOGE(TAG, "音效名称过长: %s", name);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (effect_count() >= AUDIO_MIXER_MAX_EFFECTS)
+    {
+        ESP_LOGE(TAG, "音效数量已达上限 %d", AUDIO_MIXER_MAX_EFFECTS);
+        return ESP_ERR_NO_MEM;
+    }
+
+    int id = effect_publish(name, pcm, frames);
+    if (id < 0)
+    {
+        ESP_LOGE(TAG, "音效数量已达上限 %d", AUDIO_MIXER_MAX_EFFECTS);
+        return ESP_ERR_NO_MEM;
+    }
+    if (out_id != NULL)
+    {
+        *out_id = id;
+    }
+
+    ESP_LOGI(TAG, "已注册音效 '%s': %lu 帧 @ %p (不拷贝)", name, (unsigned long)frames, pcm);
+    return ESP_OK;
+}
+
+int audio_mixer_effect_find(const char *name)
+{
+    if (name == NULL)
+    {
+        return -1;
+    }
+    int count = effect_count();
+    for (int i = 0; i < count; i++)
+    {
+        if (strcasecmp(s_effects[i].name, name) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+esp_err_t audio_mixer_effect_play(int id, float gain)
+{
+    if (id < 0 || id >= effect_count())
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (!s_running)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const mixer_effect_t *fx = &s_effects[id];
+
+    portENTER_CRITICAL(&s_lock);
+    // 优先使用空闲声部, 都在播放时按轮转顺序抢占最早的一个
+    int slot = -1;
+    for (int i = 0; i < AUDIO_MIXER_MAX_EFFECT_VOICES; i++)
+    {
+        if (s_voices[i].frames_left == 0)
+        {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0)
+    {
+        slot = s_next_voice;
+        s_next_voice = (s_next_voice + 1) % AUDIO_MIXER_MAX_EFFECT_VOICES;
+    }
+    s_voices[slot].pos = fx->pcm;
+    s_voices[slot].frames_left = fx->frames;
+    s_voices[slot].gain = gain_to_q15(gain);
+    s_stats.effects_triggered++;
+    portEXIT_CRITICAL(&s_lock);
+
+    xTaskNotifyGive(s_task_handle);
+    return ESP_OK;
+}
+
+esp_err_t audio_mixer_set_tap(audio_mixer_tap_cb_t cb, void *ctx)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_tap_cb = cb;
+    s_tap_ctx = ctx;
+    portEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
+
+void audio_mixer_get_stats(audio_mixer_stats_t *stats)
+{
+    if (stats != NULL)
+    {
+        *stats = s_stats;
+    }
+}
@@ -0,0 +1,193 @@
+/**
+ * @file audio_mixer.h
+ * @brief 多路音频混音器
+ * @details 位于I2S写入之前, 以固定块大小(I2S DMA缓冲区帧数的基本单位)把多路16位立体声流按各自增益饱和相加后直接写入I2S。
+ *          - 音乐/语音: 生产者通过audio_mixer_write写入各自的环形缓冲区
+ *          - 音效: 预加载到PSRAM, 触发时不做任何文件I/O, 在下一个混音块(5ms)开始发声
+ *          - 混音结果经过biquad级联(扬声器保护高通/低音增强/等响度/参数EQ)后输出
+ */
+
+#ifndef AUDIO_MIXER_H
+#define AUDIO_MIXER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "audio_dsp_biquad.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define AUDIO_MIXER_BLOCK_FRAMES (240)         // 每个混音块的帧数 (48kHz下5ms)
+#define AUDIO_MIXER_STREAM_BUF_SIZE (16 * 1024) // 每路流的环形缓冲区大小(字节, 约85ms)
+#define AUDIO_MIXER_MAX_EFFECTS (16)            // 最多预加载的音效数量
+#define AUDIO_MIXER_EFFECT_NAME_MAX (36)        // 音效名称长度上限, 含结尾的'\0' (不小于资源包的名称上限)
+#define AUDIO_MIXER_MAX_EFFECT_VOICES (4)       // 同时播放的音效数量
+#define AUDIO_MIXER_MAX_EFFECT_BYTES (512 * 1024) // 单个音效的最大PCM大小
+#define AUDIO_MIXER_TASK_PRIORITY (6)           // 高于audio_player解码任务
+#define AUDIO_MIXER_TASK_CORE (0)
+#define AUDIO_MIXER_MASTER_RAMP_MS (30)         // 主音量满刻度变化的最短过渡时间
+#define AUDIO_MIXER_EQ_MAX_BANDS (5)            // 参数EQ频段数
+#define AUDIO_MIXER_SPEAKER_HPF_HZ (150.0f)     // 默认扬声器保护高通频率 (NS4150B驱动的小腔体扬声器)
+#define AUDIO_MIXER_BASS_BOOST_HZ (100.0f)      // 低音增强低架频率
+#define AUDIO_MIXER_LOUDNESS_LOW_DB (6.0f)      // 等响度补偿: 低频提升
+#define AUDIO_MIXER_LOUDNESS_HIGH_DB (3.0f)     // 等响度补偿: 高频提升
+
+    /**
+     * @brief 混音流类型
+     */
+    typedef enum
+    {
+        AUDIO_MIXER_STREAM_MUSIC = 0, // 音乐 (mp3_player)
+        AUDIO_MIXER_STREAM_EFFECT,    // UI音效 (预加载)
+        AUDIO_MIXER_STREAM_VOICE,     // 语音提示 (预留)
+        AUDIO_MIXER_STREAM_MAX,
+    } audio_mixer_stream_t;
+
+    /**
+     * @brief 混音器统计信息
+     */
+    typedef struct
+    {
+        uint32_t blocks_mixed;                        // 已混音的块数
+        uint32_t underruns[AUDIO_MIXER_STREAM_MAX];   // 各路流数据不足一个块的次数
+        uint32_t effects_triggered;                   // 触发的音效次数
+        uint32_t max_mix_us;                          // 单块混音最长耗时
+        uint32_t max_eq_us;                           // 单块EQ处理最长耗时
+        uint32_t eq_swaps;                            // EQ系数切换次数
+        uint32_t peak_fill[AUDIO_MIXER_STREAM_MAX];   // 各路流环形缓冲区的最高占用(字节)
+        uint32_t zero_copy_blocks;                    // 直接从环形缓冲区混音(未经临时缓冲区)的输入块数
+        uint32_t write_errors;                        // 写入I2S失败(超时)的块数
+    } audio_mixer_stats_t;
+
+    /**
+     * @brief 输出监听回调 (可视化等旁路分析使用)
+     * @note 在混音任务中调用, 必须立即返回: 不得阻塞、加锁等待或做文件I/O
+     * @param pcm EQ之后、主音量之前的输出块 (48kHz/16位/立体声)
+     * @param frames 帧数
+     * @param ctx 注册时传入的用户参数
+     */
+    typedef void (*audio_mixer_tap_cb_t)(const int16_t *pcm, size_t frames, void *ctx);
+
+    /**
+     * @brief 输出EQ配置
+     */
+    typedef struct
+    {
+        float speaker_hpf_hz; // 扬声器保护高通频率, 0关闭
+        float bass_boost_db;  // 低音增强(低架), 0关闭
+        bool loudness;        // 等响度补偿(低架+高架)
+        int band_count;       // 参数EQ频段数
+        audio_dsp_biquad_param_t bands[AUDIO_MIXER_EQ_MAX_BANDS];
+    } audio_mixer_eq_t;
+
+    /**
+     * @brief 初始化混音器并启动混音任务
+     * @note 必须在audio_codec_init()之后调用
+     * @return esp_err_t ESP_OK成功
+     */
+    esp_err_t audio_mixer_init(void);
+
+    /**
+     * @brief 停止混音任务并释放资源 (已加载的音效保留)
+     * @return esp_err_t ESP_OK成功
+     */
+    esp_err_t audio_mixer_deinit(void);
+
+    /**
+     * @brief 向音乐/语音流写入PCM数据 (48kHz/16位/立体声)
+     * @param stream AUDIO_MIXER_STREAM_MUSIC 或 AUDIO_MIXER_STREAM_VOICE
+     * @param data PCM数据
+     * @param len 字节数
+     * @param timeout_ms 缓冲区满时最长等待时间
+     * @return esp_err_t ESP_OK全部写入, ESP_ERR_TIMEOUT超时
+     */
+    esp_err_t audio_mixer_write(audio_mixer_stream_t stream, const void *data, size_t len, uint32_t timeout_ms);
+
+    /**
+     * @brief 丢弃某路流中尚未播放的数据 (停止/定位时使用)
+     * @param stream 流类型
+     * @return esp_err_t ESP_OK成功
+     */
+    esp_err_t audio_mixer_flush(audio_mixer_stream_t stream);
+
+    /**
+     * @brief 设置某路流的增益, 在ramp_ms内线性过渡
+     * @param stream 流类型
+     * @param gain 线性增益 0.0-1.0
+     * @param ramp_ms 过渡时间(毫秒), 0表示在下一块内完成
+     * @return esp_err_t ESP_OK成功
+     */
+    esp_err_t audio_mixer_set_gain(audio_mixer_stream_t stream, float gain, uint32_t ramp_ms);
+
+    /**
+     * @brief 从WAV文件预加载音效到PSRAM
+     * @details 支持16位PCM, 单声道会展开为立体声, 非48kHz会在加载时线性重采样。
+     *          可以在混音器运行期间从任意任务调用, 与播放和其他加载并发安全; 音效加入后不能卸载
+     * @param path WAV文件路径 (如 "/spiffs/click.wav")
+     * @param name 音效名称 (用于audio_mixer_effect_find), 最多AUDIO_MIXER_EFFECT_NAME_MAX - 1字节
+     * @param out_id 输出音效ID, 可为NULL
+     * @return esp_err_t ESP_OK成功, ESP_ERR_INVALID_ARG名称过长, ESP_ERR_NO_MEM数量已达上限或内存不足
+     */
+    esp_err_t audio_mixer_effect_load(const char *path, const char *name, int *out_id);
+
+    /**
+     * @brief 注册已在内存中的音效, 不拷贝数据 (例如资源包映射的flash)
+     * @note 与audio_mixer_effect_load相同, 运行期间从任意任务调用都是安全的
+     * @param name 音效名称, 最多AUDIO_MIXER_EFFECT_NAME_MAX - 1字节
+     * @param pcm 48kHz/16位立体声PCM, 按AUDIO_DSP_ALIGN对齐, 混音器使用期间必须一直有效
+     * @param frames 帧数, 必须是AUDIO_MIXER_BLOCK_FRAMES的整数倍
+     * @param out_id 输出音效ID, 可为NULL
+     * @return esp_err_t ESP_OK成功, ESP_ERR_INVALID_ARG未对齐、长度不是整块或名称过长, ESP_ERR_NO_MEM数量已达上限
+     */
+    esp_err_t audio_mixer_effect_register(const char *name, const int16_t *pcm, uint32_t frames, int *out_id);
+
+    /**
+     * @brief 按名称查找已加载的音效
+     * @return 音效ID, 未找到返回-1
+     */
+    int audio_mixer_effect_find(const char *name);
+
+    /**
+     * @brief 触发音效播放 (不阻塞, 不做文件I/O)
+     * @param id 音效ID
+     * @param gain 线性增益 0.0-1.0
+     * @return esp_err_t ESP_OK成功, ESP_ERR_NOT_FOUND ID无效
+     */
+    esp_err_t audio_mixer_effect_play(int id, float gain);
+
+    /**
+     * @brief 设置输出EQ
+     * @details 系数在调用者任务中计算, 混音任务在下一个块内交叉淡化到新系数, 不会产生爆音。
+     *          有提升的配置会自动降低前级增益, 避免削波。
+     * @param eq EQ配置
+     * @return esp_err_t ESP_OK成功, ESP_ERR_INVALID_ARG参数无效
+     */
+    esp_err_t audio_mixer_set_eq(const audio_mixer_eq_t *eq);
+
+    /**
+     * @brief 获取当前输出EQ配置
+     */
+    void audio_mixer_get_eq(audio_mixer_eq_t *eq);
+
+    /**
+     * @brief 注册输出监听回调, 每个混音块调用一次
+     * @param cb 回调, NULL表示取消
+     * @param ctx 用户参数
+     * @return esp_err_t ESP_OK成功
+     */
+    esp_err_t audio_mixer_set_tap(audio_mixer_tap_cb_t cb, void *ctx);
+
+    /**
+     * @brief 获取混音器统计信息
+     */
+    void audio_mixer_get_stats(audio_mixer_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_MIXER_H
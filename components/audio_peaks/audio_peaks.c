@@ -0,0 +1,738 @@
+/**
+ * @file audio_peaks.c
+ * @brief 峰值文件的生成与读取
+ * @details 写入端只认WAV data块中的原始字节: 16位PCM逐帧统计, IMA-ADPCM按块解码后统计,
+ *          录音写入任务和从已有文件生成共用同一条路径, 两者得到的峰值文件完全相同。
+ *          所有读写都经过sd_manager的I/O调度: 录音时按录音类别写入, 生成按后台类别读写,
+ *          显示按界面类别读取, 都不会挡住音频流的读取。
+ */
+
+#include "audio_peaks.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "audio_dsp_adpcm.h"
+
+static const char *TAG = "audio_peaks";
+
+#define PEAKS_MAGIC "PEAK"
+#define PEAKS_VERSION (1)
+#define PEAKS_WAV_HEAD_BYTES (4096) // 解析WAV时读取的文件头长度, data块必须在其中开始
+#define PEAKS_LEVEL_INIT_CAP (256)  // 高级别数组的初始容量 (桶数)
+
+/**
+ * @brief 文件头 (小端, 全部4字节对齐)
+ */
+typedef struct
+{
+    char magic[4];   // 关闭时才写入, 未完成的文件无效
+    uint16_t version;
+    uint16_t levels;
+    uint32_t sample_rate;
+    uint32_t total_samples;
+    uint32_t data_bytes;
+    uint32_t base_samples;
+    uint32_t factor;
+    uint32_t offset[AUDIO_PEAKS_LEVELS]; // 各级在文件中的偏移
+    uint32_t count[AUDIO_PEAKS_LEVELS];  // 各级的桶数, 每桶2字节(min, max)
+} peaks_header_t;
+
+struct audio_peaks_writer
+{
+    sd_manager_file_t *file;
+    sd_manager_io_class_t io_class;
+    uint32_t offset; // 第0级下一次写入的位置
+    char *path;
+    audio_peaks_source_t src;
+    uint32_t total_samples;
+    bool io_error;
+
+    // 跨调用的不完整帧/ADPCM块
+    size_t unit;
+    size_t carry_len;
+    uint8_t *carry;
+    int16_t *pcm; // ADPCM解码输出
+
+    // 各级正在累计的桶: 第0级按采样计数, 更高级按下一级的桶计数
+    uint32_t acc_n[AUDIO_PEAKS_LEVELS];
+    int16_t acc_min[AUDIO_PEAKS_LEVELS];
+    int16_t acc_max[AUDIO_PEAKS_LEVELS];
+    uint32_t count[AUDIO_PEAKS_LEVELS];
+
+    // 第0级写入缓冲, 更高级别在内存中累计到关闭
+    int8_t buf0[AUDIO_PEAKS_WRITE_BUF];
+    size_t buf0_len;
+    int8_t *level[AUDIO_PEAKS_LEVELS];
+    size_t level_cap[AUDIO_PEAKS_LEVELS];
+};
+
+struct audio_peaks
+{
+    sd_manager_file_t *file;
+    peaks_header_t hdr;
+    int8_t *buf;
+    size_t buf_cap; // 字节
+};
+
+/* ---------- WAV解析 ---------- */
+
+typedef struct
+{
+    audio_peaks_source_t src;
+    uint32_t data_offset;
+    uint32_t data_size; // WAV头中的原始值
+} peaks_wav_t;
+
+static uint16_t peaks_rd16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t peaks_rd32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief 读取WAV文件头, 找到fmt和data块
+ */
+static esp_err_t peaks_parse_wav(sd_manager_file_t *f, sd_manager_io_class_t io_class, peaks_wav_t *wav)
+{
+    uint8_t *head = malloc(PEAKS_WAV_HEAD_BYTES);
+    if (head == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    size_t len = 0;
+    esp_err_t ret = sd_manager_file_read(f, 0, head, PEAKS_WAV_HEAD_BYTES, io_class, &len);
+    if (ret != ESP_OK)
+    {
+        free(head);
+        return ret;
+    }
+    ret = ESP_ERR_NOT_SUPPORTED;
+    bool have_fmt = false;
+
+    if (len >= 12 && memcmp(head, "RIFF", 4) == 0 && memcmp(head + 8, "WAVE", 4) == 0)
+    {
+        size_t pos = 12;
+        while (pos + 8 <= len)
+        {
+            const uint8_t *chunk = head + pos;
+            uint32_t size = peaks_rd32(chunk + 4);
+            if (memcmp(chunk, "data", 4) == 0)
+            {
+                wav->data_offset = pos + 8;
+                wav->data_size = size;
+                ret = have_fmt ? ESP_OK : ESP_ERR_NOT_SUPPORTED;
+                break;
+            }
+            if (size > len - pos - 8)
+            {
+                break;
+            }
+            if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16)
+            {
+                wav->src.format = peaks_rd16(chunk + 8);
+                wav->src.channels = peaks_rd16(chunk + 10);
+                wav->src.sample_rate = peaks_rd32(chunk + 12);
+                wav->src.block_align = peaks_rd16(chunk + 20);
+                have_fmt = true;
+            }
+            pos += 8 + size + (size & 1);
+        }
+    }
+    free(head);
+    return ret;
+}
+
+static bool peaks_source_supported(const audio_peaks_source_t *src)
+{
+    if (src->channels < 1 || src->channels > 2 || src->sample_rate == 0)
+    {
+        return false;
+    }
+    if (src->format == AUDIO_PEAKS_FORMAT_PCM16)
+    {
+        return true;
+    }
+    return src->format == AUDIO_PEAKS_FORMAT_IMA_ADPCM && src->block_align > 4u * src->channels &&
+           src->block_align <= AUDIO_PEAKS_MAX_BLOCK;
+}
+
+/* ---------- 写入 ---------- */
+
+static void peaks_flush_level0(audio_peaks_writer_t *w)
+{
+    if (w->buf0_len > 0 && !w->io_error)
+    {
+        if (sd_manager_file_write(w->file, w->offset, w->buf0, w->buf0_len, w->io_class) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "写入峰值文件失败");
+            w->io_error = true;
+        }
+        w->offset += w->buf0_len;
+    }
+    w->buf0_len = 0;
+}
+
+static void peaks_acc_reset(audio_peaks_writer_t *w, int level)
+{
+    w->acc_n[level] = 0;
+    w->acc_min[level] = INT16_MAX;
+    w->acc_max[level] = INT16_MIN;
+}
+
+/**
+ * @brief 输出一个完整的桶, 并计入上一级
+ */
+static void peaks_emit(audio_peaks_writer_t *w, int level, int8_t mn, int8_t mx)
+{
+    if (level == 0)
+    {
+        w->buf0[w->buf0_len++] = mn;
+        w->buf0[w->buf0_len++] = mx;
+        if (w->buf0_len == AUDIO_PEAKS_WRITE_BUF)
+        {
+            peaks_flush_level0(w);
+        }
+    }
+    else
+    {
+        size_t need = 2 * ((size_t)w->count[level] + 1);
+        if (need > w->level_cap[level])
+        {
+            size_t cap = w->level_cap[level] ? w->level_cap[level] * 2 : 2 * PEAKS_LEVEL_INIT_CAP;
+            int8_t *grown = heap_caps_realloc(w->level[level], cap, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            if (grown == NULL)
+            {
+                grown = realloc(w->level[level], cap);
+            }
+            if (grown == NULL)
+            {
+                w->io_error = true; // 内存不足, 峰值文件作废
+                return;
+            }
+            w->level[level] = grown;
+            w->level_cap[level] = cap;
+        }
+        w->level[level][2 * w->count[level]] = mn;
+        w->level[level][2 * w->count[level] + 1] = mx;
+    }
+    w->count[level]++;
+
+    int up = level + 1;
+    if (up < AUDIO_PEAKS_LEVELS)
+    {
+        w->acc_min[up] = mn < w->acc_min[up] ? mn : w->acc_min[up];
+        w->acc_max[up] = mx > w->acc_max[up] ? mx : w->acc_max[up];
+        if (++w->acc_n[up] == AUDIO_PEAKS_LEVEL_FACTOR)
+        {
+            int8_t umn = (int8_t)w->acc_min[up];
+            int8_t umx = (int8_t)w->acc_max[up];
+            peaks_acc_reset(w, up);
+            peaks_emit(w, up, umn, umx);
+        }
+    }
+}
+
+/**
+ * @brief 第0级的桶满或结束时输出 (16位 -> 8位)
+ */
+static void peaks_emit_level0(audio_peaks_writer_t *w)
+{
+    int8_t mn = (int8_t)(w->acc_min[0] >> 8);
+    int8_t mx = (int8_t)(w->acc_max[0] >> 8);
+    peaks_acc_reset(w, 0);
+    peaks_emit(w, 0, mn, mx);
+}
+
+/**
+ * @brief 统计交织PCM, 立体声两个声道合并
+ */
+static void peaks_add_pcm(audio_peaks_writer_t *w, const int16_t *pcm, size_t frames)
+{
+    const size_t ch = w->src.channels;
+    for (size_t i = 0; i < frames; i++)
+    {
+        for (size_t c = 0; c < ch; c++)
+        {
+            int16_t v = pcm[i * ch + c];
+            w->acc_min[0] = v < w->acc_min[0] ? v : w->acc_min[0];
+            w->acc_max[0] = v > w->acc_max[0] ? v : w->acc_max[0];
+        }
+        if (++w->acc_n[0] == AUDIO_PEAKS_BASE_SAMPLES)
+        {
+            peaks_emit_level0(w);
+        }
+    }
+    w->total_samples += frames;
+}
+
+/**
+ * @brief 统计原始字节中的PCM帧 (输入不保证对齐, 按字节读取)
+ */
+static void peaks_add_pcm_bytes(audio_peaks_writer_t *w, const uint8_t *p, size_t frames)
+{
+    const size_t ch = w->src.channels;
+    for (size_t i = 0; i < frames; i++)
+    {
+        int16_t v[2];
+        for (size_t c = 0; c < ch; c++)
+        {
+            v[c] = (int16_t)peaks_rd16(p + 2 * (i * ch + c));
+        }
+        peaks_add_pcm(w, v, 1);
+    }
+}
+
+/**
+ * @brief 处理若干完整单位 (PCM帧或ADPCM块)
+ */
+static void peaks_add_units(audio_peaks_writer_t *w, const uint8_t *p, size_t units)
+{
+    if (w->src.format == AUDIO_PEAKS_FORMAT_PCM16)
+    {
+        peaks_add_pcm_bytes(w, p, units);
+        return;
+    }
+    for (size_t i = 0; i < units; i++)
+    {
+        size_t frames = audio_dsp_adpcm_decode_block(p + i * w->unit, w->unit, w->src.channels, w->pcm);
+        peaks_add_pcm(w, w->pcm, frames);
+    }
+}
+
+esp_err_t audio_peaks_writer_open(const char *peak_path, const audio_peaks_source_t *src, sd_manager_io_class_t io_class,
+                                  audio_peaks_writer_t **out)
+{
+    if (peak_path == NULL || src == NULL || out == NULL || !peaks_source_supported(src) ||
+        (unsigned)io_class >= SD_MANAGER_CLASS_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_peaks_writer_t *w = heap_caps_calloc(1, sizeof(audio_peaks_writer_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (w == NULL)
+    {
+        w = calloc(1, sizeof(audio_peaks_writer_t));
+    }
+    if (w == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    w->src = *src;
+    w->io_class = io_class;
+    w->unit = src->format == AUDIO_PEAKS_FORMAT_PCM16 ? 2u * src->channels : src->block_align;
+    w->carry = malloc(w->unit);
+    w->path = strdup(peak_path);
+    if (src->format == AUDIO_PEAKS_FORMAT_IMA_ADPCM)
+    {
+        w->pcm = malloc(AUDIO_DSP_ADPCM_FRAMES_PER_BLOCK(src->block_align, src->channels) * src->channels * sizeof(int16_t));
+    }
+    if (w->carry == NULL || w->path == NULL || (src->format == AUDIO_PEAKS_FORMAT_IMA_ADPCM && w->pcm == NULL))
+    {
+        audio_peaks_writer_close(w, 0, false);
+        return ESP_ERR_NO_MEM;
+    }
+    for (int l = 0; l < AUDIO_PEAKS_LEVELS; l++)
+    {
+        peaks_acc_reset(w, l);
+    }
+
+    // 覆盖已有文件; 文件头先占位(全零, magic无效), 关闭时回写
+    peaks_header_t hdr = {0};
+    if (sd_manager_file_open(peak_path, true, &w->file) != ESP_OK || sd_manager_file_truncate(w->file, 0) != ESP_OK ||
+        sd_manager_file_write(w->file, 0, &hdr, sizeof(hdr), io_class) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "无法创建峰值文件: %s", peak_path);
+        audio_peaks_writer_close(w, 0, false);
+        return ESP_FAIL;
+    }
+    w->offset = sizeof(hdr);
+
+    *out = w;
+    return ESP_OK;
+}
+
+void audio_peaks_writer_feed(audio_peaks_writer_t *w, const void *data, size_t len)
+{
+    if (w == NULL || data == NULL)
+    {
+        return;
+    }
+    const uint8_t *p = data;
+
+    // 1. 先补齐上次剩下的不完整单位
+    if (w->carry_len > 0)
+    {
+        size_t take = w->unit - w->carry_len;
+        take = take < len ? take : len;
+        memcpy(w->carry + w->carry_len, p, take);
+        w->carry_len += take;
+        p += take;
+        len -= take;
+        if (w->carry_len < w->unit)
+        {
+            return;
+        }
+        peaks_add_units(w, w->carry, 1);
+        w->carry_len = 0;
+    }
+
+    // 2. 完整单位直接处理, 剩余部分留到下次
+    size_t units = len / w->unit;
+    peaks_add_units(w, p, units);
+    p += units * w->unit;
+    len -= units * w->unit;
+    memcpy(w->carry, p, len);
+    w->carry_len = len;
+}
+
+esp_err_t audio_peaks_writer_close(audio_peaks_writer_t *w, uint32_t data_bytes, bool commit)
+{
+    if (w == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_OK;
+    if (commit && w->file != NULL)
+    {
+        // 1. 文件末尾不完整的ADPCM块 (录音结尾补齐过, 一般不会出现)
+        if (w->src.format == AUDIO_PEAKS_FORMAT_IMA_ADPCM && w->carry_len > 4u * w->src.channels)
+        {
+            size_t frames = audio_dsp_adpcm_decode_block(w->carry, w->carry_len, w->src.channels, w->pcm);
+            peaks_add_pcm(w, w->pcm, frames);
+        }
+
+        // 2. 各级不满的最后一桶
+        if (w->acc_n[0] > 0)
+        {
+            peaks_emit_level0(w);
+        }
+        for (int l = 1; l < AUDIO_PEAKS_LEVELS; l++)
+        {
+            if (w->acc_n[l] > 0)
+            {
+                int8_t mn = (int8_t)w->acc_min[l];
+                int8_t mx = (int8_t)w->acc_max[l];
+                peaks_acc_reset(w, l);
+                peaks_emit(w, l, mn, mx);
+            }
+        }
+        peaks_flush_level0(w);
+
+        // 3. 追加高级别并回写文件头
+        peaks_header_t hdr = {
+            .version = PEAKS_VERSION,
+            .levels = AUDIO_PEAKS_LEVELS,
+            .sample_rate = w->src.sample_rate,
+            .total_samples = w->total_samples,
+            .data_bytes = data_bytes,
+            .base_samples = AUDIO_PEAKS_BASE_SAMPLES,
+            .factor = AUDIO_PEAKS_LEVEL_FACTOR,
+        };
+        uint32_t offset = sizeof(hdr);
+        for (int l = 0; l < AUDIO_PEAKS_LEVELS; l++)
+        {
+            hdr.offset[l] = offset;
+            hdr.count[l] = w->count[l];
+            offset += 2 * w->count[l];
+            if (l > 0 && w->count[l] > 0 && !w->io_error &&
+                sd_manager_file_write(w->file, hdr.offset[l], w->level[l], 2 * w->count[l], w->io_class) != ESP_OK)
+            {
+                w->io_error = true;
+            }
+        }
+        memcpy(hdr.magic, PEAKS_MAGIC, 4);
+        if (!w->io_error && sd_manager_file_write(w->file, 0, &hdr, sizeof(hdr), w->io_class) != ESP_OK)
+        {
+            w->io_error = true;
+        }
+        ret = w->io_error ? ESP_FAIL : ESP_OK;
+    }
+
+    // 关闭和删除都会使目录列表缓存失效
+    bool created = w->file != NULL;
+    if (created && sd_manager_file_close(w->file) != ESP_OK)
+    {
+        ret = ESP_FAIL;
+    }
+    if (created && (!commit || ret != ESP_OK))
+    {
+        sd_manager_delete_file(w->path);
+    }
+    if (commit && ret == ESP_OK)
+    {
+        ESP_LOGI(TAG, "峰值文件已保存: %s, %lu 采样, 第0级 %lu 桶", w->path, (unsigned long)w->total_samples,
+                 (unsigned long)w->count[0]);
+    }
+
+    for (int l = 0; l < AUDIO_PEAKS_LEVELS; l++)
+    {
+        heap_caps_free(w->level[l]);
+    }
+    free(w->carry);
+    free(w->pcm);
+    free(w->path);
+    heap_caps_free(w);
+    return ret;
+}
+
+/* ---------- 从WAV生成 ---------- */
+
+bool audio_peaks_path(const char *wav_path, char *out, size_t out_len)
+{
+    if (wav_path == NULL || out == NULL)
+    {
+        return false;
+    }
+    const char *dot = strrchr(wav_path, '.');
+    const char *slash = strrchr(wav_path, '/');
+    size_t base = (dot != NULL && (slash == NULL || dot > slash)) ? (size_t)(dot - wav_path) : strlen(wav_path);
+    int n = snprintf(out, out_len, "%.*s%s", (int)base, wav_path, AUDIO_PEAKS_EXT);
+    return n > 0 && (size_t)n < out_len;
+}
+
+esp_err_t audio_peaks_generate(const char *wav_path)
+{
+    char peak_path[160];
+    if (!audio_peaks_path(wav_path, peak_path, sizeof(peak_path)))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sd_manager_file_t *f = NULL;
+    if (sd_manager_file_open(wav_path, false, &f) != ESP_OK)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    peaks_wav_t wav = {0};
+    esp_err_t ret = peaks_parse_wav(f, SD_MANAGER_CLASS_BACKGROUND, &wav);
+    if (ret == ESP_OK && !peaks_source_supported(&wav.src))
+    {
+        ret = ESP_ERR_NOT_SUPPORTED;
+    }
+
+    uint8_t *chunk = NULL;
+    audio_peaks_writer_t *w = NULL;
+    if (ret == ESP_OK)
+    {
+        chunk = sd_manager_alloc_io_buffer(AUDIO_PEAKS_GEN_CHUNK);
+        ret = chunk != NULL ? audio_peaks_writer_open(peak_path, &wav.src, SD_MANAGER_CLASS_BACKGROUND, &w) : ESP_ERR_NO_MEM;
+    }
+
+    if (ret == ESP_OK)
+    {
+        // 未正常结束的录音data长度为0, 读到文件末尾
+        uint32_t remaining = wav.data_size != 0 ? wav.data_size : UINT32_MAX;
+        uint32_t offset = wav.data_offset;
+        while (remaining > 0)
+        {
+            size_t want = remaining < AUDIO_PEAKS_GEN_CHUNK ? remaining : AUDIO_PEAKS_GEN_CHUNK;
+            size_t got = 0;
+            if (sd_manager_file_read(f, offset, chunk, want, SD_MANAGER_CLASS_BACKGROUND, &got) != ESP_OK || got == 0)
+            {
+                break;
+            }
+            audio_peaks_writer_feed(w, chunk, got);
+            offset += got;
+            remaining -= got;
+        }
+        ret = audio_peaks_writer_close(w, wav.data_size, true);
+    }
+
+    free(chunk);
+    sd_manager_file_close(f);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGW(TAG, "生成峰值文件失败: %s (%s)", wav_path, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/* ---------- 读取 ---------- */
+
+/**
+ * @brief 读取并校验峰值文件头
+ */
+static bool peaks_read_header(sd_manager_file_t *f, peaks_header_t *hdr)
+{
+    size_t got = 0;
+    if (sd_manager_file_read(f, 0, hdr, sizeof(*hdr), SD_MANAGER_CLASS_UI, &got) != ESP_OK || got != sizeof(*hdr))
+    {
+        return false;
+    }
+    return memcmp(hdr->magic, PEAKS_MAGIC, 4) == 0 && hdr->version == PEAKS_VERSION &&
+           hdr->levels == AUDIO_PEAKS_LEVELS && hdr->base_samples == AUDIO_PEAKS_BASE_SAMPLES &&
+           hdr->factor == AUDIO_PEAKS_LEVEL_FACTOR;
+}
+
+/**
+ * @brief 打开并校验与WAV一致的峰值文件 (按界面类别读取, 显示时调用)
+ * @return 文件句柄; 无效时为NULL
+ */
+static sd_manager_file_t *peaks_open_checked(const char *wav_path, peaks_header_t *hdr)
+{
+    char peak_path[160];
+    if (!audio_peaks_path(wav_path, peak_path, sizeof(peak_path)))
+    {
+        return NULL;
+    }
+
+    sd_manager_file_t *wf = NULL;
+    if (sd_manager_file_open(wav_path, false, &wf) != ESP_OK)
+    {
+        return NULL;
+    }
+    peaks_wav_t wav = {0};
+    esp_err_t ret = peaks_parse_wav(wf, SD_MANAGER_CLASS_UI, &wav);
+    sd_manager_file_close(wf);
+    if (ret != ESP_OK)
+    {
+        return NULL;
+    }
+
+    sd_manager_file_t *f = NULL;
+    if (sd_manager_file_open(peak_path, false, &f) != ESP_OK)
+    {
+        return NULL;
+    }
+    if (!peaks_read_header(f, hdr) || hdr->data_bytes != wav.data_size || hdr->sample_rate != wav.src.sample_rate)
+    {
+        sd_manager_file_close(f);
+        return NULL;
+    }
+    return f;
+}
+
+bool audio_peaks_is_valid(const char *wav_path)
+{
+    peaks_header_t hdr;
+    sd_manager_file_t *f = peaks_open_checked(wav_path, &hdr);
+    if (f == NULL)
+    {
+        return false;
+    }
+    sd_manager_file_close(f);
+    return true;
+}
+
+esp_err_t audio_peaks_open(const char *wav_path, audio_peaks_t **out)
+{
+    if (wav_path == NULL || out == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    audio_peaks_t *p = calloc(1, sizeof(audio_peaks_t));
+    if (p == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    p->file = peaks_open_checked(wav_path, &p->hdr);
+    if (p->file == NULL)
+    {
+        free(p);
+        return ESP_ERR_INVALID_STATE;
+    }
+    *out = p;
+    return ESP_OK;
+}
+
+void audio_peaks_get_info(const audio_peaks_t *p, audio_peaks_info_t *info)
+{
+    if (p == NULL || info == NULL)
+    {
+        return;
+    }
+    info->sample_rate = p->hdr.sample_rate;
+    info->total_samples = p->hdr.total_samples;
+    info->data_bytes = p->hdr.data_bytes;
+    memcpy(info->level_count, p->hdr.count, sizeof(info->level_count));
+}
+
+esp_err_t audio_peaks_read(audio_peaks_t *p, uint32_t start_sample, uint32_t samples_per_col, size_t cols,
+                           int8_t *min, int8_t *max)
+{
+    if (p == NULL || min == NULL || max == NULL || samples_per_col == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(min, 0, cols);
+    memset(max, 0, cols);
+
+    // 1. 选择桶不大于每列采样数的最粗一级
+    int level = 0;
+    uint64_t bucket = AUDIO_PEAKS_BASE_SAMPLES;
+    while (level + 1 < AUDIO_PEAKS_LEVELS && bucket * AUDIO_PEAKS_LEVEL_FACTOR <= samples_per_col)
+    {
+        bucket *= AUDIO_PEAKS_LEVEL_FACTOR;
+        level++;
+    }
+    uint32_t count = p->hdr.count[level];
+    uint64_t first = start_sample / bucket;
+    uint64_t end = (start_sample + (uint64_t)samples_per_col * cols + bucket - 1) / bucket;
+    end = end < count ? end : count;
+    if (cols == 0 || first >= end)
+    {
+        return ESP_OK; // 全部在录音结束之后
+    }
+
+    // 2. 一次读取覆盖范围内的所有桶
+    size_t bytes = (size_t)(end - first) * 2;
+    if (bytes > p->buf_cap)
+    {
+        int8_t *grown = realloc(p->buf, bytes);
+        if (grown == NULL)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+        p->buf = grown;
+        p->buf_cap = bytes;
+    }
+    size_t got = 0;
+    uint32_t offset = p->hdr.offset[level] + (uint32_t)first * 2;
+    if (sd_manager_file_read(p->file, offset, p->buf, bytes, SD_MANAGER_CLASS_UI, &got) != ESP_OK || got != bytes)
+    {
+        return ESP_FAIL;
+    }
+
+    // 3. 合并到各列
+    for (size_t c = 0; c < cols; c++)
+    {
+        uint64_t s0 = start_sample + (uint64_t)samples_per_col * c;
+        uint64_t b0 = s0 / bucket;
+        uint64_t b1 = (s0 + samples_per_col + bucket - 1) / bucket;
+        b1 = b1 < end ? b1 : end;
+        if (b0 >= b1)
+        {
+            continue;
+        }
+        int8_t mn = INT8_MAX;
+        int8_t mx = INT8_MIN;
+        for (uint64_t b = b0; b < b1; b++)
+        {
+            const int8_t *pair = &p->buf[(b - first) * 2];
+            mn = pair[0] < mn ? pair[0] : mn;
+            mx = pair[1] > mx ? pair[1] : mx;
+        }
+        min[c] = mn;
+        max[c] = mx;
+    }
+    return ESP_OK;
+}
+
+void audio_peaks_close(audio_peaks_t *p)
+{
+    if (p == NULL)
+    {
+        return;
+    }
+    sd_manager_file_close(p->file);
+    free(p->buf);
+    free(p);
+}
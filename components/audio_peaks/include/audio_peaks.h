@@ -0,0 +1,147 @@
+/**
+ * @file audio_peaks.h
+ * @brief 录音波形的峰值文件 (多级min/max)
+ * @details 每个WAV旁边保存一个同名的.pk文件, 按固定采样数分桶记录8位的最小/最大值,
+ *          共AUDIO_PEAKS_LEVELS级, 每级的桶比上一级大AUDIO_PEAKS_LEVEL_FACTOR倍。
+ *          波形显示按缩放倍数选择合适的级别, 只读取可见范围内的几KB峰值, 从不读取音频数据。
+ *
+ *          文件布局: 文件头 | 第0级 | 第1级 | ... 第0级在写入时流式追加, 更高级别在内存中累计,
+ *          关闭时追加到文件末尾并回写文件头。文件头的magic在关闭时才写入,
+ *          录音中途掉电的峰值文件不会被当作有效文件, 下次打开时从WAV重新生成。
+ */
+
+#ifndef AUDIO_PEAKS_H
+#define AUDIO_PEAKS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sd_manager.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define AUDIO_PEAKS_LEVELS (4)            // 级数
+#define AUDIO_PEAKS_BASE_SAMPLES (256)    // 第0级每桶的采样数 (16kHz时16ms)
+#define AUDIO_PEAKS_LEVEL_FACTOR (8)      // 相邻两级的桶大小之比: 256, 2048, 16384, 131072
+#define AUDIO_PEAKS_EXT ".pk"             // 峰值文件扩展名, 替换WAV的扩展名
+#define AUDIO_PEAKS_WRITE_BUF (4096)      // 第0级写入缓冲 (字节)
+#define AUDIO_PEAKS_GEN_CHUNK (16 * 1024) // 从WAV生成时每次读取的字节数
+#define AUDIO_PEAKS_MAX_BLOCK (4096)      // 支持的最大ADPCM块
+
+#define AUDIO_PEAKS_FORMAT_PCM16 (0x0001)     // WAV格式码: 16位PCM
+#define AUDIO_PEAKS_FORMAT_IMA_ADPCM (0x0011) // WAV格式码: IMA-ADPCM
+
+    /**
+     * @brief 峰值数据来源的音频格式
+     */
+    typedef struct
+    {
+        uint16_t format;      // AUDIO_PEAKS_FORMAT_xxx
+        uint16_t channels;    // 1或2, 立体声的两个声道合并统计
+        uint32_t sample_rate;
+        uint16_t block_align; // ADPCM块字节数 (PCM不使用)
+    } audio_peaks_source_t;
+
+    /**
+     * @brief 峰值文件信息
+     */
+    typedef struct
+    {
+        uint32_t sample_rate;
+        uint32_t total_samples;               // 每声道采样数
+        uint32_t data_bytes;                  // 生成时WAV data块的字节数, 用于判断峰值文件是否过期
+        uint32_t level_count[AUDIO_PEAKS_LEVELS]; // 各级的桶数
+    } audio_peaks_info_t;
+
+    typedef struct audio_peaks_writer audio_peaks_writer_t;
+    typedef struct audio_peaks audio_peaks_t;
+
+    /**
+     * @brief 由WAV路径得到峰值文件路径 (替换扩展名)
+     * @return true 成功, false 缓冲区不足
+     */
+    bool audio_peaks_path(const char *wav_path, char *out, size_t out_len);
+
+    /**
+     * @brief 开始写入峰值文件 (已存在时覆盖)
+     * @param peak_path 峰值文件路径
+     * @param src 输入数据的格式
+     * @param io_class 写入请求的类别: 录音时SD_MANAGER_CLASS_RECORD, 从WAV生成时SD_MANAGER_CLASS_BACKGROUND
+     * @param out 输出写入句柄
+     * @return esp_err_t ESP_OK成功, ESP_ERR_INVALID_ARG格式不支持, ESP_ERR_NO_MEM, ESP_FAIL无法创建文件
+     */
+    esp_err_t audio_peaks_writer_open(const char *peak_path, const audio_peaks_source_t *src, sd_manager_io_class_t io_class,
+                                      audio_peaks_writer_t **out);
+
+    /**
+     * @brief 送入一段WAV data块中的原始字节 (可以在任意字节处分段, 不完整的帧/ADPCM块留到下次)
+     * @note 只做比较和累计, 第0级缓冲满时写一次文件
+     */
+    void audio_peaks_writer_feed(audio_peaks_writer_t *w, const void *data, size_t len);
+
+    /**
+     * @brief 结束写入并释放句柄
+     * @param w 写入句柄
+     * @param data_bytes WAV data块的最终字节数, 记入文件头
+     * @param commit false时删除峰值文件 (录音失败)
+     * @return esp_err_t ESP_OK成功
+     */
+    esp_err_t audio_peaks_writer_close(audio_peaks_writer_t *w, uint32_t data_bytes, bool commit);
+
+    /**
+     * @brief 从WAV文件生成峰值文件 (读取整个data块, 耗时与文件长度成正比, 不要在UI任务中调用)
+     * @note 读写都是SD_MANAGER_CLASS_BACKGROUND请求, 不挡住音频读取和录音写入
+     * @param wav_path WAV路径, 支持16位PCM和IMA-ADPCM, 单声道或立体声
+     * @return esp_err_t ESP_OK成功, ESP_ERR_NOT_SUPPORTED格式不支持
+     */
+    esp_err_t audio_peaks_generate(const char *wav_path);
+
+    /**
+     * @brief 检查WAV旁边的峰值文件是否有效且与WAV一致
+     * @return true 有效, 可以直接打开
+     */
+    bool audio_peaks_is_valid(const char *wav_path);
+
+    /**
+     * @brief 打开WAV对应的峰值文件用于显示
+     * @note 只读取文件头, 峰值文件无效时返回ESP_ERR_INVALID_STATE, 由调用者决定是否生成
+     * @param wav_path WAV路径
+     * @param out 输出句柄
+     * @return esp_err_t ESP_OK成功
+     */
+    esp_err_t audio_peaks_open(const char *wav_path, audio_peaks_t **out);
+
+    /**
+     * @brief 获取峰值文件信息
+     */
+    void audio_peaks_get_info(const audio_peaks_t *p, audio_peaks_info_t *info);
+
+    /**
+     * @brief 读取一段波形, 每个输出列对应samples_per_col个采样
+     * @details 选择桶不大于samples_per_col的最粗一级, 一次读取覆盖范围内的桶再合并到各列。
+     *          超出录音长度的列输出0
+     * @param p 峰值句柄
+     * @param start_sample 第一列的起始采样
+     * @param samples_per_col 每列的采样数 (缩放倍数)
+     * @param cols 列数
+     * @param min 输出各列最小值 (-128..127)
+     * @param max 输出各列最大值
+     * @return esp_err_t ESP_OK成功
+     */
+    esp_err_t audio_peaks_read(audio_peaks_t *p, uint32_t start_sample, uint32_t samples_per_col, size_t cols,
+                               int8_t *min, int8_t *max);
+
+    /**
+     * @brief 关闭峰值文件
+     */
+    void audio_peaks_close(audio_peaks_t *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_PEAKS_H
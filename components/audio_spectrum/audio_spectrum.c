@@ -0,0 +1,271 @@
+/**
+ * @file audio_spectrum.c
+ * @brief 播放音频的实时频谱分析实现
+ * @details 数据流:
+ *          混音任务 --(监听回调: 下混+抽取)--> 历史缓冲区 --(频谱任务: 加窗+FFT+分段)--> 单槽邮箱 --> UI
+ *          历史缓冲区和邮箱都是单生产者/单消费者, 只用原子计数器同步, 不加锁。
+ */
+
+#include "audio_spectrum.h"
+#include <string.h>
+#include <math.h>
+#include <stdatomic.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "audio_mixer.h"
+#include "audio_dsp_fft.h"
+
+static const char *TAG = "audio_spectrum";
+
+#define HISTORY_SIZE (1024) // 抽取后的历史采样数 (2的幂, 约85ms)
+#define HISTORY_MASK (HISTORY_SIZE - 1)
+#define DECIMATED_RATE (48000 / AUDIO_SPECTRUM_DECIMATION)
+#define MAILBOX_READ_RETRY (3)
+
+// 历史缓冲区: 混音任务写, 频谱任务读最近的FFT_POINTS个采样
+static int16_t s_history[HISTORY_SIZE];
+static atomic_uint s_history_count; // 已写入的采样总数
+static int32_t s_decim_acc = 0;     // 抽取累加器 (仅混音任务访问)
+static int s_decim_n = 0;
+
+// 单槽邮箱: 顺序锁, 计数为奇数表示正在写入
+static audio_spectrum_frame_t s_mailbox;
+static atomic_uint s_mailbox_lock;
+
+// 频谱任务私有数据
+static int16_t s_fft_buf[2 * AUDIO_SPECTRUM_FFT_POINTS];
+static int16_t s_twiddle[2 * AUDIO_SPECTRUM_FFT_POINTS];
+static int16_t s_window[AUDIO_SPECTRUM_FFT_POINTS];
+static uint16_t s_bin_lo[AUDIO_SPECTRUM_BARS]; // 每个频段的FFT bin范围 [lo, hi)
+static uint16_t s_bin_hi[AUDIO_SPECTRUM_BARS];
+static uint8_t s_levels[AUDIO_SPECTRUM_BARS];
+
+static TaskHandle_t s_task_handle = NULL;
+static volatile bool s_running = false;
+
+/**
+ * @brief 混音器监听回调: 立体声下混为单声道并做4倍抽取 (平均)
+ * @note 运行在混音任务中, 只做整数运算, 不阻塞
+ */
+static void spectrum_tap(const int16_t *pcm, size_t frames, void *ctx)
+{
+    unsigned count = atomic_load_explicit(&s_history_count, memory_order_relaxed);
+
+    for (size_t i = 0; i < frames; i++)
+    {
+        s_decim_acc += (int32_t)pcm[2 * i] + pcm[2 * i + 1];
+        if (++s_decim_n == AUDIO_SPECTRUM_DECIMATION)
+        {
+            s_history[count & HISTORY_MASK] = (int16_t)(s_decim_acc / (2 * AUDIO_SPECTRUM_DECIMATION));
+            count++;
+            s_decim_acc = 0;
+            s_decim_n = 0;
+        }
+    }
+
+    atomic_store_explicit(&s_history_count, count, memory_order_release);
+}
+
+/**
+ * @brief 计算各频段对应的FFT bin范围 (对数分布, 每段至少一个bin)
+ */
+static void spectrum_init_bins(void)
+{
+    const float bin_hz = (float)DECIMATED_RATE / AUDIO_SPECTRUM_FFT_POINTS;
+    const float max_hz = DECIMATED_RATE / 2.0f;
+    uint16_t prev_hi = 1;
+
+    for (int b = 0; b < AUDIO_SPECTRUM_BARS; b++)
+    {
+        float f_lo = AUDIO_SPECTRUM_MIN_HZ * powf(max_hz / AUDIO_SPECTRUM_MIN_HZ, (float)b / AUDIO_SPECTRUM_BARS);
+        float f_hi = AUDIO_SPECTRUM_MIN_HZ * powf(max_hz / AUDIO_SPECTRUM_MIN_HZ, (float)(b + 1) / AUDIO_SPECTRUM_BARS);
+        uint16_t lo = (uint16_t)lroundf(f_lo / bin_hz);
+        uint16_t hi = (uint16_t)lroundf(f_hi / bin_hz);
+
+        lo = lo < prev_hi ? prev_hi : lo;
+        hi = hi <= lo ? lo + 1 : hi;
+        if (hi > AUDIO_SPECTRUM_FFT_POINTS / 2)
+        {
+            hi = AUDIO_SPECTRUM_FFT_POINTS / 2;
+        }
+        if (lo >= hi)
+        {
+            lo = hi - 1;
+        }
+        s_bin_lo[b] = lo;
+        s_bin_hi[b] = hi;
+        prev_hi = hi;
+    }
+}
+
+/**
+ * @brief 发布一帧到邮箱 (写端不等待)
+ */
+static void mailbox_publish(const uint8_t *bars)
+{
+    unsigned lock = atomic_load_explicit(&s_mailbox_lock, memory_order_relaxed);
+    atomic_store_explicit(&s_mailbox_lock, lock + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    memcpy(s_mailbox.bars, bars, AUDIO_SPECTRUM_BARS);
+    s_mailbox.seq++;
+
+    atomic_store_explicit(&s_mailbox_lock, lock + 2, memory_order_release);
+}
+
+/**
+ * @brief 对最近的FFT_POINTS个采样做一次分析, 更新s_levels
+ */
+static void spectrum_analyze(unsigned count)
+{
+    // 1. 取最近的采样并加窗 (虚部清零)
+    unsigned start = count - AUDIO_SPECTRUM_FFT_POINTS;
+    for (int i = 0; i < AUDIO_SPECTRUM_FFT_POINTS; i++)
+    {
+        int32_t v = s_history[(start + i) & HISTORY_MASK];
+        s_fft_buf[2 * i] = (int16_t)((v * s_window[i]) >> 15);
+        s_fft_buf[2 * i + 1] = 0;
+    }
+
+    // 2. 定点基4 FFT
+    audio_dsp_fft_r4_s16(s_fft_buf, AUDIO_SPECTRUM_FFT_POINTS, s_twiddle);
+
+    // 3. 各频段取最大功率, 换算成0-100电平, 下降时限速形成"回落"效果
+    for (int b = 0; b < AUDIO_SPECTRUM_BARS; b++)
+    {
+        uint32_t peak = 0;
+        for (int k = s_bin_lo[b]; k < s_bin_hi[b]; k++)
+        {
+            int32_t re = s_fft_buf[2 * k];
+            int32_t im = s_fft_buf[2 * k + 1];
+            uint32_t power = (uint32_t)(re * re) + (uint32_t)(im * im);
+            peak = power > peak ? power : peak;
+        }
+
+        int level = 0;
+        if (peak > 0)
+        {
+            float db = 10.0f * log10f((float)peak);
+            level = (int)((db - (AUDIO_SPECTRUM_DB_TOP - AUDIO_SPECTRUM_DB_RANGE)) * 100.0f / AUDIO_SPECTRUM_DB_RANGE);
+            level = level < 0 ? 0 : (level > 100 ? 100 : level);
+        }
+
+        int fallen = (int)s_levels[b] - AUDIO_SPECTRUM_FALL_PER_FRAME;
+        s_levels[b] = (uint8_t)(level > fallen ? level : (fallen > 0 ? fallen : 0));
+    }
+}
+
+/**
+ * @brief 没有新数据时各频段回落
+ * @return true 还有非零的频段
+ */
+static bool spectrum_decay(void)
+{
+    bool active = false;
+    for (int b = 0; b < AUDIO_SPECTRUM_BARS; b++)
+    {
+        int fallen = (int)s_levels[b] - AUDIO_SPECTRUM_FALL_PER_FRAME;
+        s_levels[b] = (uint8_t)(fallen > 0 ? fallen : 0);
+        active |= s_levels[b] > 0;
+    }
+    return active;
+}
+
+static void spectrum_task(void *arg)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+    unsigned last_count = atomic_load_explicit(&s_history_count, memory_order_acquire);
+    bool published_silence = false;
+
+    while (s_running)
+    {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(AUDIO_SPECTRUM_FRAME_MS));
+
+        unsigned count = atomic_load_explicit(&s_history_count, memory_order_acquire);
+        if (count != last_count && count >= AUDIO_SPECTRUM_FFT_POINTS)
+        {
+            spectrum_analyze(count);
+            last_count = count;
+            published_silence = false;
+            mailbox_publish(s_levels);
+        }
+        else if (!published_silence)
+        {
+            // 混音器空闲(没有播放), 柱子回落到零后不再发布, UI不需要重绘
+            published_silence = !spectrum_decay();
+            mailbox_publish(s_levels);
+        }
+    }
+
+    s_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t audio_spectrum_start(void)
+{
+    if (s_running)
+    {
+        return ESP_OK;
+    }
+
+    audio_dsp_fft_r4_twiddle(s_twiddle, AUDIO_SPECTRUM_FFT_POINTS);
+    audio_dsp_window_hann_q15(s_window, AUDIO_SPECTRUM_FFT_POINTS);
+    spectrum_init_bins();
+    memset(s_levels, 0, sizeof(s_levels));
+    s_decim_acc = 0;
+    s_decim_n = 0;
+
+    s_running = true;
+    BaseType_t ret = xTaskCreatePinnedToCore(spectrum_task, "spectrum", 3072, NULL,
+                                             AUDIO_SPECTRUM_TASK_PRIORITY, &s_task_handle, AUDIO_SPECTRUM_TASK_CORE);
+    if (ret != pdPASS)
+    {
+        ESP_LOGE(TAG, "创建频谱任务失败");
+        s_running = false;
+        return ESP_FAIL;
+    }
+
+    audio_mixer_set_tap(spectrum_tap, NULL);
+    ESP_LOGI(TAG, "频谱分析启动: %d点FFT, %dHz, %d个频段", AUDIO_SPECTRUM_FFT_POINTS, DECIMATED_RATE, AUDIO_SPECTRUM_BARS);
+    return ESP_OK;
+}
+
+esp_err_t audio_spectrum_stop(void)
+{
+    audio_mixer_set_tap(NULL, NULL);
+    s_running = false;
+
+    // 等待频谱任务在下一个周期退出
+    for (int i = 0; i < 10 && s_task_handle != NULL; i++)
+    {
+        vTaskDelay(pdMS_TO_TICKS(AUDIO_SPECTRUM_FRAME_MS));
+    }
+    return ESP_OK;
+}
+
+bool audio_spectrum_read(audio_spectrum_frame_t *frame, uint32_t last_seq)
+{
+    if (frame == NULL)
+    {
+        return false;
+    }
+
+    for (int retry = 0; retry < MAILBOX_READ_RETRY; retry++)
+    {
+        unsigned before = atomic_load_explicit(&s_mailbox_lock, memory_order_acquire);
+        if (before & 1)
+        {
+            continue; // 正在写入
+        }
+
+        *frame = s_mailbox;
+        atomic_thread_fence(memory_order_acquire);
+
+        if (atomic_load_explicit(&s_mailbox_lock, memory_order_relaxed) == before)
+        {
+            return frame->seq != last_seq;
+        }
+    }
+    return false; // 读取期间一直被覆盖, 下次再取
+}
@@ -0,0 +1,67 @@
+/**
+ * @file audio_spectrum.h
+ * @brief 播放音频的实时频谱分析
+ * @details 通过混音器的输出监听回调取样: 混音任务中只做下混和4倍抽取后写入历史缓冲区,
+ *          频谱任务(核心0, 低优先级)定时对最近的采样加窗并做定点基4 FFT,
+ *          按对数频段汇总后写入单槽邮箱, 由UI任务随时读取最新一帧。
+ *          整个链路没有任何阻塞点, 音频路径不会等待UI。
+ */
+
+#ifndef AUDIO_SPECTRUM_H
+#define AUDIO_SPECTRUM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define AUDIO_SPECTRUM_BARS (16)          // 对数频段(柱)数量
+#define AUDIO_SPECTRUM_FFT_POINTS (256)   // FFT点数 (4的幂)
+#define AUDIO_SPECTRUM_DECIMATION (4)     // 48kHz抽取到12kHz, 分析范围0-6kHz
+#define AUDIO_SPECTRUM_FRAME_MS (33)      // 分析周期 (约30fps)
+#define AUDIO_SPECTRUM_MIN_HZ (60.0f)     // 第一个频段的下限
+#define AUDIO_SPECTRUM_DB_TOP (78.0f)     // 满刻度正弦对应的电平
+#define AUDIO_SPECTRUM_DB_RANGE (60.0f)   // 显示的动态范围
+#define AUDIO_SPECTRUM_FALL_PER_FRAME (4) // 柱高每帧最多下降量 (0-100刻度)
+#define AUDIO_SPECTRUM_TASK_PRIORITY (3)
+#define AUDIO_SPECTRUM_TASK_CORE (0)
+
+    /**
+     * @brief 一帧频谱
+     */
+    typedef struct
+    {
+        uint8_t bars[AUDIO_SPECTRUM_BARS]; // 各频段电平 0-100
+        uint32_t seq;                      // 帧序号, 每发布一帧加1
+    } audio_spectrum_frame_t;
+
+    /**
+     * @brief 启动频谱分析 (注册混音器监听并创建分析任务)
+     * @note 必须在audio_mixer_init()之后调用
+     * @return esp_err_t ESP_OK成功
+     */
+    esp_err_t audio_spectrum_start(void);
+
+    /**
+     * @brief 停止频谱分析
+     * @return esp_err_t ESP_OK成功
+     */
+    esp_err_t audio_spectrum_stop(void);
+
+    /**
+     * @brief 读取最新一帧 (不阻塞)
+     * @param frame 输出
+     * @param last_seq 调用者上次读到的帧序号, 用于判断是否有新帧 (首次传0)
+     * @return true 读到了比last_seq新的帧
+     */
+    bool audio_spectrum_read(audio_spectrum_frame_t *frame, uint32_t last_seq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_SPECTRUM_H
@@ -0,0 +1,438 @@
+/**
+ * @file boot_manager.c
+ * @brief 按依赖关系并行执行的分阶段启动
+ * @details 没有常驻的调度任务: boot_manager_start为没有依赖的阶段创建任务, 每个阶段结束时在自己的任务中
+ *          检查哪些阶段的依赖已全部结束, 为它们创建任务(或标记为跳过)。阶段i结束时置位事件组的bit i,
+ *          boot_manager_wait等待对应的位。s_entries在启动后只在s_lock下修改, 只有运行中的阶段自己的任务
+ *          写它的core和start_us。
+ */
+
+#include "boot_manager.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+
+static const char *TAG = "boot_manager";
+
+typedef struct
+{
+    boot_stage_t stage;
+    uint8_t dep_idx[BOOT_MANAGER_MAX_DEPS];
+    uint8_t dep_count;
+    boot_stage_state_t state;
+    esp_err_t err;
+    int core;
+    int64_t ready_us;
+    int64_t start_us;
+    int64_t end_us;
+} boot_entry_t;
+
+static boot_entry_t s_entries[BOOT_MANAGER_MAX_STAGES];
+static size_t s_count = 0;
+static bool s_started = false;
+static int64_t s_start_us = 0;
+static SemaphoreHandle_t s_lock = NULL;
+static EventGroupHandle_t s_done = NULL;
+
+static const char *s_state_names[] = {"waiting", "running", "ok", "FAILED", "skipped"};
+
+static int boot_find(const char *name)
+{
+    for (size_t i = 0; i < s_count; i++)
+    {
+        if (strcmp(s_entries[i].stage.name, name) == 0)
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static bool boot_finished(boot_stage_state_t state)
+{
+    return state == BOOT_STAGE_DONE || state == BOOT_STAGE_FAILED || state == BOOT_STAGE_SKIPPED;
+}
+
+static void boot_stage_task(void *arg);
+
+/**
+ * @brief 启动依赖已全部结束的阶段, 调用时持有s_lock
+ * @return EventBits_t 本次被跳过或创建任务失败(即已结束)的阶段
+ */
+static EventBits_t boot_dispatch_locked(void)
+{
+    EventBits_t finished = 0;
+    bool changed = true;
+    while (changed)
+    {
+        // 跳过一个阶段可能使依赖它的阶段也变为可判定, 反复扫描直到没有变化
+        changed = false;
+        for (size_t i = 0; i < s_count; i++)
+        {
+            boot_entry_t *e = &s_entries[i];
+            if (e->state != BOOT_STAGE_WAITING)
+            {
+                continue;
+            }
+            bool ready = true;
+            bool blocked = false;
+            for (uint8_t d = 0; d < e->dep_count; d++)
+            {
+                const boot_entry_t *dep = &s_entries[e->dep_idx[d]];
+                if (!boot_finished(dep->state))
+                {
+                    ready = false;
+                }
+                else if (dep->state != BOOT_STAGE_DONE && !(dep->stage.flags & BOOT_STAGE_OPTIONAL))
+                {
+                    blocked = true;
+                }
+            }
+            if (!ready)
+            {
+                continue;
+            }
+
+            int64_t now = esp_timer_get_time();
+            e->ready_us = now;
+            if (blocked)
+            {
+                e->state = BOOT_STAGE_SKIPPED;
+                e->err = ESP_ERR_INVALID_STATE;
+                e->end_us = now;
+                finished |= (EventBits_t)1 << i;
+                changed = true;
+                ESP_LOGW(TAG, "%s: 依赖的阶段失败, 跳过", e->stage.name);
+                continue;
+            }
+
+            e->state = BOOT_STAGE_RUNNING;
+            BaseType_t core = tskNO_AFFINITY;
+            if (e->stage.flags & BOOT_STAGE_PIN_CORE0)
+            {
+                core = 0;
+            }
+            else if (e->stage.flags & BOOT_STAGE_PIN_CORE1)
+            {
+                core = 1;
+            }
+            uint32_t stack = e->stage.stack ? e->stage.stack : BOOT_MANAGER_DEFAULT_STACK;
+            UBaseType_t prio = e->stage.priority ? e->stage.priority : BOOT_MANAGER_DEFAULT_PRIORITY;
+            if (xTaskCreatePinnedToCore(boot_stage_task, e->stage.name, stack, (void *)(uintptr_t)i, prio, NULL,
+                                        core) != pdPASS)
+            {
+                e->state = BOOT_STAGE_FAILED;
+                e->err = ESP_ERR_NO_MEM;
+                e->end_us = now;
+                finished |= (EventBits_t)1 << i;
+                changed = true;
+                ESP_LOGE(TAG, "%s: 创建任务失败", e->stage.name);
+            }
+        }
+    }
+    return finished;
+}
+
+static void boot_stage_task(void *arg)
+{
+    size_t i = (size_t)(uintptr_t)arg;
+    boot_entry_t *e = &s_entries[i];
+    e->core = xPortGetCoreID();
+    e->start_us = esp_timer_get_time();
+
+    esp_err_t err = e->stage.fn(e->stage.arg);
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    e->end_us = esp_timer_get_time();
+    e->err = err;
+    e->state = (err == ESP_OK) ? BOOT_STAGE_DONE : BOOT_STAGE_FAILED;
+    EventBits_t finished = boot_dispatch_locked() | ((EventBits_t)1 << i);
+    xSemaphoreGive(s_lock);
+
+    if (err == ESP_OK)
+    {
+        ESP_LOGI(TAG, "%s: %lld ms (core %d)", e->stage.name, (long long)(e->end_us - e->start_us) / 1000, e->core);
+    }
+    else
+    {
+        ESP_LOGW(TAG, "%s: 失败 %s%s", e->stage.name, esp_err_to_name(err),
+                 (e->stage.flags & BOOT_STAGE_OPTIONAL) ? " (可选, 继续)" : "");
+    }
+    xEventGroupSetBits(s_done, finished);
+    vTaskDelete(NULL);
+}
+
+esp_err_t boot_manager_add(const boot_stage_t *stage)
+{
+    if (stage == NULL || stage->name == NULL || stage->fn == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_started)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (boot_find(stage->name) >= 0)
+    {
+        ESP_LOGE(TAG, "阶段 %s 重复登记", stage->name);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_count >= BOOT_MANAGER_MAX_STAGES)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    boot_entry_t *e = &s_entries[s_count++];
+    memset(e, 0, sizeof(boot_entry_t));
+    e->stage = *stage;
+    e->state = BOOT_STAGE_WAITING;
+    e->core = -1;
+    return ESP_OK;
+}
+
+/**
+ * @brief 把依赖的名字解析为下标, 并检查循环依赖 (Kahn拓扑排序)
+ */
+static esp_err_t boot_resolve(void)
+{
+    uint8_t indegree[BOOT_MANAGER_MAX_STAGES] = {0};
+    for (size_t i = 0; i < s_count; i++)
+    {
+        boot_entry_t *e = &s_entries[i];
+        e->dep_count = 0;
+        for (size_t d = 0; d < BOOT_MANAGER_MAX_DEPS && e->stage.deps[d] != NULL; d++)
+        {
+            int idx = boot_find(e->stage.deps[d]);
+            if (idx < 0)
+            {
+                ESP_LOGE(TAG, "%s 依赖的阶段 %s 未登记", e->stage.name, e->stage.deps[d]);
+                return ESP_ERR_NOT_FOUND;
+            }
+            e->dep_idx[e->dep_count++] = (uint8_t)idx;
+        }
+        indegree[i] = e->dep_count;
+    }
+
+    uint8_t queue[BOOT_MANAGER_MAX_STAGES];
+    size_t head = 0;
+    size_t tail = 0;
+    for (size_t i = 0; i < s_count; i++)
+    {
+        if (indegree[i] == 0)
+        {
+            queue[tail++] = (uint8_t)i;
+        }
+    }
+    while (head < tail)
+    {
+        uint8_t done = queue[head++];
+        for (size_t i = 0; i < s_count; i++)
+        {
+            for (uint8_t d = 0; d < s_entries[i].dep_count; d++)
+            {
+                if (s_entries[i].dep_idx[d] == done && --indegree[i] == 0)
+                {
+                    queue[tail++] = (uint8_t)i;
+                }
+            }
+        }
+    }
+    if (tail < s_count)
+    {
+        for (size_t i = 0; i < s_count; i++)
+        {
+            if (indegree[i] != 0)
+            {
+                ESP_LOGE(TAG, "循环依赖: %s", s_entries[i].stage.name);
+            }
+        }
+        return ESP_ERR_INVALID_STATE;
+    }
+    return ESP_OK;
+}
+
+esp_err_t boot_manager_start(void)
+{
+    if (s_started)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t err = boot_resolve();
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    if (s_lock == NULL)
+    {
+        s_lock = xSemaphoreCreateMutex();
+    }
+    if (s_done == NULL)
+    {
+        s_done = xEventGroupCreate();
+    }
+    if (s_lock == NULL || s_done == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_started = true;
+    s_start_us = esp_timer_get_time();
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    EventBits_t finished = boot_dispatch_locked();
+    xSemaphoreGive(s_lock);
+    if (finished != 0)
+    {
+        xEventGroupSetBits(s_done, finished);
+    }
+    return ESP_OK;
+}
+
+esp_err_t boot_manager_wait(const char *name, TickType_t timeout)
+{
+    if (name == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int i = boot_find(name);
+    if (i < 0 || !s_started)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    EventBits_t bit = (EventBits_t)1 << i;
+    if (!(xEventGroupWaitBits(s_done, bit, pdFALSE, pdTRUE, timeout) & bit))
+    {
+        return ESP_ERR_TIMEOUT;
+    }
+    return (s_entries[i].state == BOOT_STAGE_SKIPPED) ? ESP_ERR_INVALID_STATE : s_entries[i].err;
+}
+
+esp_err_t boot_manager_wait_all(bool include_background, TickType_t timeout)
+{
+    if (!s_started)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    EventBits_t mask = 0;
+    for (size_t i = 0; i < s_count; i++)
+    {
+        if (include_background || !(s_entries[i].stage.flags & BOOT_STAGE_BACKGROUND))
+        {
+            mask |= (EventBits_t)1 << i;
+        }
+    }
+    if (mask == 0)
+    {
+        return ESP_OK;
+    }
+    EventBits_t bits = xEventGroupWaitBits(s_done, mask, pdFALSE, pdTRUE, timeout);
+    return ((bits & mask) == mask) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+size_t boot_manager_get_timeline(boot_stage_record_t *records, size_t max)
+{
+    if (records == NULL)
+    {
+        return 0;
+    }
+    if (s_lock != NULL)
+    {
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+    }
+    size_t n = (s_count < max) ? s_count : max;
+    for (size_t i = 0; i < n; i++)
+    {
+        const boot_entry_t *e = &s_entries[i];
+        records[i] = (boot_stage_record_t){
+            .name = e->stage.name,
+            .state = e->state,
+            .err = e->err,
+            .flags = e->stage.flags,
+            .core = e->core,
+            .ready_us = e->ready_us,
+            .start_us = e->start_us,
+            .end_us = e->end_us,
+        };
+    }
+    if (s_lock != NULL)
+    {
+        xSemaphoreGive(s_lock);
+    }
+    return n;
+}
+
+void boot_manager_print_timeline(FILE *out)
+{
+    // 静态缓冲区: app_main的栈只有几KB
+    static boot_stage_record_t records[BOOT_MANAGER_MAX_STAGES];
+    size_t n = boot_manager_get_timeline(records, BOOT_MANAGER_MAX_STAGES);
+    int64_t now = esp_timer_get_time();
+
+    // 时间线从boot_manager_start开始, 右端为最晚结束的阶段(或仍在运行的阶段的当前时刻);
+    // 表中的时刻是上电后的毫秒数
+    int64_t last = s_start_us;
+    int64_t foreground_end = s_start_us;
+    int64_t all_end = s_start_us;
+    bool foreground_done = true;
+    bool all_done = true;
+    for (size_t i = 0; i < n; i++)
+    {
+        const boot_stage_record_t *r = &records[i];
+        bool done = boot_finished(r->state);
+        int64_t end = done ? r->end_us : now;
+        last = (end > last) ? end : last;
+        all_done = all_done && done;
+        all_end = (done && r->end_us > all_end) ? r->end_us : all_end;
+        if (!(r->flags & BOOT_STAGE_BACKGROUND))
+        {
+            foreground_done = foreground_done && done;
+            foreground_end = (done && r->end_us > foreground_end) ? r->end_us : foreground_end;
+        }
+    }
+    int64_t span = (last > s_start_us) ? last - s_start_us : 1;
+
+    fprintf(out, "\nBoot timeline (%lld - %lld ms, %d 列)\n", (long long)s_start_us / 1000, (long long)last / 1000,
+            BOOT_MANAGER_TIMELINE_WIDTH);
+    fprintf(out, "%-14s %8s %8s %8s %4s %-8s %s\n", "stage", "ready", "start", "dur", "core", "result", "timeline");
+    for (size_t i = 0; i < n; i++)
+    {
+        const boot_stage_record_t *r = &records[i];
+        char bar[BOOT_MANAGER_TIMELINE_WIDTH + 1];
+        memset(bar, ' ', BOOT_MANAGER_TIMELINE_WIDTH);
+        bar[BOOT_MANAGER_TIMELINE_WIDTH] = '\0';
+        if (r->start_us != 0)
+        {
+            // '.': 任务已创建还未开始执行; '#': 执行中; 仍在运行的阶段画到当前时刻, 跳过的阶段不画
+            int64_t end = boot_finished(r->state) ? r->end_us : now;
+            int c0 = (int)((r->ready_us - s_start_us) * BOOT_MANAGER_TIMELINE_WIDTH / span);
+            int c1 = (int)((r->start_us - s_start_us) * BOOT_MANAGER_TIMELINE_WIDTH / span);
+            int c2 = (int)((end - s_start_us) * BOOT_MANAGER_TIMELINE_WIDTH / span);
+            for (int c = c0; c < BOOT_MANAGER_TIMELINE_WIDTH && c <= c2; c++)
+            {
+                bar[c] = (c < c1) ? '.' : '#';
+            }
+        }
+        char ready[24] = "-";
+        char start[24] = "-";
+        char dur[24] = "-";
+        char core[8] = "-";
+        if (r->ready_us != 0)
+        {
+            snprintf(ready, sizeof(ready), "%lld", (long long)r->ready_us / 1000);
+        }
+        if (r->start_us != 0)
+        {
+            int64_t end = boot_finished(r->state) ? r->end_us : now;
+            snprintf(start, sizeof(start), "%lld", (long long)r->start_us / 1000);
+            snprintf(dur, sizeof(dur), "%lld%s", (long long)(end - r->start_us) / 1000,
+                     boot_finished(r->state) ? "" : "+");
+            snprintf(core, sizeof(core), "%d", r->core);
+        }
+        fprintf(out, "%-14s %8s %8s %8s %4s %-8s |%s|%s\n", r->name, ready, start, dur, core, s_state_names[r->state],
+                bar, (r->flags & BOOT_STAGE_BACKGROUND) ? " bg" : "");
+    }
+    fprintf(out, "boot_manager_start at %lld ms; foreground %s %lld ms; all %s %lld ms\n",
+            (long long)s_start_us / 1000, foreground_done ? "done at" : "running, last at",
+            (long long)foreground_end / 1000, all_done ? "done at" : "running, last at", (long long)all_end / 1000);
+}
@@ -0,0 +1,127 @@
+/**
+ * @file boot_manager.h
+ * @brief 按依赖关系并行执行的分阶段启动
+ * @details 启动过程拆成若干阶段, 每个阶段声明它依赖的阶段(按名字):
+ *          - 依赖全部结束的阶段立即在自己的任务中执行, 互不依赖的阶段在两个核上同时进行
+ *          - 阶段失败时依赖它的阶段被跳过; 标记BOOT_STAGE_OPTIONAL的阶段失败不影响依赖它的阶段
+ *            (它们自己处理资源缺失, 例如没有SD卡)
+ *          - 标记BOOT_STAGE_BACKGROUND的阶段(联网等)不计入前台启动, boot_manager_wait_all可以只等前台阶段
+ *          - 每个阶段记录就绪、开始、结束时间和运行的核, boot_manager_print_timeline打印启动时间线
+ *          阶段在boot_manager_start之前全部登记, 启动时检查未知的依赖和循环依赖。
+ */
+
+#ifndef BOOT_MANAGER_H
+#define BOOT_MANAGER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define BOOT_MANAGER_MAX_STAGES (24)        // 事件组可用的位数
+#define BOOT_MANAGER_MAX_DEPS (6)           // 每个阶段最多依赖的阶段数
+#define BOOT_MANAGER_DEFAULT_STACK (4096)   // 阶段任务的默认栈大小
+#define BOOT_MANAGER_DEFAULT_PRIORITY (4)   // 阶段任务的默认优先级 (低于界面任务)
+#define BOOT_MANAGER_TIMELINE_WIDTH (48)    // 时间线图的列数
+
+// 阶段标志
+#define BOOT_STAGE_OPTIONAL (1u << 0)   // 失败时依赖它的阶段照常执行
+#define BOOT_STAGE_BACKGROUND (1u << 1) // 不计入前台启动
+#define BOOT_STAGE_PIN_CORE0 (1u << 2)  // 固定在核0执行, 默认不固定
+#define BOOT_STAGE_PIN_CORE1 (1u << 3)  // 固定在核1执行
+
+    /**
+     * @brief 阶段函数, 在阶段自己的任务中执行; 返回后任务结束, 需要常驻的工作应另建任务
+     */
+    typedef esp_err_t (*boot_stage_fn_t)(void *arg);
+
+    /**
+     * @brief 阶段描述, 0/NULL表示默认值
+     */
+    typedef struct
+    {
+        const char *name;                          // 唯一的名字, 也是任务名; 必须在整个运行期间有效
+        boot_stage_fn_t fn;
+        void *arg;
+        const char *deps[BOOT_MANAGER_MAX_DEPS];   // 依赖的阶段名, 未用的为NULL
+        uint32_t flags;                            // BOOT_STAGE_*
+        uint32_t stack;                            // 默认BOOT_MANAGER_DEFAULT_STACK
+        UBaseType_t priority;                      // 默认BOOT_MANAGER_DEFAULT_PRIORITY
+    } boot_stage_t;
+
+    /**
+     * @brief 阶段状态
+     */
+    typedef enum
+    {
+        BOOT_STAGE_WAITING = 0, // 等待依赖
+        BOOT_STAGE_RUNNING,
+        BOOT_STAGE_DONE,
+        BOOT_STAGE_FAILED,
+        BOOT_STAGE_SKIPPED,     // 依赖的阶段失败, 未执行
+    } boot_stage_state_t;
+
+    /**
+     * @brief 时间线中的一个阶段, 时间为esp_timer_get_time() (上电后的微秒数), 未到达的时刻为0
+     */
+    typedef struct
+    {
+        const char *name;
+        boot_stage_state_t state;
+        esp_err_t err;
+        uint32_t flags;
+        int core;         // 执行所在的核, 未执行时为-1
+        int64_t ready_us; // 依赖全部结束、任务创建的时间
+        int64_t start_us; // 阶段函数开始执行的时间
+        int64_t end_us;
+    } boot_stage_record_t;
+
+    /**
+     * @brief 登记一个阶段 (描述被复制)
+     * @return esp_err_t ESP_ERR_INVALID_STATE已经启动, ESP_ERR_NO_MEM超过BOOT_MANAGER_MAX_STAGES, ESP_ERR_INVALID_ARG名字重复或缺少函数
+     */
+    esp_err_t boot_manager_add(const boot_stage_t *stage);
+
+    /**
+     * @brief 检查依赖关系并开始执行没有依赖的阶段, 立即返回
+     * @return esp_err_t ESP_ERR_NOT_FOUND依赖了未登记的阶段, ESP_ERR_INVALID_STATE有循环依赖或已经启动
+     */
+    esp_err_t boot_manager_start(void);
+
+    /**
+     * @brief 等待一个阶段结束
+     * @return esp_err_t 阶段的返回值; 被跳过时ESP_ERR_INVALID_STATE, 超时ESP_ERR_TIMEOUT, 没有该阶段ESP_ERR_NOT_FOUND
+     */
+    esp_err_t boot_manager_wait(const char *name, TickType_t timeout);
+
+    /**
+     * @brief 等待所有阶段结束
+     * @param include_background false时只等不带BOOT_STAGE_BACKGROUND的阶段
+     * @return esp_err_t ESP_OK全部结束(不论成败), ESP_ERR_TIMEOUT
+     */
+    esp_err_t boot_manager_wait_all(bool include_background, TickType_t timeout);
+
+    /**
+     * @brief 获取时间线 (按登记顺序)
+     * @return size_t 写入的阶段数
+     */
+    size_t boot_manager_get_timeline(boot_stage_record_t *records, size_t max);
+
+    /**
+     * @brief 打印时间线: 每个阶段的开始时间、耗时、核、结果和甘特条, 以及前台和全部阶段的完成时间
+     * @note 不可重入, 不要在多个任务中同时调用
+     */
+    void boot_manager_print_timeline(FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BOOT_MANAGER_H
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <time.h>
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
@@ -24,6 +25,16 @@ static void esp_initialize_sntp(void)
     esp_sntp_init();                                 // 启动SNTP服务
 }
 
+/**
+ * @brief 设置时区为中国标准时间（东八区）
+ * @details 与SNTP同步无关, 时钟任务启动时即设置, 同步之前显示的时间也按本地时区换算
+ */
+void get_time_set_timezone(void)
+{
+    setenv("TZ", GET_TIME_TZ, 1);
+    tzset();
+}
+
 /**
  * @brief 获取当前本地时间
  * @details 获取系统当前时间并填充到自定义结构体 my_time_t 中，自动处理年份和月份
@@ -76,9 +87,8 @@ void esp_wait_sntp_sync(void)
         localtime_r(&now, &timeinfo);         // 刷新全局时间结构体
     }
 
-    // 设置时区为中国标准时间（东八区）
-    setenv("TZ", "CST-8", 1);
-    tzset();
+    // 设置时区为中国标准时间（东八区）, 时钟任务启动时通常已设置过
+    get_time_set_timezone();
 
     // 格式化并打印当前时间
     strftime(strftime_buf, sizeof(strftime_buf), "%c", &timeinfo);
@@ -1,5 +1,7 @@
 #ifndef GET_TIME_H
 #define GET_TIME_H
+
+#define GET_TIME_TZ "CST-8" // 中国标准时间（东八区）
 typedef struct
 {
     int year;
@@ -18,6 +20,11 @@ typedef struct
  */
 void esp_wait_sntp_sync(void);
 
+/**
+ * @brief 设置时区为GET_TIME_TZ
+ */
+void get_time_set_timezone(void);
+
 /**
  * @brief 获取当前本地时间
  * @details 获取系统当前时间并填充到自定义结构体 my_time_t 中，自动处理年份和月份
@@ -0,0 +1,103 @@
+/**
+ * @file json_stream.h
+ * @brief 流式、按路径提取字段的JSON解析器
+ * @details 响应数据分块到达时逐块送入(json_stream_feed), 解析器只保留当前路径和少量状态,
+ *          不建立文档树、不分配内存, 文档长度没有上限。只有路径与字段表匹配的值被拷贝到调用者的缓冲区:
+ *          - 路径写法: 对象成员用'.'连接, 数组元素用"[下标]", 例如"results[0].location.name"
+ *          - 字符串值去掉引号并处理转义(含\\uXXXX和代理对, 转为UTF-8); 数字、true/false/null按原文拷贝
+ *          - 值是对象或数组的字段不拷贝; 超出缓冲区的部分截断并记录在truncated中
+ *          - 键超过JSON_STREAM_PATH_MAX的成员及其子成员不参与匹配, 嵌套超过JSON_STREAM_MAX_DEPTH时报错
+ */
+
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define JSON_STREAM_MAX_DEPTH (16)  // 对象/数组的最大嵌套层数
+#define JSON_STREAM_PATH_MAX (96)   // 当前路径的最大长度 (含结尾的'\0')
+#define JSON_STREAM_MAX_FIELDS (32) // 字段表的最大长度 (found/truncated是32位掩码)
+
+    /**
+     * @brief 要提取的字段
+     */
+    typedef struct
+    {
+        const char *path; // 例如"results[0].now.temperature"
+        char *dest;       // 输出缓冲区, 总是以'\0'结尾; 未出现的字段保持为空字符串
+        size_t size;      // 缓冲区大小 (含结尾的'\0')
+    } json_stream_field_t;
+
+    /**
+     * @brief 解析器状态 (固定大小, 可以放在栈上或静态变量中)
+     */
+    typedef struct
+    {
+        const json_stream_field_t *fields;
+        uint8_t field_count;
+        uint8_t state;
+        uint8_t depth;
+        uint8_t esc_len;          // \\uXXXX已读入的十六进制位数
+        bool in_key;              // 正在读取的字符串是键
+        bool overflow;            // 路径超长, 当前值及其子成员不参与匹配
+        int8_t target;            // 当前值拷贝到的字段下标, -1为不拷贝
+        uint8_t lit_pos;          // true/false/null已匹配的字符数
+        const char *lit_word;     // 正在读取的true/false/null, 数字为NULL
+        uint16_t path_len;
+        uint16_t overflow_at;     // 发生超长时的路径长度, 回退到不超过它时清除overflow
+        uint32_t esc_code;        // \\uXXXX累积的码点
+        uint32_t hi_surrogate;    // 等待低代理的高代理, 0为没有
+        size_t out_len;           // 当前值已拷贝的字节数
+        size_t bytes;             // 已送入的总字节数
+        uint32_t found;           // bit i: 字段i已出现
+        uint32_t truncated;       // bit i: 字段i被截断
+        esp_err_t err;
+        char path[JSON_STREAM_PATH_MAX];
+        struct
+        {
+            uint8_t is_array;
+            uint16_t path_len; // 容器自身的路径长度
+            uint32_t index;    // 数组中下一个元素的下标
+        } stack[JSON_STREAM_MAX_DEPTH];
+    } json_stream_t;
+
+    /**
+     * @brief 初始化解析器, 并把所有字段的输出缓冲区清为空字符串
+     * @param fields 字段表, 解析期间必须保持有效
+     * @param count 字段数, 不超过JSON_STREAM_MAX_FIELDS
+     */
+    esp_err_t json_stream_init(json_stream_t *js, const json_stream_field_t *fields, size_t count);
+
+    /**
+     * @brief 送入一块数据, 块的边界可以在任意位置 (包括转义序列和多字节字符中间)
+     * @return esp_err_t ESP_OK, ESP_ERR_INVALID_RESPONSE语法错误(之后的数据被忽略), ESP_ERR_INVALID_SIZE嵌套过深
+     */
+    esp_err_t json_stream_feed(json_stream_t *js, const char *data, size_t len);
+
+    /**
+     * @brief 数据结束, 检查文档是否完整
+     * @return esp_err_t ESP_OK完整, ESP_ERR_INVALID_RESPONSE不完整或有错误
+     */
+    esp_err_t json_stream_finish(json_stream_t *js);
+
+    /**
+     * @brief 字段i是否出现过
+     */
+    static inline bool json_stream_has(const json_stream_t *js, size_t i)
+    {
+        return (js->found >> i) & 1u;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JSON_STREAM_H
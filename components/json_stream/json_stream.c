@@ -0,0 +1,562 @@
+/**
+ * @file json_stream.c
+ * @brief 流式、按路径提取字段的JSON解析器
+ * @details 逐字节的状态机。js->path始终是当前值的路径: 读到键时追加".键", 进入数组元素时追加"[下标]",
+ *          值结束后在','或容器结束时回退到容器自身的路径。值开始时与字段表比较一次, 决定是否拷贝。
+ *          所有状态都在json_stream_t中, 因此块边界可以落在任何位置。
+ */
+
+#include "json_stream.h"
+#include <string.h>
+#include <stdio.h>
+
+enum
+{
+    JS_VALUE,       // 等待一个值
+    JS_OBJ_FIRST,   // '{'之后: 键或'}'
+    JS_OBJ_KEY,     // ','之后: 键
+    JS_ARR_FIRST,   // '['之后: 第一个元素或']'
+    JS_COLON,       // 键之后: ':'
+    JS_AFTER,       // 值之后: ','或容器结束
+    JS_STRING,      // 字符串内 (键或值)
+    JS_ESCAPE,      // '\\'之后
+    JS_UNICODE,     // "\\u"之后的4位十六进制
+    JS_LITERAL,     // 数字或true/false/null
+    JS_DONE,        // 顶层值已结束, 只允许空白
+    JS_ERROR,
+};
+
+static bool js_is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static esp_err_t js_fail(json_stream_t *js, esp_err_t err)
+{
+    js->err = err;
+    js->state = JS_ERROR;
+    return err;
+}
+
+static void js_path_putc(json_stream_t *js, char c)
+{
+    if (js->overflow)
+    {
+        return;
+    }
+    if (js->path_len + 1 >= JSON_STREAM_PATH_MAX)
+    {
+        js->overflow = true;
+        return;
+    }
+    js->path[js->path_len++] = c;
+}
+
+/**
+ * @brief 回退到容器的路径长度; 回退到超长发生之前时恢复匹配
+ */
+static void js_path_truncate(json_stream_t *js, uint16_t len)
+{
+    js->path_len = len;
+    if (js->overflow && len <= js->overflow_at)
+    {
+        js->overflow = false;
+    }
+}
+
+static void js_path_mark(json_stream_t *js)
+{
+    // 记录开始追加的位置, 追加过程中超长时据此恢复
+    if (!js->overflow)
+    {
+        js->overflow_at = js->path_len;
+    }
+}
+
+static void js_path_index(json_stream_t *js)
+{
+    char seg[16];
+    uint32_t index = js->stack[js->depth - 1].index++;
+    int n = snprintf(seg, sizeof(seg), "[%lu]", (unsigned long)index);
+    js_path_mark(js);
+    for (int i = 0; i < n; i++)
+    {
+        js_path_putc(js, seg[i]);
+    }
+}
+
+static void js_out_putc(json_stream_t *js, char c)
+{
+    if (js->in_key)
+    {
+        js_path_putc(js, c);
+        return;
+    }
+    if (js->target < 0)
+    {
+        return;
+    }
+    const json_stream_field_t *f = &js->fields[js->target];
+    if (js->out_len + 1 < f->size)
+    {
+        f->dest[js->out_len++] = c;
+    }
+    else
+    {
+        js->truncated |= 1u << js->target;
+    }
+}
+
+static void js_out_utf8(json_stream_t *js, uint32_t cp)
+{
+    if (cp < 0x80)
+    {
+        js_out_putc(js, (char)cp);
+    }
+    else if (cp < 0x800)
+    {
+        js_out_putc(js, (char)(0xC0 | (cp >> 6)));
+        js_out_putc(js, (char)(0x80 | (cp & 0x3F)));
+    }
+    else if (cp < 0x10000)
+    {
+        js_out_putc(js, (char)(0xE0 | (cp >> 12)));
+        js_out_putc(js, (char)(0x80 | ((cp >> 6) & 0x3F)));
+        js_out_putc(js, (char)(0x80 | (cp & 0x3F)));
+    }
+    else
+    {
+        js_out_putc(js, (char)(0xF0 | (cp >> 18)));
+        js_out_putc(js, (char)(0x80 | ((cp >> 12) & 0x3F)));
+        js_out_putc(js, (char)(0x80 | ((cp >> 6) & 0x3F)));
+        js_out_putc(js, (char)(0x80 | (cp & 0x3F)));
+    }
+}
+
+/**
+ * @brief 标量值开始: 按当前路径查找字段
+ */
+static void js_value_begin(json_stream_t *js)
+{
+    js->target = -1;
+    js->out_len = 0;
+    if (js->overflow)
+    {
+        return;
+    }
+    js->path[js->path_len] = '\0';
+    for (uint8_t i = 0; i < js->field_count; i++)
+    {
+        // 同一路径出现多次时保留第一次的值
+        if (!(js->found & (1u << i)) && strcmp(js->fields[i].path, js->path) == 0)
+        {
+            js->target = (int8_t)i;
+            return;
+        }
+    }
+}
+
+static void js_value_end(json_stream_t *js)
+{
+    if (js->target >= 0)
+    {
+        js->fields[js->target].dest[js->out_len] = '\0';
+        js->found |= 1u << js->target;
+        js->target = -1;
+    }
+    js->state = (js->depth == 0) ? JS_DONE : JS_AFTER;
+}
+
+static esp_err_t js_push(json_stream_t *js, bool is_array)
+{
+    if (js->depth >= JSON_STREAM_MAX_DEPTH)
+    {
+        return js_fail(js, ESP_ERR_INVALID_SIZE);
+    }
+    js->stack[js->depth].is_array = is_array;
+    js->stack[js->depth].path_len = js->path_len;
+    js->stack[js->depth].index = 0;
+    js->depth++;
+    return ESP_OK;
+}
+
+static void js_pop(json_stream_t *js)
+{
+    js->depth--;
+    js_path_truncate(js, js->stack[js->depth].path_len);
+    js_value_end(js);
+}
+
+static void js_key_begin(json_stream_t *js)
+{
+    js_path_mark(js);
+    if (js->path_len > 0)
+    {
+        js_path_putc(js, '.');
+    }
+    js->in_key = true;
+    js->state = JS_STRING;
+}
+
+/**
+ * @brief 处理一个值的第一个字符
+ */
+static esp_err_t js_value_char(json_stream_t *js, char c)
+{
+    switch (c)
+    {
+    case '{':
+        js->state = JS_OBJ_FIRST;
+        return js_push(js, false);
+    case '[':
+        js->state = JS_ARR_FIRST;
+        return js_push(js, true);
+    case '"':
+        js_value_begin(js);
+        js->in_key = false;
+        js->state = JS_STRING;
+        return ESP_OK;
+    case 't':
+        js->lit_word = "true";
+        break;
+    case 'f':
+        js->lit_word = "false";
+        break;
+    case 'n':
+        js->lit_word = "null";
+        break;
+    default:
+        if (c != '-' && (c < '0' || c > '9'))
+        {
+            return js_fail(js, ESP_ERR_INVALID_RESPONSE);
+        }
+        js->lit_word = NULL;
+        break;
+    }
+    js_value_begin(js);
+    js_out_putc(js, c);
+    js->lit_pos = 1;
+    js->state = JS_LITERAL;
+    return ESP_OK;
+}
+
+/**
+ * @brief 处理一个字节, 返回false表示该字节未被消耗, 需要在新状态下重新处理
+ */
+static bool js_step(json_stream_t *js, char c)
+{
+    switch (js->state)
+    {
+    case JS_VALUE:
+        if (!js_is_space(c))
+        {
+            js_value_char(js, c);
+        }
+        return true;
+
+    case JS_OBJ_FIRST:
+        if (c == '}')
+        {
+            js_pop(js);
+        }
+        else if (c == '"')
+        {
+            js_key_begin(js);
+        }
+        else if (!js_is_space(c))
+        {
+            js_fail(js, ESP_ERR_INVALID_RESPONSE);
+        }
+        return true;
+
+    case JS_OBJ_KEY:
+        if (c == '"')
+        {
+            js_key_begin(js);
+        }
+        else if (!js_is_space(c))
+        {
+            js_fail(js, ESP_ERR_INVALID_RESPONSE);
+        }
+        return true;
+
+    case JS_ARR_FIRST:
+        if (js_is_space(c))
+        {
+            return true;
+        }
+        if (c == ']')
+        {
+            js_pop(js);
+            return true;
+        }
+        js_path_index(js);
+        js->state = JS_VALUE;
+        return false;
+
+    case JS_COLON:
+        if (c == ':')
+        {
+            js->state = JS_VALUE;
+        }
+        else if (!js_is_space(c))
+        {
+            js_fail(js, ESP_ERR_INVALID_RESPONSE);
+        }
+        return true;
+
+    case JS_AFTER:
+    {
+        if (js_is_space(c))
+        {
+            return true;
+        }
+        bool is_array = js->stack[js->depth - 1].is_array;
+        if (c == ',')
+        {
+            js_path_truncate(js, js->stack[js->depth - 1].path_len);
+            if (is_array)
+            {
+                js_path_index(js);
+                js->state = JS_VALUE;
+            }
+            else
+            {
+                js->state = JS_OBJ_KEY;
+            }
+        }
+        else if (c == (is_array ? ']' : '}'))
+        {
+            js_pop(js);
+        }
+        else
+        {
+            js_fail(js, ESP_ERR_INVALID_RESPONSE);
+        }
+        return true;
+    }
+
+    case JS_STRING:
+        if (c == '"')
+        {
+            if (js->hi_surrogate != 0)
+            {
+                js_out_utf8(js, 0xFFFD); // 孤立的高代理
+                js->hi_surrogate = 0;
+            }
+            if (js->in_key)
+            {
+                js->in_key = false;
+                js->state = JS_COLON;
+            }
+            else
+            {
+                js_value_end(js);
+            }
+        }
+        else if (c == '\\')
+        {
+            js->state = JS_ESCAPE;
+        }
+        else if ((unsigned char)c < 0x20)
+        {
+            js_fail(js, ESP_ERR_INVALID_RESPONSE);
+        }
+        else
+        {
+            if (js->hi_surrogate != 0)
+            {
+                js_out_utf8(js, 0xFFFD);
+                js->hi_surrogate = 0;
+            }
+            js_out_putc(js, c); // UTF-8多字节字符按字节原样拷贝
+        }
+        return true;
+
+    case JS_ESCAPE:
+    {
+        char out;
+        switch (c)
+        {
+        case '"':
+        case '\\':
+        case '/':
+            out = c;
+            break;
+        case 'b':
+            out = '\b';
+            break;
+        case 'f':
+            out = '\f';
+            break;
+        case 'n':
+            out = '\n';
+            break;
+        case 'r':
+            out = '\r';
+            break;
+        case 't':
+            out = '\t';
+            break;
+        case 'u':
+            js->esc_len = 0;
+            js->esc_code = 0;
+            js->state = JS_UNICODE;
+            return true;
+        default:
+            js_fail(js, ESP_ERR_INVALID_RESPONSE);
+            return true;
+        }
+        if (js->hi_surrogate != 0)
+        {
+            js_out_utf8(js, 0xFFFD);
+            js->hi_surrogate = 0;
+        }
+        js_out_putc(js, out);
+        js->state = JS_STRING;
+        return true;
+    }
+
+    case JS_UNICODE:
+    {
+        uint32_t v;
+        if (c >= '0' && c <= '9')
+        {
+            v = c - '0';
+        }
+        else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+        {
+            v = (c | 0x20) - 'a' + 10;
+        }
+        else
+        {
+            js_fail(js, ESP_ERR_INVALID_RESPONSE);
+            return true;
+        }
+        js->esc_code = (js->esc_code << 4) | v;
+        if (++js->esc_len < 4)
+        {
+            return true;
+        }
+        uint32_t cp = js->esc_code;
+        js->state = JS_STRING;
+        if (cp >= 0xD800 && cp < 0xDC00)
+        {
+            if (js->hi_surrogate != 0)
+            {
+                js_out_utf8(js, 0xFFFD);
+            }
+            js->hi_surrogate = cp; // 等待紧随其后的低代理
+            return true;
+        }
+        if (cp >= 0xDC00 && cp < 0xE000)
+        {
+            if (js->hi_surrogate == 0)
+            {
+                js_out_utf8(js, 0xFFFD);
+                return true;
+            }
+            cp = 0x10000 + ((js->hi_surrogate - 0xD800) << 10) + (cp - 0xDC00);
+        }
+        else if (js->hi_surrogate != 0)
+        {
+            js_out_utf8(js, 0xFFFD);
+        }
+        js->hi_surrogate = 0;
+        js_out_utf8(js, cp);
+        return true;
+    }
+
+    case JS_LITERAL:
+        if (js->lit_word != NULL)
+        {
+            if (js->lit_word[js->lit_pos] != '\0')
+            {
+                if (c != js->lit_word[js->lit_pos])
+                {
+                    js_fail(js, ESP_ERR_INVALID_RESPONSE);
+                    return true;
+                }
+                js->lit_pos++;
+                js_out_putc(js, c);
+                return true;
+            }
+        }
+        else if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-')
+        {
+            js_out_putc(js, c);
+            return true;
+        }
+        // 字面量结束, 当前字符属于后面的结构
+        js->lit_pos = 0;
+        js_value_end(js);
+        return false;
+
+    case JS_DONE:
+        if (!js_is_space(c))
+        {
+            js_fail(js, ESP_ERR_INVALID_RESPONSE);
+        }
+        return true;
+
+    default:
+        return true;
+    }
+}
+
+esp_err_t json_stream_init(json_stream_t *js, const json_stream_field_t *fields, size_t count)
+{
+    if (js == NULL || (fields == NULL && count > 0) || count > JSON_STREAM_MAX_FIELDS)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        if (fields[i].path == NULL || fields[i].dest == NULL || fields[i].size == 0)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+        fields[i].dest[0] = '\0';
+    }
+    memset(js, 0, sizeof(json_stream_t));
+    js->fields = fields;
+    js->field_count = (uint8_t)count;
+    js->state = JS_VALUE;
+    js->target = -1;
+    return ESP_OK;
+}
+
+esp_err_t json_stream_feed(json_stream_t *js, const char *data, size_t len)
+{
+    if (js == NULL || (data == NULL && len > 0))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < len && js->state != JS_ERROR;)
+    {
+        if (js_step(js, data[i]))
+        {
+            i++;
+        }
+    }
+    js->bytes += len;
+    return js->err;
+}
+
+esp_err_t json_stream_finish(json_stream_t *js)
+{
+    if (js == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (js->state == JS_LITERAL && js->depth == 0)
+    {
+        // 顶层是数字时没有结束符
+        js_step(js, ' ');
+    }
+    if (js->state != JS_DONE)
+    {
+        return (js->err != ESP_OK) ? js->err : ESP_ERR_INVALID_RESPONSE;
+    }
+    return ESP_OK;
+}
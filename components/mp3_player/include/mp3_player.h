@@ -1,6 +1,7 @@
 #ifndef MP3_PLAYER_H
 #define MP3_PLAYER_H
 
+#include <stdint.h>
 #include "esp_err.h"
 #include "audio_player.h"
 
@@ -9,6 +10,20 @@ extern "C"
 {
 #endif
 
+// MP3解码后端: 1使用esp_audio_codec (Espressif预编译库), 0使用libhelix (mp3_decoder_helix.c)
+#define MP3_PLAYER_USE_ESP_AUDIO_CODEC (1)
+
+    /**
+     * @brief 当前文件的解码统计
+     */
+    typedef struct
+    {
+        const char *backend;        // 解码后端名称
+        uint32_t decode_us_per_sec; // 每秒音频的解码耗时(微秒), 10000即占用1%的CPU
+        uint32_t max_decode_us;     // 单次解码最长耗时
+        uint64_t frames_decoded;    // 已解码的帧数
+    } mp3_player_decoder_stats_t;
+
     /**
      * @brief 初始化MP3播放器
      *        必须在audio_codec_init()之后调用
@@ -20,12 +35,13 @@ extern "C"
     esp_err_t mp3_player_init(void);
 
     /**
-     * @brief 播放音频文件 (支持MP3和WAV格式)
-     *        audio_player会自动识别文件格式
+     * @brief 播放音频文件 (支持MP3、WAV(16位PCM/IMA-ADPCM)和FLAC格式)
+     *        按文件内容选择组件内的解码后端, 没有匹配的后端时交给audio_player识别
      *
      * @param file_path 文件路径,例如:
      *                  - "/spiffs/music.mp3" (MP3格式)
      *                  - "/spiffs/audio.wav" (WAV格式)
+     *                  - "/sdcard/music.flac" (FLAC格式)
      *
      * @return
      *    - ESP_OK: 成功
@@ -76,6 +92,44 @@ extern "C"
      */
     audio_player_state_t mp3_player_get_state(void);
 
+    /**
+     * @brief 定位到指定播放时间 (仅MP3)
+     *        VBR文件使用Xing/VBRI目录, CBR文件按帧长度计算,
+     *        其他文件首次定位时建立稀疏帧索引并缓存
+     *
+     * @param position_ms 目标时间(毫秒), 超出时长时定位到最后一帧
+     *
+     * @return
+     *    - ESP_OK: 成功
+     *    - ESP_ERR_INVALID_STATE: 没有正在播放的MP3文件
+     *    - 其他: 失败
+     */
+    esp_err_t mp3_player_seek_ms(uint32_t position_ms);
+
+    /**
+     * @brief 获取当前播放位置
+     *
+     * @param position_ms 输出当前播放时间(毫秒)
+     * @param duration_ms 输出总时长(毫秒, 未知时为0), 可为NULL
+     *
+     * @return
+     *    - ESP_OK: 成功
+     *    - ESP_ERR_INVALID_STATE: 当前没有播放文件
+     */
+    esp_err_t mp3_player_get_position(uint32_t *position_ms, uint32_t *duration_ms);
+
+    /**
+     * @brief 获取当前文件的解码统计
+     *        esp-audio-player播放的文件不经过组件内的解码器, 统计为0
+     *
+     * @param stats 输出
+     *
+     * @return
+     *    - ESP_OK: 成功
+     *    - ESP_ERR_INVALID_ARG: stats为NULL
+     */
+    esp_err_t mp3_player_get_decoder_stats(mp3_player_decoder_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
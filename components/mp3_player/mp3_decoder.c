@@ -0,0 +1,66 @@
+/**
+ * @file mp3_decoder.c
+ * @brief 解码器后端选择
+ */
+
+#include "mp3_decoder.h"
+#include "mp3_player.h"
+#include <string.h>
+#include "esp_heap_caps.h"
+
+extern const mp3_decoder_backend_t mp3_decoder_wav_pcm;
+extern const mp3_decoder_backend_t mp3_decoder_wav_adpcm;
+extern const mp3_decoder_backend_t mp3_decoder_flac;
+#if MP3_PLAYER_USE_ESP_AUDIO_CODEC
+extern const mp3_decoder_backend_t mp3_decoder_esp_mp3;
+#else
+extern const mp3_decoder_backend_t mp3_decoder_helix_mp3;
+#endif
+
+// 按顺序嗅探, 第一个匹配的后端生效
+// 有固定文件头的格式在前, MP3只靠帧同步字判断, 放在最后
+static const mp3_decoder_backend_t *const s_backends[] = {
+    &mp3_decoder_wav_pcm,
+    &mp3_decoder_wav_adpcm,
+    &mp3_decoder_flac,
+#if MP3_PLAYER_USE_ESP_AUDIO_CODEC
+    &mp3_decoder_esp_mp3,
+#else
+    &mp3_decoder_helix_mp3,
+#endif
+    NULL,
+};
+
+const mp3_decoder_backend_t *mp3_decoder_select(const uint8_t *head, size_t len)
+{
+    for (int i = 0; s_backends[i] != NULL; i++)
+    {
+        if (s_backends[i]->probe(head, len))
+        {
+            return s_backends[i];
+        }
+    }
+    return NULL;
+}
+
+uint32_t mp3_decoder_id3_size(const uint8_t *head, size_t len)
+{
+    if (len < 10 || memcmp(head, "ID3", 3) != 0)
+    {
+        return 0;
+    }
+    // 同步安全整数 (每字节7位), 标志位0x10表示标签后还有10字节的尾
+    uint32_t size = ((uint32_t)(head[6] & 0x7F) << 21) | ((uint32_t)(head[7] & 0x7F) << 14) |
+                    ((uint32_t)(head[8] & 0x7F) << 7) | (head[9] & 0x7F);
+    return size + 10 + ((head[5] & 0x10) ? 10 : 0);
+}
+
+void *mp3_decoder_malloc(size_t size)
+{
+    void *buf = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (buf == NULL)
+    {
+        buf = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+    return buf;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file mp3_decoder.h
+ * @brief 解码器后端接口 (组件内部接口)
+ * @details 后端只负责把压缩数据转换成PCM; 文件读取、暂停/定位和写入混音器由mp3_stream统一完成。
+ *          未选中任何后端的文件仍交给esp-audio-player播放。
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define MP3_DECODER_PROBE_BYTES (512)  // 内容嗅探读取的文件头长度 (WAV的data块需要在此范围内)
+#define MP3_DECODER_MAX_FRAMES (1152)  // 单次decode最多输出的帧数
+
+    /**
+     * @brief 解码输出格式
+     */
+    typedef struct
+    {
+        uint32_t sample_rate;
+        uint8_t channels; // 1或2, 单声道由mp3_stream扩展为立体声
+    } mp3_decoder_info_t;
+
+    /**
+     * @brief 解码器后端
+     */
+    typedef struct
+    {
+        const char *name;
+        bool mpeg_frames; // 数据是MPEG音频帧, 可以用mp3_seek定位
+        uint32_t in_bytes; // 需要的输入缓冲区大小 (不小于最大帧长), 0表示使用默认大小
+
+        /**
+         * @brief 根据文件开头(已跳过ID3v2标签)判断能否解码
+         */
+        bool (*probe)(const uint8_t *head, size_t len);
+
+        /**
+         * @brief 创建解码器
+         * @param ctx 输出解码器上下文
+         * @param head 文件开头 (probe使用的同一段数据, 已跳过ID3v2标签)
+         * @param len head长度
+         * @param data_offset 输出第一段音频数据相对head的偏移 (跳过文件头)
+         */
+        esp_err_t (*open)(void **ctx, const uint8_t *head, size_t len, uint32_t *data_offset);
+
+        /**
+         * @brief 解码
+         * @param in 输入数据
+         * @param in_len 输入长度
+         * @param consumed 输出已使用的输入字节数; 一帧的输出超过MP3_DECODER_MAX_FRAMES需要分多次返回时,
+         *                 前几次为0(下次调用传入同一段数据), 最后一次才计入该帧的长度
+         * @param pcm 输入时指向mp3_stream的PCM缓冲区(容量MP3_DECODER_MAX_FRAMES帧立体声);
+         *            后端也可以改为指向in或自己的缓冲区, 省去一次拷贝, 数据在下一次调用前有效
+         * @param frames 输出帧数 (不超过MP3_DECODER_MAX_FRAMES, 可以为0, 例如跳过了坏数据)
+         * @param info 输出本次解码的格式
+         * @return ESP_OK 成功; ESP_ERR_INVALID_SIZE 输入不足一帧, 需要更多数据;
+         *         ESP_ERR_NOT_FOUND 音频数据已结束(之后是其他块); 其他 无法继续
+         */
+        esp_err_t (*decode)(void *ctx, const uint8_t *in, size_t in_len, size_t *consumed,
+                            int16_t **pcm, size_t *frames, mp3_decoder_info_t *info);
+
+        /**
+         * @brief 定位后清除解码状态
+         */
+        void (*reset)(void *ctx);
+
+        /**
+         * @brief 释放解码器
+         */
+        void (*close)(void *ctx);
+    } mp3_decoder_backend_t;
+
+    /**
+     * @brief 按内容选择后端
+     * @param head 文件开头
+     * @param len head长度
+     * @return 后端, NULL表示交给esp-audio-player
+     */
+    const mp3_decoder_backend_t *mp3_decoder_select(const uint8_t *head, size_t len);
+
+    /**
+     * @brief 文件开头ID3v2标签的总长度 (含标签头和尾), 选择后端前跳过, 后端看到的head从标签之后开始
+     * @return 标签长度, 没有标签时为0
+     */
+    uint32_t mp3_decoder_id3_size(const uint8_t *head, size_t len);
+
+    /**
+     * @brief 分配解码用的缓冲区: 优先内部RAM, 不足时使用PSRAM
+     * @return 缓冲区, 用heap_caps_free释放
+     */
+    void *mp3_decoder_malloc(size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,139 @@
+/**
+ * @file mp3_decoder_esp.c
+ * @brief MP3后端: esp_audio_codec
+ * @details 使用Espressif预编译的esp_audio_codec MP3解码器 (静态库, 内部实现不在本仓库)。
+ *          与libhelix的CPU对比在板上用tools/host_bench测量。输入输出缓冲区由mp3_stream放在内部RAM。
+ */
+
+#include "mp3_decoder.h"
+#include "mp3_player.h"
+
+#if MP3_PLAYER_USE_ESP_AUDIO_CODEC
+
+#include <stdlib.h>
+#include "esp_log.h"
+#include "esp_audio_dec.h"
+#include "esp_mp3_dec.h"
+#include "mp3_seek.h"
+
+static const char *TAG = "mp3_dec_esp";
+
+static bool s_registered = false;
+
+static esp_err_t esp_mp3_create(esp_audio_dec_handle_t *dec)
+{
+    esp_audio_dec_cfg_t cfg = {
+        .type = ESP_AUDIO_TYPE_MP3,
+    };
+    return esp_audio_dec_open(&cfg, dec) == ESP_AUDIO_ERR_OK ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+static esp_err_t esp_mp3_open(void **ctx, const uint8_t *head, size_t len, uint32_t *data_offset)
+{
+    if (!s_registered)
+    {
+        if (esp_mp3_dec_register() != ESP_AUDIO_ERR_OK)
+        {
+            ESP_LOGE(TAG, "注册MP3解码器失败");
+            return ESP_FAIL;
+        }
+        s_registered = true;
+    }
+
+    esp_audio_dec_handle_t *dec = calloc(1, sizeof(esp_audio_dec_handle_t));
+    if (dec == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t ret = esp_mp3_create(dec);
+    if (ret != ESP_OK)
+    {
+        free(dec);
+        return ret;
+    }
+
+    *ctx = dec;
+    *data_offset = 0; // 标签已由mp3_player跳过, head从第一帧开始
+    return ESP_OK;
+}
+
+static esp_err_t esp_mp3_decode(void *ctx, const uint8_t *in, size_t in_len, size_t *consumed,
+                                int16_t **pcm, size_t *frames, mp3_decoder_info_t *info)
+{
+    esp_audio_dec_handle_t *dec = ctx;
+    if (*dec == NULL)
+    {
+        return ESP_FAIL;
+    }
+
+    esp_audio_dec_in_raw_t raw = {
+        .buffer = (uint8_t *)in,
+        .len = in_len,
+    };
+    esp_audio_dec_out_frame_t out = {
+        .buffer = (uint8_t *)*pcm,
+        .len = MP3_DECODER_MAX_FRAMES * 2 * sizeof(int16_t),
+    };
+
+    esp_audio_err_t ret = esp_audio_dec_process(*dec, &raw, &out);
+    *consumed = raw.consumed;
+    *frames = 0;
+
+    if (ret == ESP_AUDIO_ERR_DATA_LACK)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (ret != ESP_AUDIO_ERR_OK)
+    {
+        // 坏帧: 至少跳过一个字节, 下一次调用重新同步
+        if (*consumed == 0)
+        {
+            *consumed = 1;
+        }
+        return ESP_OK;
+    }
+
+    esp_audio_dec_info_t dec_info;
+    if (esp_audio_dec_get_info(*dec, &dec_info) != ESP_AUDIO_ERR_OK || dec_info.channel == 0)
+    {
+        return ESP_OK;
+    }
+    info->sample_rate = dec_info.sample_rate;
+    info->channels = dec_info.channel;
+    *frames = out.decoded_size / (dec_info.channel * sizeof(int16_t));
+    return ESP_OK;
+}
+
+static void esp_mp3_reset(void *ctx)
+{
+    // 重建解码器, 丢弃位储备(bit reservoir)和重叠相加的历史
+    esp_audio_dec_handle_t *dec = ctx;
+    esp_audio_dec_close(*dec);
+    *dec = NULL;
+    if (esp_mp3_create(dec) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "重建MP3解码器失败");
+    }
+}
+
+static void esp_mp3_close(void *ctx)
+{
+    esp_audio_dec_handle_t *dec = ctx;
+    if (*dec != NULL)
+    {
+        esp_audio_dec_close(*dec);
+    }
+    free(dec);
+}
+
+const mp3_decoder_backend_t mp3_decoder_esp_mp3 = {
+    .name = "esp_audio_codec MP3",
+    .mpeg_frames = true,
+    .probe = mp3_seek_check_head,
+    .open = esp_mp3_open,
+    .decode = esp_mp3_decode,
+    .reset = esp_mp3_reset,
+    .close = esp_mp3_close,
+};
+
+#endif // MP3_PLAYER_USE_ESP_AUDIO_CODEC
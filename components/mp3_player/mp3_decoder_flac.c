@@ -0,0 +1,697 @@
+/**
+ * @file mp3_decoder_flac.c
+ * @brief FLAC后端: 流式解码
+ * @details 支持1-2声道、4-24位、块大小不超过MP3_DECODER_FLAC_MAX_BLOCK的流(覆盖常见的压缩级别)。
+ *          元数据块在解码时逐段跳过(封面图片不占内存), 每帧完整读入输入缓冲区后一次解码,
+ *          各声道先解码为int32, 再在第一个声道的缓冲区内原地交织成int16, 分多次返回。
+ *          只校验帧头CRC-8用于确认同步, 不计算帧尾CRC-16。
+ */
+
+#include "mp3_decoder.h"
+#include <string.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+
+static const char *TAG = "mp3_dec_flac";
+
+#define MP3_DECODER_FLAC_MAX_BLOCK (4608)      // 支持的最大块大小 (每声道采样数)
+#define MP3_DECODER_FLAC_IN_BYTES (32 * 1024)  // 输入缓冲区, 需要容纳一整帧 (24位立体声4096块约20KB)
+
+typedef struct
+{
+    const uint8_t *buf;
+    size_t len;
+    size_t pos;     // 下一个装入cache的字节
+    uint64_t cache; // 高位对齐的待读位
+    int bits;       // cache中的有效位数
+    bool overrun;   // 读到了输入末尾之后
+} flac_bits_t;
+
+typedef struct
+{
+    uint32_t sample_rate;
+    uint8_t channels;
+    uint8_t bps;
+    uint16_t max_block;
+    uint32_t skip;      // 元数据块中还需跳过的字节
+    bool metadata;      // 还在元数据部分
+    int32_t *ch[2];     // 各声道解码结果, 输出时ch[0]原地变为交织int16
+    size_t out_frames;  // 当前帧的输出帧数
+    size_t out_pos;     // 已返回的帧数
+    size_t frame_bytes; // 当前帧的长度, 全部返回后计入consumed
+    uint32_t frame_rate;
+    uint8_t frame_channels;
+} flac_ctx_t;
+
+static inline void bits_fill(flac_bits_t *b)
+{
+    while (b->bits <= 56 && b->pos < b->len)
+    {
+        b->cache |= (uint64_t)b->buf[b->pos++] << (56 - b->bits);
+        b->bits += 8;
+    }
+}
+
+/**
+ * @brief 读取n位无符号数 (n <= 32)
+ */
+static inline uint32_t bits_read(flac_bits_t *b, int n)
+{
+    if (n == 0)
+    {
+        return 0;
+    }
+    if (b->bits < n)
+    {
+        bits_fill(b);
+        if (b->bits < n)
+        {
+            b->overrun = true;
+            return 0;
+        }
+    }
+    uint32_t v = (uint32_t)(b->cache >> (64 - n));
+    b->cache <<= n;
+    b->bits -= n;
+    return v;
+}
+
+static inline int32_t bits_read_signed(flac_bits_t *b, int n)
+{
+    if (n == 0)
+    {
+        return 0;
+    }
+    uint32_t v = bits_read(b, n);
+    return (int32_t)(v << (32 - n)) >> (32 - n);
+}
+
+/**
+ * @brief 读取一元编码 (连续0的个数, 以1结束)
+ */
+static inline uint32_t bits_unary(flac_bits_t *b)
+{
+    uint32_t q = 0;
+    while (true)
+    {
+        if (b->cache == 0)
+        {
+            // cache中的有效位全是0 (有效位之后总是0)
+            q += b->bits;
+            b->bits = 0;
+            bits_fill(b);
+            if (b->bits == 0)
+            {
+                b->overrun = true;
+                return 0;
+            }
+            continue;
+        }
+        int z = __builtin_clzll(b->cache);
+        b->cache <<= z;
+        b->cache <<= 1;
+        b->bits -= z + 1;
+        return q + z;
+    }
+}
+
+/**
+ * @brief 丢弃到字节边界, 返回已读取的字节数
+ */
+static size_t bits_align(flac_bits_t *b)
+{
+    int drop = b->bits & 7;
+    b->cache <<= drop;
+    b->bits -= drop;
+    return b->pos - b->bits / 8;
+}
+
+/**
+ * @brief 帧头CRC-8 (多项式0x07)
+ */
+static uint8_t flac_crc8(const uint8_t *p, size_t len)
+{
+    uint8_t crc = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= p[i];
+        for (int k = 0; k < 8; k++)
+        {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static bool flac_probe(const uint8_t *head, size_t len)
+{
+    // "fLaC" + STREAMINFO块头(类型0, 长度34) + STREAMINFO
+    if (len < 42 || memcmp(head, "fLaC", 4) != 0 || (head[4] & 0x7f) != 0 ||
+        head[5] != 0 || head[6] != 0 || head[7] != 34)
+    {
+        return false;
+    }
+    uint16_t max_block = (uint16_t)((head[10] << 8) | head[11]);
+    uint32_t max_frame = ((uint32_t)head[15] << 16) | ((uint32_t)head[16] << 8) | head[17];
+    uint32_t rate = ((uint32_t)head[18] << 12) | ((uint32_t)head[19] << 4) | (head[20] >> 4);
+    uint8_t channels = ((head[20] >> 1) & 0x07) + 1;
+    uint8_t bps = (((head[20] & 0x01) << 4) | (head[21] >> 4)) + 1;
+
+    return rate > 0 && channels <= 2 && bps >= 4 && bps <= 24 && max_block >= 16 &&
+           max_block <= MP3_DECODER_FLAC_MAX_BLOCK && max_frame <= MP3_DECODER_FLAC_IN_BYTES;
+}
+
+static esp_err_t flac_open(void **ctx, const uint8_t *head, size_t len, uint32_t *data_offset)
+{
+    if (!flac_probe(head, len))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    flac_ctx_t *f = calloc(1, sizeof(flac_ctx_t));
+    if (f == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    f->max_block = (uint16_t)((head[10] << 8) | head[11]);
+    f->sample_rate = ((uint32_t)head[18] << 12) | ((uint32_t)head[19] << 4) | (head[20] >> 4);
+    f->channels = ((head[20] >> 1) & 0x07) + 1;
+    f->bps = (((head[20] & 0x01) << 4) | (head[21] >> 4)) + 1;
+    f->metadata = true;
+
+    for (int c = 0; c < f->channels; c++)
+    {
+        f->ch[c] = mp3_decoder_malloc(f->max_block * sizeof(int32_t));
+        if (f->ch[c] == NULL)
+        {
+            heap_caps_free(f->ch[0]);
+            free(f);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    // 元数据块(包括STREAMINFO)在decode中逐个跳过
+    *ctx = f;
+    *data_offset = 4;
+    ESP_LOGI(TAG, "FLAC: %lu Hz, %u 声道, %u 位, 最大块 %u", (unsigned long)f->sample_rate, f->channels,
+             f->bps, f->max_block);
+    return ESP_OK;
+}
+
+/**
+ * @brief 解码残差 (Rice编码, 按分区)
+ */
+static bool flac_residual(flac_bits_t *b, int32_t *out, size_t block, int order)
+{
+    uint32_t method = bits_read(b, 2);
+    if (method > 1)
+    {
+        return false;
+    }
+    int param_bits = method == 0 ? 4 : 5;
+    uint32_t escape = method == 0 ? 0x0f : 0x1f;
+    int part_order = (int)bits_read(b, 4);
+    size_t parts = (size_t)1 << part_order;
+    size_t part_len = block >> part_order;
+    if ((part_len << part_order) != block || part_len < (size_t)order)
+    {
+        return false;
+    }
+
+    size_t i = order;
+    for (size_t p = 0; p < parts; p++)
+    {
+        size_t end = (p + 1) * part_len;
+        uint32_t k = bits_read(b, param_bits);
+        if (k == escape)
+        {
+            int raw = (int)bits_read(b, 5);
+            for (; i < end; i++)
+            {
+                out[i] = bits_read_signed(b, raw);
+            }
+        }
+        else
+        {
+            for (; i < end; i++)
+            {
+                uint32_t v = (bits_unary(b) << k) | bits_read(b, (int)k);
+                out[i] = (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+            }
+        }
+        if (b->overrun)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 固定预测器恢复 (原地)
+ */
+static void flac_restore_fixed(int32_t *s, size_t block, int order)
+{
+    switch (order)
+    {
+    case 1:
+        for (size_t i = 1; i < block; i++)
+        {
+            s[i] += s[i - 1];
+        }
+        break;
+    case 2:
+        for (size_t i = 2; i < block; i++)
+        {
+            s[i] += 2 * s[i - 1] - s[i - 2];
+        }
+        break;
+    case 3:
+        for (size_t i = 3; i < block; i++)
+        {
+            s[i] += 3 * (s[i - 1] - s[i - 2]) + s[i - 3];
+        }
+        break;
+    case 4:
+        for (size_t i = 4; i < block; i++)
+        {
+            s[i] += 4 * (s[i - 1] + s[i - 3]) - 6 * s[i - 2] - s[i - 4];
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief LPC恢复 (原地), 位宽允许时用32位累加
+ */
+static void flac_restore_lpc(int32_t *s, size_t block, const int32_t *coef, int order, int shift, bool wide)
+{
+    for (size_t i = order; i < block; i++)
+    {
+        const int32_t *hist = &s[i - 1];
+        if (wide)
+        {
+            int64_t sum = 0;
+            for (int j = 0; j < order; j++)
+            {
+                sum += (int64_t)coef[j] * hist[-j];
+            }
+            s[i] += (int32_t)(sum >> shift);
+        }
+        else
+        {
+            int32_t sum = 0;
+            for (int j = 0; j < order; j++)
+            {
+                sum += coef[j] * hist[-j];
+            }
+            s[i] += sum >> shift;
+        }
+    }
+}
+
+static int flac_ilog2(uint32_t v)
+{
+    int l = 0;
+    while (v >>= 1)
+    {
+        l++;
+    }
+    return l;
+}
+
+/**
+ * @brief 解码一个子帧
+ * @param bps 本声道采样位数 (side声道比其他声道多1位)
+ */
+static bool flac_subframe(flac_bits_t *b, int32_t *out, size_t block, int bps)
+{
+    if (bits_read(b, 1) != 0)
+    {
+        return false;
+    }
+    uint32_t type = bits_read(b, 6);
+    int wasted = 0;
+    if (bits_read(b, 1))
+    {
+        wasted = (int)bits_unary(b) + 1;
+        bps -= wasted;
+        if (bps <= 0)
+        {
+            return false;
+        }
+    }
+
+    if (type == 0)
+    {
+        // CONSTANT
+        int32_t v = bits_read_signed(b, bps);
+        for (size_t i = 0; i < block; i++)
+        {
+            out[i] = v;
+        }
+    }
+    else if (type == 1)
+    {
+        // VERBATIM
+        for (size_t i = 0; i < block; i++)
+        {
+            out[i] = bits_read_signed(b, bps);
+        }
+    }
+    else if (type >= 8 && type <= 12)
+    {
+        // FIXED, 阶数0-4
+        int order = (int)(type - 8);
+        if ((size_t)order > block)
+        {
+            return false;
+        }
+        for (int i = 0; i < order; i++)
+        {
+            out[i] = bits_read_signed(b, bps);
+        }
+        if (!flac_residual(b, out, block, order))
+        {
+            return false;
+        }
+        flac_restore_fixed(out, block, order);
+    }
+    else if (type >= 32)
+    {
+        // LPC, 阶数1-32
+        int order = (int)(type - 31);
+        int32_t coef[32];
+        if ((size_t)order > block)
+        {
+            return false;
+        }
+        for (int i = 0; i < order; i++)
+        {
+            out[i] = bits_read_signed(b, bps);
+        }
+        int precision = (int)bits_read(b, 4) + 1;
+        int shift = bits_read_signed(b, 5);
+        if (precision == 16 || shift < 0)
+        {
+            return false;
+        }
+        for (int i = 0; i < order; i++)
+        {
+            coef[i] = bits_read_signed(b, precision);
+        }
+        if (!flac_residual(b, out, block, order))
+        {
+            return false;
+        }
+        bool wide = bps + precision + flac_ilog2((uint32_t)order) > 32;
+        flac_restore_lpc(out, block, coef, order, shift, wide);
+    }
+    else
+    {
+        return false; // 保留的类型
+    }
+
+    if (wasted > 0)
+    {
+        for (size_t i = 0; i < block; i++)
+        {
+            out[i] <<= wasted;
+        }
+    }
+    return !b->overrun;
+}
+
+/**
+ * @brief 把各声道的int32结果转换成交织int16, 原地写入ch[0]
+ * @details 第i帧的输出正好占ch[0][i]的位置(立体声)或其前半(单声道), 顺序处理不会覆盖未读的数据
+ */
+static void flac_interleave(flac_ctx_t *f, size_t block, int bps, int channels)
+{
+    int16_t *out = (int16_t *)f->ch[0];
+    int shift = bps - 16;
+
+    for (size_t i = 0; i < block; i++)
+    {
+        for (int c = 0; c < channels; c++)
+        {
+            int32_t v = f->ch[c][i];
+            v = shift >= 0 ? v >> shift : v << -shift;
+            out[i * channels + c] = (int16_t)v;
+        }
+    }
+}
+
+/**
+ * @brief 查找帧同步字 (0xFFF8/0xFFF9)
+ * @return 同步字的位置, 没有找到时返回len
+ */
+static size_t flac_find_sync(const uint8_t *in, size_t len)
+{
+    for (size_t i = 0; i + 1 < len; i++)
+    {
+        if (in[i] == 0xff && (in[i + 1] & 0xfe) == 0xf8)
+        {
+            return i;
+        }
+    }
+    return len;
+}
+
+/**
+ * @brief 解码一帧到f->ch
+ * @return ESP_OK 成功; ESP_ERR_INVALID_SIZE 帧不完整; ESP_ERR_INVALID_CRC 不是有效的帧
+ */
+static esp_err_t flac_frame(flac_ctx_t *f, const uint8_t *in, size_t in_len)
+{
+    static const uint32_t s_rates[12] = {0, 88200, 176400, 192000, 8000, 16000,
+                                         22050, 24000, 32000, 44100, 48000, 96000};
+    static const uint8_t s_bps[8] = {0, 8, 12, 0, 16, 20, 24, 0};
+
+    flac_bits_t b = {.buf = in, .len = in_len};
+    bits_read(&b, 16); // 同步字和分块方式
+    uint32_t bs_code = bits_read(&b, 4);
+    uint32_t rate_code = bits_read(&b, 4);
+    uint32_t ch_code = bits_read(&b, 4);
+    uint32_t bps_code = bits_read(&b, 3);
+    if (bits_read(&b, 1) != 0 || bs_code == 0 || rate_code == 15 || ch_code > 10 || bps_code == 3 || bps_code == 7)
+    {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    // 帧号/采样号 (UTF-8方式扩展到最多7字节, 只需要跳过)
+    uint32_t lead = bits_read(&b, 8);
+    int extra = 0;
+    while (extra < 8 && (lead & (0x80 >> extra)))
+    {
+        extra++;
+    }
+    if (extra == 1 || extra == 8)
+    {
+        return ESP_ERR_INVALID_CRC;
+    }
+    for (int i = 1; i < extra; i++)
+    {
+        bits_read(&b, 8);
+    }
+
+    size_t block;
+    if (bs_code == 1)
+    {
+        block = 192;
+    }
+    else if (bs_code <= 5)
+    {
+        block = 576u << (bs_code - 2);
+    }
+    else if (bs_code == 6)
+    {
+        block = bits_read(&b, 8) + 1;
+    }
+    else if (bs_code == 7)
+    {
+        block = bits_read(&b, 16) + 1;
+    }
+    else
+    {
+        block = 256u << (bs_code - 8);
+    }
+
+    uint32_t rate = f->sample_rate;
+    if (rate_code >= 1 && rate_code <= 11)
+    {
+        rate = s_rates[rate_code];
+    }
+    else if (rate_code == 12)
+    {
+        rate = bits_read(&b, 8) * 1000;
+    }
+    else if (rate_code == 13)
+    {
+        rate = bits_read(&b, 16);
+    }
+    else if (rate_code == 14)
+    {
+        rate = bits_read(&b, 16) * 10;
+    }
+
+    size_t header_len = bits_align(&b);
+    uint8_t crc = (uint8_t)bits_read(&b, 8);
+    if (b.overrun)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (flac_crc8(in, header_len) != crc)
+    {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    int bps = bps_code == 0 ? f->bps : s_bps[bps_code];
+    int channels = ch_code < 8 ? (int)ch_code + 1 : 2;
+    if (channels != f->channels || block > f->max_block || rate == 0 || bps > 24)
+    {
+        ESP_LOGW(TAG, "跳过不支持的帧: %d 声道, 块 %u", channels, (unsigned)block);
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    for (int c = 0; c < channels; c++)
+    {
+        // 左/差、差/右、中/差立体声中的差声道多1位
+        bool side = (ch_code == 8 && c == 1) || (ch_code == 9 && c == 0) || (ch_code == 10 && c == 1);
+        if (!flac_subframe(&b, f->ch[c], block, bps + (side ? 1 : 0)))
+        {
+            return b.overrun ? ESP_ERR_INVALID_SIZE : ESP_ERR_INVALID_CRC;
+        }
+    }
+
+    int32_t *l = f->ch[0];
+    int32_t *r = f->ch[1];
+    if (ch_code == 8)
+    {
+        for (size_t i = 0; i < block; i++)
+        {
+            r[i] = l[i] - r[i];
+        }
+    }
+    else if (ch_code == 9)
+    {
+        for (size_t i = 0; i < block; i++)
+        {
+            l[i] += r[i];
+        }
+    }
+    else if (ch_code == 10)
+    {
+        for (size_t i = 0; i < block; i++)
+        {
+            int32_t mid = (l[i] << 1) | (r[i] & 1);
+            int32_t side = r[i];
+            l[i] = (mid + side) >> 1;
+            r[i] = (mid - side) >> 1;
+        }
+    }
+
+    // 帧尾: 对齐到字节后是CRC-16
+    size_t frame_len = bits_align(&b) + 2;
+    if (frame_len > in_len)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    flac_interleave(f, block, bps, channels);
+    f->out_frames = block;
+    f->out_pos = 0;
+    f->frame_bytes = frame_len;
+    f->frame_rate = rate;
+    f->frame_channels = (uint8_t)channels;
+    return ESP_OK;
+}
+
+static esp_err_t flac_decode(void *ctx, const uint8_t *in, size_t in_len, size_t *consumed,
+                             int16_t **pcm, size_t *frames, mp3_decoder_info_t *info)
+{
+    flac_ctx_t *f = ctx;
+    *consumed = 0;
+    *frames = 0;
+
+    if (f->out_pos == f->out_frames)
+    {
+        if (f->skip > 0)
+        {
+            *consumed = in_len < f->skip ? in_len : f->skip;
+            f->skip -= *consumed;
+            return ESP_OK;
+        }
+        if (f->metadata)
+        {
+            // 元数据块头: 最后一块标志 + 类型, 24位长度
+            if (in_len < 4)
+            {
+                return ESP_ERR_INVALID_SIZE;
+            }
+            f->metadata = (in[0] & 0x80) == 0;
+            f->skip = ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | in[3];
+            *consumed = 4;
+            return ESP_OK;
+        }
+
+        size_t sync = flac_find_sync(in, in_len);
+        if (sync > 0)
+        {
+            *consumed = sync == in_len ? in_len - 1 : sync; // 保留最后一个字节, 可能是同步字的前半
+            return *consumed > 0 ? ESP_OK : ESP_ERR_INVALID_SIZE;
+        }
+
+        esp_err_t ret = flac_frame(f, in, in_len);
+        if (ret == ESP_ERR_INVALID_SIZE)
+        {
+            return ret;
+        }
+        if (ret != ESP_OK)
+        {
+            *consumed = 1; // 不是有效的帧, 从下一个字节重新同步
+            return ESP_OK;
+        }
+    }
+
+    size_t n = f->out_frames - f->out_pos;
+    n = n < MP3_DECODER_MAX_FRAMES ? n : MP3_DECODER_MAX_FRAMES;
+    *pcm = (int16_t *)f->ch[0] + f->out_pos * f->frame_channels;
+    *frames = n;
+    f->out_pos += n;
+    if (f->out_pos == f->out_frames)
+    {
+        *consumed = f->frame_bytes;
+    }
+    info->sample_rate = f->frame_rate;
+    info->channels = f->frame_channels;
+    return ESP_OK;
+}
+
+static void flac_reset(void *ctx)
+{
+    flac_ctx_t *f = ctx;
+    f->out_frames = 0;
+    f->out_pos = 0;
+}
+
+static void flac_close(void *ctx)
+{
+    flac_ctx_t *f = ctx;
+    heap_caps_free(f->ch[0]);
+    heap_caps_free(f->ch[1]);
+    free(f);
+}
+
+const mp3_decoder_backend_t mp3_decoder_flac = {
+    .name = "FLAC",
+    .in_bytes = MP3_DECODER_FLAC_IN_BYTES,
+    .probe = flac_probe,
+    .open = flac_open,
+    .decode = flac_decode,
+    .reset = flac_reset,
+    .close = flac_close,
+};
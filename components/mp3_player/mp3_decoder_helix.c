@@ -0,0 +1,129 @@
+/**
+ * @file mp3_decoder_helix.c
+ * @brief MP3后端: libhelix
+ * @details 与esp-audio-player相同的定点解码器(源码随chmorgan/esp-libhelix-mp3编译, 任何目标都能构建)。
+ *          MP3_PLAYER_USE_ESP_AUDIO_CODEC为0时播放器用它解码MP3; tools/host_bench在linux目标上
+ *          也通过本后端测量MP3的解码耗时, 在esp32s3上与esp_audio_codec后端对比。
+ */
+
+#include "mp3_decoder.h"
+#include <stdlib.h>
+#include "esp_log.h"
+#include "mp3dec.h"
+#include "mp3_seek.h"
+
+static const char *TAG = "mp3_dec_helix";
+
+static esp_err_t helix_mp3_open(void **ctx, const uint8_t *head, size_t len, uint32_t *data_offset)
+{
+    (void)head;
+    (void)len;
+    HMP3Decoder *dec = calloc(1, sizeof(HMP3Decoder));
+    if (dec == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    *dec = MP3InitDecoder();
+    if (*dec == NULL)
+    {
+        free(dec);
+        return ESP_ERR_NO_MEM;
+    }
+    *ctx = dec;
+    *data_offset = 0; // 标签已由mp3_player跳过, head从第一帧开始
+    return ESP_OK;
+}
+
+static esp_err_t helix_mp3_decode(void *ctx, const uint8_t *in, size_t in_len, size_t *consumed,
+                                  int16_t **pcm, size_t *frames, mp3_decoder_info_t *info)
+{
+    HMP3Decoder *dec = ctx;
+    *consumed = 0;
+    *frames = 0;
+    if (*dec == NULL)
+    {
+        return ESP_FAIL;
+    }
+
+    // MP3Decode要求输入从帧头开始; 同步字之前的数据直接丢弃
+    int offset = MP3FindSyncWord((unsigned char *)in, (int)in_len);
+    if (offset < 0)
+    {
+        // 保留最后一个字节, 同步字可能跨越缓冲区边界
+        *consumed = in_len > 1 ? in_len - 1 : 0;
+        return *consumed > 0 ? ESP_OK : ESP_ERR_INVALID_SIZE;
+    }
+    if (offset > 0)
+    {
+        *consumed = offset;
+        return ESP_OK;
+    }
+
+    unsigned char *p = (unsigned char *)in;
+    int left = (int)in_len;
+    int err = MP3Decode(*dec, &p, &left, *pcm, 0);
+    *consumed = in_len - left;
+
+    if (err == ERR_MP3_INDATA_UNDERFLOW)
+    {
+        *consumed = 0;
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (err == ERR_MP3_MAINDATA_UNDERFLOW)
+    {
+        // 位储备还不完整(开头或定位后的前几帧), 帧已消耗, 没有输出
+        return ESP_OK;
+    }
+    if (err != ERR_MP3_NONE)
+    {
+        // 坏帧或误判的同步字: 至少跳过一个字节, 下一次调用重新同步
+        if (*consumed == 0)
+        {
+            *consumed = 1;
+        }
+        return ESP_OK;
+    }
+
+    MP3FrameInfo fi;
+    MP3GetLastFrameInfo(*dec, &fi);
+    if (fi.nChans < 1 || fi.nChans > 2 || fi.outputSamps == 0)
+    {
+        return ESP_OK;
+    }
+    info->sample_rate = fi.samprate;
+    info->channels = fi.nChans;
+    *frames = fi.outputSamps / fi.nChans;
+    return ESP_OK;
+}
+
+static void helix_mp3_reset(void *ctx)
+{
+    // libhelix没有复位接口, 重建解码器丢弃位储备(bit reservoir)和重叠相加的历史
+    HMP3Decoder *dec = ctx;
+    MP3FreeDecoder(*dec);
+    *dec = MP3InitDecoder();
+    if (*dec == NULL)
+    {
+        ESP_LOGE(TAG, "重建MP3解码器失败");
+    }
+}
+
+static void helix_mp3_close(void *ctx)
+{
+    HMP3Decoder *dec = ctx;
+    if (*dec != NULL)
+    {
+        MP3FreeDecoder(*dec);
+    }
+    free(dec);
+}
+
+const mp3_decoder_backend_t mp3_decoder_helix_mp3 = {
+    .name = "libhelix MP3",
+    .mpeg_frames = true,
+    .probe = mp3_seek_check_head,
+    .open = helix_mp3_open,
+    .decode = helix_mp3_decode,
+    .reset = helix_mp3_reset,
+    .close = helix_mp3_close,
+};
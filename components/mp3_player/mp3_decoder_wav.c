@@ -0,0 +1,247 @@
+/**
+ * @file mp3_decoder_wav.c
+ * @brief WAV后端: 16位PCM和IMA-ADPCM
+ * @details 按块(chunk)解析文件头, 只播放data块, 录音文件data块之后的cue/LIST块不会被当作音频。
+ *          立体声PCM直接把输入缓冲区交给混音器, 不经过中间拷贝(小端格式与内存布局一致);
+ *          IMA-ADPCM按块解码, 用于播放audio_app录制的压缩录音。
+ */
+
+#include "mp3_decoder.h"
+#include <string.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "audio_dsp_adpcm.h"
+
+static const char *TAG = "mp3_dec_wav";
+
+#define WAV_FORMAT_PCM (0x0001)
+#define WAV_FORMAT_IMA_ADPCM (0x0011)
+#define WAV_ADPCM_MAX_BLOCK (4096) // 支持的最大ADPCM块 (单声道8185帧)
+
+typedef struct
+{
+    uint16_t format;
+    uint16_t channels;
+    uint32_t sample_rate;
+    uint16_t block_align;
+    uint16_t bits;
+    uint32_t data_offset;
+    uint32_t data_size; // 未知(录音未正常结束)时为UINT32_MAX, 播放到文件末尾
+} wav_info_t;
+
+typedef struct
+{
+    wav_info_t wav;
+    uint32_t remaining; // data块中未解码的字节数
+    // ADPCM: 当前块的解码输出, 分多次返回
+    int16_t *block;
+    size_t block_frames;
+    size_t block_pos;
+} wav_ctx_t;
+
+static uint16_t wav_rd16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t wav_rd32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief 解析RIFF块直到data块
+ * @return true 在head范围内找到了fmt和data块
+ */
+static bool wav_parse(const uint8_t *head, size_t len, wav_info_t *wav)
+{
+    if (len < 12 || memcmp(head, "RIFF", 4) != 0 || memcmp(head + 8, "WAVE", 4) != 0)
+    {
+        return false;
+    }
+
+    bool have_fmt = false;
+    size_t pos = 12;
+    while (pos + 8 <= len)
+    {
+        const uint8_t *chunk = head + pos;
+        uint32_t size = wav_rd32(chunk + 4);
+
+        if (memcmp(chunk, "data", 4) == 0)
+        {
+            wav->data_offset = pos + 8;
+            wav->data_size = (size == 0) ? UINT32_MAX : size;
+            return have_fmt;
+        }
+        if (size > len - pos - 8)
+        {
+            return false; // 块超出了文件头的范围
+        }
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16)
+        {
+            wav->format = wav_rd16(chunk + 8);
+            wav->channels = wav_rd16(chunk + 10);
+            wav->sample_rate = wav_rd32(chunk + 12);
+            wav->block_align = wav_rd16(chunk + 20);
+            wav->bits = wav_rd16(chunk + 22);
+            have_fmt = true;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    return false;
+}
+
+static bool wav_pcm_probe(const uint8_t *head, size_t len)
+{
+    wav_info_t wav;
+    return wav_parse(head, len, &wav) && wav.format == WAV_FORMAT_PCM && wav.bits == 16 &&
+           wav.channels >= 1 && wav.channels <= 2 && wav.block_align == 2 * wav.channels && wav.sample_rate > 0;
+}
+
+static bool wav_adpcm_probe(const uint8_t *head, size_t len)
+{
+    wav_info_t wav;
+    if (!wav_parse(head, len, &wav) || wav.format != WAV_FORMAT_IMA_ADPCM || wav.bits != 4 ||
+        wav.channels < 1 || wav.channels > 2 || wav.sample_rate == 0)
+    {
+        return false;
+    }
+    // 立体声块在块头之后按8字节一组交替存放两个声道
+    size_t header = 4 * wav.channels;
+    return wav.block_align > header && wav.block_align <= WAV_ADPCM_MAX_BLOCK &&
+           (wav.channels == 1 || (wav.block_align - header) % 8 == 0);
+}
+
+static esp_err_t wav_open(void **ctx, const uint8_t *head, size_t len, uint32_t *data_offset)
+{
+    wav_ctx_t *w = calloc(1, sizeof(wav_ctx_t));
+    if (w == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    if (!wav_parse(head, len, &w->wav))
+    {
+        free(w);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (w->wav.format == WAV_FORMAT_IMA_ADPCM)
+    {
+        size_t frames = AUDIO_DSP_ADPCM_FRAMES_PER_BLOCK(w->wav.block_align, w->wav.channels);
+        w->block = mp3_decoder_malloc(frames * w->wav.channels * sizeof(int16_t));
+        if (w->block == NULL)
+        {
+            free(w);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    w->remaining = w->wav.data_size;
+    *ctx = w;
+    *data_offset = w->wav.data_offset;
+    ESP_LOGI(TAG, "WAV: 格式0x%04x, %lu Hz, %u 声道, data %lu 字节", w->wav.format,
+             (unsigned long)w->wav.sample_rate, w->wav.channels, (unsigned long)w->wav.data_size);
+    return ESP_OK;
+}
+
+static esp_err_t wav_pcm_decode(void *ctx, const uint8_t *in, size_t in_len, size_t *consumed,
+                                int16_t **pcm, size_t *frames, mp3_decoder_info_t *info)
+{
+    wav_ctx_t *w = ctx;
+    size_t frame_bytes = w->wav.block_align;
+
+    *consumed = 0;
+    *frames = 0;
+    if (w->remaining < frame_bytes)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    size_t n = in_len < w->remaining ? in_len : w->remaining;
+    n = n < MP3_DECODER_MAX_FRAMES * frame_bytes ? n : MP3_DECODER_MAX_FRAMES * frame_bytes;
+    n -= n % frame_bytes;
+    if (n == 0)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // 零拷贝: 输入位置总是帧长的整数倍, 直接把输入缓冲区当作输出
+    *pcm = (int16_t *)in;
+    *consumed = n;
+    *frames = n / frame_bytes;
+    w->remaining -= n;
+    info->sample_rate = w->wav.sample_rate;
+    info->channels = w->wav.channels;
+    return ESP_OK;
+}
+
+static esp_err_t wav_adpcm_decode(void *ctx, const uint8_t *in, size_t in_len, size_t *consumed,
+                                  int16_t **pcm, size_t *frames, mp3_decoder_info_t *info)
+{
+    wav_ctx_t *w = ctx;
+    size_t block_bytes = w->remaining < w->wav.block_align ? w->remaining : w->wav.block_align;
+
+    *consumed = 0;
+    *frames = 0;
+    if (w->block_pos == w->block_frames)
+    {
+        // 上一块已全部返回, 解码下一块 (文件末尾可能是不完整的块)
+        if (block_bytes <= 4u * w->wav.channels)
+        {
+            return ESP_ERR_NOT_FOUND;
+        }
+        if (in_len < block_bytes)
+        {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        w->block_frames = audio_dsp_adpcm_decode_block(in, block_bytes, w->wav.channels, w->block);
+        w->block_pos = 0;
+    }
+
+    size_t n = w->block_frames - w->block_pos;
+    n = n < MP3_DECODER_MAX_FRAMES ? n : MP3_DECODER_MAX_FRAMES;
+    *pcm = w->block + w->block_pos * w->wav.channels;
+    *frames = n;
+    w->block_pos += n;
+    if (w->block_pos == w->block_frames)
+    {
+        *consumed = block_bytes;
+        w->remaining -= block_bytes;
+    }
+    info->sample_rate = w->wav.sample_rate;
+    info->channels = w->wav.channels;
+    return ESP_OK;
+}
+
+static void wav_reset(void *ctx)
+{
+    wav_ctx_t *w = ctx;
+    w->block_frames = 0;
+    w->block_pos = 0;
+}
+
+static void wav_close(void *ctx)
+{
+    wav_ctx_t *w = ctx;
+    heap_caps_free(w->block);
+    free(w);
+}
+
+const mp3_decoder_backend_t mp3_decoder_wav_pcm = {
+    .name = "WAV PCM",
+    .probe = wav_pcm_probe,
+    .open = wav_open,
+    .decode = wav_pcm_decode,
+    .reset = wav_reset,
+    .close = wav_close,
+};
+
+const mp3_decoder_backend_t mp3_decoder_wav_adpcm = {
+    .name = "WAV IMA-ADPCM",
+    .probe = wav_adpcm_probe,
+    .open = wav_open,
+    .decode = wav_adpcm_decode,
+    .reset = wav_reset,
+    .close = wav_close,
+};
@@ -0,0 +1,68 @@
+/**
+ * @file mp3_frame.c
+ * @brief MPEG音频帧头解析
+ * @details 只依赖输入缓冲区, 不访问文件和RTOS; 解码器后端和tools/host_bench(linux目标)直接编译本文件。
+ */
+
+#include "mp3_seek.h"
+
+// Layer III 码率表 (kbps): [0]=MPEG1, [1]=MPEG2/2.5
+static const uint16_t s_bitrate_l3[2][16] = {
+    {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0},
+    {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0},
+};
+
+// 采样率表: [version][index], version: 0=MPEG2.5, 2=MPEG2, 3=MPEG1
+static const uint32_t s_sample_rate[4][3] = {
+    {11025, 12000, 8000},
+    {0, 0, 0},
+    {22050, 24000, 16000},
+    {44100, 48000, 32000},
+};
+
+bool mp3_seek_parse_header(const uint8_t *hdr, mp3_frame_info_t *info)
+{
+    // 11位同步字
+    if (hdr[0] != 0xFF || (hdr[1] & 0xE0) != 0xE0)
+    {
+        return false;
+    }
+
+    uint8_t version = (hdr[1] >> 3) & 0x03;
+    uint8_t layer = (hdr[1] >> 1) & 0x03;
+    uint8_t bitrate_idx = (hdr[2] >> 4) & 0x0F;
+    uint8_t rate_idx = (hdr[2] >> 2) & 0x03;
+    uint8_t padding = (hdr[2] >> 1) & 0x01;
+    uint8_t mode = (hdr[3] >> 6) & 0x03;
+
+    // 只处理Layer III; 排除保留版本、自由码率和非法采样率
+    if (version == 1 || layer != 1 || bitrate_idx == 0 || bitrate_idx == 15 || rate_idx == 3)
+    {
+        return false;
+    }
+
+    info->version = version;
+    info->channels = (mode == 3) ? 1 : 2;
+    info->sample_rate = s_sample_rate[version][rate_idx];
+    info->bitrate_kbps = s_bitrate_l3[version == 3 ? 0 : 1][bitrate_idx];
+    info->samples_per_frame = (version == 3) ? 1152 : 576;
+    // 帧长度 = 每帧采样数/8 * 码率 / 采样率 + 填充
+    info->frame_len = (info->samples_per_frame / 8) * info->bitrate_kbps * 1000 / info->sample_rate + padding;
+    return true;
+}
+
+bool mp3_seek_check_head(const uint8_t *head, size_t len)
+{
+    mp3_frame_info_t first;
+    mp3_frame_info_t second;
+    if (len < 4 || !mp3_seek_parse_header(head, &first))
+    {
+        return false;
+    }
+    if (first.frame_len + 4 > len)
+    {
+        return true;
+    }
+    return mp3_seek_parse_header(head + first.frame_len, &second) && second.version == first.version &&
+           second.sample_rate == first.sample_rate;
+}
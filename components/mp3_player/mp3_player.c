@@ -1,13 +1,86 @@
 #include "mp3_player.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "esp_log.h"
 #include "esp_spiffs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "audio_player.h"
 #include "audio_codec.h"
+#include "audio_mixer.h"
+#include "mp3_seek.h"
+#include "mp3_decoder.h"
+#include "mp3_stream.h"
 
 static const char *TAG = "mp3_player";
 
+// 当前播放文件 (fp由audio_player或mp3_stream接管, 这里只用来判断有没有当前文件)
+static SemaphoreHandle_t s_play_mutex = NULL;
+static FILE *s_current_fp = NULL;
+static char s_current_path[128] = {0};
+static mp3_seek_info_t s_seek_info;
+// 当前文件由组件内解码器(mp3_stream)播放, 否则由audio_player播放
+static bool s_native = false;
+
+// 播放位置 = 最近一次定位的时间 + 之后写入I2S的采样数
+static uint32_t s_position_base_ms = 0;
+static uint64_t s_frames_written = 0;
+static uint32_t s_out_sample_rate = AUDIO_DEFAULT_SAMPLE_RATE;
+static uint32_t s_out_frame_bytes = AUDIO_DEFAULT_CHANNELS * AUDIO_DEFAULT_BITS_PER_SAMPLE / 8;
+
+// audio_player播放的每个文件(包括定位后的视图)带一个代号, 用来区分旧文件的空闲事件和写入
+static uint32_t s_gen_counter = 0;          // 最近分配的代号 (持有s_play_mutex时修改)
+static uint32_t s_file_gen = 0;             // 当前文件的代号, 0表示没有 (持有s_play_mutex并在s_pos_lock内修改)
+static volatile uint32_t s_closed_gen = 0;  // audio_player最近关闭的文件
+static volatile uint32_t s_reading_gen = 0; // audio_player任务正在解码的文件 (只有该任务写入)
+// s_file_gen、s_position_base_ms和s_frames_written一起修改/读取, 写入回调中不能使用互斥锁
+static portMUX_TYPE s_pos_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief 设置播放位置的起点, 写入计数从零开始
+ */
+static void reset_position(uint32_t base_ms)
+{
+    portENTER_CRITICAL(&s_pos_lock);
+    s_position_base_ms = base_ms;
+    s_frames_written = 0;
+    portEXIT_CRITICAL(&s_pos_lock);
+}
+
+/**
+ * @brief 释放当前文件的定位信息
+ * @note 调用者需持有s_play_mutex
+ */
+static void clear_current_file(void)
+{
+    s_native = false;
+    s_current_fp = NULL;
+    s_current_path[0] = '\0';
+    mp3_seek_info_free(&s_seek_info);
+    // audio_player中还没结束的旧文件, 之后的写入全部丢弃
+    portENTER_CRITICAL(&s_pos_lock);
+    s_file_gen = 0;
+    portEXIT_CRITICAL(&s_pos_lock);
+}
+
+/**
+ * @brief 当前文件播放结束后(解码器已关闭fp)清除当前文件
+ * @details audio_player的空闲事件不带文件信息, 定位或切换文件时旧文件的空闲事件可能排在s_play_mutex后面;
+ *          只有当前代号的文件已被关闭才算结束
+ * @note 调用者需持有s_play_mutex
+ */
+static void check_finished(void)
+{
+    bool finished = s_native ? mp3_stream_get_state() == AUDIO_PLAYER_STATE_IDLE
+                             : (s_current_fp != NULL && s_closed_gen == s_file_gen);
+    if (finished)
+    {
+        clear_current_file();
+    }
+}
+
 // 音频播放器回调函数
 static void audio_player_callback(audio_player_cb_ctx_t *ctx)
 {
@@ -15,6 +88,10 @@ static void audio_player_callback(audio_player_cb_ctx_t *ctx)
     {
     case AUDIO_PLAYER_CALLBACK_EVENT_IDLE:
         ESP_LOGI(TAG, "播放器状态: 空闲");
+        // 播放结束后audio_player已关闭fp, 不能再用于定位; 旧文件的空闲事件不清除新文件
+        xSemaphoreTake(s_play_mutex, portMAX_DELAY);
+        check_finished();
+        xSemaphoreGive(s_play_mutex);
         break;
     case AUDIO_PLAYER_CALLBACK_EVENT_PLAYING:
         ESP_LOGI(TAG, "播放器状态: 正在播放");
@@ -38,30 +115,48 @@ static void audio_player_callback(audio_player_cb_ctx_t *ctx)
 }
 
 // 静音控制回调
+// 只静音音乐流(短渐变), 不影响混音器中的UI音效
 static esp_err_t audio_mute_callback(AUDIO_PLAYER_MUTE_SETTING setting)
 {
     bool mute = (setting == AUDIO_PLAYER_MUTE);
     ESP_LOGI(TAG, "静音设置: %s", mute ? "开启" : "关闭");
-    return audio_codec_set_mute(mute);
+    return audio_mixer_set_gain(AUDIO_MIXER_STREAM_MUSIC, mute ? 0.0f : 1.0f, 10);
 }
 
 // I2S写入回调
+// 解码数据写入混音器的音乐流, 由混音任务与音效叠加后写入codec
+// 定位或切换文件后, 旧文件剩余的数据直接丢弃, 不写入混音器也不计入播放位置
 static esp_err_t audio_write_callback(void *audio_buffer, size_t len, size_t *bytes_written, uint32_t timeout_ms)
 {
-    esp_codec_dev_handle_t playback_dev = audio_codec_get_playback_dev();
-    if (playback_dev == NULL)
+    uint32_t gen = s_reading_gen;
+    if (gen != s_file_gen)
     {
-        ESP_LOGE(TAG, "播放设备未初始化");
-        return ESP_FAIL;
-    }
-
-    int ret = esp_codec_dev_write(playback_dev, audio_buffer, len);
-    if (ret == 0) {
         *bytes_written = len;
         return ESP_OK;
     }
-    *bytes_written = 0;
-    return ESP_FAIL;
+
+    esp_err_t ret = audio_mixer_write(AUDIO_MIXER_STREAM_MUSIC, audio_buffer, len, timeout_ms);
+    if (ret != ESP_OK)
+    {
+        *bytes_written = 0;
+        return ret;
+    }
+    *bytes_written = len;
+
+    portENTER_CRITICAL(&s_pos_lock);
+    uint32_t current = s_file_gen;
+    if (gen == current)
+    {
+        s_frames_written += len / s_out_frame_bytes;
+    }
+    portEXIT_CRITICAL(&s_pos_lock);
+    if (gen != current && current != 0)
+    {
+        // 写入期间定位到了新的视图, 这一块可能在定位清空混音器之后才写入;
+        // 新视图的数据也由本任务写入, 此时还没有开始, 可以整体清空
+        audio_mixer_flush(AUDIO_MIXER_STREAM_MUSIC);
+    }
+    return ESP_OK;
 }
 
 // I2S时钟重配置回调
@@ -75,6 +170,10 @@ static esp_err_t audio_clk_reconfig_callback(uint32_t rate, uint32_t bits_cfg, i
     // 因为audio_codec已经配置好了,通常不需要动态改变
     // 如果需要支持不同采样率的MP3文件,可以在这里实现
 
+    // 记录解码输出格式, 用于把写入字节数换算成播放时间
+    s_out_sample_rate = rate;
+    s_out_frame_bytes = bits_cfg * (ch == I2S_SLOT_MODE_MONO ? 1 : 2) / 8;
+
     return ESP_OK;
 }
 
@@ -82,6 +181,15 @@ esp_err_t mp3_player_init(void)
 {
     ESP_LOGI(TAG, "初始化MP3播放器");
 
+    if (s_play_mutex == NULL)
+    {
+        s_play_mutex = xSemaphoreCreateMutex();
+        if (s_play_mutex == NULL)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
     // 配置audio_player
     audio_player_config_t config = {
         .mute_fn = audio_mute_callback,
@@ -107,35 +215,124 @@ esp_err_t mp3_player_init(void)
         return ret;
     }
 
+    ret = mp3_stream_init();
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "创建解码播放任务失败: %s", esp_err_to_name(ret));
+        audio_player_delete();
+        return ret;
+    }
+
     ESP_LOGI(TAG, "MP3播放器初始化成功");
     return ESP_OK;
 }
 
-esp_err_t mp3_player_play_file(const char *file_path)
+/**
+ * @brief audio_player播放的文件视图: 位置0对应offset处的帧, 带当前文件的代号
+ * @details audio_player没有清空输入缓冲区和重置解码器的接口, 定位时把视图当作新文件重新播放:
+ *          格式检测时回到的"开头"就是目标帧, 缓冲区中旧位置的数据和位储备都随旧文件丢弃。
+ *          新文件同样经过视图(offset为0), 读取和关闭时记录代号, 用于区分旧文件的写入和空闲事件
+ */
+typedef struct
 {
-    if (file_path == NULL)
+    FILE *fp;
+    long base;
+    uint32_t gen;
+} seek_view_t;
+
+static int seek_view_read(void *cookie, char *buf, _READ_WRITE_BUFSIZE_TYPE len)
+{
+    seek_view_t *v = cookie;
+    s_reading_gen = v->gen;
+    return (int)fread(buf, 1, (size_t)len, v->fp);
+}
+
+static _fpos_t seek_view_seek(void *cookie, _fpos_t pos, int whence)
+{
+    seek_view_t *v = cookie;
+    if (whence == SEEK_END && fseek(v->fp, 0, SEEK_END) != 0)
     {
-        ESP_LOGE(TAG, "文件路径为空");
-        return ESP_ERR_INVALID_ARG;
+        return -1;
     }
+    long target = (whence == SEEK_SET ? v->base : ftell(v->fp)) + (long)pos;
+    if (target < v->base || fseek(v->fp, target, SEEK_SET) != 0)
+    {
+        return -1;
+    }
+    return target - v->base;
+}
 
-    // 检测文件格式
-    const char *file_ext = strrchr(file_path, '.');
-    const char *format_name = "未知";
+static int seek_view_close(void *cookie)
+{
+    seek_view_t *v = cookie;
+    s_closed_gen = v->gen;
+    int ret = fclose(v->fp);
+    free(v);
+    return ret;
+}
 
-    if (file_ext != NULL)
+/**
+ * @brief audio_player从offset处开始播放文件
+ * @details 切换代号、清空混音器中的音乐数据和重置播放位置一起完成, 之后旧文件的写入都被丢弃
+ * @param fp 已打开的文件, 无论成败都由本函数接管 (成功后由audio_player关闭, 旧的fp也由它关闭)
+ * @param offset 开始播放的文件偏移
+ * @param position_ms offset对应的播放时间
+ * @note 调用者需持有s_play_mutex
+ */
+static esp_err_t start_audio_player_at(FILE *fp, uint32_t offset, uint32_t position_ms)
+{
+    seek_view_t *v = malloc(sizeof(*v));
+    if (v == NULL)
     {
-        if (strcasecmp(file_ext, ".mp3") == 0)
-        {
-            format_name = "MP3";
-        }
-        else if (strcasecmp(file_ext, ".wav") == 0)
-        {
-            format_name = "WAV";
-        }
+        fclose(fp);
+        return ESP_ERR_NO_MEM;
+    }
+    v->fp = fp;
+    v->base = (long)offset;
+    v->gen = ++s_gen_counter;
+    FILE *view = funopen(v, seek_view_read, NULL, seek_view_seek, seek_view_close);
+    if (view == NULL)
+    {
+        free(v);
+        fclose(fp);
+        return ESP_FAIL;
     }
 
-    ESP_LOGI(TAG, "准备播放文件: %s (格式: %s)", file_path, format_name);
+    portENTER_CRITICAL(&s_pos_lock);
+    uint32_t prev_gen = s_file_gen;
+    uint32_t prev_base_ms = s_position_base_ms;
+    uint64_t prev_frames = s_frames_written;
+    s_file_gen = v->gen;
+    s_position_base_ms = position_ms;
+    s_frames_written = 0;
+    portEXIT_CRITICAL(&s_pos_lock);
+    audio_mixer_flush(AUDIO_MIXER_STREAM_MUSIC);
+
+    esp_err_t ret = audio_player_play(view);
+    if (ret != ESP_OK)
+    {
+        // 旧文件(如果有)继续播放
+        portENTER_CRITICAL(&s_pos_lock);
+        s_file_gen = prev_gen;
+        s_position_base_ms = prev_base_ms;
+        s_frames_written = prev_frames;
+        portEXIT_CRITICAL(&s_pos_lock);
+        fclose(view); // 同时关闭fp
+        return ret;
+    }
+    s_current_fp = view;
+    return ESP_OK;
+}
+
+esp_err_t mp3_player_play_file(const char *file_path)
+{
+    if (file_path == NULL)
+    {
+        ESP_LOGE(TAG, "文件路径为空");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ESP_LOGI(TAG, "准备播放文件: %s", file_path);
 
     // 打开文件
     FILE *fp = fopen(file_path, "rb");
@@ -151,45 +348,243 @@ esp_err_t mp3_player_play_file(const char *file_path)
     fseek(fp, 0, SEEK_SET);
     ESP_LOGI(TAG, "文件大小: %ld 字节 (%.2f MB)", file_size, file_size / 1024.0 / 1024.0);
 
-    // 调用audio_player播放 (自动识别MP3和WAV格式)
-    // 注意: audio_player_play会接管fp的生命周期,播放完成后会自动fclose
-    esp_err_t ret = audio_player_play(fp);
+    // 按文件内容(而不是扩展名)选择解码后端; ID3v2标签(可能有几十KB的封面)之后的数据才用于判断
+    uint8_t head[MP3_DECODER_PROBE_BYTES];
+    size_t head_len = fread(head, 1, sizeof(head), fp);
+    uint32_t head_offset = mp3_decoder_id3_size(head, head_len);
+    if (head_offset > 0)
+    {
+        head_len = (fseek(fp, head_offset, SEEK_SET) == 0) ? fread(head, 1, sizeof(head), fp) : 0;
+    }
+    fseek(fp, 0, SEEK_SET);
+    const mp3_decoder_backend_t *backend = mp3_decoder_select(head, head_len);
+    const char *format_name = backend != NULL ? backend->name : "esp-audio-player";
+    ESP_LOGI(TAG, "解码器: %s", format_name);
+
+    xSemaphoreTake(s_play_mutex, portMAX_DELAY);
+
+    // 停止另一条播放路径上的文件
+    if (s_native && backend == NULL)
+    {
+        mp3_stream_stop();
+    }
+    else if (!s_native && backend != NULL && audio_player_get_state() != AUDIO_PLAYER_STATE_IDLE)
+    {
+        audio_player_stop();
+        audio_mixer_flush(AUDIO_MIXER_STREAM_MUSIC);
+    }
+    clear_current_file();
+
+    // 解析ID3/Xing/VBRI头, 确定定位方式 (非MP3文件不支持定位)
+    if (backend == NULL || backend->mpeg_frames)
+    {
+        mp3_seek_probe(fp, (uint32_t)file_size, &s_seek_info);
+    }
+    else
+    {
+        memset(&s_seek_info, 0, sizeof(s_seek_info)); // 不保留上一个文件的时长
+    }
+
+    esp_err_t ret;
+    if (backend != NULL)
+    {
+        // 组件内解码器, 成功时mp3_stream接管fp
+        ret = mp3_stream_play(fp, file_path, backend, head, head_len, head_offset);
+        s_native = (ret == ESP_OK);
+        if (ret == ESP_OK)
+        {
+            s_current_fp = fp;
+            reset_position(0);
+        }
+        else
+        {
+            fclose(fp); // 如果播放失败,需要手动关闭文件
+        }
+    }
+    else
+    {
+        // 调用audio_player播放 (自动识别MP3和WAV格式)
+        // 注意: audio_player接管fp的生命周期(包括失败时), 播放完成后会自动fclose
+        ret = start_audio_player_at(fp, 0, 0);
+    }
     if (ret != ESP_OK)
     {
         ESP_LOGE(TAG, "播放失败: %s", esp_err_to_name(ret));
-        fclose(fp); // 如果播放失败,需要手动关闭文件
+        mp3_seek_info_free(&s_seek_info);
+        xSemaphoreGive(s_play_mutex);
         return ret;
     }
 
-    ESP_LOGI(TAG, "开始播放 %s 文件", format_name);
+    strncpy(s_current_path, file_path, sizeof(s_current_path) - 1);
+    s_current_path[sizeof(s_current_path) - 1] = '\0';
+    xSemaphoreGive(s_play_mutex);
+
+    ESP_LOGI(TAG, "开始播放 (%s)", format_name);
     return ESP_OK;
 }
 
 esp_err_t mp3_player_pause(void)
 {
     ESP_LOGI(TAG, "暂停播放");
-    return audio_player_pause();
+    return s_native ? mp3_stream_pause() : audio_player_pause();
 }
 
 esp_err_t mp3_player_resume(void)
 {
     ESP_LOGI(TAG, "恢复播放");
-    return audio_player_resume();
+    return s_native ? mp3_stream_resume() : audio_player_resume();
 }
 
 esp_err_t mp3_player_stop(void)
 {
     ESP_LOGI(TAG, "停止播放");
-    return audio_player_stop();
+    if (s_native)
+    {
+        return mp3_stream_stop(); // 同时清空混音器中的音乐数据
+    }
+    esp_err_t ret = audio_player_stop();
+    audio_mixer_flush(AUDIO_MIXER_STREAM_MUSIC);
+    return ret;
 }
 
 esp_err_t mp3_player_deinit(void)
 {
     ESP_LOGI(TAG, "反初始化MP3播放器");
-    return audio_player_delete();
+    mp3_stream_deinit();
+    esp_err_t ret = audio_player_delete();
+    if (s_play_mutex != NULL)
+    {
+        xSemaphoreTake(s_play_mutex, portMAX_DELAY);
+        clear_current_file();
+        xSemaphoreGive(s_play_mutex);
+    }
+    return ret;
 }
 
 audio_player_state_t mp3_player_get_state(void)
 {
-    return audio_player_get_state();
+    return s_native ? mp3_stream_get_state() : audio_player_get_state();
+}
+
+esp_err_t mp3_player_seek_ms(uint32_t position_ms)
+{
+    if (s_play_mutex == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_play_mutex, portMAX_DELAY);
+    check_finished();
+
+    if (s_current_fp == NULL || s_seek_info.mode == MP3_SEEK_MODE_NONE)
+    {
+        xSemaphoreGive(s_play_mutex);
+        ESP_LOGW(TAG, "当前没有可定位的MP3文件");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // 重新同步读取用单独打开的文件, 播放任务照常读取自己的文件, 不需要先暂停;
+    // 无TOC的VBR文件的索引在后台建立, 这里只有一次窗口读取
+    FILE *fp = fopen(s_current_path, "rb");
+    if (fp == NULL)
+    {
+        xSemaphoreGive(s_play_mutex);
+        ESP_LOGE(TAG, "无法打开文件: %s", s_current_path);
+        return ESP_FAIL;
+    }
+
+    uint32_t offset = 0;
+    uint32_t actual_ms = 0;
+    esp_err_t ret = mp3_seek_locate(fp, s_current_path, &s_seek_info, position_ms, &offset, &actual_ms);
+    if (ret == ESP_OK && s_native)
+    {
+        // 播放任务在两次解码之间执行: 清空输入缓冲区, 重建解码器, 丢弃混音器中旧位置的数据
+        ret = mp3_stream_seek(offset);
+    }
+    else if (ret == ESP_OK)
+    {
+        // 播放位置随视图一起重置, 见start_audio_player_at
+        bool paused = audio_player_get_state() == AUDIO_PLAYER_STATE_PAUSE;
+        ret = start_audio_player_at(fp, offset, actual_ms);
+        fp = NULL;
+        if (ret == ESP_OK && paused)
+        {
+            audio_player_pause();
+        }
+    }
+    if (fp != NULL)
+    {
+        fclose(fp);
+    }
+
+    if (ret == ESP_OK)
+    {
+        if (s_native)
+        {
+            reset_position(actual_ms);
+        }
+        ESP_LOGI(TAG, "定位到 %lu ms (文件偏移 %lu)", (unsigned long)actual_ms, (unsigned long)offset);
+    }
+    else
+    {
+        ESP_LOGE(TAG, "定位失败: %s", esp_err_to_name(ret));
+    }
+
+    xSemaphoreGive(s_play_mutex);
+    return ret;
+}
+
+esp_err_t mp3_player_get_position(uint32_t *position_ms, uint32_t *duration_ms)
+{
+    if (position_ms == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_play_mutex == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // 与定位/切换文件互斥, 起点和写入计数在s_pos_lock内一起读取
+    xSemaphoreTake(s_play_mutex, portMAX_DELAY);
+    check_finished();
+    if (s_current_fp == NULL)
+    {
+        xSemaphoreGive(s_play_mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    portENTER_CRITICAL(&s_pos_lock);
+    uint32_t base_ms = s_position_base_ms;
+    uint64_t frames = s_frames_written;
+    portEXIT_CRITICAL(&s_pos_lock);
+    uint32_t rate = s_out_sample_rate;
+    if (s_native)
+    {
+        mp3_stream_get_progress(&frames, &rate);
+        rate = rate ? rate : s_seek_info.sample_rate;
+    }
+    *position_ms = base_ms + (rate ? (uint32_t)(frames * 1000 / rate) : 0);
+    if (duration_ms != NULL)
+    {
+        *duration_ms = s_seek_info.duration_ms;
+    }
+    xSemaphoreGive(s_play_mutex);
+    return ESP_OK;
+}
+
+esp_err_t mp3_player_get_decoder_stats(mp3_player_decoder_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_native)
+    {
+        mp3_stream_get_stats(stats);
+        return ESP_OK;
+    }
+    memset(stats, 0, sizeof(*stats));
+    stats->backend = "esp-audio-player";
+    return ESP_OK;
 }
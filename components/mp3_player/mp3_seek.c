@@ -0,0 +1,725 @@
+/**
+ * @file mp3_seek.c
+ * @brief MP3随机定位实现
+ * @details 定位只需一次fseek+一次窗口读取:
+ *          - Xing/VBRI: 通过TOC查表得到偏移
+ *          - CBR: 按帧长度直接计算
+ *          - 其他VBR: 首次定位时在后台任务中扫描一遍帧头建立稀疏索引(按路径缓存),
+ *            经sd_manager的后台I/O类读取, 不阻塞调用者; 索引完成前按平均码率估算
+ *          文件以只读方式打开, CONFIG_FATFS_USE_FASTSEEK会在fopen时预先建立簇链映射表(CLMT),
+ *          因此fseek到大文件任意位置都不需要沿FAT链逐簇查找。
+ */
+
+#include "mp3_seek.h"
+#include <string.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "sd_manager.h"
+
+static const char *TAG = "mp3_seek";
+
+#define MP3_SEEK_INDEX_STEP (32)        // 稀疏索引每隔多少帧记录一个偏移
+#define MP3_SEEK_INDEX_CACHE_SLOTS (4)  // 缓存的稀疏索引数量
+#define MP3_SEEK_INDEX_CHUNK (16 * 1024) // 建立索引时的读取块大小
+#define MP3_SEEK_INDEX_TASK_STACK (3072)
+#define MP3_SEEK_INDEX_TASK_PRIORITY (2) // 低于播放任务
+#define MP3_SEEK_MAX_FRAME_LEN (1441)     // Layer III最大帧长 (MPEG1 320kbps 32kHz含填充)
+
+// 稀疏帧索引缓存条目
+typedef struct
+{
+    char path[128];
+    uint32_t file_size;
+    uint32_t count;    // 已记录的条目数
+    uint32_t *offsets; // offsets[i] = 第 i*MP3_SEEK_INDEX_STEP 帧的文件偏移
+    uint32_t last_use; // LRU计数
+} mp3_seek_index_t;
+
+/**
+ * @brief 后台建立索引的任务参数
+ */
+typedef struct
+{
+    char path[128];
+    uint32_t data_start;
+    uint32_t data_end;
+} mp3_seek_index_job_t;
+
+// 索引缓存和后台任务状态由s_index_lock保护, 扫描文件时不持有
+static SemaphoreHandle_t s_index_lock = NULL;
+static mp3_seek_index_t s_index_cache[MP3_SEEK_INDEX_CACHE_SLOTS];
+static uint32_t s_index_use_counter = 0;
+static bool s_index_building = false;         // 同一时间只有一个后台任务
+static char s_index_building_path[128];
+static volatile bool s_index_abort = false;   // 定位了另一个文件, 放弃当前扫描
+
+static uint32_t read_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint16_t read_be16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+/**
+ * @brief 在缓冲区中查找连续两个参数一致的帧头
+ * @details 下一个帧头不在缓冲区内的候选无法交叉验证, 不接受 (音频数据中很容易出现像帧头的字节);
+ *          只有缓冲区是数据区的结尾、且候选帧正好在结尾处结束时才接受最后一帧。
+ *          调用者需要把len截到数据区结尾, 未找到时从缓冲区末尾MP3_SEEK_MAX_FRAME_LEN字节之前继续查找
+ * @param at_end 缓冲区末尾就是数据区的结尾
+ * @return 帧头在缓冲区中的位置, 未找到返回-1
+ */
+static int find_frame_sync(const uint8_t *buf, size_t len, bool at_end, mp3_frame_info_t *info)
+{
+    for (size_t i = 0; i + 4 <= len; i++)
+    {
+        mp3_frame_info_t first;
+        if (!mp3_seek_parse_header(buf + i, &first))
+        {
+            continue;
+        }
+
+        size_t next = i + first.frame_len;
+        if (next + 4 > len)
+        {
+            if (at_end && next == len)
+            {
+                if (info)
+                {
+                    *info = first;
+                }
+                return (int)i;
+            }
+            continue;
+        }
+
+        mp3_frame_info_t second;
+        if (mp3_seek_parse_header(buf + next, &second) &&
+            second.sample_rate == first.sample_rate &&
+            second.version == first.version)
+        {
+            if (info)
+            {
+                *info = first;
+            }
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 从窗口中第一个帧头开始顺着帧长向后走, 计算这些帧的平均码率
+ * @return 平均码率(kbps), 没有完整的帧时为0
+ */
+static uint32_t window_avg_kbps(const uint8_t *buf, size_t len)
+{
+    int start = find_frame_sync(buf, len, false, NULL);
+    if (start < 0)
+    {
+        return 0;
+    }
+
+    uint64_t bytes = 0;
+    uint32_t frames = 0;
+    mp3_frame_info_t fi = {0};
+    for (size_t pos = (size_t)start; pos + 4 <= len && mp3_seek_parse_header(buf + pos, &fi); pos += fi.frame_len)
+    {
+        if (pos + fi.frame_len > len)
+        {
+            break;
+        }
+        bytes += fi.frame_len;
+        frames++;
+    }
+    if (frames == 0)
+    {
+        return 0;
+    }
+    // 平均码率 = 总位数 / 总时长
+    return (uint32_t)(bytes * 8 * fi.sample_rate / ((uint64_t)frames * fi.samples_per_frame * 1000));
+}
+
+/**
+ * @brief 解析第一帧中的Xing/Info或VBRI头
+ */
+static void parse_vbr_header(const uint8_t *frame, size_t avail, const mp3_frame_info_t *fi, mp3_seek_info_t *info)
+{
+    // Xing头位于帧头+side info之后
+    size_t side_info = (fi->version == 3) ? (fi->channels == 1 ? 17 : 32) : (fi->channels == 1 ? 9 : 17);
+    size_t xing_off = 4 + side_info;
+
+    if (xing_off + 8 <= avail &&
+        (memcmp(frame + xing_off, "Xing", 4) == 0 || memcmp(frame + xing_off, "Info", 4) == 0))
+    {
+        bool is_info = (memcmp(frame + xing_off, "Info", 4) == 0);
+        uint32_t flags = read_be32(frame + xing_off + 4);
+        size_t p = xing_off + 8;
+        uint32_t frames = 0;
+        uint32_t bytes = 0;
+        bool has_toc = false;
+
+        if ((flags & 0x01) && p + 4 <= avail)
+        {
+            frames = read_be32(frame + p);
+            p += 4;
+        }
+        if ((flags & 0x02) && p + 4 <= avail)
+        {
+            bytes = read_be32(frame + p);
+            p += 4;
+        }
+        if ((flags & 0x04) && p + 100 <= avail)
+        {
+            memcpy(info->xing_toc, frame + p, 100);
+            has_toc = true;
+        }
+
+        if (frames > 0)
+        {
+            info->total_frames = frames;
+        }
+        if (bytes > 0 && info->data_start + bytes <= info->data_end)
+        {
+            info->data_end = info->data_start + bytes;
+        }
+
+        // Info头是LAME为CBR文件写的, 按CBR计算更精确
+        info->mode = (has_toc && !is_info && frames > 0) ? MP3_SEEK_MODE_XING : MP3_SEEK_MODE_CBR;
+        if (info->mode == MP3_SEEK_MODE_CBR && info->data_start + fi->frame_len < info->data_end)
+        {
+            // Xing/Info帧本身不含音频(帧数也不计入它), 按帧长计算的偏移从下一帧开始;
+            // XING模式的TOC比例则是相对包含该帧的整个数据区
+            info->data_start += fi->frame_len;
+        }
+        return;
+    }
+
+    // VBRI头固定位于帧头后32字节
+    const size_t vbri_off = 4 + 32;
+    if (vbri_off + 26 <= avail && memcmp(frame + vbri_off, "VBRI", 4) == 0)
+    {
+        const uint8_t *v = frame + vbri_off;
+        uint32_t bytes = read_be32(v + 10);
+        uint32_t frames = read_be32(v + 14);
+        uint16_t entries = read_be16(v + 18);
+        uint16_t scale = read_be16(v + 20);
+        uint16_t entry_size = read_be16(v + 22);
+        uint16_t frames_per_entry = read_be16(v + 24);
+
+        info->total_frames = frames;
+        if (bytes > 0 && info->data_start + bytes <= info->data_end)
+        {
+            info->data_end = info->data_start + bytes;
+        }
+
+        if (entries == 0 || entry_size == 0 || entry_size > 4 || frames_per_entry == 0 ||
+            vbri_off + 26 + (size_t)entries * entry_size > avail)
+        {
+            ESP_LOGW(TAG, "VBRI目录不完整, 改用稀疏帧索引");
+            info->mode = MP3_SEEK_MODE_INDEX;
+            return;
+        }
+
+        // 把相对增量累加成绝对偏移, toc[i]为第i个条目起点
+        info->vbri_toc = heap_caps_malloc((entries + 1) * sizeof(uint32_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (info->vbri_toc == NULL)
+        {
+            info->mode = MP3_SEEK_MODE_INDEX;
+            return;
+        }
+
+        const uint8_t *t = v + 26;
+        uint32_t acc = 0;
+        info->vbri_toc[0] = 0;
+        for (uint16_t i = 0; i < entries; i++)
+        {
+            uint32_t delta = 0;
+            for (uint16_t b = 0; b < entry_size; b++)
+            {
+                delta = (delta << 8) | t[i * entry_size + b];
+            }
+            acc += delta * scale;
+            info->vbri_toc[i + 1] = acc;
+        }
+        info->vbri_entries = entries;
+        info->vbri_frames_per_entry = frames_per_entry;
+        info->mode = MP3_SEEK_MODE_VBRI;
+        return;
+    }
+
+    // 没有VBR头: 先按CBR处理, 由mp3_seek_probe抽查文件中部的帧码率再确认
+    info->mode = MP3_SEEK_MODE_CBR;
+}
+
+esp_err_t mp3_seek_probe(FILE *fp, uint32_t file_size, mp3_seek_info_t *info)
+{
+    if (fp == NULL || info == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(info, 0, sizeof(*info));
+    info->data_end = file_size;
+
+    uint8_t *buf = heap_caps_malloc(MP3_SEEK_RESYNC_WINDOW, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (buf == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = ESP_ERR_NOT_SUPPORTED;
+
+    // 1. 跳过ID3v2标签 (可能包含较大的封面图片)
+    uint8_t id3[10];
+    if (fseek(fp, 0, SEEK_SET) == 0 && fread(id3, 1, sizeof(id3), fp) == sizeof(id3) &&
+        memcmp(id3, "ID3", 3) == 0)
+    {
+        uint32_t tag_size = ((uint32_t)(id3[6] & 0x7F) << 21) | ((uint32_t)(id3[7] & 0x7F) << 14) |
+                            ((uint32_t)(id3[8] & 0x7F) << 7) | (id3[9] & 0x7F);
+        info->data_start = 10 + tag_size + ((id3[5] & 0x10) ? 10 : 0);
+    }
+
+    // 2. 去掉文件末尾的ID3v1标签
+    if (file_size > 128 && fseek(fp, file_size - 128, SEEK_SET) == 0 &&
+        fread(id3, 1, 3, fp) == 3 && memcmp(id3, "TAG", 3) == 0)
+    {
+        info->data_end = file_size - 128;
+    }
+
+    // 3. 定位第一帧并解析VBR头
+    size_t n = 0;
+    if (info->data_start < info->data_end && fseek(fp, info->data_start, SEEK_SET) == 0)
+    {
+        n = fread(buf, 1, MP3_SEEK_RESYNC_WINDOW, fp);
+        n = n < info->data_end - info->data_start ? n : info->data_end - info->data_start;
+    }
+
+    mp3_frame_info_t fi;
+    int pos = find_frame_sync(buf, n, info->data_start + n == info->data_end, &fi);
+    if (pos >= 0)
+    {
+        info->data_start += pos;
+        info->sample_rate = fi.sample_rate;
+        info->samples_per_frame = fi.samples_per_frame;
+        info->channels = fi.channels;
+        info->bitrate_kbps = fi.bitrate_kbps;
+
+        parse_vbr_header(buf + pos, n - pos, &fi, info);
+
+        if (info->mode == MP3_SEEK_MODE_CBR && info->total_frames == 0)
+        {
+            // 无VBR头: 抽查文件中部的帧码率, 与首帧不同则是无TOC的VBR
+            uint32_t head_kbps = window_avg_kbps(buf + pos, n - pos);
+            uint32_t mid = info->data_start + (info->data_end - info->data_start) / 2;
+            mp3_frame_info_t mid_fi;
+            if (fseek(fp, mid, SEEK_SET) == 0)
+            {
+                size_t m = fread(buf, 1, MP3_SEEK_RESYNC_WINDOW, fp);
+                m = m < info->data_end - mid ? m : info->data_end - mid;
+                if (find_frame_sync(buf, m, mid + m == info->data_end, &mid_fi) >= 0 && mid_fi.bitrate_kbps != info->bitrate_kbps)
+                {
+                    // 稀疏索引建立之前按开头和中部两个窗口的平均码率估算时长和定位
+                    uint32_t mid_kbps = window_avg_kbps(buf, m);
+                    info->mode = MP3_SEEK_MODE_INDEX;
+                    if (head_kbps > 0 && mid_kbps > 0)
+                    {
+                        info->bitrate_kbps = (head_kbps + mid_kbps) / 2;
+                    }
+                }
+            }
+        }
+
+        uint32_t audio_bytes = info->data_end - info->data_start;
+        if (info->total_frames > 0)
+        {
+            info->duration_ms = (uint32_t)((uint64_t)info->total_frames * info->samples_per_frame * 1000 / info->sample_rate);
+            if (info->duration_ms > 0)
+            {
+                info->bitrate_kbps = (uint32_t)((uint64_t)audio_bytes * 8 / info->duration_ms);
+            }
+        }
+        else if (info->mode == MP3_SEEK_MODE_CBR || info->mode == MP3_SEEK_MODE_INDEX)
+        {
+            // kbps 即 bit/ms (INDEX为估算值)
+            info->duration_ms = (uint32_t)((uint64_t)audio_bytes * 8 / info->bitrate_kbps);
+        }
+
+        ESP_LOGI(TAG, "定位方式: %d, 数据区: %lu-%lu, %lu Hz, %lu kbps, 时长 %lu ms",
+                 info->mode, (unsigned long)info->data_start, (unsigned long)info->data_end,
+                 (unsigned long)info->sample_rate, (unsigned long)info->bitrate_kbps,
+                 (unsigned long)info->duration_ms);
+        ret = ESP_OK;
+    }
+    else
+    {
+        ESP_LOGW(TAG, "未找到MP3帧同步, 不支持定位");
+    }
+
+    free(buf);
+    fseek(fp, 0, SEEK_SET);
+    return ret;
+}
+
+/**
+ * @brief 查找已建立的稀疏帧索引
+ * @note 调用者需持有s_index_lock
+ */
+static mp3_seek_index_t *index_find(const char *path, uint32_t file_size)
+{
+    for (int i = 0; i < MP3_SEEK_INDEX_CACHE_SLOTS; i++)
+    {
+        mp3_seek_index_t *slot = &s_index_cache[i];
+        if (slot->offsets != NULL && slot->file_size == file_size && strcmp(slot->path, path) == 0)
+        {
+            slot->last_use = ++s_index_use_counter;
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 读取一块: SD卡上的文件经后台I/O类读取, 其他(SPIFFS)用stdio
+ */
+static size_t index_read(sd_manager_file_t *file, FILE *f, uint32_t pos, uint8_t *buf, size_t len)
+{
+    size_t got = 0;
+    if (file != NULL)
+    {
+        return sd_manager_file_read(file, pos, buf, len, SD_MANAGER_CLASS_BACKGROUND, &got) == ESP_OK ? got : 0;
+    }
+    return fseek(f, pos, SEEK_SET) == 0 ? fread(buf, 1, len, f) : 0;
+}
+
+/**
+ * @brief 顺序读取整个数据区, 每MP3_SEEK_INDEX_STEP帧记录一次偏移, 完成后放入缓存
+ */
+static void index_build(const mp3_seek_index_job_t *job)
+{
+    sd_manager_file_t *file = NULL;
+    FILE *f = NULL;
+    if (sd_manager_file_open(job->path, false, &file) != ESP_OK)
+    {
+        file = NULL;
+        f = fopen(job->path, "rb");
+        if (f == NULL)
+        {
+            return;
+        }
+    }
+
+    uint8_t *chunk = heap_caps_malloc(MP3_SEEK_INDEX_CHUNK, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    uint32_t capacity = 256;
+    uint32_t *offsets = heap_caps_malloc(capacity * sizeof(uint32_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    uint32_t count = 0;
+    uint32_t frame_no = 0;
+
+    if (chunk != NULL && offsets != NULL)
+    {
+        ESP_LOGI(TAG, "后台建立稀疏帧索引: %s", job->path);
+
+        uint32_t pos = job->data_start;
+        uint32_t chunk_off = 0;
+        size_t chunk_len = 0;
+
+        while (pos + 4 <= job->data_end && !s_index_abort)
+        {
+            // 当前帧头不在块内时从pos处重新读一块
+            if (pos < chunk_off || pos + 4 > chunk_off + chunk_len)
+            {
+                chunk_off = pos;
+                chunk_len = index_read(file, f, pos, chunk, MP3_SEEK_INDEX_CHUNK);
+                if (chunk_len < 4)
+                {
+                    break;
+                }
+            }
+
+            mp3_frame_info_t fi;
+            if (!mp3_seek_parse_header(chunk + (pos - chunk_off), &fi))
+            {
+                // 数据损坏, 在当前块内向后重新同步; 块末尾无法验证的候选留给下一块
+                size_t left = chunk_len - (pos - chunk_off) - 1;
+                bool at_end = chunk_off + chunk_len >= job->data_end;
+                if (at_end)
+                {
+                    left = job->data_end > pos + 1 ? job->data_end - pos - 1 : 0;
+                }
+                int skip = find_frame_sync(chunk + (pos - chunk_off) + 1, left, at_end, NULL);
+                if (skip >= 0)
+                {
+                    pos += (uint32_t)skip + 1;
+                }
+                else if (at_end || left <= MP3_SEEK_MAX_FRAME_LEN)
+                {
+                    pos += (uint32_t)left + 1;
+                }
+                else
+                {
+                    pos += (uint32_t)(left - MP3_SEEK_MAX_FRAME_LEN) + 1;
+                    chunk_len = 0; // 从新的pos处重新读一块
+                }
+                continue;
+            }
+
+            if (frame_no % MP3_SEEK_INDEX_STEP == 0)
+            {
+                if (count == capacity)
+                {
+                    uint32_t *grown = heap_caps_realloc(offsets, capacity * 2 * sizeof(uint32_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+                    if (grown == NULL)
+                    {
+                        break;
+                    }
+                    offsets = grown;
+                    capacity *= 2;
+                }
+                offsets[count++] = pos;
+            }
+
+            frame_no++;
+            pos += fi.frame_len;
+        }
+    }
+
+    free(chunk);
+    if (file != NULL)
+    {
+        sd_manager_file_close(file); // 读取都是同步的, 没有未完成的请求
+    }
+    else
+    {
+        fclose(f);
+    }
+
+    if (count == 0 || s_index_abort)
+    {
+        free(offsets);
+        if (s_index_abort)
+        {
+            ESP_LOGI(TAG, "已切换文件, 放弃建立索引: %s", job->path);
+        }
+        return;
+    }
+
+    xSemaphoreTake(s_index_lock, portMAX_DELAY);
+    mp3_seek_index_t *victim = &s_index_cache[0];
+    for (int i = 0; i < MP3_SEEK_INDEX_CACHE_SLOTS; i++)
+    {
+        if (s_index_cache[i].offsets == NULL || s_index_cache[i].last_use < victim->last_use)
+        {
+            victim = &s_index_cache[i];
+        }
+    }
+    free(victim->offsets);
+    strncpy(victim->path, job->path, sizeof(victim->path) - 1);
+    victim->path[sizeof(victim->path) - 1] = '\0';
+    victim->file_size = job->data_end;
+    victim->count = count;
+    victim->offsets = offsets;
+    victim->last_use = ++s_index_use_counter;
+    xSemaphoreGive(s_index_lock);
+
+    ESP_LOGI(TAG, "稀疏帧索引完成: %lu 帧, %lu 个条目", (unsigned long)frame_no, (unsigned long)count);
+}
+
+static void index_task(void *arg)
+{
+    mp3_seek_index_job_t *job = arg;
+    index_build(job);
+    free(job);
+
+    xSemaphoreTake(s_index_lock, portMAX_DELAY);
+    s_index_building = false;
+    xSemaphoreGive(s_index_lock);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief 启动后台任务为path建立索引; 正在为其他文件建立时让那个任务放弃, 本次不启动(下次定位时再试)
+ * @note 调用者需持有s_index_lock
+ */
+static void index_request(const char *path, const mp3_seek_info_t *info)
+{
+    if (s_index_building)
+    {
+        if (strcmp(s_index_building_path, path) != 0)
+        {
+            s_index_abort = true;
+        }
+        return;
+    }
+
+    mp3_seek_index_job_t *job = malloc(sizeof(*job));
+    if (job == NULL)
+    {
+        return;
+    }
+    strncpy(job->path, path, sizeof(job->path) - 1);
+    job->path[sizeof(job->path) - 1] = '\0';
+    job->data_start = info->data_start;
+    job->data_end = info->data_end;
+
+    s_index_abort = false;
+    s_index_building = true;
+    strcpy(s_index_building_path, job->path);
+    if (xTaskCreate(index_task, "mp3_index", MP3_SEEK_INDEX_TASK_STACK, job, MP3_SEEK_INDEX_TASK_PRIORITY, NULL) != pdPASS)
+    {
+        ESP_LOGE(TAG, "创建索引任务失败");
+        s_index_building = false;
+        free(job);
+    }
+}
+
+/**
+ * @brief 按稀疏索引定位; 索引还没有建立时启动后台任务并返回false, 由调用者估算
+ */
+static bool index_locate(const char *path, const mp3_seek_info_t *info, uint64_t frame,
+                         uint32_t *out_offset, uint32_t *out_position_ms)
+{
+    if (s_index_lock == NULL)
+    {
+        s_index_lock = xSemaphoreCreateMutex(); // 只在持有播放器互斥锁时调用, 不会并发创建
+        if (s_index_lock == NULL)
+        {
+            return false;
+        }
+    }
+
+    xSemaphoreTake(s_index_lock, portMAX_DELAY);
+    mp3_seek_index_t *index = index_find(path, info->data_end);
+    if (index == NULL)
+    {
+        index_request(path, info);
+        xSemaphoreGive(s_index_lock);
+        return false;
+    }
+
+    uint32_t entry = (uint32_t)(frame / MP3_SEEK_INDEX_STEP);
+    if (entry >= index->count)
+    {
+        entry = index->count - 1;
+    }
+    // 索引中的偏移本身就是帧起点, 无需估算
+    *out_offset = index->offsets[entry];
+    *out_position_ms = (uint32_t)((uint64_t)entry * MP3_SEEK_INDEX_STEP * info->samples_per_frame * 1000 / info->sample_rate);
+    xSemaphoreGive(s_index_lock);
+    return true;
+}
+
+esp_err_t mp3_seek_locate(FILE *fp, const char *path, const mp3_seek_info_t *info,
+                          uint32_t position_ms, uint32_t *out_offset, uint32_t *out_position_ms)
+{
+    if (fp == NULL || info == NULL || out_offset == NULL || out_position_ms == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (info->duration_ms > 0 && position_ms >= info->duration_ms)
+    {
+        position_ms = info->duration_ms - 1;
+    }
+
+    uint32_t audio_bytes = info->data_end - info->data_start;
+    uint64_t frame = (uint64_t)position_ms * info->sample_rate / (1000ULL * info->samples_per_frame);
+    uint32_t offset = info->data_start;
+    uint32_t actual_ms = position_ms;
+
+    switch (info->mode)
+    {
+    case MP3_SEEK_MODE_XING:
+    {
+        // TOC[i]/256 为 i% 时长处的字节比例, 段内线性插值
+        float percent = (float)position_ms * 100.0f / info->duration_ms;
+        int a = (int)percent;
+        if (a > 99)
+        {
+            a = 99;
+        }
+        float fa = info->xing_toc[a];
+        float fb = (a < 99) ? info->xing_toc[a + 1] : 256.0f;
+        float fx = fa + (fb - fa) * (percent - a);
+        offset = info->data_start + (uint32_t)(fx / 256.0f * audio_bytes);
+        break;
+    }
+    case MP3_SEEK_MODE_VBRI:
+    {
+        uint32_t entry = (uint32_t)(frame / info->vbri_frames_per_entry);
+        if (entry >= info->vbri_entries)
+        {
+            entry = info->vbri_entries - 1;
+        }
+        uint32_t in_entry = (uint32_t)(frame - (uint64_t)entry * info->vbri_frames_per_entry);
+        uint32_t span = info->vbri_toc[entry + 1] - info->vbri_toc[entry];
+        offset = info->data_start + info->vbri_toc[entry] + span * in_entry / info->vbri_frames_per_entry;
+        break;
+    }
+    case MP3_SEEK_MODE_INDEX:
+        if (index_locate(path, info, frame, out_offset, out_position_ms))
+        {
+            return ESP_OK;
+        }
+        // 索引还在后台建立: 按平均码率估算, 同CBR
+        // fall through
+    case MP3_SEEK_MODE_CBR:
+    {
+        // 平均帧长 = 每帧采样数/8 * 码率 / 采样率 (填充字节平均分摊)
+        double frame_bytes = (double)info->samples_per_frame / 8.0 * info->bitrate_kbps * 1000.0 / info->sample_rate;
+        offset = info->data_start + (uint32_t)(frame * frame_bytes);
+        actual_ms = (uint32_t)(frame * info->samples_per_frame * 1000ULL / info->sample_rate);
+        break;
+    }
+    default:
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (offset >= info->data_end)
+    {
+        offset = info->data_end > 4 ? info->data_end - 4 : info->data_start;
+    }
+
+    // 在估算偏移处读取一个窗口, 重新同步到合法的帧边界
+    uint8_t *buf = heap_caps_malloc(MP3_SEEK_RESYNC_WINDOW, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (buf == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    int pos = -1;
+    if (fseek(fp, offset, SEEK_SET) == 0)
+    {
+        size_t n = fread(buf, 1, MP3_SEEK_RESYNC_WINDOW, fp);
+        n = n < info->data_end - offset ? n : info->data_end - offset;
+        pos = find_frame_sync(buf, n, offset + n == info->data_end, NULL);
+    }
+    free(buf);
+
+    if (pos < 0)
+    {
+        ESP_LOGW(TAG, "偏移 %lu 处未找到帧同步, 交给解码器重新同步", (unsigned long)offset);
+        pos = 0;
+    }
+
+    *out_offset = offset + pos;
+    *out_position_ms = actual_ms;
+    return ESP_OK;
+}
+
+void mp3_seek_info_free(mp3_seek_info_t *info)
+{
+    if (info == NULL)
+    {
+        return;
+    }
+    free(info->vbri_toc);
+    info->vbri_toc = NULL;
+    info->vbri_entries = 0;
+    info->mode = MP3_SEEK_MODE_NONE;
+}
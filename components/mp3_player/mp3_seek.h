@@ -0,0 +1,116 @@
+/**
+ * @file mp3_seek.h
+ * @brief MP3随机定位 (组件内部接口)
+ * @details 解析ID3v2/Xing/VBRI/帧头, 把时间位置换算成帧对齐的文件偏移
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define MP3_SEEK_RESYNC_WINDOW (4096) // 定位后重新同步时单次读取的窗口大小
+
+    /**
+     * @brief 定位方式 (按精度从高到低选择)
+     */
+    typedef enum
+    {
+        MP3_SEEK_MODE_NONE = 0, // 未识别,不支持定位
+        MP3_SEEK_MODE_XING,     // Xing/Info头中的100点TOC
+        MP3_SEEK_MODE_VBRI,     // Fraunhofer VBRI头中的TOC
+        MP3_SEEK_MODE_CBR,      // 恒定码率,按帧大小直接计算
+        MP3_SEEK_MODE_INDEX,    // 无TOC的VBR,使用稀疏帧索引 (后台建立, 完成前按平均码率估算)
+    } mp3_seek_mode_t;
+
+    /**
+     * @brief 单个MP3帧头的解析结果
+     */
+    typedef struct
+    {
+        uint8_t version;            // 3=MPEG1, 2=MPEG2, 0=MPEG2.5
+        uint8_t channels;           // 声道数
+        uint16_t samples_per_frame; // 每帧采样数 (1152或576)
+        uint32_t sample_rate;       // 采样率
+        uint32_t bitrate_kbps;      // 码率
+        uint32_t frame_len;         // 帧长度(字节,含填充)
+    } mp3_frame_info_t;
+
+    /**
+     * @brief 单个文件的定位信息 (由mp3_seek_probe填充)
+     */
+    typedef struct
+    {
+        mp3_seek_mode_t mode;
+        uint32_t data_start;   // 第一帧(跳过ID3v2后)的文件偏移
+        uint32_t data_end;     // 音频数据结束位置(去掉ID3v1)
+        uint32_t sample_rate;  // 采样率
+        uint16_t samples_per_frame;
+        uint8_t channels;
+        uint32_t bitrate_kbps; // CBR码率 / VBR平均码率 (INDEX为开头和中部抽样的估算值)
+        uint32_t total_frames; // 总帧数 (未知时为0)
+        uint32_t duration_ms;  // 总时长 (未知时为0, INDEX为估算值)
+        uint8_t xing_toc[100]; // Xing TOC
+        uint16_t vbri_entries; // VBRI TOC条目数
+        uint16_t vbri_frames_per_entry;
+        uint32_t *vbri_toc;    // VBRI TOC (累加后的绝对偏移, PSRAM)
+    } mp3_seek_info_t;
+
+    /**
+     * @brief 解析单个帧头
+     * @param hdr 4字节帧头
+     * @param info 输出帧信息
+     * @return true 合法的Layer III帧头
+     */
+    bool mp3_seek_parse_header(const uint8_t *hdr, mp3_frame_info_t *info);
+
+    /**
+     * @brief 解码器后端的内容嗅探: head(已跳过ID3v2标签)必须从一个有效的帧头开始,
+     *        下一帧也在head内时还要求它的帧头参数一致
+     * @param head 文件开头
+     * @param len head长度
+     * @return true head是MPEG Layer III数据
+     */
+    bool mp3_seek_check_head(const uint8_t *head, size_t len);
+
+    /**
+     * @brief 探测文件的定位方式和时长
+     * @note 读取完成后文件位置恢复到0
+     * @param fp 已打开的文件
+     * @param file_size 文件大小
+     * @param info 输出定位信息
+     * @return esp_err_t ESP_OK成功, ESP_ERR_NOT_SUPPORTED不是MP3
+     */
+    esp_err_t mp3_seek_probe(FILE *fp, uint32_t file_size, mp3_seek_info_t *info);
+
+    /**
+     * @brief 把时间位置换算成帧对齐的文件偏移
+     * @details Xing/VBRI/CBR直接计算, 然后在目标处读取一个窗口重新同步到连续的两个合法帧头。
+     *          其他VBR文件第一次定位时启动后台任务建立稀疏帧索引(按路径缓存), 本函数不等待:
+     *          索引完成前按平均码率估算(同CBR), 完成后直接查表
+     * @param fp 用于重新同步读取的文件 (调用者独占, 不能是播放任务正在读取的文件)
+     * @param path 文件路径 (稀疏索引的缓存键)
+     * @param info mp3_seek_probe的结果
+     * @param position_ms 目标时间
+     * @param out_offset 输出帧对齐的偏移
+     * @param out_position_ms 输出该帧实际对应的时间
+     * @return esp_err_t ESP_OK成功
+     */
+    esp_err_t mp3_seek_locate(FILE *fp, const char *path, const mp3_seek_info_t *info,
+                              uint32_t position_ms, uint32_t *out_offset, uint32_t *out_position_ms);
+
+    /**
+     * @brief 释放定位信息中的动态内存
+     */
+    void mp3_seek_info_free(mp3_seek_info_t *info);
+
+#ifdef __cplusplus
+}
+#endif
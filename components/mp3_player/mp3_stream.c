@@ -0,0 +1,503 @@
+/**
+ * @file mp3_stream.c
+ * @brief 使用组件内解码器后端的播放任务
+ * @details 任务循环: 有命令先执行命令, 播放状态下每轮补充输入、解码一次并写入混音器音乐流。
+ *          输入和输出缓冲区优先放在内部RAM, 解码期间尽量不访问PSRAM。
+ *          SD卡上的文件按SD_MANAGER_CLASS_AUDIO经sd_manager的I/O调度读取, 界面和后台读写不会插在前面。
+ */
+
+#include "mp3_stream.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "audio_mixer.h"
+#include "sd_manager.h"
+
+static const char *TAG = "mp3_stream";
+
+typedef enum
+{
+    STREAM_CMD_PLAY = 0,
+    STREAM_CMD_PAUSE,
+    STREAM_CMD_RESUME,
+    STREAM_CMD_STOP,
+    STREAM_CMD_SEEK,
+    STREAM_CMD_EXIT,
+} stream_cmd_type_t;
+
+typedef struct
+{
+    stream_cmd_type_t type;
+    FILE *fp;
+    const char *path;
+    const mp3_decoder_backend_t *backend;
+    const uint8_t *head;
+    size_t len;
+    uint32_t offset; // PLAY: head在文件中的偏移; SEEK: 目标偏移
+} stream_cmd_t;
+
+// 命令通道: 调用者串行发送, 任务执行完成后释放s_cmd_done
+static QueueHandle_t s_cmd_queue = NULL;
+static SemaphoreHandle_t s_cmd_done = NULL;
+static SemaphoreHandle_t s_api_mutex = NULL;
+static esp_err_t s_cmd_result = ESP_OK;
+static TaskHandle_t s_task_handle = NULL;
+static volatile audio_player_state_t s_state = AUDIO_PLAYER_STATE_IDLE;
+
+// 以下仅播放任务访问
+static FILE *s_fp = NULL;
+static sd_manager_file_t *s_file = NULL; // SD卡上的文件, NULL时用s_fp读取
+static uint32_t s_file_pos = 0;          // s_file的读取位置
+static const mp3_decoder_backend_t *s_backend = NULL;
+static void *s_ctx = NULL;
+static uint8_t *s_in = NULL;
+static size_t s_in_cap = 0; // 输入缓冲区大小, 按后端的需要调整
+static size_t s_in_pos = 0; // 未解码数据的起始位置
+static size_t s_in_len = 0; // 缓冲区中数据的结束位置
+static bool s_eof = false;
+static int16_t *s_pcm = NULL;
+
+// 播放进度和统计 (任务写, 其他任务读)
+static volatile uint64_t s_frames_written = 0;
+static volatile uint32_t s_out_rate = 0;
+static int64_t s_decode_us = 0;
+static mp3_player_decoder_stats_t s_stats;
+
+/**
+ * @brief 关闭当前文件和解码器
+ * @param flush 丢弃混音器中尚未播放的数据 (停止时), 自然结束时保留
+ */
+static void stream_close(bool flush)
+{
+    if (s_backend != NULL && s_ctx != NULL)
+    {
+        s_backend->close(s_ctx);
+    }
+    if (s_file != NULL)
+    {
+        sd_manager_file_close(s_file); // 读取都是同步的, 这里没有未完成的请求
+    }
+    if (s_fp != NULL)
+    {
+        fclose(s_fp);
+    }
+    if (flush)
+    {
+        audio_mixer_flush(AUDIO_MIXER_STREAM_MUSIC);
+    }
+    s_fp = NULL;
+    s_file = NULL;
+    s_ctx = NULL;
+    s_backend = NULL;
+    s_state = AUDIO_PLAYER_STATE_IDLE;
+}
+
+/**
+ * @brief 按后端需要的大小重新分配输入缓冲区
+ */
+static esp_err_t stream_resize_input(size_t bytes)
+{
+    if (bytes == s_in_cap)
+    {
+        return ESP_OK;
+    }
+
+    uint8_t *buf = mp3_decoder_malloc(bytes);
+    if (buf == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    heap_caps_free(s_in);
+    s_in = buf;
+    s_in_cap = bytes;
+    return ESP_OK;
+}
+
+static esp_err_t stream_open(const stream_cmd_t *cmd)
+{
+    stream_close(true);
+
+    size_t in_bytes = cmd->backend->in_bytes > MP3_STREAM_IN_BYTES ? cmd->backend->in_bytes : MP3_STREAM_IN_BYTES;
+    if (stream_resize_input(in_bytes) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "分配 %u 字节输入缓冲区失败", (unsigned)in_bytes);
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint32_t data_offset = 0;
+    esp_err_t ret = cmd->backend->open(&s_ctx, cmd->head, cmd->len, &data_offset);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "%s 解码器创建失败: %s", cmd->backend->name, esp_err_to_name(ret));
+        s_ctx = NULL;
+        return ret;
+    }
+
+    data_offset += cmd->offset;
+    s_fp = cmd->fp;
+    s_backend = cmd->backend;
+    fseek(s_fp, data_offset, SEEK_SET);
+    // 不在SD卡上或sd_manager未启用时打开失败, 用s_fp读取
+    if (cmd->path == NULL || sd_manager_file_open(cmd->path, false, &s_file) != ESP_OK)
+    {
+        s_file = NULL;
+    }
+    s_file_pos = data_offset;
+    s_in_pos = 0;
+    s_in_len = 0;
+    s_eof = false;
+    s_frames_written = 0;
+    s_out_rate = 0;
+    s_decode_us = 0;
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.backend = s_backend->name;
+    s_state = AUDIO_PLAYER_STATE_PLAYING;
+    ESP_LOGI(TAG, "使用 %s 解码, 数据起始 %lu%s", s_backend->name, (unsigned long)data_offset,
+             s_file != NULL ? ", 经I/O调度读取" : "");
+    return ESP_OK;
+}
+
+/**
+ * @brief 把剩余数据移到缓冲区开头并从文件补满
+ */
+static void stream_refill(void)
+{
+    if (s_in_pos > 0)
+    {
+        memmove(s_in, s_in + s_in_pos, s_in_len - s_in_pos);
+        s_in_len -= s_in_pos;
+        s_in_pos = 0;
+    }
+    if (!s_eof && s_in_len < s_in_cap)
+    {
+        size_t want = s_in_cap - s_in_len;
+        if (s_file != NULL)
+        {
+            size_t got = 0;
+            esp_err_t ret = sd_manager_file_read(s_file, s_file_pos, s_in + s_in_len, want, SD_MANAGER_CLASS_AUDIO, &got);
+            if (ret != ESP_OK)
+            {
+                ESP_LOGE(TAG, "读取失败: %s", esp_err_to_name(ret));
+                got = 0;
+            }
+            s_file_pos += got;
+            s_in_len += got;
+            s_eof = (ret != ESP_OK || got < want);
+        }
+        else
+        {
+            s_in_len += fread(s_in + s_in_len, 1, want, s_fp);
+            s_eof = feof(s_fp) || ferror(s_fp);
+        }
+    }
+}
+
+/**
+ * @brief 单声道扩展为立体声 (从后往前, dst和src可以相同)
+ */
+static void stream_mono_to_stereo(int16_t *dst, const int16_t *src, size_t frames)
+{
+    for (size_t i = frames; i-- > 0;)
+    {
+        int16_t v = src[i];
+        dst[2 * i] = v;
+        dst[2 * i + 1] = v;
+    }
+}
+
+/**
+ * @brief 解码一次并写入混音器
+ */
+static void stream_step(void)
+{
+    if (s_in_len - s_in_pos < s_in_cap / 2)
+    {
+        stream_refill();
+    }
+    if (s_in_len == s_in_pos)
+    {
+        ESP_LOGI(TAG, "播放结束");
+        stream_close(false);
+        return;
+    }
+
+    size_t consumed = 0;
+    size_t frames = 0;
+    int16_t *pcm = s_pcm;
+    mp3_decoder_info_t info = {0};
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t ret = s_backend->decode(s_ctx, s_in + s_in_pos, s_in_len - s_in_pos, &consumed, &pcm, &frames, &info);
+    uint32_t cost_us = (uint32_t)(esp_timer_get_time() - t0);
+    s_in_pos += consumed;
+
+    if (ret == ESP_ERR_INVALID_SIZE)
+    {
+        if (s_eof)
+        {
+            // 文件末尾的残缺帧
+            ESP_LOGI(TAG, "播放结束");
+            stream_close(false);
+        }
+        else if (s_in_len - s_in_pos == s_in_cap)
+        {
+            // 缓冲区满仍凑不出一帧, 跳过一个字节重新同步
+            s_in_pos++;
+        }
+        else
+        {
+            stream_refill();
+        }
+        return;
+    }
+    if (ret == ESP_ERR_NOT_FOUND)
+    {
+        ESP_LOGI(TAG, "播放结束");
+        stream_close(false);
+        return;
+    }
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "%s 解码失败: %s", s_backend->name, esp_err_to_name(ret));
+        stream_close(false);
+        return;
+    }
+    if (frames == 0)
+    {
+        return;
+    }
+
+    // 统计: 每秒音频的解码耗时即该后端的CPU占用(百万分比)
+    s_decode_us += cost_us;
+    s_stats.frames_decoded += frames;
+    s_stats.max_decode_us = cost_us > s_stats.max_decode_us ? cost_us : s_stats.max_decode_us;
+    s_stats.decode_us_per_sec = (uint32_t)(s_decode_us * info.sample_rate / s_stats.frames_decoded);
+
+    if (info.channels == 1)
+    {
+        stream_mono_to_stereo(s_pcm, pcm, frames);
+        pcm = s_pcm;
+    }
+    s_out_rate = info.sample_rate;
+    if (audio_mixer_write(AUDIO_MIXER_STREAM_MUSIC, pcm, frames * 2 * sizeof(int16_t), portMAX_DELAY) == ESP_OK)
+    {
+        s_frames_written += frames;
+    }
+}
+
+static esp_err_t stream_handle(const stream_cmd_t *cmd)
+{
+    switch (cmd->type)
+    {
+    case STREAM_CMD_PLAY:
+        return stream_open(cmd);
+    case STREAM_CMD_PAUSE:
+        if (s_state != AUDIO_PLAYER_STATE_PLAYING)
+        {
+            return ESP_ERR_INVALID_STATE;
+        }
+        s_state = AUDIO_PLAYER_STATE_PAUSE;
+        return ESP_OK;
+    case STREAM_CMD_RESUME:
+        if (s_state != AUDIO_PLAYER_STATE_PAUSE)
+        {
+            return ESP_ERR_INVALID_STATE;
+        }
+        s_state = AUDIO_PLAYER_STATE_PLAYING;
+        return ESP_OK;
+    case STREAM_CMD_STOP:
+        stream_close(true);
+        return ESP_OK;
+    case STREAM_CMD_SEEK:
+        if (s_fp == NULL)
+        {
+            return ESP_ERR_INVALID_STATE;
+        }
+        fseek(s_fp, cmd->offset, SEEK_SET);
+        s_file_pos = cmd->offset;
+        s_in_pos = 0;
+        s_in_len = 0;
+        s_eof = false;
+        s_backend->reset(s_ctx);
+        audio_mixer_flush(AUDIO_MIXER_STREAM_MUSIC);
+        s_frames_written = 0;
+        return ESP_OK;
+    default:
+        return ESP_ERR_INVALID_ARG;
+    }
+}
+
+static void stream_task(void *arg)
+{
+    stream_cmd_t cmd;
+
+    while (true)
+    {
+        // 播放时不等待命令, 其他状态阻塞直到有命令
+        TickType_t wait = (s_state == AUDIO_PLAYER_STATE_PLAYING) ? 0 : portMAX_DELAY;
+        if (xQueueReceive(s_cmd_queue, &cmd, wait) == pdTRUE)
+        {
+            if (cmd.type == STREAM_CMD_EXIT)
+            {
+                stream_close(true);
+                xSemaphoreGive(s_cmd_done);
+                break;
+            }
+            s_cmd_result = stream_handle(&cmd);
+            xSemaphoreGive(s_cmd_done);
+            continue;
+        }
+        stream_step();
+    }
+
+    s_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief 发送命令并等待执行完成
+ */
+static esp_err_t stream_send(const stream_cmd_t *cmd)
+{
+    if (s_task_handle == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_api_mutex, portMAX_DELAY);
+    xQueueSend(s_cmd_queue, cmd, portMAX_DELAY);
+    esp_err_t ret = ESP_ERR_TIMEOUT;
+    if (xSemaphoreTake(s_cmd_done, pdMS_TO_TICKS(MP3_STREAM_CMD_TIMEOUT_MS)) == pdTRUE)
+    {
+        ret = s_cmd_result;
+    }
+    xSemaphoreGive(s_api_mutex);
+    return ret;
+}
+
+esp_err_t mp3_stream_init(void)
+{
+    if (s_task_handle != NULL)
+    {
+        return ESP_OK;
+    }
+
+    s_cmd_queue = xQueueCreate(4, sizeof(stream_cmd_t));
+    s_cmd_done = xSemaphoreCreateBinary();
+    s_api_mutex = xSemaphoreCreateMutex();
+    s_in = heap_caps_malloc(MP3_STREAM_IN_BYTES, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    s_in_cap = MP3_STREAM_IN_BYTES;
+    s_pcm = heap_caps_malloc(MP3_DECODER_MAX_FRAMES * 2 * sizeof(int16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (s_cmd_queue == NULL || s_cmd_done == NULL || s_api_mutex == NULL || s_in == NULL || s_pcm == NULL)
+    {
+        ESP_LOGE(TAG, "播放任务资源分配失败");
+        mp3_stream_deinit();
+        return ESP_ERR_NO_MEM;
+    }
+
+    BaseType_t ret = xTaskCreatePinnedToCore(stream_task, "mp3_stream", 4096, NULL, MP3_STREAM_TASK_PRIORITY,
+                                             &s_task_handle, MP3_STREAM_TASK_CORE);
+    if (ret != pdPASS)
+    {
+        ESP_LOGE(TAG, "创建播放任务失败");
+        mp3_stream_deinit();
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t mp3_stream_deinit(void)
+{
+    if (s_task_handle != NULL)
+    {
+        stream_cmd_t cmd = {.type = STREAM_CMD_EXIT};
+        stream_send(&cmd);
+        for (int i = 0; i < 50 && s_task_handle != NULL; i++)
+        {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+    }
+
+    if (s_cmd_queue != NULL)
+    {
+        vQueueDelete(s_cmd_queue);
+        s_cmd_queue = NULL;
+    }
+    if (s_cmd_done != NULL)
+    {
+        vSemaphoreDelete(s_cmd_done);
+        s_cmd_done = NULL;
+    }
+    if (s_api_mutex != NULL)
+    {
+        vSemaphoreDelete(s_api_mutex);
+        s_api_mutex = NULL;
+    }
+    heap_caps_free(s_in);
+    heap_caps_free(s_pcm);
+    s_in = NULL;
+    s_in_cap = 0;
+    s_pcm = NULL;
+    return ESP_OK;
+}
+
+esp_err_t mp3_stream_play(FILE *fp, const char *path, const mp3_decoder_backend_t *backend, const uint8_t *head,
+                          size_t len, uint32_t head_offset)
+{
+    if (fp == NULL || backend == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    stream_cmd_t cmd = {.type = STREAM_CMD_PLAY,
+                        .fp = fp,
+                        .path = path,
+                        .backend = backend,
+                        .head = head,
+                        .len = len,
+                        .offset = head_offset};
+    return stream_send(&cmd);
+}
+
+esp_err_t mp3_stream_pause(void)
+{
+    stream_cmd_t cmd = {.type = STREAM_CMD_PAUSE};
+    return stream_send(&cmd);
+}
+
+esp_err_t mp3_stream_resume(void)
+{
+    stream_cmd_t cmd = {.type = STREAM_CMD_RESUME};
+    return stream_send(&cmd);
+}
+
+esp_err_t mp3_stream_stop(void)
+{
+    stream_cmd_t cmd = {.type = STREAM_CMD_STOP};
+    return stream_send(&cmd);
+}
+
+esp_err_t mp3_stream_seek(uint32_t offset)
+{
+    stream_cmd_t cmd = {.type = STREAM_CMD_SEEK, .offset = offset};
+    return stream_send(&cmd);
+}
+
+audio_player_state_t mp3_stream_get_state(void)
+{
+    return s_state;
+}
+
+void mp3_stream_get_progress(uint64_t *frames, uint32_t *sample_rate)
+{
+    *frames = s_frames_written;
+    *sample_rate = s_out_rate;
+}
+
+void mp3_stream_get_stats(mp3_player_decoder_stats_t *stats)
+{
+    *stats = s_stats;
+}
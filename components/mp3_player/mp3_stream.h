@@ -0,0 +1,75 @@
+/**
+ * @file mp3_stream.h
+ * @brief 使用组件内解码器后端的播放任务 (组件内部接口)
+ * @details 状态和控制语义与esp-audio-player一致, mp3_player按当前文件选择的路径转发调用。
+ *          所有控制命令在播放任务中顺序执行, 调用返回时命令已生效。
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "audio_player.h"
+#include "mp3_decoder.h"
+#include "mp3_player.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define MP3_STREAM_IN_BYTES (4096)      // 默认输入缓冲区 (内部RAM), 后端可以要求更大的
+#define MP3_STREAM_TASK_PRIORITY (5)    // 与esp-audio-player任务相同
+#define MP3_STREAM_TASK_CORE (0)
+#define MP3_STREAM_CMD_TIMEOUT_MS (1000)
+
+    /**
+     * @brief 创建播放任务
+     */
+    esp_err_t mp3_stream_init(void);
+
+    /**
+     * @brief 删除播放任务 (正在播放时先停止)
+     */
+    esp_err_t mp3_stream_deinit(void);
+
+    /**
+     * @brief 开始播放, 成功时接管fp (播放结束或停止时关闭, 之后状态变为IDLE), 失败时由调用者关闭
+     * @details SD卡上的文件另用sd_manager_file打开, 播放数据按SD_MANAGER_CLASS_AUDIO经I/O调度读取,
+     *          优先于录音以外的其他读写; 其他文件(或sd_manager未启用)用fp读取
+     * @param fp 已打开的文件, 位置任意
+     * @param path fp的路径, 可以为NULL (只用fp读取)
+     * @param backend 解码器后端
+     * @param head 文件开头 (用于后端解析文件头, 已跳过ID3v2标签)
+     * @param len head长度
+     * @param head_offset head在文件中的偏移 (ID3v2标签长度)
+     */
+    esp_err_t mp3_stream_play(FILE *fp, const char *path, const mp3_decoder_backend_t *backend, const uint8_t *head,
+                              size_t len, uint32_t head_offset);
+
+    esp_err_t mp3_stream_pause(void);
+    esp_err_t mp3_stream_resume(void);
+    esp_err_t mp3_stream_stop(void);
+
+    /**
+     * @brief 跳转到文件偏移 (帧边界), 清除解码状态和混音器中的旧数据
+     * @note 调用者应先暂停; fp在暂停期间可由调用者读取(建立定位索引)
+     */
+    esp_err_t mp3_stream_seek(uint32_t offset);
+
+    audio_player_state_t mp3_stream_get_state(void);
+
+    /**
+     * @brief 自上次play/seek以来写入混音器的帧数和输出采样率
+     */
+    void mp3_stream_get_progress(uint64_t *frames, uint32_t *sample_rate);
+
+    /**
+     * @brief 当前文件的解码统计
+     */
+    void mp3_stream_get_stats(mp3_player_decoder_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
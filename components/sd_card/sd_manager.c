@@ -5,6 +5,7 @@
  */
 
 #include "sd_manager.h"
+#include "sd_manager_io.h"
 #include <stdio.h>
 #include <string.h>
 #include <dirent.h>
@@ -14,6 +15,7 @@
 #include "esp_vfs_fat.h"
 #include "sdmmc_cmd.h"
 #include "driver/sdspi_host.h"
+#include "diskio_sdmmc.h"
 
 #define TAG "sd_manager"
 #define MOUNT_POINT "/sdcard"
@@ -37,7 +39,7 @@ esp_err_t sd_manager_init(void)
     esp_vfs_fat_sdmmc_mount_config_t mount_config = {
         .format_if_mount_failed = false,
         .max_files = 8,
-        .allocation_unit_size = 16 * 1024};
+        .allocation_unit_size = SD_MANAGER_ALLOC_UNIT};
 
     ESP_LOGI(TAG, "初始化SD卡 (SPI模式)...");
     ESP_LOGI(TAG, "引脚配置: MOSI=%d, MISO=%d, CLK=%d, CS=%d",
@@ -50,7 +52,7 @@ esp_err_t sd_manager_init(void)
 
     // 大幅降低频率以解决CRC错误问题 (1MHz)
     // 挂载成功后，如果需要高速，可以尝试逐步提高到 10MHz 或 20MHz
-    host.max_freq_khz = 10000;
+    host.max_freq_khz = SD_MANAGER_SPI_FREQ_KHZ;
 
     spi_bus_config_t bus_cfg = {
         .mosi_io_num = PIN_NUM_MOSI,
@@ -113,6 +115,12 @@ esp_err_t sd_manager_init(void)
     ESP_LOGI(TAG, "SD卡挂载成功！");
     sdmmc_card_print_info(stdout, card);
 
+    // 文件读写接口直接使用FatFs, 失败时VFS接口仍然可用
+    if (sd_manager_io_init(ff_diskio_get_pdrv_card(card), MOUNT_POINT) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "文件接口启用失败, 只能通过VFS访问");
+    }
+
     return ESP_OK;
 }
 
@@ -120,6 +128,9 @@ void sd_manager_deinit(void)
 {
     if (card != NULL)
     {
+        // 先完成未处理的异步请求
+        sd_manager_io_deinit();
+
         // 卸载文件系统
         esp_vfs_fat_sdcard_unmount(MOUNT_POINT, card);
         card = NULL;
@@ -189,3 +200,24 @@ bool sd_manager_file_exists(const char *file_path)
     }
     return false;
 }
+
+esp_err_t sd_manager_create_contiguous_file(const char *file_path, uint64_t size)
+{
+    if (file_path == NULL || size == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (card == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // alloc_now=true: 立即分配并写入FAT链, 保证后续写入区域连续
+    esp_err_t ret = esp_vfs_fat_create_contiguous_file(MOUNT_POINT, file_path, size, true);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGW(TAG, "预分配连续文件失败: %s (%llu 字节) %s", file_path, (unsigned long long)size, esp_err_to_name(ret));
+    }
+    sd_manager_dir_changed(file_path); // 失败时也可能已创建或截断了同名文件
+    return ret;
+}
@@ -2,11 +2,24 @@
  * @file sd_manager.h
  * @brief ESP32 SD卡管理器
  * @details 提供SD卡文件系统操作接口，支持SDMMC高速模式和FAT文件系统
+ *
+ *          文件读写接口(sd_manager_read_file等)绕过VFS和stdio, 直接调用FatFs:
+ *          - 读取直接进入调用者的缓冲区, 扇区对齐的部分按多扇区一次传输, 不经过stdio缓冲和FatFs扇区窗口
+ *          - 写入前按文件大小预留连续簇, 整块数据一次写入; 多次小块追加用sd_manager_writer合并成对齐的大块
+ *          - 所有读写请求由I/O任务按优先级类别调度: 实时音频 > 录音 > 界面 > 后台,
+ *            同类请求中顺序续读优先并合并相邻传输, 界面和后台请求分片执行, 不会长时间占住卡;
+ *            同步接口也是提交请求后等待, sd_manager_read_file/write_file按后台类别执行
+ *          - 每类操作统计次数、字节数和耗时
+ *          - 目录列表(sd_manager_dir_*)一次读出名称、大小、类型和修改时间, 按目录缓存, 排序过滤后分页读取
+ *          - 派生数据缓存见sd_manager_cache.h, 基准测试见sd_manager_bench.h
+ *          缓冲区位于内部RAM且4字节对齐时SPI驱动可以直接DMA, 否则驱动会逐扇区经过中转缓冲,
+ *          大块读写建议使用sd_manager_alloc_io_buffer()分配。
  */
 
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include "esp_err.h"
 
@@ -15,6 +28,149 @@ extern "C"
 {
 #endif
 
+#define SD_MANAGER_SPI_FREQ_KHZ (10000)     // SPI时钟, 调整时用sd_manager_bench对比
+#define SD_MANAGER_ALLOC_UNIT (16 * 1024)   // 格式化时的分配单元 (簇大小)
+#define SD_MANAGER_PATH_MAX (128)           // 文件接口支持的最长路径 (含挂载点"/sdcard")
+#define SD_MANAGER_WRITER_BUF (32 * 1024)   // sd_manager_writer的合并缓冲, 扇区和分配单元(16KB)的整数倍
+#define SD_MANAGER_IO_ALIGN (4)             // SPI DMA要求的缓冲区对齐
+#define SD_MANAGER_ASYNC_STACK (4096)       // I/O任务栈大小
+#define SD_MANAGER_ASYNC_PRIORITY (4)       // I/O任务优先级 (低于音频任务)
+#define SD_MANAGER_IO_MAX_REQUESTS (16)     // 同时排队的异步请求数
+#define SD_MANAGER_IO_RESERVED (4)          // 只留给音频和录音类别的请求数, 后台请求再多也不会占满
+#define SD_MANAGER_IO_SLICE (16 * 1024)     // 界面和后台请求单次最多传输的字节数, 分片之间先处理更高类别
+#define SD_MANAGER_IO_MERGE_MAX (64 * 1024) // 合并相邻请求后单次传输的上限
+#define SD_MANAGER_IO_NOTIFY_INDEX (1)      // 异步请求不带回调时完成通知使用的任务通知序号, 不占用默认的0号
+#define SD_MANAGER_IO_AGING_MS (200)        // 同类中等待超过该时间的请求不再让位给顺序续读
+#define SD_MANAGER_IO_RETRY_MS (10)         // 同步接口没有空闲请求槽时的重试间隔
+#define SD_MANAGER_DIR_CACHE_DIRS (4)       // 缓存列表的目录数, 超出时淘汰最久未用的
+#define SD_MANAGER_DIR_MAX_ENTRIES (8192)   // 单个目录最多列出的条目数, 超出的部分不列出
+
+    /**
+     * @brief 统计的操作类型
+     */
+    typedef enum
+    {
+        SD_MANAGER_OP_READ = 0,   // sd_manager_read_file (含异步)
+        SD_MANAGER_OP_WRITE,      // sd_manager_write_file (含异步) 和writer的每次实际写入
+        SD_MANAGER_OP_CREATE_DIR,
+        SD_MANAGER_OP_DELETE,
+        SD_MANAGER_OP_GET_SIZE,
+        SD_MANAGER_OP_LIST_DIR, // 读取整个目录建立缓存 (缓存命中不计入)
+        SD_MANAGER_OP_RENAME,
+        SD_MANAGER_OP_MAX,
+    } sd_manager_op_t;
+
+    /**
+     * @brief 异步请求的优先级类别 (数值越小越优先)
+     */
+    typedef enum
+    {
+        SD_MANAGER_CLASS_AUDIO = 0,  // 实时音频流, 延迟直接决定是否欠载
+        SD_MANAGER_CLASS_RECORD,     // 录音写入, 有缓冲但不能无限等待
+        SD_MANAGER_CLASS_UI,         // 界面资源加载, 用户在等待
+        SD_MANAGER_CLASS_BACKGROUND, // 媒体库扫描、缓存生成等
+        SD_MANAGER_CLASS_MAX,
+    } sd_manager_io_class_t;
+
+    /**
+     * @brief 单类操作的统计
+     */
+    typedef struct
+    {
+        uint32_t calls;
+        uint32_t errors;
+        uint64_t bytes;    // 实际读写的字节数
+        uint64_t total_us; // 累计耗时, 吞吐量 = bytes / total_us
+        uint32_t max_us;   // 单次最长耗时
+        uint32_t last_us;  // 最近一次耗时
+    } sd_manager_op_stats_t;
+
+    /**
+     * @brief 单个优先级类别的调度统计
+     */
+    typedef struct
+    {
+        uint32_t requests;      // 已完成的请求数
+        uint32_t merged;        // 与前一个请求合并成一次传输的请求数
+        uint32_t pending;       // 排队或执行中的请求数
+        uint32_t rejected;      // 没有空闲请求槽被拒绝的次数
+        uint64_t wait_total_us; // 从提交到开始执行的累计等待时间
+        uint32_t wait_max_us;   // 最长等待时间
+    } sd_manager_class_stats_t;
+
+    /**
+     * @brief 文件接口统计
+     */
+    typedef struct
+    {
+        sd_manager_op_stats_t op[SD_MANAGER_OP_MAX];
+        sd_manager_class_stats_t cls[SD_MANAGER_CLASS_MAX];
+        uint32_t dir_cache_hits;   // sd_manager_dir_open直接使用缓存的次数
+        uint32_t dir_cache_misses; // 需要读取目录的次数
+    } sd_manager_stats_t;
+
+    /**
+     * @brief 目录列表的排序方式
+     */
+    typedef enum
+    {
+        SD_MANAGER_SORT_NONE = 0, // 目录中的存储顺序
+        SD_MANAGER_SORT_NAME,     // 名称, 不区分大小写
+        SD_MANAGER_SORT_SIZE,
+        SD_MANAGER_SORT_MTIME,
+    } sd_manager_dir_sort_t;
+
+    /**
+     * @brief 目录列表的类型过滤
+     */
+    typedef enum
+    {
+        SD_MANAGER_DIR_ALL = 0,
+        SD_MANAGER_DIR_FILES_ONLY,
+        SD_MANAGER_DIR_DIRS_ONLY,
+    } sd_manager_dir_type_t;
+
+    /**
+     * @brief 目录列表选项, 全0表示按存储顺序列出所有非隐藏条目
+     */
+    typedef struct
+    {
+        sd_manager_dir_sort_t sort;
+        bool descending;            // 降序 (只影响排序键, 不影响dirs_first)
+        bool dirs_first;            // 子目录排在文件前面
+        sd_manager_dir_type_t type; // 类型过滤
+        const char *extensions;     // 文件扩展名过滤, 分号分隔不区分大小写, 例如"wav;mp3;flac"; NULL不过滤, 不影响子目录
+        bool show_hidden;           // 列出隐藏/系统属性和以'.'开头的条目
+    } sd_manager_dir_opts_t;
+
+    /**
+     * @brief 目录条目
+     */
+    typedef struct
+    {
+        const char *name; // 条目名 (不含路径), sd_manager_dir_close之前有效
+        uint32_t size;    // 文件大小, 子目录为0
+        uint32_t mtime;   // 修改时间 (time_t, 与stat()的st_mtime相同)
+        bool is_dir;
+    } sd_manager_dir_entry_t;
+
+    /** @brief 排序过滤后的目录列表, 内容在打开时固定, 之后的修改不影响已打开的列表 */
+    typedef struct sd_manager_dir sd_manager_dir_t;
+
+    /**
+     * @brief 异步操作完成回调, 在I/O任务中调用, 不要在回调中阻塞
+     * @param ret 操作结果
+     * @param bytes 实际读写的字节数
+     * @param arg 提交时传入的参数
+     */
+    typedef void (*sd_manager_io_cb_t)(esp_err_t ret, size_t bytes, void *arg);
+
+    /** @brief 合并写入句柄 */
+    typedef struct sd_manager_writer sd_manager_writer_t;
+
+    /** @brief 按偏移读写的文件句柄, 读写请求经过I/O调度 */
+    typedef struct sd_manager_file sd_manager_file_t;
+
     /**
      * @brief 初始化SD卡并挂载文件系统
      * @return esp_err_t ESP_OK成功，其他值失败
@@ -32,6 +188,53 @@ extern "C"
      */
     void sd_manager_list_dir(const char *path);
 
+    /**
+     * @brief 打开目录列表
+     * @details 目录的条目(名称、大小、类型、修改时间)第一次打开时用f_readdir读取一遍并缓存在PSRAM,
+     *          不对每个条目调用stat; 之后打开同一目录直接使用缓存。排序和过滤的结果也随缓存保存,
+     *          选项相同时不再重新排序。sd_manager的写入、建目录、删除会使所在目录的缓存失效;
+     *          通过fopen等VFS接口修改时需要调用sd_manager_file_changed()或sd_manager_dir_invalidate()
+     * @param dir_path 目录路径, 例如"/sdcard/record"
+     * @param opts 排序和过滤选项, NULL等同全0
+     * @param out 输出列表句柄
+     * @return esp_err_t ESP_OK成功, ESP_ERR_NOT_FOUND目录不存在, ESP_ERR_NO_MEM, ESP_ERR_INVALID_STATE未挂载
+     */
+    esp_err_t sd_manager_dir_open(const char *dir_path, const sd_manager_dir_opts_t *opts, sd_manager_dir_t **out);
+
+    /**
+     * @brief 列表中的条目数 (过滤后)
+     */
+    uint32_t sd_manager_dir_count(const sd_manager_dir_t *dir);
+
+    /**
+     * @brief 按页读取列表, 只拷贝条目描述, 不访问卡
+     * @param dir 列表句柄
+     * @param start 第一个条目的序号
+     * @param entries 输出数组
+     * @param max 数组容量
+     * @param out_count 实际输出的条目数, start超出范围时为0
+     * @return esp_err_t ESP_OK成功
+     */
+    esp_err_t sd_manager_dir_read(const sd_manager_dir_t *dir, uint32_t start, sd_manager_dir_entry_t *entries,
+                                  uint32_t max, uint32_t *out_count);
+
+    /**
+     * @brief 关闭列表并释放句柄
+     */
+    void sd_manager_dir_close(sd_manager_dir_t *dir);
+
+    /**
+     * @brief 使目录的列表缓存失效
+     * @param dir_path 目录路径, NULL表示全部
+     */
+    void sd_manager_dir_invalidate(const char *dir_path);
+
+    /**
+     * @brief 文件经fopen等VFS接口创建、写入或删除后调用, 使它所在目录的列表缓存失效
+     * @param file_path 文件路径, 例如"/sdcard/record/a.wav"; 不在SD卡上的路径没有影响
+     */
+    void sd_manager_file_changed(const char *file_path);
+
     /**
      * @brief 检查指定文件是否存在
      * @param file_path 文件路径
@@ -39,18 +242,34 @@ extern "C"
      */
     bool sd_manager_file_exists(const char *file_path);
 
+    /**
+     * @brief 创建预分配了连续簇的文件 (f_expand)
+     * @details 文件大小直接设为size, 数据区连续, 之后的顺序写入不再需要分配簇和更新FAT,
+     *          写入延迟更稳定。用"r+b"(或sd_manager_file_open读写方式)打开后写入,
+     *          结束时用ftruncate(或sd_manager_file_truncate)截断到实际长度。
+     * @param file_path 文件路径 (已存在时会被覆盖)
+     * @param size 预分配大小 (字节)
+     * @return esp_err_t ESP_OK成功, ESP_ERR_NO_MEM找不到足够大的连续空间, 其他值失败
+     */
+    esp_err_t sd_manager_create_contiguous_file(const char *file_path, uint64_t size);
+
     /**
      * @brief 从SD卡读取文件内容
+     * @details 数据直接读入buffer, 文件比缓冲区长时只读取buffer_size字节。
+     *          作为SD_MANAGER_CLASS_BACKGROUND请求执行并等待完成(按SD_MANAGER_IO_SLICE分片, 不挡住音频读取),
+     *          其他类别用sd_manager_read_file_async; 不要在完成回调中调用
      * @param file_path 文件路径
      * @param buffer 接收数据的缓冲区
      * @param buffer_size 缓冲区大小
      * @param bytes_read 实际读取的字节数（可选）
-     * @return esp_err_t ESP_OK成功，其他值失败
+     * @return esp_err_t ESP_OK成功，ESP_ERR_NOT_FOUND文件不存在，ESP_ERR_INVALID_STATE未挂载，其他值失败
      */
     esp_err_t sd_manager_read_file(const char *file_path, void *buffer, size_t buffer_size, size_t *bytes_read);
 
     /**
      * @brief 将数据写入SD卡文件
+     * @details 文件已存在时被覆盖。先按data_size预留连续簇, 再写入整块数据;
+     *          与sd_manager_read_file一样作为后台请求分片执行并等待完成
      * @param file_path 文件路径
      * @param data 要写入的数据
      * @param data_size 数据大小
@@ -61,7 +280,7 @@ extern "C"
     /**
      * @brief 创建新目录
      * @param dir_path 目录路径
-     * @return esp_err_t ESP_OK成功，其他值失败
+     * @return esp_err_t ESP_OK成功或目录已存在，ESP_ERR_NOT_FOUND上级目录不存在，其他值失败
      */
     esp_err_t sd_manager_create_dir(const char *dir_path);
 
@@ -72,6 +291,15 @@ extern "C"
      */
     esp_err_t sd_manager_delete_file(const char *file_path);
 
+    /**
+     * @brief 重命名或移动文件 (同一个卷内), 目标已存在时先删除目标
+     * @details 先完整写入临时文件再重命名, 读者只会看到旧文件、没有文件或新文件, 不会看到写了一半的文件
+     * @param from_path 原路径
+     * @param to_path 新路径, 上级目录须已存在
+     * @return esp_err_t ESP_OK成功，ESP_ERR_NOT_FOUND原文件不存在，其他值失败
+     */
+    esp_err_t sd_manager_rename_file(const char *from_path, const char *to_path);
+
     /**
      * @brief 获取文件大小
      * @param file_path 文件路径
@@ -80,6 +308,122 @@ extern "C"
      */
     esp_err_t sd_manager_get_file_size(const char *file_path, size_t *file_size);
 
+    /**
+     * @brief 异步读取文件, 参数和结果与sd_manager_read_file相同
+     * @details buffer在完成前必须保持有效。cb为NULL时, 完成后用xTaskNotifyIndexed(SD_MANAGER_IO_NOTIFY_INDEX,
+     *          eSetValueWithOverwrite)把结果(esp_err_t)通知给提交请求的任务, 用
+     *          xTaskNotifyWaitIndexed(SD_MANAGER_IO_NOTIFY_INDEX, ...)等待; 任务自己在0号上的通知不受影响
+     * @param io_class 优先级类别
+     * @return esp_err_t ESP_OK已提交, ESP_ERR_TIMEOUT没有空闲请求槽, ESP_ERR_INVALID_STATE未挂载
+     */
+    esp_err_t sd_manager_read_file_async(const char *file_path, void *buffer, size_t buffer_size,
+                                         sd_manager_io_class_t io_class, sd_manager_io_cb_t cb, void *arg);
+
+    /**
+     * @brief 异步写入文件, 参数和结果与sd_manager_write_file相同
+     * @details data在完成前必须保持有效, 完成方式同sd_manager_read_file_async
+     * @return esp_err_t ESP_OK已提交, ESP_ERR_TIMEOUT没有空闲请求槽, ESP_ERR_INVALID_STATE未挂载
+     */
+    esp_err_t sd_manager_write_file_async(const char *file_path, const void *data, size_t data_size,
+                                          sd_manager_io_class_t io_class, sd_manager_io_cb_t cb, void *arg);
+
+    /**
+     * @brief 打开文件用于按偏移读写
+     * @details 打开本身在调用者任务中执行; 之后的读写都交给I/O任务, 同一句柄上偏移相邻、
+     *          缓冲区也相邻的请求会合并成一次传输
+     * @param file_path 文件路径
+     * @param write false只读; true读写, 文件不存在时创建
+     * @param out 输出句柄
+     * @return esp_err_t ESP_OK成功
+     */
+    esp_err_t sd_manager_file_open(const char *file_path, bool write, sd_manager_file_t **out);
+
+    /**
+     * @brief 异步读取文件的一段
+     * @details 完成方式同sd_manager_read_file_async, 读到文件末尾时bytes小于len
+     */
+    esp_err_t sd_manager_file_read_async(sd_manager_file_t *file, uint32_t offset, void *buffer, size_t len,
+                                         sd_manager_io_class_t io_class, sd_manager_io_cb_t cb, void *arg);
+
+    /**
+     * @brief 异步写入文件的一段 (偏移超过文件末尾时文件被扩展, 中间的内容不确定)
+     */
+    esp_err_t sd_manager_file_write_async(sd_manager_file_t *file, uint32_t offset, const void *data, size_t len,
+                                          sd_manager_io_class_t io_class, sd_manager_io_cb_t cb, void *arg);
+
+    /**
+     * @brief 读取文件的一段并等待完成 (经过I/O调度, 没有空闲请求槽时等待; 不要在完成回调中调用)
+     * @param bytes_read 实际读取的字节数 (可选)
+     * @return esp_err_t ESP_OK成功
+     */
+    esp_err_t sd_manager_file_read(sd_manager_file_t *file, uint32_t offset, void *buffer, size_t len,
+                                   sd_manager_io_class_t io_class, size_t *bytes_read);
+
+    /**
+     * @brief 写入文件的一段并等待完成 (经过I/O调度, 没有空闲请求槽时等待; 不要在完成回调中调用)
+     */
+    esp_err_t sd_manager_file_write(sd_manager_file_t *file, uint32_t offset, const void *data, size_t len,
+                                    sd_manager_io_class_t io_class);
+
+    /**
+     * @brief 把文件的缓存数据和目录项(长度、修改时间)写到卡上 (在调用者任务中执行)
+     * @return esp_err_t ESP_OK成功, ESP_ERR_INVALID_STATE还有未完成的请求
+     */
+    esp_err_t sd_manager_file_sync(sd_manager_file_t *file);
+
+    /**
+     * @brief 把文件截断到size字节, 释放之后的簇 (在调用者任务中执行, 文件须以读写方式打开)
+     * @return esp_err_t ESP_OK成功, ESP_ERR_INVALID_STATE还有未完成的请求或只读打开
+     */
+    esp_err_t sd_manager_file_truncate(sd_manager_file_t *file, uint32_t size);
+
+    /**
+     * @brief 关闭文件
+     * @return esp_err_t ESP_OK成功, ESP_ERR_INVALID_STATE还有未完成的请求 (句柄仍然有效)
+     */
+    esp_err_t sd_manager_file_close(sd_manager_file_t *file);
+
+    /**
+     * @brief 创建合并写入句柄, 用于多次小块追加
+     * @details 小块数据先拷入SD_MANAGER_WRITER_BUF大小的对齐缓冲, 满一块写一次;
+     *          缓冲为空时的整块数据直接写入, 不经过拷贝。文件偏移始终按整块对齐。
+     *          每次实际写入都是io_class类别的同步请求 (sd_manager_file_write)
+     * @param file_path 文件路径 (已存在时会被覆盖)
+     * @param size_hint 预计的文件大小, 用于预留连续簇, 0表示未知
+     * @param io_class 写入请求的优先级类别, 缓存生成等用SD_MANAGER_CLASS_BACKGROUND
+     * @param out 输出句柄
+     * @return esp_err_t ESP_OK成功
+     */
+    esp_err_t sd_manager_writer_open(const char *file_path, size_t size_hint, sd_manager_io_class_t io_class,
+                                     sd_manager_writer_t **out);
+
+    /**
+     * @brief 追加数据
+     * @return esp_err_t ESP_OK成功, 失败后句柄只能关闭
+     */
+    esp_err_t sd_manager_writer_append(sd_manager_writer_t *w, const void *data, size_t len);
+
+    /**
+     * @brief 写出剩余数据, 关闭文件并释放句柄
+     * @return esp_err_t ESP_OK成功, 之前的追加失败时返回该错误
+     */
+    esp_err_t sd_manager_writer_close(sd_manager_writer_t *w);
+
+    /**
+     * @brief 分配适合直接DMA的I/O缓冲区 (内部RAM, SD_MANAGER_IO_ALIGN对齐), 用free()释放
+     */
+    void *sd_manager_alloc_io_buffer(size_t size);
+
+    /**
+     * @brief 获取文件接口统计
+     */
+    void sd_manager_get_stats(sd_manager_stats_t *stats);
+
+    /**
+     * @brief 清零文件接口统计
+     */
+    void sd_manager_reset_stats(void);
+
 #ifdef __cplusplus
 }
 #endif
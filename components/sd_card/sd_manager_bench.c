@@ -0,0 +1,347 @@
+/**
+ * @file sd_manager_bench.c
+ * @brief SD卡基准测试
+ * @details 每个组合使用同一个测试文件, 依次执行四种模式; 每次f_read/f_write单独计时,
+ *          延迟样本排序后取分位数。顺序写之后f_sync, 写入的数据都落到卡上再开始读。
+ *          随机偏移由固定种子的LCG生成, 同一配置每次运行访问相同的位置。
+ */
+
+#include "sd_manager_bench.h"
+#include "sd_manager.h"
+#include "sd_manager_io.h"
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "ff.h"
+
+#define TAG "sd_manager"
+
+#define BENCH_BASE_SIZE (512)
+#define BENCH_SEED (0x5EED1234u)
+
+static const char *s_pattern_names[SD_MANAGER_BENCH_PATTERN_MAX] = {
+    "seq_write",
+    "seq_read",
+    "rand_read",
+    "rand_write",
+};
+
+// 一个组合的运行状态
+typedef struct
+{
+    FIL fil;
+    uint8_t *buf;       // 本组合使用的缓冲区 (对齐或错开1字节)
+    uint32_t buf_size;
+    uint32_t shift;     // 不对齐时文件偏移整体后移1字节
+    uint32_t file_bytes;
+    uint32_t *lat;      // 每次操作的耗时
+    uint32_t lat_cap;
+    uint32_t rng;
+} bench_case_t;
+
+const char *sd_manager_bench_pattern_name(sd_manager_bench_pattern_t pattern)
+{
+    return ((unsigned)pattern < SD_MANAGER_BENCH_PATTERN_MAX) ? s_pattern_names[pattern] : "?";
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief 由延迟样本计算分位数 (样本会被排序)
+ */
+static void bench_summarize(sd_manager_bench_result_t *r, uint32_t *lat, uint32_t n)
+{
+    r->ops = n;
+    if (n == 0)
+    {
+        return;
+    }
+    qsort(lat, n, sizeof(uint32_t), cmp_u32);
+    r->avg_us = (uint32_t)(r->total_us / n);
+    r->p50_us = lat[(n - 1) * 50 / 100];
+    r->p90_us = lat[(n - 1) * 90 / 100];
+    r->p99_us = lat[(n - 1) * 99 / 100];
+    r->max_us = lat[n - 1];
+}
+
+/**
+ * @brief 随机偏移: 对齐时按缓冲区大小取整
+ */
+static uint32_t bench_random_offset(bench_case_t *c)
+{
+    c->rng = c->rng * 1664525u + 1013904223u;
+    uint32_t blocks = c->file_bytes / c->buf_size;
+    return (c->rng >> 8) % blocks * c->buf_size + c->shift;
+}
+
+/**
+ * @brief 执行一种模式, 结果写入r
+ */
+static esp_err_t bench_pattern(bench_case_t *c, sd_manager_bench_pattern_t pattern, uint32_t random_ops,
+                               sd_manager_bench_result_t *r)
+{
+    bool is_write = (pattern == SD_MANAGER_BENCH_SEQ_WRITE || pattern == SD_MANAGER_BENCH_RAND_WRITE);
+    bool is_random = (pattern == SD_MANAGER_BENCH_RAND_READ || pattern == SD_MANAGER_BENCH_RAND_WRITE);
+    uint32_t ops = is_random ? random_ops : c->file_bytes / c->buf_size;
+    if (ops > c->lat_cap)
+    {
+        ops = c->lat_cap;
+    }
+
+    FRESULT fr = f_lseek(&c->fil, c->shift);
+    uint32_t n = 0;
+    for (; fr == FR_OK && n < ops; n++)
+    {
+        if (is_random)
+        {
+            uint32_t offset = bench_random_offset(c);
+            // 定位不计入单次耗时: 比较的是传输本身, 定位的开销可以从顺序和随机的差别看出
+            fr = f_lseek(&c->fil, offset);
+            if (fr != FR_OK)
+            {
+                break;
+            }
+        }
+
+        UINT done = 0;
+        int64_t start = esp_timer_get_time();
+        fr = is_write ? f_write(&c->fil, c->buf, c->buf_size, &done) : f_read(&c->fil, c->buf, c->buf_size, &done);
+        uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+        if (fr == FR_OK && done != c->buf_size)
+        {
+            fr = is_write ? FR_DENIED : FR_INT_ERR; // 卡满或文件比预期短
+        }
+        if (fr != FR_OK)
+        {
+            break;
+        }
+        c->lat[n] = us;
+        r->total_us += us;
+        r->bytes += done;
+    }
+    if (fr == FR_OK && pattern == SD_MANAGER_BENCH_SEQ_WRITE)
+    {
+        // 写入的数据全部落盘后再测读取, sync的耗时计入最后一次写入
+        int64_t start = esp_timer_get_time();
+        fr = f_sync(&c->fil);
+        uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+        if (n > 0)
+        {
+            c->lat[n - 1] += us;
+        }
+        r->total_us += us;
+    }
+
+    bench_summarize(r, c->lat, n);
+    r->ret = (fr == FR_OK) ? ESP_OK : ESP_FAIL;
+    if (fr != FR_OK)
+    {
+        ESP_LOGW(TAG, "基准测试 %s %lu字节失败 (FRESULT=%d)", s_pattern_names[pattern], (unsigned long)c->buf_size, fr);
+    }
+    return r->ret;
+}
+
+/**
+ * @brief 运行一个组合的四种模式
+ * @return 写入的结果数
+ */
+static size_t bench_case(bench_case_t *c, const char *fpath, bool aligned, bool prealloc, uint32_t random_ops,
+                         sd_manager_bench_result_t *results, size_t max_results)
+{
+    size_t n = 0;
+    esp_err_t ret = ESP_OK;
+
+    // 每个组合都从删除旧文件开始, 新建文件的写入要重新分配簇
+    f_unlink(fpath);
+    FRESULT fr = f_open(&c->fil, fpath, FA_READ | FA_WRITE | FA_CREATE_ALWAYS);
+    bool opened = (fr == FR_OK);
+    if (fr == FR_OK && prealloc)
+    {
+        // opt=1立即分配连续簇, 顺序写时不再查找空闲簇和更新FAT
+        fr = f_expand(&c->fil, c->file_bytes + c->shift, 1);
+    }
+    if (fr != FR_OK)
+    {
+        ESP_LOGW(TAG, "基准测试文件创建失败 (FRESULT=%d)", fr);
+        ret = (fr == FR_DENIED) ? ESP_ERR_NO_MEM : ESP_FAIL;
+    }
+
+    for (int p = 0; p < SD_MANAGER_BENCH_PATTERN_MAX && n < max_results; p++)
+    {
+        sd_manager_bench_result_t *r = &results[n++];
+        memset(r, 0, sizeof(sd_manager_bench_result_t));
+        r->pattern = (sd_manager_bench_pattern_t)p;
+        r->buf_size = c->buf_size;
+        r->aligned = aligned;
+        r->preallocated = prealloc;
+        r->ret = ret;
+        if (ret == ESP_OK)
+        {
+            ret = bench_pattern(c, (sd_manager_bench_pattern_t)p, random_ops, r);
+        }
+    }
+
+    if (opened)
+    {
+        f_close(&c->fil);
+    }
+    return n;
+}
+
+esp_err_t sd_manager_bench_run(const sd_manager_bench_config_t *cfg, sd_manager_bench_result_t *results,
+                               size_t max_results, size_t *count)
+{
+    if (cfg == NULL || cfg->dir == NULL || results == NULL || count == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *count = 0;
+
+    uint32_t file_bytes = cfg->file_bytes ? cfg->file_bytes : SD_MANAGER_BENCH_FILE_BYTES;
+    uint32_t random_ops = cfg->random_ops ? cfg->random_ops : SD_MANAGER_BENCH_RANDOM_OPS;
+    uint32_t sizes_mask = cfg->sizes_mask ? cfg->sizes_mask : (1u << SD_MANAGER_BENCH_SIZES) - 1;
+    uint8_t align_mask = cfg->align_mask ? cfg->align_mask : 0x3;
+    uint8_t alloc_mask = cfg->alloc_mask ? cfg->alloc_mask : 0x3;
+
+    uint32_t max_size = 0;
+    for (int i = 0; i < SD_MANAGER_BENCH_SIZES; i++)
+    {
+        if (sizes_mask & (1u << i))
+        {
+            max_size = BENCH_BASE_SIZE << i;
+        }
+    }
+    if (max_size == 0 || file_bytes < max_size)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = sd_manager_create_dir(cfg->dir);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    char path[SD_MANAGER_PATH_MAX];
+    char fpath[SD_MANAGER_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/bench.bin", cfg->dir);
+    ret = sd_manager_io_fatfs_path(path, fpath, sizeof(fpath));
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    // 缓冲区多留4字节用于错开对齐; 延迟样本数按最小的缓冲区计算
+    uint32_t min_size = BENCH_BASE_SIZE << __builtin_ctz(sizes_mask);
+    bench_case_t *c = calloc(1, sizeof(bench_case_t));
+    uint8_t *buf = sd_manager_alloc_io_buffer(max_size + SD_MANAGER_IO_ALIGN);
+    uint32_t lat_cap = file_bytes / min_size;
+    lat_cap = (lat_cap > random_ops) ? lat_cap : random_ops;
+    uint32_t *lat = malloc(lat_cap * sizeof(uint32_t));
+    if (c == NULL || buf == NULL || lat == NULL)
+    {
+        free(c);
+        free(buf);
+        free(lat);
+        return ESP_ERR_NO_MEM;
+    }
+    for (uint32_t i = 0; i < max_size + SD_MANAGER_IO_ALIGN; i++)
+    {
+        buf[i] = (uint8_t)(i * 31 + 7);
+    }
+
+    ESP_LOGI(TAG, "基准测试开始: 文件 %lu 字节, 随机 %lu 次", (unsigned long)file_bytes, (unsigned long)random_ops);
+    int64_t start = esp_timer_get_time();
+    size_t n = 0;
+    for (int i = 0; i < SD_MANAGER_BENCH_SIZES; i++)
+    {
+        if (!(sizes_mask & (1u << i)))
+        {
+            continue;
+        }
+        for (int a = 0; a < 2; a++)
+        {
+            if (!(align_mask & (1u << a)))
+            {
+                continue;
+            }
+            for (int p = 0; p < 2; p++)
+            {
+                if (!(alloc_mask & (1u << p)) || n >= max_results)
+                {
+                    continue;
+                }
+                bool aligned = (a == 0);
+                memset(c, 0, sizeof(bench_case_t));
+                c->buf_size = BENCH_BASE_SIZE << i;
+                c->buf = aligned ? buf : buf + 1;
+                c->shift = aligned ? 0 : 1;
+                c->file_bytes = file_bytes - file_bytes % c->buf_size;
+                c->lat = lat;
+                c->lat_cap = lat_cap;
+                c->rng = BENCH_SEED;
+                n += bench_case(c, fpath, aligned, p == 1, random_ops, results + n, max_results - n);
+            }
+        }
+    }
+    f_unlink(fpath);
+    sd_manager_dir_changed(path);
+    ESP_LOGI(TAG, "基准测试完成: %u 项, 耗时 %.1f 秒", (unsigned)n, (esp_timer_get_time() - start) / 1e6);
+
+    free(c);
+    free(buf);
+    free(lat);
+    *count = n;
+    return ESP_OK;
+}
+
+static double bench_mbps(const sd_manager_bench_result_t *r)
+{
+    // 字节/微秒 = MB/s (10^6)
+    return r->total_us ? (double)r->bytes / (double)r->total_us : 0.0;
+}
+
+void sd_manager_bench_print(FILE *out, const sd_manager_bench_result_t *results, size_t count, const char *label)
+{
+    fprintf(out, "\nSD benchmark: %s\n", label ? label : "");
+    fprintf(out, "%-10s %6s %5s %7s %6s %8s %8s %8s %8s %8s %8s\n", "pattern", "size", "align", "alloc", "ops",
+            "MB/s", "avg_us", "p50_us", "p90_us", "p99_us", "max_us");
+    for (size_t i = 0; i < count; i++)
+    {
+        const sd_manager_bench_result_t *r = &results[i];
+        if (r->ret != ESP_OK && r->ops == 0)
+        {
+            fprintf(out, "%-10s %6lu %5s %7s   FAILED (%s)\n", s_pattern_names[r->pattern], (unsigned long)r->buf_size,
+                    r->aligned ? "yes" : "no", r->preallocated ? "prealloc" : "fresh", esp_err_to_name(r->ret));
+            continue;
+        }
+        fprintf(out, "%-10s %6lu %5s %7s %6lu %8.3f %8lu %8lu %8lu %8lu %8lu%s\n", s_pattern_names[r->pattern],
+                (unsigned long)r->buf_size, r->aligned ? "yes" : "no", r->preallocated ? "prealloc" : "fresh",
+                (unsigned long)r->ops, bench_mbps(r), (unsigned long)r->avg_us, (unsigned long)r->p50_us,
+                (unsigned long)r->p90_us, (unsigned long)r->p99_us, (unsigned long)r->max_us,
+                r->ret != ESP_OK ? "  (incomplete)" : "");
+    }
+}
+
+void sd_manager_bench_write_csv(FILE *out, const sd_manager_bench_result_t *results, size_t count,
+                                const char *label, bool header)
+{
+    if (header)
+    {
+        fprintf(out, "%s\n", SD_MANAGER_BENCH_CSV_HEADER);
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        const sd_manager_bench_result_t *r = &results[i];
+        fprintf(out, "%s,%s,%lu,%d,%d,%s,%lu,%llu,%.4f,%lu,%lu,%lu,%lu,%lu\n", label ? label : "",
+                s_pattern_names[r->pattern], (unsigned long)r->buf_size, r->aligned ? 1 : 0, r->preallocated ? 1 : 0,
+                r->ret == ESP_OK ? "ok" : esp_err_to_name(r->ret), (unsigned long)r->ops, (unsigned long long)r->bytes,
+                bench_mbps(r), (unsigned long)r->avg_us, (unsigned long)r->p50_us, (unsigned long)r->p90_us,
+                (unsigned long)r->p99_us, (unsigned long)r->max_us);
+    }
+}
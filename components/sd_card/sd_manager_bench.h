@@ -0,0 +1,105 @@
+/**
+ * @file sd_manager_bench.h
+ * @brief SD卡吞吐量和延迟基准测试
+ * @details 在测试目录中按 缓冲区大小 x 缓冲区是否对齐 x 新建/预分配文件 的每种组合:
+ *          建文件 -> 顺序写满 -> 顺序读 -> 随机读 -> 随机覆盖写, 每个模式记录吞吐量和单次操作延迟的分位数。
+ *          读写直接调用FatFs (与sd_manager_read_file等相同的路径), 不经过I/O任务。
+ *          主机替身(tools/host_sd)运行同一份代码, 镜像文件没有卡的延迟, 测得的就是FatFs和文件接口本身的开销。
+ *          测试会改写测试目录中的文件, 运行期间不要有其他任务大量读写卡。
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define SD_MANAGER_BENCH_SIZES (8)                   // 缓冲区大小档位: 512 << i, 512B到64KB
+#define SD_MANAGER_BENCH_FILE_BYTES (1024 * 1024)    // 默认测试文件大小
+#define SD_MANAGER_BENCH_RANDOM_OPS (256)            // 默认随机读写次数 (不超过文件能容纳的块数)
+#define SD_MANAGER_BENCH_MAX_RESULTS (SD_MANAGER_BENCH_SIZES * 2 * 2 * SD_MANAGER_BENCH_PATTERN_MAX)
+#define SD_MANAGER_BENCH_CSV_HEADER "label,pattern,buf_size,aligned,prealloc,result,ops,bytes,mbps,avg_us,p50_us,p90_us,p99_us,max_us"
+
+    /**
+     * @brief 访问模式
+     */
+    typedef enum
+    {
+        SD_MANAGER_BENCH_SEQ_WRITE = 0, // 从空文件(或预分配的文件)开头顺序写满
+        SD_MANAGER_BENCH_SEQ_READ,
+        SD_MANAGER_BENCH_RAND_READ,  // 随机偏移, 对齐时偏移是缓冲区大小的整数倍
+        SD_MANAGER_BENCH_RAND_WRITE, // 随机覆盖写, 不再分配簇
+        SD_MANAGER_BENCH_PATTERN_MAX,
+    } sd_manager_bench_pattern_t;
+
+    /**
+     * @brief 测试配置, 0表示默认值
+     */
+    typedef struct
+    {
+        const char *dir;      // 测试目录, 例如"/sdcard/bench", 不存在时创建(上级目录须已存在), 结束后删除测试文件
+        uint32_t file_bytes;  // 每种组合的文件大小, 默认SD_MANAGER_BENCH_FILE_BYTES
+        uint32_t random_ops;  // 随机读写次数, 默认SD_MANAGER_BENCH_RANDOM_OPS
+        uint32_t sizes_mask;  // bit i选择512 << i字节的缓冲区, 0为全部
+        uint8_t align_mask;   // bit0对齐, bit1不对齐 (缓冲区地址和文件偏移都错开1字节), 0为两种
+        uint8_t alloc_mask;   // bit0新建文件(写入时分配簇), bit1预分配连续簇(f_expand), 0为两种
+    } sd_manager_bench_config_t;
+
+    /**
+     * @brief 单个组合单个模式的结果
+     */
+    typedef struct
+    {
+        sd_manager_bench_pattern_t pattern;
+        uint32_t buf_size;
+        bool aligned;
+        bool preallocated;
+        esp_err_t ret; // 该组合第一次失败的结果, 失败后的模式不再执行
+        uint32_t ops;
+        uint64_t bytes;
+        uint64_t total_us;
+        uint32_t avg_us;
+        uint32_t p50_us;
+        uint32_t p90_us;
+        uint32_t p99_us;
+        uint32_t max_us;
+    } sd_manager_bench_result_t;
+
+    /**
+     * @brief 运行基准测试 (阻塞, 默认配置在10MHz的卡上约需1-2分钟)
+     * @param cfg 配置
+     * @param results 结果数组, 容量SD_MANAGER_BENCH_MAX_RESULTS即可容纳全部组合
+     * @param max_results 数组容量
+     * @param count 输出的结果数
+     * @return esp_err_t ESP_OK完成(个别组合的失败记录在结果中), ESP_ERR_NO_MEM, ESP_ERR_INVALID_STATE未挂载
+     */
+    esp_err_t sd_manager_bench_run(const sd_manager_bench_config_t *cfg, sd_manager_bench_result_t *results,
+                                   size_t max_results, size_t *count);
+
+    /**
+     * @brief 打印结果表格
+     * @param label 本次测试的说明, 例如SPI频率和分配单元
+     */
+    void sd_manager_bench_print(FILE *out, const sd_manager_bench_result_t *results, size_t count, const char *label);
+
+    /**
+     * @brief 输出CSV (列见SD_MANAGER_BENCH_CSV_HEADER), 每行以label开头, 便于从串口日志中筛选和比较多次运行
+     * @param header 是否先输出表头
+     */
+    void sd_manager_bench_write_csv(FILE *out, const sd_manager_bench_result_t *results, size_t count,
+                                    const char *label, bool header);
+
+    /**
+     * @brief 模式名称 ("seq_write"等)
+     */
+    const char *sd_manager_bench_pattern_name(sd_manager_bench_pattern_t pattern);
+
+#ifdef __cplusplus
+}
+#endif
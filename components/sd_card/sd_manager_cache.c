@@ -0,0 +1,943 @@
+/**
+ * @file sd_manager_cache.c
+ * @brief SD卡上的派生数据缓存
+ * @details 条目表在PSRAM中, 每个条目记录键、大小、最近使用序号和取得计数; 查找是线性扫描
+ *          (上限SD_MANAGER_CACHE_MAX_ENTRIES个, 比一次卡访问快得多)。
+ *          所有操作持有s_cache_lock, 发布和淘汰的文件操作也在锁内完成, 保证条目表、目录和清单一致。
+ *          条目和清单的读写都经过I/O调度, 按SD_MANAGER_CLASS_BACKGROUND分片执行, 不会挡住播放的读取。
+ *          清单只是使用顺序的持久化: 启动时以扫描到的文件为准, 清单中没有的文件视为最久未用。
+ *          所以条目增删后清单不必立即写回, 按CACHE_MANIFEST_DELAY_US和CACHE_MANIFEST_BATCH合并写回。
+ */
+
+#include "sd_manager_cache.h"
+#include "sd_manager.h"
+#include "sd_manager_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "ff.h"
+
+#define TAG "sd_cache"
+
+#define CACHE_MANIFEST_MAGIC (0x48434453) // "SDCH"
+#define CACHE_MANIFEST_VERSION (1)
+#define CACHE_MANIFEST_NAME "manifest.bin"
+#define CACHE_MANIFEST_DELAY_US (5 * 1000 * 1000) // 上次写回后这段时间内的增删合并到之后的一次写回
+#define CACHE_MANIFEST_BATCH (32)                 // 未写回的增删达到这个数时不再等待
+#define CACHE_SUBDIRS (16) // 按键的最高4位分子目录, 单个目录的条目少, 打开文件时查找快
+#define CACHE_KEY_HEX (16)
+#define FNV64_OFFSET (0xcbf29ce484222325ULL)
+#define FNV64_PRIME (0x100000001b3ULL)
+
+// 内存中的条目 (24字节)
+typedef struct
+{
+    uint64_t key;
+    uint32_t size;
+    uint32_t last_use; // 最近使用的序号, 越小越久未用
+    uint16_t pins;     // 取得计数, 大于0时不淘汰、不替换
+    uint16_t reserved;
+} cache_entry_t;
+
+// 清单文件头, 之后是count个manifest_entry_t
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entry_size;
+    uint32_t count;
+    uint32_t tick;  // 保存时的使用序号, 启动后从这里继续
+    uint64_t check; // 条目部分的FNV-1a 64
+} manifest_header_t;
+
+typedef struct
+{
+    uint64_t key;
+    uint32_t size;
+    uint32_t last_use;
+} manifest_entry_t;
+
+struct sd_manager_cache_txn
+{
+    sd_manager_cache_key_t key;
+    sd_manager_writer_t *writer;
+    size_t bytes;
+    esp_err_t err; // 第一次追加失败的结果
+    char tmp[SD_MANAGER_PATH_MAX];
+};
+
+static SemaphoreHandle_t s_cache_lock = NULL;
+static bool s_cache_ready = false;
+static char s_cache_dir[SD_MANAGER_CACHE_PATH_MAX];
+static uint64_t s_budget = 0;
+static cache_entry_t *s_entries = NULL;
+static uint32_t s_count = 0;
+static uint64_t s_used = 0;
+static uint32_t s_tick = 0;
+static uint32_t s_tmp_seq = 0;
+static bool s_entries_dirty = false; // 条目有增删, 清单尚未写回
+static bool s_order_dirty = false;   // 命中改变了使用顺序, 清单尚未写回
+static uint32_t s_pending = 0;       // 清单尚未写回的增删次数
+static int64_t s_saved_at = 0;       // 上次写回清单的时刻
+static sd_manager_cache_stats_t s_stats;
+
+static uint64_t fnv64(uint64_t h, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    for (size_t i = 0; i < len; i++)
+    {
+        h ^= p[i];
+        h *= FNV64_PRIME;
+    }
+    return h;
+}
+
+static void entry_path(sd_manager_cache_key_t key, char *out, size_t out_len)
+{
+    snprintf(out, out_len, "%s/%x/%016llx.bin", s_cache_dir, (unsigned)(key >> 60), (unsigned long long)key);
+}
+
+static cache_entry_t *entry_find(sd_manager_cache_key_t key)
+{
+    for (uint32_t i = 0; i < s_count; i++)
+    {
+        if (s_entries[i].key == key)
+        {
+            return &s_entries[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 从表中去掉条目 (不删除文件), 最后一个条目移到空位
+ */
+static void entry_drop(cache_entry_t *e)
+{
+    s_used -= e->size;
+    *e = s_entries[--s_count];
+    s_entries_dirty = true;
+    s_pending++;
+}
+
+/**
+ * @brief 解析"0123456789abcdef.bin"形式的文件名
+ */
+static bool parse_entry_name(const char *name, sd_manager_cache_key_t *key)
+{
+    if (strlen(name) != CACHE_KEY_HEX + 4 || strcmp(name + CACHE_KEY_HEX, ".bin") != 0)
+    {
+        return false;
+    }
+    uint64_t k = 0;
+    for (int i = 0; i < CACHE_KEY_HEX; i++)
+    {
+        char c = name[i];
+        int v = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+        if (v < 0)
+        {
+            return false;
+        }
+        k = (k << 4) | (uint64_t)v;
+    }
+    *key = k;
+    return true;
+}
+
+/**
+ * @brief 读取整个文件, 经I/O调度按后台类别分片执行
+ */
+static esp_err_t cache_read_file(const char *path, void *buf, size_t len, size_t *got)
+{
+    *got = 0;
+    sd_manager_file_t *f = NULL;
+    esp_err_t ret = sd_manager_file_open(path, false, &f);
+    if (ret == ESP_OK)
+    {
+        ret = sd_manager_file_read(f, 0, buf, len, SD_MANAGER_CLASS_BACKGROUND, got);
+        sd_manager_file_close(f);
+    }
+    return ret;
+}
+
+/**
+ * @brief 新建或覆盖文件并写入, 经I/O调度按后台类别分片执行
+ */
+static esp_err_t cache_write_file(const char *path, const void *data, size_t len)
+{
+    sd_manager_file_t *f = NULL;
+    esp_err_t ret = sd_manager_file_open(path, true, &f);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    ret = sd_manager_file_truncate(f, 0);
+    if (ret == ESP_OK && len > 0)
+    {
+        ret = sd_manager_file_write(f, 0, data, len, SD_MANAGER_CLASS_BACKGROUND);
+    }
+    esp_err_t close_ret = sd_manager_file_close(f);
+    return (ret == ESP_OK) ? close_ret : ret;
+}
+
+/**
+ * @brief 写回清单: 先写临时文件再重命名, 调用时持有s_cache_lock
+ */
+static esp_err_t manifest_save(void)
+{
+    size_t bytes = sizeof(manifest_header_t) + (size_t)s_count * sizeof(manifest_entry_t);
+    uint8_t *buf = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (buf == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    manifest_entry_t *me = (manifest_entry_t *)(buf + sizeof(manifest_header_t));
+    for (uint32_t i = 0; i < s_count; i++)
+    {
+        me[i].key = s_entries[i].key;
+        me[i].size = s_entries[i].size;
+        me[i].last_use = s_entries[i].last_use;
+    }
+    manifest_header_t hdr = {
+        .magic = CACHE_MANIFEST_MAGIC,
+        .version = CACHE_MANIFEST_VERSION,
+        .entry_size = sizeof(manifest_entry_t),
+        .count = s_count,
+        .tick = s_tick,
+        .check = fnv64(FNV64_OFFSET, me, (size_t)s_count * sizeof(manifest_entry_t)),
+    };
+    memcpy(buf, &hdr, sizeof(hdr));
+
+    char tmp[SD_MANAGER_PATH_MAX];
+    char path[SD_MANAGER_PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s/manifest.tmp", s_cache_dir);
+    snprintf(path, sizeof(path), "%s/" CACHE_MANIFEST_NAME, s_cache_dir);
+    esp_err_t ret = cache_write_file(tmp, buf, bytes);
+    if (ret == ESP_OK)
+    {
+        ret = sd_manager_rename_file(tmp, path);
+    }
+    heap_caps_free(buf);
+    s_saved_at = esp_timer_get_time(); // 失败时也等下一个间隔再试
+    if (ret == ESP_OK)
+    {
+        s_entries_dirty = false;
+        s_order_dirty = false;
+        s_pending = 0;
+    }
+    else
+    {
+        ESP_LOGW(TAG, "清单写回失败: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/**
+ * @brief 条目增删后按需写回清单: 距上次写回超过CACHE_MANIFEST_DELAY_US或累计CACHE_MANIFEST_BATCH次增删时写回,
+ *        否则留给之后的操作、sd_manager_cache_flush()或卸载, 调用时持有s_cache_lock
+ */
+static void manifest_save_deferred(void)
+{
+    if (s_entries_dirty &&
+        (s_pending >= CACHE_MANIFEST_BATCH || esp_timer_get_time() - s_saved_at >= CACHE_MANIFEST_DELAY_US))
+    {
+        manifest_save();
+    }
+}
+
+static int cmp_entry_key(const void *a, const void *b)
+{
+    uint64_t x = ((const cache_entry_t *)a)->key;
+    uint64_t y = ((const cache_entry_t *)b)->key;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief 按清单恢复扫描到的条目的使用顺序, 清单无效时忽略
+ * @return 清单与目录内容一致时返回true
+ */
+static bool manifest_load(void)
+{
+    char path[SD_MANAGER_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/" CACHE_MANIFEST_NAME, s_cache_dir);
+    size_t bytes = 0;
+    if (sd_manager_get_file_size(path, &bytes) != ESP_OK || bytes < sizeof(manifest_header_t) ||
+        bytes > sizeof(manifest_header_t) + SD_MANAGER_CACHE_MAX_ENTRIES * sizeof(manifest_entry_t))
+    {
+        return false;
+    }
+    uint8_t *buf = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (buf == NULL)
+    {
+        return false;
+    }
+
+    bool consistent = false;
+    size_t got = 0;
+    manifest_header_t hdr;
+    const manifest_entry_t *me = (const manifest_entry_t *)(buf + sizeof(manifest_header_t));
+    if (cache_read_file(path, buf, bytes, &got) == ESP_OK && got == bytes)
+    {
+        memcpy(&hdr, buf, sizeof(hdr));
+        size_t entries_bytes = bytes - sizeof(manifest_header_t);
+        if (hdr.magic == CACHE_MANIFEST_MAGIC && hdr.version == CACHE_MANIFEST_VERSION &&
+            hdr.entry_size == sizeof(manifest_entry_t) && entries_bytes == hdr.count * sizeof(manifest_entry_t) &&
+            fnv64(FNV64_OFFSET, me, entries_bytes) == hdr.check)
+        {
+            // 扫描结果按键排序后逐个查找清单中的条目
+            qsort(s_entries, s_count, sizeof(cache_entry_t), cmp_entry_key);
+            uint32_t matched = 0;
+            for (uint32_t i = 0; i < hdr.count; i++)
+            {
+                cache_entry_t probe = {.key = me[i].key};
+                cache_entry_t *e = bsearch(&probe, s_entries, s_count, sizeof(cache_entry_t), cmp_entry_key);
+                if (e != NULL)
+                {
+                    e->last_use = me[i].last_use;
+                    matched += (e->size == me[i].size) ? 1 : 0;
+                }
+            }
+            s_tick = hdr.tick;
+            consistent = (matched == hdr.count && matched == s_count);
+        }
+        else
+        {
+            ESP_LOGW(TAG, "清单无效, 按目录内容重建");
+        }
+    }
+    heap_caps_free(buf);
+    return consistent;
+}
+
+/**
+ * @brief 扫描一个子目录, 登记条目文件; 条目表已满时删除多出的文件
+ */
+static void scan_subdir(const char *subdir, FILINFO *fno)
+{
+    char fpath[SD_MANAGER_PATH_MAX];
+    char path[SD_MANAGER_PATH_MAX];
+    FF_DIR dir;
+    if (sd_manager_io_fatfs_path(subdir, fpath, sizeof(fpath)) != ESP_OK || f_opendir(&dir, fpath) != FR_OK)
+    {
+        return;
+    }
+    while (f_readdir(&dir, fno) == FR_OK && fno->fname[0] != '\0')
+    {
+        sd_manager_cache_key_t key;
+        if ((fno->fattrib & AM_DIR) || !parse_entry_name(fno->fname, &key))
+        {
+            continue;
+        }
+        if (s_count >= SD_MANAGER_CACHE_MAX_ENTRIES || fno->fsize > UINT32_MAX)
+        {
+            snprintf(path, sizeof(path), "%s/%s", subdir, fno->fname);
+            sd_manager_delete_file(path);
+            continue;
+        }
+        cache_entry_t *e = &s_entries[s_count++];
+        memset(e, 0, sizeof(cache_entry_t));
+        e->key = key;
+        e->size = (uint32_t)fno->fsize;
+        s_used += e->size;
+    }
+    f_closedir(&dir);
+}
+
+/**
+ * @brief 删除缓存目录中残留的临时文件 (上次写入或发布时断电)
+ */
+static void remove_stale_tmp(FILINFO *fno)
+{
+    char fpath[SD_MANAGER_PATH_MAX];
+    char path[SD_MANAGER_PATH_MAX];
+    FF_DIR dir;
+    if (sd_manager_io_fatfs_path(s_cache_dir, fpath, sizeof(fpath)) != ESP_OK || f_opendir(&dir, fpath) != FR_OK)
+    {
+        return;
+    }
+    // 边读目录边删除在FatFs中是安全的, 删除只标记目录项
+    while (f_readdir(&dir, fno) == FR_OK && fno->fname[0] != '\0')
+    {
+        size_t len = strlen(fno->fname);
+        if (!(fno->fattrib & AM_DIR) && len > 4 && strcmp(fno->fname + len - 4, ".tmp") == 0)
+        {
+            snprintf(path, sizeof(path), "%s/%s", s_cache_dir, fno->fname);
+            sd_manager_delete_file(path);
+        }
+    }
+    f_closedir(&dir);
+}
+
+/**
+ * @brief 淘汰最久未用的条目, 直到再放入need字节(new_entry时还有一个条目)后不超过预算, 调用时持有s_cache_lock
+ * @return esp_err_t ESP_OK成功, ESP_ERR_NO_MEM剩下的条目都正被读取
+ */
+static esp_err_t evict_for(uint64_t need, bool new_entry)
+{
+    char path[SD_MANAGER_PATH_MAX];
+    while (s_count > 0 &&
+           (s_used + need > s_budget || (new_entry && s_count >= SD_MANAGER_CACHE_MAX_ENTRIES)))
+    {
+        cache_entry_t *victim = NULL;
+        for (uint32_t i = 0; i < s_count; i++)
+        {
+            cache_entry_t *e = &s_entries[i];
+            if (e->pins == 0 && (victim == NULL || e->last_use < victim->last_use))
+            {
+                victim = e;
+            }
+        }
+        if (victim == NULL)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+        entry_path(victim->key, path, sizeof(path));
+        esp_err_t ret = sd_manager_delete_file(path);
+        if (ret != ESP_OK && ret != ESP_ERR_NOT_FOUND)
+        {
+            ESP_LOGW(TAG, "淘汰 %s 失败: %s", path, esp_err_to_name(ret));
+        }
+        s_stats.evictions++;
+        s_stats.evicted_bytes += victim->size;
+        entry_drop(victim);
+    }
+    return (s_used + need <= s_budget) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+/**
+ * @brief 把写好的临时文件发布为条目
+ */
+static esp_err_t cache_publish(sd_manager_cache_key_t key, const char *tmp, size_t bytes)
+{
+    char path[SD_MANAGER_PATH_MAX];
+    entry_path(key, path, sizeof(path));
+
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    esp_err_t ret = s_cache_ready ? ESP_OK : ESP_ERR_INVALID_STATE;
+    if (ret == ESP_OK && bytes > s_budget)
+    {
+        ret = ESP_ERR_INVALID_SIZE;
+    }
+    cache_entry_t *old = (ret == ESP_OK) ? entry_find(key) : NULL;
+    if (old != NULL && old->pins > 0)
+    {
+        ret = ESP_ERR_INVALID_STATE;
+    }
+    if (ret == ESP_OK)
+    {
+        // 替换时旧条目留在表中直到重命名成功, 淘汰期间临时取得它, 不会被选中;
+        // 淘汰失败时旧条目和它的文件都保持不变
+        uint64_t need = bytes;
+        if (old != NULL)
+        {
+            need = (bytes > old->size) ? bytes - old->size : 0;
+            old->pins++;
+        }
+        ret = evict_for(need, old == NULL);
+        if (old != NULL)
+        {
+            old = entry_find(key); // 淘汰会移动条目
+            old->pins--;
+        }
+    }
+    if (ret == ESP_OK)
+    {
+        // 旧条目的文件由重命名替换
+        ret = sd_manager_rename_file(tmp, path);
+        if (ret == ESP_OK)
+        {
+            cache_entry_t *e = old;
+            if (e == NULL)
+            {
+                e = &s_entries[s_count++];
+                memset(e, 0, sizeof(cache_entry_t));
+                e->key = key;
+            }
+            else
+            {
+                s_used -= e->size;
+            }
+            e->size = (uint32_t)bytes;
+            e->last_use = ++s_tick;
+            s_used += bytes;
+            s_stats.puts++;
+            s_stats.put_bytes += bytes;
+            s_entries_dirty = true;
+            s_pending++;
+        }
+        else if (old != NULL && sd_manager_get_file_size(path, &(size_t){0}) == ESP_ERR_NOT_FOUND)
+        {
+            // 重命名删除了旧文件之后失败: 旧条目已没有文件
+            entry_drop(old);
+        }
+    }
+    if (ret != ESP_OK)
+    {
+        s_stats.put_errors++;
+        sd_manager_delete_file(tmp);
+    }
+    manifest_save_deferred();
+    xSemaphoreGive(s_cache_lock);
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGW(TAG, "发布条目 %016llx 失败: %s", (unsigned long long)key, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/**
+ * @brief 生成临时文件路径, 同一个键的并发写入互不干扰
+ */
+static esp_err_t tmp_path(sd_manager_cache_key_t key, char *out, size_t out_len)
+{
+    if (s_cache_lock == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    esp_err_t ret = s_cache_ready ? ESP_OK : ESP_ERR_INVALID_STATE;
+    uint32_t seq = s_tmp_seq++;
+    xSemaphoreGive(s_cache_lock);
+    snprintf(out, out_len, "%s/%016llx_%lu.tmp", s_cache_dir, (unsigned long long)key, (unsigned long)seq);
+    return ret;
+}
+
+esp_err_t sd_manager_cache_init(const char *dir, uint64_t budget_bytes)
+{
+    if (dir == NULL || strlen(dir) >= sizeof(s_cache_dir))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_cache_lock == NULL)
+    {
+        s_cache_lock = xSemaphoreCreateMutex();
+        if (s_cache_lock == NULL)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (s_cache_ready)
+    {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = sd_manager_create_dir(dir);
+    char path[SD_MANAGER_PATH_MAX];
+    for (int i = 0; i < CACHE_SUBDIRS && ret == ESP_OK; i++)
+    {
+        snprintf(path, sizeof(path), "%s/%x", dir, i);
+        ret = sd_manager_create_dir(path);
+    }
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "创建缓存目录 %s 失败: %s", dir, esp_err_to_name(ret));
+        return ret;
+    }
+
+    FILINFO *fno = malloc(sizeof(FILINFO));
+    cache_entry_t *entries = heap_caps_calloc(SD_MANAGER_CACHE_MAX_ENTRIES, sizeof(cache_entry_t),
+                                              MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (fno == NULL || entries == NULL)
+    {
+        free(fno);
+        heap_caps_free(entries);
+        return ESP_ERR_NO_MEM;
+    }
+
+    int64_t start = esp_timer_get_time();
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    strcpy(s_cache_dir, dir);
+    s_budget = budget_bytes ? budget_bytes : SD_MANAGER_CACHE_BUDGET;
+    s_entries = entries;
+    s_count = 0;
+    s_used = 0;
+    s_tick = 0;
+    memset(&s_stats, 0, sizeof(s_stats));
+
+    remove_stale_tmp(fno);
+    for (int i = 0; i < CACHE_SUBDIRS; i++)
+    {
+        snprintf(path, sizeof(path), "%s/%x", dir, i);
+        scan_subdir(path, fno);
+    }
+    bool consistent = manifest_load();
+    s_cache_ready = true;
+    s_entries_dirty = !consistent;
+    s_pending = 0;
+    evict_for(0, false); // 扫描时条目数已限制在上限内, 这里只按预算淘汰
+    if (s_entries_dirty)
+    {
+        manifest_save();
+    }
+    ESP_LOGI(TAG, "缓存 %s: %lu 个条目, %llu/%llu 字节, 耗时 %lld ms%s", dir, (unsigned long)s_count,
+             (unsigned long long)s_used, (unsigned long long)s_budget, (esp_timer_get_time() - start) / 1000,
+             consistent ? "" : " (清单已按目录重建)");
+    xSemaphoreGive(s_cache_lock);
+
+    free(fno);
+    return ESP_OK;
+}
+
+void sd_manager_cache_deinit(void)
+{
+    if (s_cache_lock == NULL)
+    {
+        return;
+    }
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    if (s_cache_ready)
+    {
+        if (s_entries_dirty || s_order_dirty)
+        {
+            manifest_save();
+        }
+        s_cache_ready = false;
+        heap_caps_free(s_entries);
+        s_entries = NULL;
+        s_count = 0;
+        s_used = 0;
+    }
+    xSemaphoreGive(s_cache_lock);
+}
+
+sd_manager_cache_key_t sd_manager_cache_key_make(const char *source, uint64_t size, uint32_t mtime,
+                                                 const char *variant)
+{
+    uint8_t meta[12];
+    for (int i = 0; i < 8; i++)
+    {
+        meta[i] = (uint8_t)(size >> (8 * i));
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        meta[8 + i] = (uint8_t)(mtime >> (8 * i));
+    }
+    // 各部分之间插入'\0', "ab"+"c"和"a"+"bc"得到不同的键
+    uint64_t h = fnv64(FNV64_OFFSET, source ? source : "", source ? strlen(source) + 1 : 1);
+    h = fnv64(h, meta, sizeof(meta));
+    h = fnv64(h, variant ? variant : "", variant ? strlen(variant) + 1 : 1);
+    return h;
+}
+
+esp_err_t sd_manager_cache_key_file(const char *src_path, const char *variant, sd_manager_cache_key_t *key)
+{
+    if (key == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int64_t start = esp_timer_get_time();
+    char fpath[SD_MANAGER_PATH_MAX];
+    esp_err_t ret = sd_manager_io_fatfs_path(src_path, fpath, sizeof(fpath));
+    FILINFO *fno = (ret == ESP_OK) ? malloc(sizeof(FILINFO)) : NULL;
+    if (ret == ESP_OK && fno == NULL)
+    {
+        ret = ESP_ERR_NO_MEM;
+    }
+    if (ret == ESP_OK)
+    {
+        FRESULT fr = f_stat(fpath, fno);
+        ret = (fr == FR_OK) ? ESP_OK : (fr == FR_NO_FILE || fr == FR_NO_PATH) ? ESP_ERR_NOT_FOUND : ESP_FAIL;
+        if (ret == ESP_OK)
+        {
+            // FAT时间戳: 日期在高16位, 时间在低16位
+            *key = sd_manager_cache_key_make(src_path, fno->fsize, ((uint32_t)fno->fdate << 16) | fno->ftime, variant);
+        }
+    }
+    free(fno);
+    sd_manager_io_record(SD_MANAGER_OP_GET_SIZE, ret, 0, (uint32_t)(esp_timer_get_time() - start));
+    return ret;
+}
+
+esp_err_t sd_manager_cache_acquire(sd_manager_cache_key_t key, char *path, size_t path_len, size_t *size)
+{
+    if (s_cache_lock == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    esp_err_t ret = ESP_ERR_INVALID_STATE;
+    if (s_cache_ready)
+    {
+        cache_entry_t *e = entry_find(key);
+        ret = (e != NULL) ? ESP_OK : ESP_ERR_NOT_FOUND;
+        if (e != NULL)
+        {
+            e->pins++;
+            e->last_use = ++s_tick;
+            s_order_dirty = true;
+            s_stats.hits++;
+            if (path != NULL)
+            {
+                entry_path(key, path, path_len);
+            }
+            if (size != NULL)
+            {
+                *size = e->size;
+            }
+        }
+        else
+        {
+            s_stats.misses++;
+        }
+    }
+    xSemaphoreGive(s_cache_lock);
+    return ret;
+}
+
+void sd_manager_cache_release(sd_manager_cache_key_t key)
+{
+    if (s_cache_lock == NULL)
+    {
+        return;
+    }
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    cache_entry_t *e = s_cache_ready ? entry_find(key) : NULL;
+    if (e != NULL && e->pins > 0)
+    {
+        e->pins--;
+    }
+    xSemaphoreGive(s_cache_lock);
+}
+
+esp_err_t sd_manager_cache_read(sd_manager_cache_key_t key, void *buffer, size_t buffer_size, size_t *bytes_read)
+{
+    if (buffer == NULL || bytes_read == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *bytes_read = 0;
+    char path[SD_MANAGER_PATH_MAX];
+    size_t size = 0;
+    esp_err_t ret = sd_manager_cache_acquire(key, path, sizeof(path), &size);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    ret = (size <= buffer_size) ? cache_read_file(path, buffer, size, bytes_read) : ESP_ERR_INVALID_SIZE;
+    sd_manager_cache_release(key);
+
+    if (ret == ESP_ERR_NOT_FOUND)
+    {
+        // 文件被缓存以外的途径删除: 去掉条目, 按未命中处理
+        xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+        cache_entry_t *e = s_cache_ready ? entry_find(key) : NULL;
+        if (e != NULL && e->pins == 0)
+        {
+            entry_drop(e);
+            manifest_save_deferred();
+        }
+        s_stats.hits--;
+        s_stats.misses++;
+        xSemaphoreGive(s_cache_lock);
+    }
+    return ret;
+}
+
+esp_err_t sd_manager_cache_put(sd_manager_cache_key_t key, const void *data, size_t size)
+{
+    if (data == NULL && size > 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    char tmp[SD_MANAGER_PATH_MAX];
+    esp_err_t ret = tmp_path(key, tmp, sizeof(tmp));
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    ret = cache_write_file(tmp, data, size);
+    if (ret != ESP_OK)
+    {
+        sd_manager_delete_file(tmp);
+        xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+        s_stats.put_errors++;
+        xSemaphoreGive(s_cache_lock);
+        return ret;
+    }
+    return cache_publish(key, tmp, size);
+}
+
+esp_err_t sd_manager_cache_begin(sd_manager_cache_key_t key, size_t size_hint, sd_manager_cache_txn_t **out)
+{
+    if (out == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out = NULL;
+    sd_manager_cache_txn_t *txn = calloc(1, sizeof(sd_manager_cache_txn_t));
+    if (txn == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    txn->key = key;
+    esp_err_t ret = tmp_path(key, txn->tmp, sizeof(txn->tmp));
+    if (ret == ESP_OK)
+    {
+        ret = sd_manager_writer_open(txn->tmp, size_hint, SD_MANAGER_CLASS_BACKGROUND, &txn->writer);
+    }
+    if (ret != ESP_OK)
+    {
+        free(txn);
+        return ret;
+    }
+    *out = txn;
+    return ESP_OK;
+}
+
+esp_err_t sd_manager_cache_append(sd_manager_cache_txn_t *txn, const void *data, size_t len)
+{
+    if (txn == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (txn->err != ESP_OK)
+    {
+        return txn->err;
+    }
+    txn->err = sd_manager_writer_append(txn->writer, data, len);
+    if (txn->err == ESP_OK)
+    {
+        txn->bytes += len;
+    }
+    return txn->err;
+}
+
+esp_err_t sd_manager_cache_commit(sd_manager_cache_txn_t *txn)
+{
+    if (txn == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t ret = sd_manager_writer_close(txn->writer);
+    ret = (txn->err != ESP_OK) ? txn->err : ret;
+    if (ret == ESP_OK)
+    {
+        ret = cache_publish(txn->key, txn->tmp, txn->bytes);
+    }
+    else
+    {
+        sd_manager_delete_file(txn->tmp);
+        xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+        s_stats.put_errors++;
+        xSemaphoreGive(s_cache_lock);
+    }
+    free(txn);
+    return ret;
+}
+
+void sd_manager_cache_abort(sd_manager_cache_txn_t *txn)
+{
+    if (txn == NULL)
+    {
+        return;
+    }
+    sd_manager_writer_close(txn->writer);
+    sd_manager_delete_file(txn->tmp);
+    free(txn);
+}
+
+esp_err_t sd_manager_cache_remove(sd_manager_cache_key_t key)
+{
+    if (s_cache_lock == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    char path[SD_MANAGER_PATH_MAX];
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    esp_err_t ret = ESP_ERR_INVALID_STATE;
+    if (s_cache_ready)
+    {
+        cache_entry_t *e = entry_find(key);
+        ret = (e == NULL) ? ESP_ERR_NOT_FOUND : (e->pins > 0) ? ESP_ERR_INVALID_STATE : ESP_OK;
+        if (ret == ESP_OK)
+        {
+            entry_path(key, path, sizeof(path));
+            sd_manager_delete_file(path);
+            entry_drop(e);
+            manifest_save_deferred();
+        }
+    }
+    xSemaphoreGive(s_cache_lock);
+    return ret;
+}
+
+esp_err_t sd_manager_cache_clear(void)
+{
+    if (s_cache_lock == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    char path[SD_MANAGER_PATH_MAX];
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    esp_err_t ret = s_cache_ready ? ESP_OK : ESP_ERR_INVALID_STATE;
+    if (ret == ESP_OK)
+    {
+        uint32_t i = 0;
+        while (i < s_count)
+        {
+            if (s_entries[i].pins > 0)
+            {
+                i++;
+                continue;
+            }
+            entry_path(s_entries[i].key, path, sizeof(path));
+            sd_manager_delete_file(path);
+            entry_drop(&s_entries[i]); // 最后一个条目移到i, 不前进
+        }
+        ret = manifest_save();
+    }
+    xSemaphoreGive(s_cache_lock);
+    return ret;
+}
+
+esp_err_t sd_manager_cache_flush(void)
+{
+    if (s_cache_lock == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    esp_err_t ret = s_cache_ready ? ESP_OK : ESP_ERR_INVALID_STATE;
+    if (ret == ESP_OK && (s_entries_dirty || s_order_dirty))
+    {
+        ret = manifest_save();
+    }
+    xSemaphoreGive(s_cache_lock);
+    return ret;
+}
+
+void sd_manager_cache_get_stats(sd_manager_cache_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return;
+    }
+    memset(stats, 0, sizeof(sd_manager_cache_stats_t));
+    if (s_cache_lock == NULL)
+    {
+        return;
+    }
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    *stats = s_stats;
+    stats->entries = s_count;
+    stats->used_bytes = s_used;
+    stats->budget_bytes = s_budget;
+    xSemaphoreGive(s_cache_lock);
+}
+
+void sd_manager_cache_reset_stats(void)
+{
+    if (s_cache_lock == NULL)
+    {
+        return;
+    }
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    memset(&s_stats, 0, sizeof(s_stats));
+    xSemaphoreGive(s_cache_lock);
+}
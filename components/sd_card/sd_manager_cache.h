@@ -0,0 +1,158 @@
+/**
+ * @file sd_manager_cache.h
+ * @brief SD卡上的派生数据缓存 (缩略图、解码后的图片、峰值文件、曲库索引、天气响应等)
+ * @details 缓存按内容键存放, 键是 源文件路径 + 大小 + 修改时间 + 变体 的64位哈希, 源文件变化后键随之变化,
+ *          旧条目不再命中, 最终被LRU淘汰, 不需要显式失效。
+ *          - 布局: <dir>/<k>/<key>.bin, k是键的最高4位(16个子目录), 清单在<dir>/manifest.bin
+ *          - 发布: 先写<dir>/<key>_<n>.tmp, 写完后重命名为正式文件, 读者不会看到写了一半的条目;
+ *            启动时删除残留的临时文件
+ *          - 总大小超过预算或条目数达到上限时按最近使用淘汰, 正在读取(已取得)的条目不会被淘汰
+ *          - 条目增删后清单合并写回 (距上次写回5秒以上或累计32次增删时), 命中改变的使用顺序只在
+ *            sd_manager_cache_flush()或卸载时写回; 启动时清单和目录内容不一致(断电等)以目录为准
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define SD_MANAGER_CACHE_DIR "/sdcard/.cache"             // 默认缓存目录
+#define SD_MANAGER_CACHE_BUDGET (64ULL * 1024 * 1024)     // 默认总大小预算
+#define SD_MANAGER_CACHE_MAX_ENTRIES (2048)               // 条目数上限 (内存中每个条目24字节, 在PSRAM)
+#define SD_MANAGER_CACHE_PATH_MAX (64)                    // 缓存目录路径的最大长度
+
+    typedef uint64_t sd_manager_cache_key_t;
+
+    typedef struct sd_manager_cache_txn sd_manager_cache_txn_t;
+
+    /**
+     * @brief 缓存统计
+     */
+    typedef struct
+    {
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t puts;          // 发布的条目数
+        uint32_t put_errors;    // 写入或发布失败、超过预算被拒绝
+        uint32_t evictions;     // 因预算或条目数淘汰的条目数
+        uint64_t put_bytes;
+        uint64_t evicted_bytes;
+        uint32_t entries;       // 当前条目数
+        uint64_t used_bytes;    // 当前条目总大小
+        uint64_t budget_bytes;
+    } sd_manager_cache_stats_t;
+
+    /**
+     * @brief 打开缓存目录 (SD卡挂载后调用), 读取清单并与目录内容核对
+     * @param dir 缓存目录, 例如SD_MANAGER_CACHE_DIR, 不存在时创建(上级目录须已存在)
+     * @param budget_bytes 总大小预算, 0使用SD_MANAGER_CACHE_BUDGET; 已有条目超出时立即淘汰
+     * @return esp_err_t ESP_OK成功, ESP_ERR_NO_MEM, 其他值为目录创建失败
+     */
+    esp_err_t sd_manager_cache_init(const char *dir, uint64_t budget_bytes);
+
+    /**
+     * @brief 写回清单并关闭缓存 (sd_manager_deinit也会调用), 未完成的写入事务须先提交或放弃
+     */
+    void sd_manager_cache_deinit(void);
+
+    /**
+     * @brief 由源数据的描述计算键 (不访问卡), 用于不是文件的源, 例如天气请求的URL
+     * @param source 源的名称或路径
+     * @param size 源的大小
+     * @param mtime 源的修改时间 (任意单调的版本号均可)
+     * @param variant 派生数据的种类和参数, 例如"thumb:96x96", 同一个源的不同派生数据必须不同; 可为NULL
+     */
+    sd_manager_cache_key_t sd_manager_cache_key_make(const char *source, uint64_t size, uint32_t mtime,
+                                                     const char *variant);
+
+    /**
+     * @brief 由源文件计算键: 读取文件的大小和修改时间 (一次f_stat)
+     * @param src_path 源文件路径 ("/sdcard/...")
+     * @param variant 见sd_manager_cache_key_make
+     * @return esp_err_t ESP_OK成功, ESP_ERR_NOT_FOUND源文件不存在
+     */
+    esp_err_t sd_manager_cache_key_file(const char *src_path, const char *variant, sd_manager_cache_key_t *key);
+
+    /**
+     * @brief 查找并取得条目, 取得期间条目不会被淘汰或替换, 用完调用sd_manager_cache_release
+     * @param path 输出条目文件路径, 可用sd_manager_read_file/sd_manager_file_open读取; 可为NULL
+     * @param size 输出条目大小; 可为NULL
+     * @return esp_err_t ESP_OK命中, ESP_ERR_NOT_FOUND未命中, ESP_ERR_INVALID_STATE未初始化
+     */
+    esp_err_t sd_manager_cache_acquire(sd_manager_cache_key_t key, char *path, size_t path_len, size_t *size);
+
+    /**
+     * @brief 释放sd_manager_cache_acquire取得的条目
+     */
+    void sd_manager_cache_release(sd_manager_cache_key_t key);
+
+    /**
+     * @brief 命中时把整个条目读入缓冲区 (取得 -> sd_manager_read_file -> 释放)
+     * @return esp_err_t ESP_OK命中, ESP_ERR_NOT_FOUND未命中, ESP_ERR_INVALID_SIZE缓冲区不够大
+     */
+    esp_err_t sd_manager_cache_read(sd_manager_cache_key_t key, void *buffer, size_t buffer_size, size_t *bytes_read);
+
+    /**
+     * @brief 写入整个条目并发布, 已有同键条目时替换
+     * @return esp_err_t ESP_OK成功, ESP_ERR_INVALID_SIZE超过预算, ESP_ERR_INVALID_STATE同键条目正被读取
+     */
+    esp_err_t sd_manager_cache_put(sd_manager_cache_key_t key, const void *data, size_t size);
+
+    /**
+     * @brief 开始流式写入一个条目 (数据写入临时文件, 经sd_manager_writer合并)
+     * @param size_hint 预计大小, 用于预留连续簇, 未知时为0
+     */
+    esp_err_t sd_manager_cache_begin(sd_manager_cache_key_t key, size_t size_hint, sd_manager_cache_txn_t **out);
+
+    /**
+     * @brief 追加数据
+     */
+    esp_err_t sd_manager_cache_append(sd_manager_cache_txn_t *txn, const void *data, size_t len);
+
+    /**
+     * @brief 完成写入并发布, 必要时先淘汰旧条目; 无论成功与否txn都被释放
+     * @return esp_err_t 同sd_manager_cache_put
+     */
+    esp_err_t sd_manager_cache_commit(sd_manager_cache_txn_t *txn);
+
+    /**
+     * @brief 放弃写入, 删除临时文件并释放txn
+     */
+    void sd_manager_cache_abort(sd_manager_cache_txn_t *txn);
+
+    /**
+     * @brief 删除一个条目
+     * @return esp_err_t ESP_OK成功, ESP_ERR_NOT_FOUND不存在, ESP_ERR_INVALID_STATE正被读取
+     */
+    esp_err_t sd_manager_cache_remove(sd_manager_cache_key_t key);
+
+    /**
+     * @brief 删除所有未被读取的条目
+     */
+    esp_err_t sd_manager_cache_clear(void);
+
+    /**
+     * @brief 写回清单 (保存尚未写回的增删和命中改变的使用顺序), 清单未变化时不写
+     */
+    esp_err_t sd_manager_cache_flush(void);
+
+    /**
+     * @brief 获取统计
+     */
+    void sd_manager_cache_get_stats(sd_manager_cache_stats_t *stats);
+
+    /**
+     * @brief 清零命中、写入和淘汰计数 (条目数和大小不变)
+     */
+    void sd_manager_cache_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
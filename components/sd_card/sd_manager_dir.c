@@ -0,0 +1,742 @@
+/**
+ * @file sd_manager_dir.c
+ * @brief 目录列表和列表缓存
+ * @details f_readdir一次返回条目的名称、大小、属性和修改时间, 读一遍目录就得到全部信息,
+ *          不像readdir + stat那样每个条目再查找一次目录。读取结果作为快照缓存:
+ *          - 每个目录一个快照, 条目是定长数组, 名称集中存放在字符串池中, 都在PSRAM
+ *          - 最多缓存SD_MANAGER_DIR_CACHE_DIRS个目录, 按最近使用淘汰
+ *          - 快照带引用计数, 失效或淘汰时已打开的列表继续使用旧快照, 最后一个引用释放时才释放内存
+ *          - 快照中保存最近一次排序过滤的结果, 选项相同的打开只拷贝序号数组
+ *          读取目录时不持有缓存锁; 期间有失效通知时, 读到的快照只给本次打开使用, 不放入缓存。
+ */
+
+#include "sd_manager.h"
+#include "sd_manager_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "ff.h"
+
+#define TAG "sd_manager"
+
+#define DIR_ITEMS_INIT (64)     // 条目数组的初始容量
+#define DIR_NAMES_INIT (1024)   // 字符串池的初始容量 (字节)
+#define DIR_EXT_MAX (48)        // 缓存的扩展名过滤字符串的最大长度, 更长时不缓存排序结果
+
+#define DIR_ATTR_DIR (1u << 0)
+#define DIR_ATTR_HIDDEN (1u << 1)
+
+// 快照中的条目 (16字节)
+typedef struct
+{
+    uint32_t name_off; // 在字符串池中的偏移
+    uint32_t size;
+    uint32_t mtime;
+    uint32_t attr; // DIR_ATTR_xxx
+} dir_item_t;
+
+// 一个目录的快照, 内容创建后不再修改 (排序结果除外, 受s_dir_lock保护)
+typedef struct dir_snapshot
+{
+    struct dir_snapshot *next; // 缓存链表
+    char path[SD_MANAGER_PATH_MAX];
+    uint32_t refs;     // 缓存本身持有一个引用
+    uint32_t last_use; // 最近使用的序号, 用于淘汰
+    dir_item_t *items;
+    uint32_t count;
+    uint32_t cap;
+    char *names;
+    size_t names_len;
+    size_t names_cap;
+
+    // 最近一次排序过滤的结果
+    bool sorted_valid;
+    sd_manager_dir_opts_t sorted_opts; // extensions指向sorted_ext
+    char sorted_ext[DIR_EXT_MAX];
+    uint32_t *sorted;
+    uint32_t sorted_count;
+} dir_snapshot_t;
+
+struct sd_manager_dir
+{
+    dir_snapshot_t *snap;
+    uint32_t *order; // 过滤排序后的条目序号
+    uint32_t count;
+};
+
+static SemaphoreHandle_t s_dir_lock = NULL;
+static dir_snapshot_t *s_cache = NULL;
+static uint32_t s_use_seq = 0;
+static uint32_t s_gen = 0; // 每次失效加1, 读取目录期间有变化时不缓存
+
+static esp_err_t fresult_to_dir_err(FRESULT fr)
+{
+    switch (fr)
+    {
+    case FR_OK:
+        return ESP_OK;
+    case FR_NO_FILE:
+    case FR_NO_PATH:
+        return ESP_ERR_NOT_FOUND;
+    case FR_INVALID_NAME:
+        return ESP_ERR_INVALID_ARG;
+    case FR_NOT_ENOUGH_CORE:
+        return ESP_ERR_NO_MEM;
+    default:
+        return ESP_FAIL;
+    }
+}
+
+static void *dir_alloc(size_t size)
+{
+    return heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+}
+
+static void *dir_realloc(void *ptr, size_t size)
+{
+    return heap_caps_realloc(ptr, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+}
+
+static void snapshot_free(dir_snapshot_t *snap)
+{
+    heap_caps_free(snap->items);
+    heap_caps_free(snap->names);
+    heap_caps_free(snap->sorted);
+    heap_caps_free(snap);
+}
+
+/**
+ * @brief 释放一个引用, 调用时持有s_dir_lock
+ */
+static void snapshot_release(dir_snapshot_t *snap)
+{
+    if (--snap->refs == 0)
+    {
+        snapshot_free(snap);
+    }
+}
+
+/**
+ * @brief 去掉路径末尾的'/', 缓存按规范化的路径比较
+ */
+static bool dir_normalize(const char *path, char *out, size_t out_len)
+{
+    size_t len = strlen(path);
+    while (len > 1 && path[len - 1] == '/')
+    {
+        len--;
+    }
+    if (len >= out_len)
+    {
+        return false;
+    }
+    memcpy(out, path, len);
+    out[len] = '\0';
+    return true;
+}
+
+/**
+ * @brief FAT日期时间换成time_t, 与VFS的stat()相同按本地时间换算
+ */
+static uint32_t dir_fat_time(WORD fdate, WORD ftime)
+{
+    struct tm tm = {
+        .tm_year = ((fdate >> 9) & 0x7F) + 80,
+        .tm_mon = ((fdate >> 5) & 0x0F) - 1,
+        .tm_mday = fdate & 0x1F,
+        .tm_hour = (ftime >> 11) & 0x1F,
+        .tm_min = (ftime >> 5) & 0x3F,
+        .tm_sec = (ftime & 0x1F) * 2,
+        .tm_isdst = -1,
+    };
+    return (uint32_t)mktime(&tm);
+}
+
+static esp_err_t snapshot_add(dir_snapshot_t *snap, const FILINFO *fno)
+{
+    if (snap->count == snap->cap)
+    {
+        uint32_t cap = snap->cap ? snap->cap * 2 : DIR_ITEMS_INIT;
+        dir_item_t *items = dir_realloc(snap->items, cap * sizeof(dir_item_t));
+        if (items == NULL)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+        snap->items = items;
+        snap->cap = cap;
+    }
+
+    size_t len = strlen(fno->fname) + 1;
+    if (snap->names_len + len > snap->names_cap)
+    {
+        size_t cap = snap->names_cap ? snap->names_cap : DIR_NAMES_INIT;
+        while (snap->names_len + len > cap)
+        {
+            cap *= 2;
+        }
+        char *names = dir_realloc(snap->names, cap);
+        if (names == NULL)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+        snap->names = names;
+        snap->names_cap = cap;
+    }
+
+    dir_item_t *item = &snap->items[snap->count++];
+    item->name_off = snap->names_len;
+    item->size = (fno->fattrib & AM_DIR) ? 0 : (uint32_t)fno->fsize;
+    item->mtime = dir_fat_time(fno->fdate, fno->ftime);
+    item->attr = ((fno->fattrib & AM_DIR) ? DIR_ATTR_DIR : 0) |
+                 ((fno->fattrib & (AM_HID | AM_SYS)) || fno->fname[0] == '.' ? DIR_ATTR_HIDDEN : 0);
+    memcpy(snap->names + snap->names_len, fno->fname, len);
+    snap->names_len += len;
+    return ESP_OK;
+}
+
+/**
+ * @brief 读取整个目录建立快照 (不持有缓存锁)
+ */
+static esp_err_t snapshot_load(const char *path, dir_snapshot_t **out)
+{
+    char fpath[SD_MANAGER_PATH_MAX];
+    esp_err_t ret = sd_manager_io_fatfs_path(path, fpath, sizeof(fpath));
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    dir_snapshot_t *snap = dir_alloc(sizeof(dir_snapshot_t));
+    FF_DIR *dp = malloc(sizeof(FF_DIR));
+    FILINFO *fno = malloc(sizeof(FILINFO)); // 长文件名缓冲较大, 不放在调用者的栈上
+    if (snap == NULL || dp == NULL || fno == NULL)
+    {
+        heap_caps_free(snap);
+        free(dp);
+        free(fno);
+        return ESP_ERR_NO_MEM;
+    }
+    memset(snap, 0, sizeof(dir_snapshot_t));
+    strcpy(snap->path, path);
+    snap->refs = 1;
+
+    int64_t start = esp_timer_get_time();
+    ret = fresult_to_dir_err(f_opendir(dp, fpath));
+    if (ret == ESP_OK)
+    {
+        for (;;)
+        {
+            ret = fresult_to_dir_err(f_readdir(dp, fno));
+            if (ret != ESP_OK)
+            {
+                break;
+            }
+            if (fno->fname[0] == '\0')
+            {
+                break; // 目录结束
+            }
+            if (snap->count >= SD_MANAGER_DIR_MAX_ENTRIES)
+            {
+                ESP_LOGW(TAG, "目录条目超过%d个, 其余不列出: %s", SD_MANAGER_DIR_MAX_ENTRIES, path);
+                break;
+            }
+            ret = snapshot_add(snap, fno);
+            if (ret != ESP_OK)
+            {
+                break;
+            }
+        }
+        f_closedir(dp);
+    }
+    sd_manager_io_record(SD_MANAGER_OP_LIST_DIR, ret, 0, (uint32_t)(esp_timer_get_time() - start));
+    free(dp);
+    free(fno);
+
+    if (ret != ESP_OK)
+    {
+        snapshot_free(snap);
+        return ret;
+    }
+    ESP_LOGD(TAG, "已读取目录 %s: %lu 个条目", path, (unsigned long)snap->count);
+    *out = snap;
+    return ESP_OK;
+}
+
+/**
+ * @brief 文件名的扩展名是否在分号分隔的列表中
+ */
+static bool dir_ext_match(const char *name, const char *list)
+{
+    const char *dot = strrchr(name, '.');
+    if (dot == NULL)
+    {
+        return false;
+    }
+    size_t ext_len = strlen(dot + 1);
+    const char *p = list;
+    while (*p != '\0')
+    {
+        const char *end = strchr(p, ';');
+        size_t len = (end != NULL) ? (size_t)(end - p) : strlen(p);
+        if (len == ext_len && strncasecmp(p, dot + 1, len) == 0)
+        {
+            return true;
+        }
+        if (end == NULL)
+        {
+            break;
+        }
+        p = end + 1;
+    }
+    return false;
+}
+
+static bool dir_filter(const dir_snapshot_t *snap, const dir_item_t *item, const sd_manager_dir_opts_t *opts)
+{
+    bool is_dir = (item->attr & DIR_ATTR_DIR) != 0;
+    if ((item->attr & DIR_ATTR_HIDDEN) && !opts->show_hidden)
+    {
+        return false;
+    }
+    if ((opts->type == SD_MANAGER_DIR_FILES_ONLY && is_dir) || (opts->type == SD_MANAGER_DIR_DIRS_ONLY && !is_dir))
+    {
+        return false;
+    }
+    return is_dir || opts->extensions == NULL || dir_ext_match(snap->names + item->name_off, opts->extensions);
+}
+
+static int dir_compare(const dir_snapshot_t *snap, const sd_manager_dir_opts_t *opts, uint32_t a, uint32_t b)
+{
+    const dir_item_t *x = &snap->items[a];
+    const dir_item_t *y = &snap->items[b];
+    if (opts->dirs_first && (x->attr & DIR_ATTR_DIR) != (y->attr & DIR_ATTR_DIR))
+    {
+        return (x->attr & DIR_ATTR_DIR) ? -1 : 1;
+    }
+
+    int c = 0;
+    switch (opts->sort)
+    {
+    case SD_MANAGER_SORT_SIZE:
+        c = (x->size > y->size) - (x->size < y->size);
+        break;
+    case SD_MANAGER_SORT_MTIME:
+        c = (x->mtime > y->mtime) - (x->mtime < y->mtime);
+        break;
+    default:
+        break;
+    }
+    if (c == 0 && opts->sort != SD_MANAGER_SORT_NONE)
+    {
+        // 大小或时间相同时按名称, 结果不依赖目录中的存储顺序
+        c = strcasecmp(snap->names + x->name_off, snap->names + y->name_off);
+    }
+    return opts->descending ? -c : c;
+}
+
+/**
+ * @brief 自底向上的归并排序 (稳定, 比较时需要快照和选项, 不能用qsort)
+ */
+static void dir_sort(const dir_snapshot_t *snap, const sd_manager_dir_opts_t *opts, uint32_t *order, uint32_t *tmp,
+                     uint32_t n)
+{
+    uint32_t *src = order;
+    uint32_t *dst = tmp;
+    for (uint32_t width = 1; width < n; width *= 2)
+    {
+        for (uint32_t lo = 0; lo < n; lo += 2 * width)
+        {
+            uint32_t mid = (lo + width < n) ? lo + width : n;
+            uint32_t hi = (lo + 2 * width < n) ? lo + 2 * width : n;
+            uint32_t i = lo, j = mid, k = lo;
+            while (i < mid && j < hi)
+            {
+                dst[k++] = (dir_compare(snap, opts, src[j], src[i]) < 0) ? src[j++] : src[i++];
+            }
+            while (i < mid)
+            {
+                dst[k++] = src[i++];
+            }
+            while (j < hi)
+            {
+                dst[k++] = src[j++];
+            }
+        }
+        uint32_t *t = src;
+        src = dst;
+        dst = t;
+    }
+    if (src != order)
+    {
+        memcpy(order, src, n * sizeof(uint32_t));
+    }
+}
+
+/**
+ * @brief 选项是否与快照中保存的排序结果相同
+ */
+static bool dir_opts_equal(const dir_snapshot_t *snap, const sd_manager_dir_opts_t *opts)
+{
+    const sd_manager_dir_opts_t *o = &snap->sorted_opts;
+    if (!snap->sorted_valid || o->sort != opts->sort || o->descending != opts->descending ||
+        o->dirs_first != opts->dirs_first || o->type != opts->type || o->show_hidden != opts->show_hidden)
+    {
+        return false;
+    }
+    if (opts->extensions == NULL || o->extensions == NULL)
+    {
+        return opts->extensions == o->extensions;
+    }
+    return strcasecmp(opts->extensions, o->extensions) == 0;
+}
+
+/**
+ * @brief 过滤并排序, 结果放入列表句柄 (不持有缓存锁, 快照内容不会变化)
+ */
+static esp_err_t dir_build_order(sd_manager_dir_t *dir, const sd_manager_dir_opts_t *opts)
+{
+    dir_snapshot_t *snap = dir->snap;
+    size_t bytes = (snap->count > 0 ? snap->count : 1) * sizeof(uint32_t);
+    dir->order = dir_alloc(bytes);
+    if (dir->order == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < snap->count; i++)
+    {
+        if (dir_filter(snap, &snap->items[i], opts))
+        {
+            dir->order[n++] = i;
+        }
+    }
+    dir->count = n;
+
+    if (opts->sort != SD_MANAGER_SORT_NONE || opts->dirs_first)
+    {
+        uint32_t *tmp = dir_alloc(bytes);
+        if (tmp == NULL)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+        dir_sort(snap, opts, dir->order, tmp, n);
+        heap_caps_free(tmp);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 把排序结果保存到快照, 之后相同选项的打开直接拷贝 (调用时持有s_dir_lock)
+ */
+static void dir_save_order(dir_snapshot_t *snap, const sd_manager_dir_t *dir, const sd_manager_dir_opts_t *opts)
+{
+    if (opts->extensions != NULL && strlen(opts->extensions) >= DIR_EXT_MAX)
+    {
+        return;
+    }
+    uint32_t *sorted = dir_realloc(snap->sorted, (dir->count > 0 ? dir->count : 1) * sizeof(uint32_t));
+    if (sorted == NULL)
+    {
+        return;
+    }
+    memcpy(sorted, dir->order, dir->count * sizeof(uint32_t));
+    snap->sorted = sorted;
+    snap->sorted_count = dir->count;
+    snap->sorted_opts = *opts;
+    if (opts->extensions != NULL)
+    {
+        strcpy(snap->sorted_ext, opts->extensions);
+        snap->sorted_opts.extensions = snap->sorted_ext;
+    }
+    snap->sorted_valid = true;
+}
+
+/**
+ * @brief 从缓存中移除快照并释放缓存的引用, 调用时持有s_dir_lock
+ */
+static void cache_remove(dir_snapshot_t **link)
+{
+    dir_snapshot_t *snap = *link;
+    *link = snap->next;
+    snap->next = NULL;
+    snapshot_release(snap);
+}
+
+/**
+ * @brief 快照放入缓存, 超出容量时淘汰最久未用的, 调用时持有s_dir_lock
+ */
+static void cache_insert(dir_snapshot_t *snap)
+{
+    uint32_t n = 0;
+    dir_snapshot_t **oldest = NULL;
+    for (dir_snapshot_t **it = &s_cache; *it != NULL; it = &(*it)->next)
+    {
+        if (oldest == NULL || (*it)->last_use < (*oldest)->last_use)
+        {
+            oldest = it;
+        }
+        n++;
+    }
+    if (n >= SD_MANAGER_DIR_CACHE_DIRS)
+    {
+        cache_remove(oldest);
+    }
+
+    snap->refs++;
+    snap->next = s_cache;
+    s_cache = snap;
+}
+
+esp_err_t sd_manager_dir_open(const char *dir_path, const sd_manager_dir_opts_t *opts, sd_manager_dir_t **out)
+{
+    static const sd_manager_dir_opts_t s_default_opts = {0};
+    if (dir_path == NULL || out == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out = NULL;
+    if (s_dir_lock == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    opts = (opts != NULL) ? opts : &s_default_opts;
+
+    char path[SD_MANAGER_PATH_MAX];
+    if (!dir_normalize(dir_path, path, sizeof(path)))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sd_manager_dir_t *dir = calloc(1, sizeof(sd_manager_dir_t));
+    if (dir == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // 查找缓存, 找到时顺便取出相同选项的排序结果
+    xSemaphoreTake(s_dir_lock, portMAX_DELAY);
+    for (dir_snapshot_t *it = s_cache; it != NULL; it = it->next)
+    {
+        if (strcasecmp(it->path, path) == 0)
+        {
+            dir->snap = it;
+            it->refs++;
+            it->last_use = ++s_use_seq;
+            if (dir_opts_equal(it, opts))
+            {
+                dir->order = dir_alloc((it->sorted_count > 0 ? it->sorted_count : 1) * sizeof(uint32_t));
+                if (dir->order != NULL)
+                {
+                    memcpy(dir->order, it->sorted, it->sorted_count * sizeof(uint32_t));
+                    dir->count = it->sorted_count;
+                }
+            }
+            break;
+        }
+    }
+    uint32_t gen = s_gen;
+    xSemaphoreGive(s_dir_lock);
+    sd_manager_io_record_dir_cache(dir->snap != NULL);
+
+    if (dir->snap == NULL)
+    {
+        dir_snapshot_t *snap = NULL;
+        esp_err_t ret = snapshot_load(path, &snap);
+        if (ret != ESP_OK)
+        {
+            free(dir);
+            return ret;
+        }
+        dir->snap = snap;
+
+        xSemaphoreTake(s_dir_lock, portMAX_DELAY);
+        if (gen == s_gen)
+        {
+            // 读取期间可能有其他任务缓存了同一目录, 用新读到的替换
+            for (dir_snapshot_t **it = &s_cache; *it != NULL; it = &(*it)->next)
+            {
+                if (strcasecmp((*it)->path, path) == 0)
+                {
+                    cache_remove(it);
+                    break;
+                }
+            }
+            snap->last_use = ++s_use_seq;
+            cache_insert(snap);
+        }
+        xSemaphoreGive(s_dir_lock);
+    }
+
+    if (dir->order == NULL)
+    {
+        esp_err_t ret = dir_build_order(dir, opts);
+        if (ret != ESP_OK)
+        {
+            sd_manager_dir_close(dir);
+            return ret;
+        }
+        xSemaphoreTake(s_dir_lock, portMAX_DELAY);
+        dir_save_order(dir->snap, dir, opts);
+        xSemaphoreGive(s_dir_lock);
+    }
+
+    *out = dir;
+    return ESP_OK;
+}
+
+uint32_t sd_manager_dir_count(const sd_manager_dir_t *dir)
+{
+    return (dir != NULL) ? dir->count : 0;
+}
+
+esp_err_t sd_manager_dir_read(const sd_manager_dir_t *dir, uint32_t start, sd_manager_dir_entry_t *entries,
+                              uint32_t max, uint32_t *out_count)
+{
+    if (dir == NULL || out_count == NULL || (entries == NULL && max > 0))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t n = 0;
+    const dir_snapshot_t *snap = dir->snap;
+    for (uint32_t i = start; i < dir->count && n < max; i++, n++)
+    {
+        const dir_item_t *item = &snap->items[dir->order[i]];
+        entries[n].name = snap->names + item->name_off;
+        entries[n].size = item->size;
+        entries[n].mtime = item->mtime;
+        entries[n].is_dir = (item->attr & DIR_ATTR_DIR) != 0;
+    }
+    *out_count = n;
+    return ESP_OK;
+}
+
+void sd_manager_dir_close(sd_manager_dir_t *dir)
+{
+    if (dir == NULL)
+    {
+        return;
+    }
+    heap_caps_free(dir->order);
+    if (dir->snap != NULL)
+    {
+        if (s_dir_lock != NULL)
+        {
+            xSemaphoreTake(s_dir_lock, portMAX_DELAY);
+            snapshot_release(dir->snap);
+            xSemaphoreGive(s_dir_lock);
+        }
+        else
+        {
+            snapshot_release(dir->snap); // 卸载后关闭, 缓存已经清空
+        }
+    }
+    free(dir);
+}
+
+/**
+ * @brief 移除路径为path的缓存, 调用时持有s_dir_lock
+ */
+static void cache_drop(const char *path)
+{
+    for (dir_snapshot_t **it = &s_cache; *it != NULL; it = &(*it)->next)
+    {
+        if (strcasecmp((*it)->path, path) == 0)
+        {
+            cache_remove(it);
+            return;
+        }
+    }
+}
+
+void sd_manager_dir_invalidate(const char *dir_path)
+{
+    if (s_dir_lock == NULL)
+    {
+        return;
+    }
+    char path[SD_MANAGER_PATH_MAX];
+    if (dir_path != NULL && !dir_normalize(dir_path, path, sizeof(path)))
+    {
+        return;
+    }
+
+    xSemaphoreTake(s_dir_lock, portMAX_DELAY);
+    s_gen++;
+    if (dir_path == NULL)
+    {
+        while (s_cache != NULL)
+        {
+            cache_remove(&s_cache);
+        }
+    }
+    else
+    {
+        cache_drop(path);
+    }
+    xSemaphoreGive(s_dir_lock);
+}
+
+void sd_manager_dir_changed(const char *path)
+{
+    if (s_dir_lock == NULL || path == NULL)
+    {
+        return;
+    }
+    char self[SD_MANAGER_PATH_MAX];
+    if (!dir_normalize(path, self, sizeof(self)))
+    {
+        return;
+    }
+    char parent[SD_MANAGER_PATH_MAX];
+    strcpy(parent, self);
+    char *slash = strrchr(parent, '/');
+    if (slash != NULL)
+    {
+        *slash = '\0';
+    }
+
+    xSemaphoreTake(s_dir_lock, portMAX_DELAY);
+    s_gen++;
+    cache_drop(self); // 删除或重建的目录本身
+    cache_drop(parent);
+    xSemaphoreGive(s_dir_lock);
+}
+
+void sd_manager_file_changed(const char *file_path)
+{
+    sd_manager_dir_changed(file_path);
+}
+
+esp_err_t sd_manager_dir_init(void)
+{
+    if (s_dir_lock == NULL)
+    {
+        s_dir_lock = xSemaphoreCreateMutex();
+    }
+    return (s_dir_lock != NULL) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+void sd_manager_dir_deinit(void)
+{
+    if (s_dir_lock == NULL)
+    {
+        return;
+    }
+    xSemaphoreTake(s_dir_lock, portMAX_DELAY);
+    while (s_cache != NULL)
+    {
+        cache_remove(&s_cache);
+    }
+    xSemaphoreGive(s_dir_lock);
+    vSemaphoreDelete(s_dir_lock);
+    s_dir_lock = NULL;
+}
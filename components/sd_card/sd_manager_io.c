@@ -0,0 +1,1131 @@
+/**
+ * @file sd_manager_io.c
+ * @brief SD卡文件读写层
+ * @details 文件接口直接使用FatFs, 不经过VFS和newlib stdio:
+ *          - f_read/f_write对扇区对齐的部分直接在调用者缓冲区和卡之间多扇区传输,
+ *            只有首尾不满一个扇区的部分经过文件的扇区窗口
+ *          - 写入前用f_expand(opt=0)找好连续空间, 分配簇时不再搜索FAT
+ *          - 异步请求由一个I/O任务按类别调度 (见sched_pick), 同一时刻只有它在传输异步数据
+ *          路径仍使用VFS形式("/sdcard/..."), 在这里换成FatFs的驱动器前缀("0:/...")。
+ *          修改文件和目录的操作会通知目录列表缓存 (sd_manager_dir.c) 使对应目录失效。
+ *          不依赖SD卡驱动, 主机替身挂载FAT镜像后可以直接编译运行。
+ */
+
+#include "sd_manager.h"
+#include "sd_manager_io.h"
+#include "sd_manager_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "ff.h"
+
+#define TAG "sd_manager"
+
+#if configTASK_NOTIFICATION_ARRAY_ENTRIES <= SD_MANAGER_IO_NOTIFY_INDEX
+#error "SD_MANAGER_IO_NOTIFY_INDEX需要CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES >= 2"
+#endif
+
+typedef enum
+{
+    IO_REQ_READ_FILE,  // 整个文件 (按路径)
+    IO_REQ_WRITE_FILE,
+    IO_REQ_READ_AT,    // 句柄上的一段
+    IO_REQ_WRITE_AT,
+} io_req_type_t;
+
+// 异步请求, 放在静态请求槽中, 每个类别一条单向链表 (按提交顺序)
+typedef struct io_request
+{
+    struct io_request *next;   // 队列中的下一个
+    struct io_request *merged; // 合并到本请求一起传输的下一个请求
+    io_req_type_t type;
+    sd_manager_io_class_t cls;
+    char path[SD_MANAGER_PATH_MAX]; // 整文件请求的路径
+    sd_manager_file_t *file;        // 按偏移请求的句柄
+    FIL *own;                       // 整文件请求打开的文件
+    uint32_t offset;
+    uint8_t *buffer;
+    size_t size;  // 本请求的字节数
+    size_t total; // 含合并请求的总字节数
+    size_t done;  // 已传输的字节数
+    bool started;
+    bool finished;
+    esp_err_t ret;
+    int64_t submit_us;
+    uint32_t exec_us;
+    sd_manager_io_cb_t cb;
+    void *arg;
+    TaskHandle_t notify; // cb为NULL时通知的任务 (SD_MANAGER_IO_NOTIFY_INDEX号通知)
+} io_request_t;
+
+struct sd_manager_file
+{
+    FIL fil;          // 只在I/O任务中读写
+    uint32_t pending; // 未完成的请求数, 受s_sched_lock保护
+    bool write;
+    char path[SD_MANAGER_PATH_MAX]; // 以读写方式打开时, 关闭时使所在目录的列表缓存失效
+};
+
+struct sd_manager_writer
+{
+    sd_manager_file_t *file;
+    sd_manager_io_class_t cls;
+    uint8_t *buf; // SD_MANAGER_WRITER_BUF, 对齐的DMA缓冲
+    size_t used;
+    uint32_t offset; // 下一次写入的文件偏移
+    esp_err_t err;   // 第一次写入失败的结果
+};
+
+static bool s_ready = false;
+static uint8_t s_pdrv;
+static char s_mount[16];
+static size_t s_mount_len;
+
+static io_request_t s_slots[SD_MANAGER_IO_MAX_REQUESTS];
+static io_request_t *s_free = NULL;
+static size_t s_free_count = 0;
+static io_request_t *s_queue[SD_MANAGER_CLASS_MAX];
+static SemaphoreHandle_t s_sched_lock = NULL; // 保护请求槽、队列和句柄的pending
+static TaskHandle_t s_io_task = NULL;
+static SemaphoreHandle_t s_stopped = NULL;
+static volatile bool s_stopping = false;
+static sd_manager_file_t *s_last_file = NULL; // 上一次传输的句柄和结束位置, 用于顺序续读优先
+static uint32_t s_last_end = 0;
+
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static sd_manager_stats_t s_stats;
+
+static esp_err_t fresult_to_err(FRESULT fr)
+{
+    switch (fr)
+    {
+    case FR_OK:
+        return ESP_OK;
+    case FR_NO_FILE:
+    case FR_NO_PATH:
+        return ESP_ERR_NOT_FOUND;
+    case FR_INVALID_NAME:
+    case FR_INVALID_OBJECT:
+    case FR_INVALID_PARAMETER:
+        return ESP_ERR_INVALID_ARG;
+    case FR_EXIST:
+    case FR_DENIED:
+    case FR_LOCKED:
+        return ESP_ERR_INVALID_STATE;
+    case FR_NOT_ENOUGH_CORE:
+        return ESP_ERR_NO_MEM;
+    case FR_TIMEOUT:
+        return ESP_ERR_TIMEOUT;
+    default:
+        return ESP_FAIL;
+    }
+}
+
+/**
+ * @brief VFS路径换成FatFs路径: "/sdcard/a/b.wav" -> "0:/a/b.wav"
+ */
+static esp_err_t io_path(const char *path, char *out, size_t out_len)
+{
+    if (!s_ready)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (path == NULL || strncmp(path, s_mount, s_mount_len) != 0 ||
+        (path[s_mount_len] != '/' && path[s_mount_len] != '\0'))
+    {
+        ESP_LOGW(TAG, "路径不在%s下: %s", s_mount, path ? path : "(null)");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const char *rest = path + s_mount_len;
+    int n = snprintf(out, out_len, "%u:%s", (unsigned)s_pdrv, rest[0] != '\0' ? rest : "/");
+    return (n > 0 && (size_t)n < out_len) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+static void stats_record_us(sd_manager_op_t op, esp_err_t ret, size_t bytes, uint32_t us)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    sd_manager_op_stats_t *st = &s_stats.op[op];
+    st->calls++;
+    if (ret != ESP_OK)
+    {
+        st->errors++;
+    }
+    st->bytes += bytes;
+    st->total_us += us;
+    st->last_us = us;
+    if (us > st->max_us)
+    {
+        st->max_us = us;
+    }
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+static void stats_record(sd_manager_op_t op, esp_err_t ret, size_t bytes, int64_t start_us)
+{
+    stats_record_us(op, ret, bytes, (uint32_t)(esp_timer_get_time() - start_us));
+}
+
+esp_err_t sd_manager_io_fatfs_path(const char *path, char *out, size_t out_len)
+{
+    return io_path(path, out, out_len);
+}
+
+void sd_manager_io_record(sd_manager_op_t op, esp_err_t ret, size_t bytes, uint32_t us)
+{
+    stats_record_us(op, ret, bytes, us);
+}
+
+void sd_manager_io_record_dir_cache(bool hit)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    if (hit)
+    {
+        s_stats.dir_cache_hits++;
+    }
+    else
+    {
+        s_stats.dir_cache_misses++;
+    }
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+static FIL *io_open(const char *path, BYTE mode, esp_err_t *ret)
+{
+    char fpath[SD_MANAGER_PATH_MAX];
+    *ret = io_path(path, fpath, sizeof(fpath));
+    if (*ret != ESP_OK)
+    {
+        return NULL;
+    }
+
+    FIL *fp = malloc(sizeof(FIL));
+    if (fp == NULL)
+    {
+        *ret = ESP_ERR_NO_MEM;
+        return NULL;
+    }
+    *ret = fresult_to_err(f_open(fp, fpath, mode));
+    if (*ret != ESP_OK)
+    {
+        ESP_LOGD(TAG, "打开失败: %s (%s)", path, esp_err_to_name(*ret));
+        free(fp);
+        return NULL;
+    }
+    return fp;
+}
+
+static esp_err_t io_close(FIL *fp)
+{
+    esp_err_t ret = fresult_to_err(f_close(fp));
+    free(fp);
+    return ret;
+}
+
+esp_err_t sd_manager_create_dir(const char *dir_path)
+{
+    int64_t start = esp_timer_get_time();
+    char fpath[SD_MANAGER_PATH_MAX];
+    esp_err_t ret = io_path(dir_path, fpath, sizeof(fpath));
+    if (ret == ESP_OK)
+    {
+        FRESULT fr = f_mkdir(fpath);
+        if (fr == FR_EXIST)
+        {
+            // 已存在的目录视为成功, 同名文件仍然报错
+            FILINFO fno;
+            fr = f_stat(fpath, &fno);
+            fr = (fr == FR_OK && !(fno.fattrib & AM_DIR)) ? FR_EXIST : fr;
+        }
+        ret = fresult_to_err(fr);
+        if (ret == ESP_OK)
+        {
+            sd_manager_dir_changed(dir_path);
+        }
+    }
+
+    stats_record(SD_MANAGER_OP_CREATE_DIR, ret, 0, start);
+    return ret;
+}
+
+esp_err_t sd_manager_delete_file(const char *file_path)
+{
+    int64_t start = esp_timer_get_time();
+    char fpath[SD_MANAGER_PATH_MAX];
+    esp_err_t ret = io_path(file_path, fpath, sizeof(fpath));
+    if (ret == ESP_OK)
+    {
+        ret = fresult_to_err(f_unlink(fpath));
+        if (ret == ESP_OK)
+        {
+            sd_manager_dir_changed(file_path);
+        }
+    }
+
+    stats_record(SD_MANAGER_OP_DELETE, ret, 0, start);
+    return ret;
+}
+
+esp_err_t sd_manager_rename_file(const char *from_path, const char *to_path)
+{
+    int64_t start = esp_timer_get_time();
+    char from[SD_MANAGER_PATH_MAX];
+    char to[SD_MANAGER_PATH_MAX];
+    esp_err_t ret = io_path(from_path, from, sizeof(from));
+    if (ret == ESP_OK)
+    {
+        ret = io_path(to_path, to, sizeof(to));
+    }
+    if (ret == ESP_OK)
+    {
+        // FatFs不覆盖已存在的目标
+        FRESULT fr = f_rename(from, to);
+        if (fr == FR_EXIST)
+        {
+            fr = f_unlink(to);
+            fr = (fr == FR_OK) ? f_rename(from, to) : fr;
+        }
+        ret = fresult_to_err(fr);
+        if (ret == ESP_OK)
+        {
+            sd_manager_dir_changed(from_path);
+            sd_manager_dir_changed(to_path);
+        }
+    }
+
+    stats_record(SD_MANAGER_OP_RENAME, ret, 0, start);
+    return ret;
+}
+
+esp_err_t sd_manager_get_file_size(const char *file_path, size_t *file_size)
+{
+    if (file_size == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t start = esp_timer_get_time();
+    char fpath[SD_MANAGER_PATH_MAX];
+    esp_err_t ret = io_path(file_path, fpath, sizeof(fpath));
+    if (ret == ESP_OK)
+    {
+        FILINFO fno;
+        ret = fresult_to_err(f_stat(fpath, &fno));
+        *file_size = (ret == ESP_OK) ? (size_t)fno.fsize : 0;
+    }
+
+    stats_record(SD_MANAGER_OP_GET_SIZE, ret, 0, start);
+    return ret;
+}
+
+/**
+ * @brief 从空闲请求槽分配请求并排到所属类别的队尾
+ * @note 界面和后台请求不能用掉留给音频和录音的SD_MANAGER_IO_RESERVED个请求槽
+ */
+static esp_err_t io_submit(io_req_type_t type, sd_manager_io_class_t io_class, const char *path,
+                           sd_manager_file_t *file, uint32_t offset, const void *buffer, size_t size,
+                           sd_manager_io_cb_t cb, void *arg)
+{
+    if ((unsigned)io_class >= SD_MANAGER_CLASS_MAX || (buffer == NULL && size > 0) ||
+        (file == NULL && (path == NULL || strlen(path) >= SD_MANAGER_PATH_MAX)))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_ready || s_stopping)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    size_t reserve = (io_class >= SD_MANAGER_CLASS_UI) ? SD_MANAGER_IO_RESERVED : 0;
+    xSemaphoreTake(s_sched_lock, portMAX_DELAY);
+    if (s_free_count <= reserve)
+    {
+        xSemaphoreGive(s_sched_lock);
+        portENTER_CRITICAL(&s_stats_lock);
+        s_stats.cls[io_class].rejected++;
+        portEXIT_CRITICAL(&s_stats_lock);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    io_request_t *req = s_free;
+    s_free = req->next;
+    s_free_count--;
+    memset(req, 0, sizeof(io_request_t));
+    req->type = type;
+    req->cls = io_class;
+    req->file = file;
+    req->offset = offset;
+    req->buffer = (uint8_t *)buffer;
+    req->size = size;
+    req->cb = cb;
+    req->arg = arg;
+    req->notify = (cb == NULL) ? xTaskGetCurrentTaskHandle() : NULL;
+    req->submit_us = esp_timer_get_time();
+    if (file == NULL)
+    {
+        strcpy(req->path, path);
+    }
+    else
+    {
+        file->pending++;
+    }
+
+    io_request_t **tail = &s_queue[io_class];
+    while (*tail != NULL)
+    {
+        tail = &(*tail)->next;
+    }
+    *tail = req;
+    xSemaphoreGive(s_sched_lock);
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.cls[io_class].pending++;
+    portEXIT_CRITICAL(&s_stats_lock);
+
+    xTaskNotifyGive(s_io_task);
+    return ESP_OK;
+}
+
+static void sched_record_wait(io_request_t *req, int64_t now)
+{
+    uint32_t wait_us = (uint32_t)(now - req->submit_us);
+    req->started = true;
+
+    portENTER_CRITICAL(&s_stats_lock);
+    sd_manager_class_stats_t *st = &s_stats.cls[req->cls];
+    st->wait_total_us += wait_us;
+    if (wait_us > st->wait_max_us)
+    {
+        st->wait_max_us = wait_us;
+    }
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+/**
+ * @brief 把同一句柄上紧接着的请求合并进来 (偏移和缓冲区都相邻), 一次传输完成
+ * @note 调用时持有s_sched_lock
+ */
+static void sched_merge(io_request_t *req, int64_t now)
+{
+    req->total = req->size;
+    if (req->file == NULL)
+    {
+        return;
+    }
+
+    io_request_t *tail = req;
+    io_request_t **it = &s_queue[req->cls];
+    while (*it != NULL)
+    {
+        io_request_t *r = *it;
+        if (r->file == req->file && r->type == req->type && r->offset == req->offset + req->total &&
+            r->buffer == req->buffer + req->total && req->total + r->size <= SD_MANAGER_IO_MERGE_MAX)
+        {
+            *it = r->next;
+            r->next = NULL;
+            tail->merged = r;
+            tail = r;
+            req->total += r->size;
+            sched_record_wait(r, now);
+
+            portENTER_CRITICAL(&s_stats_lock);
+            s_stats.cls[req->cls].merged++;
+            portEXIT_CRITICAL(&s_stats_lock);
+
+            it = &s_queue[req->cls]; // 合并后下一段可能排在前面, 从头再找
+            continue;
+        }
+        it = &r->next;
+    }
+}
+
+/**
+ * @brief 选出下一个要执行的请求: 先按类别, 同类中顺序续读优先
+ * @details 分片执行中的请求和等待超过SD_MANAGER_IO_AGING_MS的请求不参与重排, 避免饿死
+ */
+static io_request_t *sched_pick(void)
+{
+    int64_t now = esp_timer_get_time();
+    io_request_t *req = NULL;
+
+    xSemaphoreTake(s_sched_lock, portMAX_DELAY);
+    for (int c = 0; c < SD_MANAGER_CLASS_MAX && req == NULL; c++)
+    {
+        io_request_t **pick = &s_queue[c];
+        if (*pick == NULL)
+        {
+            continue;
+        }
+
+        io_request_t *head = *pick;
+        if (!head->started && now - head->submit_us < SD_MANAGER_IO_AGING_MS * 1000LL && s_last_file != NULL)
+        {
+            for (io_request_t **it = &s_queue[c]; *it != NULL; it = &(*it)->next)
+            {
+                if ((*it)->file == s_last_file && (*it)->offset == s_last_end)
+                {
+                    pick = it;
+                    break;
+                }
+            }
+        }
+
+        req = *pick;
+        *pick = req->next;
+        req->next = NULL;
+        if (!req->started)
+        {
+            sched_record_wait(req, now);
+            sched_merge(req, now);
+        }
+    }
+    xSemaphoreGive(s_sched_lock);
+    return req;
+}
+
+/**
+ * @brief 执行请求的一片: 音频和录音一次做完, 界面和后台最多SD_MANAGER_IO_SLICE字节
+ */
+static void io_run_slice(io_request_t *req)
+{
+    int64_t start = esp_timer_get_time();
+    bool is_read = (req->type == IO_REQ_READ_FILE || req->type == IO_REQ_READ_AT);
+    FIL *fp = req->own;
+
+    if (req->file != NULL)
+    {
+        fp = &req->file->fil;
+        FSIZE_t pos = (FSIZE_t)req->offset + req->done;
+        if (f_tell(fp) != pos)
+        {
+            req->ret = fresult_to_err(f_lseek(fp, pos));
+        }
+    }
+    else if (fp == NULL)
+    {
+        // 整文件请求在第一片时打开, 最后一片后关闭
+        fp = io_open(req->path, is_read ? FA_READ : (FA_WRITE | FA_CREATE_ALWAYS), &req->ret);
+        if (fp != NULL && !is_read && req->total > 0)
+        {
+            f_expand(fp, req->total, 0);
+        }
+        req->own = fp;
+    }
+
+    size_t n = req->total - req->done;
+    if (req->cls >= SD_MANAGER_CLASS_UI && n > SD_MANAGER_IO_SLICE)
+    {
+        n = SD_MANAGER_IO_SLICE;
+    }
+
+    UINT xfer = 0;
+    if (fp != NULL && req->ret == ESP_OK && n > 0)
+    {
+        FRESULT fr = is_read ? f_read(fp, req->buffer + req->done, n, &xfer)
+                             : f_write(fp, req->buffer + req->done, n, &xfer);
+        req->ret = fresult_to_err(fr);
+        if (req->ret == ESP_OK && !is_read && xfer != n)
+        {
+            req->ret = ESP_ERR_NO_MEM; // 卡已满
+        }
+        req->done += xfer;
+        if (req->file != NULL)
+        {
+            s_last_file = req->file;
+            s_last_end = req->offset + req->done;
+        }
+    }
+
+    // 出错、读到文件末尾或全部完成时结束
+    req->finished = (fp == NULL || req->ret != ESP_OK || xfer < n || req->done == req->total);
+    if (req->finished && req->own != NULL)
+    {
+        esp_err_t close_ret = io_close(req->own);
+        req->own = NULL;
+        req->ret = (req->ret == ESP_OK) ? close_ret : req->ret;
+        if (!is_read)
+        {
+            sd_manager_dir_changed(req->path);
+        }
+    }
+    req->exec_us += (uint32_t)(esp_timer_get_time() - start);
+}
+
+/**
+ * @brief 完成请求和合并进来的请求: 先归还请求槽再通知, 回调中可以立即提交新请求
+ */
+static void io_complete(io_request_t *req)
+{
+    bool is_read = (req->type == IO_REQ_READ_FILE || req->type == IO_REQ_READ_AT);
+    esp_err_t ret = req->ret;
+    size_t remain = req->done;
+    stats_record_us(is_read ? SD_MANAGER_OP_READ : SD_MANAGER_OP_WRITE, ret, req->done, req->exec_us);
+
+    io_request_t *r = req;
+    while (r != NULL)
+    {
+        io_request_t *next = r->merged;
+        sd_manager_io_class_t io_class = r->cls;
+        sd_manager_io_cb_t cb = r->cb;
+        void *arg = r->arg;
+        TaskHandle_t notify = r->notify;
+        size_t bytes = (r->size < remain) ? r->size : remain;
+        remain -= bytes;
+
+        xSemaphoreTake(s_sched_lock, portMAX_DELAY);
+        if (r->file != NULL)
+        {
+            r->file->pending--;
+        }
+        r->next = s_free;
+        s_free = r;
+        s_free_count++;
+        xSemaphoreGive(s_sched_lock);
+
+        portENTER_CRITICAL(&s_stats_lock);
+        s_stats.cls[io_class].requests++;
+        s_stats.cls[io_class].pending--;
+        portEXIT_CRITICAL(&s_stats_lock);
+
+        if (cb != NULL)
+        {
+            cb(ret, bytes, arg);
+        }
+        else
+        {
+            xTaskNotifyIndexed(notify, SD_MANAGER_IO_NOTIFY_INDEX, (uint32_t)ret, eSetValueWithOverwrite);
+        }
+        r = next;
+    }
+}
+
+/**
+ * @brief I/O任务: 每次执行一片, 未完成的请求放回队首, 下一轮先检查更高类别
+ */
+static void io_task(void *arg)
+{
+    for (;;)
+    {
+        io_request_t *req = sched_pick();
+        if (req == NULL)
+        {
+            if (s_stopping)
+            {
+                break;
+            }
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        io_run_slice(req);
+        if (req->finished)
+        {
+            io_complete(req);
+        }
+        else
+        {
+            xSemaphoreTake(s_sched_lock, portMAX_DELAY);
+            req->next = s_queue[req->cls];
+            s_queue[req->cls] = req;
+            xSemaphoreGive(s_sched_lock);
+        }
+    }
+
+    xSemaphoreGive(s_stopped);
+    vTaskDelete(NULL);
+}
+
+esp_err_t sd_manager_read_file_async(const char *file_path, void *buffer, size_t buffer_size,
+                                     sd_manager_io_class_t io_class, sd_manager_io_cb_t cb, void *arg)
+{
+    return io_submit(IO_REQ_READ_FILE, io_class, file_path, NULL, 0, buffer, buffer_size, cb, arg);
+}
+
+esp_err_t sd_manager_write_file_async(const char *file_path, const void *data, size_t data_size,
+                                      sd_manager_io_class_t io_class, sd_manager_io_cb_t cb, void *arg)
+{
+    return io_submit(IO_REQ_WRITE_FILE, io_class, file_path, NULL, 0, data, data_size, cb, arg);
+}
+
+esp_err_t sd_manager_file_open(const char *file_path, bool write, sd_manager_file_t **out)
+{
+    if (out == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out = NULL;
+
+    char fpath[SD_MANAGER_PATH_MAX];
+    esp_err_t ret = io_path(file_path, fpath, sizeof(fpath));
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    sd_manager_file_t *file = calloc(1, sizeof(sd_manager_file_t));
+    if (file == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    ret = fresult_to_err(f_open(&file->fil, fpath, write ? (FA_READ | FA_WRITE | FA_OPEN_ALWAYS) : FA_READ));
+    if (ret != ESP_OK)
+    {
+        free(file);
+        return ret;
+    }
+    if (write)
+    {
+        // 文件可能是新建的
+        file->write = true;
+        snprintf(file->path, sizeof(file->path), "%s", file_path);
+        sd_manager_dir_changed(file->path);
+    }
+
+    *out = file;
+    return ESP_OK;
+}
+
+esp_err_t sd_manager_file_read_async(sd_manager_file_t *file, uint32_t offset, void *buffer, size_t len,
+                                     sd_manager_io_class_t io_class, sd_manager_io_cb_t cb, void *arg)
+{
+    if (file == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return io_submit(IO_REQ_READ_AT, io_class, NULL, file, offset, buffer, len, cb, arg);
+}
+
+esp_err_t sd_manager_file_write_async(sd_manager_file_t *file, uint32_t offset, const void *data, size_t len,
+                                      sd_manager_io_class_t io_class, sd_manager_io_cb_t cb, void *arg)
+{
+    if (file == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return io_submit(IO_REQ_WRITE_AT, io_class, NULL, file, offset, data, len, cb, arg);
+}
+
+// 同步接口: 提交后在栈上的信号量上等待完成回调
+typedef struct
+{
+    SemaphoreHandle_t done;
+    esp_err_t ret;
+    size_t bytes;
+} io_waiter_t;
+
+static void io_wait_cb(esp_err_t ret, size_t bytes, void *arg)
+{
+    io_waiter_t *w = (io_waiter_t *)arg;
+    w->ret = ret;
+    w->bytes = bytes;
+    xSemaphoreGive(w->done);
+}
+
+/**
+ * @brief 提交请求并等待完成, 没有空闲请求槽时等待其他请求完成后重试
+ * @param path 整文件请求的路径, 按偏移请求时为NULL
+ */
+static esp_err_t io_submit_wait(io_req_type_t type, const char *path, sd_manager_file_t *file, uint32_t offset,
+                                const void *buffer, size_t len, sd_manager_io_class_t io_class, size_t *bytes)
+{
+    if (bytes != NULL)
+    {
+        *bytes = 0;
+    }
+    if (file == NULL && path == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_io_task != NULL && xTaskGetCurrentTaskHandle() == s_io_task)
+    {
+        return ESP_ERR_INVALID_STATE; // 在完成回调中等待会死锁
+    }
+
+    StaticSemaphore_t sem;
+    io_waiter_t w = {.done = xSemaphoreCreateBinaryStatic(&sem)};
+    esp_err_t ret;
+    while ((ret = io_submit(type, io_class, path, file, offset, buffer, len, io_wait_cb, &w)) == ESP_ERR_TIMEOUT)
+    {
+        vTaskDelay(pdMS_TO_TICKS(SD_MANAGER_IO_RETRY_MS));
+    }
+    if (ret == ESP_OK)
+    {
+        xSemaphoreTake(w.done, portMAX_DELAY);
+        ret = w.ret;
+        if (bytes != NULL)
+        {
+            *bytes = w.bytes;
+        }
+    }
+    vSemaphoreDelete(w.done);
+    return ret;
+}
+
+esp_err_t sd_manager_file_read(sd_manager_file_t *file, uint32_t offset, void *buffer, size_t len,
+                               sd_manager_io_class_t io_class, size_t *bytes_read)
+{
+    if (file == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return io_submit_wait(IO_REQ_READ_AT, NULL, file, offset, buffer, len, io_class, bytes_read);
+}
+
+esp_err_t sd_manager_file_write(sd_manager_file_t *file, uint32_t offset, const void *data, size_t len,
+                                sd_manager_io_class_t io_class)
+{
+    if (file == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t written = 0;
+    esp_err_t ret = io_submit_wait(IO_REQ_WRITE_AT, NULL, file, offset, data, len, io_class, &written);
+    return (ret == ESP_OK && written != len) ? ESP_ERR_NO_MEM : ret;
+}
+
+esp_err_t sd_manager_read_file(const char *file_path, void *buffer, size_t buffer_size, size_t *bytes_read)
+{
+    if (bytes_read != NULL)
+    {
+        *bytes_read = 0;
+    }
+    if (buffer == NULL && buffer_size > 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // 作为后台请求分片执行, 每片之间先处理音频请求; 数据由FatFs直接传输到buffer
+    return io_submit_wait(IO_REQ_READ_FILE, file_path, NULL, 0, buffer, buffer_size, SD_MANAGER_CLASS_BACKGROUND,
+                          bytes_read);
+}
+
+esp_err_t sd_manager_write_file(const char *file_path, const void *data, size_t data_size)
+{
+    if (data == NULL && data_size > 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t written = 0;
+    esp_err_t ret = io_submit_wait(IO_REQ_WRITE_FILE, file_path, NULL, 0, data, data_size,
+                                   SD_MANAGER_CLASS_BACKGROUND, &written);
+    ret = (ret == ESP_OK && written != data_size) ? ESP_ERR_NO_MEM : ret; // 卡已满
+    if (ret != ESP_OK)
+    {
+        ESP_LOGW(TAG, "写入失败: %s (%s)", file_path ? file_path : "(null)", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/**
+ * @brief 句柄上没有未完成的请求时, 调用者任务可以直接操作fil
+ */
+static bool file_idle(sd_manager_file_t *file)
+{
+    xSemaphoreTake(s_sched_lock, portMAX_DELAY);
+    uint32_t pending = file->pending;
+    xSemaphoreGive(s_sched_lock);
+    return pending == 0;
+}
+
+esp_err_t sd_manager_file_sync(sd_manager_file_t *file)
+{
+    if (file == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!file_idle(file))
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return fresult_to_err(f_sync(&file->fil));
+}
+
+esp_err_t sd_manager_file_truncate(sd_manager_file_t *file, uint32_t size)
+{
+    if (file == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!file->write || !file_idle(file))
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t ret = fresult_to_err(f_lseek(&file->fil, size));
+    if (ret == ESP_OK)
+    {
+        ret = fresult_to_err(f_truncate(&file->fil));
+    }
+    return ret;
+}
+
+esp_err_t sd_manager_file_close(sd_manager_file_t *file)
+{
+    if (file == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(s_sched_lock, portMAX_DELAY);
+    if (s_last_file == file)
+    {
+        s_last_file = NULL;
+    }
+    xSemaphoreGive(s_sched_lock);
+    if (!file_idle(file))
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = fresult_to_err(f_close(&file->fil));
+    if (file->write)
+    {
+        sd_manager_dir_changed(file->path);
+    }
+    free(file);
+    return ret;
+}
+
+esp_err_t sd_manager_writer_open(const char *file_path, size_t size_hint, sd_manager_io_class_t io_class,
+                                 sd_manager_writer_t **out)
+{
+    if (out == NULL || (unsigned)io_class >= SD_MANAGER_CLASS_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out = NULL;
+
+    sd_manager_writer_t *w = calloc(1, sizeof(sd_manager_writer_t));
+    if (w == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    w->cls = io_class;
+    w->buf = sd_manager_alloc_io_buffer(SD_MANAGER_WRITER_BUF);
+    if (w->buf == NULL)
+    {
+        free(w);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // 覆盖已有文件: 截断到0后才能预留连续簇; 句柄刚打开没有请求, 可以直接操作fil
+    esp_err_t ret = sd_manager_file_open(file_path, true, &w->file);
+    if (ret == ESP_OK)
+    {
+        ret = sd_manager_file_truncate(w->file, 0);
+        if (ret != ESP_OK)
+        {
+            sd_manager_file_close(w->file);
+        }
+    }
+    if (ret != ESP_OK)
+    {
+        free(w->buf);
+        free(w);
+        return ret;
+    }
+    if (size_hint > 0)
+    {
+        f_expand(&w->file->fil, size_hint, 0);
+    }
+
+    *out = w;
+    return ESP_OK;
+}
+
+/**
+ * @brief 经I/O调度写入一段, 后台类别的大块按SD_MANAGER_IO_SLICE分片, 不会长时间占住卡
+ */
+static esp_err_t writer_put(sd_manager_writer_t *w, const void *data, size_t len)
+{
+    esp_err_t ret = sd_manager_file_write(w->file, w->offset, data, len, w->cls);
+    if (ret == ESP_OK)
+    {
+        w->offset += len;
+    }
+    w->err = ret;
+    return ret;
+}
+
+esp_err_t sd_manager_writer_append(sd_manager_writer_t *w, const void *data, size_t len)
+{
+    if (w == NULL || (data == NULL && len > 0))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (w->err != ESP_OK)
+    {
+        return w->err;
+    }
+
+    const uint8_t *p = (const uint8_t *)data;
+    esp_err_t ret;
+
+    // 先补满缓冲中未满的一块
+    if (w->used > 0)
+    {
+        size_t n = SD_MANAGER_WRITER_BUF - w->used;
+        n = (n < len) ? n : len;
+        memcpy(w->buf + w->used, p, n);
+        w->used += n;
+        p += n;
+        len -= n;
+        if (w->used < SD_MANAGER_WRITER_BUF)
+        {
+            return ESP_OK;
+        }
+        ret = writer_put(w, w->buf, SD_MANAGER_WRITER_BUF);
+        w->used = 0;
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+    }
+
+    // 文件偏移已按整块对齐, 整块部分直接从调用者的缓冲写入
+    size_t direct = len - len % SD_MANAGER_WRITER_BUF;
+    if (direct > 0)
+    {
+        ret = writer_put(w, p, direct);
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+        p += direct;
+        len -= direct;
+    }
+
+    memcpy(w->buf, p, len);
+    w->used = len;
+    return ESP_OK;
+}
+
+esp_err_t sd_manager_writer_close(sd_manager_writer_t *w)
+{
+    if (w == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = w->err;
+    if (ret == ESP_OK && w->used > 0)
+    {
+        ret = writer_put(w, w->buf, w->used);
+    }
+    esp_err_t close_ret = sd_manager_file_close(w->file); // 使所在目录的列表缓存失效
+    ret = (ret == ESP_OK) ? close_ret : ret;
+
+    free(w->buf);
+    free(w);
+    return ret;
+}
+
+void *sd_manager_alloc_io_buffer(size_t size)
+{
+    return heap_caps_aligned_alloc(SD_MANAGER_IO_ALIGN, size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+}
+
+void sd_manager_get_stats(sd_manager_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return;
+    }
+    portENTER_CRITICAL(&s_stats_lock);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+void sd_manager_reset_stats(void)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    memset(s_stats.op, 0, sizeof(s_stats.op));
+    for (int c = 0; c < SD_MANAGER_CLASS_MAX; c++)
+    {
+        uint32_t pending = s_stats.cls[c].pending;
+        memset(&s_stats.cls[c], 0, sizeof(sd_manager_class_stats_t));
+        s_stats.cls[c].pending = pending;
+    }
+    s_stats.dir_cache_hits = 0;
+    s_stats.dir_cache_misses = 0;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+esp_err_t sd_manager_io_init(uint8_t pdrv, const char *mount_point)
+{
+    if (s_ready)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (mount_point == NULL || strlen(mount_point) >= sizeof(s_mount))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_free = NULL;
+    for (int i = SD_MANAGER_IO_MAX_REQUESTS - 1; i >= 0; i--)
+    {
+        s_slots[i].next = s_free;
+        s_free = &s_slots[i];
+    }
+    s_free_count = SD_MANAGER_IO_MAX_REQUESTS;
+    memset(s_queue, 0, sizeof(s_queue));
+    s_last_file = NULL;
+    s_stopping = false;
+
+    strcpy(s_mount, mount_point);
+    s_mount_len = strlen(s_mount);
+    s_pdrv = pdrv;
+
+    s_sched_lock = xSemaphoreCreateMutex();
+    s_stopped = xSemaphoreCreateBinary();
+    if (s_sched_lock == NULL || s_stopped == NULL || sd_manager_dir_init() != ESP_OK ||
+        xTaskCreate(io_task, "sd_io", SD_MANAGER_ASYNC_STACK, NULL, SD_MANAGER_ASYNC_PRIORITY, &s_io_task) != pdPASS)
+    {
+        ESP_LOGE(TAG, "I/O任务创建失败");
+        sd_manager_dir_deinit();
+        if (s_sched_lock != NULL)
+        {
+            vSemaphoreDelete(s_sched_lock);
+            s_sched_lock = NULL;
+        }
+        if (s_stopped != NULL)
+        {
+            vSemaphoreDelete(s_stopped);
+            s_stopped = NULL;
+        }
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_ready = true;
+    ESP_LOGI(TAG, "文件接口已启用: %s -> %u:", s_mount, (unsigned)s_pdrv);
+    return ESP_OK;
+}
+
+void sd_manager_io_deinit(void)
+{
+    if (!s_ready)
+    {
+        return;
+    }
+
+    // 缓存清单要在文件接口禁用前写回
+    sd_manager_cache_deinit();
+
+    // 不再接受新请求, I/O任务处理完已提交的请求后退出
+    s_stopping = true;
+    xTaskNotifyGive(s_io_task);
+    xSemaphoreTake(s_stopped, portMAX_DELAY);
+
+    s_ready = false;
+    sd_manager_dir_deinit();
+    s_io_task = NULL;
+    vSemaphoreDelete(s_sched_lock);
+    s_sched_lock = NULL;
+    vSemaphoreDelete(s_stopped);
+    s_stopped = NULL;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file sd_manager_io.h
+ * @brief 文件读写层 (组件内部接口)
+ * @details 文件接口直接调用FatFs, 需要知道挂载点对应的FatFs驱动器号。
+ *          目标板上由sd_manager_init()在挂载后调用; 主机替身挂载FAT镜像后调用同一接口。
+ *          目录列表(sd_manager_dir.c)共用这里的路径转换和统计。
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "sd_manager.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief 启用文件接口并启动I/O任务
+     * @param pdrv 卷的FatFs驱动器号
+     * @param mount_point VFS挂载点, 例如"/sdcard", 文件接口的路径以它开头
+     * @return esp_err_t ESP_OK成功
+     */
+    esp_err_t sd_manager_io_init(uint8_t pdrv, const char *mount_point);
+
+    /**
+     * @brief 完成已提交的异步请求, 停止I/O任务并禁用文件接口 (卸载卷之前调用)
+     */
+    void sd_manager_io_deinit(void);
+
+    /**
+     * @brief VFS路径换成FatFs路径, 例如"/sdcard/a/b.wav" -> "0:/a/b.wav"
+     * @return esp_err_t ESP_OK成功, ESP_ERR_INVALID_STATE未启用, ESP_ERR_INVALID_ARG不在挂载点下或太长
+     */
+    esp_err_t sd_manager_io_fatfs_path(const char *path, char *out, size_t out_len);
+
+    /**
+     * @brief 记录一次操作的统计
+     */
+    void sd_manager_io_record(sd_manager_op_t op, esp_err_t ret, size_t bytes, uint32_t us);
+
+    /**
+     * @brief 记录一次目录缓存查找
+     */
+    void sd_manager_io_record_dir_cache(bool hit);
+
+    /**
+     * @brief 初始化目录列表缓存 (sd_manager_io_init调用)
+     */
+    esp_err_t sd_manager_dir_init(void);
+
+    /**
+     * @brief 丢弃所有目录缓存 (sd_manager_io_deinit调用), 已打开的列表仍可使用到关闭
+     */
+    void sd_manager_dir_deinit(void);
+
+    /**
+     * @brief path指向的文件或目录被修改: 使它所在目录和它本身的列表缓存失效
+     */
+    void sd_manager_dir_changed(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
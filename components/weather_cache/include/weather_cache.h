@@ -0,0 +1,110 @@
+/**
+ * @file weather_cache.h
+ * @brief 保存在NVS中的天气数据缓存 (TTL + stale-while-revalidate)
+ * @details 每个(接口, 城市)一条记录, 保存最近一次成功响应解析后的数据和响应的ETag/Last-Modified,
+ *          重启后立即可用, 不必等一次HTTPS请求:
+ *          - FRESH: 取得后不超过ttl_s, 直接使用, 不请求
+ *          - STALE: 超过ttl_s但不超过ttl_s + stale_s, 先显示缓存的数据, 同时在后台重新验证
+ *          - EXPIRED: 更旧的数据不再显示, 只能等待请求
+ *          重新验证时带上保存的验证器发条件请求, 服务器返回304时只调用weather_cache_touch更新取得时间。
+ *          取得时间是UNIX时间: 系统时钟尚未同步(SNTP之前)时无法计算年龄, 有记录时一律视为STALE。
+ *          数据按原样保存, 调用者负责在数据结构改变时换一个endpoint字符串或检查长度。
+ */
+
+#ifndef WEATHER_CACHE_H
+#define WEATHER_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <time.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define WEATHER_CACHE_NAMESPACE "weather_cache" // NVS命名空间
+#define WEATHER_CACHE_DATA_MAX (512)            // 单条记录的数据最大长度
+#define WEATHER_CACHE_VALIDATOR_MAX (64)        // ETag/Last-Modified最大长度 (含结尾的'\0')
+#define WEATHER_CACHE_CLOCK_VALID (1704067200)  // 早于2024-01-01的系统时间视为时钟未同步
+
+    /**
+     * @brief 缓存状态
+     */
+    typedef enum
+    {
+        WEATHER_CACHE_MISS = 0, // 没有记录
+        WEATHER_CACHE_FRESH,    // 在TTL内
+        WEATHER_CACHE_STALE,    // 可以显示, 需要重新验证
+        WEATHER_CACHE_EXPIRED,  // 太旧, 不再显示
+    } weather_cache_state_t;
+
+    /**
+     * @brief 记录的元数据
+     */
+    typedef struct
+    {
+        int64_t fetched_at;                              // 取得或304确认时的UNIX时间(秒), 0表示当时时钟未同步
+        char etag[WEATHER_CACHE_VALIDATOR_MAX];          // 空字符串表示服务器没有提供
+        char last_modified[WEATHER_CACHE_VALIDATOR_MAX];
+    } weather_cache_meta_t;
+
+    /**
+     * @brief 读取记录
+     * @param endpoint 接口路径, 例如"/v3/weather/now.json"
+     * @param location 城市
+     * @param meta 输出元数据
+     * @param data 输出数据缓冲区
+     * @param size 缓冲区大小
+     * @param len 输出数据长度, 可为NULL
+     * @return esp_err_t ESP_OK, ESP_ERR_NOT_FOUND没有记录或记录无效, ESP_ERR_INVALID_SIZE缓冲区太小
+     */
+    esp_err_t weather_cache_load(const char *endpoint, const char *location, weather_cache_meta_t *meta, void *data,
+                                 size_t size, size_t *len);
+
+    /**
+     * @brief 保存记录 (覆盖旧记录)
+     * @param meta fetched_at为0时使用当前时间 (时钟未同步时仍为0)
+     */
+    esp_err_t weather_cache_store(const char *endpoint, const char *location, const weather_cache_meta_t *meta,
+                                  const void *data, size_t len);
+
+    /**
+     * @brief 服务器确认内容未变(304): 只把取得时间更新为当前时间
+     * @return esp_err_t ESP_ERR_NOT_FOUND没有记录
+     */
+    esp_err_t weather_cache_touch(const char *endpoint, const char *location);
+
+    /**
+     * @brief 删除记录
+     */
+    esp_err_t weather_cache_remove(const char *endpoint, const char *location);
+
+    /**
+     * @brief 按当前时间判断记录的状态
+     * @param meta 已读取的元数据, NULL表示没有记录
+     * @param ttl_s 新鲜期
+     * @param stale_s 过了新鲜期后仍可显示的时长
+     */
+    weather_cache_state_t weather_cache_state(const weather_cache_meta_t *meta, uint32_t ttl_s, uint32_t stale_s);
+
+    /**
+     * @brief 记录的年龄(秒), 时钟未同步或取得时间未知时返回-1
+     */
+    int64_t weather_cache_age(const weather_cache_meta_t *meta);
+
+    /**
+     * @brief 当前系统时间是否已同步
+     */
+    static inline bool weather_cache_clock_valid(void)
+    {
+        return time(NULL) >= WEATHER_CACHE_CLOCK_VALID;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WEATHER_CACHE_H
@@ -0,0 +1,240 @@
+/**
+ * @file weather_cache.c
+ * @brief 保存在NVS中的天气数据缓存
+ * @details 每条记录是一个NVS blob, 键为"w" + (接口, 城市)的32位FNV-1a散列; 记录头中再保存64位散列,
+ *          32位散列碰撞时读到的不是自己的记录, 按没有记录处理。记录头带魔数和版本, 格式改变后旧记录自动失效。
+ */
+
+#include "weather_cache.h"
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "nvs.h"
+
+static const char *TAG = "weather_cache";
+
+#define WEATHER_CACHE_MAGIC (0x31484357) // "WCH1"
+#define WEATHER_CACHE_VERSION (1)
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t data_len;
+    uint64_t key_hash;
+    weather_cache_meta_t meta;
+} weather_cache_header_t;
+
+typedef struct
+{
+    weather_cache_header_t header;
+    uint8_t data[WEATHER_CACHE_DATA_MAX];
+} weather_cache_record_t;
+
+static uint64_t weather_cache_hash(const char *endpoint, const char *location)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const char *p = endpoint; *p != '\0'; p++)
+    {
+        h = (h ^ (uint8_t)*p) * 0x100000001b3ULL;
+    }
+    h = (h ^ '\n') * 0x100000001b3ULL; // 分隔符, 避免("ab", "c")与("a", "bc")相同
+    for (const char *p = location; *p != '\0'; p++)
+    {
+        h = (h ^ (uint8_t)*p) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static void weather_cache_nvs_key(uint64_t hash, char key[NVS_KEY_NAME_MAX_SIZE])
+{
+    snprintf(key, NVS_KEY_NAME_MAX_SIZE, "w%08lx", (unsigned long)((hash >> 32) ^ (hash & 0xffffffffULL)));
+}
+
+/**
+ * @brief 读取并校验记录
+ */
+static esp_err_t weather_cache_read(const char *endpoint, const char *location, weather_cache_record_t *rec)
+{
+    uint64_t hash = weather_cache_hash(endpoint, location);
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    weather_cache_nvs_key(hash, key);
+
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(WEATHER_CACHE_NAMESPACE, NVS_READONLY, &nvs);
+    if (err != ESP_OK)
+    {
+        // 命名空间还不存在时返回ESP_ERR_NVS_NOT_FOUND
+        return ESP_ERR_NOT_FOUND;
+    }
+    size_t len = sizeof(weather_cache_record_t);
+    err = nvs_get_blob(nvs, key, rec, &len);
+    nvs_close(nvs);
+    if (err != ESP_OK)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    const weather_cache_header_t *h = &rec->header;
+    if (len < sizeof(weather_cache_header_t) || h->magic != WEATHER_CACHE_MAGIC ||
+        h->version != WEATHER_CACHE_VERSION || h->key_hash != hash || h->data_len > WEATHER_CACHE_DATA_MAX ||
+        len != sizeof(weather_cache_header_t) + h->data_len)
+    {
+        ESP_LOGD(TAG, "记录 %s 无效, 忽略", key);
+        return ESP_ERR_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t weather_cache_write(const char *endpoint, const char *location, const weather_cache_record_t *rec)
+{
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    weather_cache_nvs_key(rec->header.key_hash, key);
+
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(WEATHER_CACHE_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    err = nvs_set_blob(nvs, key, rec, sizeof(weather_cache_header_t) + rec->header.data_len);
+    if (err == ESP_OK)
+    {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "保存 %s %s 失败: %s", endpoint, location, esp_err_to_name(err));
+    }
+    return err;
+}
+
+static int64_t weather_cache_now(void)
+{
+    return weather_cache_clock_valid() ? (int64_t)time(NULL) : 0;
+}
+
+esp_err_t weather_cache_load(const char *endpoint, const char *location, weather_cache_meta_t *meta, void *data,
+                             size_t size, size_t *len)
+{
+    if (endpoint == NULL || location == NULL || meta == NULL || (data == NULL && size > 0))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    weather_cache_record_t rec;
+    esp_err_t err = weather_cache_read(endpoint, location, &rec);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    if (rec.header.data_len > size)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *meta = rec.header.meta;
+    memcpy(data, rec.data, rec.header.data_len);
+    if (len != NULL)
+    {
+        *len = rec.header.data_len;
+    }
+    return ESP_OK;
+}
+
+esp_err_t weather_cache_store(const char *endpoint, const char *location, const weather_cache_meta_t *meta,
+                              const void *data, size_t len)
+{
+    if (endpoint == NULL || location == NULL || meta == NULL || (data == NULL && len > 0))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len > WEATHER_CACHE_DATA_MAX)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    weather_cache_record_t rec = {
+        .header = {
+            .magic = WEATHER_CACHE_MAGIC,
+            .version = WEATHER_CACHE_VERSION,
+            .data_len = (uint16_t)len,
+            .key_hash = weather_cache_hash(endpoint, location),
+            .meta = *meta,
+        },
+    };
+    if (rec.header.meta.fetched_at == 0)
+    {
+        rec.header.meta.fetched_at = weather_cache_now();
+    }
+    // 保证验证器以'\0'结尾, 读取时可直接作为字符串使用
+    rec.header.meta.etag[WEATHER_CACHE_VALIDATOR_MAX - 1] = '\0';
+    rec.header.meta.last_modified[WEATHER_CACHE_VALIDATOR_MAX - 1] = '\0';
+    memcpy(rec.data, data, len);
+    return weather_cache_write(endpoint, location, &rec);
+}
+
+esp_err_t weather_cache_touch(const char *endpoint, const char *location)
+{
+    if (endpoint == NULL || location == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    weather_cache_record_t rec;
+    esp_err_t err = weather_cache_read(endpoint, location, &rec);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    rec.header.meta.fetched_at = weather_cache_now();
+    return weather_cache_write(endpoint, location, &rec);
+}
+
+esp_err_t weather_cache_remove(const char *endpoint, const char *location)
+{
+    if (endpoint == NULL || location == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    weather_cache_nvs_key(weather_cache_hash(endpoint, location), key);
+
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(WEATHER_CACHE_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    err = nvs_erase_key(nvs, key);
+    if (err == ESP_OK)
+    {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    return (err == ESP_ERR_NVS_NOT_FOUND) ? ESP_OK : err;
+}
+
+int64_t weather_cache_age(const weather_cache_meta_t *meta)
+{
+    if (meta == NULL || meta->fetched_at == 0 || !weather_cache_clock_valid())
+    {
+        return -1;
+    }
+    int64_t age = (int64_t)time(NULL) - meta->fetched_at;
+    return (age < 0) ? 0 : age; // 时钟被往回调过
+}
+
+weather_cache_state_t weather_cache_state(const weather_cache_meta_t *meta, uint32_t ttl_s, uint32_t stale_s)
+{
+    if (meta == NULL)
+    {
+        return WEATHER_CACHE_MISS;
+    }
+    int64_t age = weather_cache_age(meta);
+    if (age < 0)
+    {
+        return WEATHER_CACHE_STALE;
+    }
+    if (age <= (int64_t)ttl_s)
+    {
+        return WEATHER_CACHE_FRESH;
+    }
+    return (age <= (int64_t)ttl_s + stale_s) ? WEATHER_CACHE_STALE : WEATHER_CACHE_EXPIRED;
+}
@@ -0,0 +1,150 @@
+/**
+ * @file weather_client.h
+ * @brief 保持连接的HTTPS天气客户端
+ * @details 整个程序共用一个esp_http_client句柄, 不再每次请求都新建客户端、完整握手、再断开:
+ *          - 两次请求之间保持TCP/TLS连接, 同一主机的下一次请求直接发送
+ *          - 连接被服务器关闭(空闲超时等)后重连时带上保存的TLS会话票据(RFC 5077), 服务器接受时只需简化握手
+ *          - 闲置超过WEATHER_CLIENT_IDLE_MAX_MS的连接在请求前主动关闭, 不在已失效的连接上白等一次写失败
+ *          - 分别统计新建连接的握手耗时(TCP连接 + TLS握手)和请求耗时(发送请求到收完响应)
+ *          会话票据需要CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS; 服务器是否真的恢复了会话以服务器为准,
+ *          客户端只记录重连时是否带了会话。本地替身服务器见tools/weather_server.py。
+ */
+
+#ifndef WEATHER_CLIENT_H
+#define WEATHER_CLIENT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define WEATHER_CLIENT_TIMEOUT_MS (10000)  // 单次请求超时 (含连接和握手)
+#define WEATHER_CLIENT_IDLE_MAX_MS (50000) // 连接闲置超过该时间后重连, 略短于常见服务器的60秒空闲超时
+#define WEATHER_CLIENT_BUFFER_SIZE (1024)  // esp_http_client的接收缓冲区
+#define WEATHER_CLIENT_VALIDATOR_MAX (64)  // 保存的ETag/Last-Modified最大长度 (含结尾的'\0')
+
+    /**
+     * @brief 客户端配置, 0/NULL表示默认值
+     */
+    typedef struct
+    {
+        const char *cert_pem;             // 服务器根证书(PEM), NULL时使用内置证书包; 本地替身服务器用它打印的自签名证书
+        bool skip_common_name_check;      // 不检查证书中的主机名, 仅用于按IP访问本地替身服务器
+        int timeout_ms;                   // 默认WEATHER_CLIENT_TIMEOUT_MS
+        uint32_t idle_max_ms;             // 默认WEATHER_CLIENT_IDLE_MAX_MS
+    } weather_client_config_t;
+
+    /**
+     * @brief 单次请求的结果
+     */
+    typedef struct
+    {
+        int status;              // HTTP状态码
+        size_t len;              // 写入缓冲区的字节数 (不含结尾的'\0')
+        bool truncated;          // 响应比缓冲区长, 多出的部分已丢弃
+        bool new_connection;     // 本次请求新建了连接
+        bool session_offered;    // 新建连接时带了保存的TLS会话
+        bool retried;            // 保持的连接已被关闭, 重连后重发了请求
+        uint32_t handshake_us;   // 新建连接的TCP连接和TLS握手耗时, 复用连接时为0
+        uint32_t request_us;     // 从发送请求到收完响应的耗时
+        char etag[WEATHER_CLIENT_VALIDATOR_MAX];          // 响应的ETag, 没有时为空字符串
+        char last_modified[WEATHER_CLIENT_VALIDATOR_MAX]; // 响应的Last-Modified, 没有时为空字符串
+    } weather_client_result_t;
+
+    /**
+     * @brief 条件请求的验证器, 来自上一次响应的ETag/Last-Modified; NULL或空字符串不发送
+     * @details 服务器认为内容未变时返回304且没有响应体, 调用者继续使用缓存的数据
+     */
+    typedef struct
+    {
+        const char *if_none_match;
+        const char *if_modified_since;
+    } weather_client_validators_t;
+
+    /**
+     * @brief 累计统计
+     */
+    typedef struct
+    {
+        uint32_t requests;
+        uint32_t errors;             // 传输失败 (不含HTTP错误状态码)
+        uint32_t reused;             // 在保持的连接上完成的请求
+        uint32_t retries;            // 保持的连接已被关闭, 重连后重发
+        uint32_t idle_closes;        // 闲置超时主动关闭的连接
+        uint32_t full_handshakes;    // 没有保存会话的新建连接
+        uint32_t resumed_handshakes; // 带保存会话的新建连接
+        uint64_t full_handshake_us;  // 累计耗时, 除以次数得到平均值
+        uint64_t resumed_handshake_us;
+        uint32_t handshake_max_us;
+        uint64_t request_us;
+        uint32_t request_max_us;
+    } weather_client_stats_t;
+
+    /**
+     * @brief 设置配置, 在第一次请求之前调用; 不调用时使用默认值 (内置证书包)
+     * @details 已有连接时会关闭连接并丢弃保存的会话
+     */
+    esp_err_t weather_client_init(const weather_client_config_t *config);
+
+    /**
+     * @brief 发送GET请求并把响应体读入缓冲区 (以'\0'结尾)
+     * @param url 完整URL; 与上一次请求主机相同时复用连接
+     * @param buf 响应缓冲区
+     * @param buf_size 缓冲区大小, 最多写入buf_size - 1字节
+     * @param result 单次结果, 可为NULL
+     * @return esp_err_t ESP_OK收到响应(状态码见result), 其他值为连接或传输失败
+     */
+    esp_err_t weather_client_get(const char *url, char *buf, size_t buf_size, weather_client_result_t *result);
+
+    /**
+     * @brief 响应体数据回调, 在HTTP_EVENT_ON_DATA中按到达的块调用 (块的大小和边界不固定)
+     */
+    typedef void (*weather_client_data_cb_t)(const char *data, size_t len, void *arg);
+
+    /**
+     * @brief 发送GET请求, 响应体不经缓冲直接分块交给on_data, 长度没有限制
+     * @details 复用的连接失效时, 只有尚未收到任何数据才会重发, 所以on_data不会看到重复的数据;
+     *          result->len为交给on_data的总字节数, result->truncated总是false
+     */
+    esp_err_t weather_client_get_stream(const char *url, weather_client_data_cb_t on_data, void *arg,
+                                        weather_client_result_t *result);
+
+    /**
+     * @brief 与weather_client_get_stream相同, 但带If-None-Match/If-Modified-Since请求头
+     * @param validators 可为NULL (等同于weather_client_get_stream)
+     * @return esp_err_t 同weather_client_get_stream; 内容未变时result->status为304, on_data不会被调用
+     */
+    esp_err_t weather_client_get_conditional(const char *url, const weather_client_validators_t *validators,
+                                             weather_client_data_cb_t on_data, void *arg,
+                                             weather_client_result_t *result);
+
+    /**
+     * @brief 关闭连接但保留会话, 下一次请求重连时恢复会话 (例如WiFi断开时)
+     */
+    void weather_client_close(void);
+
+    /**
+     * @brief 关闭连接, 释放客户端和保存的会话
+     */
+    void weather_client_deinit(void);
+
+    /**
+     * @brief 获取统计
+     */
+    void weather_client_get_stats(weather_client_stats_t *stats);
+
+    /**
+     * @brief 清零统计
+     */
+    void weather_client_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WEATHER_CLIENT_H
@@ -0,0 +1,427 @@
+/**
+ * @file weather_client.c
+ * @brief 保持连接的HTTPS天气客户端
+ * @details esp_http_client在同一个句柄上连续请求同一主机时复用连接; 句柄启用save_client_session后,
+ *          传输层在连接关闭时保存TLS会话, 同一句柄重连时带上会话。所以整个程序只保留一个句柄。
+ *          事件在esp_http_client_perform的调用者中同步分发, 通过user_data传入本次请求的上下文:
+ *          HTTP_EVENT_ON_CONNECTED说明本次新建了连接(此时TLS握手已完成), 据此区分握手和请求的耗时。
+ */
+
+#include "weather_client.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_http_client.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#ifdef CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
+#include "esp_crt_bundle.h"
+#endif
+
+static const char *TAG = "weather_client";
+
+// 一次请求的上下文
+typedef struct
+{
+    weather_client_data_cb_t on_data;
+    void *arg;
+    size_t len;           // 已交给on_data的字节数
+    int64_t connected_us; // 收到HTTP_EVENT_ON_CONNECTED的时间, 0表示复用了连接
+    weather_client_result_t *res; // 响应头中的ETag/Last-Modified写到这里
+} weather_request_t;
+
+// weather_client_get的缓冲区
+typedef struct
+{
+    char *buf;
+    size_t buf_size;
+    size_t len;
+    bool truncated;
+} weather_buffer_t;
+
+static SemaphoreHandle_t s_lock = NULL;
+static esp_http_client_handle_t s_client = NULL;
+static weather_client_config_t s_config;
+static bool s_connected = false;    // 句柄上有打开的连接
+static bool s_have_session = false; // 句柄上已有过成功的TLS连接, 重连时会带上保存的会话
+static int64_t s_last_done_us = 0;  // 上一次请求结束的时间, 用于闲置超时
+static weather_client_stats_t s_stats;
+
+static esp_err_t weather_event_handler(esp_http_client_event_t *evt)
+{
+    weather_request_t *req = evt->user_data;
+    switch (evt->event_id)
+    {
+    case HTTP_EVENT_ON_CONNECTED:
+        s_connected = true;
+        if (req != NULL)
+        {
+            req->connected_us = esp_timer_get_time();
+        }
+        break;
+    case HTTP_EVENT_ON_HEADER:
+        if (req != NULL && evt->header_key != NULL && evt->header_value != NULL)
+        {
+            if (strcasecmp(evt->header_key, "ETag") == 0)
+            {
+                snprintf(req->res->etag, sizeof(req->res->etag), "%s", evt->header_value);
+            }
+            else if (strcasecmp(evt->header_key, "Last-Modified") == 0)
+            {
+                snprintf(req->res->last_modified, sizeof(req->res->last_modified), "%s", evt->header_value);
+            }
+        }
+        break;
+    case HTTP_EVENT_ON_DATA:
+        if (req != NULL && evt->data_len > 0)
+        {
+            req->on_data(evt->data, evt->data_len, req->arg);
+            req->len += evt->data_len;
+        }
+        break;
+    case HTTP_EVENT_DISCONNECTED:
+        s_connected = false;
+        break;
+    default:
+        break;
+    }
+    return ESP_OK;
+}
+
+static void weather_buffer_append(const char *data, size_t len, void *arg)
+{
+    weather_buffer_t *b = arg;
+    size_t room = b->buf_size - 1 - b->len;
+    size_t n = (len < room) ? len : room;
+    memcpy(b->buf + b->len, data, n);
+    b->len += n;
+    b->buf[b->len] = '\0';
+    b->truncated = b->truncated || n < len;
+}
+
+static void weather_lock_init(void)
+{
+    // 第一次调用可能来自任意任务, 创建锁本身不加锁: 各任务在联网后才会请求天气, 不会同时到达这里
+    if (s_lock == NULL)
+    {
+        s_lock = xSemaphoreCreateMutex();
+    }
+}
+
+/**
+ * @brief 释放句柄和保存的会话, 调用时持有s_lock
+ */
+static void weather_client_destroy(void)
+{
+    if (s_client != NULL)
+    {
+        esp_http_client_set_user_data(s_client, NULL);
+        esp_http_client_cleanup(s_client);
+        s_client = NULL;
+    }
+    s_connected = false;
+    s_have_session = false;
+}
+
+static esp_http_client_handle_t weather_client_create(const char *url)
+{
+    esp_http_client_config_t config = {
+        .url = url,
+        .method = HTTP_METHOD_GET,
+        .event_handler = weather_event_handler,
+        .disable_auto_redirect = true,
+        .timeout_ms = s_config.timeout_ms ? s_config.timeout_ms : WEATHER_CLIENT_TIMEOUT_MS,
+        .buffer_size = WEATHER_CLIENT_BUFFER_SIZE,
+        .keep_alive_enable = true, // TCP保活, 尽早发现被中间设备丢弃的连接
+        .cert_pem = s_config.cert_pem,
+        .skip_cert_common_name_check = s_config.skip_common_name_check,
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        .save_client_session = true,
+#endif
+    };
+#ifdef CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
+    if (s_config.cert_pem == NULL)
+    {
+        config.crt_bundle_attach = esp_crt_bundle_attach;
+    }
+#endif
+    return esp_http_client_init(&config);
+}
+
+/**
+ * @brief 执行一次请求, 调用时持有s_lock
+ */
+static esp_err_t weather_perform(weather_request_t *req, int64_t *start_us)
+{
+    req->len = 0;
+    req->connected_us = 0;
+    req->res->etag[0] = '\0';
+    req->res->last_modified[0] = '\0';
+    *start_us = esp_timer_get_time();
+    esp_http_client_set_user_data(s_client, req);
+    esp_err_t err = esp_http_client_perform(s_client);
+    esp_http_client_set_user_data(s_client, NULL);
+    return err;
+}
+
+esp_err_t weather_client_init(const weather_client_config_t *config)
+{
+    weather_lock_init();
+    if (s_lock == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    weather_client_destroy();
+    if (config != NULL)
+    {
+        s_config = *config;
+    }
+    else
+    {
+        memset(&s_config, 0, sizeof(s_config));
+    }
+    xSemaphoreGive(s_lock);
+    return ESP_OK;
+}
+
+/**
+ * @brief 设置或删除条件请求头, 调用时持有s_lock; 请求头保存在句柄上, 请求后必须删除
+ */
+static void weather_set_validators(const weather_client_validators_t *validators, bool set)
+{
+    if (validators == NULL)
+    {
+        return;
+    }
+    if (validators->if_none_match != NULL && validators->if_none_match[0] != '\0')
+    {
+        if (set)
+        {
+            esp_http_client_set_header(s_client, "If-None-Match", validators->if_none_match);
+        }
+        else
+        {
+            esp_http_client_delete_header(s_client, "If-None-Match");
+        }
+    }
+    if (validators->if_modified_since != NULL && validators->if_modified_since[0] != '\0')
+    {
+        if (set)
+        {
+            esp_http_client_set_header(s_client, "If-Modified-Since", validators->if_modified_since);
+        }
+        else
+        {
+            esp_http_client_delete_header(s_client, "If-Modified-Since");
+        }
+    }
+}
+
+esp_err_t weather_client_get_stream(const char *url, weather_client_data_cb_t on_data, void *arg,
+                                    weather_client_result_t *result)
+{
+    return weather_client_get_conditional(url, NULL, on_data, arg, result);
+}
+
+esp_err_t weather_client_get_conditional(const char *url, const weather_client_validators_t *validators,
+                                         weather_client_data_cb_t on_data, void *arg,
+                                         weather_client_result_t *result)
+{
+    if (url == NULL || on_data == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    weather_lock_init();
+    if (s_lock == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    weather_client_result_t res = {0};
+    esp_err_t err = ESP_OK;
+    if (s_client == NULL)
+    {
+        s_client = weather_client_create(url);
+        err = (s_client != NULL) ? ESP_OK : ESP_ERR_NO_MEM;
+    }
+    else
+    {
+        // 闲置太久的连接服务器多半已经关闭, 主动关闭后重连(带会话)比先在旧连接上失败一次快
+        uint32_t idle_max_ms = s_config.idle_max_ms ? s_config.idle_max_ms : WEATHER_CLIENT_IDLE_MAX_MS;
+        if (s_connected && esp_timer_get_time() - s_last_done_us > (int64_t)idle_max_ms * 1000)
+        {
+            esp_http_client_close(s_client);
+            s_connected = false;
+            s_stats.idle_closes++;
+        }
+        // 主机不同时esp_http_client会关闭旧连接
+        err = esp_http_client_set_url(s_client, url);
+    }
+
+    weather_request_t req = {.on_data = on_data, .arg = arg, .res = &res};
+    int64_t start = 0;
+    bool session = s_have_session;
+    if (err == ESP_OK)
+    {
+        weather_set_validators(validators, true);
+        bool reusing = s_connected;
+        err = weather_perform(&req, &start);
+        if (err != ESP_OK && reusing && req.connected_us == 0 && req.len == 0)
+        {
+            // 保持的连接已被服务器关闭: 重连后重发一次
+            ESP_LOGD(TAG, "保持的连接已失效, 重连: %s", esp_err_to_name(err));
+            esp_http_client_close(s_client);
+            s_connected = false;
+            res.retried = true;
+            s_stats.retries++;
+            err = weather_perform(&req, &start);
+        }
+        weather_set_validators(validators, false);
+    }
+
+    int64_t done = esp_timer_get_time();
+    s_last_done_us = done;
+    s_stats.requests++;
+    res.new_connection = (req.connected_us != 0);
+    if (res.new_connection)
+    {
+        res.session_offered = session;
+        res.handshake_us = (uint32_t)(req.connected_us - start);
+        if (session)
+        {
+            s_stats.resumed_handshakes++;
+            s_stats.resumed_handshake_us += res.handshake_us;
+        }
+        else
+        {
+            s_stats.full_handshakes++;
+            s_stats.full_handshake_us += res.handshake_us;
+        }
+        if (res.handshake_us > s_stats.handshake_max_us)
+        {
+            s_stats.handshake_max_us = res.handshake_us;
+        }
+    }
+
+    if (err == ESP_OK)
+    {
+        res.status = esp_http_client_get_status_code(s_client);
+        res.len = req.len;
+        res.request_us = (uint32_t)(done - (res.new_connection ? req.connected_us : start));
+        s_stats.request_us += res.request_us;
+        if (res.request_us > s_stats.request_max_us)
+        {
+            s_stats.request_max_us = res.request_us;
+        }
+        if (!res.new_connection)
+        {
+            s_stats.reused++;
+        }
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        s_have_session = true;
+#endif
+    }
+    else
+    {
+        s_stats.errors++;
+        if (s_client != NULL)
+        {
+            esp_http_client_close(s_client);
+            s_connected = false;
+        }
+    }
+    xSemaphoreGive(s_lock);
+
+    if (err == ESP_OK)
+    {
+        ESP_LOGD(TAG, "HTTP %d, %u 字节, %s连接, 握手 %lu us, 请求 %lu us", res.status, (unsigned)res.len,
+                 res.new_connection ? (res.session_offered ? "恢复会话的新" : "新") : "复用",
+                 (unsigned long)res.handshake_us, (unsigned long)res.request_us);
+    }
+    else
+    {
+        ESP_LOGW(TAG, "请求失败: %s", esp_err_to_name(err));
+    }
+    if (result != NULL)
+    {
+        *result = res;
+    }
+    return err;
+}
+
+esp_err_t weather_client_get(const char *url, char *buf, size_t buf_size, weather_client_result_t *result)
+{
+    if (buf == NULL || buf_size == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    weather_buffer_t b = {.buf = buf, .buf_size = buf_size};
+    buf[0] = '\0';
+    weather_client_result_t res = {0};
+    esp_err_t err = weather_client_get_stream(url, weather_buffer_append, &b, &res);
+    res.len = b.len;
+    res.truncated = b.truncated;
+    if (result != NULL)
+    {
+        *result = res;
+    }
+    return err;
+}
+
+void weather_client_close(void)
+{
+    if (s_lock == NULL)
+    {
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (s_client != NULL && s_connected)
+    {
+        esp_http_client_close(s_client);
+        s_connected = false;
+    }
+    xSemaphoreGive(s_lock);
+}
+
+void weather_client_deinit(void)
+{
+    if (s_lock == NULL)
+    {
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    weather_client_destroy();
+    xSemaphoreGive(s_lock);
+}
+
+void weather_client_get_stats(weather_client_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return;
+    }
+    if (s_lock == NULL)
+    {
+        memset(stats, 0, sizeof(weather_client_stats_t));
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *stats = s_stats;
+    xSemaphoreGive(s_lock);
+}
+
+void weather_client_reset_stats(void)
+{
+    if (s_lock == NULL)
+    {
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    memset(&s_stats, 0, sizeof(s_stats));
+    xSemaphoreGive(s_lock);
+}
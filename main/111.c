@@ -7,38 +7,97 @@
 #include "esp_timer.h"
 #include "esp_freertos_hooks.h"
 #include "time_weather.h"
+#include "hptts.h"
 #include "lvgl_task.h"
 #include "hardware_init.h"
+#include "boot_manager.h"
 
 TaskHandle_t lvgl_task_handle = NULL;
 TaskHandle_t lvgl_time_handle = NULL;
 
+#define MAIN_BOOT_FOREGROUND_TIMEOUT_MS (20 * 1000) // 等待前台阶段(界面、音频等)的最长时间
+#define MAIN_BOOT_BACKGROUND_TIMEOUT_MS (60 * 1000) // 再等待后台阶段(联网等)的最长时间, 只影响时间线的打印
+
 /**
- * @brief 应用程序主入口函数
- * @details 初始化LVGL系统，创建主页界面，运行主循环
+ * @brief 启动阶段ui
  */
-void app_main(void)
+static esp_err_t main_stage_ui(void *arg)
+{
+    return lvgl_task_start();
+}
+
+/**
+ * @brief 启动阶段weather_cache: 不等网络, 先显示NVS中缓存的天气
+ */
+static esp_err_t main_stage_weather_cache(void *arg)
 {
-    // 1. 硬件初始化 (NVS + WiFi连接)
-    // 此函数会阻塞直到WiFi连接成功
-    if (hardware_init() == ESP_OK)
+    hptts_weather_show_cached();
+    return ESP_OK;
+}
+
+/**
+ * @brief 启动阶段weather: 创建天气后台刷新任务
+ */
+static esp_err_t main_stage_weather(void *arg)
+{
+    // 低优先级, 不与界面和时间任务争抢
+    if (xTaskCreatePinnedToCore(hptts_weather_task, "weather", 1024 * 8, NULL, 2, NULL, 0) != pdPASS)
     {
-        ESP_LOGI("MAIN", "Hardware init success, starting tasks...");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
 
-        // 先创建lvgl任务，确保LVGL端口初始化完成
-        xTaskCreatePinnedToCore(lvgl_task, "lvgl_task", 1024 * 10, NULL, 5, &lvgl_task_handle, 1);
+/**
+ * @brief 登记应用层的启动阶段, 硬件阶段见hardware_boot_register
+ * @details 界面只依赖I2C总线(触摸), 不等SD卡、音频和WiFi; 联网相关的阶段都在后台
+ */
+static esp_err_t main_boot_register(void)
+{
+    const boot_stage_t stages[] = {
+        {.name = "ui", .fn = main_stage_ui, .deps = {"i2c"}},
+        {.name = "clock", .fn = time_clock_stage},
+        {.name = "player", .fn = time_player_stage, .deps = {"audio", "sd"}, .flags = BOOT_STAGE_OPTIONAL},
+        {.name = "weather_cache", .fn = main_stage_weather_cache, .deps = {"nvs", "ui"}},
+        {.name = "sntp", .fn = time_sntp_stage, .deps = {"wifi"}, .flags = BOOT_STAGE_BACKGROUND},
+        {.name = "weather", .fn = main_stage_weather, .deps = {"weather_cache", "net"},
+         .flags = BOOT_STAGE_BACKGROUND},
+    };
+    esp_err_t ret = hardware_boot_register();
+    for (size_t i = 0; ret == ESP_OK && i < sizeof(stages) / sizeof(stages[0]); i++)
+    {
+        ret = boot_manager_add(&stages[i]);
+    }
+    return ret;
+}
 
-        // 延迟一段时间，确保LVGL初始化完成
-        vTaskDelay(pdMS_TO_TICKS(1000));
+/**
+ * @brief 应用程序主入口函数
+ * @details 登记启动阶段并按依赖关系并行执行, 打印前台和全部阶段的启动时间线
+ */
+void app_main(void)
+{
+    esp_err_t ret = main_boot_register();
+    if (ret == ESP_OK)
+    {
+        ret = boot_manager_start();
+    }
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE("MAIN", "Boot setup failed: %s, halting system", esp_err_to_name(ret));
+        return;
+    }
 
-        // 创建时间和天气更新任务
-        // 增加栈大小到10KB，避免SNTP和LVGL操作导致的栈溢出
-        xTaskCreatePinnedToCore(time_and_weather, "time", 1024 * 10, NULL, 6, &lvgl_time_handle, 0);
+    if (boot_manager_wait_all(false, pdMS_TO_TICKS(MAIN_BOOT_FOREGROUND_TIMEOUT_MS)) != ESP_OK)
+    {
+        ESP_LOGW("MAIN", "Foreground boot stages still running");
     }
-    else
+    boot_manager_print_timeline(stdout);
+
+    // 没有网络时sntp一直等待, 超时后也打印, 可以看到还在运行的阶段
+    if (boot_manager_wait_all(true, pdMS_TO_TICKS(MAIN_BOOT_BACKGROUND_TIMEOUT_MS)) != ESP_OK)
     {
-        ESP_LOGE("MAIN", "Hardware init failed, halting system");
-        // 初始化失败，停止运行或重启
-        // esp_restart();
+        ESP_LOGW("MAIN", "Background boot stages still running");
     }
+    boot_manager_print_timeline(stdout);
 }
@@ -9,23 +9,103 @@
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/ringbuf.h"
 #include "esp_heap_caps.h"
+#include "esp_timer.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <sd_manager.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <strings.h>
+#include "esp_spiffs.h"
+#include "audio_mixer.h"
+#include "audio_dsp.h"
+#include "audio_dsp_adpcm.h"
+#include "audio_dsp_decim.h"
+#include "audio_dsp_vad.h"
+#include "audio_peaks.h"
+#include "asset_pack.h"
 
 static const char *TAG = "audio_app";
 
-// 录音任务句柄
-static TaskHandle_t s_record_task_handle = NULL;
+#define AUDIO_SPIFFS_BASE_PATH "/spiffs"
+#define AUDIO_SPIFFS_PARTITION "audio"
+
+// 采集任务和写入任务句柄
+static TaskHandle_t s_capture_task_handle = NULL;
+static TaskHandle_t s_writer_task_handle = NULL;
 // 录音状态标志
 static volatile bool s_is_recording = false;
+// 采集任务已退出, 写入任务取完缓冲区后即可收尾
+static volatile bool s_capture_done = false;
+// 采集和写入之间的环形缓冲区 (PSRAM)
+static RingbufHandle_t s_record_ring = NULL;
+// 录音统计
+static audio_app_record_stats_t s_record_stats;
 // 录音文件名
 static char s_record_filename[128] = {0};
 
+// 录音格式描述
+typedef struct
+{
+    uint16_t channels;
+    uint32_t sample_rate;
+    bool adpcm;
+} record_format_desc_t;
+
+static const record_format_desc_t s_format_desc[AUDIO_RECORD_FORMAT_MAX] = {
+    [AUDIO_RECORD_FORMAT_PCM_48K_STEREO] = {2, 48000, false},
+    [AUDIO_RECORD_FORMAT_PCM_48K_MONO] = {1, 48000, false},
+    [AUDIO_RECORD_FORMAT_PCM_16K_MONO] = {1, 16000, false},
+    [AUDIO_RECORD_FORMAT_ADPCM_48K_MONO] = {1, 48000, true},
+    [AUDIO_RECORD_FORMAT_ADPCM_16K_MONO] = {1, 16000, true},
+};
+
+#define RECORD_ADPCM_SPB AUDIO_DSP_ADPCM_SAMPLES_PER_BLOCK(AUDIO_DSP_ADPCM_BLOCK_BYTES)
+
+static audio_app_record_format_t s_record_format = AUDIO_RECORD_FORMAT_PCM_48K_STEREO;
+static size_t s_header_len = 0;         // 当前格式的WAV头长度
+static volatile uint32_t s_record_samples = 0; // 已编码的采样帧数 (ADPCM的fact块)
+// 格式转换状态 (仅采集任务访问)
+static audio_dsp_decim_t s_decim;
+static audio_dsp_adpcm_state_t s_adpcm;
+static int16_t s_adpcm_pcm[RECORD_ADPCM_SPB];
+static size_t s_adpcm_fill = 0;
+
+// 静音跳过 (VAD状态和缓存仅采集任务访问, 标记表在采集结束后由写入任务读取)
+typedef struct
+{
+    uint32_t position; // 在文件采样时间轴上的位置
+    uint32_t length;   // 此处被跳过的采样数
+} record_cue_t;
+
+static bool s_vad_enabled = AUDIO_RECORD_VAD_DEFAULT;
+static bool s_vad_gating = false; // 本次录音是否跳过静音
+static audio_dsp_vad_t s_vad;
+static int16_t s_vad_hold[AUDIO_RECORD_READ_BYTES / sizeof(int16_t)]; // 上一块静音, 语音开始时补写保留起音
+static size_t s_vad_hold_samples = 0;
+static uint32_t s_vad_skipped = 0; // 当前静音段已丢弃的采样数
+static record_cue_t s_cues[AUDIO_RECORD_VAD_MAX_CUES];
+static uint32_t s_cue_count = 0;
+
+// 预录: 常驻采集任务把16kHz单声道循环写入PSRAM (仅采集任务访问缓冲区)
+#define PREROLL_SAMPLES (AUDIO_RECORD_PREROLL_RATE / 1000 * AUDIO_RECORD_PREROLL_MS)
+#define PREROLL_FACTOR (AUDIO_DEFAULT_SAMPLE_RATE / AUDIO_RECORD_PREROLL_RATE)
+#define RECORD_READ_FRAMES (AUDIO_RECORD_READ_BYTES / (AUDIO_DEFAULT_CHANNELS * sizeof(int16_t)))
+#define RECORD_READ_TIMEOUT_MS (1000) // 切换延迟档位时读取会短暂阻塞
+#define PREROLL_CHUNK (RECORD_READ_FRAMES / PREROLL_FACTOR) // 回放预录时每次送入VAD的采样数, 与实时块一致
+
+static volatile bool s_preroll_enabled = false;
+static int16_t *s_preroll_buf = NULL; // 首次开启时分配, 之后常驻
+static size_t s_preroll_pos = 0;      // 下一个写入位置
+static size_t s_preroll_count = 0;    // 有效采样数
+static audio_dsp_decim_t s_preroll_decim;
+static int16_t s_preroll_low[RECORD_READ_FRAMES]; // 当前块的16kHz单声道结果
+
 // WAV文件头结构体
 typedef struct
 {
@@ -62,118 +142,885 @@ static void generate_wav_header(wav_header_t *header, uint32_t data_len, uint32_
     header->data_len = data_len;
 }
 
-// 录音任务
-static void record_task(void *arg)
+// IMA-ADPCM WAV文件头 (fmt扩展 + fact块)
+typedef struct
+{
+    char riff_tag[4];
+    uint32_t riff_len;
+    char wave_tag[4];
+    char fmt_tag[4];
+    uint32_t fmt_len;           // 20
+    uint16_t audio_fmt;         // 0x11 = IMA-ADPCM
+    uint16_t channels;
+    uint32_t sample_rate;
+    uint32_t byte_rate;
+    uint16_t block_align;       // 块大小
+    uint16_t bits_per_sample;   // 4
+    uint16_t cb_size;           // 2
+    uint16_t samples_per_block; // 每块采样数
+    char fact_tag[4];           // "fact"
+    uint32_t fact_len;          // 4
+    uint32_t total_samples;     // 总采样数 (不含最后一块的补齐)
+    char data_tag[4];
+    uint32_t data_len;
+} wav_adpcm_header_t;
+
+// 生成IMA-ADPCM WAV头
+static void generate_wav_adpcm_header(wav_adpcm_header_t *header, uint32_t data_len, uint32_t sample_rate, uint32_t total_samples)
+{
+    memcpy(header->riff_tag, "RIFF", 4);
+    header->riff_len = data_len + sizeof(wav_adpcm_header_t) - 8;
+    memcpy(header->wave_tag, "WAVE", 4);
+    memcpy(header->fmt_tag, "fmt ", 4);
+    header->fmt_len = 20;
+    header->audio_fmt = 0x11;
+    header->channels = 1;
+    header->sample_rate = sample_rate;
+    header->byte_rate = sample_rate * AUDIO_DSP_ADPCM_BLOCK_BYTES / RECORD_ADPCM_SPB;
+    header->block_align = AUDIO_DSP_ADPCM_BLOCK_BYTES;
+    header->bits_per_sample = 4;
+    header->cb_size = 2;
+    header->samples_per_block = RECORD_ADPCM_SPB;
+    memcpy(header->fact_tag, "fact", 4);
+    header->fact_len = 4;
+    header->total_samples = total_samples;
+    memcpy(header->data_tag, "data", 4);
+    header->data_len = data_len;
+}
+
+/**
+ * @brief 按当前录音格式生成文件头
+ * @param buf 输出, 至少sizeof(wav_adpcm_header_t)字节
+ * @param data_len 已写入的数据长度
+ * @param final 录音已结束, ADPCM使用精确的采样数, 否则按已写入的整块数计算
+ * @param trailer_len data块之后的其他块(cue/LIST)长度, 计入RIFF长度
+ * @return 文件头长度
+ */
+static size_t record_build_header(uint8_t *buf, uint32_t data_len, bool final, uint32_t trailer_len)
 {
-    esp_codec_dev_handle_t record_dev = audio_codec_get_record_dev();
-    if (record_dev == NULL)
+    const record_format_desc_t *desc = &s_format_desc[s_record_format];
+    if (desc->adpcm)
     {
-        ESP_LOGE(TAG, "无法获取录音设备");
-        s_is_recording = false;
-        vTaskDelete(NULL);
+        wav_adpcm_header_t *header = (wav_adpcm_header_t *)buf;
+        uint32_t samples = final ? s_record_samples : data_len / AUDIO_DSP_ADPCM_BLOCK_BYTES * RECORD_ADPCM_SPB;
+        generate_wav_adpcm_header(header, data_len, desc->sample_rate, samples);
+        header->riff_len += trailer_len;
+        return sizeof(wav_adpcm_header_t);
+    }
+    wav_header_t *header = (wav_header_t *)buf;
+    generate_wav_header(header, data_len, desc->sample_rate, desc->channels, 16);
+    header->riff_len += trailer_len;
+    return sizeof(wav_header_t);
+}
+
+/**
+ * @brief 把转换后的数据放入环形缓冲区 (不等待), 更新丢帧和峰值统计
+ */
+static void record_send(const void *data, size_t len, uint32_t frames)
+{
+    if (xRingbufferSend(s_record_ring, data, len, 0) != pdTRUE)
+    {
+        s_record_stats.dropped_frames += frames;
         return;
     }
 
-    FILE *f = fopen(s_record_filename, "wb");
-    if (f == NULL)
+    uint32_t used = AUDIO_RECORD_RING_SIZE - xRingbufferGetCurFreeSize(s_record_ring);
+    if (used > s_record_stats.ring_peak_bytes)
     {
-        ESP_LOGE(TAG, "无法创建录音文件: %s", s_record_filename);
-        s_is_recording = false;
-        vTaskDelete(NULL);
+        s_record_stats.ring_peak_bytes = used;
+    }
+}
+
+/**
+ * @brief 编码一个ADPCM块并发送
+ */
+static void record_flush_adpcm_block(void)
+{
+    uint8_t block[AUDIO_DSP_ADPCM_BLOCK_BYTES];
+    audio_dsp_adpcm_encode_block(&s_adpcm, s_adpcm_pcm, block, sizeof(block));
+    record_send(block, sizeof(block), RECORD_ADPCM_SPB);
+    s_adpcm_fill = 0;
+}
+
+/**
+ * @brief 把转换后的采样编码(ADPCM)或直接发送
+ * @param pcm 交织采样
+ * @param samples 每声道采样数
+ */
+static void record_emit(const int16_t *pcm, size_t samples)
+{
+    const record_format_desc_t *desc = &s_format_desc[s_record_format];
+
+    if (!desc->adpcm)
+    {
+        record_send(pcm, samples * desc->channels * sizeof(int16_t), samples);
+        s_record_samples += samples;
         return;
     }
 
-    // 预留WAV头空间
-    wav_header_t header;
-    memset(&header, 0, sizeof(wav_header_t));
-    fwrite(&header, 1, sizeof(wav_header_t), f);
+    // 攒满一块后ADPCM编码
+    for (size_t i = 0; i < samples; i++)
+    {
+        s_adpcm_pcm[s_adpcm_fill++] = pcm[i];
+        if (s_adpcm_fill == RECORD_ADPCM_SPB)
+        {
+            record_flush_adpcm_block();
+        }
+    }
+    s_record_samples += samples;
+}
+
+/**
+ * @brief 采样数换算为当前格式写入文件的字节数 (ADPCM按平均码率)
+ */
+static uint32_t record_samples_to_bytes(uint32_t samples)
+{
+    const record_format_desc_t *desc = &s_format_desc[s_record_format];
+    if (desc->adpcm)
+    {
+        return (uint32_t)((uint64_t)samples * AUDIO_DSP_ADPCM_BLOCK_BYTES / RECORD_ADPCM_SPB);
+    }
+    return samples * desc->channels * sizeof(int16_t);
+}
 
-    ESP_LOGI(TAG, "开始录音: %s", s_record_filename);
-    // 提升录音增益：默认提升到36dB，适配低灵敏度驻极体麦克风
-    audio_codec_set_record_gain(36.0f);
+/**
+ * @brief 结束当前静音段: 记录一个标记点 (位置为文件中的下一个采样)
+ */
+static void record_close_silence(void)
+{
+    if (s_vad_skipped == 0)
+    {
+        return;
+    }
+    s_cues[s_cue_count].position = s_record_samples;
+    s_cues[s_cue_count].length = s_vad_skipped;
+    s_cue_count++;
+    s_record_stats.silence_markers = s_cue_count;
+    s_vad_skipped = 0;
+}
+
+/**
+ * @brief VAD门控: 判断这一块是否写入
+ * @details 静音块先缓存一块, 被下一块静音挤出时才真正丢弃, 语音开始时补写缓存块,
+ *          保证起音不被切掉。标记表用完后不再跳过, 保证时间轴始终可以还原。
+ * @return true 写入这一块
+ */
+static bool record_vad_gate(const int16_t *pcm, size_t samples)
+{
+    const record_format_desc_t *desc = &s_format_desc[s_record_format];
+
+    int64_t t0 = esp_timer_get_time();
+    bool speech = audio_dsp_vad_process(&s_vad, pcm, samples, desc->channels);
+    uint32_t cost_us = (uint32_t)(esp_timer_get_time() - t0);
+    if (cost_us > s_record_stats.vad_max_us)
+    {
+        s_record_stats.vad_max_us = cost_us;
+    }
+
+    if (speech)
+    {
+        s_record_stats.vad_speech_blocks++;
+        if (s_vad_hold_samples > 0)
+        {
+            record_close_silence();
+            record_emit(s_vad_hold, s_vad_hold_samples);
+            s_vad_hold_samples = 0;
+        }
+        return true;
+    }
+
+    s_record_stats.vad_silence_blocks++;
+    if (s_cue_count >= AUDIO_RECORD_VAD_MAX_CUES)
+    {
+        return true;
+    }
 
-    // 申请缓冲区
-    size_t buf_size = 4096 * 1; // 可调节为2048/4096以平衡时延与I/O
-    // uint8_t *buffer = (uint8_t *)heap_caps_malloc(buf_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    uint8_t *buffer = (uint8_t *)malloc(buf_size);
-    if (buffer == NULL)
+    // 挤出的上一块静音真正丢弃
+    if (s_vad_hold_samples > 0)
     {
-        ESP_LOGE(TAG, "内存不足");
-        fclose(f);
+        s_vad_skipped += s_vad_hold_samples;
+        s_record_stats.bytes_saved += record_samples_to_bytes(s_vad_hold_samples);
+    }
+    memcpy(s_vad_hold, pcm, samples * desc->channels * sizeof(int16_t));
+    s_vad_hold_samples = samples;
+    return false;
+}
+
+/**
+ * @brief 已是录音格式的采样: 静音跳过后发送
+ */
+static void record_process_converted(const int16_t *pcm, size_t samples)
+{
+    if (s_vad_gating && !record_vad_gate(pcm, samples))
+    {
+        return;
+    }
+    record_emit(pcm, samples);
+}
+
+/**
+ * @brief 把一块48kHz立体声采集数据转换为录音格式并发送
+ * @param pcm 交织立体声, 原地处理
+ * @param frames 帧数
+ */
+static void record_process(int16_t *pcm, size_t frames)
+{
+    const record_format_desc_t *desc = &s_format_desc[s_record_format];
+    size_t samples = frames;
+
+    if (desc->channels == 1)
+    {
+        // 1. 两个麦克风下混 (原地)
+        audio_dsp_downmix_s16(pcm, pcm, frames);
+
+        // 2. 抽取到16kHz (原地, 输出位置总落后于输入位置)
+        if (desc->sample_rate != AUDIO_DEFAULT_SAMPLE_RATE)
+        {
+            samples = audio_dsp_decim_process(&s_decim, pcm, samples, pcm);
+        }
+    }
+
+    // 3. 静音跳过后发送
+    record_process_converted(pcm, samples);
+}
+
+/**
+ * @brief 录音结束时处理剩余数据
+ * @details 结尾的静音也记一个标记, 还原时长度正确;
+ *          补齐并发送最后一个ADPCM块 (补齐部分不计入采样数)
+ */
+static void record_finish_process(void)
+{
+    if (s_vad_hold_samples > 0)
+    {
+        s_vad_skipped += s_vad_hold_samples;
+        s_record_stats.bytes_saved += record_samples_to_bytes(s_vad_hold_samples);
+        s_vad_hold_samples = 0;
+    }
+    record_close_silence();
+
+    if (!s_format_desc[s_record_format].adpcm || s_adpcm_fill == 0)
+    {
+        return;
+    }
+    int16_t last = s_adpcm_pcm[s_adpcm_fill - 1];
+    while (s_adpcm_fill < RECORD_ADPCM_SPB)
+    {
+        s_adpcm_pcm[s_adpcm_fill++] = last;
+    }
+    record_flush_adpcm_block();
+}
+
+/**
+ * @brief 把一块48kHz立体声转换为16kHz单声道, 结果在s_preroll_low中
+ * @return 输出采样数
+ */
+static size_t preroll_convert(const int16_t *pcm, size_t frames)
+{
+    audio_dsp_downmix_s16(s_preroll_low, pcm, frames);
+    return audio_dsp_decim_process(&s_preroll_decim, s_preroll_low, frames, s_preroll_low);
+}
+
+/**
+ * @brief 写入预录缓冲区, 满后覆盖最旧的数据
+ */
+static void preroll_push(const int16_t *pcm, size_t samples)
+{
+    for (size_t i = 0; i < samples; i++)
+    {
+        s_preroll_buf[s_preroll_pos] = pcm[i];
+        s_preroll_pos = (s_preroll_pos + 1) % PREROLL_SAMPLES;
+    }
+    s_preroll_count = (s_preroll_count + samples > PREROLL_SAMPLES) ? PREROLL_SAMPLES : s_preroll_count + samples;
+}
+
+/**
+ * @brief 预录开启且当前录音格式能直接使用预录的16kHz单声道数据
+ */
+static bool preroll_matches_format(void)
+{
+    const record_format_desc_t *desc = &s_format_desc[s_record_format];
+    return s_preroll_enabled && s_preroll_buf != NULL && desc->channels == 1 && desc->sample_rate == AUDIO_RECORD_PREROLL_RATE;
+}
+
+/**
+ * @brief 录音开始: 按时间顺序把预录内容送入录音链路, 然后清空预录
+ * @details 预录已关闭时只清空, 不使用关闭之前残留的内容
+ */
+static void preroll_drain(void)
+{
+    if (preroll_matches_format() && s_preroll_count > 0)
+    {
+        int16_t chunk[PREROLL_CHUNK];
+        size_t start = (s_preroll_pos + PREROLL_SAMPLES - s_preroll_count) % PREROLL_SAMPLES;
+        size_t left = s_preroll_count;
+        ESP_LOGI(TAG, "录音从预录开始: %lu ms", (unsigned long)(s_preroll_count * 1000 / AUDIO_RECORD_PREROLL_RATE));
+
+        while (left > 0)
+        {
+            size_t n = left < PREROLL_CHUNK ? left : PREROLL_CHUNK;
+            for (size_t i = 0; i < n; i++)
+            {
+                chunk[i] = s_preroll_buf[(start + i) % PREROLL_SAMPLES];
+            }
+            record_process_converted(chunk, n);
+            start = (start + n) % PREROLL_SAMPLES;
+            left -= n;
+        }
+    }
+    s_preroll_pos = 0;
+    s_preroll_count = 0;
+}
+
+/**
+ * @brief 采集任务: 只读取codec并放入环形缓冲区, 从不等待SD卡
+ * @details 开启预录时常驻: 不录音时只更新预录缓冲区, 录音开始/结束在块边界切换,
+ *          16kHz单声道格式直接使用预录链路的转换结果, 与预录内容无缝衔接
+ * @details 缓冲区满时丢弃本块并计数, 保证I2S RX DMA始终被及时取走
+ */
+static void record_capture_task(void *arg)
+{
+    uint8_t *buffer = (uint8_t *)malloc(AUDIO_RECORD_READ_BYTES);
+    if (audio_codec_get_record_dev() == NULL || buffer == NULL)
+    {
+        ESP_LOGE(TAG, "无法启动采集: 录音设备或内存不可用");
+        free(buffer);
         s_is_recording = false;
+        s_capture_done = true;
+        s_capture_task_handle = NULL;
         vTaskDelete(NULL);
         return;
     }
 
-    size_t total_bytes = 0;
-    int read_res;
+    // 提升录音增益：默认提升到36dB，适配低灵敏度驻极体麦克风
+    audio_codec_set_record_gain(36.0f);
+
+    audio_dsp_decim_init(&s_preroll_decim, PREROLL_FACTOR);
+    bool recording = false;
 
-    while (s_is_recording)
+    while (s_is_recording || s_preroll_enabled)
     {
-        read_res = esp_codec_dev_read(record_dev, buffer, buf_size);
-        if (read_res == ESP_CODEC_DEV_OK)
+        // 直接读I2S, 切换延迟档位重建I2S通道时在这里短暂阻塞
+        esp_err_t read_res = audio_codec_record_read(buffer, AUDIO_RECORD_READ_BYTES, RECORD_READ_TIMEOUT_MS);
+        if (read_res != ESP_OK)
+        {
+            ESP_LOGW(TAG, "读取音频数据失败或超时: %s", esp_err_to_name(read_res));
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+
+        // 1. 录音状态在块边界切换
+        bool want = s_is_recording;
+        if (recording && !want)
+        {
+            record_finish_process();
+            s_capture_done = true;
+            recording = false;
+        }
+
+        size_t low_samples = 0;
+        if (s_preroll_enabled && s_preroll_buf != NULL)
         {
-            fwrite(buffer, 1, buf_size, f);
-            total_bytes += buf_size;
+            low_samples = preroll_convert((const int16_t *)buffer, RECORD_READ_FRAMES);
         }
         else
         {
-            ESP_LOGW(TAG, "读取音频数据失败或超时: %d", read_res);
-            vTaskDelay(pdMS_TO_TICKS(10));
+            // 预录已关闭: 丢弃残留内容, 重新开启后从空缓冲区开始 (只在本任务中修改, 不与preroll_push竞争)
+            s_preroll_pos = 0;
+            s_preroll_count = 0;
         }
-    }
 
-    // 录音结束，回填WAV头
-    ESP_LOGI(TAG, "录音结束，正在保存... 总大小: %d 字节", total_bytes);
+        if (want && !recording)
+        {
+            recording = true;
+            preroll_drain();
+        }
 
-    // 假设采样率48000, 双声道, 16位 (需与audio_codec配置一致)
-    generate_wav_header(&header, total_bytes, 48000, 2, 16);
-    fseek(f, 0, SEEK_SET);
-    fwrite(&header, 1, sizeof(wav_header_t), f);
+        // 2. 录音时送入录音链路, 否则只更新预录
+        if (recording)
+        {
+            s_record_stats.bytes_captured += AUDIO_RECORD_READ_BYTES;
+            if (low_samples > 0 && preroll_matches_format())
+            {
+                record_process_converted(s_preroll_low, low_samples);
+            }
+            else
+            {
+                record_process((int16_t *)buffer, RECORD_READ_FRAMES);
+            }
+        }
+        else if (low_samples > 0)
+        {
+            preroll_push(s_preroll_low, low_samples);
+        }
+    }
 
-    fclose(f);
+    if (recording)
+    {
+        record_finish_process();
+    }
+    s_preroll_pos = 0;
+    s_preroll_count = 0;
     free(buffer);
+    s_capture_done = true;
+    s_capture_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief 创建采集任务 (已在运行时直接返回)
+ */
+static esp_err_t record_start_capture_task(void)
+{
+    if (s_capture_task_handle != NULL)
+    {
+        return ESP_OK;
+    }
+    BaseType_t ret = xTaskCreatePinnedToCore(record_capture_task, "RecCapture", 4096, NULL, AUDIO_RECORD_CAPTURE_PRIORITY,
+                                             &s_capture_task_handle, 0);
+    return ret == pdPASS ? ESP_OK : ESP_FAIL;
+}
+
+/**
+ * @brief 打开录音文件, 优先使用预分配的连续空间
+ * @details 写入经sd_manager的I/O调度按SD_MANAGER_CLASS_RECORD排队, 只让位于音乐播放的读取,
+ *          界面和后台的读写(缩略图、媒体库扫描)不会插在录音前面
+ */
+static sd_manager_file_t *record_open_file(const char *path)
+{
+    s_record_stats.preallocated =
+        (sd_manager_create_contiguous_file(path, AUDIO_RECORD_PREALLOC_BYTES) == ESP_OK); // 否则退回普通文件
+
+    sd_manager_file_t *f = NULL;
+    if (sd_manager_file_open(path, true, &f) != ESP_OK)
+    {
+        return NULL;
+    }
+    return f;
+}
+
+/**
+ * @brief 按偏移写入录音文件
+ */
+static esp_err_t record_write_at(sd_manager_file_t *f, uint32_t offset, const void *data, size_t len)
+{
+    return sd_manager_file_write(f, offset, data, len, SD_MANAGER_CLASS_RECORD);
+}
+
+/**
+ * @brief 回写WAV头并同步目录项
+ */
+static void record_update_header(sd_manager_file_t *f, uint32_t data_len, bool final, uint32_t trailer_len)
+{
+    uint8_t header[sizeof(wav_adpcm_header_t)];
+    size_t len = record_build_header(header, data_len, final, trailer_len);
+    record_write_at(f, 0, header, len);
+    sd_manager_file_sync(f);
+}
+
+/**
+ * @brief 在data块之后写入静音标记: cue块(位置) + LIST/adtl中的ltxt(跳过的采样数)
+ * @details 标记先在buf中拼好再一次写入, 最多AUDIO_RECORD_VAD_MAX_CUES个, 约7KB
+ * @return 写入的字节数, 没有标记或写入失败时为0
+ */
+static uint32_t record_write_cues(sd_manager_file_t *f, uint32_t offset, uint8_t *buf)
+{
+    if (s_cue_count == 0)
+    {
+        return 0;
+    }
+
+    uint32_t cue_len = 4 + 24 * s_cue_count;
+    uint32_t list_len = 4 + 28 * s_cue_count;
+    uint32_t head[3];
+    uint8_t *p = buf;
+
+    memcpy(p, "cue ", 4);
+    head[0] = cue_len;
+    head[1] = s_cue_count;
+    memcpy(p + 4, head, 2 * sizeof(uint32_t));
+    p += 12;
+    for (uint32_t i = 0; i < s_cue_count; i++)
+    {
+        // ID, 播放位置, 所在块"data", 块起始, 压缩块起始, 块内采样偏移
+        uint32_t point[6] = {i + 1, s_cues[i].position, 0, 0, 0, s_cues[i].position};
+        memcpy(&point[2], "data", 4);
+        memcpy(p, point, sizeof(point));
+        p += sizeof(point);
+    }
+
+    memcpy(p, "LIST", 4);
+    head[0] = list_len;
+    memcpy(p + 4, head, sizeof(uint32_t));
+    memcpy(p + 8, "adtl", 4);
+    p += 12;
+    for (uint32_t i = 0; i < s_cue_count; i++)
+    {
+        // ltxt: ID, 区间长度, 用途码"sil ", 国家/语言/方言/代码页均为0
+        uint32_t ltxt[7] = {0, 20, i + 1, s_cues[i].length, 0, 0, 0};
+        memcpy(&ltxt[0], "ltxt", 4);
+        memcpy(&ltxt[4], "sil ", 4);
+        memcpy(p, ltxt, sizeof(ltxt));
+        p += sizeof(ltxt);
+    }
+
+    uint32_t len = (uint32_t)(p - buf);
+    return record_write_at(f, offset, buf, len) == ESP_OK ? len : 0;
+}
+
+/**
+ * @brief 为当前录音创建峰值文件 (失败时返回NULL, 不影响录音)
+ */
+static audio_peaks_writer_t *record_open_peaks(void)
+{
+    const record_format_desc_t *desc = &s_format_desc[s_record_format];
+    audio_peaks_source_t src = {
+        .format = desc->adpcm ? AUDIO_PEAKS_FORMAT_IMA_ADPCM : AUDIO_PEAKS_FORMAT_PCM16,
+        .channels = desc->channels,
+        .sample_rate = desc->sample_rate,
+        .block_align = AUDIO_DSP_ADPCM_BLOCK_BYTES,
+    };
+    char path[sizeof(s_record_filename) + 4];
+    audio_peaks_writer_t *peaks = NULL;
+    if (!AUDIO_RECORD_PEAKS || !audio_peaks_path(s_record_filename, path, sizeof(path)) ||
+        audio_peaks_writer_open(path, &src, SD_MANAGER_CLASS_RECORD, &peaks) != ESP_OK)
+    {
+        return NULL;
+    }
+    return peaks;
+}
+
+/**
+ * @brief 从环形缓冲区攒满32KB后整块写入文件, 直到采集结束且缓冲区取空
+ * @details 文件从偏移0开始按32KB整块写入(第一块包含WAV头), 每次写入都扇区对齐;
+ *          周期性回写WAV头, 掉电后文件仍可播放。取出的数据同时送入峰值文件
+ */
+static void record_write_loop(sd_manager_file_t *f, uint8_t *block, audio_peaks_writer_t *peaks)
+{
+    // 第一块以WAV头占位开头, 长度在回写时填入
+    size_t fill = s_header_len;
+    memset(block, 0, fill);
+    uint32_t file_pos = 0;
+    uint32_t data_len = 0;
+    int64_t last_header_us = esp_timer_get_time();
+
+    while (true)
+    {
+        bool done = s_capture_done;
+        size_t item_size = 0;
+        void *item = xRingbufferReceiveUpTo(s_record_ring, &item_size, pdMS_TO_TICKS(100), AUDIO_RECORD_WRITE_BYTES - fill);
+        if (item == NULL)
+        {
+            if (done)
+            {
+                break; // 采集已结束且缓冲区已取空
+            }
+            continue;
+        }
+        memcpy(block + fill, item, item_size);
+        audio_peaks_writer_feed(peaks, item, item_size);
+        vRingbufferReturnItem(s_record_ring, item);
+        fill += item_size;
+        data_len += item_size;
+
+        if (fill < AUDIO_RECORD_WRITE_BYTES)
+        {
+            continue;
+        }
+
+        int64_t t0 = esp_timer_get_time();
+        if (record_write_at(f, file_pos, block, AUDIO_RECORD_WRITE_BYTES) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "写入录音文件失败, 停止录音");
+            s_is_recording = false;
+            fill = 0;
+            break;
+        }
+        uint32_t write_ms = (uint32_t)((esp_timer_get_time() - t0) / 1000);
+        if (write_ms > s_record_stats.max_write_ms)
+        {
+            s_record_stats.max_write_ms = write_ms;
+        }
+        file_pos += AUDIO_RECORD_WRITE_BYTES;
+        s_record_stats.bytes_written = data_len;
+        fill = 0;
 
-    s_record_task_handle = NULL;
-    ESP_LOGI(TAG, "录音文件已保存");
+        if (esp_timer_get_time() - last_header_us >= AUDIO_RECORD_HEADER_UPDATE_MS * 1000LL)
+        {
+            record_update_header(f, data_len, false, 0);
+            last_header_us = esp_timer_get_time();
+        }
+    }
+
+    // 写入最后不足一块的数据
+    if (fill > 0 && record_write_at(f, file_pos, block, fill) == ESP_OK)
+    {
+        file_pos += fill;
+    }
+    s_record_stats.bytes_written = data_len;
+
+    // 采集已结束, 静音标记表不再变化; block已经写出, 用来拼标记
+    uint32_t trailer_len = record_write_cues(f, file_pos, block);
+    file_pos += trailer_len;
+    record_update_header(f, data_len, true, trailer_len);
+    // 截掉预分配但未使用的部分 (覆盖同名旧文件时也截掉它多出的部分)
+    sd_manager_file_truncate(f, file_pos);
+}
+
+/**
+ * @brief 写入任务: 打开文件并持续把环形缓冲区的数据写入SD卡
+ */
+static void record_writer_task(void *arg)
+{
+    // 写入缓冲区放在内部DMA内存, SPI驱动可直接使用, 无需逐扇区拷贝
+    uint8_t *block = sd_manager_alloc_io_buffer(AUDIO_RECORD_WRITE_BYTES);
+    sd_manager_file_t *f = block ? record_open_file(s_record_filename) : NULL;
+
+    if (f != NULL)
+    {
+        ESP_LOGI(TAG, "开始录音: %s (%s)", s_record_filename, s_record_stats.preallocated ? "连续预分配" : "普通文件");
+        audio_peaks_writer_t *peaks = record_open_peaks();
+        record_write_loop(f, block, peaks);
+        sd_manager_file_close(f); // 同时使/sdcard/record的列表缓存失效
+        if (peaks != NULL)
+        {
+            audio_peaks_writer_close(peaks, s_record_stats.bytes_written, true);
+        }
+        ESP_LOGI(TAG, "录音文件已保存: %lu 字节, 丢帧 %lu, 缓冲峰值 %lu 字节, 最长写入 %lu ms",
+                 (unsigned long)s_record_stats.bytes_written, (unsigned long)s_record_stats.dropped_frames,
+                 (unsigned long)s_record_stats.ring_peak_bytes, (unsigned long)s_record_stats.max_write_ms);
+        if (s_vad_gating)
+        {
+            ESP_LOGI(TAG, "静音跳过: 语音 %lu 块, 静音 %lu 块, 少写 %lu 字节, 标记 %lu 个, VAD最长 %lu us",
+                     (unsigned long)s_record_stats.vad_speech_blocks, (unsigned long)s_record_stats.vad_silence_blocks,
+                     (unsigned long)s_record_stats.bytes_saved, (unsigned long)s_record_stats.silence_markers,
+                     (unsigned long)s_record_stats.vad_max_us);
+        }
+    }
+    else
+    {
+        ESP_LOGE(TAG, "无法创建录音文件: %s", s_record_filename);
+        s_is_recording = false;
+    }
+
+    // 等采集任务退出后再释放缓冲区
+    while (!s_capture_done)
+    {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    free(block);
+    vRingbufferDeleteWithCaps(s_record_ring);
+    s_record_ring = NULL;
+    s_writer_task_handle = NULL;
     vTaskDelete(NULL);
 }
+
+/**
+ * @brief 预加载SPIFFS根目录下的所有WAV音效到PSRAM
+ * @details 音效名为去掉扩展名的文件名, 例如 /spiffs/click.wav -> "click"
+ */
+static void audio_app_preload_effects(void)
+{
+    DIR *dir = opendir(AUDIO_SPIFFS_BASE_PATH);
+    if (dir == NULL)
+    {
+        return;
+    }
+
+    struct dirent *ent;
+    int loaded = 0;
+    while ((ent = readdir(dir)) != NULL)
+    {
+        const char *ext = strrchr(ent->d_name, '.');
+        if (ext == NULL || strcasecmp(ext, ".wav") != 0)
+        {
+            continue;
+        }
+
+        char path[64];
+        char name[AUDIO_MIXER_EFFECT_NAME_MAX];
+        snprintf(path, sizeof(path), "%s/%s", AUDIO_SPIFFS_BASE_PATH, ent->d_name);
+        snprintf(name, sizeof(name), "%.*s", (int)(ext - ent->d_name), ent->d_name);
+        if (audio_mixer_effect_load(path, name, NULL) == ESP_OK)
+        {
+            loaded++;
+        }
+    }
+    closedir(dir);
+
+    ESP_LOGI(TAG, "已预加载 %d 个音效", loaded);
+}
+
+// 资源包中的名称原样作为音效名称注册
+_Static_assert(ASSET_PACK_NAME_MAX <= AUDIO_MIXER_EFFECT_NAME_MAX, "混音器的音效名称放不下资源包中的名称");
+
+/**
+ * @brief 把资源包中的音效注册到混音器
+ * @details 打包时已转换为48kHz立体声并补齐到整块, 混音器直接从映射的flash读取, 不占PSRAM
+ */
+static void audio_app_register_pack_effects(void)
+{
+    int loaded = 0;
+    uint32_t count = asset_pack_count();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        asset_pack_asset_t asset;
+        if (asset_pack_get(i, &asset) != ESP_OK || asset.entry->type != ASSET_PACK_TYPE_PCM)
+        {
+            continue;
+        }
+        if (audio_mixer_effect_register(asset.entry->name, asset.data, asset.entry->meta[0], NULL) == ESP_OK)
+        {
+            loaded++;
+        }
+    }
+
+    ESP_LOGI(TAG, "已注册 %d 个资源包音效", loaded);
+}
+
 esp_err_t audio_app_init(void)
 {
-    // 这里可以做一些应用层的初始化，目前驱动层已经初始化好了
     ESP_LOGI(TAG, "音频应用初始化");
 
+    // audio分区优先按资源包映射: 音效、图片、字体都是flash指针, 不经过文件系统
+    esp_err_t ret = asset_pack_init(AUDIO_SPIFFS_PARTITION);
+    if (ret == ESP_OK)
+    {
+        audio_app_register_pack_effects();
+        return ESP_OK;
+    }
+
+    // 分区中不是资源包时按SPIFFS挂载, 存放UI音效等只读资源
+    esp_vfs_spiffs_conf_t conf = {
+        .base_path = AUDIO_SPIFFS_BASE_PATH,
+        .partition_label = AUDIO_SPIFFS_PARTITION,
+        .max_files = 4,
+        .format_if_mount_failed = false,
+    };
+    ret = esp_vfs_spiffs_register(&conf);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGW(TAG, "挂载音频SPIFFS失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    // 音效在启动时一次性读入PSRAM, 触发时不再访问文件系统
+    audio_app_preload_effects();
     return ESP_OK;
 }
 
-esp_err_t audio_app_start_record(const char *filename)
+esp_err_t audio_app_play_effect(const char *name)
 {
-    if (s_is_recording)
+    int id = audio_mixer_effect_find(name);
+    if (id < 0)
+    {
+        ESP_LOGW(TAG, "未找到音效: %s", name ? name : "(null)");
+        return ESP_ERR_NOT_FOUND;
+    }
+    return audio_mixer_effect_play(id, 1.0f);
+}
+
+esp_err_t audio_app_start_record(const char *filename, audio_app_record_format_t format)
+{
+    if (s_is_recording || s_writer_task_handle != NULL)
     {
         ESP_LOGW(TAG, "正在录音中，请先停止");
         return ESP_ERR_INVALID_STATE;
     }
 
-    if (filename == NULL)
+    if (filename == NULL || format >= AUDIO_RECORD_FORMAT_MAX)
     {
         return ESP_ERR_INVALID_ARG;
     }
 
+    s_record_ring = xRingbufferCreateWithCaps(AUDIO_RECORD_RING_SIZE, RINGBUF_TYPE_BYTEBUF, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (s_record_ring == NULL)
+    {
+        ESP_LOGE(TAG, "录音缓冲区分配失败");
+        return ESP_ERR_NO_MEM;
+    }
+
     strncpy(s_record_filename, filename, sizeof(s_record_filename) - 1);
-    s_is_recording = true;
+    memset(&s_record_stats, 0, sizeof(s_record_stats));
+
+    // 格式转换状态在采集任务启动前复位
+    uint8_t header[sizeof(wav_adpcm_header_t)];
+    s_record_format = format;
+    s_header_len = record_build_header(header, 0, false, 0);
+    s_record_samples = 0;
+    audio_dsp_decim_init(&s_decim, AUDIO_DEFAULT_SAMPLE_RATE / s_format_desc[format].sample_rate);
+    memset(&s_adpcm, 0, sizeof(s_adpcm));
+    s_adpcm_fill = 0;
+    s_vad_gating = s_vad_enabled;
+    audio_dsp_vad_init(&s_vad, s_format_desc[format].sample_rate, AUDIO_RECORD_VAD_HANGOVER_MS);
+    s_vad_hold_samples = 0;
+    s_vad_skipped = 0;
+    s_cue_count = 0;
+
+    s_capture_done = false;
 
-    // 创建录音任务，优先级稍高，分配4KB栈空间
-    BaseType_t ret = xTaskCreate(record_task, "RecTask", 4096, NULL, 5, &s_record_task_handle);
+    // 写入任务负责打开文件, 采集任务立即开始读取, 文件准备期间的数据先进入缓冲区
+    BaseType_t ret = xTaskCreate(record_writer_task, "RecWriter", 4096, NULL, AUDIO_RECORD_WRITER_PRIORITY, &s_writer_task_handle);
     if (ret != pdPASS)
     {
-        ESP_LOGE(TAG, "创建录音任务失败");
+        ESP_LOGE(TAG, "创建录音写入任务失败");
+        vRingbufferDeleteWithCaps(s_record_ring);
+        s_record_ring = NULL;
+        return ESP_FAIL;
+    }
+
+    // 状态全部就绪后再置位, 常驻的采集任务看到后从下一块开始录音
+    s_is_recording = true;
+
+    // 开启预录时采集任务已在运行, 下一块即开始录音
+    if (record_start_capture_task() != ESP_OK)
+    {
+        // 写入任务看到采集结束后会自行清理
+        ESP_LOGE(TAG, "创建录音采集任务失败");
         s_is_recording = false;
+        s_capture_done = true;
         return ESP_FAIL;
     }
 
     return ESP_OK;
 }
 
+esp_err_t audio_app_set_record_preroll(bool enable)
+{
+    if (!enable)
+    {
+        // 采集任务在当前块结束后退出 (录音中则在录音结束后退出), 并清空预录内容;
+        // 之后开始的录音不再使用预录 (preroll_matches_format检查开关)
+        s_preroll_enabled = false;
+        return ESP_OK;
+    }
+
+    if (s_preroll_buf == NULL)
+    {
+        s_preroll_buf = heap_caps_malloc(PREROLL_SAMPLES * sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (s_preroll_buf == NULL)
+        {
+            ESP_LOGE(TAG, "预录缓冲区分配失败");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    s_preroll_enabled = true;
+    if (record_start_capture_task() != ESP_OK)
+    {
+        ESP_LOGE(TAG, "创建录音采集任务失败");
+        s_preroll_enabled = false;
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "预录已开启: %d ms, %d Hz单声道", AUDIO_RECORD_PREROLL_MS, AUDIO_RECORD_PREROLL_RATE);
+    return ESP_OK;
+}
+
+void audio_app_set_record_vad(bool enable)
+{
+    s_vad_enabled = enable;
+}
+
 esp_err_t audio_app_stop_record(void)
 {
     if (!s_is_recording)
@@ -182,15 +1029,26 @@ esp_err_t audio_app_stop_record(void)
     }
 
     ESP_LOGI(TAG, "请求停止录音...");
+    // 采集任务在当前块读完后退出, 写入任务取空缓冲区后回写WAV头并关闭文件
     s_is_recording = false;
 
-    // 等待任务结束（简单处理，实际可能需要信号量同步）
-    // 这里不wait也行，任务会自动删除
-
     return ESP_OK;
 }
 
+void audio_app_get_record_stats(audio_app_record_stats_t *stats)
+{
+    if (stats != NULL)
+    {
+        *stats = s_record_stats;
+    }
+}
+
 bool audio_app_is_recording(void)
 {
     return s_is_recording;
 }
+
+bool audio_app_is_record_saving(void)
+{
+    return s_writer_task_handle != NULL;
+}
@@ -8,24 +8,101 @@
 
 #include "esp_err.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+// 录音管线配置: 采集任务 -> PSRAM环形缓冲区 -> 写入任务 -> SD卡
+#define AUDIO_RECORD_READ_BYTES (4096)                     // 采集任务单次读取 (48kHz立体声约21ms)
+#define AUDIO_RECORD_RING_SIZE (1024 * 1024)               // 环形缓冲区 (PSRAM, 48kHz立体声约5.4秒)
+#define AUDIO_RECORD_WRITE_BYTES (32 * 1024)               // 单次写入SD卡的大小 (扇区对齐)
+#define AUDIO_RECORD_PREALLOC_BYTES (64ULL * 1024 * 1024)  // 预分配的连续空间 (48kHz立体声约5.8分钟)
+#define AUDIO_RECORD_HEADER_UPDATE_MS (5000)               // WAV头回写周期, 掉电时最多丢失这段时长的长度信息
+#define AUDIO_RECORD_CAPTURE_PRIORITY (7)
+#define AUDIO_RECORD_WRITER_PRIORITY (4)
+#define AUDIO_RECORD_VAD_DEFAULT (true)                    // 默认开启静音跳过
+#define AUDIO_RECORD_VAD_HANGOVER_MS (400)                 // 语音结束后继续写入的时长
+#define AUDIO_RECORD_VAD_MAX_CUES (128)                    // 单个文件最多的静音标记数, 用完后不再跳过静音
+#define AUDIO_RECORD_PREROLL_DEFAULT (false)               // 启动后是否常开预录; 默认只在录音界面显示期间开启
+#define AUDIO_RECORD_PREROLL_MS (3000)                     // 预录时长
+#define AUDIO_RECORD_PREROLL_RATE (16000)                  // 预录采样率 (单声道), 与16kHz单声道录音格式衔接
+#define AUDIO_RECORD_PEAKS (true)                          // 录音时在写入任务中同时生成峰值文件(.pk), 用于波形显示
+
+    /**
+     * @brief 录音格式 (全部在采集任务中流式定点处理)
+     */
+    typedef enum
+    {
+        AUDIO_RECORD_FORMAT_PCM_48K_STEREO = 0, // 原始双麦克风, 192KB/s
+        AUDIO_RECORD_FORMAT_PCM_48K_MONO,       // 双麦克风下混, 96KB/s
+        AUDIO_RECORD_FORMAT_PCM_16K_MONO,       // 下混+抽取到16kHz, 32KB/s
+        AUDIO_RECORD_FORMAT_ADPCM_48K_MONO,     // 下混+IMA-ADPCM, 约24KB/s
+        AUDIO_RECORD_FORMAT_ADPCM_16K_MONO,     // 下混+抽取+IMA-ADPCM, 约8KB/s (适合语音备忘)
+        AUDIO_RECORD_FORMAT_MAX,
+    } audio_app_record_format_t;
+
+    /**
+     * @brief 录音统计信息 (每次开始录音时清零)
+     */
+    typedef struct
+    {
+        uint32_t bytes_captured;  // 从codec读取的字节数
+        uint32_t bytes_written;   // 写入文件的音频数据字节数
+        uint32_t dropped_frames;  // 环形缓冲区满而丢弃的帧数 (按录音格式的采样率计)
+        uint32_t ring_peak_bytes; // 环形缓冲区最高占用
+        uint32_t max_write_ms;    // 单次写入SD卡的最长耗时
+        bool preallocated;        // 文件是否使用了预分配的连续空间
+        uint32_t vad_speech_blocks;  // VAD判为语音的块数 (约21ms一块)
+        uint32_t vad_silence_blocks; // VAD判为静音的块数
+        uint32_t vad_max_us;         // VAD单块最长耗时
+        uint32_t bytes_saved;        // 跳过静音少写的字节数
+        uint32_t silence_markers;    // 写入的静音标记(cue点)数
+    } audio_app_record_stats_t;
+
     /**
      * @brief 初始化音频应用
+     * @details audio分区是资源包时映射资源包并注册其中的音效, 否则挂载SPIFFS并预加载WAV音效
      * @return esp_err_t
      */
     esp_err_t audio_app_init(void);
 
+    /**
+     * @brief 播放预加载的UI音效 (不阻塞, 与音乐混音)
+     * @param name 音效名称, 即资源包或SPIFFS中去掉扩展名的WAV文件名 (例如 "click")
+     * @return esp_err_t ESP_OK成功, ESP_ERR_NOT_FOUND未加载该音效
+     */
+    esp_err_t audio_app_play_effect(const char *name);
+
     /**
      * @brief 开始录音
      * @param filename 保存的文件名 (例如 "/sdcard/record.wav")
+     * @param format 录音格式, ADPCM格式写入WAV格式码0x11 (IMA-ADPCM)
      * @return esp_err_t
      */
-    esp_err_t audio_app_start_record(const char *filename);
+    esp_err_t audio_app_start_record(const char *filename, audio_app_record_format_t format);
+
+    /**
+     * @brief 设置录音时是否跳过静音 (下次开始录音时生效)
+     * @details 开启后静音段不写入文件, 每段被跳过的静音在WAV的cue块中记一个标记点,
+     *          LIST/adtl中对应的ltxt记录被跳过的采样数(用途码"sil "), 可据此还原原始时间轴
+     * @param enable true开启
+     */
+    void audio_app_set_record_vad(bool enable);
+
+    /**
+     * @brief 开启/关闭预录
+     * @details 开启后采集任务常驻, ES7210持续采集, 下混抽取为16kHz单声道后循环写入PSRAM中的预录缓冲区。
+     *          开始16kHz单声道格式的录音时, 文件从按键前AUDIO_RECORD_PREROLL_MS的音频开始,
+     *          文件在写入任务中异步打开; 其他格式不使用预录内容, 但省去了启动采集的延迟。
+     *          开启期间麦克风和采集任务一直运行, 只在录音界面显示时开启 (AUDIO_RECORD_PREROLL_DEFAULT)
+     * @note 须在audio_codec_init()之后调用
+     * @param enable true开启
+     * @return esp_err_t
+     */
+    esp_err_t audio_app_set_record_preroll(bool enable);
 
     /**
      * @brief 停止录音
@@ -33,6 +110,12 @@ extern "C"
      */
     esp_err_t audio_app_stop_record(void);
 
+    /**
+     * @brief 获取录音统计信息 (录音中或结束后均可调用)
+     * @param stats 输出
+     */
+    void audio_app_get_record_stats(audio_app_record_stats_t *stats);
+
     /**
      * @brief 检查是否正在录音
      * @return true 正在录音
@@ -40,6 +123,14 @@ extern "C"
      */
     bool audio_app_is_recording(void);
 
+    /**
+     * @brief 录音文件是否还在保存
+     * @details audio_app_stop_record()只通知采集结束, 写入任务随后写出缓冲区中的数据、回写WAV头并关闭
+     *          录音和峰值文件; 返回false后才能读取刚停止的录音
+     * @return true 写入任务还在运行
+     */
+    bool audio_app_is_record_saving(void);
+
 #ifdef __cplusplus
 }
 #endif
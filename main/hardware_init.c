@@ -1,4 +1,6 @@
 #include "hardware_init.h"
+#include <stdio.h>
+#include <stdlib.h>
 #include "esp_log.h"
 #include "nvs_flash.h"
 #include "simple_wifi_sta.h"
@@ -6,11 +8,22 @@
 #include "freertos/event_groups.h"
 #include "audio_app.h"
 #include "sd_manager.h"
+#include "sd_manager_bench.h"
+#include "sd_manager_cache.h"
 #include "audio_codec.h"
+#include "audio_mixer.h"
+#include "audio_spectrum.h"
 #include "i2c_manager.h"
+#include "boot_manager.h"
 
 static const char *TAG = "HARDWARE_INIT";
 
+// 1: SD卡挂载后运行基准测试 (约1-2分钟), 表格和CSV打印到串口, 用于调整SPI频率和分配单元
+#define HARDWARE_SD_BENCH (0)
+
+// 启动时等待WiFi连接的时长, 超时后联网相关的阶段照常开始 (各自重试)
+#define HARDWARE_WIFI_WAIT_MS (30 * 1000)
+
 // 内部使用的事件组
 static EventGroupHandle_t s_wifi_ev_handle = NULL;
 #define WIFI_CONNECT_BIT BIT0
@@ -53,101 +66,193 @@ static esp_err_t hardware_nvs_init(void)
 }
 
 /**
- * @brief 硬件层统一初始化
- * @details 初始化NVS、WiFi、SPIFFS、SD卡、I2C总线和音频编解码器，并阻塞等待WiFi连接成功
- * @return esp_err_t ESP_OK: 初始化成功且WiFi已连接; 其他: 初始化失败
+ * @brief SD卡基准测试, 结果以当前SPI频率和分配单元为标签
  */
-esp_err_t hardware_init(void)
+static void hardware_sd_bench(void)
 {
-    esp_err_t ret;
+    sd_manager_bench_result_t *results = malloc(SD_MANAGER_BENCH_MAX_RESULTS * sizeof(sd_manager_bench_result_t));
+    if (results == NULL)
+    {
+        return;
+    }
 
-    // 1. NVS初始化
-    ESP_LOGI(TAG, "Initializing NVS...");
-    ret = hardware_nvs_init();
+    char label[48];
+    snprintf(label, sizeof(label), "spi%dk_au%dk", SD_MANAGER_SPI_FREQ_KHZ, SD_MANAGER_ALLOC_UNIT / 1024);
+    sd_manager_bench_config_t cfg = {.dir = "/sdcard/bench"};
+    size_t count = 0;
+    esp_err_t ret = sd_manager_bench_run(&cfg, results, SD_MANAGER_BENCH_MAX_RESULTS, &count);
+    if (ret == ESP_OK)
+    {
+        sd_manager_bench_print(stdout, results, count, label);
+        sd_manager_bench_write_csv(stdout, results, count, label, true);
+    }
+    else
+    {
+        ESP_LOGE(TAG, "SD卡基准测试失败: %s", esp_err_to_name(ret));
+    }
+    free(results);
+}
+
+/**
+ * @brief 阶段nvs: NVS闪存初始化
+ */
+static esp_err_t hardware_stage_nvs(void *arg)
+{
+    return hardware_nvs_init();
+}
+
+/**
+ * @brief 阶段assets: 挂载audio分区并预加载UI音效 (录音/播放需要)
+ */
+static esp_err_t hardware_stage_assets(void *arg)
+{
+    return audio_app_init();
+}
+
+/**
+ * @brief 阶段sd: 挂载SD卡, 打开派生数据缓存
+ */
+static esp_err_t hardware_stage_sd(void *arg)
+{
+    esp_err_t ret = sd_manager_init();
     if (ret != ESP_OK)
     {
-        ESP_LOGE(TAG, "NVS init failed: %s", esp_err_to_name(ret));
         return ret;
     }
 
-    // 2. 初始化音频SPIFFS (录音/播放需要)
-    ESP_LOGI(TAG, "Initializing Audio SPIFFS...");
-    ret = audio_app_init(); // 假设这里包含了 audio_spiffs_init 类似的功能，根据上下文推断
+    // SD卡初始化成功后，打印目录内容进行调试
+    ESP_LOGI(TAG, "Listing SD Card root directory:");
+    sd_manager_list_dir("/sdcard");
+    ESP_LOGI(TAG, "Listing /sdcard/mp3 directory:");
+    sd_manager_list_dir("/sdcard/mp3");
+
+    // 派生数据缓存 (缩略图、峰值文件等), 失败时各功能按未命中处理
+    ret = sd_manager_cache_init(SD_MANAGER_CACHE_DIR, SD_MANAGER_CACHE_BUDGET);
     if (ret != ESP_OK)
     {
-        ESP_LOGE(TAG, "Audio SPIFFS init failed: %s", esp_err_to_name(ret));
-        // 非致命错误，继续
+        ESP_LOGW(TAG, "SD cache init failed: %s", esp_err_to_name(ret));
     }
 
-    // 3. 初始化SD卡
-    ESP_LOGI(TAG, "Initializing SD Card...");
-    ret = sd_manager_init();
-    if (ret != ESP_OK)
+    if (HARDWARE_SD_BENCH)
     {
-        ESP_LOGE(TAG, "SD Card init failed: %s", esp_err_to_name(ret));
-        // 非致命错误，继续
+        hardware_sd_bench();
     }
-    else
+    return ESP_OK;
+}
+
+/**
+ * @brief 阶段i2c: 安装I2C总线驱动
+ * @details 触摸和音频编解码器都会调用i2c_manager_init, 它本身不可并发调用; 由这个阶段先完成,
+ *          之后的调用直接返回. 可选阶段: 失败时屏幕(SPI2)照常启动, 触摸和音频初始化各自报错
+ */
+static esp_err_t hardware_stage_i2c(void *arg)
+{
+    return i2c_manager_init();
+}
+
+/**
+ * @brief 阶段audio: 音频编解码器、混音器、频谱分析和预录
+ */
+static esp_err_t hardware_stage_audio(void *arg)
+{
+    esp_err_t ret = audio_codec_init();
+    if (ret != ESP_OK)
     {
-        // SD卡初始化成功后，打印目录内容进行调试
-        ESP_LOGI(TAG, "Listing SD Card root directory:");
-        sd_manager_list_dir("/sdcard");
-        ESP_LOGI(TAG, "Listing /sdcard/mp3 directory:");
-        sd_manager_list_dir("/sdcard/mp3");
+        return ret;
     }
+    audio_codec_set_volume(60);
 
-    // 4. 初始化音频编解码器
-    ESP_LOGI(TAG, "Initializing Audio Codec...");
-    ret = audio_codec_init();
+    // 混音器接管codec写入, 音乐和UI音效经它叠加后输出
+    ret = audio_mixer_init();
     if (ret != ESP_OK)
     {
-        ESP_LOGE(TAG, "Audio Codec init failed: %d", ret);
+        ESP_LOGE(TAG, "Audio mixer init failed: %s", esp_err_to_name(ret));
     }
     else
     {
-        ESP_LOGI(TAG, "Audio system initialized successfully");
-        audio_codec_set_volume(60);
+        // 频谱分析挂在混音器输出上, 为主界面的频谱控件提供数据
+        audio_spectrum_start();
     }
 
-    // 5. 扫描I2C总线
-    ESP_LOGI(TAG, "Scanning I2C Bus...");
-    i2c_manager_scan();
+    // 预录: 麦克风常驻采集到PSRAM, 按下录音键时从按键前几秒开始。常开时ES7210和采集任务一直运行,
+    // 默认关闭, 由录音界面在显示期间开启 (lvgl_bottomr_init)
+    if (AUDIO_RECORD_PREROLL_DEFAULT)
+    {
+        audio_app_set_record_preroll(true);
+    }
+    return ESP_OK;
+}
 
-    // 6. 创建事件组
+/**
+ * @brief 阶段i2c_scan: 扫描I2C总线 (逐个地址探测, 只用于调试输出)
+ */
+static esp_err_t hardware_stage_i2c_scan(void *arg)
+{
+    return i2c_manager_scan();
+}
+
+/**
+ * @brief 阶段wifi: 启动WiFi STA, 不等待连接
+ */
+static esp_err_t hardware_stage_wifi(void *arg)
+{
     s_wifi_ev_handle = xEventGroupCreate();
     if (s_wifi_ev_handle == NULL)
     {
         ESP_LOGE(TAG, "Failed to create event group");
-        return ESP_FAIL;
+        return ESP_ERR_NO_MEM;
     }
+    return wifi_sta_init(wifi_event_handler);
+}
 
-    // 7. WiFi初始化
-    ESP_LOGI(TAG, "Initializing WiFi...");
-    ret = wifi_sta_init(wifi_event_handler);
-    if (ret != ESP_OK)
+/**
+ * @brief 阶段net: 等待WiFi连接
+ * @details 超时只表示启动期间没有连上, WiFi驱动会继续重连, 依赖它的阶段照常执行并自行重试
+ */
+static esp_err_t hardware_stage_net(void *arg)
+{
+    EventBits_t bits = xEventGroupWaitBits(s_wifi_ev_handle, WIFI_CONNECT_BIT, pdFALSE, pdFALSE,
+                                           pdMS_TO_TICKS(HARDWARE_WIFI_WAIT_MS));
+    if (!(bits & WIFI_CONNECT_BIT))
     {
-        ESP_LOGE(TAG, "WiFi init failed: %s", esp_err_to_name(ret));
-        return ret;
+        ESP_LOGW(TAG, "WiFi not connected within %d ms", HARDWARE_WIFI_WAIT_MS);
+        return ESP_ERR_TIMEOUT;
     }
+    ESP_LOGI(TAG, "WiFi Connected");
+    return ESP_OK;
+}
 
-    // 8. 等待连接
-    ESP_LOGI(TAG, "Waiting for WiFi connection...");
-    EventBits_t bits = xEventGroupWaitBits(
-        s_wifi_ev_handle,
-        WIFI_CONNECT_BIT,
-        pdTRUE,       // 退出时清除位
-        pdFALSE,      // 等待任意位
-        portMAX_DELAY // 永久等待
-    );
-
-    if (bits & WIFI_CONNECT_BIT)
-    {
-        ESP_LOGI(TAG, "Hardware init complete: WiFi Connected");
-        return ESP_OK;
-    }
-    else
+/**
+ * @brief 登记硬件初始化的启动阶段
+ * @details 依赖关系:
+ *          - nvs, assets, sd, i2c 互不依赖, 同时开始
+ *          - audio 依赖 i2c 和 assets (预录和UI音效)
+ *          - wifi 依赖 nvs, net 依赖 wifi (后台)
+ *          - i2c_scan 依赖 audio 和 ui (所有I2C设备初始化之后, 后台)
+ * @return esp_err_t boot_manager_add的结果
+ */
+esp_err_t hardware_boot_register(void)
+{
+    const boot_stage_t stages[] = {
+        {.name = "nvs", .fn = hardware_stage_nvs},
+        {.name = "assets", .fn = hardware_stage_assets, .flags = BOOT_STAGE_OPTIONAL},
+        {.name = "sd", .fn = hardware_stage_sd, .flags = BOOT_STAGE_OPTIONAL, .stack = 6 * 1024},
+        {.name = "i2c", .fn = hardware_stage_i2c, .flags = BOOT_STAGE_OPTIONAL},
+        {.name = "audio", .fn = hardware_stage_audio, .deps = {"i2c", "assets"}, .flags = BOOT_STAGE_OPTIONAL,
+         .stack = 6 * 1024},
+        {.name = "i2c_scan", .fn = hardware_stage_i2c_scan, .deps = {"audio", "ui"},
+         .flags = BOOT_STAGE_BACKGROUND | BOOT_STAGE_OPTIONAL, .priority = 1},
+        {.name = "wifi", .fn = hardware_stage_wifi, .deps = {"nvs"}},
+        {.name = "net", .fn = hardware_stage_net, .deps = {"wifi"},
+         .flags = BOOT_STAGE_BACKGROUND | BOOT_STAGE_OPTIONAL},
+    };
+    for (size_t i = 0; i < sizeof(stages) / sizeof(stages[0]); i++)
     {
-        ESP_LOGE(TAG, "Hardware init failed: WiFi Timeout");
-        return ESP_FAIL;
+        esp_err_t ret = boot_manager_add(&stages[i]);
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
     }
+    return ESP_OK;
 }
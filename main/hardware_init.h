@@ -4,10 +4,11 @@
 #include "esp_err.h"
 
 /**
- * @brief 硬件层统一初始化
- * @details 初始化NVS、WiFi、SPIFFS、SD卡、I2C总线和音频编解码器，并阻塞等待WiFi连接成功
- * @return esp_err_t ESP_OK: 初始化成功且WiFi已连接; 其他: 初始化失败
+ * @brief 登记硬件初始化的启动阶段 (boot_manager)
+ * @details 阶段: nvs, assets, sd, i2c, audio, i2c_scan, wifi, net; 不阻塞, 也不等待WiFi连接。
+ *          i2c_scan依赖界面阶段"ui", 由调用者登记。
+ * @return esp_err_t ESP_OK: 登记成功; 其他: boot_manager_add的错误
  */
-esp_err_t hardware_init(void);
+esp_err_t hardware_boot_register(void);
 
 #endif // HARDWARE_INIT_H
@@ -15,185 +15,237 @@
 #include "esp_system.h"
 #include "esp_sntp.h"
 #include "esp_http_client.h"
-#include "cJSON.h"
 #include "hptts.h"
+#include "weather_client.h"
+#include "json_stream.h"
+#include "weather_cache.h"
+#include "weather_functions.h"
 
-#define MAX_HTTP_OUTPUT_BUFFER 1024 // HTTP响应缓冲区最大长度
+#define HPTTS_WEATHER_ENDPOINT "/v3/weather/now.json" // 同时作为缓存键, user_seniverse_now_config_t改变时应改名
+#define HPTTS_WEATHER_LOCATION "guangzhou"
+#define HPTTS_WEATHER_URL "https://api.seniverse.com" HPTTS_WEATHER_ENDPOINT "?key=SYEUrFRiIVQow_1OX&location=" HPTTS_WEATHER_LOCATION "&language=zh-Hans&unit=c"
+#define HPTTS_WEATHER_CERT NULL // 服务器证书(PEM), NULL使用内置证书包
 
-static const char *TAG = "HTTP_CLIENT";           // HTTP相关日志标签
-static int user_cjson_parse_now(char *json_data); // 天气JSON解析函数声明
+static const char *TAG = "HTTP_CLIENT"; // HTTP相关日志标签
+static void user_weather_print_now(void);
+
+// 全局天气数据结构体, 只在完整解析成功(或服务器确认缓存未变)后更新
+user_seniverse_now_config_t user_now_config;
+static weather_cache_meta_t s_now_meta; // user_now_config的取得时间和验证器
+static bool s_cache_loaded = false;     // 已读过NVS中的缓存
+static bool s_now_valid = false;        // user_now_config中有数据 (来自缓存或请求, 不一定仍可显示)
+
+// 解析中的数据, 响应不完整或格式错误时丢弃
+static user_seniverse_now_config_t s_now_parsing;
+static json_stream_t s_now_parser;
+
+#define HPTTS_NOW_FIELD(json_path, member) {json_path, s_now_parsing.member, sizeof(s_now_parsing.member)}
+static const json_stream_field_t s_now_fields[] = {
+    HPTTS_NOW_FIELD("results[0].location.id", id),
+    HPTTS_NOW_FIELD("results[0].location.name", name),
+    HPTTS_NOW_FIELD("results[0].location.country", country),
+    HPTTS_NOW_FIELD("results[0].location.path", path),
+    HPTTS_NOW_FIELD("results[0].location.timezone", timezone),
+    HPTTS_NOW_FIELD("results[0].location.timezone_offset", timezone_offset),
+    HPTTS_NOW_FIELD("results[0].now.text", weather_text),
+    HPTTS_NOW_FIELD("results[0].now.code", weather_code),
+    HPTTS_NOW_FIELD("results[0].now.temperature", temperature),
+    HPTTS_NOW_FIELD("results[0].last_update", last_update),
+};
+#define HPTTS_NOW_FIELD_COUNT (sizeof(s_now_fields) / sizeof(s_now_fields[0]))
+#define HPTTS_NOW_REQUIRED ((1u << 1) | (1u << 6) | (1u << 8) | (1u << 9)) // 城市、天气、温度、更新时间
 
 /**
- * @brief HTTP客户端事件处理函数
- *
- * 该函数用于处理ESP-IDF HTTP客户端的各种事件，包括连接、数据接收、断开等。
- * 在接收到心知天气API的数据时，会将数据累积到 weather_buffer，
- * 并在数据接收完成后调用 user_cjson_parse_now 进行JSON解析和信息打印。
- *
- * @param evt HTTP客户端事件结构体，包含事件类型和相关数据
- * @return esp_err_t ESP_OK表示成功处理
+ * @brief 响应体分块到达时直接送入解析器, 不缓存整个响应
  */
-esp_err_t _http_event_handler(esp_http_client_event_t *evt)
+static void user_weather_on_data(const char *data, size_t len, void *arg)
 {
-    static int output_len = 0;                                // 已读取的字节数，累计接收数据长度
-    static char weather_buffer[MAX_HTTP_OUTPUT_BUFFER] = {0}; // 用于存储心知天气API返回的JSON数据
-
-    switch (evt->event_id)
-    {
-    case HTTP_EVENT_ERROR:
-        // 发生错误时的事件
-        ESP_LOGD(TAG, "HTTP_EVENT_ERROR");
-        break;
-    case HTTP_EVENT_ON_CONNECTED:
-        // 与服务器成功建立连接
-        ESP_LOGD(TAG, "HTTP_EVENT_ON_CONNECTED");
-        output_len = 0; // 每次连接时重置计数器
-        break;
-    case HTTP_EVENT_HEADER_SENT:
-        // 已发送HTTP请求头
-        ESP_LOGD(TAG, "HTTP_EVENT_HEADER_SENT");
-        break;
-    case HTTP_EVENT_ON_HEADER:
-        // 收到HTTP响应头部
-        ESP_LOGD(TAG, "HTTP_EVENT_ON_HEADER, key=%s, value=%s", evt->header_key, evt->header_value);
-        break;
-    case HTTP_EVENT_ON_DATA:
-        // 收到HTTP响应数据（可能多次调用，需累积数据）
-        ESP_LOGD(TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
-        // 计算本次可复制的数据长度，防止缓冲区溢出
-        int copy_len = MIN(evt->data_len, (MAX_HTTP_OUTPUT_BUFFER - output_len - 1));
-        if (copy_len > 0)
-        {
-            // 将本次收到的数据追加到 weather_buffer
-            memcpy(weather_buffer + output_len, evt->data, copy_len);
-            output_len += copy_len;
-            weather_buffer[output_len] = '\0'; // 确保字符串以'\0'结尾，便于后续解析
-        }
-        break;
-    case HTTP_EVENT_ON_FINISH:
-        // 数据接收完成（所有数据已收到）
-        ESP_LOGD(TAG, "HTTP_EVENT_ON_FINISH");
-        // 如果已收到数据，则进行JSON解析
-        if (output_len > 0)
-        {
-            user_cjson_parse_now(weather_buffer); // 解析心知天气JSON数据并打印信息
-        }
-        output_len = 0; // 重置计数器，准备下次接收
-        break;
-    case HTTP_EVENT_DISCONNECTED:
-        // 与服务器断开连接
-        ESP_LOGD(TAG, "HTTP_EVENT_DISCONNECTED");
-        break;
-    case HTTP_EVENT_REDIRECT:
-        // 收到重定向响应
-        ESP_LOGD(TAG, "HTTP_EVENT_REDIRECT");
-        break;
-    }
-    return ESP_OK;
+    json_stream_feed((json_stream_t *)arg, data, len);
 }
 
 /**
- * @brief 从心知天气API获取天气数据
- *
- * 发送HTTPS GET请求获取广州当前天气数据
+ * @brief 把user_now_config显示到主界面并打印
+ * @param stale 数据已过新鲜期, 正在等待刷新
  */
-void http_rest_with_url(void)
+static void user_weather_publish(bool stale)
 {
-    char local_response_buffer[MAX_HTTP_OUTPUT_BUFFER] = {0}; // 响应数据缓冲区
-    esp_http_client_config_t config = {
-        .url = "https://api.seniverse.com/v3/weather/now.json?key=SYEUrFRiIVQow_1OX&location=guangzhou&language=zh-Hans&unit=c",
-        .method = HTTP_METHOD_GET,
-        .event_handler = _http_event_handler,
-        .user_data = local_response_buffer, // 传递本地缓冲区地址以获取响应
-        .disable_auto_redirect = true,
-        .timeout_ms = 10000,                        // HTTPS需要更长超时时间
-        .crt_bundle_attach = esp_crt_bundle_attach, // 使用系统内置根证书
-    };
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_http_client_perform(client);
-    // // 发送 GET 请求
-    // esp_err_t err = esp_http_client_perform(client);
-    // if (err == ESP_OK)
-    // {
-    //     int status_code = esp_http_client_get_status_code(client);
-    //     int content_length = esp_http_client_get_content_length(client);
-    //     ESP_LOGI(TAG, "HTTP GET Status = %d, content_length = %d", status_code, content_length);
-
-    //     // 检查HTTP状态码
-    //     if (status_code == 200)
-    //     {
-    //         user_cjson_parse_now(local_response_buffer); // 调用解析函数
-    //     }
-    //     else
-    //     {
-    //         ESP_LOGW(TAG, "HTTP request returned status code: %d", status_code);
-    //     }
-    // }
-    esp_http_client_cleanup(client); // 清理HTTP客户端
+    update_weather_display(user_now_config.temperature, user_now_config.last_update, stale);
+    user_weather_print_now();
 }
 
-// 全局天气数据结构体
-user_seniverse_now_config_t user_now_config;
-
 /**
- * @brief 解析心知天气实时天气JSON数据
- * @param json_data 心知天气API返回的原始JSON字符串
- * @return 0表示解析成功，-1表示失败
+ * @brief 从NVS读取上次保存的天气, 未过期时立即显示
+ * @return weather_cache_state_t 缓存状态; 已过期的数据也会读入, 用于条件请求
  */
-static int user_cjson_parse_now(char *json_data)
+static weather_cache_state_t user_weather_load_cached(void)
 {
-    cJSON *root = NULL;
-    cJSON *results = NULL;
-    cJSON *item = NULL;
-    cJSON *location = NULL;
-    cJSON *now = NULL;
-
-    root = cJSON_Parse(json_data); // 解析JSON字符串
-    if (!root)
+    weather_cache_meta_t meta;
+    size_t len = 0;
+    esp_err_t err = weather_cache_load(HPTTS_WEATHER_ENDPOINT, HPTTS_WEATHER_LOCATION, &meta, &s_now_parsing,
+                                       sizeof(s_now_parsing), &len);
+    if (err != ESP_OK || len != sizeof(s_now_parsing))
     {
-        ESP_LOGI(TAG, "JSON解析失败: [%s]\n", cJSON_GetErrorPtr());
-        return -1;
+        ESP_LOGI(TAG, "没有缓存的天气");
+        return WEATHER_CACHE_MISS;
     }
+    user_now_config = s_now_parsing;
+    s_now_meta = meta;
+    s_now_valid = true;
 
-    results = cJSON_GetObjectItem(root, "results"); // 获取results数组
-    if (!results || !cJSON_IsArray(results))
+    weather_cache_state_t state = weather_cache_state(&s_now_meta, HPTTS_WEATHER_TTL_S, HPTTS_WEATHER_STALE_S);
+    static const char *state_names[] = {"无", "新鲜", "待刷新", "已过期"};
+    ESP_LOGI(TAG, "缓存的天气: %s, 年龄 %lld 秒", state_names[state], (long long)weather_cache_age(&s_now_meta));
+    if (state != WEATHER_CACHE_EXPIRED)
     {
-        ESP_LOGI(TAG, "未找到results数组");
-        cJSON_Delete(root);
-        return -1;
+        user_weather_publish(state == WEATHER_CACHE_STALE);
     }
+    return state;
+}
 
-    item = cJSON_GetArrayItem(results, 0); // 取第一个城市结果
-    if (!item)
+/**
+ * @brief 从心知天气API获取天气数据
+ *
+ * 发送HTTPS GET请求获取广州当前天气数据。连接由weather_client保持, 周期性调用时不再每次完整握手;
+ * 响应体不经缓冲, 分块送入json_stream, 只把需要的字段拷贝到user_now_config, 响应长度不受缓冲区限制。
+ * 已有数据时带上次响应的ETag/Last-Modified发条件请求, 服务器返回304时沿用已有数据;
+ * 成功后的数据连同验证器保存到NVS(weather_cache), 重启后立即可用。
+ * 测试时可把HPTTS_WEATHER_URL改为本地替身服务器(tools/weather_server.py), 并用HPTTS_WEATHER_CERT填入它的证书。
+ * @return esp_err_t ESP_OK user_now_config已是最新
+ */
+esp_err_t http_rest_with_url(void)
+{
+    static bool configured = false;
+    if (!configured && HPTTS_WEATHER_CERT != NULL)
     {
-        ESP_LOGI(TAG, "results数组为空");
-        cJSON_Delete(root);
-        return -1;
+        weather_client_config_t cfg = {
+            .cert_pem = HPTTS_WEATHER_CERT,
+            .skip_common_name_check = true,
+        };
+        weather_client_init(&cfg);
     }
+    configured = true;
 
-    // 解析location对象
-    location = cJSON_GetObjectItem(item, "location");
-    if (location)
+    json_stream_init(&s_now_parser, s_now_fields, HPTTS_NOW_FIELD_COUNT);
+    weather_client_validators_t validators = {
+        .if_none_match = s_now_meta.etag,
+        .if_modified_since = s_now_meta.last_modified,
+    };
+    static weather_client_result_t res; // 含两个验证器, 不放在栈上
+    esp_err_t err = weather_client_get_conditional(HPTTS_WEATHER_URL, s_now_valid ? &validators : NULL,
+                                                   user_weather_on_data, &s_now_parser, &res);
+    if (err != ESP_OK)
     {
-        user_now_config.id = cJSON_GetObjectItem(location, "id")->valuestring;
-        user_now_config.name = cJSON_GetObjectItem(location, "name")->valuestring;
-        user_now_config.country = cJSON_GetObjectItem(location, "country")->valuestring;
-        user_now_config.path = cJSON_GetObjectItem(location, "path")->valuestring;
-        user_now_config.timezone = cJSON_GetObjectItem(location, "timezone")->valuestring;
-        user_now_config.timezone_offset = cJSON_GetObjectItem(location, "timezone_offset")->valuestring;
+        ESP_LOGW(TAG, "天气请求失败: %s", esp_err_to_name(err));
+        return err;
     }
+    ESP_LOGI(TAG, "HTTP GET Status = %d, %u 字节, 握手 %lu ms, 请求 %lu ms%s", res.status, (unsigned)res.len,
+             (unsigned long)(res.handshake_us / 1000), (unsigned long)(res.request_us / 1000),
+             res.new_connection ? "" : " (复用连接)");
 
-    // 解析now对象
-    now = cJSON_GetObjectItem(item, "now");
-    if (now)
+    // 检查HTTP状态码
+    if (res.status == 304 && s_now_valid)
+    {
+        // 内容未变: 沿用已有数据, 只更新取得时间
+        weather_cache_touch(HPTTS_WEATHER_ENDPOINT, HPTTS_WEATHER_LOCATION);
+        s_now_meta.fetched_at = weather_cache_clock_valid() ? (int64_t)time(NULL) : 0;
+        user_weather_publish(false);
+        return ESP_OK;
+    }
+    if (res.status != 200)
     {
-        user_now_config.weather_text = cJSON_GetObjectItem(now, "text")->valuestring;
-        user_now_config.weather_code = cJSON_GetObjectItem(now, "code")->valuestring;
-        user_now_config.temperature = cJSON_GetObjectItem(now, "temperature")->valuestring;
+        ESP_LOGW(TAG, "HTTP request returned status code: %d", res.status);
+        return ESP_ERR_INVALID_RESPONSE;
     }
+    err = json_stream_finish(&s_now_parser);
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "JSON解析失败: %s (第%u字节)", esp_err_to_name(err), (unsigned)s_now_parser.bytes);
+        return err;
+    }
+    if ((s_now_parser.found & HPTTS_NOW_REQUIRED) != HPTTS_NOW_REQUIRED)
+    {
+        ESP_LOGW(TAG, "响应中缺少字段 (found=0x%03lx)", (unsigned long)s_now_parser.found);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    if (s_now_parser.truncated != 0)
+    {
+        ESP_LOGW(TAG, "部分字段过长已截断 (0x%03lx)", (unsigned long)s_now_parser.truncated);
+    }
+    user_now_config = s_now_parsing;
+    memset(&s_now_meta, 0, sizeof(s_now_meta));
+    memcpy(s_now_meta.etag, res.etag, sizeof(s_now_meta.etag));
+    memcpy(s_now_meta.last_modified, res.last_modified, sizeof(s_now_meta.last_modified));
+    weather_cache_store(HPTTS_WEATHER_ENDPOINT, HPTTS_WEATHER_LOCATION, &s_now_meta, &user_now_config,
+                        sizeof(user_now_config));
+    s_now_meta.fetched_at = weather_cache_clock_valid() ? (int64_t)time(NULL) : 0;
+    s_now_valid = true;
+    user_weather_publish(false);
+    return ESP_OK;
+}
 
-    user_now_config.last_update = cJSON_GetObjectItem(item, "last_update")->valuestring;
+/**
+ * @brief 读取并显示NVS中缓存的天气
+ * @details 只依赖NVS和界面, 在启动阶段weather_cache中调用, 不必等WiFi; 之后的调用直接返回
+ */
+void hptts_weather_show_cached(void)
+{
+    if (!s_cache_loaded)
+    {
+        s_cache_loaded = true;
+        user_weather_load_cached();
+    }
+}
+
+/**
+ * @brief 天气后台刷新任务
+ * @details 先显示NVS中缓存的天气(不等网络), 之后按缓存状态刷新:
+ *          新鲜期内等到新鲜期结束; 过了新鲜期先照常显示(标记为待刷新)再请求; 请求失败时按
+ *          HPTTS_WEATHER_RETRY_S加倍重试, 不超过新鲜期; 数据超过HPTTS_WEATHER_STALE_S后从界面上移除。
+ *          时钟未同步时无法计算缓存年龄, 按待刷新处理, 请求成功后等待一个新鲜期。
+ */
+void hptts_weather_task(void *pvParameters)
+{
+    hptts_weather_show_cached(); // 启动阶段weather_cache通常已经显示过
+    uint32_t retry_s = HPTTS_WEATHER_RETRY_S;
+    while (1)
+    {
+        weather_cache_state_t state = WEATHER_CACHE_MISS;
+        if (s_now_valid)
+        {
+            state = weather_cache_state(&s_now_meta, HPTTS_WEATHER_TTL_S, HPTTS_WEATHER_STALE_S);
+        }
+        uint32_t wait_s;
+        if (state == WEATHER_CACHE_FRESH)
+        {
+            wait_s = HPTTS_WEATHER_TTL_S - (uint32_t)weather_cache_age(&s_now_meta) + 1;
+        }
+        else if (http_rest_with_url() == ESP_OK)
+        {
+            retry_s = HPTTS_WEATHER_RETRY_S;
+            wait_s = HPTTS_WEATHER_TTL_S;
+        }
+        else
+        {
+            if (state == WEATHER_CACHE_EXPIRED)
+            {
+                update_weather_display(NULL, NULL, true);
+            }
+            else if (state == WEATHER_CACHE_STALE)
+            {
+                update_weather_display(user_now_config.temperature, user_now_config.last_update, true);
+            }
+            wait_s = retry_s;
+            retry_s = MIN(retry_s * 2, HPTTS_WEATHER_TTL_S);
+        }
+        vTaskDelay(pdMS_TO_TICKS(wait_s * 1000));
+    }
+}
 
+/**
+ * @brief 打印实时天气, 更新时间从ISO 8601转换为"年-月-日 时:分:秒"
+ */
+static void user_weather_print_now(void)
+{
     // 时间格式转换
     char formatted_time[64] = {0};
     char year[5] = {0}, month[3] = {0}, day[3] = {0}, hour[3] = {0}, minute[3] = {0}, second[3] = {0};
@@ -222,7 +274,4 @@ static int user_cjson_parse_now(char *json_data)
     ESP_LOGI(TAG, "天气: %s", user_now_config.weather_text);
     ESP_LOGI(TAG, "温度: %s°C", user_now_config.temperature);
     ESP_LOGI(TAG, "天气更新时间: %s", formatted_time); // 使用转换后的时间格式
-
-    cJSON_Delete(root); // 释放内存
-    return 0;
 }
@@ -2,24 +2,29 @@
 #define HPTTS_H
 
 #include "esp_err.h"
-#include "esp_http_client.h"
 extern struct tm timeinfo;
+// 心知天气实时天气, 字符串直接存放在结构体中 (UTF-8, 超长时截断)
 typedef struct
 {
-    char *id;
-    char *name;
-    char *country;
-    char *path;
-    char *timezone;
-    char *timezone_offset;
-    char *weather_text;
-    char *weather_code;
-    char *temperature;
-    char *last_update;
+    char id[16];
+    char name[32];
+    char country[8];
+    char path[64];
+    char timezone[32];
+    char timezone_offset[8];
+    char weather_text[32];
+    char weather_code[4];
+    char temperature[8];
+    char last_update[32];
 } user_seniverse_now_config_t;
+extern user_seniverse_now_config_t user_now_config;
+#define HPTTS_WEATHER_TTL_S (10 * 60)       // 新鲜期: 心知天气的实时天气约10分钟更新一次
+#define HPTTS_WEATHER_STALE_S (6 * 60 * 60) // 过了新鲜期后仍显示缓存数据的时长
+#define HPTTS_WEATHER_RETRY_S (30)          // 刷新失败后的首次重试间隔, 之后逐次加倍
 // 函数声明
-esp_err_t _http_event_handler(esp_http_client_event_t *evt);
-void http_rest_with_url(void);
+esp_err_t http_rest_with_url(void);
+void hptts_weather_show_cached(void);         // 读取并显示NVS中缓存的天气, 只在第一次调用时执行
+void hptts_weather_task(void *pvParameters); // 天气后台刷新任务 (显示缓存并按TTL刷新)
 void esp_wait_sntp_sync(void); // 新增SNTP同步函数声明
 
 #endif // HPTTS_H
@@ -2,6 +2,7 @@
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "lv_port.h"
 #include "lvgl.h"
 #include "lv_demos.h"
@@ -20,6 +21,8 @@
 #include "driver/gpio.h"
 #include "iot_button.h"
 #include "button_gpio.h"
+#include "spectrum_widget.h"
+#include "waveform_widget.h"
 // 前置声明
 void lvgl_bottomr_init(void);
 void iot_button_init(void);
@@ -29,6 +32,9 @@ int next_call = 0;
 lv_ui guider_ui;
 // CPU使用率监控相关变量
 static TaskHandle_t cpu_monitor_task_handle = NULL;
+// 界面创建完成的信号, lvgl_task_start等待它
+static SemaphoreHandle_t s_ui_ready = NULL;
+extern TaskHandle_t lvgl_task_handle;
 
 // CPU使用率监控任务
 static void cpu_monitor_task(void *arg)
@@ -53,6 +59,13 @@ void lvgl_task(void *pvParameter)
     setup_ui(&guider_ui);
     events_init(&guider_ui);
 
+    // 主界面底部的音乐频谱
+    lv_obj_t *spectrum = spectrum_widget_create(guider_ui.screen_main_cont_1, 330, 90);
+    if (spectrum != NULL)
+    {
+        lv_obj_align(spectrum, LV_ALIGN_BOTTOM_MID, 0, -60);
+    }
+
     // 初始化自定义底部按钮
     // lvgl_bottomr_init();
     iot_button_init();
@@ -67,6 +80,11 @@ void lvgl_task(void *pvParameter)
         1                         // 在CPU1上运行
     );
 
+    if (s_ui_ready != NULL)
+    {
+        xSemaphoreGive(s_ui_ready);
+    }
+
     // LVGL任务主循环 - 保持任务持续运行
     while (1)
     {
@@ -90,6 +108,31 @@ void lvgl_task(void *pvParameter)
     }
 }
 
+/**
+ * @brief 启动阶段ui: 创建LVGL任务并等待界面创建完成
+ * @details 屏幕驱动、界面、频谱控件和按键都在lvgl_task中初始化, 完成后它进入主循环继续运行。
+ *          触摸驱动会调用i2c_manager_init, 所以这个阶段依赖阶段i2c。
+ * @return esp_err_t ESP_OK: 界面已显示; ESP_ERR_NO_MEM: 创建任务失败; ESP_ERR_TIMEOUT: 初始化超时
+ */
+esp_err_t lvgl_task_start(void)
+{
+    s_ui_ready = xSemaphoreCreateBinary();
+    if (s_ui_ready == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreatePinnedToCore(lvgl_task, "lvgl_task", 1024 * 10, NULL, 5, &lvgl_task_handle, 1) != pdPASS)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xSemaphoreTake(s_ui_ready, pdMS_TO_TICKS(LVGL_TASK_START_TIMEOUT_MS)) != pdTRUE)
+    {
+        ESP_LOGE(TAG, "界面初始化超时");
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
 static void button_single_click_cb(void *arg, void *data)
 {
     ESP_LOGI(TAG, "BUTTON_SINGLE_CLICK");
@@ -139,6 +182,43 @@ void iot_button_init(void)
     // 注册三连击事件，使用所有参数
     iot_button_register_cb(gpio_btn_handle, BUTTON_MULTIPLE_CLICK, &args, button_triple_click_cb, user_msg);
 }
+// 录音界面: 停止录音后显示刚保存的录音波形
+static lv_obj_t *s_record_wave = NULL;
+static lv_timer_t *s_record_wave_timer = NULL;
+static char s_record_last[64] = {0};
+
+// 等写入任务关闭录音和峰值文件后再显示波形, 否则峰值文件还没写完会被当作无效文件重新生成
+static void record_wave_poll_cb(lv_timer_t *timer)
+{
+    if (audio_app_is_record_saving())
+    {
+        return;
+    }
+    lv_timer_pause(timer);
+    if (s_record_wave != NULL && s_record_last[0] != '\0')
+    {
+        waveform_widget_set_file(s_record_wave, s_record_last);
+    }
+}
+
+// 录音界面所在屏幕显示期间开启预录, 离开后关闭, 麦克风不在其他界面常驻采集
+static void record_screen_event_handler(lv_event_t *e)
+{
+    if (AUDIO_RECORD_PREROLL_DEFAULT)
+    {
+        return; // 预录常开, 由hardware_init开启
+    }
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code == LV_EVENT_SCREEN_LOADED)
+    {
+        audio_app_set_record_preroll(true);
+    }
+    else if (code == LV_EVENT_SCREEN_UNLOADED)
+    {
+        audio_app_set_record_preroll(false);
+    }
+}
+
 // 录音按钮事件回调
 static void record_btn_event_handler(lv_event_t *e)
 {
@@ -156,6 +236,10 @@ static void record_btn_event_handler(lv_event_t *e)
             // 更新UI
             lv_label_set_text(label, "start");
             lv_obj_set_style_bg_color(btn, lv_color_hex(0x3B82F6), LV_PART_MAIN); // 恢复蓝色
+            if (s_record_wave_timer != NULL)
+            {
+                lv_timer_resume(s_record_wave_timer); // 保存完成后显示波形
+            }
             ESP_LOGI(TAG, "用户点击: 停止录音");
         }
         else
@@ -168,8 +252,9 @@ static void record_btn_event_handler(lv_event_t *e)
                      now_time.year, now_time.month, now_time.day,
                      now_time.hour, now_time.min, now_time.sec);
 
-            if (audio_app_start_record(filename) == ESP_OK)
+            if (audio_app_start_record(filename, AUDIO_RECORD_FORMAT_ADPCM_16K_MONO) == ESP_OK)
             {
+                snprintf(s_record_last, sizeof(s_record_last), "%s", filename);
                 // 更新UI
                 lv_label_set_text(label, "stop");
                 lv_obj_set_style_bg_color(btn, lv_color_hex(0xFF0000), LV_PART_MAIN); // 变为红色
@@ -205,4 +290,21 @@ void lvgl_bottomr_init(void)
 
     // 添加事件处理
     lv_obj_add_event_cb(btn, record_btn_event_handler, LV_EVENT_CLICKED, NULL);
+
+    // 预录只在录音界面显示期间开启; 按钮创建在当前屏幕上, 现在就开启
+    lv_obj_add_event_cb(scr, record_screen_event_handler, LV_EVENT_SCREEN_LOADED, NULL);
+    lv_obj_add_event_cb(scr, record_screen_event_handler, LV_EVENT_SCREEN_UNLOADED, NULL);
+    if (!AUDIO_RECORD_PREROLL_DEFAULT)
+    {
+        audio_app_set_record_preroll(true);
+    }
+
+    // 按钮下方显示最近一次录音的波形, 可左右拖动浏览
+    s_record_wave = waveform_widget_create(scr, 300, 80);
+    if (s_record_wave != NULL)
+    {
+        lv_obj_align_to(s_record_wave, btn, LV_ALIGN_OUT_BOTTOM_MID, 0, 20);
+        s_record_wave_timer = lv_timer_create(record_wave_poll_cb, WAVEFORM_WIDGET_POLL_MS, NULL);
+        lv_timer_pause(s_record_wave_timer);
+    }
 }
@@ -1,10 +1,14 @@
 #ifndef LVGL_TASK_H
 #define LVGL_TASK_H
 
+#include "esp_err.h"
 #include "gui_guider.h"  // guider_ui的定义在这里
 
+#define LVGL_TASK_START_TIMEOUT_MS (10 * 1000) // 等待界面创建完成的最长时间
+
 extern lv_ui guider_ui;
 
 void lvgl_task(void* pvParameter);
+esp_err_t lvgl_task_start(void); // 启动阶段ui: 创建lvgl_task并等待界面创建完成
 
 #endif // LVGL_TASK_H
\ No newline at end of file
@@ -10,26 +10,54 @@
 #include "get_time.h"
 #include "clock_functions.h"
 #include "mp3_player.h"
+
+extern TaskHandle_t lvgl_time_handle;
 static const char *TAG = "audio_example";
-void time_and_weather(void *pvParameters)
+
+/**
+ * @brief 启动阶段sntp: 启动SNTP并等待第一次同步 (后台, 没有网络时一直等待)
+ */
+esp_err_t time_sntp_stage(void *arg)
 {
     esp_wait_sntp_sync(); // 初始SNTP同步,确保时间准确
+    return ESP_OK;
+}
 
-    // 4. 初始化MP3播放器
+/**
+ * @brief 启动阶段player: 初始化MP3播放器并播放开机提示音
+ */
+esp_err_t time_player_stage(void *arg)
+{
     esp_err_t ret = mp3_player_init();
     if (ret != ESP_OK)
     {
         ESP_LOGE(TAG, "MP3播放器初始化失败: %d", ret);
+        return ret;
     }
-    else
-    {
-        ESP_LOGI(TAG, "MP3播放器初始化成功");
-    }
+    ESP_LOGI(TAG, "MP3播放器初始化成功");
 
     vTaskDelay(pdMS_TO_TICKS(100));
 
     mp3_player_play_file("/sdcard/mp3/qing.mp3"); // 播放MP3
+    return ESP_OK;
+}
 
+/**
+ * @brief 启动阶段clock: 创建时间更新任务
+ */
+esp_err_t time_clock_stage(void *arg)
+{
+    // 不等待SNTP: 先设置时区, 同步之前显示的是按本地时区换算的未校准时间, 同步后自动校正
+    get_time_set_timezone();
+    if (xTaskCreatePinnedToCore(time_and_weather, "time", 1024 * 4, NULL, 6, &lvgl_time_handle, 0) != pdPASS)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void time_and_weather(void *pvParameters)
+{
     uint32_t time_update_counter = 0; // 时间更新计数器
     while (1)
     {
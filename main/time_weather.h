@@ -1,6 +1,13 @@
 #ifndef TIME_WEATHER_H
 #define TIME_WEATHER_H
 
+#include "esp_err.h"
+
 void time_and_weather(void* pvParameters);
 
+// 启动阶段 (boot_manager), arg未使用
+esp_err_t time_sntp_stage(void *arg);   // 启动SNTP并等待第一次同步
+esp_err_t time_player_stage(void *arg); // 初始化MP3播放器并播放开机提示音
+esp_err_t time_clock_stage(void *arg);  // 创建时间更新任务
+
 #endif // TIME_WEATHER_H
\ No newline at end of file
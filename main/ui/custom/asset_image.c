@@ -0,0 +1,28 @@
+/*
+ * 资源包图片
+ * 把资源包中IMAGE类型的索引项转换成lv_image_dsc_t
+ */
+
+#include "asset_image.h"
+#include "asset_pack.h"
+
+bool asset_image_get(const char *name, lv_image_dsc_t *dsc)
+{
+    asset_pack_asset_t asset;
+    if (asset_pack_find(name, &asset) != ESP_OK || asset.entry->type != ASSET_PACK_TYPE_IMAGE)
+    {
+        return false;
+    }
+
+    const asset_pack_entry_t *e = asset.entry;
+    lv_memzero(dsc, sizeof(*dsc));
+    dsc->header.magic = LV_IMAGE_HEADER_MAGIC;
+    dsc->header.w = e->meta[0] & 0xFFFF;
+    dsc->header.h = e->meta[0] >> 16;
+    dsc->header.cf = e->meta[1] & 0xFF;
+    dsc->header.stride = e->meta[1] >> 16;
+    dsc->header.flags = e->meta[2] & 0xFFFF;
+    dsc->data = asset.data;
+    dsc->data_size = asset.size;
+    return true;
+}
@@ -0,0 +1,31 @@
+#ifndef __ASSET_IMAGE_H_
+#define __ASSET_IMAGE_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "lvgl.h"
+
+    /**
+     * 资源包图片
+     * -----------------------------------------------------------------------------
+     * - 像素数据直接指向映射的flash, 不解码、不拷贝, LVGL按变量图片绘制
+     * - 资源包在启动时由audio_app_init()映射, 之后一直有效
+     */
+
+    /**
+     * 从资源包取图片描述
+     *
+     * @param name 资源名称 (打包目录中的相对路径去掉扩展名, 例如 "icons/wifi")
+     * @param dsc 输出图片描述, 调用者保存 (lv_image_set_src只保存指针)
+     * @return true 找到, false 资源包未映射或不是图片
+     */
+    bool asset_image_get(const char *name, lv_image_dsc_t *dsc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ASSET_IMAGE_H_ */
@@ -0,0 +1,98 @@
+/*
+ * 音乐频谱控件
+ * 负责把audio_spectrum的分析结果画成柱状图
+ * -----------------------------------------------------------------------------
+ * 设计原则：音频路径从不等待UI
+ * - 数据来自单槽邮箱, 读不到新帧就保持上一帧
+ * - 每帧只更新高度变化的柱子, 减少重绘面积
+ */
+
+#include "spectrum_widget.h"
+#include "audio_spectrum.h"
+
+typedef struct
+{
+    lv_obj_t *bars[AUDIO_SPECTRUM_BARS];
+    int32_t heights[AUDIO_SPECTRUM_BARS]; // 当前显示的柱高, 用于判断是否需要更新
+    int32_t max_height;
+    uint32_t last_seq;
+    lv_timer_t *timer;
+} spectrum_widget_t;
+
+/**
+ * 定时刷新回调 (LVGL任务中执行)
+ */
+static void spectrum_widget_timer_cb(lv_timer_t *timer)
+{
+    spectrum_widget_t *w = (spectrum_widget_t *)lv_timer_get_user_data(timer);
+    audio_spectrum_frame_t frame;
+
+    if (!lv_obj_is_visible(lv_obj_get_parent(w->bars[0])))
+    {
+        return; // 不可见时不刷新
+    }
+    if (!audio_spectrum_read(&frame, w->last_seq))
+    {
+        return; // 没有新帧
+    }
+    w->last_seq = frame.seq;
+
+    for (int i = 0; i < AUDIO_SPECTRUM_BARS; i++)
+    {
+        int32_t h = frame.bars[i] * w->max_height / 100;
+        if (h < SPECTRUM_WIDGET_MIN_BAR_H)
+        {
+            h = SPECTRUM_WIDGET_MIN_BAR_H;
+        }
+        if (h != w->heights[i])
+        {
+            w->heights[i] = h;
+            lv_obj_set_height(w->bars[i], h);
+        }
+    }
+}
+
+/**
+ * 容器删除时停止定时器并释放上下文
+ */
+static void spectrum_widget_delete_cb(lv_event_t *e)
+{
+    spectrum_widget_t *w = (spectrum_widget_t *)lv_event_get_user_data(e);
+    lv_timer_delete(w->timer);
+    lv_free(w);
+}
+
+lv_obj_t *spectrum_widget_create(lv_obj_t *parent, int32_t width, int32_t height)
+{
+    spectrum_widget_t *w = lv_malloc_zeroed(sizeof(spectrum_widget_t));
+    if (w == NULL)
+    {
+        return NULL;
+    }
+    w->max_height = height;
+
+    // 透明容器, 不响应点击和滚动, 不影响下层的滑动手势
+    lv_obj_t *cont = lv_obj_create(parent);
+    lv_obj_remove_style_all(cont);
+    lv_obj_set_size(cont, width, height);
+    lv_obj_remove_flag(cont, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+
+    int32_t bar_w = (width - SPECTRUM_WIDGET_BAR_GAP * (AUDIO_SPECTRUM_BARS - 1)) / AUDIO_SPECTRUM_BARS;
+    for (int i = 0; i < AUDIO_SPECTRUM_BARS; i++)
+    {
+        lv_obj_t *bar = lv_obj_create(cont);
+        lv_obj_remove_style_all(bar);
+        lv_obj_remove_flag(bar, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+        lv_obj_set_size(bar, bar_w, SPECTRUM_WIDGET_MIN_BAR_H);
+        lv_obj_align(bar, LV_ALIGN_BOTTOM_LEFT, i * (bar_w + SPECTRUM_WIDGET_BAR_GAP), 0);
+        lv_obj_set_style_bg_opa(bar, 200, LV_PART_MAIN | LV_STATE_DEFAULT);
+        lv_obj_set_style_bg_color(bar, lv_color_hex(0xffffff), LV_PART_MAIN | LV_STATE_DEFAULT);
+        lv_obj_set_style_radius(bar, 2, LV_PART_MAIN | LV_STATE_DEFAULT);
+        w->bars[i] = bar;
+        w->heights[i] = SPECTRUM_WIDGET_MIN_BAR_H;
+    }
+
+    w->timer = lv_timer_create(spectrum_widget_timer_cb, SPECTRUM_WIDGET_PERIOD_MS, w);
+    lv_obj_add_event_cb(cont, spectrum_widget_delete_cb, LV_EVENT_DELETE, w);
+    return cont;
+}
@@ -0,0 +1,37 @@
+#ifndef __SPECTRUM_WIDGET_H_
+#define __SPECTRUM_WIDGET_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "lvgl.h"
+
+#define SPECTRUM_WIDGET_PERIOD_MS (33) // 刷新周期, 最高约30fps
+#define SPECTRUM_WIDGET_BAR_GAP (4)    // 柱间距(像素)
+#define SPECTRUM_WIDGET_MIN_BAR_H (2)  // 静音时的最小柱高
+
+    /**
+     * 音乐频谱控件
+     * -----------------------------------------------------------------------------
+     * - 从audio_spectrum的邮箱读取最新一帧, 读取不阻塞
+     * - 只修改高度变化了的柱子, LVGL只重绘这些柱子所在的区域
+     * - 控件不可见(例如切到其他页面)时跳过刷新
+     */
+
+    /**
+     * 创建频谱控件
+     *
+     * @param parent 父对象
+     * @param width 宽度
+     * @param height 高度 (柱子的最大高度)
+     * @return lv_obj_t* 控件容器, 删除容器时自动停止刷新
+     */
+    lv_obj_t *spectrum_widget_create(lv_obj_t *parent, int32_t width, int32_t height);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SPECTRUM_WIDGET_H_ */
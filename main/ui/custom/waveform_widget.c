@@ -0,0 +1,361 @@
+/*
+ * 录音波形控件
+ * 负责把audio_peaks的峰值文件画成min/max波形
+ * -----------------------------------------------------------------------------
+ * 设计原则：UI任务从不读取音频数据
+ * - 显示只读取峰值文件中可见范围附近的几KB, 拖动在列缓存内时不访问SD卡
+ * - 峰值文件需要生成时交给后台任务, UI任务只轮询结果
+ */
+
+#include "waveform_widget.h"
+#include <string.h>
+#include <stdatomic.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "audio_peaks.h"
+
+static const char *TAG = "waveform_widget";
+
+// 后台生成任务的状态: 任务结束或控件删除时, 后到的一方释放任务描述
+enum
+{
+    WAVEFORM_GEN_RUNNING = 1,
+    WAVEFORM_GEN_OK,
+    WAVEFORM_GEN_FAILED,
+    WAVEFORM_GEN_ORPHANED, // 控件已删除, 任务结束时自行释放
+};
+
+typedef struct
+{
+    atomic_int state;
+    char path[128];
+} waveform_gen_job_t;
+
+typedef struct
+{
+    lv_obj_t *obj;
+    int32_t width;
+    char path[128];
+    audio_peaks_t *peaks;
+    audio_peaks_info_t info;
+    uint32_t spp;   // 每像素采样数
+    uint32_t start; // 最左侧像素的采样位置
+
+    // 列缓存: 第i列对应 cache_start + i * cache_spp 开始的cache_spp个采样
+    int8_t *cache_min;
+    int8_t *cache_max;
+    int32_t cache_cols;
+    uint32_t cache_start;
+    uint32_t cache_spp;
+    bool cache_valid;
+
+    // 拖动
+    int32_t drag_x;
+    uint32_t drag_start;
+
+    waveform_gen_job_t *job;
+    lv_timer_t *timer;
+} waveform_widget_t;
+
+/**
+ * 后台生成峰值文件 (只访问任务描述, 不访问控件)
+ */
+static void waveform_gen_task(void *arg)
+{
+    waveform_gen_job_t *job = (waveform_gen_job_t *)arg;
+    int result = audio_peaks_generate(job->path) == ESP_OK ? WAVEFORM_GEN_OK : WAVEFORM_GEN_FAILED;
+
+    int expected = WAVEFORM_GEN_RUNNING;
+    if (!atomic_compare_exchange_strong(&job->state, &expected, result))
+    {
+        lv_free(job); // 控件已删除
+    }
+    vTaskDelete(NULL);
+}
+
+/**
+ * 放弃正在进行的生成任务 (任务结束后自行释放)
+ */
+static void waveform_release_job(waveform_widget_t *w)
+{
+    if (w->job == NULL)
+    {
+        return;
+    }
+    int expected = WAVEFORM_GEN_RUNNING;
+    if (!atomic_compare_exchange_strong(&w->job->state, &expected, WAVEFORM_GEN_ORPHANED))
+    {
+        lv_free(w->job); // 任务已结束
+    }
+    w->job = NULL;
+}
+
+static uint32_t waveform_max_start(const waveform_widget_t *w)
+{
+    uint64_t visible = (uint64_t)w->spp * w->width;
+    return w->info.total_samples > visible ? (uint32_t)(w->info.total_samples - visible) : 0;
+}
+
+/**
+ * 确保可见范围在列缓存内, 否则以可见范围为中心重新读取
+ */
+static void waveform_ensure_cache(waveform_widget_t *w)
+{
+    if (w->peaks == NULL)
+    {
+        return;
+    }
+    if (w->cache_valid && w->cache_spp == w->spp && w->start >= w->cache_start &&
+        (w->start - w->cache_start) % w->spp == 0 &&
+        (w->start - w->cache_start) / w->spp + w->width <= (uint32_t)w->cache_cols)
+    {
+        return;
+    }
+
+    // 左侧多缓存一屏 (不超过文件开头), 起点与当前位置对齐到整列
+    uint32_t left_cols = w->start / w->spp;
+    left_cols = left_cols < (uint32_t)w->width ? left_cols : (uint32_t)w->width;
+    w->cache_start = w->start - left_cols * w->spp;
+    w->cache_spp = w->spp;
+    w->cache_valid = audio_peaks_read(w->peaks, w->cache_start, w->spp, w->cache_cols, w->cache_min, w->cache_max) == ESP_OK;
+}
+
+/**
+ * 绘制: 每个像素一列, 从中线向上画到最大值、向下画到最小值
+ */
+static void waveform_draw_cb(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_target(e);
+    waveform_widget_t *w = (waveform_widget_t *)lv_obj_get_user_data(obj);
+    if (w->peaks == NULL || !w->cache_valid)
+    {
+        return;
+    }
+
+    lv_layer_t *layer = lv_event_get_layer(e);
+    lv_area_t coords;
+    lv_obj_get_coords(obj, &coords);
+    int32_t half = lv_area_get_height(&coords) / 2;
+    int32_t mid = coords.y1 + half;
+
+    lv_draw_rect_dsc_t dsc;
+    lv_draw_rect_dsc_init(&dsc);
+    dsc.bg_color = lv_color_hex(0x3B82F6);
+    dsc.bg_opa = LV_OPA_COVER;
+
+    int32_t first = (int32_t)((w->start - w->cache_start) / w->spp);
+    for (int32_t x = 0; x < w->width; x++)
+    {
+        int8_t mn = w->cache_min[first + x];
+        int8_t mx = w->cache_max[first + x];
+        if (mn == 0 && mx == 0)
+        {
+            continue;
+        }
+        lv_area_t col = {
+            .x1 = coords.x1 + x,
+            .x2 = coords.x1 + x,
+            .y1 = mid - mx * half / 128,
+            .y2 = mid - mn * half / 128,
+        };
+        lv_draw_rect(layer, &dsc, &col);
+    }
+}
+
+/**
+ * 拖动浏览: 按下时记录起点, 拖动时按像素换算采样位置
+ */
+static void waveform_input_cb(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_target(e);
+    waveform_widget_t *w = (waveform_widget_t *)lv_obj_get_user_data(obj);
+    lv_point_t point;
+    lv_indev_get_point(lv_indev_active(), &point);
+
+    if (lv_event_get_code(e) == LV_EVENT_PRESSED)
+    {
+        w->drag_x = point.x;
+        w->drag_start = w->start;
+        return;
+    }
+
+    int64_t target = (int64_t)w->drag_start - (int64_t)(point.x - w->drag_x) * w->spp;
+    target = target < 0 ? 0 : target;
+    target = target > waveform_max_start(w) ? waveform_max_start(w) : target;
+    if ((uint32_t)target != w->start)
+    {
+        w->start = (uint32_t)target;
+        waveform_ensure_cache(w);
+        lv_obj_invalidate(obj);
+    }
+}
+
+/**
+ * 轮询后台生成结果 (LVGL任务中执行)
+ */
+static void waveform_poll_cb(lv_timer_t *timer)
+{
+    waveform_widget_t *w = (waveform_widget_t *)lv_timer_get_user_data(timer);
+    if (w->job == NULL)
+    {
+        lv_timer_pause(timer);
+        return;
+    }
+
+    int state = atomic_load(&w->job->state);
+    if (state == WAVEFORM_GEN_RUNNING)
+    {
+        return;
+    }
+    lv_free(w->job);
+    w->job = NULL;
+    lv_timer_pause(timer);
+
+    if (state == WAVEFORM_GEN_OK && audio_peaks_open(w->path, &w->peaks) == ESP_OK)
+    {
+        audio_peaks_get_info(w->peaks, &w->info);
+        waveform_widget_set_zoom(w->obj, 0);
+    }
+    else
+    {
+        ESP_LOGW(TAG, "无法生成峰值文件: %s", w->path);
+    }
+}
+
+/**
+ * 控件删除时关闭峰值文件并释放上下文
+ */
+static void waveform_delete_cb(lv_event_t *e)
+{
+    waveform_widget_t *w = (waveform_widget_t *)lv_event_get_user_data(e);
+    lv_timer_delete(w->timer);
+    waveform_release_job(w);
+    audio_peaks_close(w->peaks);
+    lv_free(w->cache_min);
+    lv_free(w->cache_max);
+    lv_free(w);
+}
+
+lv_obj_t *waveform_widget_create(lv_obj_t *parent, int32_t width, int32_t height)
+{
+    waveform_widget_t *w = lv_malloc_zeroed(sizeof(waveform_widget_t));
+    if (w == NULL)
+    {
+        return NULL;
+    }
+    w->width = width;
+    w->cache_cols = width * WAVEFORM_WIDGET_CACHE_SCREENS;
+    w->cache_min = lv_malloc(w->cache_cols);
+    w->cache_max = lv_malloc(w->cache_cols);
+    if (w->cache_min == NULL || w->cache_max == NULL)
+    {
+        lv_free(w->cache_min);
+        lv_free(w->cache_max);
+        lv_free(w);
+        return NULL;
+    }
+    w->spp = 1;
+
+    // 可拖动, 但不滚动父容器, 也不触发页面切换手势
+    lv_obj_t *obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(obj);
+    lv_obj_set_size(obj, width, height);
+    lv_obj_add_flag(obj, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_remove_flag(obj, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_SCROLL_CHAIN_HOR | LV_OBJ_FLAG_SCROLL_CHAIN_VER |
+                                LV_OBJ_FLAG_GESTURE_BUBBLE);
+    lv_obj_set_user_data(obj, w);
+    w->obj = obj;
+
+    w->timer = lv_timer_create(waveform_poll_cb, WAVEFORM_WIDGET_POLL_MS, w);
+    lv_timer_pause(w->timer);
+    lv_obj_add_event_cb(obj, waveform_draw_cb, LV_EVENT_DRAW_MAIN, NULL);
+    lv_obj_add_event_cb(obj, waveform_input_cb, LV_EVENT_PRESSED, NULL);
+    lv_obj_add_event_cb(obj, waveform_input_cb, LV_EVENT_PRESSING, NULL);
+    lv_obj_add_event_cb(obj, waveform_delete_cb, LV_EVENT_DELETE, w);
+    return obj;
+}
+
+bool waveform_widget_set_file(lv_obj_t *obj, const char *wav_path)
+{
+    waveform_widget_t *w = (waveform_widget_t *)lv_obj_get_user_data(obj);
+    if (w == NULL || wav_path == NULL || strlen(wav_path) >= sizeof(w->path))
+    {
+        return false;
+    }
+
+    waveform_release_job(w);
+    audio_peaks_close(w->peaks);
+    w->peaks = NULL;
+    w->cache_valid = false;
+    memset(&w->info, 0, sizeof(w->info));
+    strcpy(w->path, wav_path);
+    lv_obj_invalidate(obj);
+
+    if (audio_peaks_open(wav_path, &w->peaks) == ESP_OK)
+    {
+        audio_peaks_get_info(w->peaks, &w->info);
+        waveform_widget_set_zoom(obj, 0);
+        return true;
+    }
+
+    // 峰值文件不存在或已过期: 后台生成, 完成后由定时器打开
+    waveform_gen_job_t *job = lv_malloc_zeroed(sizeof(waveform_gen_job_t));
+    if (job == NULL)
+    {
+        return false;
+    }
+    strcpy(job->path, wav_path);
+    atomic_store(&job->state, WAVEFORM_GEN_RUNNING);
+    if (xTaskCreate(waveform_gen_task, "wave_gen", WAVEFORM_WIDGET_GEN_STACK, job, WAVEFORM_WIDGET_GEN_PRIORITY, NULL) != pdPASS)
+    {
+        lv_free(job);
+        return false;
+    }
+    w->job = job;
+    lv_timer_resume(w->timer);
+    return true;
+}
+
+void waveform_widget_set_zoom(lv_obj_t *obj, uint32_t samples_per_px)
+{
+    waveform_widget_t *w = (waveform_widget_t *)lv_obj_get_user_data(obj);
+    if (w == NULL)
+    {
+        return;
+    }
+
+    if (samples_per_px == 0)
+    {
+        // 整个文件占满宽度
+        samples_per_px = (w->info.total_samples + w->width - 1) / w->width;
+        w->start = 0;
+    }
+    else
+    {
+        uint64_t center = w->start + (uint64_t)w->spp * w->width / 2;
+        uint64_t half = (uint64_t)samples_per_px * w->width / 2;
+        w->start = center > half ? (uint32_t)(center - half) : 0;
+    }
+    w->spp = samples_per_px > 0 ? samples_per_px : 1;
+    waveform_widget_set_position(obj, w->start);
+}
+
+void waveform_widget_set_position(lv_obj_t *obj, uint32_t sample)
+{
+    waveform_widget_t *w = (waveform_widget_t *)lv_obj_get_user_data(obj);
+    if (w == NULL)
+    {
+        return;
+    }
+    uint32_t max_start = waveform_max_start(w);
+    w->start = sample > max_start ? max_start : sample;
+    waveform_ensure_cache(w);
+    lv_obj_invalidate(obj);
+}
+
+uint32_t waveform_widget_get_position(lv_obj_t *obj)
+{
+    waveform_widget_t *w = (waveform_widget_t *)lv_obj_get_user_data(obj);
+    return w != NULL ? w->start : 0;
+}
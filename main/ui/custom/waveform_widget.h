@@ -0,0 +1,71 @@
+#ifndef __WAVEFORM_WIDGET_H_
+#define __WAVEFORM_WIDGET_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lvgl.h"
+
+#define WAVEFORM_WIDGET_CACHE_SCREENS (3)  // 列缓存覆盖的屏数 (左右各多缓存一屏)
+#define WAVEFORM_WIDGET_POLL_MS (200)      // 等待后台生成峰值文件的轮询周期
+#define WAVEFORM_WIDGET_GEN_STACK (4096)   // 生成任务的栈大小
+#define WAVEFORM_WIDGET_GEN_PRIORITY (2)   // 生成任务优先级 (低于录音写入任务)
+
+    /**
+     * 录音波形控件
+     * -----------------------------------------------------------------------------
+     * - 只读取录音旁边的峰值文件(.pk), 不读取音频数据, 30分钟的录音也能立即显示和拖动
+     * - 按缩放倍数从峰值文件中选择合适的级别, 一次读取左右各多一屏的列, 屏内拖动不访问SD卡
+     * - 峰值文件不存在或与录音不一致时, 在后台低优先级任务中生成, 生成完成后自动显示
+     * - 左右拖动浏览, 拖动时不会触发页面切换手势
+     */
+
+    /**
+     * 创建波形控件
+     *
+     * @param parent 父对象
+     * @param width 宽度 (每个像素一列)
+     * @param height 高度
+     * @return lv_obj_t* 控件对象, 删除时自动关闭峰值文件
+     */
+    lv_obj_t *waveform_widget_create(lv_obj_t *parent, int32_t width, int32_t height);
+
+    /**
+     * 显示一个录音文件, 默认缩放到整个文件正好占满宽度
+     *
+     * @param obj 控件对象
+     * @param wav_path 录音路径 (例如 "/sdcard/record/20250101_120000.wav")
+     * @return true 已显示或已开始后台生成; false 路径无效或内存不足
+     */
+    bool waveform_widget_set_file(lv_obj_t *obj, const char *wav_path);
+
+    /**
+     * 设置缩放, 保持视图中心不变
+     *
+     * @param obj 控件对象
+     * @param samples_per_px 每个像素的采样数, 0表示整个文件占满宽度
+     */
+    void waveform_widget_set_zoom(lv_obj_t *obj, uint32_t samples_per_px);
+
+    /**
+     * 设置最左侧像素对应的采样位置
+     *
+     * @param obj 控件对象
+     * @param sample 采样位置 (超出时限制在末尾)
+     */
+    void waveform_widget_set_position(lv_obj_t *obj, uint32_t sample);
+
+    /**
+     * 获取最左侧像素对应的采样位置
+     */
+    uint32_t waveform_widget_get_position(lv_obj_t *obj);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __WAVEFORM_WIDGET_H_ */
@@ -0,0 +1,77 @@
+/*
+ * 天气显示模块
+ * 负责主界面上的天气标签
+ * -----------------------------------------------------------------------------
+ * 设计原则：高内聚、低耦合
+ * - 只接收显示用的字符串, 不依赖天气数据结构
+ * - 标签由本模块创建和持有, 不修改GUI Guider生成的代码
+ */
+
+#include "weather_functions.h"
+#include "lvgl.h"
+#include "gui_guider.h"
+#include <stdio.h>
+#include <string.h>
+
+static lv_obj_t *s_weather_label = NULL;
+
+/**
+ * 创建天气标签 (调用时持有LVGL锁)
+ *
+ * @return 标签, 主界面尚未创建时返回NULL
+ */
+static lv_obj_t *weather_label_get(void)
+{
+    if (s_weather_label != NULL && lv_obj_is_valid(s_weather_label))
+    {
+        return s_weather_label;
+    }
+    if (guider_ui.screen_main_cont_1 == NULL || !lv_obj_is_valid(guider_ui.screen_main_cont_1))
+    {
+        return NULL;
+    }
+    // 位于数字时钟(95, 96, 251x60)下方, 宽度与时钟相同
+    s_weather_label = lv_label_create(guider_ui.screen_main_cont_1);
+    lv_obj_set_pos(s_weather_label, 95, 160);
+    lv_obj_set_size(s_weather_label, 251, 24);
+    lv_obj_set_style_text_font(s_weather_label, &lv_font_montserratMedium_16, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_text_color(s_weather_label, lv_color_hex(0xffffff), LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_text_align(s_weather_label, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_label_set_text(s_weather_label, "");
+    return s_weather_label;
+}
+
+/**
+ * 更新天气显示
+ *
+ * 功能说明：
+ * - 温度 + 数据更新时间(时:分), 例如"28 C  15:37"
+ * - 待刷新的数据以半透明显示
+ */
+void update_weather_display(const char *temperature, const char *last_update, bool stale)
+{
+    // 格式化显示字符串（数据处理层）
+    char buf[32] = "";
+    if (temperature != NULL)
+    {
+        // "2025-09-05T15:37:36+08:00"中的"15:37"
+        if (last_update != NULL && strlen(last_update) >= 16)
+        {
+            snprintf(buf, sizeof(buf), "%s C  %.5s", temperature, last_update + 11);
+        }
+        else
+        {
+            snprintf(buf, sizeof(buf), "%s C", temperature);
+        }
+    }
+
+    lv_lock();
+    // 更新天气标签（UI层）
+    lv_obj_t *label = weather_label_get();
+    if (label != NULL)
+    {
+        lv_label_set_text(label, buf);
+        lv_obj_set_style_text_opa(label, stale ? LV_OPA_50 : LV_OPA_COVER, LV_PART_MAIN | LV_STATE_DEFAULT);
+    }
+    lv_unlock();
+}
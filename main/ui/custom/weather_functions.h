@@ -0,0 +1,35 @@
+#ifndef __WEATHER_FUNCTIONS_H_
+#define __WEATHER_FUNCTIONS_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+
+    /**
+     * 天气显示模块接口
+     * -----------------------------------------------------------------------------
+     * 主界面数字时钟下方的一行天气 (温度和数据更新时间), 标签在第一次更新时创建。
+     * 界面字体只有ASCII字符, 不显示城市和天气文字。
+     */
+
+    /**
+     * 更新天气显示
+     *
+     * @param temperature 温度字符串, NULL时隐藏天气
+     * @param last_update ISO 8601格式的数据更新时间, 例如"2025-09-05T15:37:36+08:00", 可为NULL
+     * @param stale 数据已过新鲜期 (来自缓存、正在等待刷新), 以半透明显示
+     *
+     * 功能特性：
+     * - 线程安全设计 (内部加LVGL锁)
+     * - 主界面尚未创建时不做任何事
+     */
+    void update_weather_display(const char *temperature, const char *last_update, bool stale);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __WEATHER_FUNCTIONS_H_ */
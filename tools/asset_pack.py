@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""audio分区资源包打包工具 (布局见 components/asset_pack/include/asset_pack.h)
+
+    python tools/asset_pack.py build audio_data -o build/audio_pack.bin
+    python tools/asset_pack.py list build/audio_pack.bin
+    parttool.py -p COM3 write_partition --partition-name=audio --input build/audio_pack.bin
+
+目录中的文件按扩展名处理, 资源名称是相对路径去掉扩展名 (例如 icons/wifi.bin -> "icons/wifi"):
+  .wav        16位PCM, 转换为48kHz立体声并补齐到混音块 (与audio_mixer_effect_load相同的线性插值)
+  .bin        LVGL 9 图片 (LVGLImage.py生成), 图片头拆到索引中, 只保存像素数据
+  .ttf .otf .fnt  字体, 原样保存
+  其他        原样保存
+"""
+
+import argparse
+import os
+import struct
+import sys
+import wave
+import zlib
+
+MAGIC = 0x4B415041  # "APAK"
+VERSION = 1
+ALIGN = 64
+NAME_MAX = 36
+HEADER_FMT = "<IHHIIIII36x"
+ENTRY_FMT = "<36sHHII3II"
+HEADER_SIZE = struct.calcsize(HEADER_FMT)
+ENTRY_SIZE = struct.calcsize(ENTRY_FMT)
+
+TYPE_RAW, TYPE_PCM, TYPE_IMAGE, TYPE_FONT = 0, 1, 2, 3
+TYPE_NAMES = {TYPE_RAW: "raw", TYPE_PCM: "pcm", TYPE_IMAGE: "image", TYPE_FONT: "font"}
+
+MIXER_RATE = 48000
+MIXER_BLOCK_FRAMES = 240  # AUDIO_MIXER_BLOCK_FRAMES
+LV_IMAGE_HEADER_MAGIC = 0x19
+LV_IMAGE_HEADER_SIZE = 12
+
+assert HEADER_SIZE == 64 and ENTRY_SIZE == 64
+
+
+def align_up(n, a=ALIGN):
+    return (n + a - 1) // a * a
+
+
+def convert_wav(path):
+    """返回 (48kHz立体声PCM字节, 输出帧数, 原采样率, 原声道数)"""
+    with wave.open(path, "rb") as w:
+        channels, width, rate = w.getnchannels(), w.getsampwidth(), w.getframerate()
+        raw = w.readframes(w.getnframes())
+    if width != 2 or channels not in (1, 2):
+        raise ValueError(f"{path}: 只支持16位单声道/立体声PCM")
+
+    in_frames = len(raw) // (2 * channels)
+    samples = struct.unpack(f"<{in_frames * channels}h", raw[: in_frames * channels * 2])
+    out_frames = in_frames * MIXER_RATE // rate
+    if out_frames == 0:
+        raise ValueError(f"{path}: 没有音频数据")
+
+    step = (rate << 16) // MIXER_RATE
+    out = []
+    phase = 0
+    for _ in range(out_frames):
+        idx = phase >> 16
+        frac = phase & 0xFFFF
+        nxt = idx + 1 if idx + 1 < in_frames else idx
+        for c in range(2):
+            sc = 0 if channels == 1 else c
+            a = samples[idx * channels + sc]
+            b = samples[nxt * channels + sc]
+            out.append(a + (((b - a) * frac) >> 16))
+        phase += step
+
+    padded = align_up(out_frames, MIXER_BLOCK_FRAMES)
+    out.extend([0] * ((padded - out_frames) * 2))
+    return struct.pack(f"<{len(out)}h", *out), padded, rate, channels
+
+
+def convert_image(path):
+    """返回 (像素数据, meta)"""
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < LV_IMAGE_HEADER_SIZE or data[0] != LV_IMAGE_HEADER_MAGIC:
+        raise ValueError(f"{path}: 不是LVGL 9 图片 (文件头magic应为0x19)")
+    _, cf, flags, w, h, stride, _ = struct.unpack("<BBHHHHH", data[:LV_IMAGE_HEADER_SIZE])
+    return data[LV_IMAGE_HEADER_SIZE:], [w | (h << 16), cf | (stride << 16), flags]
+
+
+def load_asset(path):
+    """返回 (类型, 数据, meta, 说明)"""
+    ext = os.path.splitext(path)[1].lower()
+    if ext == ".wav":
+        pcm, frames, rate, channels = convert_wav(path)
+        return TYPE_PCM, pcm, [frames, MIXER_RATE, 2], f"{rate}Hz {channels}ch -> {frames} 帧"
+    if ext == ".bin":
+        pixels, meta = convert_image(path)
+        return TYPE_IMAGE, pixels, meta, f"{meta[0] & 0xFFFF}x{meta[0] >> 16} cf=0x{meta[1] & 0xFF:02x}"
+    with open(path, "rb") as f:
+        data = f.read()
+    kind = TYPE_FONT if ext in (".ttf", ".otf", ".fnt") else TYPE_RAW
+    return kind, data, [0, 0, 0], ""
+
+
+def build(src_dir, out_path, max_size):
+    assets = []
+    for root, dirs, files in os.walk(src_dir):
+        dirs.sort()
+        for fn in sorted(files):
+            if fn.startswith("."):
+                continue
+            path = os.path.join(root, fn)
+            rel = os.path.relpath(path, src_dir).replace(os.sep, "/")
+            name = os.path.splitext(rel)[0]
+            if len(name.encode()) >= NAME_MAX:
+                sys.exit(f"名称过长 (最多{NAME_MAX - 1}字节): {name}")
+            kind, data, meta, note = load_asset(path)
+            assets.append((name.encode(), kind, data, meta, rel, note))
+
+    # 固件按strcmp二分查找, 这里按字节序排序
+    assets.sort(key=lambda a: a[0])
+    for a, b in zip(assets, assets[1:]):
+        if a[0] == b[0]:
+            sys.exit(f"资源名称重复: {a[0].decode()} ({a[4]}, {b[4]})")
+
+    index_offset = HEADER_SIZE
+    offset = align_up(index_offset + ENTRY_SIZE * len(assets))
+    data_offset = offset
+    entries = []
+    blobs = []
+    for name, kind, data, meta, rel, note in assets:
+        entries.append(struct.pack(ENTRY_FMT, name, kind, 0, offset, len(data), *meta, zlib.crc32(data)))
+        blobs.append((offset, data))
+        print(f"  {TYPE_NAMES[kind]:5} {offset:#010x} {len(data):8d}  {name.decode()}  {note}")
+        offset = align_up(offset + len(data))
+    total = offset
+
+    if max_size and total > max_size:
+        sys.exit(f"资源包 {total} 字节, 超过分区大小 {max_size}")
+
+    index = b"".join(entries)
+    header = struct.pack(HEADER_FMT, MAGIC, VERSION, ENTRY_SIZE, len(assets),
+                         index_offset, data_offset, total, zlib.crc32(index))
+    image = bytearray(total)
+    image[0:HEADER_SIZE] = header
+    image[index_offset:index_offset + len(index)] = index
+    for off, data in blobs:
+        image[off:off + len(data)] = data
+
+    with open(out_path, "wb") as f:
+        f.write(image)
+    print(f"{out_path}: {len(assets)} 个资源, {total} 字节")
+
+
+def list_pack(path):
+    with open(path, "rb") as f:
+        image = f.read()
+    magic, version, entry_size, count, index_offset, data_offset, total, index_crc = \
+        struct.unpack_from(HEADER_FMT, image, 0)
+    if magic != MAGIC or version != VERSION or entry_size != ENTRY_SIZE:
+        sys.exit(f"{path}: 不是资源包")
+    index = image[index_offset:index_offset + count * ENTRY_SIZE]
+    ok = zlib.crc32(index) == index_crc
+    print(f"{path}: {count} 个资源, {total} 字节, 索引CRC {'正确' if ok else '错误'}")
+    for i in range(count):
+        name, kind, _, off, size, m0, m1, m2, crc = struct.unpack_from(ENTRY_FMT, index, i * ENTRY_SIZE)
+        good = zlib.crc32(image[off:off + size]) == crc
+        name = name.rstrip(b"\0").decode()
+        print(f"  {TYPE_NAMES.get(kind, kind):5} {off:#010x} {size:8d}  {name}{'' if good else '  CRC错误'}")
+        ok = ok and good
+    return 0 if ok else 1
+
+
+def parse_size(text):
+    text = text.strip().upper()
+    scale = {"K": 1024, "M": 1024 * 1024}.get(text[-1:], 1)
+    return int(text.rstrip("KM"), 0) * scale
+
+
+def main():
+    parser = argparse.ArgumentParser(description="audio分区资源包打包工具")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    p = sub.add_parser("build", help="把目录打包成资源包")
+    p.add_argument("src", help="资源目录")
+    p.add_argument("-o", "--output", required=True, help="输出文件")
+    p.add_argument("--max-size", default="7M", help="分区大小, 超过时报错 (默认7M, 与partitions.csv相同)")
+    p = sub.add_parser("list", help="列出资源包内容并校验CRC")
+    p.add_argument("pack")
+    args = parser.parse_args()
+
+    if args.cmd == "build":
+        build(args.src, args.output, parse_size(args.max_size))
+        return 0
+    return list_pack(args.pack)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
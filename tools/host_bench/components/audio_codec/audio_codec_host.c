@@ -0,0 +1,396 @@
+/**
+ * @file audio_codec_host.c
+ * @brief 主机基准测试用的codec替身实现
+ * @details 接口与components/audio_codec一致, 音量按相同规则折算软件增益,
+ *          模拟音量只记录不生效(输出文件是codec之前的数字信号)。
+ */
+
+#include "audio_codec.h"
+#include "audio_codec_host.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "audio_codec_host";
+
+#define HOST_BYTES_PER_SEC (AUDIO_DEFAULT_SAMPLE_RATE * AUDIO_DEFAULT_CHANNELS * AUDIO_DEFAULT_BITS_PER_SAMPLE / 8)
+
+// 设备句柄只用来区分播放/录音, 不指向实际对象
+static struct esp_codec_dev_t *const s_play_dev = (struct esp_codec_dev_t *)1;
+static struct esp_codec_dev_t *const s_rec_dev = (struct esp_codec_dev_t *)2;
+
+static bool s_initialized = false;
+static bool s_realtime = true;
+static int s_volume = 60;
+static int16_t s_soft_gain_q15 = AUDIO_CODEC_SOFT_GAIN_UNITY;
+static audio_codec_latency_profile_t s_profile = AUDIO_CODEC_DEFAULT_LATENCY_PROFILE;
+static uint32_t s_latency_avg_us[AUDIO_CODEC_LATENCY_MAX]; // 各档位分别累计
+static uint32_t s_latency_max_us[AUDIO_CODEC_LATENCY_MAX];
+static bool s_mixer_active = false;
+
+// 各档位的DMA配置, 与目标板一致
+static const uint32_t s_profile_frames[AUDIO_CODEC_LATENCY_MAX][2] = {
+    [AUDIO_CODEC_LATENCY_INTERACTIVE] = {AUDIO_CODEC_INTERACTIVE_DMA_FRAMES, AUDIO_CODEC_INTERACTIVE_DMA_DESC},
+    [AUDIO_CODEC_LATENCY_BALANCED] = {AUDIO_CODEC_BALANCED_DMA_FRAMES, AUDIO_CODEC_BALANCED_DMA_DESC},
+    [AUDIO_CODEC_LATENCY_MUSIC] = {AUDIO_CODEC_MUSIC_DMA_FRAMES, AUDIO_CODEC_MUSIC_DMA_DESC},
+};
+
+// 播放输出
+static FILE *s_sink_fp = NULL;
+static audio_codec_host_sink_stats_t s_sink_stats;
+static int64_t s_sink_start_us = 0;
+
+// 录音输入
+static FILE *s_source_fp = NULL;
+static uint64_t s_source_bytes = 0;
+static int64_t s_source_start_us = 0;
+
+uint32_t audio_codec_host_crc32(uint32_t crc, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= p[i];
+        for (int b = 0; b < 8; b++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+/**
+ * @brief 当前延迟档位的DMA总缓冲时长
+ */
+static int64_t host_dma_us(void)
+{
+    return (int64_t)s_profile_frames[s_profile][0] * s_profile_frames[s_profile][1] * 1000000LL / AUDIO_DEFAULT_SAMPLE_RATE;
+}
+
+/**
+ * @brief 按实时速度节流: 设备时间超前墙钟超过DMA深度时等待
+ * @param start_us 本次输出/输入开始的时间
+ * @param bytes 已传输的字节数 (含本次)
+ * @return 等待之后设备时间超前墙钟的时长, 即排队中的数据量
+ */
+static int64_t host_pace(int64_t start_us, uint64_t bytes)
+{
+    int64_t due_us = start_us + (int64_t)(bytes * 1000000ULL / HOST_BYTES_PER_SEC);
+    if (!s_realtime)
+    {
+        return 0;
+    }
+    int64_t ahead_us = due_us - esp_timer_get_time() - host_dma_us();
+    if (ahead_us > 0)
+    {
+        vTaskDelay(pdMS_TO_TICKS(ahead_us / 1000) + 1);
+    }
+    int64_t queued_us = due_us - esp_timer_get_time();
+    return queued_us > 0 ? queued_us : 0;
+}
+
+/**
+ * @brief 播放输出: 追加到输出文件并按实时速度节流
+ */
+static void host_sink_write(const void *data, size_t len)
+{
+    if (s_sink_stats.bytes == 0)
+    {
+        s_sink_start_us = esp_timer_get_time();
+    }
+    s_sink_stats.bytes += (uint64_t)len;
+    s_sink_stats.writes++;
+    s_sink_stats.crc32 = audio_codec_host_crc32(s_sink_stats.crc32, data, len);
+    if (s_sink_fp != NULL)
+    {
+        fwrite(data, 1, len, s_sink_fp);
+    }
+
+    uint32_t latency_us = (uint32_t)host_pace(s_sink_start_us, s_sink_stats.bytes);
+    uint32_t *avg = &s_latency_avg_us[s_profile];
+    uint32_t *max = &s_latency_max_us[s_profile];
+    *avg += ((int32_t)latency_us - (int32_t)*avg) >> 4;
+    *max = latency_us > *max ? latency_us : *max;
+}
+
+int esp_codec_dev_write(esp_codec_dev_handle_t codec, void *data, int len)
+{
+    if (codec != s_play_dev || data == NULL || len < 0)
+    {
+        return ESP_CODEC_DEV_INVALID_ARG;
+    }
+    host_sink_write(data, (size_t)len);
+    return ESP_CODEC_DEV_OK;
+}
+
+esp_err_t audio_codec_playback_write(const int16_t *pcm, size_t frames, uint32_t timeout_ms)
+{
+    if (pcm == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_initialized)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    host_sink_write(pcm, frames * AUDIO_DEFAULT_CHANNELS * sizeof(int16_t));
+    return ESP_OK;
+}
+
+/**
+ * @brief 录音输入: 从输入文件循环读取, 没有文件时输出静音
+ */
+static void host_source_read(void *data, size_t len)
+{
+    if (s_source_bytes == 0)
+    {
+        s_source_start_us = esp_timer_get_time();
+    }
+
+    size_t got = 0;
+    if (s_source_fp != NULL)
+    {
+        got = fread(data, 1, len, s_source_fp);
+        if (got < len)
+        {
+            // 到文件末尾后从头循环
+            rewind(s_source_fp);
+            got += fread((uint8_t *)data + got, 1, len - got, s_source_fp);
+        }
+    }
+    memset((uint8_t *)data + got, 0, len - got);
+    s_source_bytes += (uint64_t)len;
+
+    host_pace(s_source_start_us, s_source_bytes);
+}
+
+int esp_codec_dev_read(esp_codec_dev_handle_t codec, void *data, int len)
+{
+    if (codec != s_rec_dev || data == NULL || len < 0)
+    {
+        return ESP_CODEC_DEV_INVALID_ARG;
+    }
+    host_source_read(data, (size_t)len);
+    return ESP_CODEC_DEV_OK;
+}
+
+esp_err_t audio_codec_record_read(void *data, size_t len, uint32_t timeout_ms)
+{
+    if (data == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_initialized)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    host_source_read(data, len);
+    return ESP_OK;
+}
+
+esp_err_t audio_codec_set_latency_profile(audio_codec_latency_profile_t profile)
+{
+    if ((unsigned)profile >= AUDIO_CODEC_LATENCY_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_mixer_active)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // 替身没有DMA, 只改变节流深度
+    s_profile = profile;
+    return ESP_OK;
+}
+
+audio_codec_latency_profile_t audio_codec_get_latency_profile(void)
+{
+    return s_profile;
+}
+
+esp_err_t audio_codec_get_profile_latency_stats(audio_codec_latency_profile_t profile, audio_codec_latency_stats_t *stats)
+{
+    if (stats == NULL || (unsigned)profile >= AUDIO_CODEC_LATENCY_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(stats, 0, sizeof(*stats));
+    stats->profile = profile;
+    stats->dma_frames = s_profile_frames[profile][0];
+    stats->dma_desc_num = s_profile_frames[profile][1];
+    stats->buffer_us = (uint32_t)((uint64_t)stats->dma_frames * stats->dma_desc_num * 1000000ULL / AUDIO_DEFAULT_SAMPLE_RATE);
+    stats->latency_avg_us = s_latency_avg_us[profile];
+    stats->latency_max_us = s_latency_max_us[profile];
+
+    // 按实时速度运行时每个DMA缓冲区对应一次中断
+    if (s_realtime && stats->latency_max_us > 0)
+    {
+        stats->tx_isr_per_sec = AUDIO_DEFAULT_SAMPLE_RATE / stats->dma_frames;
+        stats->rx_isr_per_sec = stats->tx_isr_per_sec;
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_codec_get_latency_stats(audio_codec_latency_stats_t *stats)
+{
+    return audio_codec_get_profile_latency_stats(s_profile, stats);
+}
+
+void audio_codec_playback_set_active(bool active)
+{
+    s_mixer_active = active;
+}
+
+void audio_codec_host_set_realtime(bool realtime)
+{
+    s_realtime = realtime;
+}
+
+esp_err_t audio_codec_host_sink_open(const char *path)
+{
+    audio_codec_host_sink_close();
+    memset(&s_sink_stats, 0, sizeof(s_sink_stats));
+    if (path == NULL)
+    {
+        return ESP_OK;
+    }
+    s_sink_fp = fopen(path, "wb");
+    if (s_sink_fp == NULL)
+    {
+        ESP_LOGE(TAG, "无法创建输出文件: %s", path);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+void audio_codec_host_sink_close(void)
+{
+    if (s_sink_fp != NULL)
+    {
+        fclose(s_sink_fp);
+        s_sink_fp = NULL;
+    }
+}
+
+esp_err_t audio_codec_host_source_open(const char *path)
+{
+    if (s_source_fp != NULL)
+    {
+        fclose(s_source_fp);
+        s_source_fp = NULL;
+    }
+    s_source_bytes = 0;
+    if (path == NULL)
+    {
+        return ESP_OK;
+    }
+    s_source_fp = fopen(path, "rb");
+    if (s_source_fp == NULL)
+    {
+        ESP_LOGE(TAG, "无法打开输入文件: %s", path);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+void audio_codec_host_get_sink_stats(audio_codec_host_sink_stats_t *stats)
+{
+    if (stats != NULL)
+    {
+        *stats = s_sink_stats;
+    }
+}
+
+esp_err_t audio_codec_init(void)
+{
+    s_initialized = true;
+    return audio_codec_set_volume(s_volume);
+}
+
+esp_err_t audio_codec_deinit(void)
+{
+    audio_codec_host_sink_close();
+    audio_codec_host_source_open(NULL);
+    s_initialized = false;
+    return ESP_OK;
+}
+
+esp_codec_dev_handle_t audio_codec_get_playback_dev(void)
+{
+    return s_initialized ? s_play_dev : NULL;
+}
+
+esp_codec_dev_handle_t audio_codec_get_record_dev(void)
+{
+    return s_initialized ? s_rec_dev : NULL;
+}
+
+esp_err_t audio_codec_set_volume(int volume)
+{
+    if (volume < 0 || volume > 100)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_volume = volume;
+
+    // 与目标板相同: 模拟音量取不低于目标的一档, 差值由软件增益补足
+    int analog = (volume + AUDIO_CODEC_ANALOG_VOL_STEP - 1) / AUDIO_CODEC_ANALOG_VOL_STEP * AUDIO_CODEC_ANALOG_VOL_STEP;
+    analog = analog < AUDIO_CODEC_ANALOG_VOL_STEP ? AUDIO_CODEC_ANALOG_VOL_STEP : analog;
+    float db = AUDIO_CODEC_VOL_MIN_DB * (analog - volume) / 100.0f;
+    if (volume == 0)
+    {
+        s_soft_gain_q15 = 0;
+    }
+    else
+    {
+        s_soft_gain_q15 = db >= 0.0f ? AUDIO_CODEC_SOFT_GAIN_UNITY : (int16_t)(powf(10.0f, db / 20.0f) * AUDIO_CODEC_SOFT_GAIN_UNITY);
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_codec_get_volume(int *volume)
+{
+    if (volume == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *volume = s_volume;
+    return ESP_OK;
+}
+
+int16_t audio_codec_get_soft_gain_q15(void)
+{
+    return s_soft_gain_q15;
+}
+
+bool audio_codec_playback_volume_switch(int16_t gain_q15, int16_t *new_gain_q15)
+{
+    // 替身没有模拟音量档位, 音量全部折算在软件增益中, 从不跨档
+    *new_gain_q15 = gain_q15;
+    return false;
+}
+
+esp_err_t audio_codec_set_mute(bool enable)
+{
+    return ESP_OK;
+}
+
+esp_err_t audio_codec_set_pa_enable(bool enable)
+{
+    return ESP_OK;
+}
+
+esp_err_t audio_codec_set_record_gain(float db)
+{
+    return ESP_OK;
+}
+
+esp_err_t audio_codec_set_record_channel_gain(uint16_t channel_mask, float db)
+{
+    return ESP_OK;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file audio_codec_host.h
+ * @brief 主机codec替身的配置与统计
+ * @details 播放设备把写入的PCM追加到输出文件(可选)并计算CRC32;
+ *          录音设备从输入文件(原始48kHz立体声PCM)循环读取, 没有文件时输出静音。
+ *          实时模式下按48kHz立体声的字节速率节流, 模拟I2S DMA的背压,
+ *          缓冲深度跟随audio_codec_set_latency_profile()设置的档位。
+ */
+
+#ifndef AUDIO_CODEC_HOST_H
+#define AUDIO_CODEC_HOST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief 播放输出统计
+     */
+    typedef struct
+    {
+        uint64_t bytes;     // 写入的字节数
+        uint32_t writes;    // 写入次数
+        uint32_t crc32;     // 输出数据的CRC32
+    } audio_codec_host_sink_stats_t;
+
+    /**
+     * @brief 设置节流模式
+     * @param realtime true按实时速度写入/读取, false尽快完成
+     */
+    void audio_codec_host_set_realtime(bool realtime);
+
+    /**
+     * @brief 开始新的输出: 清零统计, 重置节流时钟
+     * @param path 输出文件路径, NULL不保存
+     * @return esp_err_t
+     */
+    esp_err_t audio_codec_host_sink_open(const char *path);
+
+    /**
+     * @brief 关闭输出文件
+     */
+    void audio_codec_host_sink_close(void);
+
+    /**
+     * @brief 设置录音输入文件
+     * @param path 原始PCM文件, NULL输出静音
+     * @return esp_err_t
+     */
+    esp_err_t audio_codec_host_source_open(const char *path);
+
+    /**
+     * @brief 获取输出统计
+     */
+    void audio_codec_host_get_sink_stats(audio_codec_host_sink_stats_t *stats);
+
+    /**
+     * @brief 计算CRC32 (IEEE 802.3), 可分段累加
+     * @param crc 上一段的结果, 第一段传0
+     */
+    uint32_t audio_codec_host_crc32(uint32_t crc, const void *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_CODEC_HOST_H
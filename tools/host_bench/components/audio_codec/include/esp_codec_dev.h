@@ -0,0 +1,34 @@
+/**
+ * @file esp_codec_dev.h
+ * @brief 主机基准测试用的esp_codec_dev最小替身
+ * @details 只提供audio_codec.h和混音器用到的类型与读写接口, 签名与esp_codec_dev一致。
+ */
+
+#ifndef ESP_CODEC_DEV_H
+#define ESP_CODEC_DEV_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define ESP_CODEC_DEV_OK (0)
+#define ESP_CODEC_DEV_INVALID_ARG (-1)
+
+    typedef struct esp_codec_dev_t *esp_codec_dev_handle_t;
+
+    /**
+     * @brief 写入播放数据 (写入输出文件, 按实时速度节流)
+     */
+    int esp_codec_dev_write(esp_codec_dev_handle_t codec, void *data, int len);
+
+    /**
+     * @brief 读取录音数据 (从输入文件读取, 按实时速度节流)
+     */
+    int esp_codec_dev_read(esp_codec_dev_handle_t codec, void *data, int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ESP_CODEC_DEV_H
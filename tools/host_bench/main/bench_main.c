@@ -0,0 +1,812 @@
+/**
+ * @file bench_main.c
+ * @brief 主机音频链路基准测试
+ * @details 依次播放语料目录中的MP3/WAV文件: 解码 -> 混音器音乐流 -> 混音任务(EQ/主音量) -> 文件codec替身。
+ *          每个文件输出: 每秒音频的解码耗时、混音耗时、缓冲区峰值、播放期间的分配次数以及解码/输出的CRC32。
+ *          解码CRC与时序无关, 可直接比较; 输出CRC在没有欠载时同样稳定。
+ *
+ *          MP3通过播放器的解码器后端接口(mp3_decoder_backend_t)解码, 输入与mp3_stream一样经4KB缓冲区送入,
+ *          每个MP3文件依次用每个可用的后端各跑一遍: linux目标只有libhelix(mp3_decoder_helix.c);
+ *          esp32s3上另有esp_audio_codec(mp3_decoder_esp.c, 只有芯片目标的预编译库), 两者在同一块板上对比。
+ *          编译为esp32s3时语料从SD卡读取, 没有环境变量, 使用默认值; 目标板上另外输出每帧解码的CPU周期数。
+ *
+ *          准确度: 语料中有 <文件名>.ref (参考解码器的输出, 原始16位立体声PCM, 采样率与文件相同)时,
+ *          把解码输出与它比较。两个解码器的起始延迟可能不同(Xing帧、无缝播放裁剪), 先在第一段非静音的
+ *          窗口内搜索最佳对齐, 再逐帧比较, 输出RMS误差、最大误差(LSB)和信噪比, 按ISO/IEC 11172-4判定:
+ *          full accuracy (RMS <= 2^-15/sqrt(12)满量程且最大误差 <= 2^-14) 或 limited accuracy
+ *          (RMS < 2^-11/sqrt(12)满量程), 超出limited时结果为FAIL, 进程返回1。例如:
+ *            ffmpeg -i song.mp3 -f s16le -ac 2 song.mp3.ref
+ *
+ *          环境变量 (linux目标):
+ *            BENCH_CORPUS   语料目录 (默认 ./corpus, 目标板上为 /sdcard/bench)
+ *            BENCH_REALTIME 1按实时速度节流(linux默认), 0尽快完成(目标板默认)
+ *            BENCH_OUT      保存混音输出(原始48kHz立体声PCM, MP3为<文件名>.<解码器>.pcm)的目录, 不设置则不保存
+ *            BENCH_PROFILE  输出延迟档位 interactive / balanced(默认) / music
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <dirent.h>
+#include <stdatomic.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "audio_codec.h"
+#include "audio_codec_host.h"
+#include "audio_mixer.h"
+#include "mp3_decoder.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#define BENCH_DEFAULT_CORPUS "corpus"
+#define BENCH_DEFAULT_REALTIME (1)
+#define BENCH_CYCLES() (0u) // 主机上的周期数没有参考价值
+#else
+#include "esp_cpu.h"
+#include "sd_manager.h"
+#define BENCH_DEFAULT_CORPUS "/sdcard/bench"
+#define BENCH_DEFAULT_REALTIME (0)
+#define BENCH_CYCLES() ((uint32_t)esp_cpu_get_cycle_count())
+#endif
+
+static const char *TAG = "host_bench";
+
+#define BENCH_MAX_FILES (64)
+#define BENCH_MP3_IN_BYTES (4096)                                // MP3输入缓冲区, 与mp3_stream的默认大小相同
+#define BENCH_WAV_CHUNK_FRAMES (1152)                            // WAV每次送入混音器的帧数
+#define BENCH_DRAIN_TIMEOUT_MS (3000)                            // 等待混音器输出完最后一块
+
+#define BENCH_REF_SUFFIX ".ref"          // 参考解码输出: <文件名>.ref
+#define BENCH_REF_WINDOW (8192)          // 对齐窗口帧数
+#define BENCH_REF_MAX_LAG (3 * 1152)     // 对齐搜索范围(±帧): 编解码延迟、Xing帧、无缝播放裁剪
+#define BENCH_REF_SILENCE (64)           // 对齐窗口从第一个幅度超过该值的帧开始
+#define BENCH_REF_CHUNK_FRAMES (1152)    // 对齐后每次读取的参考帧数
+#define BENCH_REF_FULL_RMS_LSB (0.2887)  // 2^-15/sqrt(12)满量程
+#define BENCH_REF_FULL_MAX_LSB (2)       // 2^-14满量程
+#define BENCH_REF_LIMITED_RMS_LSB (4.619) // 2^-11/sqrt(12)满量程
+
+extern const mp3_decoder_backend_t mp3_decoder_helix_mp3;
+#if !CONFIG_IDF_TARGET_LINUX
+extern const mp3_decoder_backend_t mp3_decoder_esp_mp3;
+#endif
+
+// 每个MP3文件依次用这些后端解码
+static const mp3_decoder_backend_t *const s_mp3_backends[] = {
+#if !CONFIG_IDF_TARGET_LINUX
+    &mp3_decoder_esp_mp3,
+#endif
+    &mp3_decoder_helix_mp3,
+    NULL,
+};
+
+/**
+ * @brief 单个文件的结果
+ */
+typedef struct
+{
+    char name[64];
+    const char *decoder;    // 解码器名称 (MP3为后端名)
+    uint32_t sample_rate;
+    uint64_t frames;        // 解码输出的帧数
+    int64_t decode_us;      // 解码总耗时
+    uint32_t max_frame_us;  // 单帧最长解码耗时
+    uint64_t decode_cycles; // 解码总CPU周期数 (只在目标板上统计)
+    uint32_t decode_blocks; // 解码输出的块数 (MP3为帧数)
+    uint32_t allocs;        // 播放期间的malloc/calloc/realloc次数
+    uint32_t frees;
+    uint32_t decode_crc;    // 解码输出(立体声)的CRC32
+    bool has_ref;           // 有参考输出
+    int32_t ref_lag;        // 解码输出第i帧对应参考第i+ref_lag帧
+    uint64_t ref_frames;    // 参与比较的帧数
+    double ref_err2;        // 误差平方和
+    double ref_sig2;        // 参考信号平方和
+    uint32_t ref_max_diff;  // 最大误差 (LSB)
+    audio_mixer_stats_t mixer;
+    audio_codec_host_sink_stats_t sink;
+} bench_result_t;
+
+/* ---------- 分配计数 (链接时--wrap) ---------- */
+
+static atomic_uint s_alloc_count;
+static atomic_uint s_free_count;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+void *__wrap_malloc(size_t size)
+{
+    atomic_fetch_add_explicit(&s_alloc_count, 1, memory_order_relaxed);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    atomic_fetch_add_explicit(&s_alloc_count, 1, memory_order_relaxed);
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    atomic_fetch_add_explicit(&s_alloc_count, 1, memory_order_relaxed);
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr)
+{
+    if (ptr != NULL)
+    {
+        atomic_fetch_add_explicit(&s_free_count, 1, memory_order_relaxed);
+    }
+    __real_free(ptr);
+}
+
+/* ---------- 工具函数 ---------- */
+
+/**
+ * @brief 把整个文件读入内存 (在计时和计数窗口之外完成)
+ */
+static uint8_t *bench_load_file(const char *path, size_t *size)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = len > 0 ? malloc((size_t)len) : NULL;
+    if (data != NULL && fread(data, 1, (size_t)len, f) != (size_t)len)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = data ? (size_t)len : 0;
+    return data;
+}
+
+/* ---------- 与参考解码输出比较 ---------- */
+
+/**
+ * @brief 比较状态 (一次只比较一个文件)
+ */
+static struct
+{
+    FILE *f;
+    char io_buf[4096]; // stdio缓冲区, 避免第一次读取时分配而计入播放期间的分配次数
+    bool aligned;
+    uint64_t head_start; // 对齐窗口在解码输出中的起始帧 (之前是静音)
+    size_t head_frames;
+    uint64_t skip;       // 对齐后没有参考数据对应的解码帧数 (对齐到参考开头之前)
+    bool eof;
+    int16_t head[BENCH_REF_WINDOW * 2];
+    int16_t ref[(BENCH_REF_WINDOW + 2 * BENCH_REF_MAX_LAG) * 2];
+} s_ref;
+
+/**
+ * @brief 打开参考输出, 没有时不比较
+ */
+static void bench_ref_open(bench_result_t *r, const char *path)
+{
+    memset(&s_ref, 0, sizeof(s_ref));
+    s_ref.f = fopen(path, "rb");
+    if (s_ref.f != NULL)
+    {
+        setvbuf(s_ref.f, s_ref.io_buf, _IOFBF, sizeof(s_ref.io_buf));
+        r->has_ref = true;
+    }
+}
+
+/**
+ * @brief 对齐之后逐帧比较, 参考数据从文件顺序读取
+ */
+static void bench_ref_compare(bench_result_t *r, const int16_t *pcm, size_t frames)
+{
+    size_t skip = s_ref.skip < frames ? (size_t)s_ref.skip : frames;
+    s_ref.skip -= skip;
+    pcm += 2 * skip;
+    frames -= skip;
+
+    while (frames > 0 && !s_ref.eof)
+    {
+        size_t n = frames < BENCH_REF_CHUNK_FRAMES ? frames : BENCH_REF_CHUNK_FRAMES;
+        size_t got = fread(s_ref.ref, 2 * sizeof(int16_t), n, s_ref.f);
+        s_ref.eof = got < n;
+        for (size_t k = 0; k < got * 2; k++)
+        {
+            int32_t d = pcm[k] - s_ref.ref[k];
+            uint32_t ad = (uint32_t)(d < 0 ? -d : d);
+            r->ref_err2 += (double)d * d;
+            r->ref_sig2 += (double)s_ref.ref[k] * s_ref.ref[k];
+            r->ref_max_diff = ad > r->ref_max_diff ? ad : r->ref_max_diff;
+        }
+        r->ref_frames += got;
+        pcm += 2 * got;
+        frames -= got;
+    }
+}
+
+/**
+ * @brief 在对齐窗口内搜索误差平方和最小的延迟, 然后比较窗口本身
+ * @details 参考中对应的范围是窗口前后各BENCH_REF_MAX_LAG帧, 参考开头之前补零;
+ *          按|延迟|从小到大搜索, 误差相同时取较小的延迟
+ */
+static void bench_ref_align(bench_result_t *r)
+{
+    int64_t first = (int64_t)s_ref.head_start - BENCH_REF_MAX_LAG;
+    size_t pad = first < 0 ? (size_t)-first : 0;
+    size_t want = s_ref.head_frames + 2 * BENCH_REF_MAX_LAG;
+
+    memset(s_ref.ref, 0, sizeof(s_ref.ref));
+    if (pad < want && fseek(s_ref.f, (long)(first + (int64_t)pad) * 2 * sizeof(int16_t), SEEK_SET) == 0)
+    {
+        fread(s_ref.ref + 2 * pad, 2 * sizeof(int16_t), want - pad, s_ref.f);
+    }
+
+    int32_t best_lag = 0;
+    uint64_t best_err = UINT64_MAX;
+    for (int32_t i = 0; i <= 2 * BENCH_REF_MAX_LAG; i++)
+    {
+        int32_t lag = (i & 1) ? (i + 1) / 2 : -(i / 2); // 0, 1, -1, 2, -2 ...
+        const int16_t *ref = s_ref.ref + 2 * (BENCH_REF_MAX_LAG + lag);
+        uint64_t err = 0;
+        for (size_t k = 0; k < s_ref.head_frames * 2 && err < best_err; k++)
+        {
+            int32_t d = s_ref.head[k] - ref[k];
+            err += (uint64_t)((int64_t)d * d);
+        }
+        if (err < best_err)
+        {
+            best_err = err;
+            best_lag = lag;
+        }
+    }
+
+    // 从窗口起点对应的参考位置开始顺序比较
+    int64_t ref_start = (int64_t)s_ref.head_start + best_lag;
+    s_ref.skip = ref_start < 0 ? (uint64_t)-ref_start : 0;
+    s_ref.eof = fseek(s_ref.f, (long)(ref_start + (int64_t)s_ref.skip) * 2 * sizeof(int16_t), SEEK_SET) != 0;
+    s_ref.aligned = true;
+    r->ref_lag = best_lag;
+    bench_ref_compare(r, s_ref.head, s_ref.head_frames);
+}
+
+/**
+ * @brief 解码输出送入比较: 跳过开头的静音, 攒够对齐窗口后对齐, 之后直接比较
+ */
+static void bench_ref_feed(bench_result_t *r, const int16_t *pcm, size_t frames)
+{
+    size_t i = 0;
+    while (!s_ref.aligned && i < frames)
+    {
+        const int16_t *p = pcm + 2 * i;
+        i++;
+        if (s_ref.head_frames == 0 && abs(p[0]) <= BENCH_REF_SILENCE && abs(p[1]) <= BENCH_REF_SILENCE)
+        {
+            s_ref.head_start++;
+            continue;
+        }
+        s_ref.head[2 * s_ref.head_frames] = p[0];
+        s_ref.head[2 * s_ref.head_frames + 1] = p[1];
+        if (++s_ref.head_frames == BENCH_REF_WINDOW)
+        {
+            bench_ref_align(r);
+        }
+    }
+    if (i < frames)
+    {
+        bench_ref_compare(r, pcm + 2 * i, frames - i);
+    }
+}
+
+/**
+ * @brief 解码结束: 不足一个窗口的短文件用已有的数据对齐
+ */
+static void bench_ref_close(bench_result_t *r)
+{
+    if (s_ref.f == NULL)
+    {
+        return;
+    }
+    if (!s_ref.aligned && s_ref.head_frames > 0)
+    {
+        bench_ref_align(r);
+    }
+    fclose(s_ref.f);
+    s_ref.f = NULL;
+}
+
+/**
+ * @brief 比较结果, 按ISO/IEC 11172-4的准确度等级判定
+ * @return "bitexact" / "full" / "limited" / "FAIL"
+ */
+static const char *bench_ref_verdict(const bench_result_t *r, double *rms_lsb)
+{
+    *rms_lsb = r->ref_frames ? sqrt(r->ref_err2 / (r->ref_frames * 2)) : 0.0;
+    if (r->ref_frames == 0)
+    {
+        return "FAIL"; // 没有可比较的数据 (文件为空或全部静音)
+    }
+    if (r->ref_err2 == 0.0)
+    {
+        return "bitexact";
+    }
+    if (*rms_lsb <= BENCH_REF_FULL_RMS_LSB && r->ref_max_diff <= BENCH_REF_FULL_MAX_LSB)
+    {
+        return "full";
+    }
+    return *rms_lsb < BENCH_REF_LIMITED_RMS_LSB ? "limited" : "FAIL";
+}
+
+/**
+ * @brief 把一段立体声PCM送入混音器并累计CRC
+ */
+static void bench_output(bench_result_t *r, const int16_t *pcm, size_t frames)
+{
+    size_t bytes = frames * AUDIO_DEFAULT_CHANNELS * sizeof(int16_t);
+    r->decode_crc = audio_codec_host_crc32(r->decode_crc, pcm, bytes);
+    r->frames += frames;
+    if (s_ref.f != NULL)
+    {
+        bench_ref_feed(r, pcm, frames);
+    }
+    audio_mixer_write(AUDIO_MIXER_STREAM_MUSIC, pcm, bytes, portMAX_DELAY);
+}
+
+/**
+ * @brief 单声道原地扩展为立体声 (从后往前)
+ */
+static void bench_mono_to_stereo(int16_t *pcm, size_t frames)
+{
+    for (size_t i = frames; i-- > 0;)
+    {
+        pcm[2 * i] = pcm[i];
+        pcm[2 * i + 1] = pcm[i];
+    }
+}
+
+/* ---------- 解码 ---------- */
+
+/**
+ * @brief MP3输入: 文件数据在PSRAM, 按mp3_stream的方式搬到内部RAM缓冲区再解码
+ */
+typedef struct
+{
+    const uint8_t *data;
+    size_t size;
+    size_t file_pos; // 下一次从文件读取的位置
+    uint8_t buf[BENCH_MP3_IN_BYTES];
+    size_t pos; // 未解码数据的起始位置
+    size_t len; // 缓冲区中数据的结束位置
+} bench_mp3_input_t;
+
+/**
+ * @brief ID3v2标签总长度 (没有标签时为0), 与mp3_decoder_id3_size相同 (mp3_decoder.c依赖播放器的其他部分, 不编译进来)
+ */
+static uint32_t bench_id3_size(const uint8_t *head, size_t len)
+{
+    if (len < 10 || memcmp(head, "ID3", 3) != 0)
+    {
+        return 0;
+    }
+    uint32_t size = ((uint32_t)(head[6] & 0x7F) << 21) | ((uint32_t)(head[7] & 0x7F) << 14) |
+                    ((uint32_t)(head[8] & 0x7F) << 7) | (head[9] & 0x7F);
+    return size + 10 + ((head[5] & 0x10) ? 10 : 0);
+}
+
+/**
+ * @brief 把剩余数据移到缓冲区开头并补满 (拷贝不计入解码耗时)
+ */
+static void bench_mp3_refill(bench_mp3_input_t *in)
+{
+    memmove(in->buf, in->buf + in->pos, in->len - in->pos);
+    in->len -= in->pos;
+    in->pos = 0;
+    size_t n = sizeof(in->buf) - in->len;
+    n = n < in->size - in->file_pos ? n : in->size - in->file_pos;
+    memcpy(in->buf + in->len, in->data + in->file_pos, n);
+    in->len += n;
+    in->file_pos += n;
+}
+
+/**
+ * @brief 通过解码器后端解码, 输入缓冲区和错误处理与mp3_stream一致
+ */
+static void bench_decode_mp3(bench_result_t *r, const mp3_decoder_backend_t *backend, const uint8_t *data,
+                             size_t size)
+{
+    static bench_mp3_input_t in;
+    static int16_t pcm_buf[MP3_DECODER_MAX_FRAMES * 2];
+    void *ctx = NULL;
+    uint32_t data_offset = 0;
+
+    in.data = data;
+    in.size = size;
+    in.file_pos = bench_id3_size(data, size);
+    in.pos = 0;
+    in.len = 0;
+    bench_mp3_refill(&in);
+    if (!backend->probe(in.buf, in.len) || backend->open(&ctx, in.buf, in.len, &data_offset) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "%s: %s 无法解码", r->name, backend->name);
+        return;
+    }
+    in.pos = data_offset;
+
+    while (true)
+    {
+        if (in.len - in.pos < sizeof(in.buf) / 2)
+        {
+            bench_mp3_refill(&in);
+        }
+        if (in.len == in.pos)
+        {
+            break;
+        }
+
+        size_t consumed = 0;
+        size_t frames = 0;
+        int16_t *pcm = pcm_buf;
+        mp3_decoder_info_t info = {0};
+        int64_t t0 = esp_timer_get_time();
+        uint32_t c0 = BENCH_CYCLES();
+        esp_err_t err = backend->decode(ctx, in.buf + in.pos, in.len - in.pos, &consumed, &pcm, &frames, &info);
+        uint32_t frame_cycles = BENCH_CYCLES() - c0;
+        uint32_t frame_us = (uint32_t)(esp_timer_get_time() - t0);
+        in.pos += consumed;
+
+        if (err == ESP_ERR_INVALID_SIZE)
+        {
+            if (in.file_pos == in.size)
+            {
+                break; // 文件末尾的残缺帧
+            }
+            if (in.len - in.pos == sizeof(in.buf))
+            {
+                in.pos++; // 缓冲区满仍凑不出一帧, 跳过一个字节重新同步
+            }
+            else
+            {
+                bench_mp3_refill(&in);
+            }
+            continue;
+        }
+        if (err != ESP_OK)
+        {
+            if (err != ESP_ERR_NOT_FOUND)
+            {
+                ESP_LOGE(TAG, "%s: %s 解码失败: %s", r->name, backend->name, esp_err_to_name(err));
+            }
+            break;
+        }
+        if (frames == 0)
+        {
+            continue;
+        }
+        if (info.channels == 1)
+        {
+            // 后端可能把pcm指向输入缓冲区, 先拷贝到自己的缓冲区再扩展
+            if (pcm != pcm_buf)
+            {
+                memcpy(pcm_buf, pcm, frames * sizeof(int16_t));
+                pcm = pcm_buf;
+            }
+            bench_mono_to_stereo(pcm, frames);
+        }
+        r->decode_us += frame_us;
+        r->decode_cycles += frame_cycles;
+        r->decode_blocks++;
+        r->max_frame_us = frame_us > r->max_frame_us ? frame_us : r->max_frame_us;
+        r->sample_rate = info.sample_rate;
+        bench_output(r, pcm, frames);
+    }
+
+    backend->close(ctx);
+}
+
+/**
+ * @brief 16位PCM WAV: 查找fmt/data块后分段送入 (解码耗时即格式转换耗时)
+ */
+static void bench_decode_wav(bench_result_t *r, uint8_t *data, size_t size)
+{
+    static int16_t pcm[BENCH_WAV_CHUNK_FRAMES * 2];
+    uint16_t channels = 0;
+    uint16_t bits = 0;
+    size_t pos = 12;
+
+    if (size < 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0)
+    {
+        ESP_LOGE(TAG, "%s: 不是WAV文件", r->name);
+        return;
+    }
+
+    while (pos + 8 <= size)
+    {
+        uint32_t chunk_len = data[pos + 4] | (data[pos + 5] << 8) | (data[pos + 6] << 16) | ((uint32_t)data[pos + 7] << 24);
+        const uint8_t *body = data + pos + 8;
+        if (memcmp(data + pos, "fmt ", 4) == 0 && chunk_len >= 16)
+        {
+            channels = body[2] | (body[3] << 8);
+            r->sample_rate = body[4] | (body[5] << 8) | (body[6] << 16) | ((uint32_t)body[7] << 24);
+            bits = body[14] | (body[15] << 8);
+        }
+        else if (memcmp(data + pos, "data", 4) == 0)
+        {
+            if (bits != 16 || (channels != 1 && channels != 2))
+            {
+                ESP_LOGE(TAG, "%s: 只支持16位单/双声道PCM", r->name);
+                return;
+            }
+            size_t avail = size - (pos + 8);
+            size_t frames_left = (chunk_len < avail ? chunk_len : avail) / (channels * sizeof(int16_t));
+            const int16_t *src = (const int16_t *)body;
+            while (frames_left > 0)
+            {
+                size_t n = frames_left < BENCH_WAV_CHUNK_FRAMES ? frames_left : BENCH_WAV_CHUNK_FRAMES;
+                int64_t t0 = esp_timer_get_time();
+                uint32_t c0 = BENCH_CYCLES();
+                memcpy(pcm, src, n * channels * sizeof(int16_t));
+                if (channels == 1)
+                {
+                    bench_mono_to_stereo(pcm, n);
+                }
+                r->decode_cycles += BENCH_CYCLES() - c0;
+                r->decode_blocks++;
+                r->decode_us += esp_timer_get_time() - t0;
+                bench_output(r, pcm, n);
+                src += n * channels;
+                frames_left -= n;
+            }
+            return;
+        }
+        pos += 8 + chunk_len + (chunk_len & 1);
+    }
+}
+
+/* ---------- 主流程 ---------- */
+
+/**
+ * @brief 等待混音器把已写入的数据全部输出 (最后一块不足时补齐静音)
+ */
+static void bench_wait_drain(uint64_t frames)
+{
+    uint64_t blocks = (frames + AUDIO_MIXER_BLOCK_FRAMES - 1) / AUDIO_MIXER_BLOCK_FRAMES;
+    uint64_t expect = blocks * AUDIO_MIXER_BLOCK_FRAMES * AUDIO_DEFAULT_CHANNELS * sizeof(int16_t);
+    audio_codec_host_sink_stats_t sink;
+
+    for (int waited = 0; waited < BENCH_DRAIN_TIMEOUT_MS; waited += 10)
+    {
+        audio_codec_host_get_sink_stats(&sink);
+        if (sink.bytes >= expect)
+        {
+            return;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    ESP_LOGW(TAG, "等待输出超时: %llu / %llu 字节", (unsigned long long)sink.bytes, (unsigned long long)expect);
+}
+
+/**
+ * @brief 播放一个文件
+ * @param backend MP3解码器后端, NULL表示WAV
+ */
+static void bench_run_file(const char *dir, const char *name, const mp3_decoder_backend_t *backend,
+                           const char *out_dir, bench_result_t *r)
+{
+    char path[512];
+    size_t size = 0;
+
+    memset(r, 0, sizeof(*r));
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->decoder = backend != NULL ? backend->name : "WAV PCM";
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    uint8_t *data = bench_load_file(path, &size);
+    if (data == NULL)
+    {
+        ESP_LOGE(TAG, "无法读取: %s", path);
+        return;
+    }
+    snprintf(path, sizeof(path), "%s/%s%s", dir, name, BENCH_REF_SUFFIX);
+    bench_ref_open(r, path);
+
+    // 每个文件重新初始化混音器, 统计和缓冲区峰值从零开始
+    if (out_dir != NULL)
+    {
+        if (backend != NULL)
+        {
+            // 同一个MP3文件的多次运行按解码器区分: <文件名>.<后端名第一个词>.pcm
+            snprintf(path, sizeof(path), "%s/%s.%.*s.pcm", out_dir, name, (int)strcspn(backend->name, " "),
+                     backend->name);
+        }
+        else
+        {
+            snprintf(path, sizeof(path), "%s/%s.pcm", out_dir, name);
+        }
+    }
+    audio_codec_host_sink_open(out_dir != NULL ? path : NULL);
+    audio_mixer_init();
+
+    unsigned allocs0 = atomic_load(&s_alloc_count);
+    unsigned frees0 = atomic_load(&s_free_count);
+
+    if (backend != NULL)
+    {
+        bench_decode_mp3(r, backend, data, size);
+    }
+    else
+    {
+        bench_decode_wav(r, data, size);
+    }
+    bench_wait_drain(r->frames);
+
+    r->allocs = atomic_load(&s_alloc_count) - allocs0;
+    r->frees = atomic_load(&s_free_count) - frees0;
+    bench_ref_close(r);
+    audio_mixer_get_stats(&r->mixer);
+    audio_codec_host_get_sink_stats(&r->sink);
+
+    audio_mixer_deinit();
+    audio_codec_host_sink_close();
+    free(data);
+}
+
+static void bench_print(const bench_result_t *r)
+{
+    double audio_s = r->sample_rate ? (double)r->frames / r->sample_rate : 0.0;
+    double decode_ms_per_s = audio_s > 0.0 ? r->decode_us / 1000.0 / audio_s : 0.0;
+    char cycles[16] = "-";
+
+    if (r->decode_cycles > 0 && r->decode_blocks > 0)
+    {
+        snprintf(cycles, sizeof(cycles), "%llu", (unsigned long long)(r->decode_cycles / r->decode_blocks));
+    }
+    printf("%-24s %-19s %7.2f %6lu %9.3f %7lu %9s %7lu %8lu %6lu %6lu/%-6lu %08lx %08lx\n",
+           r->name, r->decoder, audio_s, (unsigned long)r->sample_rate, decode_ms_per_s,
+           (unsigned long)r->max_frame_us, cycles, (unsigned long)r->mixer.max_mix_us,
+           (unsigned long)r->mixer.peak_fill[AUDIO_MIXER_STREAM_MUSIC],
+           (unsigned long)r->mixer.underruns[AUDIO_MIXER_STREAM_MUSIC],
+           (unsigned long)r->allocs, (unsigned long)r->frees,
+           (unsigned long)r->decode_crc, (unsigned long)r->sink.crc32);
+}
+
+/**
+ * @brief 按名称取延迟档位, 无法识别时用默认档位
+ */
+static audio_codec_latency_profile_t bench_parse_profile(const char *name)
+{
+    static const char *const names[AUDIO_CODEC_LATENCY_MAX] = {"interactive", "balanced", "music"};
+    for (int i = 0; name != NULL && i < AUDIO_CODEC_LATENCY_MAX; i++)
+    {
+        if (strcasecmp(name, names[i]) == 0)
+        {
+            return (audio_codec_latency_profile_t)i;
+        }
+    }
+    return AUDIO_CODEC_DEFAULT_LATENCY_PROFILE;
+}
+
+/**
+ * @brief 结束: linux目标以退出码结束进程; 目标板上exit()会abort, 只打印结果, 由调用者从app_main返回
+ */
+static void bench_exit(int code)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    exit(code);
+#else
+    printf("bench done (%d)\n", code);
+#endif
+}
+
+void app_main(void)
+{
+    const char *corpus = getenv("BENCH_CORPUS") ? getenv("BENCH_CORPUS") : BENCH_DEFAULT_CORPUS;
+    const char *realtime = getenv("BENCH_REALTIME");
+    const char *out_dir = getenv("BENCH_OUT");
+    static bench_result_t results[BENCH_MAX_FILES];
+    int count = 0;
+
+#if !CONFIG_IDF_TARGET_LINUX
+    if (sd_manager_init() != ESP_OK)
+    {
+        ESP_LOGE(TAG, "SD卡挂载失败");
+        bench_exit(1);
+        return;
+    }
+#endif
+
+    audio_codec_host_set_realtime(realtime != NULL ? strcmp(realtime, "0") != 0 : BENCH_DEFAULT_REALTIME);
+    audio_codec_set_latency_profile(bench_parse_profile(getenv("BENCH_PROFILE")));
+    audio_codec_init();
+
+    DIR *dir = opendir(corpus);
+    if (dir == NULL)
+    {
+        ESP_LOGE(TAG, "无法打开语料目录: %s", corpus);
+        bench_exit(1);
+        return;
+    }
+
+    printf("%-24s %-19s %7s %6s %9s %7s %9s %7s %8s %6s %13s %8s %8s\n", "file", "decoder", "sec", "rate", "dec_ms/s", "frm_us",
+           "cyc/frm", "mix_us", "peak_B", "under", "alloc/free", "dec_crc", "out_crc");
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && count < BENCH_MAX_FILES)
+    {
+        const char *ext = strrchr(entry->d_name, '.');
+        if (ext == NULL || (strcasecmp(ext, ".mp3") != 0 && strcasecmp(ext, ".wav") != 0))
+        {
+            continue;
+        }
+        if (strcasecmp(ext, ".wav") == 0)
+        {
+            bench_run_file(corpus, entry->d_name, NULL, out_dir, &results[count]);
+            bench_print(&results[count]);
+            count++;
+            continue;
+        }
+        for (int i = 0; s_mp3_backends[i] != NULL && count < BENCH_MAX_FILES; i++)
+        {
+            bench_run_file(corpus, entry->d_name, s_mp3_backends[i], out_dir, &results[count]);
+            bench_print(&results[count]);
+            count++;
+        }
+    }
+    closedir(dir);
+
+    // 汇总: 总解码耗时 / 总音频时长
+    double total_s = 0.0;
+    int64_t total_us = 0;
+    uint64_t total_cycles = 0;
+    for (int i = 0; i < count; i++)
+    {
+        total_s += results[i].sample_rate ? (double)results[i].frames / results[i].sample_rate : 0.0;
+        total_us += results[i].decode_us;
+        total_cycles += results[i].decode_cycles;
+    }
+    printf("total: %d runs, %.2f s audio, decode %.3f ms per second of audio\n", count, total_s,
+           total_s > 0.0 ? total_us / 1000.0 / total_s : 0.0);
+    if (total_cycles > 0 && total_s > 0.0)
+    {
+        printf("decode cpu: %.1f MHz for real-time playback\n", total_cycles / total_s / 1e6);
+    }
+
+    // 与参考解码输出的比较
+    int failures = 0;
+    bool header = false;
+    for (int i = 0; i < count; i++)
+    {
+        const bench_result_t *r = &results[i];
+        if (!r->has_ref)
+        {
+            continue;
+        }
+        if (!header)
+        {
+            printf("\n%-24s %-19s %6s %8s %8s %6s %8s %s\n", "reference", "decoder", "lag", "sec", "rms_lsb", "max", "snr_db", "result");
+            header = true;
+        }
+        double rms_lsb;
+        const char *verdict = bench_ref_verdict(r, &rms_lsb);
+        double snr = r->ref_err2 > 0.0 ? 10.0 * log10(r->ref_sig2 / r->ref_err2) : INFINITY;
+        printf("%-24s %-19s %6ld %8.2f %8.3f %6lu %8.1f %s\n", r->name, r->decoder, (long)r->ref_lag,
+               r->sample_rate ? (double)r->ref_frames / r->sample_rate : 0.0, rms_lsb,
+               (unsigned long)r->ref_max_diff, snr, verdict);
+        failures += strcmp(verdict, "FAIL") == 0;
+    }
+
+    audio_codec_latency_stats_t lat;
+    audio_codec_get_latency_stats(&lat);
+    printf("latency: DMA %lu x %lu frames, buffer %.1f ms, measured avg %.1f ms / max %.1f ms, %lu tx irq/s\n",
+           (unsigned long)lat.dma_frames, (unsigned long)lat.dma_desc_num, lat.buffer_us / 1000.0,
+           lat.latency_avg_us / 1000.0, lat.latency_max_us / 1000.0, (unsigned long)lat.tx_isr_per_sec);
+
+    audio_codec_deinit();
+    bench_exit(failures == 0 ? 0 : 1);
+}
@@ -0,0 +1,299 @@
+/**
+ * @file dsp_check_main.c
+ * @brief 主机上检查audio_dsp定点biquad的精度
+ * @details 每组滤波器依次检查:
+ *            - 设计: Q28系数在特征频率上的幅度响应与设计值的偏差 (峰值/架式为增益, 高低通为Q)
+ *            - 运算: 同一组Q28系数, 定点级联与双精度直接I型逐样本比较, 检查最大误差和误差均方根(LSB),
+ *              同时打印误差信噪比
+ *            - 分块: 按混音器块大小(240帧)分块处理与整段处理逐位相同, chain_swap换到相同系数时与直接处理逐位相同
+ *          测试信号为48kHz立体声: 左声道是几个正弦与白噪声的和, 右声道是白噪声, 峰值约-12dBFS,
+ *          提升12dB的滤波器也不会削波。任一项超出上限时以非0退出。
+ *
+ *          环境变量:
+ *            DSP_CHECK_SECONDS  每组滤波器的信号长度 (默认2)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "audio_dsp.h"
+#include "audio_dsp_biquad.h"
+
+#define DSP_CHECK_RATE (48000)
+#define DSP_CHECK_CHANNELS (2)
+#define DSP_CHECK_BLOCK_FRAMES (240)   // 与AUDIO_MIXER_BLOCK_FRAMES相同
+#define DSP_CHECK_AMPLITUDE (8000.0)   // 信号峰值 (约-12dBFS)
+#define DSP_CHECK_MAX_ERR_LSB (1.0)    // 定点输出与双精度参考的最大误差上限
+#define DSP_CHECK_MAX_RMS_LSB (0.35)   // 误差均方根上限; 只有输出取整时为1/sqrt(12)=0.289, 与信号电平无关
+#define DSP_CHECK_MAX_RESP_DB (0.05)   // Q28系数的幅度响应与设计值的最大偏差
+
+/**
+ * @brief 一组待检查的滤波器
+ */
+typedef struct
+{
+    const char *name;
+    int stages;
+    audio_dsp_biquad_param_t param[AUDIO_DSP_BIQUAD_MAX_STAGES];
+} dsp_check_case_t;
+
+static const dsp_check_case_t s_cases[] = {
+    {"hp20", 1, {{AUDIO_DSP_BIQUAD_HIGHPASS, 20.0f, 0.0f, 0.707f}}}, // 极点最接近z=1, 对量化最敏感
+    {"hp150", 1, {{AUDIO_DSP_BIQUAD_HIGHPASS, 150.0f, 0.0f, 0.707f}}}, // 默认的扬声器保护高通
+    {"lp12k", 1, {{AUDIO_DSP_BIQUAD_LOWPASS, 12000.0f, 0.0f, 0.707f}}},
+    {"peak1k+12", 1, {{AUDIO_DSP_BIQUAD_PEAK, 1000.0f, 12.0f, 1.0f}}},
+    {"peak60-12", 1, {{AUDIO_DSP_BIQUAD_PEAK, 60.0f, -12.0f, 4.0f}}},
+    {"lshelf100+6", 1, {{AUDIO_DSP_BIQUAD_LOW_SHELF, 100.0f, 6.0f, 0.707f}}},
+    {"hshelf8k-6", 1, {{AUDIO_DSP_BIQUAD_HIGH_SHELF, 8000.0f, -6.0f, 0.707f}}},
+    {"eq10",
+     10,
+     {
+         {AUDIO_DSP_BIQUAD_HIGHPASS, 150.0f, 0.0f, 0.707f},
+         {AUDIO_DSP_BIQUAD_LOW_SHELF, 100.0f, 4.0f, 0.707f},
+         {AUDIO_DSP_BIQUAD_PEAK, 250.0f, -3.0f, 1.4f},
+         {AUDIO_DSP_BIQUAD_PEAK, 500.0f, 2.0f, 1.4f},
+         {AUDIO_DSP_BIQUAD_PEAK, 1000.0f, -2.0f, 1.4f},
+         {AUDIO_DSP_BIQUAD_PEAK, 2000.0f, 3.0f, 1.4f},
+         {AUDIO_DSP_BIQUAD_PEAK, 3000.0f, -3.0f, 1.4f},
+         {AUDIO_DSP_BIQUAD_PEAK, 6000.0f, 2.0f, 2.0f},
+         {AUDIO_DSP_BIQUAD_HIGH_SHELF, 10000.0f, 3.0f, 0.707f},
+         {AUDIO_DSP_BIQUAD_LOWPASS, 18000.0f, 0.0f, 0.707f},
+     }},
+};
+#define DSP_CHECK_CASES (sizeof(s_cases) / sizeof(s_cases[0]))
+
+static int s_failures = 0;
+
+static void check(bool ok, const char *name, const char *what)
+{
+    printf("%-12s %-28s %s\n", name, what, ok ? "OK" : "FAIL");
+    if (!ok)
+    {
+        s_failures++;
+    }
+}
+
+/**
+ * @brief 均匀分布的白噪声, [-1, 1)
+ */
+static double noise(uint32_t *x)
+{
+    *x = *x * 1664525u + 1013904223u;
+    return (double)(int32_t)*x / 2147483648.0;
+}
+
+static void make_signal(int16_t *pcm, size_t frames)
+{
+    uint32_t seed_l = 1;
+    uint32_t seed_r = 2;
+    const double freqs[] = {31.0, 440.0, 2500.0, 9000.0};
+    for (size_t i = 0; i < frames; i++)
+    {
+        double t = (double)i / DSP_CHECK_RATE;
+        double l = 0.25 * noise(&seed_l);
+        for (size_t k = 0; k < sizeof(freqs) / sizeof(freqs[0]); k++)
+        {
+            l += 0.18 * sin(2.0 * M_PI * freqs[k] * t);
+        }
+        pcm[2 * i] = (int16_t)lrint(l * DSP_CHECK_AMPLITUDE);
+        pcm[2 * i + 1] = (int16_t)lrint(noise(&seed_r) * DSP_CHECK_AMPLITUDE);
+    }
+}
+
+/**
+ * @brief Q28系数在归一化角频率w上的幅度响应 (dB)
+ */
+static double coef_response_db(const audio_dsp_biquad_coef_t *k, double w)
+{
+    const double s = 1.0 / (1 << AUDIO_DSP_BIQUAD_COEF_SHIFT);
+    double b0 = k->b0 * s, b1 = k->b1 * s, b2 = k->b2 * s, a1 = k->a1 * s, a2 = k->a2 * s;
+    double nr = b0 + b1 * cos(w) + b2 * cos(2 * w);
+    double ni = -b1 * sin(w) - b2 * sin(2 * w);
+    double dr = 1.0 + a1 * cos(w) + a2 * cos(2 * w);
+    double di = -a1 * sin(w) - a2 * sin(2 * w);
+    return 10.0 * log10((nr * nr + ni * ni) / (dr * dr + di * di));
+}
+
+/**
+ * @brief 设计值: 特征频率和该处应有的幅度响应
+ */
+static void expected_response(const audio_dsp_biquad_param_t *p, double *w, double *db)
+{
+    switch (p->type)
+    {
+    case AUDIO_DSP_BIQUAD_LOW_SHELF:
+        *w = 0.0; // 直流处为全部增益
+        *db = p->gain_db;
+        break;
+    case AUDIO_DSP_BIQUAD_HIGH_SHELF:
+        *w = M_PI; // 奈奎斯特频率处为全部增益
+        *db = p->gain_db;
+        break;
+    case AUDIO_DSP_BIQUAD_HIGHPASS:
+    case AUDIO_DSP_BIQUAD_LOWPASS:
+        *w = 2.0 * M_PI * p->freq_hz / DSP_CHECK_RATE; // 转折频率处 |H| = Q
+        *db = 20.0 * log10(p->q);
+        break;
+    default:
+        *w = 2.0 * M_PI * p->freq_hz / DSP_CHECK_RATE;
+        *db = p->gain_db;
+        break;
+    }
+}
+
+/**
+ * @brief 双精度直接I型级联, 使用与定点实现相同的Q28系数, 输出不量化
+ */
+static void reference_process(const audio_dsp_biquad_coef_t *coef, int stages, const int16_t *in, double *out,
+                              size_t frames)
+{
+    const double s = 1.0 / (1 << AUDIO_DSP_BIQUAD_COEF_SHIFT);
+    for (int c = 0; c < DSP_CHECK_CHANNELS; c++)
+    {
+        double x1[AUDIO_DSP_BIQUAD_MAX_STAGES] = {0}, x2[AUDIO_DSP_BIQUAD_MAX_STAGES] = {0};
+        double y1[AUDIO_DSP_BIQUAD_MAX_STAGES] = {0}, y2[AUDIO_DSP_BIQUAD_MAX_STAGES] = {0};
+        for (size_t i = 0; i < frames; i++)
+        {
+            double v = in[i * DSP_CHECK_CHANNELS + c];
+            for (int st = 0; st < stages; st++)
+            {
+                const audio_dsp_biquad_coef_t *k = &coef[st];
+                double y = k->b0 * s * v + k->b1 * s * x1[st] + k->b2 * s * x2[st] - k->a1 * s * y1[st] -
+                           k->a2 * s * y2[st];
+                x2[st] = x1[st];
+                x1[st] = v;
+                y2[st] = y1[st];
+                y1[st] = y;
+                v = y;
+            }
+            out[i * DSP_CHECK_CHANNELS + c] = v;
+        }
+    }
+}
+
+static void process_blocks(audio_dsp_biquad_chain_t *chain, int16_t *pcm, size_t frames)
+{
+    for (size_t done = 0; done < frames; done += DSP_CHECK_BLOCK_FRAMES)
+    {
+        size_t n = frames - done < DSP_CHECK_BLOCK_FRAMES ? frames - done : DSP_CHECK_BLOCK_FRAMES;
+        audio_dsp_biquad_chain_process(chain, pcm + done * DSP_CHECK_CHANNELS, n, DSP_CHECK_CHANNELS);
+    }
+}
+
+/**
+ * @brief 检查一组滤波器
+ * @param fixed/other 与输入等长的缓冲区, scratch一个块长, ref与输入等长的双精度缓冲区
+ */
+static void run_case(const dsp_check_case_t *tc, const int16_t *input, size_t frames, int16_t *fixed, int16_t *other,
+                     int16_t *scratch, double *ref)
+{
+    size_t samples = frames * DSP_CHECK_CHANNELS;
+
+    // 设计
+    audio_dsp_biquad_coef_t coef[AUDIO_DSP_BIQUAD_MAX_STAGES];
+    double resp_err = 0.0;
+    bool designed = true;
+    for (int s = 0; s < tc->stages; s++)
+    {
+        designed = designed && audio_dsp_biquad_design(&tc->param[s], DSP_CHECK_RATE, &coef[s]);
+        if (designed)
+        {
+            double w, db;
+            expected_response(&tc->param[s], &w, &db);
+            double e = fabs(coef_response_db(&coef[s], w) - db);
+            resp_err = e > resp_err ? e : resp_err;
+        }
+    }
+    check(designed, tc->name, "design");
+    if (!designed)
+    {
+        return;
+    }
+
+    // 运算: 定点 (按块) vs 双精度
+    audio_dsp_biquad_chain_t chain;
+    audio_dsp_biquad_chain_init(&chain, coef, tc->stages);
+    memcpy(fixed, input, samples * sizeof(int16_t));
+    process_blocks(&chain, fixed, frames);
+    reference_process(coef, tc->stages, input, ref, frames);
+
+    double max_err = 0.0, err_pow = 0.0, sig_pow = 0.0;
+    size_t clipped = 0;
+    for (size_t i = 0; i < samples; i++)
+    {
+        if (fabs(ref[i]) > 32767.0)
+        {
+            clipped++; // 定点输出饱和, 不计入误差
+            continue;
+        }
+        double e = fixed[i] - ref[i];
+        max_err = fabs(e) > max_err ? fabs(e) : max_err;
+        err_pow += e * e;
+        sig_pow += ref[i] * ref[i];
+    }
+    double snr = err_pow > 0.0 ? 10.0 * log10(sig_pow / err_pow) : INFINITY;
+    printf("%-12s stages %2d  resp err %.4f dB  max err %.3f LSB  rms err %.3f LSB  SNR %.1f dB  clipped %zu\n",
+           tc->name, tc->stages, resp_err, max_err, sqrt(err_pow / samples), snr, clipped);
+    check(resp_err <= DSP_CHECK_MAX_RESP_DB, tc->name, "response vs design");
+    check(clipped == 0, tc->name, "no clipping");
+    check(max_err <= DSP_CHECK_MAX_ERR_LSB, tc->name, "max error vs double");
+    check(sqrt(err_pow / samples) <= DSP_CHECK_MAX_RMS_LSB, tc->name, "rms error vs double");
+
+    // 分块: 整段处理与按块处理逐位相同
+    audio_dsp_biquad_chain_init(&chain, coef, tc->stages);
+    memcpy(other, input, samples * sizeof(int16_t));
+    audio_dsp_biquad_chain_process(&chain, other, frames, DSP_CHECK_CHANNELS);
+    check(memcmp(fixed, other, samples * sizeof(int16_t)) == 0, tc->name, "block size invariant");
+
+    // 中途chain_swap到相同系数, 与直接处理逐位相同
+    audio_dsp_biquad_chain_init(&chain, coef, tc->stages);
+    memcpy(other, input, samples * sizeof(int16_t));
+    for (size_t done = 0; done < frames; done += DSP_CHECK_BLOCK_FRAMES)
+    {
+        size_t n = frames - done < DSP_CHECK_BLOCK_FRAMES ? frames - done : DSP_CHECK_BLOCK_FRAMES;
+        int16_t *p = other + done * DSP_CHECK_CHANNELS;
+        if (done == 10 * DSP_CHECK_BLOCK_FRAMES)
+        {
+            audio_dsp_biquad_chain_swap(&chain, coef, tc->stages, p, scratch, n, DSP_CHECK_CHANNELS);
+        }
+        else
+        {
+            audio_dsp_biquad_chain_process(&chain, p, n, DSP_CHECK_CHANNELS);
+        }
+    }
+    check(memcmp(fixed, other, samples * sizeof(int16_t)) == 0, tc->name, "swap to same coefficients");
+}
+
+void app_main(void)
+{
+    int seconds = getenv("DSP_CHECK_SECONDS") ? atoi(getenv("DSP_CHECK_SECONDS")) : 2;
+    size_t frames = (size_t)(seconds > 0 ? seconds : 2) * DSP_CHECK_RATE;
+    size_t samples = frames * DSP_CHECK_CHANNELS;
+    int16_t *input = malloc(samples * sizeof(int16_t));
+    int16_t *fixed = malloc(samples * sizeof(int16_t));
+    int16_t *other = malloc(samples * sizeof(int16_t));
+    int16_t *scratch = malloc(DSP_CHECK_BLOCK_FRAMES * DSP_CHECK_CHANNELS * sizeof(int16_t));
+    double *ref = malloc(samples * sizeof(double));
+    if (input == NULL || fixed == NULL || other == NULL || scratch == NULL || ref == NULL)
+    {
+        printf("alloc failed\n");
+        exit(1);
+    }
+    make_signal(input, frames);
+
+    printf("biquad: %zu frames @ %d Hz, bounds: max err %.2f LSB, rms err %.2f LSB, response %.2f dB\n\n", frames,
+           DSP_CHECK_RATE, DSP_CHECK_MAX_ERR_LSB, DSP_CHECK_MAX_RMS_LSB, DSP_CHECK_MAX_RESP_DB);
+    for (size_t i = 0; i < DSP_CHECK_CASES; i++)
+    {
+        run_case(&s_cases[i], input, frames, fixed, other, scratch, ref);
+    }
+    free(input);
+    free(fixed);
+    free(other);
+    free(scratch);
+    free(ref);
+
+    printf("\n%s\n", s_failures == 0 ? "all checks passed" : "FAILED");
+    exit(s_failures == 0 ? 0 : 1);
+}
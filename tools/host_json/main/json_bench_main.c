@@ -0,0 +1,374 @@
+/**
+ * @file json_bench_main.c
+ * @brief 主机JSON解析基准测试: cJSON建树取字段 vs json_stream流式提取
+ * @details 对每份文档, cJSON按原来hptts.c的做法解析整个缓冲区、按路径取字符串后释放;
+ *          json_stream按不同块大小送入(模拟HTTP_EVENT_ON_DATA), 字段直接拷贝到固定大小的缓冲区。
+ *          每种方式输出: 每次解析耗时、吞吐、每次解析的分配次数、堆峰值(不含文档本身)。
+ *          两种方式提取的字段必须一致, json_stream不能有任何分配, 否则以非0退出。
+ *
+ *          文档:
+ *            seniverse  心知天气实时天气响应 (约270字节, 含\uXXXX转义)
+ *            large      40个城市的结果, 每个带逐日预报数组 (约30KB), 目标字段在开头和末尾
+ *            JSON_BENCH_FILE指定的文件 (可选)
+ *
+ *          环境变量:
+ *            JSON_BENCH_ITERS  每种方式的解析次数 (默认2000)
+ *            JSON_BENCH_FILE   额外的测试文档
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <stdatomic.h>
+#include "esp_timer.h"
+#include "cJSON.h"
+#include "json_stream.h"
+
+#define JSON_BENCH_LARGE_RESULTS (40)
+#define JSON_BENCH_VALUE_MAX (64) // 每个字段的输出缓冲区
+
+static const char *s_paths[] = {
+    "results[0].location.id",
+    "results[0].location.name",
+    "results[0].location.country",
+    "results[0].location.path",
+    "results[0].location.timezone",
+    "results[0].location.timezone_offset",
+    "results[0].now.text",
+    "results[0].now.code",
+    "results[0].now.temperature",
+    "results[0].last_update",
+    "results[39].location.name",
+    "results[39].now.temperature",
+};
+#define JSON_BENCH_FIELDS (sizeof(s_paths) / sizeof(s_paths[0]))
+
+static const size_t s_chunks[] = {1, 16, 64, 512, 0}; // 0: 整个文档一次送入
+
+static const char s_seniverse[] =
+    "{\"results\":[{\"location\":{\"id\":\"WS0E9D8WN298\",\"name\":\"\\u5e7f\\u5dde\",\"country\":\"CN\","
+    "\"path\":\"广州,广州,广东,中国\",\"timezone\":\"Asia/Shanghai\",\"timezone_offset\":\"+08:00\"},"
+    "\"now\":{\"text\":\"多云\",\"code\":\"4\",\"temperature\":\"28\"},"
+    "\"last_update\":\"2025-09-05T15:37:36+08:00\"}]}";
+
+/* ---------- 分配计数 (链接时--wrap) ---------- */
+
+static atomic_uint s_alloc_count;
+static atomic_size_t s_heap_bytes;
+static atomic_size_t s_heap_peak;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static void *bench_track(void *ptr)
+{
+    if (ptr != NULL)
+    {
+        size_t now = atomic_fetch_add(&s_heap_bytes, malloc_usable_size(ptr)) + malloc_usable_size(ptr);
+        size_t peak = atomic_load(&s_heap_peak);
+        while (now > peak && !atomic_compare_exchange_weak(&s_heap_peak, &peak, now))
+        {
+        }
+    }
+    return ptr;
+}
+
+static void bench_untrack(void *ptr)
+{
+    if (ptr != NULL)
+    {
+        atomic_fetch_sub(&s_heap_bytes, malloc_usable_size(ptr));
+    }
+}
+
+void *__wrap_malloc(size_t size)
+{
+    atomic_fetch_add_explicit(&s_alloc_count, 1, memory_order_relaxed);
+    return bench_track(__real_malloc(size));
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    atomic_fetch_add_explicit(&s_alloc_count, 1, memory_order_relaxed);
+    return bench_track(__real_calloc(n, size));
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    atomic_fetch_add_explicit(&s_alloc_count, 1, memory_order_relaxed);
+    bench_untrack(ptr);
+    return bench_track(__real_realloc(ptr, size));
+}
+
+void __wrap_free(void *ptr)
+{
+    bench_untrack(ptr);
+    __real_free(ptr);
+}
+
+/* ---------- 文档 ---------- */
+
+static char *bench_load_file(const char *path, size_t *size)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *data = len > 0 ? malloc((size_t)len + 1) : NULL;
+    if (data != NULL && fread(data, 1, (size_t)len, f) == (size_t)len)
+    {
+        data[len] = '\0';
+        *size = (size_t)len;
+    }
+    else
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+/**
+ * @brief 生成多城市、带逐日预报的大响应
+ */
+static char *bench_make_large(size_t *size)
+{
+    static const char *texts[] = {"晴", "多云", "阴", "小雨", "雷阵雨"};
+    size_t cap = 64 * 1024;
+    char *doc = malloc(cap);
+    if (doc == NULL)
+    {
+        return NULL;
+    }
+    size_t len = (size_t)snprintf(doc, cap, "{\"results\":[");
+    for (int i = 0; i < JSON_BENCH_LARGE_RESULTS; i++)
+    {
+        len += (size_t)snprintf(doc + len, cap - len,
+                                "%s{\"location\":{\"id\":\"WS%010d\",\"name\":\"city\\u00b7%d\",\"country\":\"CN\","
+                                "\"path\":\"city%d,\\\"省\\\",中国\",\"timezone\":\"Asia/Shanghai\",\"timezone_offset\":\"+08:00\"},"
+                                "\"now\":{\"text\":\"%s\",\"code\":\"%d\",\"temperature\":\"%d\",\"feels_like\":%d,"
+                                "\"pressure\":1006.5,\"humidity\":%d,\"visibility\":25.1,\"wind\":{\"direction\":\"东南\","
+                                "\"degree\":%d,\"speed\":8.3,\"scale\":\"2\"},\"alerts\":[],\"valid\":true,\"extra\":null},\"daily\":[",
+                                i ? "," : "", i, i, i, texts[i % 5], i % 38, 15 + i % 20, 14 + i % 20, 40 + i,
+                                (i * 37) % 360);
+        for (int d = 0; d < 3; d++)
+        {
+            len += (size_t)snprintf(doc + len, cap - len,
+                                    "%s{\"date\":\"2025-09-%02d\",\"text_day\":\"%s\",\"high\":\"%d\",\"low\":\"%d\","
+                                    "\"rainfall\":\"%d.0\",\"precip\":[%d,%d,[%d]]}",
+                                    d ? "," : "", 5 + d, texts[(i + d) % 5], 25 + d, 18 + d, d, d, i, d);
+        }
+        len += (size_t)snprintf(doc + len, cap - len, "],\"last_update\":\"2025-09-05T15:%02d:36+08:00\"}", i % 60);
+    }
+    len += (size_t)snprintf(doc + len, cap - len, "]}");
+    if (len >= cap)
+    {
+        free(doc);
+        return NULL;
+    }
+    *size = len;
+    return doc;
+}
+
+/* ---------- 两种解析方式 ---------- */
+
+typedef struct
+{
+    char values[JSON_BENCH_FIELDS][JSON_BENCH_VALUE_MAX];
+    uint32_t found;
+} bench_values_t;
+
+/**
+ * @brief 按"a.b[0].c"形式的路径在cJSON树中查找
+ */
+static const cJSON *bench_cjson_find(const cJSON *node, const char *path)
+{
+    char name[JSON_STREAM_PATH_MAX];
+    while (node != NULL && *path != '\0')
+    {
+        if (*path == '[')
+        {
+            char *end;
+            long index = strtol(path + 1, &end, 10);
+            node = cJSON_GetArrayItem(node, (int)index);
+            path = end + 1;
+        }
+        else
+        {
+            size_t n = strcspn(path, ".[");
+            memcpy(name, path, n);
+            name[n] = '\0';
+            node = cJSON_GetObjectItemCaseSensitive(node, name);
+            path += n;
+        }
+        if (*path == '.')
+        {
+            path++;
+        }
+    }
+    return node;
+}
+
+static bool bench_parse_cjson(const char *doc, bench_values_t *out)
+{
+    memset(out, 0, sizeof(bench_values_t));
+    cJSON *root = cJSON_Parse(doc);
+    if (root == NULL)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < JSON_BENCH_FIELDS; i++)
+    {
+        const cJSON *item = bench_cjson_find(root, s_paths[i]);
+        if (cJSON_IsString(item))
+        {
+            snprintf(out->values[i], JSON_BENCH_VALUE_MAX, "%s", item->valuestring);
+            out->found |= 1u << i;
+        }
+    }
+    cJSON_Delete(root);
+    return true;
+}
+
+static bool bench_parse_stream(const char *doc, size_t size, size_t chunk, bench_values_t *out)
+{
+    json_stream_field_t fields[JSON_BENCH_FIELDS];
+    for (size_t i = 0; i < JSON_BENCH_FIELDS; i++)
+    {
+        fields[i] = (json_stream_field_t){s_paths[i], out->values[i], JSON_BENCH_VALUE_MAX};
+    }
+    json_stream_t js;
+    json_stream_init(&js, fields, JSON_BENCH_FIELDS);
+    size_t step = chunk ? chunk : size;
+    for (size_t off = 0; off < size; off += step)
+    {
+        size_t n = (size - off < step) ? size - off : step;
+        if (json_stream_feed(&js, doc + off, n) != ESP_OK)
+        {
+            return false;
+        }
+    }
+    out->found = js.found;
+    return json_stream_finish(&js) == ESP_OK;
+}
+
+/* ---------- 测量 ---------- */
+
+typedef struct
+{
+    double us;      // 每次解析耗时
+    double allocs;  // 每次解析的分配次数
+    size_t peak;    // 堆峰值 (字节)
+    bool ok;
+} bench_measure_t;
+
+static bench_measure_t bench_run(const char *doc, size_t size, int chunk, int iters, bench_values_t *out)
+{
+    bench_measure_t m = {.ok = true};
+    size_t base = atomic_load(&s_heap_bytes);
+    atomic_store(&s_heap_peak, base);
+    atomic_store(&s_alloc_count, 0);
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < iters && m.ok; i++)
+    {
+        m.ok = (chunk < 0) ? bench_parse_cjson(doc, out) : bench_parse_stream(doc, size, (size_t)chunk, out);
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+    m.us = (double)elapsed / iters;
+    m.allocs = (double)atomic_load(&s_alloc_count) / iters;
+    m.peak = atomic_load(&s_heap_peak) - base;
+    return m;
+}
+
+static bool bench_same(const bench_values_t *a, const bench_values_t *b)
+{
+    if (a->found != b->found)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < JSON_BENCH_FIELDS; i++)
+    {
+        if (strcmp(a->values[i], b->values[i]) != 0)
+        {
+            printf("  字段不一致 %s: \"%s\" / \"%s\"\n", s_paths[i], a->values[i], b->values[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool bench_document(const char *name, const char *doc, size_t size, int iters)
+{
+    printf("\n%s: %u 字节\n", name, (unsigned)size);
+    printf("%-12s %8s %10s %9s %10s %10s\n", "parser", "chunk", "us/parse", "MB/s", "allocs", "heap peak");
+
+    static bench_values_t ref;
+    static bench_values_t got;
+    bench_measure_t m = bench_run(doc, size, -1, iters, &ref);
+    if (!m.ok)
+    {
+        printf("cJSON解析失败\n");
+        return false;
+    }
+    printf("%-12s %8s %10.2f %9.1f %10.1f %10u  (另需%u字节缓冲整个响应)\n", "cJSON", "-", m.us, size / m.us,
+           m.allocs, (unsigned)m.peak, (unsigned)size + 1);
+
+    bool ok = true;
+    for (size_t c = 0; c < sizeof(s_chunks) / sizeof(s_chunks[0]); c++)
+    {
+        memset(&got, 0, sizeof(got));
+        m = bench_run(doc, size, (int)s_chunks[c], iters, &got);
+        char chunk[16];
+        snprintf(chunk, sizeof(chunk), s_chunks[c] ? "%u" : "all", (unsigned)s_chunks[c]);
+        bool same = m.ok && bench_same(&ref, &got);
+        printf("%-12s %8s %10.2f %9.1f %10.1f %10u  %s\n", "json_stream", chunk, m.us, size / m.us, m.allocs,
+               (unsigned)m.peak, !m.ok ? "解析失败" : (same ? "" : "结果不一致"));
+        ok = ok && same && m.allocs == 0;
+    }
+    printf("json_stream状态 %u 字节, 字段缓冲 %u 字节\n", (unsigned)sizeof(json_stream_t),
+           (unsigned)(JSON_BENCH_FIELDS * JSON_BENCH_VALUE_MAX));
+    for (size_t i = 0; i < JSON_BENCH_FIELDS; i++)
+    {
+        if (ref.found & (1u << i))
+        {
+            printf("  %-36s %s\n", s_paths[i], ref.values[i]);
+        }
+    }
+    return ok;
+}
+
+void app_main(void)
+{
+    const char *iters_env = getenv("JSON_BENCH_ITERS");
+    int iters = iters_env ? atoi(iters_env) : 2000;
+    if (iters <= 0)
+    {
+        iters = 1;
+    }
+
+    bool ok = bench_document("seniverse", s_seniverse, strlen(s_seniverse), iters);
+
+    size_t size = 0;
+    char *large = bench_make_large(&size);
+    ok = ok && large != NULL && bench_document("large", large, size, iters / 10 ? iters / 10 : 1);
+    free(large);
+
+    const char *path = getenv("JSON_BENCH_FILE");
+    if (path != NULL)
+    {
+        char *doc = bench_load_file(path, &size);
+        ok = ok && doc != NULL && bench_document(path, doc, size, iters / 10 ? iters / 10 : 1);
+        free(doc);
+    }
+
+    printf("\n%s\n", ok ? "OK" : "FAIL");
+    exit(ok ? 0 : 1);
+}
@@ -0,0 +1,52 @@
+/**
+ * @file sd_manager_host.h
+ * @brief 主机sd_card替身的配置与统计
+ * @details sd_manager_init()把FAT镜像文件注册为FatFs磁盘并挂载到"/sdcard", 然后启用真实的文件接口。
+ *          镜像不存在时按指定大小创建并格式化。替身只实现sd_manager_init/deinit和文件接口,
+ *          目录列举等VFS接口在主机上不可用。
+ */
+
+#ifndef SD_MANAGER_HOST_H
+#define SD_MANAGER_HOST_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "sd_manager.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define SD_MANAGER_HOST_SECTOR (512)            // 镜像的扇区大小, 与SD卡相同
+#define SD_MANAGER_HOST_AU SD_MANAGER_ALLOC_UNIT // 格式化时的分配单元, 与目标板相同
+#define SD_MANAGER_HOST_DEFAULT_MB (64)         // 新建镜像的默认大小
+
+    /**
+     * @brief 磁盘层统计 (FatFs到镜像文件的实际传输)
+     */
+    typedef struct
+    {
+        uint32_t read_calls;
+        uint32_t write_calls;
+        uint64_t read_sectors;
+        uint64_t write_sectors;
+    } sd_manager_host_disk_stats_t;
+
+    /**
+     * @brief 设置镜像文件, 在sd_manager_init()之前调用
+     * @param path 镜像路径
+     * @param size_mb 镜像不存在时新建的大小, 0使用SD_MANAGER_HOST_DEFAULT_MB
+     */
+    void sd_manager_host_set_image(const char *path, uint32_t size_mb);
+
+    /**
+     * @brief 获取磁盘层统计
+     */
+    void sd_manager_host_get_disk_stats(sd_manager_host_disk_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SD_MANAGER_HOST_H
@@ -0,0 +1,171 @@
+/**
+ * @file sd_manager_host.c
+ * @brief 主机sd_card替身: FAT镜像文件作为FatFs磁盘
+ * @details 磁盘读写直接pread/pwrite镜像文件, 文件接口(sd_manager_io.c)与目标板完全相同,
+ *          测得的耗时只包含I/O层和FatFs本身的开销。
+ */
+
+#include "sd_manager.h"
+#include "sd_manager_io.h"
+#include "sd_manager_host.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "ff.h"
+#include "diskio_impl.h"
+
+#define TAG "sd_manager_host"
+#define MOUNT_POINT "/sdcard"
+
+static const char *s_image = "sd.img";
+static uint32_t s_size_mb = SD_MANAGER_HOST_DEFAULT_MB;
+static int s_fd = -1;
+static uint32_t s_sectors;
+static uint8_t s_pdrv = 0xFF;
+static FATFS s_fs;
+static sd_manager_host_disk_stats_t s_disk_stats;
+
+static DSTATUS img_init(unsigned char pdrv)
+{
+    return (s_fd >= 0) ? 0 : STA_NOINIT;
+}
+
+static DSTATUS img_status(unsigned char pdrv)
+{
+    return (s_fd >= 0) ? 0 : STA_NOINIT;
+}
+
+static DRESULT img_read(unsigned char pdrv, unsigned char *buff, uint32_t sector, unsigned count)
+{
+    size_t len = (size_t)count * SD_MANAGER_HOST_SECTOR;
+    s_disk_stats.read_calls++;
+    s_disk_stats.read_sectors += count;
+    return pread(s_fd, buff, len, (off_t)sector * SD_MANAGER_HOST_SECTOR) == (ssize_t)len ? RES_OK : RES_ERROR;
+}
+
+static DRESULT img_write(unsigned char pdrv, const unsigned char *buff, uint32_t sector, unsigned count)
+{
+    size_t len = (size_t)count * SD_MANAGER_HOST_SECTOR;
+    s_disk_stats.write_calls++;
+    s_disk_stats.write_sectors += count;
+    return pwrite(s_fd, buff, len, (off_t)sector * SD_MANAGER_HOST_SECTOR) == (ssize_t)len ? RES_OK : RES_ERROR;
+}
+
+static DRESULT img_ioctl(unsigned char pdrv, unsigned char cmd, void *buff)
+{
+    switch (cmd)
+    {
+    case CTRL_SYNC:
+        return RES_OK;
+    case GET_SECTOR_COUNT:
+        *(LBA_t *)buff = s_sectors;
+        return RES_OK;
+    case GET_SECTOR_SIZE:
+        *(WORD *)buff = SD_MANAGER_HOST_SECTOR;
+        return RES_OK;
+    case GET_BLOCK_SIZE:
+        *(DWORD *)buff = 1;
+        return RES_OK;
+    default:
+        return RES_PARERR;
+    }
+}
+
+static const ff_diskio_impl_t s_img_impl = {
+    .init = img_init,
+    .status = img_status,
+    .read = img_read,
+    .write = img_write,
+    .ioctl = img_ioctl,
+};
+
+void sd_manager_host_set_image(const char *path, uint32_t size_mb)
+{
+    s_image = path;
+    s_size_mb = (size_mb > 0) ? size_mb : SD_MANAGER_HOST_DEFAULT_MB;
+}
+
+void sd_manager_host_get_disk_stats(sd_manager_host_disk_stats_t *stats)
+{
+    *stats = s_disk_stats;
+}
+
+/**
+ * @brief 格式化新建的镜像 (单分区FAT, 分配单元与目标板相同)
+ */
+static FRESULT img_format(const char *drv)
+{
+    MKFS_PARM opt = {
+        .fmt = FM_ANY | FM_SFD,
+        .au_size = SD_MANAGER_HOST_AU,
+    };
+    void *work = malloc(FF_MAX_SS);
+    if (work == NULL)
+    {
+        return FR_NOT_ENOUGH_CORE;
+    }
+    FRESULT fr = f_mkfs(drv, &opt, work, FF_MAX_SS);
+    free(work);
+    return fr;
+}
+
+esp_err_t sd_manager_init(void)
+{
+    bool created = false;
+    s_fd = open(s_image, O_RDWR);
+    if (s_fd < 0)
+    {
+        s_fd = open(s_image, O_RDWR | O_CREAT, 0644);
+        if (s_fd < 0 || ftruncate(s_fd, (off_t)s_size_mb * 1024 * 1024) != 0)
+        {
+            ESP_LOGE(TAG, "无法创建镜像: %s", s_image);
+            sd_manager_deinit();
+            return ESP_FAIL;
+        }
+        created = true;
+    }
+    s_sectors = (uint32_t)(lseek(s_fd, 0, SEEK_END) / SD_MANAGER_HOST_SECTOR);
+
+    if (ff_diskio_get_drive(&s_pdrv) != ESP_OK)
+    {
+        sd_manager_deinit();
+        return ESP_ERR_NO_MEM;
+    }
+    ff_diskio_register(s_pdrv, &s_img_impl);
+
+    char drv[3] = {(char)('0' + s_pdrv), ':', 0};
+    FRESULT fr = created ? img_format(drv) : FR_OK;
+    if (fr == FR_OK)
+    {
+        fr = f_mount(&s_fs, drv, 1);
+    }
+    if (fr != FR_OK)
+    {
+        ESP_LOGE(TAG, "镜像挂载失败: %s (FRESULT=%d)", s_image, fr);
+        sd_manager_deinit();
+        return ESP_FAIL;
+    }
+
+    memset(&s_disk_stats, 0, sizeof(s_disk_stats));
+    return sd_manager_io_init(s_pdrv, MOUNT_POINT);
+}
+
+void sd_manager_deinit(void)
+{
+    sd_manager_io_deinit();
+    if (s_pdrv != 0xFF)
+    {
+        char drv[3] = {(char)('0' + s_pdrv), ':', 0};
+        f_mount(NULL, drv, 0);
+        ff_diskio_register(s_pdrv, NULL);
+        s_pdrv = 0xFF;
+    }
+    if (s_fd >= 0)
+    {
+        close(s_fd);
+        s_fd = -1;
+    }
+}
@@ -0,0 +1,664 @@
+/**
+ * @file sd_host_main.c
+ * @brief 主机上检查sd_manager文件接口
+ * @details 在FAT镜像上依次执行: 建目录 -> 整块写入 -> 取大小 -> 直接读回并校验 -> writer不规则追加并校验
+ *          -> 异步读(回调和任务通知两种完成方式) -> I/O调度(类别优先级、相邻请求合并)
+ *          -> 目录列表(排序、过滤、分页、缓存命中和写入后失效)
+ *          -> 派生数据缓存(键、读写、流式写入、LRU淘汰、取得的条目不淘汰、重新打开后恢复) -> 删除,
+ *          最后打印每类操作和每个优先级类别的统计以及磁盘层传输次数。
+ *          任一步失败时以非0退出。
+ *          设置SD_BENCH时改为运行基准测试 (sd_manager_bench.h), 打印结果表格和磁盘层传输次数。
+ *
+ *          环境变量:
+ *            SD_IMAGE     镜像路径 (默认 ./sd.img, 不存在时新建并格式化)
+ *            SD_IMAGE_MB  新建镜像的大小 (默认64)
+ *            SD_BENCH     非空时运行基准测试而不是接口检查
+ *            SD_BENCH_KB  基准测试文件大小 (默认1024)
+ *            SD_BENCH_CSV 基准测试结果另存为CSV
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "sd_manager.h"
+#include "sd_manager_host.h"
+#include "sd_manager_bench.h"
+#include "sd_manager_cache.h"
+
+#define SD_HOST_DIR "/sdcard/host_check"
+#define SD_HOST_FILE SD_HOST_DIR "/data.bin"
+#define SD_HOST_FILE_BYTES (1024 * 1024 + 123) // 不是扇区整数倍, 覆盖首尾不满一扇区的情况
+
+#define SD_HOST_BG_REQUESTS (6)                // 调度检查: 先于音频请求提交的后台整文件读取数
+#define SD_HOST_CHUNK (4096)                   // 调度检查: 按偏移读取的块大小
+#define SD_HOST_LIST_DIR SD_HOST_DIR "/list"
+#define SD_HOST_LIST_FILES (40)                // 目录检查: .wav文件数, 另有3个.mp3、1个子目录和1个隐藏文件
+#define SD_HOST_LIST_PAGE (7)                  // 目录检查: 每页条目数, 不整除总数
+#define SD_HOST_CACHE_DIR SD_HOST_DIR "/cache"
+#define SD_HOST_CACHE_BUDGET (64 * 1024)       // 缓存检查: 预算, 放得下4个SD_HOST_CACHE_ITEM
+#define SD_HOST_CACHE_ITEM (16 * 1024)
+
+static const char *s_op_names[SD_MANAGER_OP_MAX] = {"read", "write", "mkdir", "delete", "size", "listdir", "rename"};
+static const char *s_class_names[SD_MANAGER_CLASS_MAX] = {"audio", "record", "ui", "bg"};
+
+// 完成顺序: 后台请求记为0..N-1, 音频请求记为100
+static volatile int s_done_order[SD_HOST_BG_REQUESTS + 1];
+static volatile int s_done_count;
+
+static void fill_pattern(uint8_t *buf, size_t len, uint32_t seed)
+{
+    uint32_t x = seed;
+    for (size_t i = 0; i < len; i++)
+    {
+        x = x * 1664525u + 1013904223u;
+        buf[i] = (uint8_t)(x >> 24);
+    }
+}
+
+static void check(bool ok, const char *what)
+{
+    printf("%-32s %s\n", what, ok ? "OK" : "FAIL");
+    if (!ok)
+    {
+        sd_manager_deinit();
+        exit(1);
+    }
+}
+
+static void async_done_cb(esp_err_t ret, size_t bytes, void *arg)
+{
+    *(size_t *)arg = (ret == ESP_OK) ? bytes : 0;
+}
+
+static void order_cb(esp_err_t ret, size_t bytes, void *arg)
+{
+    s_done_order[s_done_count++] = (int)(intptr_t)arg;
+}
+
+// 闸门请求的回调阻塞I/O任务, 直到检查把要比较的请求全部排好队
+static void gate_cb(esp_err_t ret, size_t bytes, void *arg)
+{
+    xSemaphoreTake((SemaphoreHandle_t)arg, portMAX_DELAY);
+}
+
+static SemaphoreHandle_t gate_close(uint8_t *buf)
+{
+    SemaphoreHandle_t gate = xSemaphoreCreateBinary();
+    sd_manager_read_file_async(SD_HOST_FILE, buf, 16, SD_MANAGER_CLASS_AUDIO, gate_cb, gate);
+    return gate;
+}
+
+/**
+ * @brief 先排一批后台整文件读取, 再排一个音频读取, 音频请求应最先完成
+ */
+static bool check_priority(const uint8_t *src, uint8_t *dst)
+{
+    sd_manager_file_t *f = NULL;
+    if (sd_manager_file_open(SD_HOST_FILE, false, &f) != ESP_OK)
+    {
+        return false;
+    }
+
+    uint8_t gate_buf[16];
+    SemaphoreHandle_t gate = gate_close(gate_buf);
+    s_done_count = 0;
+    for (int i = 0; i < SD_HOST_BG_REQUESTS; i++)
+    {
+        sd_manager_read_file_async(SD_HOST_FILE, dst, SD_HOST_FILE_BYTES, SD_MANAGER_CLASS_BACKGROUND, order_cb,
+                                   (void *)(intptr_t)i);
+    }
+    uint8_t chunk[SD_HOST_CHUNK];
+    esp_err_t ret = sd_manager_file_read_async(f, 0, chunk, sizeof(chunk), SD_MANAGER_CLASS_AUDIO, order_cb,
+                                               (void *)(intptr_t)100);
+    xSemaphoreGive(gate);
+    while (ret == ESP_OK && s_done_count < SD_HOST_BG_REQUESTS + 1)
+    {
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    vSemaphoreDelete(gate);
+    sd_manager_file_close(f);
+    return ret == ESP_OK && s_done_order[0] == 100 && memcmp(chunk, src, sizeof(chunk)) == 0;
+}
+
+// 同步整文件读取在另一个任务中进行
+static volatile bool s_sync_done;
+static esp_err_t s_sync_ret;
+static size_t s_sync_got;
+
+static void sync_read_task(void *arg)
+{
+    s_sync_ret = sd_manager_read_file(SD_HOST_FILE, arg, SD_HOST_FILE_BYTES, &s_sync_got);
+    s_sync_done = true;
+    vTaskDelete(NULL);
+}
+
+static void audio_vs_sync_cb(esp_err_t ret, size_t bytes, void *arg)
+{
+    // 音频请求完成时同步读取应该还在进行
+    *(volatile int *)arg = (ret == ESP_OK && bytes == SD_HOST_CHUNK && !s_sync_done) ? 1 : -1;
+}
+
+/**
+ * @brief 同步接口的大文件读取排在音频读取前面: 它作为后台请求分片执行, 音频读取只等一片
+ */
+static bool check_sync_priority(const uint8_t *src, uint8_t *dst)
+{
+    sd_manager_file_t *f = NULL;
+    if (sd_manager_file_open(SD_HOST_FILE, false, &f) != ESP_OK)
+    {
+        return false;
+    }
+
+    sd_manager_stats_t st;
+    sd_manager_get_stats(&st);
+    uint32_t bg_pending = st.cls[SD_MANAGER_CLASS_BACKGROUND].pending;
+    uint8_t gate_buf[16];
+    SemaphoreHandle_t gate = gate_close(gate_buf);
+    s_sync_done = false;
+    memset(dst, 0, SD_HOST_FILE_BYTES);
+    xTaskCreate(sync_read_task, "sync_read", 4096, dst, 5, NULL);
+    while (st.cls[SD_MANAGER_CLASS_BACKGROUND].pending == bg_pending)
+    {
+        vTaskDelay(pdMS_TO_TICKS(1));
+        sd_manager_get_stats(&st);
+    }
+
+    volatile int audio = 0;
+    uint8_t chunk[SD_HOST_CHUNK];
+    esp_err_t ret = sd_manager_file_read_async(f, 0, chunk, sizeof(chunk), SD_MANAGER_CLASS_AUDIO, audio_vs_sync_cb,
+                                               (void *)&audio);
+    xSemaphoreGive(gate);
+    while (!s_sync_done || (ret == ESP_OK && audio == 0))
+    {
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    vSemaphoreDelete(gate);
+    sd_manager_file_close(f);
+    return ret == ESP_OK && audio == 1 && memcmp(chunk, src, sizeof(chunk)) == 0 && s_sync_ret == ESP_OK &&
+           s_sync_got == SD_HOST_FILE_BYTES && memcmp(src, dst, SD_HOST_FILE_BYTES) == 0;
+}
+
+/**
+ * @brief 同一句柄上偏移和缓冲区都相邻的读请求应合并成一次传输, 且数据正确
+ */
+static bool check_merge(const uint8_t *src, uint8_t *dst)
+{
+    sd_manager_file_t *f = NULL;
+    if (sd_manager_file_open(SD_HOST_FILE, false, &f) != ESP_OK)
+    {
+        return false;
+    }
+
+    sd_manager_stats_t before;
+    sd_manager_get_stats(&before);
+    memset(dst, 0, SD_HOST_FILE_BYTES);
+    volatile size_t bytes[8] = {0};
+    uint8_t gate_buf[16];
+    SemaphoreHandle_t gate = gate_close(gate_buf);
+    for (int i = 0; i < 8; i++)
+    {
+        sd_manager_file_read_async(f, (uint32_t)i * SD_HOST_CHUNK, dst + i * SD_HOST_CHUNK, SD_HOST_CHUNK,
+                                   SD_MANAGER_CLASS_RECORD, async_done_cb, (void *)&bytes[i]);
+    }
+    xSemaphoreGive(gate);
+
+    bool done = false;
+    while (!done)
+    {
+        vTaskDelay(pdMS_TO_TICKS(1));
+        done = true;
+        for (int i = 0; i < 8; i++)
+        {
+            done = done && bytes[i] == SD_HOST_CHUNK;
+        }
+    }
+    vSemaphoreDelete(gate);
+    sd_manager_file_close(f);
+
+    sd_manager_stats_t after;
+    sd_manager_get_stats(&after);
+    uint32_t merged = after.cls[SD_MANAGER_CLASS_RECORD].merged - before.cls[SD_MANAGER_CLASS_RECORD].merged;
+    return merged == 7 && memcmp(src, dst, 8 * SD_HOST_CHUNK) == 0;
+}
+
+/**
+ * @brief 录音的写法: 句柄上按偏移写入, 回写文件头并同步, 最后截断到实际长度
+ */
+static bool check_write_at(const uint8_t *src, uint8_t *dst)
+{
+    const char *path = SD_HOST_DIR "/rec.bin";
+    sd_manager_file_t *f = NULL;
+    if (sd_manager_file_open(path, true, &f) != ESP_OK)
+    {
+        return false;
+    }
+    bool ok = sd_manager_file_write(f, 0, src, 4 * SD_HOST_CHUNK, SD_MANAGER_CLASS_RECORD) == ESP_OK &&
+              sd_manager_file_write(f, 0, src + 100, 16, SD_MANAGER_CLASS_RECORD) == ESP_OK &&
+              sd_manager_file_sync(f) == ESP_OK && sd_manager_file_truncate(f, 3 * SD_HOST_CHUNK) == ESP_OK;
+    ok = (sd_manager_file_close(f) == ESP_OK) && ok;
+
+    size_t size = 0;
+    size_t got = 0;
+    memset(dst, 0, 4 * SD_HOST_CHUNK);
+    ok = ok && sd_manager_get_file_size(path, &size) == ESP_OK && size == 3 * SD_HOST_CHUNK &&
+         sd_manager_read_file(path, dst, 4 * SD_HOST_CHUNK, &got) == ESP_OK && got == size &&
+         memcmp(dst, src + 100, 16) == 0 && memcmp(dst + 16, src + 16, size - 16) == 0;
+
+    // 只读句柄不能截断
+    if (ok && sd_manager_file_open(path, false, &f) == ESP_OK)
+    {
+        ok = sd_manager_file_truncate(f, 0) == ESP_ERR_INVALID_STATE;
+        sd_manager_file_close(f);
+    }
+    return sd_manager_delete_file(path) == ESP_OK && ok;
+}
+
+/**
+ * @brief 按页读完整个列表
+ */
+static uint32_t read_all(sd_manager_dir_t *dir, sd_manager_dir_entry_t *all, uint32_t cap)
+{
+    uint32_t total = 0;
+    uint32_t n = 0;
+    do
+    {
+        sd_manager_dir_entry_t page[SD_HOST_LIST_PAGE];
+        sd_manager_dir_read(dir, total, page, SD_HOST_LIST_PAGE, &n);
+        for (uint32_t i = 0; i < n && total < cap; i++)
+        {
+            all[total++] = page[i];
+        }
+    } while (n == SD_HOST_LIST_PAGE);
+    return total;
+}
+
+static bool check_dir_list(const uint8_t *src)
+{
+    char path[SD_MANAGER_PATH_MAX];
+    bool ok = sd_manager_create_dir(SD_HOST_LIST_DIR) == ESP_OK &&
+              sd_manager_create_dir(SD_HOST_LIST_DIR "/sub") == ESP_OK &&
+              sd_manager_write_file(SD_HOST_LIST_DIR "/.hidden", src, 1) == ESP_OK;
+    // 写入顺序与名称顺序相反, 大小与名称无关
+    for (int i = SD_HOST_LIST_FILES - 1; ok && i >= 0; i--)
+    {
+        snprintf(path, sizeof(path), SD_HOST_LIST_DIR "/f%02d.wav", i);
+        ok = sd_manager_write_file(path, src, (size_t)((i * 7919) % 1000 + 1)) == ESP_OK;
+    }
+    for (int i = 0; ok && i < 3; i++)
+    {
+        snprintf(path, sizeof(path), SD_HOST_LIST_DIR "/m%d.MP3", i);
+        ok = sd_manager_write_file(path, src, 10) == ESP_OK;
+    }
+    if (!ok)
+    {
+        return false;
+    }
+
+    sd_manager_dir_entry_t all[SD_HOST_LIST_FILES + 8];
+    sd_manager_dir_t *dir = NULL;
+
+    // 名称排序, 目录在前, 分页读取
+    sd_manager_dir_opts_t opts = {.sort = SD_MANAGER_SORT_NAME, .dirs_first = true};
+    ok = sd_manager_dir_open(SD_HOST_LIST_DIR "/", &opts, &dir) == ESP_OK;
+    uint32_t n = ok ? read_all(dir, all, SD_HOST_LIST_FILES + 8) : 0;
+    ok = ok && n == SD_HOST_LIST_FILES + 4 && sd_manager_dir_count(dir) == n && all[0].is_dir &&
+         strcmp(all[0].name, "sub") == 0 && strcmp(all[1].name, "f00.wav") == 0 && all[1].size == 1 &&
+         strcmp(all[n - 1].name, "m2.MP3") == 0;
+    for (uint32_t i = 2; ok && i < n; i++)
+    {
+        ok = strcasecmp(all[i - 1].name, all[i].name) < 0;
+    }
+    sd_manager_dir_close(dir);
+    printf("  list by name: %u entries, first '%s', last '%s'\n", (unsigned)n, n ? all[0].name : "", n ? all[n - 1].name : "");
+
+    // 大小降序, 只列文件
+    sd_manager_dir_opts_t by_size = {.sort = SD_MANAGER_SORT_SIZE, .descending = true, .type = SD_MANAGER_DIR_FILES_ONLY};
+    ok = ok && sd_manager_dir_open(SD_HOST_LIST_DIR, &by_size, &dir) == ESP_OK;
+    n = ok ? read_all(dir, all, SD_HOST_LIST_FILES + 8) : 0;
+    ok = ok && n == SD_HOST_LIST_FILES + 3;
+    for (uint32_t i = 1; ok && i < n; i++)
+    {
+        ok = all[i - 1].size >= all[i].size && !all[i].is_dir;
+    }
+    sd_manager_dir_close(dir);
+
+    // 扩展名过滤不区分大小写, 隐藏文件只在show_hidden时列出
+    sd_manager_dir_opts_t mp3 = {.type = SD_MANAGER_DIR_FILES_ONLY, .extensions = "flac;mp3"};
+    ok = ok && sd_manager_dir_open(SD_HOST_LIST_DIR, &mp3, &dir) == ESP_OK && sd_manager_dir_count(dir) == 3;
+    sd_manager_dir_close(dir);
+    sd_manager_dir_opts_t hidden = {.show_hidden = true};
+    ok = ok && sd_manager_dir_open(SD_HOST_LIST_DIR, &hidden, &dir) == ESP_OK &&
+         sd_manager_dir_count(dir) == SD_HOST_LIST_FILES + 5;
+    sd_manager_dir_close(dir);
+
+    // 再次打开命中缓存, 不读卡; 写入新文件后失效
+    sd_manager_stats_t before, after;
+    sd_manager_get_stats(&before);
+    ok = ok && sd_manager_dir_open(SD_HOST_LIST_DIR, &opts, &dir) == ESP_OK;
+    sd_manager_dir_close(dir);
+    sd_manager_get_stats(&after);
+    ok = ok && after.dir_cache_hits == before.dir_cache_hits + 1 &&
+         after.op[SD_MANAGER_OP_LIST_DIR].calls == before.op[SD_MANAGER_OP_LIST_DIR].calls;
+
+    ok = ok && sd_manager_write_file(SD_HOST_LIST_DIR "/new.wav", src, 5) == ESP_OK &&
+         sd_manager_dir_open(SD_HOST_LIST_DIR, &opts, &dir) == ESP_OK &&
+         sd_manager_dir_count(dir) == SD_HOST_LIST_FILES + 5;
+    sd_manager_dir_close(dir);
+    sd_manager_get_stats(&before);
+    ok = ok && before.dir_cache_misses == after.dir_cache_misses + 1;
+
+    // 清理
+    for (int i = 0; i < SD_HOST_LIST_FILES; i++)
+    {
+        snprintf(path, sizeof(path), SD_HOST_LIST_DIR "/f%02d.wav", i);
+        sd_manager_delete_file(path);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        snprintf(path, sizeof(path), SD_HOST_LIST_DIR "/m%d.MP3", i);
+        sd_manager_delete_file(path);
+    }
+    sd_manager_delete_file(SD_HOST_LIST_DIR "/new.wav");
+    sd_manager_delete_file(SD_HOST_LIST_DIR "/.hidden");
+    sd_manager_delete_file(SD_HOST_LIST_DIR "/sub");
+    ok = ok && sd_manager_dir_open(SD_HOST_LIST_DIR, NULL, &dir) == ESP_OK && sd_manager_dir_count(dir) == 0;
+    sd_manager_dir_close(dir);
+    return ok && sd_manager_delete_file(SD_HOST_LIST_DIR) == ESP_OK;
+}
+
+/**
+ * @brief 缓存目录中残留的临时文件数
+ */
+static uint32_t count_cache_tmp(void)
+{
+    sd_manager_dir_t *dir = NULL;
+    sd_manager_dir_opts_t tmp = {.type = SD_MANAGER_DIR_FILES_ONLY, .extensions = "tmp"};
+    if (sd_manager_dir_open(SD_HOST_CACHE_DIR, &tmp, &dir) != ESP_OK)
+    {
+        return UINT32_MAX;
+    }
+    uint32_t n = sd_manager_dir_count(dir);
+    sd_manager_dir_close(dir);
+    return n;
+}
+
+static bool check_cache(const uint8_t *src, uint8_t *dst)
+{
+    bool ok = sd_manager_cache_init(SD_HOST_CACHE_DIR, SD_HOST_CACHE_BUDGET) == ESP_OK &&
+              sd_manager_cache_clear() == ESP_OK;
+    sd_manager_cache_reset_stats();
+    sd_manager_stats_t io_before;
+    sd_manager_get_stats(&io_before);
+
+    // 键: 同一个源的不同变体不同, 源文件改写后不同
+    sd_manager_cache_key_t ka = 0, kb = 0, kc = 0;
+    ok = ok && sd_manager_cache_key_file(SD_HOST_FILE, "thumb:96", &ka) == ESP_OK &&
+         sd_manager_cache_key_file(SD_HOST_FILE, "peaks", &kb) == ESP_OK && ka != kb &&
+         sd_manager_cache_key_make("a", 1, 2, "v") == sd_manager_cache_key_make("a", 1, 2, "v") &&
+         sd_manager_cache_key_make("a", 1, 2, "v") != sd_manager_cache_key_make("a", 1, 3, "v") &&
+         sd_manager_cache_key_make("ab", 1, 2, NULL) != sd_manager_cache_key_make("a", 1, 2, "b");
+    ok = ok && sd_manager_cache_key_file(SD_HOST_DIR "/missing.wav", NULL, &kc) == ESP_ERR_NOT_FOUND;
+    kc = sd_manager_cache_key_make("https://example.com/weather", 0, 1, NULL);
+
+    // 未命中 -> 写入 -> 命中
+    size_t got = 0;
+    ok = ok && sd_manager_cache_read(ka, dst, SD_HOST_FILE_BYTES, &got) == ESP_ERR_NOT_FOUND;
+    ok = ok && sd_manager_cache_put(ka, src, 10000) == ESP_OK &&
+         sd_manager_cache_read(ka, dst, SD_HOST_FILE_BYTES, &got) == ESP_OK && got == 10000 &&
+         memcmp(src, dst, got) == 0;
+
+    // 流式写入, 提交前不可见
+    sd_manager_cache_txn_t *txn = NULL;
+    ok = ok && sd_manager_cache_begin(kb, 0, &txn) == ESP_OK;
+    for (size_t off = 0; ok && off < 20000; off += 999)
+    {
+        ok = sd_manager_cache_append(txn, src + off, (20000 - off < 999) ? 20000 - off : 999) == ESP_OK;
+    }
+    ok = ok && sd_manager_cache_read(kb, dst, SD_HOST_FILE_BYTES, &got) == ESP_ERR_NOT_FOUND;
+    ok = ok && sd_manager_cache_commit(txn) == ESP_OK &&
+         sd_manager_cache_read(kb, dst, SD_HOST_FILE_BYTES, &got) == ESP_OK && got == 20000 &&
+         memcmp(src, dst, got) == 0;
+    ok = ok && sd_manager_cache_begin(kc, 0, &txn) == ESP_OK && sd_manager_cache_append(txn, src, 100) == ESP_OK;
+    if (txn != NULL)
+    {
+        sd_manager_cache_abort(txn);
+    }
+    ok = ok && count_cache_tmp() == 0;
+
+    // 超过预算: 取得ka后写入更多条目, kb最久未用先被淘汰, 取得的ka保留
+    char path[SD_MANAGER_PATH_MAX];
+    ok = ok && sd_manager_cache_acquire(ka, path, sizeof(path), NULL) == ESP_OK;
+    for (uint32_t i = 0; ok && i < 4; i++)
+    {
+        ok = sd_manager_cache_put(sd_manager_cache_key_make("item", i, 0, NULL), src + i, SD_HOST_CACHE_ITEM) == ESP_OK;
+    }
+    sd_manager_cache_stats_t st;
+    sd_manager_cache_get_stats(&st);
+    ok = ok && st.used_bytes <= SD_HOST_CACHE_BUDGET && st.evictions >= 2 &&
+         sd_manager_cache_read(kb, dst, SD_HOST_FILE_BYTES, &got) == ESP_ERR_NOT_FOUND &&
+         sd_manager_cache_remove(ka) == ESP_ERR_INVALID_STATE;
+    // 替换时放不下: 其余条目都被取得, 换成更大的item1需要的淘汰做不到, 旧的item1保留
+    sd_manager_cache_key_t item1 = sd_manager_cache_key_make("item", 1, 0, NULL);
+    sd_manager_cache_key_t item2 = sd_manager_cache_key_make("item", 2, 0, NULL);
+    sd_manager_cache_key_t item3 = sd_manager_cache_key_make("item", 3, 0, NULL);
+    ok = ok && sd_manager_cache_acquire(item2, NULL, 0, NULL) == ESP_OK &&
+         sd_manager_cache_acquire(item3, NULL, 0, NULL) == ESP_OK;
+    ok = ok && sd_manager_cache_put(item1, src, SD_HOST_CACHE_ITEM + 10000) == ESP_ERR_NO_MEM &&
+         sd_manager_cache_read(item1, dst, SD_HOST_FILE_BYTES, &got) == ESP_OK && got == SD_HOST_CACHE_ITEM &&
+         memcmp(src + 1, dst, SD_HOST_CACHE_ITEM) == 0;
+    sd_manager_cache_release(item3);
+    sd_manager_cache_release(item2);
+    sd_manager_cache_release(ka);
+    ok = ok && sd_manager_cache_put(kc, src, SD_HOST_CACHE_BUDGET + 1) == ESP_ERR_INVALID_SIZE && count_cache_tmp() == 0;
+    printf("  cache: %u entries, %llu bytes, %u evictions\n", (unsigned)st.entries, (unsigned long long)st.used_bytes,
+           (unsigned)st.evictions);
+
+    // 重新打开: 条目和使用顺序从清单恢复。此时item0已被淘汰, 读一次item1后使用顺序是 ka < item2 < item3 < item1,
+    // 放入更大的条目要淘汰ka和item2
+    ok = ok && sd_manager_cache_read(item1, dst, SD_HOST_FILE_BYTES, &got) == ESP_OK &&
+         memcmp(src + 1, dst, SD_HOST_CACHE_ITEM) == 0;
+    sd_manager_cache_deinit();
+    // 模拟发布前断电留下的临时文件, 重新打开时删除
+    ok = ok && sd_manager_write_file(SD_HOST_CACHE_DIR "/0123456789abcdef_7.tmp", src, 100) == ESP_OK;
+    sd_manager_cache_stats_t reopened;
+    ok = ok && sd_manager_cache_init(SD_HOST_CACHE_DIR, SD_HOST_CACHE_BUDGET) == ESP_OK && count_cache_tmp() == 0;
+    sd_manager_cache_get_stats(&reopened);
+    ok = ok && reopened.entries == st.entries && reopened.used_bytes == st.used_bytes &&
+         sd_manager_cache_put(kc, src, SD_HOST_CACHE_ITEM + 10000) == ESP_OK &&
+         sd_manager_cache_read(ka, dst, SD_HOST_FILE_BYTES, &got) == ESP_ERR_NOT_FOUND &&
+         sd_manager_cache_read(item2, dst, SD_HOST_FILE_BYTES, &got) == ESP_ERR_NOT_FOUND &&
+         sd_manager_cache_read(item1, dst, SD_HOST_FILE_BYTES, &got) == ESP_OK &&
+         sd_manager_cache_read(item3, dst, SD_HOST_FILE_BYTES, &got) == ESP_OK;
+
+    ok = ok && sd_manager_cache_clear() == ESP_OK;
+    sd_manager_cache_get_stats(&st);
+    // 条目和清单的读写都作为后台请求经过I/O调度
+    sd_manager_stats_t io_after;
+    sd_manager_get_stats(&io_after);
+    uint32_t io_bg = io_after.cls[SD_MANAGER_CLASS_BACKGROUND].requests - io_before.cls[SD_MANAGER_CLASS_BACKGROUND].requests;
+    uint32_t io_ops = (io_after.op[SD_MANAGER_OP_READ].calls - io_before.op[SD_MANAGER_OP_READ].calls) +
+                      (io_after.op[SD_MANAGER_OP_WRITE].calls - io_before.op[SD_MANAGER_OP_WRITE].calls);
+    return ok && st.entries == 0 && st.used_bytes == 0 && io_bg > 0 && io_bg == io_ops;
+}
+
+static void print_stats(void)
+{
+    sd_manager_stats_t st;
+    sd_manager_get_stats(&st);
+    printf("\n%-8s %8s %8s %12s %10s %10s %10s\n", "op", "calls", "errors", "bytes", "avg_us", "max_us", "MB/s");
+    for (int i = 0; i < SD_MANAGER_OP_MAX; i++)
+    {
+        const sd_manager_op_stats_t *o = &st.op[i];
+        double avg = o->calls ? (double)o->total_us / o->calls : 0;
+        double mbps = o->total_us ? (double)o->bytes / o->total_us : 0;
+        printf("%-8s %8u %8u %12llu %10.1f %10u %10.2f\n", s_op_names[i], (unsigned)o->calls, (unsigned)o->errors,
+               (unsigned long long)o->bytes, avg, (unsigned)o->max_us, mbps);
+    }
+
+    printf("\n%-8s %8s %8s %8s %10s %10s\n", "class", "requests", "merged", "rejected", "wait_avg", "wait_max");
+    for (int c = 0; c < SD_MANAGER_CLASS_MAX; c++)
+    {
+        const sd_manager_class_stats_t *k = &st.cls[c];
+        double avg = k->requests ? (double)k->wait_total_us / k->requests : 0;
+        printf("%-8s %8u %8u %8u %10.1f %10u\n", s_class_names[c], (unsigned)k->requests, (unsigned)k->merged,
+               (unsigned)k->rejected, avg, (unsigned)k->wait_max_us);
+    }
+
+    printf("\ndir cache: %u hits, %u misses\n", (unsigned)st.dir_cache_hits, (unsigned)st.dir_cache_misses);
+
+    sd_manager_cache_stats_t cs;
+    sd_manager_cache_get_stats(&cs);
+    printf("artifact cache: %u hits, %u misses, %u puts (%llu bytes), %u put errors, %u evictions (%llu bytes)\n",
+           (unsigned)cs.hits, (unsigned)cs.misses, (unsigned)cs.puts, (unsigned long long)cs.put_bytes,
+           (unsigned)cs.put_errors, (unsigned)cs.evictions, (unsigned long long)cs.evicted_bytes);
+
+    sd_manager_host_disk_stats_t disk;
+    sd_manager_host_get_disk_stats(&disk);
+    printf("\ndisk: %u reads / %llu sectors, %u writes / %llu sectors\n", (unsigned)disk.read_calls,
+           (unsigned long long)disk.read_sectors, (unsigned)disk.write_calls, (unsigned long long)disk.write_sectors);
+}
+
+/**
+ * @brief 基准测试模式, 成功时返回0
+ */
+static int run_bench(void)
+{
+    sd_manager_bench_result_t *results = malloc(SD_MANAGER_BENCH_MAX_RESULTS * sizeof(sd_manager_bench_result_t));
+    if (results == NULL)
+    {
+        return 1;
+    }
+    sd_manager_bench_config_t cfg = {
+        .dir = SD_HOST_DIR "/bench",
+        .file_bytes = getenv("SD_BENCH_KB") ? (uint32_t)atoi(getenv("SD_BENCH_KB")) * 1024 : 0,
+    };
+    char label[32];
+    snprintf(label, sizeof(label), "host_au%dk", SD_MANAGER_HOST_AU / 1024);
+
+    size_t count = 0;
+    esp_err_t ret = sd_manager_create_dir(SD_HOST_DIR);
+    ret = (ret == ESP_OK) ? sd_manager_bench_run(&cfg, results, SD_MANAGER_BENCH_MAX_RESULTS, &count) : ret;
+    if (ret == ESP_OK)
+    {
+        sd_manager_bench_print(stdout, results, count, label);
+        const char *csv = getenv("SD_BENCH_CSV");
+        FILE *f = csv ? fopen(csv, "w") : NULL;
+        if (f != NULL)
+        {
+            sd_manager_bench_write_csv(f, results, count, label, true);
+            fclose(f);
+            printf("CSV: %s\n", csv);
+        }
+    }
+    else
+    {
+        printf("bench failed: %s\n", esp_err_to_name(ret));
+    }
+
+    sd_manager_host_disk_stats_t disk;
+    sd_manager_host_get_disk_stats(&disk);
+    printf("\ndisk: %u reads / %llu sectors, %u writes / %llu sectors\n", (unsigned)disk.read_calls,
+           (unsigned long long)disk.read_sectors, (unsigned)disk.write_calls, (unsigned long long)disk.write_sectors);
+    free(results);
+    return ret == ESP_OK ? 0 : 1;
+}
+
+void app_main(void)
+{
+    const char *image = getenv("SD_IMAGE") ? getenv("SD_IMAGE") : "sd.img";
+    uint32_t image_mb = getenv("SD_IMAGE_MB") ? (uint32_t)atoi(getenv("SD_IMAGE_MB")) : 0;
+    sd_manager_host_set_image(image, image_mb);
+    check(sd_manager_init() == ESP_OK, "mount image");
+
+    if (getenv("SD_BENCH") != NULL)
+    {
+        int rc = run_bench();
+        sd_manager_deinit();
+        exit(rc);
+    }
+
+    uint8_t *src = malloc(SD_HOST_FILE_BYTES);
+    uint8_t *dst = sd_manager_alloc_io_buffer(SD_HOST_FILE_BYTES);
+    check(src != NULL && dst != NULL, "alloc buffers");
+    fill_pattern(src, SD_HOST_FILE_BYTES, 1);
+
+    check(sd_manager_create_dir(SD_HOST_DIR) == ESP_OK, "create_dir");
+    check(sd_manager_create_dir(SD_HOST_DIR) == ESP_OK, "create_dir (exists)");
+    check(sd_manager_write_file(SD_HOST_FILE, src, SD_HOST_FILE_BYTES) == ESP_OK, "write_file");
+
+    size_t size = 0;
+    check(sd_manager_get_file_size(SD_HOST_FILE, &size) == ESP_OK && size == SD_HOST_FILE_BYTES, "get_file_size");
+
+    size_t got = 0;
+    memset(dst, 0, SD_HOST_FILE_BYTES);
+    check(sd_manager_read_file(SD_HOST_FILE, dst, SD_HOST_FILE_BYTES, &got) == ESP_OK && got == SD_HOST_FILE_BYTES &&
+              memcmp(src, dst, got) == 0,
+          "read_file");
+
+    // writer: 不规则的小块和跨越多个合并缓冲的大块交替追加
+    sd_manager_writer_t *w = NULL;
+    check(sd_manager_writer_open(SD_HOST_FILE, SD_HOST_FILE_BYTES, SD_MANAGER_CLASS_BACKGROUND, &w) == ESP_OK, "writer_open");
+    size_t off = 0;
+    size_t step = 1;
+    while (off < SD_HOST_FILE_BYTES)
+    {
+        size_t n = (step % 5 == 0) ? 3 * SD_MANAGER_WRITER_BUF + step : step * 37;
+        n = (n < SD_HOST_FILE_BYTES - off) ? n : SD_HOST_FILE_BYTES - off;
+        if (sd_manager_writer_append(w, src + off, n) != ESP_OK)
+        {
+            break;
+        }
+        off += n;
+        step++;
+    }
+    check(sd_manager_writer_close(w) == ESP_OK && off == SD_HOST_FILE_BYTES, "writer_append/close");
+
+    memset(dst, 0, SD_HOST_FILE_BYTES);
+    check(sd_manager_read_file(SD_HOST_FILE, dst, SD_HOST_FILE_BYTES, &got) == ESP_OK && got == SD_HOST_FILE_BYTES &&
+              memcmp(src, dst, got) == 0,
+          "writer readback");
+
+    // 异步读: 回调完成
+    volatile size_t async_bytes = SIZE_MAX;
+    memset(dst, 0, SD_HOST_FILE_BYTES);
+    check(sd_manager_read_file_async(SD_HOST_FILE, dst, SD_HOST_FILE_BYTES, SD_MANAGER_CLASS_UI, async_done_cb, (void *)&async_bytes) == ESP_OK,
+          "read_file_async (cb) submit");
+    while (async_bytes == SIZE_MAX)
+    {
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    check(async_bytes == SD_HOST_FILE_BYTES && memcmp(src, dst, SD_HOST_FILE_BYTES) == 0, "read_file_async (cb)");
+
+    // 异步读: 任务通知完成, 只用SD_MANAGER_IO_NOTIFY_INDEX号, 0号上已有的通知保留
+    uint32_t result = ESP_FAIL;
+    memset(dst, 0, SD_HOST_FILE_BYTES);
+    xTaskNotifyGive(xTaskGetCurrentTaskHandle());
+    check(sd_manager_read_file_async(SD_HOST_FILE, dst, SD_HOST_FILE_BYTES, SD_MANAGER_CLASS_UI, NULL, NULL) == ESP_OK,
+          "read_file_async (notify) submit");
+    check(xTaskNotifyWaitIndexed(SD_MANAGER_IO_NOTIFY_INDEX, 0, UINT32_MAX, &result, pdMS_TO_TICKS(5000)) == pdTRUE &&
+              result == ESP_OK && memcmp(src, dst, SD_HOST_FILE_BYTES) == 0,
+          "read_file_async (notify)");
+    check(ulTaskNotifyTake(pdTRUE, 0) == 1, "async notify keeps index 0");
+
+    check(check_priority(src, dst), "audio before background");
+    check(check_sync_priority(src, dst), "audio before sync read_file");
+    check(check_merge(src, dst), "merged adjacent reads");
+    check(check_write_at(src, dst), "file write/sync/truncate");
+    check(check_dir_list(src), "dir list/sort/filter/cache");
+    check(check_cache(src, dst), "artifact cache/LRU/manifest");
+
+    check(sd_manager_delete_file(SD_HOST_FILE) == ESP_OK, "delete_file");
+    check(sd_manager_get_file_size(SD_HOST_FILE, &size) == ESP_ERR_NOT_FOUND, "get_file_size (deleted)");
+    check(sd_manager_read_file("/other/data.bin", dst, 16, &got) == ESP_ERR_INVALID_ARG, "path outside mount point");
+
+    print_stats();
+    free(src);
+    free(dst);
+    sd_manager_deinit();
+    exit(0);
+}
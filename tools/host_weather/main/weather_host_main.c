@@ -0,0 +1,138 @@
+/**
+ * @file weather_host_main.c
+ * @brief 主机上检查weather_client的连接保持和会话恢复
+ * @details 先运行替身服务器: python tools/weather_server.py, 然后连续请求WEATHER_COUNT次:
+ *          第1次新建连接并完整握手, 之后复用连接; 第WEATHER_CLOSE_AT次之前关闭连接, 重连时应带上保存的会话
+ *          (服务器日志显示"恢复会话")。每次请求打印是否新建连接、握手和请求耗时, 最后用最后一次响应的ETag
+ *          发一次条件请求, 应得到304 (服务器以--no-validators运行时跳过), 然后打印统计。
+ *          任一请求失败或不符合上述预期时以非0退出。
+ *
+ *          环境变量:
+ *            WEATHER_CA          服务器证书路径 (必需, weather_server.py启动时打印)
+ *            WEATHER_URL         默认 https://localhost:8443/v3/weather/now.json?location=guangzhou
+ *            WEATHER_COUNT       请求次数 (默认6)
+ *            WEATHER_CLOSE_AT    在第几次请求之前关闭连接 (默认WEATHER_COUNT / 2, 0为不关闭)
+ *            WEATHER_INTERVAL_MS 请求间隔 (默认200); 大于服务器的--idle-timeout时检查服务器关闭连接后的重连
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "weather_client.h"
+
+#define WEATHER_HOST_URL "https://localhost:8443/v3/weather/now.json?location=guangzhou"
+#define WEATHER_HOST_RESP (2048)
+
+static char *read_text(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *text = malloc(len + 1);
+    if (text != NULL && fread(text, 1, len, f) == (size_t)len)
+    {
+        text[len] = '\0';
+    }
+    else
+    {
+        free(text);
+        text = NULL;
+    }
+    fclose(f);
+    return text;
+}
+
+static int env_int(const char *name, int def)
+{
+    const char *v = getenv(name);
+    return v ? atoi(v) : def;
+}
+
+static void discard_body(const char *data, size_t len, void *arg)
+{
+}
+
+static void print_stats(void)
+{
+    weather_client_stats_t st;
+    weather_client_get_stats(&st);
+    printf("\nrequests %u, errors %u, reused %u, retries %u, idle closes %u\n", (unsigned)st.requests,
+           (unsigned)st.errors, (unsigned)st.reused, (unsigned)st.retries, (unsigned)st.idle_closes);
+    printf("full handshakes    %3u, avg %8.1f us\n", (unsigned)st.full_handshakes,
+           st.full_handshakes ? (double)st.full_handshake_us / st.full_handshakes : 0);
+    printf("resumed handshakes %3u, avg %8.1f us\n", (unsigned)st.resumed_handshakes,
+           st.resumed_handshakes ? (double)st.resumed_handshake_us / st.resumed_handshakes : 0);
+    printf("handshake max %u us, request avg %.1f us, max %u us\n", (unsigned)st.handshake_max_us,
+           st.requests ? (double)st.request_us / st.requests : 0, (unsigned)st.request_max_us);
+}
+
+void app_main(void)
+{
+    const char *ca_path = getenv("WEATHER_CA");
+    char *ca = ca_path ? read_text(ca_path) : NULL;
+    if (ca == NULL)
+    {
+        printf("WEATHER_CA 未设置或无法读取\n");
+        exit(1);
+    }
+    const char *url = getenv("WEATHER_URL") ? getenv("WEATHER_URL") : WEATHER_HOST_URL;
+    int count = env_int("WEATHER_COUNT", 6);
+    int close_at = env_int("WEATHER_CLOSE_AT", count / 2);
+    int interval_ms = env_int("WEATHER_INTERVAL_MS", 200);
+
+    weather_client_config_t cfg = {.cert_pem = ca};
+    weather_client_init(&cfg);
+
+    static char resp[WEATHER_HOST_RESP];
+    bool ok = true;
+    for (int i = 0; i < count; i++)
+    {
+        if (i > 0 && i == close_at)
+        {
+            weather_client_close();
+        }
+        weather_client_result_t res;
+        esp_err_t err = weather_client_get(url, resp, sizeof(resp), &res);
+        printf("#%d %s: HTTP %d, %u bytes, %-18s handshake %7u us, request %7u us%s\n", i, esp_err_to_name(err),
+               res.status, (unsigned)res.len,
+               res.new_connection ? (res.session_offered ? "new (with session)" : "new") : "reused",
+               (unsigned)res.handshake_us, (unsigned)res.request_us, res.retried ? ", retried" : "");
+
+        // 第1次和关闭后的第1次必须新建连接, 关闭后的重连必须带会话
+        bool expect_new = (i == 0) || (i == close_at);
+        ok = ok && err == ESP_OK && res.status == 200 && strstr(resp, "\"results\"") != NULL &&
+             (!expect_new || res.new_connection) && (i == 0 || !res.new_connection || res.session_offered);
+        vTaskDelay(pdMS_TO_TICKS(interval_ms));
+    }
+
+    // 条件请求: 数据在服务器的更新周期内不变, 带上ETag应得到304且没有响应体
+    static weather_client_result_t last;
+    weather_client_get(url, resp, sizeof(resp), &last);
+    if (last.etag[0] != '\0')
+    {
+        weather_client_validators_t v = {.if_none_match = last.etag};
+        weather_client_result_t res;
+        resp[0] = '\0';
+        esp_err_t err = weather_client_get_conditional(url, &v, discard_body, NULL, &res);
+        printf("conditional %s: HTTP %d, %u bytes (ETag %s)\n", esp_err_to_name(err), res.status, (unsigned)res.len,
+               last.etag);
+        ok = ok && err == ESP_OK && res.status == 304 && res.len == 0;
+    }
+    else
+    {
+        printf("服务器没有提供ETag, 跳过条件请求\n");
+    }
+
+    print_stats();
+    weather_client_deinit();
+    free(ca);
+    printf("%s\n", ok ? "OK" : "FAIL");
+    exit(ok ? 0 : 1);
+}
@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+"""心知天气接口的本地HTTPS替身服务器, 用于测试weather_client的连接保持和TLS会话恢复
+
+    python tools/weather_server.py --name 192.168.1.10          # 首次运行生成自签名证书 (需要openssl命令)
+    python tools/weather_server.py --idle-timeout 3              # 连接闲置3秒后服务器关闭, 客户端重连时应恢复会话
+    python tools/weather_server.py --update-interval 60          # 天气每60秒变化一次, 其间的条件请求返回304
+
+证书和私钥保存在 --cert-dir (默认 build/weather_server), 启动时打印证书路径:
+  - 目标板: 把证书内容填入 main/hptts.c 的 HPTTS_WEATHER_CERT, HPTTS_WEATHER_URL 改为本服务器地址
+  - 主机: tools/host_weather 用 WEATHER_CA 指定证书路径
+
+接口:
+  GET /v3/weather/now.json?location=xxx   与心知天气相同结构的实时天气, 每--update-interval秒变化一次;
+                                          带ETag/Last-Modified, 请求的If-None-Match/If-Modified-Since匹配时返回304
+                                          (--no-validators时不带, 与真实的心知天气接口一致)
+  GET /stats                              连接数、恢复会话的连接数、请求数、304次数 (JSON)
+每个新连接打印TLS版本、是否恢复了会话和握手耗时, 每个请求打印所在连接的序号和连接上的第几个请求。
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import ssl
+import subprocess
+import sys
+import threading
+import time
+from datetime import datetime, timedelta, timezone
+from email.utils import formatdate, parsedate_to_datetime
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, urlparse
+
+WEATHER = [("晴", "0"), ("多云", "4"), ("阴", "9"), ("小雨", "13"), ("雷阵雨", "11")]
+
+
+def ensure_cert(cert_dir, names):
+    cert = os.path.join(cert_dir, "cert.pem")
+    key = os.path.join(cert_dir, "key.pem")
+    if os.path.exists(cert) and os.path.exists(key):
+        return cert, key
+    os.makedirs(cert_dir, exist_ok=True)
+    san = ",".join(("IP:" if n.replace(".", "").isdigit() else "DNS:") + n for n in names)
+    subprocess.run(["openssl", "req", "-x509", "-newkey", "ec", "-pkeyopt", "ec_paramgen_curve:prime256v1",
+                    "-nodes", "-days", "3650", "-subj", f"/CN={names[0]}", "-addext", f"subjectAltName={san}",
+                    "-keyout", key, "-out", cert], check=True, capture_output=True)
+    print(f"已生成自签名证书: {cert} ({san})")
+    return cert, key
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.connections = 0
+        self.resumed = 0
+        self.requests = 0
+        self.not_modified = 0
+
+    def snapshot(self):
+        with self.lock:
+            return {"connections": self.connections, "resumed": self.resumed, "requests": self.requests,
+                    "not_modified": self.not_modified}
+
+
+class WeatherServer(ThreadingHTTPServer):
+    daemon_threads = True
+
+    def __init__(self, addr, ctx, args):
+        super().__init__(addr, WeatherHandler)
+        self.ctx = ctx
+        self.args = args
+        self.stats = Stats()
+
+    def finish_request(self, request, client_address):
+        # 握手放在连接自己的线程中, 慢客户端不阻塞accept
+        start = time.perf_counter()
+        try:
+            conn = self.ctx.wrap_socket(request, server_side=True)
+        except (ssl.SSLError, OSError) as e:
+            print(f"{client_address[0]}: 握手失败: {e}")
+            return
+        ms = (time.perf_counter() - start) * 1000
+        with self.stats.lock:
+            self.stats.connections += 1
+            self.stats.resumed += 1 if conn.session_reused else 0
+            conn_id = self.stats.connections
+        print(f"连接#{conn_id} {client_address[0]}: {conn.version()} {conn.cipher()[0]}, "
+              f"{'恢复会话' if conn.session_reused else '完整握手'}, 握手 {ms:.1f} ms")
+        conn.conn_id = conn_id
+        conn.served = 0
+        self.RequestHandlerClass(conn, client_address, self)
+
+
+class WeatherHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"  # 默认保持连接
+
+    def setup(self):
+        self.timeout = self.server.args.idle_timeout or None
+        super().setup()
+
+    def log_message(self, fmt, *args):
+        pass
+
+    def send_json(self, obj, validators=None):
+        body = json.dumps(obj, ensure_ascii=False).encode()
+        conn = self.connection
+        conn.served += 1
+        close = self.server.args.max_requests and conn.served >= self.server.args.max_requests
+        status = 200
+        if validators:
+            etag, modified = validators
+            if self.not_modified(etag, modified):
+                status, body = 304, b""
+                with self.server.stats.lock:
+                    self.server.stats.not_modified += 1
+        self.send_response(status)
+        if status == 200:
+            self.send_header("Content-Type", "application/json; charset=utf-8")
+        if validators:
+            self.send_header("ETag", validators[0])
+            self.send_header("Last-Modified", formatdate(validators[1], usegmt=True))
+        self.send_header("Content-Length", str(len(body)))
+        if close:
+            self.send_header("Connection", "close")
+            self.close_connection = True
+        self.end_headers()
+        self.wfile.write(body)
+        print(f"  连接#{conn.conn_id} 第{conn.served}个请求: {self.path} -> {status}"
+              f"{' (随后关闭连接)' if close else ''}")
+
+    def not_modified(self, etag, modified):
+        # If-None-Match优先 (RFC 9110 13.2.2)
+        inm = self.headers.get("If-None-Match")
+        if inm is not None:
+            return etag in [t.strip() for t in inm.split(",")] or inm.strip() == "*"
+        ims = self.headers.get("If-Modified-Since")
+        if ims is not None:
+            try:
+                return int(modified) <= parsedate_to_datetime(ims).timestamp()
+            except (TypeError, ValueError):
+                return False
+        return False
+
+    def do_GET(self):
+        if self.server.args.delay_ms:
+            time.sleep(self.server.args.delay_ms / 1000)
+        url = urlparse(self.path)
+        if url.path == "/stats":
+            self.send_json(self.server.stats.snapshot())
+            return
+        if url.path != "/v3/weather/now.json":
+            self.send_error(404)
+            return
+        with self.server.stats.lock:
+            self.server.stats.requests += 1
+        location = parse_qs(url.query).get("location", ["guangzhou"])[0]
+        # 天气在同一个更新周期内不变, 与真实接口约10分钟更新一次相同
+        interval = max(1, self.server.args.update_interval)
+        n = int(time.time() // interval)
+        updated = n * interval
+        text, code = WEATHER[n % len(WEATHER)]
+        obj = {"results": [{
+            "location": {
+                "id": "WS0E9D8WN298", "name": location, "country": "CN",
+                "path": f"{location},中国", "timezone": "Asia/Shanghai", "timezone_offset": "+08:00",
+            },
+            "now": {"text": text, "code": code, "temperature": str(20 + n % 10)},
+            "last_update": datetime.fromtimestamp(updated, timezone(timedelta(hours=8))).isoformat(),
+        }]}
+        validators = None
+        if not self.server.args.no_validators:
+            digest = hashlib.sha1(json.dumps(obj, ensure_ascii=False).encode()).hexdigest()[:16]
+            validators = (f'"{digest}"', updated)
+        self.send_json(obj, validators)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="心知天气接口的本地HTTPS替身服务器")
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=8443)
+    parser.add_argument("--name", action="append", help="证书中的主机名或IP, 可重复 (默认localhost和127.0.0.1)")
+    parser.add_argument("--cert-dir", default=os.path.join("build", "weather_server"))
+    parser.add_argument("--idle-timeout", type=float, default=0, help="连接闲置多少秒后由服务器关闭, 0为不关闭")
+    parser.add_argument("--max-requests", type=int, default=0, help="每个连接最多处理的请求数, 0为不限")
+    parser.add_argument("--delay-ms", type=int, default=0, help="每个请求的处理延迟")
+    parser.add_argument("--no-tickets", action="store_true", help="不发会话票据, 用于对比完整握手")
+    parser.add_argument("--update-interval", type=int, default=600, help="天气数据的更新周期(秒)")
+    parser.add_argument("--no-validators", action="store_true", help="不发ETag/Last-Modified, 不返回304")
+    args = parser.parse_args()
+
+    cert, key = ensure_cert(args.cert_dir, args.name or ["localhost", "127.0.0.1"])
+    ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    ctx.load_cert_chain(cert, key)
+    # 目标板的mbedTLS只启用了TLS 1.2, 这里同样限制, 测得的握手与真实服务器可比
+    ctx.maximum_version = ssl.TLSVersion.TLSv1_2
+    if args.no_tickets:
+        ctx.options |= ssl.OP_NO_TICKET
+
+    server = WeatherServer((args.host, args.port), ctx, args)
+    print(f"https://{args.host}:{args.port}/v3/weather/now.json  证书: {os.path.abspath(cert)}")
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    print(json.dumps(server.stats.snapshot()))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())